@@ -0,0 +1,381 @@
+/*
+*	Copyright (c) 2018, Ilya Kalinovskiy
+*	All rights reserved.
+*
+*	This is an implementation of the algorithm described in the following paper:
+*		I.A. Kalinovskiy, V.G. Spitsyn,
+*		Compact Convolutional Neural Network Cascade for Face Detection,
+*		http://arxiv.org/abs/1508.01292.
+*
+*	Redistribution and use of this program as source code or in binary form, with or without modifications, are permitted provided that the following conditions are met:
+*		1. Redistributions may not be sold, nor may they be used in a commercial product or activity without prior permission from the copyright holder (contact him at kua_21@mail.ru).
+*		2. Redistributions may not be used for military purposes.
+*		3. Any published work which utilizes this program shall include the reference to the paper available at http://arxiv.org/abs/1508.01292
+*		4. Redistributions must retain the above copyright notice and the reference to the algorithm on which the implementation is based on, this list of conditions and the following disclaimer.
+*
+*	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+*	IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#pragma once
+
+#include "config.h"
+#include "type.h"
+#include "image.h"
+
+#if defined(USE_FIXED_POINT) && defined(USE_AVX512)
+#	include "cnnpp_simd_avx512_v4.h"
+#endif
+
+#include <string>
+#include <vector>
+#include <sstream>
+#include <fstream>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+
+
+//================================================================================================================================================
+
+
+namespace NeuralNetworksLib
+{
+	namespace Benchmark
+	{
+		//flat json object, one per line in result files
+		class Record
+		{
+		private:
+			std::vector<std::pair<std::string, std::string>> fields;
+
+			static std::string quote(const std::string& str)
+			{
+				std::string res = "\"";
+				for (size_t i = 0; i < str.size(); ++i)
+				{
+					if (str[i] == '"' || str[i] == '\\') res += '\\';
+					res += str[i];
+				}
+				return res + "\"";
+			}
+
+		public:
+			Record& set(const std::string& name, const std::string& value)
+			{
+				return setRaw(name, quote(value));
+			}
+			Record& set(const std::string& name, const char* value)
+			{
+				return setRaw(name, quote(value));
+			}
+			Record& set(const std::string& name, double value)
+			{
+				std::stringstream str;
+				str.precision(6);
+				str << value;
+				return setRaw(name, str.str());
+			}
+			Record& set(const std::string& name, int value)
+			{
+				return setRaw(name, std::to_string(value));
+			}
+			Record& set(const std::string& name, bool value)
+			{
+				return setRaw(name, value ? "true" : "false");
+			}
+			Record& setNull(const std::string& name)
+			{
+				return setRaw(name, "null");
+			}
+			Record& setRaw(const std::string& name, const std::string& json_value)
+			{
+				for (auto it = fields.begin(); it != fields.end(); ++it)
+				{
+					if (it->first == name)
+					{
+						it->second = json_value;
+						return *this;
+					}
+				}
+				fields.push_back(std::make_pair(name, json_value));
+				return *this;
+			}
+
+			std::string getString(const std::string& name) const
+			{
+				for (auto it = fields.begin(); it != fields.end(); ++it)
+				{
+					if (it->first != name) continue;
+					if (it->second.size() >= 2 && it->second[0] == '"')
+					{
+						return it->second.substr(1, it->second.size() - 2);
+					}
+					return it->second;
+				}
+				return "";
+			}
+			//-1 for missing or null fields
+			double getValue(const std::string& name) const
+			{
+				const std::string value = getString(name);
+				if (value.empty() || value == "null") return -1.;
+				return atof(value.c_str());
+			}
+			std::string getKey(const std::vector<std::string>& key_fields) const
+			{
+				std::string key;
+				for (size_t i = 0; i < key_fields.size(); ++i)
+				{
+					key += (i > 0 ? "/" : "") + getString(key_fields[i]);
+				}
+				return key;
+			}
+
+			std::string toJSON() const
+			{
+				std::string json = "{ ";
+				for (size_t i = 0; i < fields.size(); ++i)
+				{
+					json += (i > 0 ? ", " : "") + quote(fields[i].first) + ": " + fields[i].second;
+				}
+				return json + " }";
+			}
+
+			//parse flat object written by toJSON
+			static bool parse(const std::string& line, Record& record)
+			{
+				size_t pos = line.find('{');
+				if (pos == std::string::npos) return false;
+
+				record.fields.clear();
+				while (true)
+				{
+					size_t key_begin = line.find('"', pos);
+					if (key_begin == std::string::npos) break;
+					size_t key_end = line.find('"', key_begin + 1);
+					size_t colon = line.find(':', key_end);
+					if (key_end == std::string::npos || colon == std::string::npos) return false;
+
+					size_t value_begin = line.find_first_not_of(" \t", colon + 1);
+					if (value_begin == std::string::npos) return false;
+
+					size_t value_end = value_begin;
+					if (line[value_begin] == '"')
+					{
+						value_end = value_begin + 1;
+						while (value_end < line.size() && line[value_end] != '"')
+						{
+							if (line[value_end] == '\\') value_end++;
+							value_end++;
+						}
+						value_end++;
+					}
+					else
+					{
+						value_end = line.find_first_of(",}", value_begin);
+						if (value_end == std::string::npos) return false;
+					}
+
+					std::string value = line.substr(value_begin, value_end - value_begin);
+					value.erase(value.find_last_not_of(" \t") + 1);
+					record.fields.push_back(std::make_pair(line.substr(key_begin + 1, key_end - key_begin - 1), value));
+
+					pos = value_end;
+				}
+
+				return record.fields.size() > 0;
+			}
+		};
+
+		inline int saveRecords(const std::string& file_name, const std::string& benchmark, const Record& config, const std::vector<Record>& records)
+		{
+			std::ofstream file(file_name.c_str());
+			if (!file.is_open())
+			{
+				printf("[Benchmark] Could not open file %s!\n", file_name.c_str());
+				return -1;
+			}
+
+			file << "{\n\t\"benchmark\": \"" << benchmark << "\",\n\t\"config\": " << config.toJSON() << ",\n\t\"results\": [\n";
+			for (size_t i = 0; i < records.size(); ++i)
+			{
+				file << "\t\t" << records[i].toJSON() << (i + 1 < records.size() ? ",\n" : "\n");
+			}
+			file << "\t]\n}\n";
+			file.close();
+
+			return 0;
+		}
+		inline int loadRecords(const std::string& file_name, std::vector<Record>& records)
+		{
+			std::ifstream file(file_name.c_str());
+			if (!file.is_open())
+			{
+				printf("[Benchmark] Could not open file %s!\n", file_name.c_str());
+				return -1;
+			}
+
+			records.clear();
+			std::string line;
+			while (std::getline(file, line))
+			{
+				if (line.find("\"config\"") != std::string::npos) continue;
+
+				Record record;
+				if (Record::parse(line, record))
+				{
+					records.push_back(record);
+				}
+			}
+
+			return 0;
+		}
+
+		//prints metric of matching records side by side, returns number of regressions beyond tolerance
+		inline int compareBaseline(const std::vector<Record>& records, const std::vector<Record>& baseline, const std::vector<std::string>& key_fields,
+			const std::string& metric, bool lower_is_better, double tolerance)
+		{
+			printf("\n%-56s %18s %18s %8s\n", "baseline comparison", ("base " + metric).c_str(), metric.c_str(), "speedup");
+
+			int regressions = 0;
+			for (auto it = records.begin(); it != records.end(); ++it)
+			{
+				const std::string key = it->getKey(key_fields);
+				auto base = std::find_if(baseline.begin(), baseline.end(), [&](const Record& rec) { return rec.getKey(key_fields) == key; });
+				if (base == baseline.end()) continue;
+
+				const double value = it->getValue(metric);
+				const double base_value = base->getValue(metric);
+				if (value <= 0. || base_value <= 0.) continue;
+
+				const double speedup = lower_is_better ? base_value / value : value / base_value;
+				const bool regression = speedup < 1. / (1. + tolerance);
+				if (regression) regressions++;
+
+				printf("%-56s %18.4g %18.4g %7.2fx%s\n", key.c_str(), base_value, value, speedup, regression ? "  REGRESSION" : "");
+			}
+
+			return regressions;
+		}
+
+		inline double percentile(std::vector<double> values, double p)
+		{
+			if (values.empty()) return 0.;
+
+			std::sort(values.begin(), values.end());
+			const double pos = MIN(MAX(p, 0.), 1.) * double(values.size() - 1);
+			const size_t idx = (size_t)pos;
+			if (idx + 1 >= values.size()) return values.back();
+			return values[idx] + (pos - double(idx)) * (values[idx + 1] - values[idx]);
+		}
+
+		//"640x480,1280x720"
+		inline std::vector<Size> parseSizes(const std::string& str)
+		{
+			std::vector<Size> sizes;
+			std::stringstream stream(str);
+			std::string item;
+			while (std::getline(stream, item, ','))
+			{
+				int width = 0, height = 0;
+				if (sscanf(item.c_str(), "%dx%d", &width, &height) == 2 && width > 0 && height > 0)
+				{
+					sizes.push_back(Size(width, height));
+				}
+			}
+			return sizes;
+		}
+		inline std::vector<int> parseList(const std::string& str)
+		{
+			std::vector<int> list;
+			std::stringstream stream(str);
+			std::string item;
+			while (std::getline(stream, item, ','))
+			{
+				if (!item.empty()) list.push_back(atoi(item.c_str()));
+			}
+			return list;
+		}
+		inline std::string sizeToString(const Size& size)
+		{
+			return std::to_string(size.width) + "x" + std::to_string(size.height);
+		}
+
+		//binary ppm (P6) or pgm (P5) as 3 channel BGR image, repo has no jpeg/png decoder
+		inline int loadPNM(const std::string& file_name, SIMD::Image_8u& image)
+		{
+			FILE* file = fopen(file_name.c_str(), "rb");
+			if (file == NULL)
+			{
+				printf("[Benchmark] Could not open file %s!\n", file_name.c_str());
+				return -1;
+			}
+
+			char magic[3] = { 0 };
+			int width = 0, height = 0, max_value = 0;
+			if (fscanf(file, "%2s %d %d %d", magic, &width, &height, &max_value) != 4 || (std::string(magic) != "P6" && std::string(magic) != "P5")
+				|| width <= 0 || height <= 0 || max_value <= 0 || max_value > 255)
+			{
+				printf("[Benchmark] Unsupported image format %s!\n", file_name.c_str());
+				fclose(file);
+				return -1;
+			}
+			fgetc(file);
+
+			const int channels = magic[1] == '6' ? 3 : 1;
+			std::vector<uchar_> row(width * channels);
+
+			image.clear();
+			image = SIMD::Image_8u(width, height, 3, ALIGN_DEF, false);
+			for (int y = 0; y < height; ++y)
+			{
+				if (fread(row.data(), 1, row.size(), file) != row.size())
+				{
+					printf("[Benchmark] Unexpected end of file %s!\n", file_name.c_str());
+					fclose(file);
+					image.clear();
+					return -1;
+				}
+
+				uchar_* dst = image.data + y * image.widthStep;
+				for (int x = 0; x < width; ++x)
+				{
+					if (channels == 3)
+					{
+						dst[3 * x + 0] = row[3 * x + 2];
+						dst[3 * x + 1] = row[3 * x + 1];
+						dst[3 * x + 2] = row[3 * x + 0];
+					}
+					else
+					{
+						dst[3 * x + 0] = dst[3 * x + 1] = dst[3 * x + 2] = row[x];
+					}
+				}
+			}
+
+			fclose(file);
+			return 0;
+		}
+
+		inline std::string getSIMDName()
+		{
+#if defined(USE_FIXED_POINT) && defined(USE_AVX512)
+			return SIMD::CNNPP_v4::isEnabled() ? "AVX-512 fixed point" : "AVX2 fixed point";
+#elif defined(USE_FIXED_POINT)
+			return "AVX2 fixed point";
+#elif defined(USE_AVX2)
+			return "AVX2";
+#elif defined(USE_AVX) && defined(USE_HF)
+			return "AVX fp16";
+#elif defined(USE_AVX)
+			return "AVX";
+#elif defined(USE_SSE)
+			return "SSE";
+#else
+			return "C++";
+#endif
+		}
+	}
+}
@@ -0,0 +1,90 @@
+#!/bin/sh
+#	builds every simd backend available on this machine, dumps the conformance workload and
+#	compares each dump against the plain C++ build with the same models (SSE builds use *_new.bin models),
+#	the AVX fp16 build (-DWITH_F16C=ON) is compared against the fp32 AVX build with tighter limits
+#
+#	usage: src/Benchmark/conformance.sh [ppm/pgm images...], without images test_images/*.jpg are converted by convert_images.sh
+#	env:   BUILD_DIR (default _conformance), OPENCL=1 adds OpenCL pipeline build, CMAKE_ARGS, CONFORMANCE_ARGS
+
+set -e
+
+ROOT=$(cd "$(dirname "$0")/../.." && pwd)
+BUILD_DIR=${BUILD_DIR:-$ROOT/_conformance}
+JOBS=$(nproc 2>/dev/null || echo 4)
+
+IMAGES=""
+for img in "$@"; do
+	IMAGES="${IMAGES:+$IMAGES,}$(cd "$(dirname "$img")" && pwd)/$(basename "$img")"
+done
+if [ -z "$IMAGES" ]; then
+	IMAGES=$("$ROOT/src/Benchmark/convert_images.sh" "$BUILD_DIR/images") || echo "[conformance] test_images are not converted, synthetic frames only"
+fi
+
+has_cpu_flag() {
+	grep -qw "$1" /proc/cpuinfo 2>/dev/null
+}
+
+#name:cmake options:dump options
+run_backend() {
+	name=$1; options=$2; args=$3
+	echo "== $name"
+	cmake -S "$ROOT" -B "$BUILD_DIR/$name" -DCMAKE_BUILD_TYPE=Release -DBUILD_Benchmark=ON $options $CMAKE_ARGS > "$BUILD_DIR/$name.log"
+	cmake --build "$BUILD_DIR/$name" --target ConformanceTest -j"$JOBS" >> "$BUILD_DIR/$name.log"
+	"$BUILD_DIR/$name/bin/ConformanceTest" --dump "$BUILD_DIR/$name.bin" --models "$ROOT/models" \
+		${IMAGES:+--images "$IMAGES"} $args $CONFORMANCE_ARGS
+}
+
+mkdir -p "$BUILD_DIR"
+
+cntk="$BUILD_DIR/cplusplus.bin"
+run_backend cplusplus ""
+if has_cpu_flag avx; then
+	run_backend avx "-DWITH_AVX=ON"
+	cntk="$cntk,$BUILD_DIR/avx.bin"
+	if has_cpu_flag f16c; then
+		#fp16 layer buffers of stage 1, gated against the fp32 AVX build below
+		run_backend avx_fp16 "-DWITH_AVX=ON -DWITH_F16C=ON"
+		cntk="$cntk,$BUILD_DIR/avx_fp16.bin"
+		fp16="$BUILD_DIR/avx.bin,$BUILD_DIR/avx_fp16.bin"
+	fi
+fi
+if has_cpu_flag avx2 && has_cpu_flag fma && has_cpu_flag f16c; then
+	if has_cpu_flag avx512bw; then
+		run_backend avx2 "-DWITH_AVX2=ON" "--avx512 0"
+		#AVX-512 kernels of the same build, must be bit-exact with AVX2 kernels
+		"$BUILD_DIR/avx2/bin/ConformanceTest" --dump "$BUILD_DIR/avx512.bin" --models "$ROOT/models" \
+			${IMAGES:+--images "$IMAGES"} --avx512 1 $CONFORMANCE_ARGS
+		cntk="$cntk,$BUILD_DIR/avx2.bin,$BUILD_DIR/avx512.bin"
+		avx512="$BUILD_DIR/avx2.bin,$BUILD_DIR/avx512.bin"
+	else
+		run_backend avx2 "-DWITH_AVX2=ON"
+		cntk="$cntk,$BUILD_DIR/avx2.bin"
+	fi
+fi
+if [ "$OPENCL" = "1" ]; then
+	run_backend opencl "-DWITH_OpenCL=ON" "--gpu 1"
+	cntk="$cntk,$BUILD_DIR/opencl.bin"
+fi
+
+new="$BUILD_DIR/cplusplus_new.bin"
+run_backend cplusplus_new "-DWITH_CNTK_MODELS=OFF"
+if has_cpu_flag sse4_1; then
+	run_backend sse "-DWITH_SSE=ON"
+	new="$new,$BUILD_DIR/sse.bin"
+fi
+
+status=0
+echo
+"$BUILD_DIR/cplusplus/bin/ConformanceTest" --compare "$cntk" --json "$BUILD_DIR/conformance_cntk.json" || status=1
+echo
+"$BUILD_DIR/cplusplus/bin/ConformanceTest" --compare "$new" --json "$BUILD_DIR/conformance_new.json" || status=1
+if [ -n "$fp16" ]; then
+	echo
+	"$BUILD_DIR/cplusplus/bin/ConformanceTest" --compare "$fp16" --max-mean-error 0.0001 --max-error 0.05 --min-agreement 0.98 || status=1
+fi
+if [ -n "$avx512" ]; then
+	echo
+	"$BUILD_DIR/cplusplus/bin/ConformanceTest" --compare "$avx512" --max-mean-error 0 --min-agreement 1 || status=1
+fi
+
+exit $status
@@ -0,0 +1,818 @@
+/*
+*	Copyright (c) 2018, Ilya Kalinovskiy
+*	All rights reserved.
+*
+*	This is an implementation of the algorithm described in the following paper:
+*		I.A. Kalinovskiy, V.G. Spitsyn,
+*		Compact Convolutional Neural Network Cascade for Face Detection,
+*		http://arxiv.org/abs/1508.01292.
+*
+*	Redistribution and use of this program as source code or in binary form, with or without modifications, are permitted provided that the following conditions are met:
+*		1. Redistributions may not be sold, nor may they be used in a commercial product or activity without prior permission from the copyright holder (contact him at kua_21@mail.ru).
+*		2. Redistributions may not be used for military purposes.
+*		3. Any published work which utilizes this program shall include the reference to the paper available at http://arxiv.org/abs/1508.01292
+*		4. Redistributions must retain the above copyright notice and the reference to the algorithm on which the implementation is based on, this list of conditions and the following disclaimer.
+*
+*	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+*	IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#include "cnn_detector_v3.h"
+#include "timer.h"
+
+#include "benchmark_utils.h"
+
+#include <map>
+#include <memory>
+#include <random>
+#include <cmath>
+
+
+//================================================================================================================================================
+
+
+using namespace NeuralNetworksLib;
+using namespace NeuralNetworksLib::Benchmark;
+
+namespace
+{
+	//simd backend is fixed at compile time, every build dumps the same workload and dumps are compared offline
+	const char dump_magic[] = "CNNCONF1";
+
+#ifdef USE_AVX
+	typedef SIMD::ConvNeuralNetwork_v2 Stage1Network;
+#else
+	typedef SIMD::ConvNeuralNetwork Stage1Network;
+#endif
+
+#ifdef USE_CNTK_MODELS
+	const std::string model_family = "cntk";
+#else
+	const std::string model_family = "new";
+#endif
+
+	//named float arrays, the prefix defines how items are compared:
+	//stage1/, stage2/, stage3/ - network outputs, detect/ - x, y, width, height, score per detection, time/ - ms
+	struct Dump
+	{
+		std::string backend;
+		std::string models;
+		std::vector<std::pair<std::string, std::vector<float>>> items;
+
+		const std::vector<float>* find(const std::string& name) const
+		{
+			for (auto it = items.begin(); it != items.end(); ++it)
+			{
+				if (it->first == name) return &it->second;
+			}
+			return NULL;
+		}
+	};
+
+	void writeString(FILE* file, const std::string& str)
+	{
+		const int len = (int)str.size();
+		fwrite(&len, sizeof(len), 1, file);
+		fwrite(str.data(), 1, len, file);
+	}
+	bool readString(FILE* file, std::string& str)
+	{
+		int len = 0;
+		if (fread(&len, sizeof(len), 1, file) != 1 || len < 0 || len > (1 << 20)) return false;
+		str.resize(len);
+		return len == 0 || fread(&str[0], 1, len, file) == (size_t)len;
+	}
+
+	int saveDump(const std::string& file_name, const Dump& dump)
+	{
+		FILE* file = fopen(file_name.c_str(), "wb");
+		if (file == NULL)
+		{
+			printf("[ConformanceTest] Could not open file %s!\n", file_name.c_str());
+			return -1;
+		}
+
+		fwrite(dump_magic, 1, sizeof(dump_magic), file);
+		writeString(file, dump.backend);
+		writeString(file, dump.models);
+
+		const int num_items = (int)dump.items.size();
+		fwrite(&num_items, sizeof(num_items), 1, file);
+		for (auto it = dump.items.begin(); it != dump.items.end(); ++it)
+		{
+			writeString(file, it->first);
+			const int count = (int)it->second.size();
+			fwrite(&count, sizeof(count), 1, file);
+			fwrite(it->second.data(), sizeof(float), count, file);
+		}
+
+		fclose(file);
+		return 0;
+	}
+	int loadDump(const std::string& file_name, Dump& dump)
+	{
+		FILE* file = fopen(file_name.c_str(), "rb");
+		if (file == NULL)
+		{
+			printf("[ConformanceTest] Could not open file %s!\n", file_name.c_str());
+			return -1;
+		}
+
+		char magic[sizeof(dump_magic)] = { 0 };
+		int num_items = 0;
+		bool ok = fread(magic, 1, sizeof(magic), file) == sizeof(magic) && std::string(magic) == dump_magic
+			&& readString(file, dump.backend) && readString(file, dump.models)
+			&& fread(&num_items, sizeof(num_items), 1, file) == 1;
+
+		dump.items.clear();
+		for (int i = 0; ok && i < num_items; ++i)
+		{
+			std::string name;
+			int count = 0;
+			ok = readString(file, name) && fread(&count, sizeof(count), 1, file) == 1 && count >= 0;
+			if (!ok) break;
+
+			std::vector<float> values(count);
+			ok = count == 0 || fread(values.data(), sizeof(float), count, file) == (size_t)count;
+			dump.items.push_back(std::make_pair(name, values));
+		}
+
+		fclose(file);
+		if (!ok)
+		{
+			printf("[ConformanceTest] Corrupted dump %s!\n", file_name.c_str());
+			return -1;
+		}
+
+		return 0;
+	}
+
+	std::string getBackendName(bool gpu, const int* winograd_layers, const int* template_layers, bool heads, bool int8)
+	{
+		std::string name = getSIMDName();
+		if (int8) name += " + int8";
+		if (winograd_layers[0] | winograd_layers[1] | winograd_layers[2]) name += " + winograd";
+		if (template_layers[0] | template_layers[1] | template_layers[2]) name += " + template";
+		if (heads) name += " + heads";
+		if (gpu)
+		{
+#if defined(USE_CL)
+			name += " + OpenCL";
+#elif defined(USE_CUDA)
+			name += " + CUDA";
+#endif
+		}
+		return name;
+	}
+
+	struct Input
+	{
+		std::string name;
+		std::unique_ptr<SIMD::Image_8u> image;
+	};
+
+	struct Options
+	{
+		std::string dump_file;
+		std::vector<std::string> compare_files;
+		std::vector<std::string> images;
+		std::vector<Size> sizes = { Size(160, 120), Size(333, 250) };
+		std::string models = "models/";
+		bool gpu = false;
+		int avx512 = -1;				//-1 - runtime dispatch, 0/1 - AVX-512 stage 1 kernels off/on
+		int vnni = -1;					//-1 - runtime dispatch, 0/1 - vpdpbusd int8 kernels off/on
+		int winograd_layers[3] = { 0, 0, 0 };	//stage 1-3 masks of 3x3 conv layers run as Winograd F(2x2,3x3)
+		int template_layers[3] = { 0, 0, 0 };	//stage 1-3 masks of conv layers run by generated kernels
+		int patches = 256;
+		bool heads = false;				//all output neurons by ForwardOutputs, output of index_output is dumped
+		bool int8 = false;				//int8 conv layers of format 1.2 models, else their float weights
+		int repeat = 5;
+		float max_mean_error = 2.e-3f;
+		float max_error = 0.f;			//0 - reported only, fixed point stage 1 has large local errors by design
+		float min_agreement = 0.9f;
+		std::string json_file;
+	};
+
+	//scalar conversion keeps network inputs bitwise identical across backends
+	void toGray(const SIMD::Image_8u& image, SIMD::Image_32f& gray_32f, SIMD::Image_8u& gray_8u)
+	{
+		gray_32f = SIMD::Image_32f(image.width, image.height, ALIGN_DEF, true);
+		gray_8u = SIMD::Image_8u(image.width, image.height, ALIGN_DEF, true);
+		for (int y = 0; y < image.height; ++y)
+		{
+			const uchar_* src = image.data + y * image.widthStep;
+			float* dst_32f = gray_32f.data + y * gray_32f.widthStep;
+			uchar_* dst_8u = gray_8u.data + y * gray_8u.widthStep;
+			for (int x = 0; x < image.width; ++x)
+			{
+				const float value = 0.114f * src[3 * x + 0] + 0.587f * src[3 * x + 1] + 0.299f * src[3 * x + 2];
+				dst_32f[x] = value;
+				dst_8u[x] = (uchar_)MIN(value + 0.5f, 255.f);
+			}
+		}
+	}
+
+	std::unique_ptr<SIMD::Image_8u> makeSyntheticImage(Size size, unsigned int seed)
+	{
+		std::unique_ptr<SIMD::Image_8u> image(new SIMD::Image_8u(size.width, size.height, 3, ALIGN_DEF, false));
+
+		std::mt19937 rng(seed);
+		std::uniform_int_distribution<int> rnd(0, 255);
+		for (int y = 0; y < size.height; ++y)
+		{
+			uchar_* dst = image->data + y * image->widthStep;
+			for (int x = 0; x < 3 * size.width; ++x)
+			{
+				//textured with some smooth regions to exercise the whole activation range
+				const int smooth = (x / 3 + y) % 64 < 32 ? 128 : 0;
+				dst[x] = (uchar_)(smooth ? (smooth + (rnd(rng) >> 3)) : rnd(rng));
+			}
+		}
+		return image;
+	}
+
+	std::vector<float> copyMap(const SIMD::Image_32f& map)
+	{
+		std::vector<float> values;
+		values.reserve(map.width * map.height);
+		for (int y = 0; y < map.height; ++y)
+		{
+			values.insert(values.end(), map.data + y * map.widthStep, map.data + y * map.widthStep + map.width);
+		}
+		return values;
+	}
+
+	std::string modelPath(const Options& opt, int stage)
+	{
+		return opt.models + "cnn4face" + std::to_string(stage) + (model_family == "cntk" ? "_cntk.bin" : "_new.bin");
+	}
+	int indexOutput(int stage)
+	{
+		CNNDetector::AdvancedParam advanced_param;
+		return advanced_param.index_output[stage - 1];
+	}
+
+	//output neurons of ForwardOutputs (--heads 1) and position of index_output among them, empty - Forward
+	template <typename Network>
+	std::vector<int> outputHeads(const Network& cnn, const Options& opt, int stage, int& head)
+	{
+		std::vector<int> heads;
+		head = 0;
+#ifdef USE_CNTK_MODELS
+		for (int k = 0; opt.heads && k < cnn.getOutputCount(); ++k) heads.push_back(k);
+		if (!heads.empty()) head = MIN(MAX(0, indexOutput(stage)), (int)heads.size() - 1);
+#endif
+		return heads;
+	}
+
+	template <typename Func>
+	float medianTime(int repeat, Func func)
+	{
+		std::vector<double> samples;
+		for (int i = 0; i < repeat; ++i)
+		{
+			Timer timer(1, true);
+			func();
+			samples.push_back(timer.get(1000.));
+		}
+		return (float)percentile(samples, 0.5);
+	}
+
+	int runStage1(const std::vector<Input>& inputs, const Options& opt, Dump& dump)
+	{
+		Stage1Network cnn;
+#ifdef USE_CNTK_MODELS
+		cnn.setInt8(opt.int8);
+#endif
+		cnn.Init(modelPath(opt, 1), indexOutput(1));
+		if (cnn.isEmpty())
+		{
+			printf("[ConformanceTest] Could not load %s!\n", modelPath(opt, 1).c_str());
+			return -1;
+		}
+		cnn.setNumThreads(1);
+#ifdef USE_CNTK_MODELS
+		cnn.setWinogradLayers(opt.winograd_layers[0]);
+		cnn.setTemplateLayers(opt.template_layers[0]);
+#endif
+		int head = 0;
+		const std::vector<int> heads = outputHeads(cnn, opt, 1, head);
+
+		for (auto input = inputs.begin(); input != inputs.end(); ++input)
+		{
+			SIMD::Image_32f gray_32f;
+			SIMD::Image_8u gray_8u;
+			toGray(*input->image, gray_32f, gray_8u);
+
+			//empty response map shares the output buffer of the network
+			cnn.AllocateMemory(gray_32f.getSize());
+			SIMD::Image_32f response_map;
+			std::vector<SIMD::Image_32f> response_maps;
+
+			auto forward = [&]() -> SIMD::Image_32f&
+			{
+#ifdef USE_CNTK_MODELS
+				if (!heads.empty())
+				{
+					cnn.ForwardOutputs(response_maps, gray_32f, heads);
+					return response_maps[head];
+				}
+#endif
+				cnn.Forward(response_map, gray_32f);
+				return response_map;
+			};
+
+			dump.items.push_back(std::make_pair("stage1/" + input->name, copyMap(forward())));
+
+			const float time = medianTime(opt.repeat, [&] { forward(); });
+			dump.items.push_back(std::make_pair("time/stage1/" + input->name, std::vector<float>(1, time)));
+		}
+
+		return 0;
+	}
+
+	int runCheckStage(int stage, const std::vector<Input>& inputs, const Options& opt, Dump& dump)
+	{
+		SIMD::ConvNeuralNetwork cnn;
+#ifdef USE_CNTK_MODELS
+		cnn.setInt8(opt.int8);
+#endif
+		cnn.Init(modelPath(opt, stage), indexOutput(stage));
+		if (cnn.isEmpty())
+		{
+			printf("[ConformanceTest] Could not load %s!\n", modelPath(opt, stage).c_str());
+			return -1;
+		}
+		cnn.setNumThreads(1);
+#ifdef USE_CNTK_MODELS
+		cnn.setWinogradLayers(opt.winograd_layers[stage - 1]);
+		cnn.setTemplateLayers(opt.template_layers[stage - 1]);
+#endif
+		int head = 0;
+		const std::vector<int> heads = outputHeads(cnn, opt, stage, head);
+
+		const Size pattern_size = cnn.getMinInputImgSize();
+		cnn.AllocateMemory(pattern_size);
+		SIMD::Image_32f patch(pattern_size.width, pattern_size.height, ALIGN_DEF, true);
+
+		for (auto input = inputs.begin(); input != inputs.end(); ++input)
+		{
+			SIMD::Image_32f gray_32f;
+			SIMD::Image_8u gray_8u;
+			toGray(*input->image, gray_32f, gray_8u);
+			if (gray_8u.width < pattern_size.width || gray_8u.height < pattern_size.height) continue;
+
+			//patches on a regular grid, same positions in every build
+			const int grid = MAX(1, (int)std::sqrt((double)opt.patches));
+			std::vector<Point> positions;
+			for (int j = 0; j < grid; ++j)
+			{
+				for (int i = 0; i < grid; ++i)
+				{
+					positions.push_back(Point(i * (gray_8u.width - pattern_size.width) / MAX(1, grid - 1),
+											  j * (gray_8u.height - pattern_size.height) / MAX(1, grid - 1)));
+				}
+			}
+
+			std::vector<float> outputs;
+			auto copyPatch = [&](SIMD::Image_32f& dst_patch, const Point& pos)
+			{
+				for (int y = 0; y < pattern_size.height; ++y)
+				{
+					const uchar_* src = gray_8u.data + (pos.y + y) * gray_8u.widthStep + pos.x;
+					float* dst = dst_patch.data + y * dst_patch.widthStep;
+					for (int x = 0; x < pattern_size.width; ++x) dst[x] = (float)src[x];
+				}
+			};
+			auto forward = [&](bool save)
+			{
+				for (auto pos = positions.begin(); pos != positions.end(); ++pos)
+				{
+					copyPatch(patch, *pos);
+
+					SIMD::Image_32f response_map;
+					std::vector<SIMD::Image_32f> response_maps;
+#ifdef USE_CNTK_MODELS
+					if (!heads.empty())
+						cnn.ForwardOutputs(response_maps, patch, heads);
+					else
+#endif
+					cnn.Forward(response_map, patch);
+					if (save)
+					{
+						const std::vector<float> values = copyMap(heads.empty() ? response_map : response_maps[head]);
+						outputs.insert(outputs.end(), values.begin(), values.end());
+					}
+				}
+			};
+
+			forward(true);
+			const std::string name = "stage" + std::to_string(stage) + "/" + input->name;
+			dump.items.push_back(std::make_pair(name, outputs));
+
+			const float time = medianTime(opt.repeat, [&] { forward(false); });
+			dump.items.push_back(std::make_pair("time/" + name, std::vector<float>(1, time)));
+		}
+
+		return 0;
+	}
+
+	int runDetector(const std::vector<Input>& inputs, const Options& opt, Dump& dump)
+	{
+		for (auto input = inputs.begin(); input != inputs.end(); ++input)
+		{
+			CNNDetector::Param param;
+			param.max_image_size = input->image->getSize();
+			param.min_obj_size = Size(40, 40);
+			param.num_threads = 1;
+			if (opt.gpu) param.pipeline = CNNDetector::Pipeline::GPU;
+
+			CNNDetector::AdvancedParam advanced_param;
+			for (int i = 0; i < 3; ++i)
+			{
+				advanced_param.path_model[i] = modelPath(opt, i + 1);
+				advanced_param.winograd_layers[i] = opt.winograd_layers[i];
+				advanced_param.template_layers[i] = opt.template_layers[i];
+				advanced_param.int8_models[i] = opt.int8;
+			}
+
+			CNNDetector detector(&param, &advanced_param);
+			if (detector.isEmpty())
+			{
+				printf("[ConformanceTest] Could not create detector!\n");
+				return -1;
+			}
+
+			std::vector<CNNDetector::Detection> detections;
+			detector.Detect(detections, *input->image);
+
+			std::vector<float> values;
+			for (auto it = detections.begin(); it != detections.end(); ++it)
+			{
+				const float det[5] = { (float)it->rect.x, (float)it->rect.y, (float)it->rect.width, (float)it->rect.height, it->score };
+				values.insert(values.end(), det, det + 5);
+			}
+			dump.items.push_back(std::make_pair("detect/" + input->name, values));
+
+			const float time = medianTime(opt.repeat, [&] { detector.Detect(detections, *input->image); });
+			dump.items.push_back(std::make_pair("time/detect/" + input->name, std::vector<float>(1, time)));
+		}
+
+		return 0;
+	}
+
+	//fraction of detections matched one to one with IoU >= 0.5
+	float detectionAgreement(const std::vector<float>& ref, const std::vector<float>& det)
+	{
+		const int num_ref = (int)ref.size() / 5;
+		const int num_det = (int)det.size() / 5;
+		if (num_ref == 0 && num_det == 0) return 1.f;
+
+		std::vector<bool> used(num_det, false);
+		int matched = 0;
+		for (int i = 0; i < num_ref; ++i)
+		{
+			const Rect a((int)ref[5 * i], (int)ref[5 * i + 1], (int)ref[5 * i + 2], (int)ref[5 * i + 3]);
+			for (int j = 0; j < num_det; ++j)
+			{
+				if (used[j]) continue;
+
+				const Rect b((int)det[5 * j], (int)det[5 * j + 1], (int)det[5 * j + 2], (int)det[5 * j + 3]);
+				const int w = MIN(a.x + a.width, b.x + b.width) - MAX(a.x, b.x);
+				const int h = MIN(a.y + a.height, b.y + b.height) - MAX(a.y, b.y);
+				if (w <= 0 || h <= 0) continue;
+
+				const float inter = float(w * h);
+				if (inter / (float(a.width * a.height + b.width * b.height) - inter) >= 0.5f)
+				{
+					used[j] = true;
+					matched++;
+					break;
+				}
+			}
+		}
+
+		return float(matched) / float(MAX(num_ref, num_det));
+	}
+
+	int compareDumps(const Options& opt)
+	{
+		std::vector<Dump> dumps(opt.compare_files.size());
+		for (size_t i = 0; i < opt.compare_files.size(); ++i)
+		{
+			if (loadDump(opt.compare_files[i], dumps[i]) < 0) return -1;
+			if (dumps[i].models != dumps[0].models)
+			{
+				printf("[ConformanceTest] %s uses %s models, reference uses %s models!\n", opt.compare_files[i].c_str(), dumps[i].models.c_str(), dumps[0].models.c_str());
+				return -1;
+			}
+		}
+
+		const Dump& ref = dumps[0];
+		printf("conformance: reference %s (%s models)\n\n", ref.backend.c_str(), ref.models.c_str());
+		printf("%-36s", "item");
+		for (size_t i = 1; i < dumps.size(); ++i) printf(" %24s", dumps[i].backend.c_str());
+		printf("\n");
+
+		int failures = 0;
+		std::vector<Record> records;
+		//accuracy first, timings after
+		std::vector<const std::pair<std::string, std::vector<float>>*> order;
+		for (int pass = 0; pass < 2; ++pass)
+		{
+			for (auto it = ref.items.begin(); it != ref.items.end(); ++it)
+			{
+				if ((it->first.compare(0, 5, "time/") == 0) == (pass == 1)) order.push_back(&*it);
+			}
+		}
+
+		for (auto it = order.begin(); it != order.end(); ++it)
+		{
+			const auto item = *it;
+			const bool is_time = item->first.compare(0, 5, "time/") == 0;
+			const bool is_detect = item->first.compare(0, 7, "detect/") == 0;
+
+			printf("%-36s", item->first.c_str());
+			for (size_t i = 1; i < dumps.size(); ++i)
+			{
+				Record record;
+				record.set("backend", dumps[i].backend).set("item", item->first);
+
+				char cell[64] = "missing";
+				bool fail = false;
+				const std::vector<float>* values = dumps[i].find(item->first);
+				if (values == NULL)
+				{
+					fail = !is_time;
+				}
+				else if (is_time)
+				{
+					const float time = values->empty() ? 0.f : (*values)[0];
+					const float speedup = time > 0.f && !item->second.empty() ? item->second[0] / time : 0.f;
+					snprintf(cell, sizeof(cell), "%.2fx %9.3f ms", speedup, time);
+					record.set("time_ms", (double)time).set("speedup", (double)speedup);
+				}
+				else if (is_detect)
+				{
+					const float agreement = detectionAgreement(item->second, *values);
+					fail = agreement < opt.min_agreement;
+					snprintf(cell, sizeof(cell), "%d/%d %.2f", (int)values->size() / 5, (int)item->second.size() / 5, agreement);
+					record.set("agreement", (double)agreement);
+				}
+				else if (values->size() != item->second.size())
+				{
+					snprintf(cell, sizeof(cell), "size %d != %d", (int)values->size(), (int)item->second.size());
+					fail = true;
+				}
+				else
+				{
+					double max_error = 0., sum_error = 0.;
+					for (size_t k = 0; k < values->size(); ++k)
+					{
+						const double error = std::fabs((double)(*values)[k] - (double)item->second[k]);
+						max_error = MAX(max_error, error);
+						sum_error += error;
+					}
+					const double mean_error = values->empty() ? 0. : sum_error / double(values->size());
+					fail = mean_error > opt.max_mean_error || (opt.max_error > 0.f && max_error > opt.max_error);
+					snprintf(cell, sizeof(cell), "%.2e / %.2e", max_error, mean_error);
+					record.set("max_abs_error", max_error).set("mean_abs_error", mean_error);
+				}
+
+				if (fail) failures++;
+				record.set("pass", !fail);
+				records.push_back(record);
+
+				printf(" %22s%s", cell, fail ? " !" : "  ");
+			}
+			printf("\n");
+		}
+
+		printf("\nnetwork outputs: max / mean abs error (limits %g / %g), detect: detections/reference agreement (limit %g), time: speedup over reference\n",
+			opt.max_error, opt.max_mean_error, opt.min_agreement);
+		printf("%d failure(s)\n", failures);
+
+		if (!opt.json_file.empty())
+		{
+			Record config;
+			config.set("reference", ref.backend)
+				.set("models", ref.models)
+				.set("max_mean_error", (double)opt.max_mean_error)
+				.set("max_error", (double)opt.max_error)
+				.set("min_agreement", (double)opt.min_agreement);
+
+			if (saveRecords(opt.json_file, "conformance", config, records) < 0) return -1;
+		}
+
+		return failures > 0 ? 1 : 0;
+	}
+
+	void printUsage()
+	{
+		printf("ConformanceTest --dump FILE [options]     run the workload with the simd backend of this build\n");
+		printf("ConformanceTest --compare REF,FILE,...    compare dumps of other builds against the reference dump\n");
+		printf("	--images FILE,...     binary ppm/pgm images for network inputs and detection agreement\n");
+		printf("	--sizes WxH,...       synthetic network inputs (default 160x120,333x250), 'none' to skip\n");
+		printf("	--models DIR          directory with cnn4face1..3 models (default models/)\n");
+		printf("	--gpu 0|1             run detection with the GPU pipeline (OpenCL or CUDA builds)\n");
+		printf("	--avx512 0|1          AVX-512 stage 1 kernels (AVX2 builds, default - if supported by cpu)\n");
+		printf("	--winograd M1,M2,M3   stage 1-3 masks of 3x3 conv layers run as Winograd F(2x2,3x3) (cntk models, default 0,0,0)\n");
+		printf("	--template M1,M2,M3   stage 1-3 masks of conv layers run by generated conv kernels (cntk models, default 0,0,0)\n");
+		printf("	--patches N           stage 2/3 patches per input (default 256)\n");
+		printf("	--heads 0|1           stage 1-3 evaluate all output neurons in one pass (ForwardOutputs, cntk models)\n");
+		printf("	--int8 0|1            int8 conv layers of int8 models (format 1.2), 0 - their float weights (default 0)\n");
+		printf("	--vnni 0|1            vpdpbusd int8 kernels (AVX2 builds, default - if supported by cpu)\n");
+		printf("	--repeat N            timed runs, median is reported (default 5)\n");
+		printf("	--max-mean-error X    mean abs error of network outputs (default 0.002)\n");
+		printf("	--max-error X         max abs error of network outputs (default 0 - not checked)\n");
+		printf("	--min-agreement X     detection agreement (default 0.9)\n");
+		printf("	--json FILE           write comparison as json\n");
+	}
+
+	bool parseOptions(int argc, char** argv, Options& opt)
+	{
+		for (int i = 1; i < argc; ++i)
+		{
+			const std::string arg = argv[i];
+			if (arg == "--help" || arg == "-h") return false;
+			if (i + 1 >= argc)
+			{
+				printf("[ConformanceTest] Missing value for %s!\n", arg.c_str());
+				return false;
+			}
+
+			const std::string val = argv[++i];
+			if (arg == "--dump") opt.dump_file = val;
+			else if (arg == "--compare")
+			{
+				std::stringstream stream(val);
+				std::string item;
+				while (std::getline(stream, item, ',')) if (!item.empty()) opt.compare_files.push_back(item);
+			}
+			else if (arg == "--images")
+			{
+				std::stringstream stream(val);
+				std::string item;
+				while (std::getline(stream, item, ',')) if (!item.empty()) opt.images.push_back(item);
+			}
+			else if (arg == "--sizes") opt.sizes = parseSizes(val);
+			else if (arg == "--models") opt.models = val;
+			else if (arg == "--gpu") opt.gpu = atoi(val.c_str()) != 0;
+			else if (arg == "--avx512") opt.avx512 = atoi(val.c_str()) != 0 ? 1 : 0;
+			else if (arg == "--winograd")
+			{
+				std::stringstream stream(val);
+				std::string item;
+				for (int k = 0; k < 3 && std::getline(stream, item, ','); ++k) opt.winograd_layers[k] = atoi(item.c_str());
+			}
+			else if (arg == "--template")
+			{
+				std::stringstream stream(val);
+				std::string item;
+				for (int k = 0; k < 3 && std::getline(stream, item, ','); ++k) opt.template_layers[k] = atoi(item.c_str());
+			}
+			else if (arg == "--patches") opt.patches = MAX(1, atoi(val.c_str()));
+			else if (arg == "--heads") opt.heads = atoi(val.c_str()) != 0;
+			else if (arg == "--int8") opt.int8 = atoi(val.c_str()) != 0;
+			else if (arg == "--vnni") opt.vnni = atoi(val.c_str()) != 0 ? 1 : 0;
+			else if (arg == "--repeat") opt.repeat = MAX(1, atoi(val.c_str()));
+			else if (arg == "--max-mean-error") opt.max_mean_error = (float)atof(val.c_str());
+			else if (arg == "--max-error") opt.max_error = (float)atof(val.c_str());
+			else if (arg == "--min-agreement") opt.min_agreement = (float)atof(val.c_str());
+			else if (arg == "--json") opt.json_file = val;
+			else
+			{
+				printf("[ConformanceTest] Unknown option %s!\n", arg.c_str());
+				return false;
+			}
+		}
+
+		if (!opt.models.empty() && opt.models.back() != '/' && opt.models.back() != '\\') opt.models += "/";
+
+		if (opt.compare_files.size() == 1)
+		{
+			printf("[ConformanceTest] Nothing to compare with!\n");
+			return false;
+		}
+
+		return opt.dump_file.empty() != opt.compare_files.empty();
+	}
+}
+
+int main(int argc, char** argv)
+{
+	Options opt;
+	if (!parseOptions(argc, argv, opt))
+	{
+		printUsage();
+		return -1;
+	}
+
+	if (!opt.compare_files.empty())
+	{
+		return compareDumps(opt);
+	}
+
+#if !defined(USE_CL) && !defined(USE_CUDA)
+	if (opt.gpu)
+	{
+		printf("[ConformanceTest] GPU pipeline is not available in this build!\n");
+		return -1;
+	}
+#endif
+
+	if (opt.avx512 >= 0)
+	{
+#if defined(USE_FIXED_POINT) && defined(USE_AVX512)
+		SIMD::CNNPP_v4::setEnabled(opt.avx512 == 1);
+		if (opt.avx512 == 1 && !SIMD::CNNPP_v4::isEnabled())
+		{
+			printf("[ConformanceTest] AVX-512 is not supported by cpu!\n");
+			return -1;
+		}
+#else
+		if (opt.avx512 == 1)
+		{
+			printf("[ConformanceTest] AVX-512 kernels are not available in this build!\n");
+			return -1;
+		}
+#endif
+	}
+
+	if (opt.vnni >= 0)
+	{
+#if defined(USE_CNTK_MODELS) && defined(USE_AVX2)
+		SIMD::ConvTemplate::setVNNIEnabled(opt.vnni == 1);
+		if (opt.vnni == 1 && !SIMD::ConvTemplate::isVNNIEnabled())
+		{
+			printf("[ConformanceTest] VNNI is not supported by cpu or build!\n");
+			return -1;
+		}
+#else
+		if (opt.vnni == 1)
+		{
+			printf("[ConformanceTest] VNNI kernels are not available in this build!\n");
+			return -1;
+		}
+#endif
+	}
+
+#ifndef USE_CNTK_MODELS
+	if (opt.winograd_layers[0] | opt.winograd_layers[1] | opt.winograd_layers[2])
+	{
+		printf("[ConformanceTest] Winograd conv layers are available with cntk models only!\n");
+		return -1;
+	}
+	if (opt.template_layers[0] | opt.template_layers[1] | opt.template_layers[2])
+	{
+		printf("[ConformanceTest] Generated conv kernels are available with cntk models only!\n");
+		return -1;
+	}
+	if (opt.heads)
+	{
+		printf("[ConformanceTest] ForwardOutputs is available with cntk models only!\n");
+		return -1;
+	}
+#endif
+
+	std::vector<Input> inputs;
+	for (auto it = opt.images.begin(); it != opt.images.end(); ++it)
+	{
+		Input input;
+		const size_t pos = it->find_last_of("/\\");
+		input.name = pos == std::string::npos ? *it : it->substr(pos + 1);
+		input.image.reset(new SIMD::Image_8u());
+		if (loadPNM(*it, *input.image) < 0) return -1;
+		inputs.push_back(std::move(input));
+	}
+	for (auto size = opt.sizes.begin(); size != opt.sizes.end(); ++size)
+	{
+		Input input;
+		input.name = "synthetic_" + sizeToString(*size);
+		input.image = makeSyntheticImage(*size, 11 + size->width);
+		inputs.push_back(std::move(input));
+	}
+	if (inputs.empty())
+	{
+		printUsage();
+		return -1;
+	}
+
+	Dump dump;
+	dump.backend = getBackendName(opt.gpu, opt.winograd_layers, opt.template_layers, opt.heads, opt.int8);
+	dump.models = model_family;
+
+	printf("conformance dump: %s (%s models)\n", dump.backend.c_str(), dump.models.c_str());
+	if (runStage1(inputs, opt, dump) < 0) return -1;
+	if (runCheckStage(2, inputs, opt, dump) < 0) return -1;
+	if (runCheckStage(3, inputs, opt, dump) < 0) return -1;
+	if (runDetector(inputs, opt, dump) < 0) return -1;
+
+	for (auto it = dump.items.begin(); it != dump.items.end(); ++it)
+	{
+		if (it->first.compare(0, 5, "time/") == 0) printf("%-36s %9.3f ms\n", it->first.c_str(), it->second[0]);
+	}
+
+	return saveDump(opt.dump_file, dump);
+}
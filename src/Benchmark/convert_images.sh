@@ -0,0 +1,44 @@
+#!/bin/sh
+#	converts test_images/*.jpg to binary ppm, the input format of the benchmarks (the repo has no jpeg decoder),
+#	with the first converter found: ImageMagick, djpeg (libjpeg), ffmpeg or python3 with Pillow
+#
+#	usage: src/Benchmark/convert_images.sh [output dir]
+#	prints the comma separated list of ppm files (--images of DetectorBenchmark, ConformanceTest and ModelQuantizer)
+
+set -e
+
+ROOT=$(cd "$(dirname "$0")/../.." && pwd)
+OUT_DIR=${1:-$ROOT/_images}
+
+has_tool() {
+	command -v "$1" > /dev/null 2>&1
+}
+
+if has_tool magick; then
+	convert_jpg() { magick "$1" "$2"; }
+elif has_tool convert; then
+	convert_jpg() { convert "$1" "$2"; }
+elif has_tool djpeg; then
+	convert_jpg() { djpeg -pnm -outfile "$2" "$1"; }
+elif has_tool ffmpeg; then
+	convert_jpg() { ffmpeg -loglevel error -y -i "$1" -pix_fmt rgb24 "$2"; }
+elif has_tool python3 && python3 -c "import PIL" > /dev/null 2>&1; then
+	convert_jpg() { python3 -c "import sys; from PIL import Image; Image.open(sys.argv[1]).convert('RGB').save(sys.argv[2], 'PPM')" "$1" "$2"; }
+else
+	echo "[convert_images] No jpeg converter found (ImageMagick, djpeg, ffmpeg or python3 Pillow)!" >&2
+	exit 1
+fi
+
+mkdir -p "$OUT_DIR"
+OUT_DIR=$(cd "$OUT_DIR" && pwd)
+
+IMAGES=""
+for jpg in "$ROOT"/test_images/[0-9].jpg; do
+	ppm="$OUT_DIR/$(basename "$jpg" .jpg).ppm"
+	if [ ! -f "$ppm" ] || [ "$jpg" -nt "$ppm" ]; then
+		convert_jpg "$jpg" "$ppm"
+	fi
+	IMAGES="${IMAGES:+$IMAGES,}$ppm"
+done
+
+echo "$IMAGES"
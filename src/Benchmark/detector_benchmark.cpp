@@ -0,0 +1,768 @@
+/*
+*	Copyright (c) 2018, Ilya Kalinovskiy
+*	All rights reserved.
+*
+*	This is an implementation of the algorithm described in the following paper:
+*		I.A. Kalinovskiy, V.G. Spitsyn,
+*		Compact Convolutional Neural Network Cascade for Face Detection,
+*		http://arxiv.org/abs/1508.01292.
+*
+*	Redistribution and use of this program as source code or in binary form, with or without modifications, are permitted provided that the following conditions are met:
+*		1. Redistributions may not be sold, nor may they be used in a commercial product or activity without prior permission from the copyright holder (contact him at kua_21@mail.ru).
+*		2. Redistributions may not be used for military purposes.
+*		3. Any published work which utilizes this program shall include the reference to the paper available at http://arxiv.org/abs/1508.01292
+*		4. Redistributions must retain the above copyright notice and the reference to the algorithm on which the implementation is based on, this list of conditions and the following disclaimer.
+*
+*	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+*	IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#include "cnn_detector_v3.h"
+#include "cnn_detector_scheduler.h"
+#include "timer.h"
+
+#include "benchmark_utils.h"
+
+#include <thread>
+#include <atomic>
+#include <memory>
+#include <random>
+#include <numeric>
+#include <cmath>
+#include <mutex>
+
+
+//================================================================================================================================================
+
+
+using namespace NeuralNetworksLib;
+using namespace NeuralNetworksLib::Benchmark;
+
+namespace
+{
+	struct Input
+	{
+		std::string name;
+		std::unique_ptr<SIMD::Image_8u> image;
+	};
+
+	struct Config
+	{
+		std::string mode;
+		bool packet_detection = false;
+		bool approx_pyramid = false;
+		float scale_factor = 1.2f;
+		int threads = 1;
+		int instances = 1;
+	};
+
+	struct Result
+	{
+		int num_threads = 0;			//effective threads of one detector
+		int num_detections = 0;
+		std::vector<double> latency;	//ms per Detect call, all instances
+		double wall_time = 0.;			//s for all timed frames
+		Packing2D::Layout layout;		//packed pyramid of instance 0, with packet_detection
+		bool hardware = false;
+		DetectorProfiler::Report report;	//profiler of instance 0, with --hw-counters
+		int exact_detections = 0;		//detections of exact pyramid, with approx_pyramid
+		int matched_detections = 0;		//exact detections found with approx_pyramid (IoU > 0.5)
+	};
+
+	struct Options
+	{
+		std::vector<std::string> images;
+		std::vector<Size> sizes = { Size(640, 480), Size(1280, 720), Size(1920, 1080), Size(3840, 2160) };
+		std::string models = "models/";
+		std::vector<int> threads;
+		std::vector<int> instances = { 1 };
+		std::vector<std::string> modes = { "sync" };
+		std::vector<int> packet = { 0 };
+		std::vector<int> approx = { 0 };
+		int approx_step = 0;
+		std::vector<float> scale_factors = { 1.2f };
+		int min_obj_size = 40;
+		int frames = 20;
+		int warmup = 2;
+		std::string json_file;
+		std::string baseline_file;
+		double tolerance = 0.1;
+		bool hw_counters = false;
+		int stream_workers = 0;
+	};
+
+	std::vector<std::string> splitList(const std::string& str)
+	{
+		std::vector<std::string> list;
+		std::stringstream stream(str);
+		std::string item;
+		while (std::getline(stream, item, ','))
+		{
+			if (!item.empty()) list.push_back(item);
+		}
+		return list;
+	}
+	std::vector<float> parseFloatList(const std::string& str)
+	{
+		std::vector<float> list;
+		const std::vector<std::string> items = splitList(str);
+		for (auto it = items.begin(); it != items.end(); ++it)
+		{
+			list.push_back((float)atof(it->c_str()));
+		}
+		return list;
+	}
+
+	bool parseDetectMode(const std::string& str, CNNDetector::DetectMode& mode)
+	{
+		if (str == "disable") mode = CNNDetector::DetectMode::disable;
+		else if (str == "sync") mode = CNNDetector::DetectMode::sync;
+		else if (str == "async") mode = CNNDetector::DetectMode::async;
+		else return false;
+		return true;
+	}
+
+	std::string baseName(const std::string& path)
+	{
+		const size_t pos = path.find_last_of("/\\");
+		return pos == std::string::npos ? path : path.substr(pos + 1);
+	}
+
+	//synthetic frame: nearest neighbour rescale of a real image keeps faces in the scene,
+	//smooth noise when no image is given (stage 1 load only, few candidates reach stage 2/3)
+	std::unique_ptr<SIMD::Image_8u> makeSyntheticFrame(Size size, const SIMD::Image_8u* source, unsigned int seed)
+	{
+		std::unique_ptr<SIMD::Image_8u> frame(new SIMD::Image_8u(size.width, size.height, 3, ALIGN_DEF, false));
+
+		if (source != NULL)
+		{
+			for (int y = 0; y < size.height; ++y)
+			{
+				const uchar_* src = source->data + (y * source->height / size.height) * source->widthStep;
+				uchar_* dst = frame->data + y * frame->widthStep;
+				for (int x = 0; x < size.width; ++x)
+				{
+					const int sx = x * source->width / size.width;
+					dst[3 * x + 0] = src[3 * sx + 0];
+					dst[3 * x + 1] = src[3 * sx + 1];
+					dst[3 * x + 2] = src[3 * sx + 2];
+				}
+			}
+			return frame;
+		}
+
+		std::mt19937 rng(seed);
+		std::uniform_real_distribution<float> rnd(0.f, 1.f);
+		const float fx = 0.02f + 0.05f * rnd(rng);
+		const float fy = 0.02f + 0.05f * rnd(rng);
+		for (int y = 0; y < size.height; ++y)
+		{
+			uchar_* dst = frame->data + y * frame->widthStep;
+			for (int x = 0; x < size.width; ++x)
+			{
+				const float value = 128.f + 60.f * sinf(fx * x) * cosf(fy * y) + 30.f * sinf(0.005f * (x + y)) + 20.f * (rnd(rng) - 0.5f);
+				const uchar_ gray = (uchar_)MIN(MAX(value, 0.f), 255.f);
+				dst[3 * x + 0] = dst[3 * x + 1] = dst[3 * x + 2] = gray;
+			}
+		}
+		return frame;
+	}
+
+	float overlap(const Rect& a, const Rect& b)
+	{
+		const int w = MIN(a.x2, b.x2) - MAX(a.x, b.x);
+		const int h = MIN(a.y2, b.y2) - MAX(a.y, b.y);
+		if (w <= 0 || h <= 0) return 0.f;
+		const float inter = float(w) * float(h);
+		return inter / (float(a.width) * float(a.height) + float(b.width) * float(b.height) - inter);
+	}
+
+	void initParam(const Input& input, const Config& config, const Options& opt, CNNDetector::Param& param, CNNDetector::AdvancedParam& advanced_param)
+	{
+		param.max_image_size = input.image->getSize();
+		param.min_obj_size = Size(opt.min_obj_size, opt.min_obj_size);
+		param.scale_factor = config.scale_factor;
+		param.num_threads = config.threads;
+
+		parseDetectMode(config.mode, advanced_param.detect_mode);
+		advanced_param.packet_detection = config.packet_detection;
+		advanced_param.approx_step = opt.approx_step;
+#ifdef USE_CNTK_MODELS
+		const std::string suffix = "_cntk.bin";
+#else
+		const std::string suffix = "_new.bin";
+#endif
+		for (int i = 0; i < 3; ++i)
+		{
+			advanced_param.path_model[i] = opt.models + "cnn4face" + std::to_string(i + 1) + suffix;
+		}
+	}
+
+	int runConfig(const Input& input, const Config& config, const Options& opt, Result& result)
+	{
+		CNNDetector::Param param;
+		CNNDetector::AdvancedParam advanced_param;
+		initParam(input, config, opt, param, advanced_param);
+
+		//accuracy of approximate pyramid is measured against detections of exact one
+		std::vector<CNNDetector::Detection> exact_detections;
+		if (config.approx_pyramid)
+		{
+			CNNDetector detector(&param, &advanced_param);
+			if (detector.isEmpty())
+			{
+				printf("[DetectorBenchmark] Could not create detector (models %s)!\n", opt.models.c_str());
+				return -1;
+			}
+			detector.Detect(exact_detections, *input.image);
+			advanced_param.approx_pyramid = true;
+		}
+
+		std::vector<std::unique_ptr<CNNDetector>> detectors;
+		for (int i = 0; i < config.instances; ++i)
+		{
+			detectors.push_back(std::unique_ptr<CNNDetector>(new CNNDetector(&param, &advanced_param)));
+			if (detectors.back()->isEmpty())
+			{
+				printf("[DetectorBenchmark] Could not create detector (models %s)!\n", opt.models.c_str());
+				return -1;
+			}
+		}
+		result.num_threads = detectors[0]->getNumThreads();
+
+		if (opt.hw_counters)
+		{
+			for (auto it = detectors.begin(); it != detectors.end(); ++it)
+			{
+				result.hardware = (*it)->getProfiler().setHardwareCounters(true);
+			}
+		}
+
+		//every instance runs on own thread with own copy of the frame
+		std::vector<std::unique_ptr<SIMD::Image_8u>> frames;
+		for (int i = 0; i < config.instances; ++i)
+		{
+			frames.push_back(std::unique_ptr<SIMD::Image_8u>(new SIMD::Image_8u(input.image->width, input.image->height, 3, ALIGN_DEF, false)));
+			frames.back()->copyData(input.image->nChannel * input.image->width, input.image->height, input.image->data, input.image->widthStep);
+		}
+
+		std::vector<std::vector<double>> latency(config.instances);
+		std::vector<int> num_detections(config.instances, 0);
+		std::vector<CNNDetector::Detection> last_detections;
+		std::atomic<int> ready(0);
+		std::atomic<bool> go(false);
+
+		auto worker = [&](int idx)
+		{
+			std::vector<CNNDetector::Detection> detections;
+			for (int i = 0; i < opt.warmup; ++i)
+			{
+				detectors[idx]->Detect(detections, *frames[idx]);
+			}
+
+			if (result.hardware)
+			{
+				DetectorProfiler& profiler = detectors[idx]->getProfiler();
+				profiler.reset();
+				profiler.setEnabled(true);
+			}
+
+			ready++;
+			while (!go.load()) std::this_thread::yield();
+
+			Timer timer(1, false);
+			for (int i = 0; i < opt.frames; ++i)
+			{
+				timer.start();
+				detectors[idx]->Detect(detections, *frames[idx]);
+				latency[idx].push_back(timer.get(1000.));
+			}
+			num_detections[idx] = (int)detections.size();
+			if (idx == 0) last_detections = detections;
+		};
+
+		std::vector<std::thread> workers;
+		for (int i = 1; i < config.instances; ++i)
+		{
+			workers.push_back(std::thread(worker, i));
+		}
+
+		//warmup of instance 0 overlaps with the others, timing starts when all are warm
+		std::thread main_worker(worker, 0);
+		while (ready.load() < config.instances) std::this_thread::yield();
+
+		Timer timer(1, true);
+		go.store(true);
+		main_worker.join();
+		for (auto& w : workers) w.join();
+		result.wall_time = timer.get(1.);
+
+		result.latency.clear();
+		for (int i = 0; i < config.instances; ++i)
+		{
+			result.latency.insert(result.latency.end(), latency[i].begin(), latency[i].end());
+		}
+		result.num_detections = num_detections[0];
+		result.exact_detections = (int)exact_detections.size();
+		result.matched_detections = 0;
+		for (auto it = exact_detections.begin(); it != exact_detections.end(); ++it)
+		{
+			for (auto jt = last_detections.begin(); jt != last_detections.end(); ++jt)
+			{
+				if (overlap(it->rect, jt->rect) > 0.5f)
+				{
+					result.matched_detections++;
+					break;
+				}
+			}
+		}
+		result.layout = detectors[0]->getPacketLayout();
+
+		if (result.hardware)
+		{
+			result.report = detectors[0]->getProfiler().getReport();
+		}
+
+		return 0;
+	}
+
+	//StreamScheduler under overload: 4 streams get frames at about twice the throughput of the pool,
+	//statistics of every stream are checked against the rate limit, queue size and deadline of the stream
+	int runStreams(const Input& input, const Options& opt, std::vector<Record>& records)
+	{
+		Config config;
+		CNNDetector::Param param;
+		CNNDetector::AdvancedParam advanced_param;
+		initParam(input, config, opt, param, advanced_param);
+
+		//single-threaded detect time sets the load
+		double time_detect = 0.;
+		{
+			CNNDetector detector(&param, &advanced_param);
+			if (detector.isEmpty())
+			{
+				printf("[DetectorBenchmark] Could not create detector (models %s)!\n", opt.models.c_str());
+				return -1;
+			}
+
+			std::vector<CNNDetector::Detection> detections;
+			for (int i = 0; i < opt.warmup; ++i)
+			{
+				detector.Detect(detections, *input.image);
+			}
+
+			Timer timer(1, true);
+			for (int i = 0; i < 3; ++i)
+			{
+				detector.Detect(detections, *input.image);
+			}
+			time_detect = MAX(timer.get(1000.) / 3., 0.1);
+		}
+
+		const int workers = opt.stream_workers;
+		const double submit_fps = 0.6 * 1000. * workers / time_detect;
+
+		const char* names[] = { "fifo", "rate", "tight", "loose" };
+		const int num_streams = sizeof(names) / sizeof(names[0]);
+		StreamScheduler::StreamParam stream_param[num_streams];
+		stream_param[1].fps = float(0.25 * submit_fps);
+		stream_param[2].max_latency = float(2. * time_detect);
+		stream_param[3].max_latency = float(8. * time_detect);
+
+		std::mutex mutex;
+		std::vector<std::vector<long long>> frame_ids(num_streams);
+		std::vector<StreamScheduler::StreamStat> stat(num_streams);
+		double duration = 0.;
+		{
+			StreamScheduler scheduler(workers, &param, &advanced_param);
+
+			std::vector<int> id(num_streams);
+			for (int k = 0; k < num_streams; ++k)
+			{
+				id[k] = scheduler.AddStream(stream_param[k], [&mutex, &frame_ids, k](int, long long frame_id, int, std::vector<CNNDetector::Detection>&)
+				{
+					std::lock_guard<std::mutex> lock(mutex);
+					frame_ids[k].push_back(frame_id);
+				});
+			}
+
+			const StreamScheduler::Clock::time_point start = StreamScheduler::Clock::now();
+			for (int f = 0; f < opt.frames; ++f)
+			{
+				std::this_thread::sleep_until(start + std::chrono::microseconds((long long)(1.e6 * f / submit_fps)));
+				for (int k = 0; k < num_streams; ++k)
+				{
+					scheduler.Submit(id[k], *input.image);
+				}
+			}
+			duration = std::chrono::duration<double>(StreamScheduler::Clock::now() - start).count();
+			scheduler.Wait();
+
+			for (int k = 0; k < num_streams; ++k)
+			{
+				scheduler.getStat(id[k], stat[k]);
+			}
+		}
+
+		printf("stream scheduler: %s %s, %d workers, detect %.2f ms, %.1f frames/s per stream\n\n",
+			input.name.c_str(), sizeToString(input.image->getSize()).c_str(), workers, time_detect, submit_fps);
+		printf("%-8s %8s %8s %10s %6s %6s %6s %6s %6s %9s %9s\n",
+			"stream", "fps", "max_lat", "submitted", "done", "rate", "queue", "stale", "miss", "lat_mean", "lat_max");
+
+		int failures = 0;
+		auto check = [&failures](bool ok, const char* stream, const char* message)
+		{
+			if (!ok)
+			{
+				printf("[DetectorBenchmark] Stream %s: %s!\n", stream, message);
+				failures++;
+			}
+		};
+
+		for (int k = 0; k < num_streams; ++k)
+		{
+			const StreamScheduler::StreamStat& st = stat[k];
+			printf("%-8s %8.1f %8.1f %10lld %6lld %6lld %6lld %6lld %6lld %9.2f %9.2f\n", names[k], stream_param[k].fps, stream_param[k].max_latency,
+				st.num_submit, st.num_processed, st.num_drop_rate, st.num_drop_queue, st.num_drop_stale, st.num_deadline_miss, st.latency_mean, st.latency_max);
+
+			check(st.num_submit == opt.frames, names[k], "submitted frames are not counted");
+			check(st.num_processed + st.num_drop_rate + st.num_drop_queue + st.num_drop_stale == st.num_submit, names[k], "frames are lost");
+			check((long long)frame_ids[k].size() == st.num_processed, names[k], "callbacks do not match processed frames");
+			check(std::is_sorted(frame_ids[k].begin(), frame_ids[k].end()), names[k], "results are out of order");
+			if (stream_param[k].fps > 0.f)
+			{
+				//token bucket: burst of 1.5 frames, one more for rounding of the last interval
+				check(st.num_drop_rate > 0, names[k], "frames above the rate limit are not dropped");
+				check(double(st.num_submit - st.num_drop_rate) <= stream_param[k].fps * duration + 2.5, names[k], "rate limit is exceeded");
+			}
+			if (stream_param[k].max_latency > 0.f)
+			{
+				//frames start before their deadline, then detection may run late
+				check(st.latency_max <= stream_param[k].max_latency + 4. * time_detect, names[k], "frame started after its deadline");
+			}
+			else
+			{
+				check(st.num_drop_stale == 0 && st.num_deadline_miss == 0, names[k], "frames without deadline are dropped as stale");
+			}
+
+			Record record;
+			record.set("input", input.name)
+				.set("stream", std::string(names[k]))
+				.set("workers", workers)
+				.set("fps", (double)stream_param[k].fps)
+				.set("max_latency", (double)stream_param[k].max_latency)
+				.set("submitted", (int)st.num_submit)
+				.set("processed", (int)st.num_processed)
+				.set("drop_rate", (int)st.num_drop_rate)
+				.set("drop_queue", (int)st.num_drop_queue)
+				.set("drop_stale", (int)st.num_drop_stale)
+				.set("deadline_miss", (int)st.num_deadline_miss)
+				.set("latency_mean_ms", st.latency_mean)
+				.set("latency_max_ms", st.latency_max);
+			records.push_back(record);
+		}
+
+		//overload fills the queue of the stream without limits, earliest deadline first serves the tight deadline before the loose one
+		check(stat[0].num_drop_queue > 0, names[0], "overload does not drop the oldest frames");
+		check(stat[2].num_processed > 0 && (stat[3].num_processed == 0 || stat[2].latency_mean < stat[3].latency_mean), names[2],
+			"tight deadline is not served before the loose one");
+
+		printf("\n%d failure(s)\n", failures);
+		return failures;
+	}
+
+	void printHardwareReport(const DetectorProfiler::Report& report)
+	{
+		auto print_value = [](bool available, const char* format, double value)
+		{
+			if (available) printf(format, value);
+			else printf("%10s", "-");
+		};
+
+		const int frames = (int)MAX(1ll, report.counter[DetectorProfiler::frames]);
+		for (int stage = 0; stage < DetectorProfiler::num_stages; ++stage)
+		{
+			const DetectorProfiler::HardwareStat& stat = report.hardware[stage];
+			if (stat.calls == 0) continue;
+
+			const bool has_cycles = (report.hardware_events & (1 << DetectorProfiler::cycles)) != 0;
+			const bool has_instructions = (report.hardware_events & (1 << DetectorProfiler::instructions)) != 0;
+			const bool has_llc = (report.hardware_events & (1 << DetectorProfiler::llc_misses)) != 0;
+			const bool has_branch = (report.hardware_events & (1 << DetectorProfiler::branch_misses)) != 0;
+			const double pixels = (double)MAX(1ll, stat.pixels);
+
+			printf("    %-10s %9.3f", DetectorProfiler::getStageName((DetectorProfiler::Stage)stage), 1.e-6 * (double)stat.value[DetectorProfiler::task_clock] / frames);
+			print_value(has_cycles && has_instructions, "%10.2f", (double)stat.value[DetectorProfiler::instructions] / (double)MAX(1ll, stat.value[DetectorProfiler::cycles]));
+			print_value(has_cycles && stat.pixels > 0, "%10.2f", (double)stat.value[DetectorProfiler::cycles] / pixels);
+			print_value(has_llc && stat.pixels > 0, "%10.3f", 64. * (double)stat.value[DetectorProfiler::llc_misses] / pixels);
+			print_value(has_branch, "%10.0f", (double)stat.value[DetectorProfiler::branch_misses] / frames);
+			printf("\n");
+		}
+	}
+
+	void printUsage()
+	{
+		printf("DetectorBenchmark [options]\n");
+		printf("	--images FILE,...     binary ppm/pgm images, also source of synthetic frames (src/Benchmark/convert_images.sh converts test_images)\n");
+		printf("	--sizes WxH,...       synthetic frame sizes (default 640x480,1280x720,1920x1080,3840x2160), 'none' to skip\n");
+		printf("	--models DIR          directory with cnn4face1..3 models (default models/)\n");
+		printf("	--threads N,...       detector threads, param.num_threads (default 1,2,4,... up to hardware threads)\n");
+		printf("	--instances N,...     detectors running concurrently on separate threads (default 1)\n");
+		printf("	--mode M,...          detect_mode: disable, sync, async (default sync)\n");
+		printf("	--packet 0|1,...      packet_detection (default 0)\n");
+		printf("	--approx 0|1,...      approx_pyramid, recall is reported against exact pyramid (default 0)\n");
+		printf("	--approx-step N       scales per anchor of approx_pyramid, 0 - one octave (default 0)\n");
+		printf("	--scale-factor X,...  pyramid scale factor (default 1.2)\n");
+		printf("	--min-obj N           minimum face size (default 40)\n");
+		printf("	--frames N            timed frames per configuration and instance (default 20)\n");
+		printf("	--warmup N            untimed frames before measuring (default 2)\n");
+		printf("	--json FILE           write results as json\n");
+		printf("	--baseline FILE       compare p50_ms against saved json results\n");
+		printf("	--tolerance X         relative slowdown reported as regression (default 0.1)\n");
+		printf("	--hw-counters 0|1     per-stage hardware counters of instance 0 (Linux perf events, enables profiler spans)\n");
+		printf("	--streams N           StreamScheduler with N workers on 4 overloaded streams of the first input instead of the sweep,\n");
+		printf("	                      checks rate, queue and deadline drops of every stream (default 0 - off, use --frames 100)\n");
+	}
+
+	bool parseOptions(int argc, char** argv, Options& opt)
+	{
+		for (int i = 1; i < argc; ++i)
+		{
+			const std::string arg = argv[i];
+			if (arg == "--help" || arg == "-h") return false;
+			if (i + 1 >= argc)
+			{
+				printf("[DetectorBenchmark] Missing value for %s!\n", arg.c_str());
+				return false;
+			}
+
+			const std::string val = argv[++i];
+			if (arg == "--images") opt.images = splitList(val);
+			else if (arg == "--sizes") opt.sizes = parseSizes(val);
+			else if (arg == "--models") opt.models = val;
+			else if (arg == "--threads") opt.threads = parseList(val);
+			else if (arg == "--instances") opt.instances = parseList(val);
+			else if (arg == "--mode") opt.modes = splitList(val);
+			else if (arg == "--packet") opt.packet = parseList(val);
+			else if (arg == "--approx") opt.approx = parseList(val);
+			else if (arg == "--approx-step") opt.approx_step = MAX(0, atoi(val.c_str()));
+			else if (arg == "--scale-factor") opt.scale_factors = parseFloatList(val);
+			else if (arg == "--min-obj") opt.min_obj_size = MAX(1, atoi(val.c_str()));
+			else if (arg == "--frames") opt.frames = MAX(1, atoi(val.c_str()));
+			else if (arg == "--warmup") opt.warmup = MAX(0, atoi(val.c_str()));
+			else if (arg == "--json") opt.json_file = val;
+			else if (arg == "--baseline") opt.baseline_file = val;
+			else if (arg == "--tolerance") opt.tolerance = atof(val.c_str());
+			else if (arg == "--hw-counters") opt.hw_counters = atoi(val.c_str()) != 0;
+			else if (arg == "--streams") opt.stream_workers = MAX(0, atoi(val.c_str()));
+			else
+			{
+				printf("[DetectorBenchmark] Unknown option %s!\n", arg.c_str());
+				return false;
+			}
+		}
+
+		for (auto it = opt.modes.begin(); it != opt.modes.end(); ++it)
+		{
+			CNNDetector::DetectMode mode;
+			if (!parseDetectMode(*it, mode))
+			{
+				printf("[DetectorBenchmark] Unknown detect mode %s!\n", it->c_str());
+				return false;
+			}
+		}
+		for (auto it = opt.scale_factors.begin(); it != opt.scale_factors.end(); ++it)
+		{
+			if (*it <= 1.f)
+			{
+				printf("[DetectorBenchmark] Scale factor must be greater than 1!\n");
+				return false;
+			}
+		}
+
+		if (!opt.models.empty() && opt.models.back() != '/' && opt.models.back() != '\\') opt.models += "/";
+
+		if (opt.threads.empty())
+		{
+			const int hw_threads = MAX(1, (int)std::thread::hardware_concurrency());
+			for (int t = 1; t < hw_threads; t *= 2) opt.threads.push_back(t);
+			opt.threads.push_back(hw_threads);
+		}
+		for (auto it = opt.instances.begin(); it != opt.instances.end(); ++it) *it = MAX(1, *it);
+
+		return !opt.modes.empty() && !opt.packet.empty() && !opt.approx.empty() && !opt.scale_factors.empty() && !opt.instances.empty()
+			&& (!opt.images.empty() || !opt.sizes.empty());
+	}
+}
+
+int main(int argc, char** argv)
+{
+	Options opt;
+	if (!parseOptions(argc, argv, opt))
+	{
+		printUsage();
+		return -1;
+	}
+
+	std::vector<Input> inputs;
+	for (auto it = opt.images.begin(); it != opt.images.end(); ++it)
+	{
+		Input input;
+		input.name = baseName(*it);
+		input.image.reset(new SIMD::Image_8u());
+		if (loadPNM(*it, *input.image) < 0) return -1;
+		inputs.push_back(std::move(input));
+	}
+	const SIMD::Image_8u* source = inputs.empty() ? NULL : inputs[0].image.get();
+	for (auto size = opt.sizes.begin(); size != opt.sizes.end(); ++size)
+	{
+		Input input;
+		input.name = "synthetic_" + sizeToString(*size);
+		input.image = makeSyntheticFrame(*size, source, 7);
+		inputs.push_back(std::move(input));
+	}
+
+	if (opt.stream_workers > 0)
+	{
+		std::vector<Record> records;
+		const int failures = runStreams(inputs[0], opt, records);
+		if (failures < 0) return -1;
+
+		if (!opt.json_file.empty())
+		{
+			Record config;
+			config.set("simd", getSIMDName())
+				.set("hardware_threads", (int)std::thread::hardware_concurrency())
+				.set("min_obj_size", opt.min_obj_size)
+				.set("frames", opt.frames);
+
+			if (saveRecords(opt.json_file, "streams", config, records) < 0) return -1;
+		}
+
+		return failures > 0 ? 1 : 0;
+	}
+
+	printf("detector benchmark: %s, %d hardware threads\n\n", getSIMDName().c_str(), (int)std::thread::hardware_concurrency());
+	printf("%-24s %-10s %-7s %3s %3s %5s %4s %4s %4s %9s %9s %9s %8s %5s %8s\n",
+		"input", "size", "mode", "pkt", "apx", "scale", "thr", "used", "inst", "p50_ms", "p90_ms", "p99_ms", "fps", "det", "scaling");
+
+	std::vector<Record> records;
+	for (auto input = inputs.begin(); input != inputs.end(); ++input)
+	{
+		for (auto mode = opt.modes.begin(); mode != opt.modes.end(); ++mode)
+		{
+			for (auto packet = opt.packet.begin(); packet != opt.packet.end(); ++packet)
+			{
+				for (auto approx = opt.approx.begin(); approx != opt.approx.end(); ++approx)
+				{
+					for (auto scale_factor = opt.scale_factors.begin(); scale_factor != opt.scale_factors.end(); ++scale_factor)
+					{
+						//scaling efficiency is throughput per core relative to the first configuration of the sweep
+						double fps_per_core_ref = 0.;
+						for (auto instances = opt.instances.begin(); instances != opt.instances.end(); ++instances)
+						{
+							for (auto threads = opt.threads.begin(); threads != opt.threads.end(); ++threads)
+							{
+								Config config;
+								config.mode = *mode;
+								config.packet_detection = *packet != 0;
+								config.approx_pyramid = *approx != 0;
+								config.scale_factor = *scale_factor;
+								config.threads = *threads;
+								config.instances = *instances;
+
+								Result result;
+								if (runConfig(*input, config, opt, result) < 0) return -1;
+
+								const double fps = double(result.latency.size()) / MAX(result.wall_time, 1.e-9);
+								const int cores = MAX(1, result.num_threads) * config.instances;
+								if (fps_per_core_ref == 0.) fps_per_core_ref = fps / cores;
+								const double scaling = fps / (cores * fps_per_core_ref);
+
+								const double mean = std::accumulate(result.latency.begin(), result.latency.end(), 0.) / double(result.latency.size());
+								const double p50 = percentile(result.latency, 0.5);
+								const double p90 = percentile(result.latency, 0.9);
+								const double p99 = percentile(result.latency, 0.99);
+
+								printf("%-24s %-10s %-7s %3d %3d %5.2f %4d %4d %4d %9.2f %9.2f %9.2f %8.2f %5d %8.2f\n", input->name.c_str(),
+									sizeToString(input->image->getSize()).c_str(), mode->c_str(), *packet != 0, *approx != 0, *scale_factor,
+									config.threads, result.num_threads, config.instances, p50, p90, p99, fps, result.num_detections, scaling);
+								if (config.packet_detection)
+								{
+									printf("    packed %s, %s, strip %d, area ratio %.3f, stage-1 waste %.3f\n", sizeToString(result.layout.size).c_str(),
+										Packing2D::getMethodName(result.layout.method), result.layout.strip_width, result.layout.area_ratio, result.layout.waste);
+								}
+								if (config.approx_pyramid)
+								{
+									printf("    approximate pyramid: %d/%d detections of exact pyramid found\n", result.matched_detections, result.exact_detections);
+								}
+								if (result.hardware)
+								{
+									printf("    %-10s %9s %10s %10s %10s %10s\n", "stage", "ms/frame", "ipc", "cyc/px", "llc_B/px", "br_miss");
+									printHardwareReport(result.report);
+								}
+
+								Record record;
+								record.set("input", input->name)
+									.set("size", sizeToString(input->image->getSize()))
+									.set("mode", *mode)
+									.set("packet", *packet != 0)
+									.set("approx", *approx != 0)
+									.set("scale_factor", (double)*scale_factor)
+									.set("threads", config.threads)
+									.set("num_threads", result.num_threads)
+									.set("instances", config.instances)
+									.set("frames", (int)result.latency.size())
+									.set("detections", result.num_detections)
+									.set("mean_ms", mean)
+									.set("p50_ms", p50)
+									.set("p90_ms", p90)
+									.set("p99_ms", p99)
+									.set("max_ms", *std::max_element(result.latency.begin(), result.latency.end()))
+									.set("fps", fps)
+									.set("scaling", scaling);
+								if (config.approx_pyramid)
+								{
+									record.set("exact_detections", result.exact_detections)
+										.set("matched_detections", result.matched_detections);
+								}
+								if (config.packet_detection)
+								{
+									record.set("pack_size", sizeToString(result.layout.size))
+										.set("pack_method", std::string(Packing2D::getMethodName(result.layout.method)))
+										.set("pack_waste", (double)result.layout.waste);
+								}
+								records.push_back(record);
+							}
+						}
+					}
+				}
+			}
+		}
+	}
+
+	if (!opt.json_file.empty())
+	{
+		Record config;
+		config.set("simd", getSIMDName())
+			.set("hardware_threads", (int)std::thread::hardware_concurrency())
+			.set("min_obj_size", opt.min_obj_size)
+			.set("frames", opt.frames)
+			.set("warmup", opt.warmup);
+
+		if (saveRecords(opt.json_file, "detector", config, records) < 0) return -1;
+	}
+
+	if (!opt.baseline_file.empty())
+	{
+		std::vector<Record> baseline;
+		if (loadRecords(opt.baseline_file, baseline) < 0) return -1;
+
+		const int regressions = compareBaseline(records, baseline, { "input", "mode", "packet", "approx", "scale_factor", "threads", "instances" }, "p50_ms", true, opt.tolerance);
+		printf("\n%d regression(s)\n", regressions);
+		if (regressions > 0) return 1;
+	}
+
+	return 0;
+}
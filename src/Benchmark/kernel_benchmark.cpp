@@ -0,0 +1,727 @@
+/*
+*	Copyright (c) 2018, Ilya Kalinovskiy
+*	All rights reserved.
+*
+*	This is an implementation of the algorithm described in the following paper:
+*		I.A. Kalinovskiy, V.G. Spitsyn,
+*		Compact Convolutional Neural Network Cascade for Face Detection,
+*		http://arxiv.org/abs/1508.01292.
+*
+*	Redistribution and use of this program as source code or in binary form, with or without modifications, are permitted provided that the following conditions are met:
+*		1. Redistributions may not be sold, nor may they be used in a commercial product or activity without prior permission from the copyright holder (contact him at kua_21@mail.ru).
+*		2. Redistributions may not be used for military purposes.
+*		3. Any published work which utilizes this program shall include the reference to the paper available at http://arxiv.org/abs/1508.01292
+*		4. Redistributions must retain the above copyright notice and the reference to the algorithm on which the implementation is based on, this list of conditions and the following disclaimer.
+*
+*	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+*	IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#include "config.h"
+#include "image.h"
+#include "image_resize.h"
+#include "image_proc.h"
+#include "timer.h"
+
+#include "cnnpp_cplusplus.h"
+#include "cnnpp_simd_sse.h"
+#include "cnnpp_simd_avx.h"
+#include "cnnpp_simd_avx_v2.h"
+#include "cnnpp_simd_avx_v3.h"
+#include "cnnpp_simd_avx512_v4.h"
+#include "activation_simd.h"
+
+#include "benchmark_utils.h"
+
+#include <thread>
+#include <atomic>
+#include <memory>
+#include <functional>
+#include <random>
+#include <cstring>
+#include <cmath>
+
+
+//================================================================================================================================================
+
+
+using namespace NeuralNetworksLib;
+using namespace NeuralNetworksLib::Benchmark;
+
+namespace
+{
+	const int num_weights = 64 * 2048;
+	const int num_weight_ptr = 64;
+
+	//per thread buffers, every kernel reads and writes only own context
+	struct Context
+	{
+		Size size;
+
+		SIMD::Image_32f src;
+		SIMD::Image_32f src2;
+		SIMD::Image_32f src3;
+		SIMD::Image_32f dst;
+		SIMD::Image_32f resize_dst;
+		SIMD::Image_8u src_8u;
+
+		SIMD::Array_32f weights;
+		std::vector<float*> weight_ptr;
+		std::vector<float*> src_ptr;
+		float scale = 1.f;
+		int size_ = 0;				//element-wise kernels length
+		int plane_size = 0;
+
+		SIMD::CNNPP cnnpp;
+		SIMD::ImageResizer resizer;
+
+#ifdef USE_AVX
+		//stage 1 layer buffers with ConvNeuralNetwork_v2 geometry
+		Size2d l1_roi, l2_roi, l3_roi;
+		Size2d lb_size[3];
+		SIMD::Array_32f lb[3];
+
+		//4 interleaved maps per pixel
+		SIMD::Array_32f wide;
+
+		SIMD::CNNPP_v2 cnnpp_v2;
+#endif
+#ifdef USE_FIXED_POINT
+		SIMD::CNNPP_v3 cnnpp_v3;
+#endif
+#if defined(USE_FIXED_POINT) && defined(USE_AVX512)
+		SIMD::CNNPP_v4 cnnpp_v4;
+#endif
+
+		explicit Context(Size _size, unsigned int seed) : size(_size)
+		{
+			std::mt19937 rng(seed);
+			std::uniform_real_distribution<float> rnd(-1.f, 1.f);
+
+			//padding covers the largest kernel and register tails
+			const int stride = roundUpMul(size.width + 16, 4 * REG_SIZE);
+			src = SIMD::Image_32f(size.width, size.height + 16, stride, ALIGN_DEF);
+			dst = SIMD::Image_32f(size.width, size.height + 16, stride, ALIGN_DEF);
+			src2 = SIMD::Image_32f(size.width, size.height + 16, stride, ALIGN_DEF);
+			src3 = SIMD::Image_32f(size.width, size.height + 16, stride, ALIGN_DEF);
+			src.height = src2.height = src3.height = dst.height = size.height;
+			for (int i = 0; i < src.widthStep * (size.height + 16); ++i)
+			{
+				src.data[i] = 128.f * (rnd(rng) + 1.f);
+				src2.data[i] = rnd(rng);
+				src3.data[i] = rnd(rng);
+			}
+			size_ = roundUpMul(size.width * size.height, 4 * REG_SIZE);
+
+			resize_dst = SIMD::Image_32f(int(0.8f * size.width), int(0.8f * size.height), roundUpMul(int(0.8f * size.width) + 1, REG_SIZE), ALIGN_DEF);
+
+			//simd converters read one register past the last pixel
+			src_8u = SIMD::Image_8u(size.width, size.height + 1, 3, ALIGN_DEF, true);
+			for (int i = 0; i < src_8u.widthStep * (size.height + 1); ++i)
+			{
+				src_8u.data[i] = uchar_(rng() & 0xFF);
+			}
+			src_8u.height = size.height;
+
+			//small weights keep activations in a realistic range
+			weights = SIMD::Array_32f(num_weights, ALIGN_DEF);
+			for (int i = 0; i < num_weights; ++i)
+			{
+				weights[i] = 0.1f * rnd(rng);
+			}
+			for (int i = 0; i < num_weight_ptr; ++i)
+			{
+				weight_ptr.push_back(weights() + i * (num_weights / num_weight_ptr));
+			}
+
+			//24 planes for snn kernels, every plane covers 1 / 24 of the image
+			plane_size = roundUpMul(size.width * size.height / 24, 4 * REG_SIZE);
+			for (int i = 0; i < 24; ++i)
+			{
+				src_ptr.push_back(src.data + i * plane_size);
+			}
+
+#ifdef USE_AVX
+			l1_roi = Size2d(size.width - 3, size.height - 3);
+			lb_size[0].cols = roundUpMul(roundUp(4 * l1_roi.cols, 2), REG_SIZE);
+			lb_size[0].rows = 2 * roundUp(l1_roi.rows, 2);
+
+			l2_roi = Size2d((l1_roi.cols >> 1) - 2, (l1_roi.rows >> 1) - 2);
+			lb_size[1].cols = roundUpMul(roundUp(8 * l2_roi.cols, 2), 2 * REG_SIZE);
+			lb_size[1].rows = 2 * roundUp(l2_roi.rows, 2);
+
+			l3_roi = Size2d((l2_roi.cols >> 1) - 3, (l2_roi.rows >> 1) - 4);
+			lb_size[2].cols = roundUpMul(16 * l3_roi.cols, 4 * REG_SIZE);
+			lb_size[2].rows = l3_roi.rows;
+
+			for (int i = 0; i < 3; ++i)
+			{
+				lb[i] = SIMD::Array_32f(lb_size[i].cols * (lb_size[i].rows + 8), ALIGN_DEF);
+			}
+			wide = SIMD::Array_32f(4 * stride * (size.height + 16), ALIGN_DEF);
+#endif
+		}
+
+		Context(const Context&) = delete;
+		Context& operator=(const Context&) = delete;
+	};
+
+	struct Kernel
+	{
+		std::string group;
+		std::string name;
+		double flops_per_pixel;		//0 if not meaningful
+		double bytes_per_pixel;		//nominal traffic, input and output
+		bool stage1_size;			//skipped for images smaller than stage 1 input
+		std::function<void(Context&)> run;
+	};
+
+	struct Options
+	{
+		std::vector<Size> sizes = { Size(32, 32), Size(320, 240), Size(640, 480), Size(1280, 720), Size(1920, 1080) };
+		std::vector<int> threads;
+		std::string filter;
+		double min_time = 0.1;		//s per measurement
+		int samples = 5;
+		std::string json_file;
+		std::string baseline_file;
+		double tolerance = 0.1;
+		bool accuracy = false;
+	};
+
+	void addCNNPPKernels(std::vector<Kernel>& kernels)
+	{
+		const std::string group = "CNNPP";
+
+		auto conv = [&](const char* name, int kh, int kw, void (SIMD::CNNPP::*func)(float*, int, float*, int, int, float*, size_t, size_t))
+		{
+			kernels.push_back({ group, name, 2. * kh * kw, 8., false, [=](Context& ctx)
+			{
+				(ctx.cnnpp.*func)(ctx.dst.data, ctx.dst.widthStep, ctx.src.data, ctx.src.widthStep, ctx.size.height, ctx.weights(),
+					ctx.size.width - (kw - 1), ctx.size.height - (kh - 1));
+			} });
+		};
+
+		conv("conv_3x3", 3, 3, &SIMD::CNNPP::conv_3x3);
+		conv("conv_4x4", 4, 4, &SIMD::CNNPP::conv_4x4);
+		conv("conv_6x5", 6, 5, &SIMD::CNNPP::conv_6x5);
+		conv("conv_8x7", 8, 7, &SIMD::CNNPP::conv_8x7);
+#ifndef USE_SSE
+		conv("conv_5x4", 5, 4, &SIMD::CNNPP::conv_5x4);
+		conv("conv_5x5", 5, 5, &SIMD::CNNPP::conv_5x5);
+		conv("conv_6x6", 6, 6, &SIMD::CNNPP::conv_6x6);
+		conv("conv_7x7", 7, 7, &SIMD::CNNPP::conv_7x7);
+		conv("conv_8x8", 8, 8, &SIMD::CNNPP::conv_8x8);
+		conv("conv_11x10", 11, 10, &SIMD::CNNPP::conv_11x10);
+		conv("conv_11x11", 11, 11, &SIMD::CNNPP::conv_11x11);
+		//nominal flops of direct 3x3 conv
+		conv("conv_3x3_wino", 3, 3, &SIMD::CNNPP::conv_3x3_wino);
+#endif
+
+		//activation + 2x2 pooling, 4 bytes read and 1 byte written per input pixel
+		auto pool = [&](const char* name, void (SIMD::CNNPP::*func)(float*, int, float*, int, int, float*, float*, float*, float*))
+		{
+			kernels.push_back({ group, name, 0., 5., false, [=](Context& ctx)
+			{
+				float** w = ctx.weight_ptr.data();
+				(ctx.cnnpp.*func)(ctx.dst.data, ctx.dst.widthStep, ctx.src.data, ctx.src.widthStep, ctx.size.height & ~1, w[0], w[1], w[2], &ctx.scale);
+			} });
+		};
+
+		pool("tanh_avr_tanh", &SIMD::CNNPP::tanh_avr_tanh);
+		pool("max_tanh_tanh", &SIMD::CNNPP::max_tanh_tanh);
+#ifndef USE_SSE
+		pool("max_tanh_bn", &SIMD::CNNPP::max_tanh_bn);
+
+		kernels.push_back({ group, "lrelu_bn_max", 0., 5., false, [](Context& ctx)
+		{
+			float** w = ctx.weight_ptr.data();
+			ctx.cnnpp.lrelu_bn_max(ctx.dst.data, ctx.dst.widthStep, ctx.src.data, ctx.src.widthStep, ctx.size.height & ~1, w[0], w[1], w[2], w[3], w[4]);
+		} });
+		kernels.push_back({ group, "conv_3x3_lrelu_bn_max_wino", 2. * 9., 4. + 1., false, [](Context& ctx)
+		{
+			float** w = ctx.weight_ptr.data();
+			ctx.cnnpp.conv_3x3_lrelu_bn_max_wino(ctx.dst.data, ctx.dst.widthStep, ctx.src.data, ctx.src.widthStep, ctx.size.height, w[0],
+				w[1], w[2], w[3], w[4], w[5], ctx.size.width - 2, ctx.size.height - 2);
+		} });
+		kernels.push_back({ group, "lrelu_bn", 0., 8., false, [](Context& ctx)
+		{
+			float** w = ctx.weight_ptr.data();
+			ctx.cnnpp.lrelu_bn(ctx.dst.data, ctx.src.data, ctx.size_, w[0], w[1], w[2], w[3], w[4]);
+		} });
+		kernels.push_back({ group, "tanhW", 0., 8., false, [](Context& ctx)
+		{
+			float** w = ctx.weight_ptr.data();
+			ctx.cnnpp.tanhW(ctx.dst.data, ctx.src.data, ctx.size_, w[0], w[1], &ctx.scale);
+		} });
+		kernels.push_back({ group, "mulCN_add_tanhW", 2., 4. + 4. / 24., false, [](Context& ctx)
+		{
+			float** w = ctx.weight_ptr.data();
+			ctx.cnnpp.mulCN_add_tanhW(24, ctx.dst.data, ctx.src_ptr.data(), ctx.plane_size, w[0], w[1], w[2], w[3], w[4]);
+		} });
+		//im2col layer 1 of check networks: 6 maps, 4x4 kernels, 16 panel rows of 1 / 24 of the image
+		kernels.push_back({ group, "gemm_6x16", 2. * 6. * 16. / 24., (16. + 6.) * 4. / 24., false, [](Context& ctx)
+		{
+			ctx.cnnpp.gemm(ctx.dst.data, ctx.plane_size, ctx.src.data, ctx.plane_size, ctx.weights(), 6, 16, ctx.plane_size);
+		} });
+#endif
+
+		//element-wise kernels over the whole image
+		kernels.push_back({ group, "tanh_tanh_2tanh", 0., 8., false, [](Context& ctx)
+		{
+			float** w = ctx.weight_ptr.data();
+			ctx.cnnpp.tanh_tanh_2tanh(ctx.dst.data, ctx.src.data, ctx.size_, w[0], w[1], w[2], &ctx.scale, w[3], w[4], w[5], w[6], w[7], w[8]);
+		} });
+#if !defined(USE_SSE) && !defined(USE_AVX)
+		kernels.push_back({ group, "tanh_bn_2tanh", 0., 8., false, [](Context& ctx)
+		{
+			float** w = ctx.weight_ptr.data();
+			ctx.cnnpp.tanh_bn_2tanh(ctx.dst.data, ctx.src.data, ctx.size_, w[0], w[1], w[2], &ctx.scale, w[3], w[4], w[5], w[6], w[7], w[8]);
+		} });
+#endif
+		kernels.push_back({ group, "tanh_tanh", 0., 8., false, [](Context& ctx)
+		{
+			float** w = ctx.weight_ptr.data();
+			ctx.cnnpp.tanh_tanh(ctx.dst.data, ctx.src.data, ctx.size_, w[0], w[1], w[2], &ctx.scale);
+		} });
+		kernels.push_back({ group, "tanh", 0., 8., false, [](Context& ctx)
+		{
+			ctx.cnnpp.tanh(ctx.dst.data, ctx.src.data, ctx.size_, ctx.weight_ptr[0], &ctx.scale);
+		} });
+		kernels.push_back({ group, "add", 1., 12., false, [](Context& ctx)
+		{
+			ctx.cnnpp.add(ctx.dst.data, ctx.src.data, ctx.src2.data, ctx.size_);
+		} });
+		kernels.push_back({ group, "add2", 2., 16., false, [](Context& ctx)
+		{
+			ctx.cnnpp.add2(ctx.dst.data, ctx.src.data, ctx.src2.data, ctx.src3.data, ctx.size_);
+		} });
+		kernels.push_back({ group, "mulC", 1., 8., false, [](Context& ctx)
+		{
+			ctx.cnnpp.mulC(ctx.dst.data, ctx.src.data, ctx.size_, ctx.weight_ptr[0]);
+		} });
+		kernels.push_back({ group, "mulC1_add", 2., 12., false, [](Context& ctx)
+		{
+			ctx.cnnpp.mulC1_add(ctx.dst.data, ctx.src.data, ctx.src2.data, ctx.size_, ctx.weight_ptr[0]);
+		} });
+		kernels.push_back({ group, "mulC2_add", 3., 12., false, [](Context& ctx)
+		{
+			ctx.cnnpp.mulC2_add(ctx.dst.data, ctx.src.data, ctx.src2.data, ctx.size_, ctx.weight_ptr[0], ctx.weight_ptr[1]);
+		} });
+		kernels.push_back({ group, "mulC24_add_tanh", 2., 4. + 4. / 24., false, [](Context& ctx)
+		{
+			float** w = ctx.weight_ptr.data();
+			ctx.cnnpp.mulC24_add_tanh(ctx.dst.data, ctx.src_ptr.data(), ctx.plane_size, w[0], w[1], &ctx.scale, w[2]);
+		} });
+	}
+
+#ifdef USE_AVX
+	//stage 1 layers of ConvNeuralNetwork_v2, flops and bytes per input image pixel
+	template <typename CNNPP_type>
+	void addStage1Kernels(std::vector<Kernel>& kernels, const std::string& group, CNNPP_type Context::*cnnpp)
+	{
+		kernels.push_back({ group, "conv_4x4_lrelu_bn_max", 2. * 16. * 4., 4. + 4., true, [=](Context& ctx)
+		{
+			float** w = ctx.weight_ptr.data();
+			(ctx.*cnnpp).conv_4x4_lrelu_bn_max(ctx.lb[0](), ctx.lb_size[0].cols, ctx.src.data, ctx.src.widthStep, ctx.size.height,
+				w[0], w[1], w[2], w[3], w[4], w[5], ctx.l1_roi.cols, ctx.l1_roi.rows, 1);
+		} });
+		kernels.push_back({ group, "conv_3x3_lrelu_bn_max", 2. * 9. * 8. / 4., 4. + 2., true, [=](Context& ctx)
+		{
+			float** w = ctx.weight_ptr.data();
+			(ctx.*cnnpp).conv_3x3_lrelu_bn_max(ctx.lb[1](), ctx.lb_size[1].cols, ctx.lb[0](), ctx.lb_size[0].cols, ctx.lb_size[0].rows,
+				w[0], w[1], w[2], w[3], w[4], w[5], ctx.l2_roi.cols, ctx.l2_roi.rows, 1);
+		} });
+		kernels.push_back({ group, "conv_5x4_lrelu_bn", 2. * 20. * 16. / 16., 2. + 4., true, [=](Context& ctx)
+		{
+			float** w = ctx.weight_ptr.data();
+			(ctx.*cnnpp).conv_5x4_lrelu_bn(ctx.lb[2](), ctx.lb_size[2].cols, ctx.lb[1](), ctx.lb_size[1].cols, ctx.lb_size[1].rows,
+				w[0], w[1], w[2], w[3], w[4], w[5], ctx.l3_roi.cols, ctx.l3_roi.rows, 1);
+		} });
+		kernels.push_back({ group, "mulCN_add_tanhW_add", 0., 4. + 4. / 16., true, [=](Context& ctx)
+		{
+			float** w = ctx.weight_ptr.data();
+			(ctx.*cnnpp).mulCN_add_tanhW_add(ctx.lb[2](), ctx.lb_size[2].cols, ctx.lb[2](), ctx.lb_size[2].cols, ctx.lb_size[2].rows,
+				w, w + 16, w[32], w[33], w[34], w + 40, ctx.l3_roi.cols, ctx.l3_roi.rows, 1);
+		} });
+		kernels.push_back({ group, "tanhW", 0., 8. / 16., true, [=](Context& ctx)
+		{
+			float** w = ctx.weight_ptr.data();
+			(ctx.*cnnpp).tanhW(ctx.lb[2](), ctx.lb_size[2].cols, ctx.lb[2](), ctx.lb_size[2].cols, ctx.lb_size[2].rows,
+				w[0], w[1], &ctx.scale, ctx.l3_roi.cols, ctx.l3_roi.rows, 1);
+		} });
+	}
+#endif
+
+#ifdef USE_AVX
+	//single map kernels of CNNPP_v2 used by legacy models
+	void addCNNPPv2Kernels(std::vector<Kernel>& kernels)
+	{
+		const std::string group = "CNNPP_v2";
+
+		kernels.push_back({ group, "conv_4x4", 2. * 16. * 4., 4. + 16., false, [](Context& ctx)
+		{
+			ctx.cnnpp_v2.conv_4x4(ctx.wide(), 4 * ctx.src.widthStep, ctx.src.data, ctx.src.widthStep, ctx.size.height, ctx.weights(),
+				ctx.size.width - 3, ctx.size.height - 3, 1);
+		} });
+		kernels.push_back({ group, "conv_3x3_lrelu_bn_max_wino", 2. * 9. * 8. / 4., 4. + 2., true, [](Context& ctx)
+		{
+			float** w = ctx.weight_ptr.data();
+			ctx.cnnpp_v2.conv_3x3_lrelu_bn_max_wino(ctx.lb[1](), ctx.lb_size[1].cols, ctx.lb[0](), ctx.lb_size[0].cols, ctx.lb_size[0].rows,
+				w[0], w[1], w[2], w[3], w[4], w[5], ctx.l2_roi.cols, ctx.l2_roi.rows, 1);
+		} });
+		kernels.push_back({ group, "max_tanh_tanh", 0., 5., false, [](Context& ctx)
+		{
+			float** w = ctx.weight_ptr.data();
+			ctx.cnnpp_v2.max_tanh_tanh(ctx.dst.data, ctx.dst.widthStep, ctx.src.data, ctx.src.widthStep, ctx.size.height & ~1, w[0], w[1], w[2], &ctx.scale, 1);
+		} });
+		kernels.push_back({ group, "tanh_tanh_2tanh", 0., 4. + 2., false, [](Context& ctx)
+		{
+			float** w = ctx.weight_ptr.data();
+			ctx.cnnpp_v2.tanh_tanh_2tanh(ctx.dst.data, ctx.dst.widthStep, ctx.src.data, ctx.src.widthStep, ctx.size.height,
+				w[0], w[1], w[2], &ctx.scale, w[3], w[4], w[5], w[6], w[7], w[8], 1);
+		} });
+		kernels.push_back({ group, "tanh", 0., 4. + 2., false, [](Context& ctx)
+		{
+			ctx.cnnpp_v2.tanh(ctx.dst.data, ctx.dst.widthStep, ctx.src.data, ctx.src.widthStep, ctx.size.height, ctx.weight_ptr[0], &ctx.scale, 1);
+		} });
+	}
+#endif
+
+	//activation functions of SIMD::Activation for every vector type of the build
+	struct ActivationISA
+	{
+		std::string name;
+		void (*transform)(SIMD::Activation::Function, SIMD::Activation::Tier, float*, const float*, size_t);
+	};
+
+	std::vector<ActivationISA> activationISAs()
+	{
+		std::vector<ActivationISA> isa;
+		isa.push_back({ "scalar", &SIMD::Activation::transform<float> });
+#if defined(USE_SSE) || defined(USE_AVX)
+		isa.push_back({ "sse", &SIMD::Activation::transform<__m128> });
+#endif
+#ifdef USE_AVX
+#	ifdef USE_AVX2
+		isa.push_back({ "avx2", &SIMD::Activation::transform<__m256> });
+#	else
+		isa.push_back({ "avx", &SIMD::Activation::transform<__m256> });
+#	endif
+#endif
+#if defined(USE_FIXED_POINT) && defined(USE_AVX512)
+		if (SIMD::CNNPP_v4::isSupported()) isa.push_back({ "avx512", &SIMD::Activation::transform_avx512 });
+#endif
+		return isa;
+	}
+
+	const char* const tier_names[] = { "fast", "rational", "poly", "table" };
+
+	void addActivationKernels(std::vector<Kernel>& kernels)
+	{
+		const std::string group = "Activation";
+		const std::vector<ActivationISA> isa = activationISAs();
+
+		for (auto it = isa.begin(); it != isa.end(); ++it)
+		{
+			auto transform = it->transform;
+			for (int tier = 0; tier < 4; ++tier)
+			{
+				const SIMD::Activation::Tier t = SIMD::Activation::Tier(tier);
+				kernels.push_back({ group, std::string("tanh_") + tier_names[tier] + "_" + it->name, 0., 8., false, [=](Context& ctx)
+				{
+					transform(SIMD::Activation::tanh_func, t, ctx.dst.data, ctx.src2.data, ctx.size_);
+				} });
+				kernels.push_back({ group, std::string("sigmoid_") + tier_names[tier] + "_" + it->name, 0., 8., false, [=](Context& ctx)
+				{
+					transform(SIMD::Activation::sigmoid_func, t, ctx.dst.data, ctx.src2.data, ctx.size_);
+				} });
+			}
+			kernels.push_back({ group, "lrelu_" + it->name, 3., 8., false, [=](Context& ctx)
+			{
+				transform(SIMD::Activation::lrelu_func, SIMD::Activation::fast_tier, ctx.dst.data, ctx.src2.data, ctx.size_);
+			} });
+		}
+	}
+
+	//max error in units in the last place and max abs error against double precision on +-[2^-12, 16]
+	void printActivationAccuracy()
+	{
+		const uint_ first = 0x39800000;		//2^-12
+		const uint_ last = 0x41800000;		//16
+		const uint_ stride = 61;
+		const size_t block = 4096;
+
+		std::vector<float> x;
+		for (uint_ bits = first; bits <= last; bits += stride)
+		{
+			float v;
+			memcpy(&v, &bits, sizeof(v));
+			x.push_back(v);
+			x.push_back(-v);
+		}
+		x.resize(roundUpMul((int)x.size(), (int)block), 1.f);
+
+		SIMD::Array_32f src((int)block, ALIGN_DEF);
+		SIMD::Array_32f dst((int)block, ALIGN_DEF);
+
+		printf("%-10s %-10s %-8s %14s %14s\n", "function", "tier", "isa", "max_ulp", "max_abs_err");
+
+		const std::vector<ActivationISA> isa = activationISAs();
+		const SIMD::Activation::Function funcs[] = { SIMD::Activation::tanh_func, SIMD::Activation::sigmoid_func };
+		const char* const func_names[] = { "tanh", "sigmoid" };
+		for (int f = 0; f < 2; ++f)
+		{
+			for (int tier = 0; tier < 4; ++tier)
+			{
+				for (auto it = isa.begin(); it != isa.end(); ++it)
+				{
+					double max_ulp = 0.;
+					double max_abs = 0.;
+					for (size_t i = 0; i < x.size(); i += block)
+					{
+						memcpy(src(), x.data() + i, block * sizeof(float));
+						it->transform(funcs[f], SIMD::Activation::Tier(tier), dst(), src(), block);
+
+						for (size_t k = 0; k < block; ++k)
+						{
+							const double v = src[(int)k];
+							const double ref = f == 0 ? std::tanh(v) : 1. / (1. + std::exp(-v));
+							const double err = fabs(double(dst[(int)k]) - ref);
+							const double ulp = ldexp(1., ilogbf(float(ref)) - 23);
+							max_abs = MAX(max_abs, err);
+							max_ulp = MAX(max_ulp, err / ulp);
+						}
+					}
+					printf("%-10s %-10s %-8s %14.1f %14.3e\n", func_names[f], tier_names[tier], it->name.c_str(), max_ulp, max_abs);
+				}
+			}
+		}
+		printf("\n");
+	}
+
+	void addImageKernels(std::vector<Kernel>& kernels)
+	{
+		//same layout as CNNDetector filter kernels
+		ALIGN(ALIGN_DEF) static const float blur_kernel[8] = { 0.25f, 0.5f, 0.25f, 0.f, 0.25f, 0.5f, 0.25f, 0.f };
+
+		kernels.push_back({ "ImageConverter", "Img8uToImg32fGRAY_bgr", 0., 3. + 4., false, [](Context& ctx)
+		{
+			SIMD::ImageConverter::Img8uToImg32fGRAY(ctx.dst, ctx.src_8u);
+		} });
+		kernels.push_back({ "ImageConverter", "Img8uToImg32fGRAY_blur_bgr", 0., 3. + 4., false, [](Context& ctx)
+		{
+			SIMD::ImageConverter::Img8uToImg32fGRAY_blur(ctx.dst, ctx.src_8u, blur_kernel, blur_kernel);
+		} });
+
+		//pyramid step 1 / 1.25
+		kernels.push_back({ "ImageResizer", "FastImageResize_nn", 0., 4. * 0.64 * 2., false, [](Context& ctx)
+		{
+			ctx.resizer.FastImageResize(ctx.resize_dst, ctx.src, 0);
+		} });
+		kernels.push_back({ "ImageResizer", "FastImageResize_bilinear", 0., 4. + 4. * 0.64, false, [](Context& ctx)
+		{
+			ctx.resizer.FastImageResize(ctx.resize_dst, ctx.src, 1);
+		} });
+	}
+
+	//wall time of num_threads threads each calling kernel num_iter times, ns
+	double runConcurrent(const Kernel& kernel, std::vector<std::unique_ptr<Context>>& contexts, int num_threads, int num_iter)
+	{
+		std::atomic<int> ready(0);
+		std::atomic<bool> go(false);
+
+		std::vector<std::thread> workers;
+		for (int t = 1; t < num_threads; ++t)
+		{
+			workers.push_back(std::thread([&, t]
+			{
+				ready++;
+				while (!go.load()) std::this_thread::yield();
+				for (int i = 0; i < num_iter; ++i) kernel.run(*contexts[t]);
+			}));
+		}
+		while (ready.load() < num_threads - 1) std::this_thread::yield();
+
+		Timer timer(1, true);
+		go.store(true);
+		for (int i = 0; i < num_iter; ++i) kernel.run(*contexts[0]);
+		for (auto& worker : workers) worker.join();
+
+		return timer.get(1.e9);
+	}
+
+	void printUsage()
+	{
+		printf("KernelBenchmark [options]\n");
+		printf("	--sizes WxH,...       image sizes (default 32x32,320x240,640x480,1280x720,1920x1080)\n");
+		printf("	--threads N,...       thread counts for scaling (default 1,2,4,... up to hardware threads)\n");
+		printf("	--filter STR          run kernels whose group/name contains STR\n");
+		printf("	--min-time SEC        measuring time per kernel, size and thread count (default 0.1)\n");
+		printf("	--samples N           timed samples, median is reported (default 5)\n");
+		printf("	--json FILE           write results as json\n");
+		printf("	--baseline FILE       compare ns_per_pixel against saved json results\n");
+		printf("	--tolerance X         relative slowdown reported as regression (default 0.1)\n");
+		printf("	--accuracy 0|1        print max ulp and abs error of Activation functions before the benchmark (default 0)\n");
+	}
+
+	bool parseOptions(int argc, char** argv, Options& opt)
+	{
+		for (int i = 1; i < argc; ++i)
+		{
+			const std::string arg = argv[i];
+			if (arg == "--help" || arg == "-h") return false;
+			if (i + 1 >= argc)
+			{
+				printf("[KernelBenchmark] Missing value for %s!\n", arg.c_str());
+				return false;
+			}
+
+			const std::string val = argv[++i];
+			if (arg == "--sizes") opt.sizes = parseSizes(val);
+			else if (arg == "--threads") opt.threads = parseList(val);
+			else if (arg == "--filter") opt.filter = val;
+			else if (arg == "--min-time") opt.min_time = atof(val.c_str());
+			else if (arg == "--samples") opt.samples = MAX(1, atoi(val.c_str()));
+			else if (arg == "--json") opt.json_file = val;
+			else if (arg == "--baseline") opt.baseline_file = val;
+			else if (arg == "--tolerance") opt.tolerance = atof(val.c_str());
+			else if (arg == "--accuracy") opt.accuracy = atoi(val.c_str()) != 0;
+			else
+			{
+				printf("[KernelBenchmark] Unknown option %s!\n", arg.c_str());
+				return false;
+			}
+		}
+
+		if (opt.threads.empty())
+		{
+			const int hw_threads = MAX(1, (int)std::thread::hardware_concurrency());
+			for (int t = 1; t < hw_threads; t *= 2) opt.threads.push_back(t);
+			opt.threads.push_back(hw_threads);
+		}
+
+		return !opt.sizes.empty();
+	}
+}
+
+int main(int argc, char** argv)
+{
+	Options opt;
+	if (!parseOptions(argc, argv, opt))
+	{
+		printUsage();
+		return -1;
+	}
+
+	std::vector<Kernel> kernels;
+	addCNNPPKernels(kernels);
+#ifdef USE_AVX
+	addCNNPPv2Kernels(kernels);
+	addStage1Kernels(kernels, "CNNPP_v2", &Context::cnnpp_v2);
+#endif
+#ifdef USE_FIXED_POINT
+	addStage1Kernels(kernels, "CNNPP_v3", &Context::cnnpp_v3);
+#endif
+#if defined(USE_FIXED_POINT) && defined(USE_AVX512)
+	if (SIMD::CNNPP_v4::isSupported()) addStage1Kernels(kernels, "CNNPP_v4", &Context::cnnpp_v4);
+#endif
+	addActivationKernels(kernels);
+	addImageKernels(kernels);
+
+	const int max_threads = *std::max_element(opt.threads.begin(), opt.threads.end());
+
+	printf("kernel benchmark: %s, %d hardware threads\n\n", getSIMDName().c_str(), (int)std::thread::hardware_concurrency());
+	if (opt.accuracy) printActivationAccuracy();
+	printf("%-16s %-28s %-10s %4s %11s %9s %8s %9s %8s\n", "group", "kernel", "size", "thr", "time_us", "GFLOP/s", "GB/s", "ns/pixel", "scaling");
+
+	std::vector<Record> records;
+	for (auto size = opt.sizes.begin(); size != opt.sizes.end(); ++size)
+	{
+		std::vector<std::unique_ptr<Context>> contexts;
+		for (int t = 0; t < max_threads; ++t)
+		{
+			contexts.push_back(std::unique_ptr<Context>(new Context(*size, 17 + t)));
+		}
+
+		const double pixels = double(size->width) * double(size->height);
+		for (auto kernel = kernels.begin(); kernel != kernels.end(); ++kernel)
+		{
+			if (!opt.filter.empty() && (kernel->group + "/" + kernel->name).find(opt.filter) == std::string::npos) continue;
+			if (kernel->stage1_size && (size->width < 64 || size->height < 64)) continue;
+
+			//calibrate iterations on single thread
+			kernel->run(*contexts[0]);
+			Timer timer(1, true);
+			kernel->run(*contexts[0]);
+			const double call_time = MAX(timer.get(1.), 1.e-7);
+			const int num_iter = MAX(1, int(opt.min_time / (opt.samples * call_time)));
+
+			double ns_per_pixel_1 = 0.;
+			for (auto t = opt.threads.begin(); t != opt.threads.end(); ++t)
+			{
+				const int num_threads = MAX(1, *t);
+
+				std::vector<double> samples;
+				for (int s = 0; s < opt.samples; ++s)
+				{
+					samples.push_back(runConcurrent(*kernel, contexts, num_threads, num_iter));
+				}
+
+				//aggregate throughput of all threads
+				const double time_ns = percentile(samples, 0.5) / num_iter;
+				const double ns_per_pixel = time_ns / (pixels * num_threads);
+				if (t == opt.threads.begin()) ns_per_pixel_1 = ns_per_pixel * num_threads;
+
+				const double gflops = kernel->flops_per_pixel / ns_per_pixel;
+				const double gbps = kernel->bytes_per_pixel / ns_per_pixel;
+				const double scaling = ns_per_pixel_1 / (ns_per_pixel * num_threads);
+
+				char gflops_str[32] = "-";
+				if (kernel->flops_per_pixel > 0.) snprintf(gflops_str, sizeof(gflops_str), "%.3f", gflops);
+
+				printf("%-16s %-28s %-10s %4d %11.2f %9s %8.2f %9.4f %8.2f\n", kernel->group.c_str(), kernel->name.c_str(), sizeToString(*size).c_str(),
+					num_threads, 1.e-3 * time_ns, gflops_str, gbps, ns_per_pixel, scaling);
+
+				Record record;
+				record.set("group", kernel->group)
+					.set("kernel", kernel->name)
+					.set("size", sizeToString(*size))
+					.set("threads", num_threads)
+					.set("time_us", 1.e-3 * time_ns)
+					.set("time_min_us", 1.e-3 * *std::min_element(samples.begin(), samples.end()) / num_iter)
+					.setNull("gflops")
+					.set("gbps", gbps)
+					.set("ns_per_pixel", ns_per_pixel)
+					.set("scaling", scaling);
+				if (kernel->flops_per_pixel > 0.) record.set("gflops", gflops);
+				else record.setNull("gflops");
+				records.push_back(record);
+			}
+		}
+	}
+
+	if (!opt.json_file.empty())
+	{
+		Record config;
+		config.set("simd", getSIMDName())
+			.set("hardware_threads", (int)std::thread::hardware_concurrency())
+			.set("samples", opt.samples)
+			.set("min_time", opt.min_time);
+
+		if (saveRecords(opt.json_file, "kernels", config, records) < 0) return -1;
+	}
+
+	if (!opt.baseline_file.empty())
+	{
+		std::vector<Record> baseline;
+		if (loadRecords(opt.baseline_file, baseline) < 0) return -1;
+
+		const int regressions = compareBaseline(records, baseline, { "group", "kernel", "size", "threads" }, "ns_per_pixel", true, opt.tolerance);
+		printf("\n%d regression(s)\n", regressions);
+		if (regressions > 0) return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,170 @@
+/*
+*	Copyright (c) 2018, Ilya Kalinovskiy
+*	All rights reserved.
+*
+*	This is an implementation of the algorithm described in the following paper:
+*		I.A. Kalinovskiy, V.G. Spitsyn,
+*		Compact Convolutional Neural Network Cascade for Face Detection,
+*		http://arxiv.org/abs/1508.01292.
+*
+*	Redistribution and use of this program as source code or in binary form, with or without modifications, are permitted provided that the following conditions are met:
+*		1. Redistributions may not be sold, nor may they be used in a commercial product or activity without prior permission from the copyright holder (contact him at kua_21@mail.ru).
+*		2. Redistributions may not be used for military purposes.
+*		3. Any published work which utilizes this program shall include the reference to the paper available at http://arxiv.org/abs/1508.01292
+*		4. Redistributions must retain the above copyright notice and the reference to the algorithm on which the implementation is based on, this list of conditions and the following disclaimer.
+*
+*	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+*	IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#include "cnn_models_converter.h"
+#include "timer.h"
+
+#include "benchmark_utils.h"
+
+#include <sstream>
+
+
+//================================================================================================================================================
+
+
+using namespace NeuralNetworksLib;
+using namespace NeuralNetworksLib::Benchmark;
+
+namespace
+{
+	struct Options
+	{
+		std::string models = "models/";
+		std::string output;
+		std::vector<std::string> images;
+		float scale_factor = 1.15f;
+		int num_threads = 1;
+		bool graph = false;
+	};
+
+	void printUsage()
+	{
+		printf("ModelQuantizer --output DIR --images FILE,... [options]     write int8 models of cnn4face1..3 (format 1.2)\n");
+		printf("	--models DIR          directory with float cnn4face1..3 models (default models/)\n");
+		printf("	--images FILE,...     binary ppm/pgm calibration images\n");
+		printf("	--scale-factor X      scale factor of calibration image pyramids (default 1.15)\n");
+		printf("	--threads N           number of threads (default 1)\n");
+		printf("	--graph 1             write float models as layer graph (format 2.0), images are not needed\n");
+	}
+
+	bool parseOptions(int argc, char** argv, Options& opt)
+	{
+		for (int i = 1; i < argc; ++i)
+		{
+			const std::string arg = argv[i];
+			if (arg == "--help" || arg == "-h") return false;
+			if (i + 1 >= argc)
+			{
+				printf("[ModelQuantizer] Missing value for %s!\n", arg.c_str());
+				return false;
+			}
+
+			const std::string val = argv[++i];
+			if (arg == "--models") opt.models = val;
+			else if (arg == "--output") opt.output = val;
+			else if (arg == "--images")
+			{
+				std::stringstream stream(val);
+				std::string item;
+				while (std::getline(stream, item, ',')) if (!item.empty()) opt.images.push_back(item);
+			}
+			else if (arg == "--scale-factor") opt.scale_factor = (float)atof(val.c_str());
+			else if (arg == "--threads") opt.num_threads = MAX(1, atoi(val.c_str()));
+			else if (arg == "--graph") opt.graph = atoi(val.c_str()) != 0;
+			else
+			{
+				printf("[ModelQuantizer] Unknown option %s!\n", arg.c_str());
+				return false;
+			}
+		}
+
+		if (!opt.models.empty() && opt.models.back() != '/' && opt.models.back() != '\\') opt.models += "/";
+		if (!opt.output.empty() && opt.output.back() != '/' && opt.output.back() != '\\') opt.output += "/";
+
+		return !opt.output.empty() && (opt.graph || !opt.images.empty()) && opt.scale_factor > 1.f;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	Options opt;
+	if (!parseOptions(argc, argv, opt))
+	{
+		printUsage();
+		return -1;
+	}
+
+#ifdef USE_CNTK_MODELS
+	//assignment of images moves data
+	std::vector<SIMD::Image_32f> images(opt.images.size());
+	for (size_t i = 0; i < opt.images.size(); ++i)
+	{
+		SIMD::Image_8u image;
+		if (loadPNM(opt.images[i], image) < 0) return -1;
+
+		images[i] = SIMD::Image_32f(image.width, image.height, ALIGN_DEF, true);
+		for (int y = 0; y < image.height; ++y)
+		{
+			const uchar_* src = image.data + y * image.widthStep;
+			float* dst = images[i].data + y * images[i].widthStep;
+			for (int x = 0; x < image.width; ++x)
+			{
+				dst[x] = 0.114f * src[3 * x + 0] + 0.587f * src[3 * x + 1] + 0.299f * src[3 * x + 2];
+			}
+		}
+	}
+
+	for (int stage = 1; stage <= 3; ++stage)
+	{
+		const std::string model_name = "cnn4face" + std::to_string(stage) + "_cntk.bin";
+
+		CNNModelsConverter cvtCNN;
+		cvtCNN.LoadBinaryModel(opt.models + model_name);
+		if (cvtCNN.isEmpty())
+		{
+			printf("[ModelQuantizer] Could not load %s!\n", (opt.models + model_name).c_str());
+			return -1;
+		}
+		if (cvtCNN.isQuantized())
+		{
+			printf("[ModelQuantizer] Model %s is already quantized!\n", (opt.models + model_name).c_str());
+			return -1;
+		}
+
+		if (opt.graph)
+		{
+			cvtCNN.SaveToGraphFile(opt.output + model_name);
+			printf("stage %d: %s (layer graph)\n", stage, (opt.output + model_name).c_str());
+			continue;
+		}
+
+		Timer timer(1, true);
+		cvtCNN.Calibrate(images, opt.scale_factor, opt.num_threads);
+		cvtCNN.Quantize();
+		if (!cvtCNN.isQuantized()) return -1;
+
+		cvtCNN.SaveToBinaryFile(opt.output + model_name);
+
+		printf("stage %d: %s (%7.1f ms)\n", stage, (opt.output + model_name).c_str(), timer.get(1000));
+		for (int layer = 0; layer < 3; ++layer)
+		{
+			float min_val = 0.f;
+			float max_val = 0.f;
+			cvtCNN.getCalibrationRange(layer, min_val, max_val);
+			printf("	conv layer %d input range [%9.4f, %9.4f]\n", layer + 1, min_val, max_val);
+		}
+	}
+
+	return 0;
+#else
+	printf("[ModelQuantizer] int8 models are supported for CNTK models only!\n");
+	return -1;
+#endif
+}
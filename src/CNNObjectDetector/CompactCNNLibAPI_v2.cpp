@@ -70,11 +70,16 @@ namespace CompactCNNLib
 		param.pipeline = static_cast<FaceDetector::Pipeline>(CNND_param.pipeline);
 		param.detect_mode = static_cast<FaceDetector::DetectMode>(CNND_ad_param.detect_mode);
 		param.num_threads = CNND_param.num_threads;
+		param.coarse_to_fine = CNND_ad_param.coarse_to_fine;
+		param.approx_pyramid = CNND_ad_param.approx_pyramid;
 
 		for (int i = 0; i < 3; ++i)
 		{
 			param.models[i] = CNND_ad_param.path_model[i].c_str();
 			param.index_output[i] = CNND_ad_param.index_output[i];
+			param.winograd_layers[i] = CNND_ad_param.winograd_layers[i];
+			param.template_layers[i] = CNND_ad_param.template_layers[i];
+			param.int8_models[i] = CNND_ad_param.int8_models[i];
 		}
 
 		param.device_info = CNND_ad_param.device_info;
@@ -109,6 +114,8 @@ namespace CompactCNNLib
 		CNND_param.pipeline = static_cast<CNNDetector::Pipeline>(param.pipeline);
 		CNND_ad_param.detect_mode = static_cast<CNNDetector::DetectMode>(param.detect_mode);
 		CNND_param.num_threads = param.num_threads;
+		CNND_ad_param.coarse_to_fine = param.coarse_to_fine;
+		CNND_ad_param.approx_pyramid = param.approx_pyramid;
 
 		for (int i = 0; i < 3; ++i)
 		{
@@ -117,6 +124,9 @@ namespace CompactCNNLib
 			else
 				CNND_ad_param.path_model[i] = "";
 			CNND_ad_param.index_output[i] = param.index_output[i];
+			CNND_ad_param.winograd_layers[i] = param.winograd_layers[i];
+			CNND_ad_param.template_layers[i] = param.template_layers[i];
+			CNND_ad_param.int8_models[i] = param.int8_models[i];
 		}
 
 		CNND_ad_param.device_info = param.device_info;
@@ -515,6 +525,42 @@ namespace CompactCNNLib
 		{
 			cvtCNN.SaveToBinaryFile(binary_file);
 		}
+#endif
+	}
+	int FaceDetector::QuantizeModel(const char* quantized_file, const char* model_file, ImageData* calibration_images, int count)
+	{
+#ifdef USE_CNTK_MODELS
+		if (calibration_images == nullptr || count <= 0) return -1;
+
+		CNNModelsConverter cvtCNN;
+		const std::string file_name(model_file);
+		if (file_name.find(".txt") != std::string::npos)
+		{
+			cvtCNN.LoadCNTKModel(file_name);
+		}
+		else
+		{
+			cvtCNN.LoadBinaryModel(file_name);
+		}
+		if (cvtCNN.isEmpty()) return -1;
+
+		std::vector<SIMD::Image_32f> images(count);
+		for (int i = 0; i < count; ++i)
+		{
+			ImageData& img = calibration_images[i];
+			SIMD::Image_8u image(img.cols, img.rows, img.channels, img.data, (int)img.step);
+			images[i] = SIMD::Image_32f(img.cols, img.rows, ALIGN_DEF, true);
+			if (SIMD::ImageConverter::Img8uToImg32fGRAY(images[i], image) < 0) return -1;
+		}
+
+		cvtCNN.Calibrate(images);
+		cvtCNN.Quantize();
+		if (!cvtCNN.isQuantized()) return -1;
+
+		cvtCNN.SaveToBinaryFile(quantized_file);
+		return 0;
+#else
+		return -1;
 #endif
 	}
 
@@ -128,6 +128,29 @@ namespace CompactCNNLib
 
 			int num_threads = 2;	//If you use asynchronous mode on the CPU then recommended 2 threads but in fact 4 threads will be used.
 
+			bool coarse_to_fine = false;
+			//CPU only. Stage 1 of the cascade is computed on every other scale of the pyramid first,
+			//the remaining scales are searched only around its responses. Faster at the cost of a slightly lower recall.
+
+			bool approx_pyramid = false;
+			//CPU only. The first layers of stage 1 are computed on one scale per octave of the pyramid,
+			//the features of the other scales are resampled from them. Faster at the cost of a lower recall.
+
+			int winograd_layers[3];
+			//CPU only. Bit l of winograd_layers[i] runs 3x3 conv layer l + 1 of stage i + 1 by Winograd F(2x2, 3x3)
+			//(2.25x less multiplications, results differ from direct convolution by float rounding only).
+			//Float CNTK models only, layer 2 of stage 1 is not affected in AVX2 builds (fixed point).
+
+			int template_layers[3];
+			//CPU only. Bit l of template_layers[i] runs conv layer l + 1 of stage i + 1 by conv + activation + max pool kernel
+			//generated for its kernel size and map count (results differ from direct kernels by float rounding only).
+			//Layers without direct kernels (retrained models of other shapes) always use them. Float CNTK models only,
+			//stage 1 of AVX builds is affected only if its topology differs from the shipped model.
+
+			bool int8_models[3];
+			//CPU of AVX2 builds only. int8_models[i] runs conv layers of stage i + 1 in int8 if models[i] is an int8 model (see QuantizeModel),
+			//otherwise the float weights of the int8 model are used, see README.
+
 			//Models
 			const char* models[3];	//Path to binary files of your CNN models.
 			int index_output[3];	//The output number of the CNN to be calculated	
@@ -157,6 +180,18 @@ namespace CompactCNNLib
 				index_output[0] = 1;
 				index_output[1] = 0;
 				index_output[2] = 0;
+
+				winograd_layers[0] = 0;
+				winograd_layers[1] = 0;
+				winograd_layers[2] = 0;
+
+				template_layers[0] = 0;
+				template_layers[1] = 0;
+				template_layers[2] = 0;
+
+				int8_models[0] = false;
+				int8_models[1] = false;
+				int8_models[2] = false;
 			}
 		};
 
@@ -187,6 +222,9 @@ namespace CompactCNNLib
 		int getGrayImage32F(ImageData* img, Pipeline pipeline);
 
 		static void CNTKDump2Binary(const char* binary_file, const char* cntk_model_dump);
+		//int8 model (CNTK models only): conv layers are calibrated on image pyramids of calibration images,
+		//model_file is binary model or CNTK dump (.txt), returns 0 on success
+		static int QuantizeModel(const char* quantized_file, const char* model_file, ImageData* calibration_images, int count);
 	};
 
 }
\ No newline at end of file
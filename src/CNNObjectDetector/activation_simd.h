@@ -0,0 +1,474 @@
+/*
+*	Copyright (c) 2018, Ilya Kalinovskiy
+*	All rights reserved.
+*
+*	This is an implementation of the algorithm described in the following paper:
+*		I.A. Kalinovskiy, V.G. Spitsyn,
+*		Compact Convolutional Neural Network Cascade for Face Detection,
+*		http://arxiv.org/abs/1508.01292.
+*
+*	Redistribution and use of this program as source code or in binary form, with or without modifications, are permitted provided that the following conditions are met:
+*		1. Redistributions may not be sold, nor may they be used in a commercial product or activity without prior permission from the copyright holder (contact him at kua_21@mail.ru).
+*		2. Redistributions may not be used for military purposes.
+*		3. Any published work which utilizes this program shall include the reference to the paper available at http://arxiv.org/abs/1508.01292
+*		4. Redistributions must retain the above copyright notice and the reference to the algorithm on which the implementation is based on, this list of conditions and the following disclaimer.
+*
+*	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+*	IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#pragma once
+
+#include "config.h"
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+
+#if defined(USE_SSE) || defined(USE_AVX)
+#	include <immintrin.h>
+#endif
+
+//alignment attributes of __m128/__m256 are dropped in template arguments, VecOps only uses them as tags
+#if defined(__GNUC__) && !defined(__clang__)
+#	pragma GCC diagnostic push
+#	pragma GCC diagnostic ignored "-Wignored-attributes"
+#endif
+
+
+//========================================================================================================
+
+
+namespace NeuralNetworksLib
+{
+	namespace SIMD
+	{
+		//activation functions of CNN kernels: tanh in several accuracy tiers, scaled tanh, sigmoid and leaky ReLU;
+		//functors are templates over the vector type (float, __m128, __m256, __m512) and are inlined into the kernels,
+		//the tier of tanh used by the kernels is tanh_tier (see below)
+		namespace Activation
+		{
+			template <typename V>
+			struct VecOps;
+
+			template <>
+			struct VecOps<float>
+			{
+				enum { size = 1 };
+				static inline float load(const float* p) { return *p; }
+				static inline void store(float* p, const float x) { *p = x; }
+				static inline float set1(const float x) { return x; }
+				static inline float add(const float a, const float b) { return a + b; }
+				static inline float sub(const float a, const float b) { return a - b; }
+				static inline float mul(const float a, const float b) { return a * b; }
+				static inline float div(const float a, const float b) { return a / b; }
+				static inline float fmadd(const float a, const float b, const float c) { return a * b + c; }
+				static inline float min(const float a, const float b) { return fminf(a, b); }
+				static inline float max(const float a, const float b) { return fmaxf(a, b); }
+				static inline float abs(const float x) { return fabsf(x); }
+				static inline float floor(const float x) { return floorf(x); }
+				static inline float rcp(const float x) { return 1.f / x; }
+				//y >= 0 gets the sign of x
+				static inline float or_sign(const float y, const float x) { return x < 0.f ? -y : y; }
+				static inline float select_lt(const float a, const float b, const float x, const float y) { return a < b ? x : y; }
+				//2^n for integer valued n
+				static inline float pow2i(const float n)
+				{
+					const int e = ((int)n + 127) << 23;
+					float r;
+					memcpy(&r, &e, sizeof(r));
+					return r;
+				}
+				//table[idx] for integer valued idx
+				static inline float gather(const float* table, const float idx) { return table[(int)idx]; }
+			};
+
+#if defined(USE_SSE) || defined(USE_AVX)
+			template <>
+			struct VecOps<__m128>
+			{
+				enum { size = 4 };
+				static inline __m128 load(const float* p) { return _mm_loadu_ps(p); }
+				static inline void store(float* p, const __m128 x) { _mm_storeu_ps(p, x); }
+				static inline __m128 set1(const float x) { return _mm_set1_ps(x); }
+				static inline __m128 add(const __m128 a, const __m128 b) { return _mm_add_ps(a, b); }
+				static inline __m128 sub(const __m128 a, const __m128 b) { return _mm_sub_ps(a, b); }
+				static inline __m128 mul(const __m128 a, const __m128 b) { return _mm_mul_ps(a, b); }
+				static inline __m128 div(const __m128 a, const __m128 b) { return _mm_div_ps(a, b); }
+				static inline __m128 fmadd(const __m128 a, const __m128 b, const __m128 c)
+				{
+#ifdef USE_FMA
+					return _mm_fmadd_ps(a, b, c);
+#else
+					return _mm_add_ps(c, _mm_mul_ps(a, b));
+#endif
+				}
+				static inline __m128 min(const __m128 a, const __m128 b) { return _mm_min_ps(a, b); }
+				static inline __m128 max(const __m128 a, const __m128 b) { return _mm_max_ps(a, b); }
+				static inline __m128 abs(const __m128 x) { return _mm_and_ps(_mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF)), x); }
+				static inline __m128 floor(const __m128 x) { return _mm_floor_ps(x); }
+				static inline __m128 rcp(const __m128 x)
+				{
+#ifdef USE_FAST_DIV
+					return _mm_rcp_ps(x);
+#else
+					return _mm_div_ps(_mm_set1_ps(1.f), x);
+#endif
+				}
+				static inline __m128 or_sign(const __m128 y, const __m128 x) { return _mm_or_ps(y, _mm_andnot_ps(_mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF)), x)); }
+				static inline __m128 select_lt(const __m128 a, const __m128 b, const __m128 x, const __m128 y) { return _mm_blendv_ps(y, x, _mm_cmplt_ps(a, b)); }
+				static inline __m128 pow2i(const __m128 n) { return _mm_castsi128_ps(_mm_slli_epi32(_mm_add_epi32(_mm_cvtps_epi32(n), _mm_set1_epi32(127)), 23)); }
+				static inline __m128 gather(const float* table, const __m128 idx)
+				{
+#ifdef USE_AVX2
+					return _mm_i32gather_ps(table, _mm_cvttps_epi32(idx), 4);
+#else
+					ALIGN(ALIGN_SSE) int i[4];
+					_mm_store_si128((__m128i*)i, _mm_cvttps_epi32(idx));
+					return _mm_setr_ps(table[i[0]], table[i[1]], table[i[2]], table[i[3]]);
+#endif
+				}
+			};
+#endif
+
+#ifdef USE_AVX
+			template <>
+			struct VecOps<__m256>
+			{
+				enum { size = 8 };
+				static inline __m256 load(const float* p) { return _mm256_loadu_ps(p); }
+				static inline void store(float* p, const __m256 x) { _mm256_storeu_ps(p, x); }
+				static inline __m256 set1(const float x) { return _mm256_set1_ps(x); }
+				static inline __m256 add(const __m256 a, const __m256 b) { return _mm256_add_ps(a, b); }
+				static inline __m256 sub(const __m256 a, const __m256 b) { return _mm256_sub_ps(a, b); }
+				static inline __m256 mul(const __m256 a, const __m256 b) { return _mm256_mul_ps(a, b); }
+				static inline __m256 div(const __m256 a, const __m256 b) { return _mm256_div_ps(a, b); }
+				static inline __m256 fmadd(const __m256 a, const __m256 b, const __m256 c)
+				{
+#ifdef USE_FMA
+					return _mm256_fmadd_ps(a, b, c);
+#else
+					return _mm256_add_ps(c, _mm256_mul_ps(a, b));
+#endif
+				}
+				static inline __m256 min(const __m256 a, const __m256 b) { return _mm256_min_ps(a, b); }
+				static inline __m256 max(const __m256 a, const __m256 b) { return _mm256_max_ps(a, b); }
+				static inline __m256 abs(const __m256 x) { return _mm256_and_ps(_mm256_castsi256_ps(_mm256_set1_epi32(0x7FFFFFFF)), x); }
+				static inline __m256 floor(const __m256 x) { return _mm256_floor_ps(x); }
+				static inline __m256 rcp(const __m256 x)
+				{
+#ifdef USE_FAST_DIV
+					return _mm256_rcp_ps(x);
+#else
+					return _mm256_div_ps(_mm256_set1_ps(1.f), x);
+#endif
+				}
+				static inline __m256 or_sign(const __m256 y, const __m256 x) { return _mm256_or_ps(y, _mm256_andnot_ps(_mm256_castsi256_ps(_mm256_set1_epi32(0x7FFFFFFF)), x)); }
+				static inline __m256 select_lt(const __m256 a, const __m256 b, const __m256 x, const __m256 y) { return _mm256_blendv_ps(y, x, _mm256_cmp_ps(a, b, _CMP_LT_OQ)); }
+				static inline __m256 pow2i(const __m256 n)
+				{
+#ifdef USE_AVX2
+					return _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_add_epi32(_mm256_cvtps_epi32(n), _mm256_set1_epi32(127)), 23));
+#else
+					//no 256 bit integer ops in AVX
+					const __m256i e = _mm256_cvtps_epi32(n);
+					const __m128i bias = _mm_set1_epi32(127);
+					const __m128i lo = _mm_slli_epi32(_mm_add_epi32(_mm256_castsi256_si128(e), bias), 23);
+					const __m128i hi = _mm_slli_epi32(_mm_add_epi32(_mm256_extractf128_si256(e, 1), bias), 23);
+					return _mm256_castsi256_ps(_mm256_insertf128_si256(_mm256_castsi128_si256(lo), hi, 1));
+#endif
+				}
+				static inline __m256 gather(const float* table, const __m256 idx)
+				{
+#ifdef USE_AVX2
+					return _mm256_i32gather_ps(table, _mm256_cvttps_epi32(idx), 4);
+#else
+					ALIGN(ALIGN_AVX) int i[8];
+					_mm256_store_si256((__m256i*)i, _mm256_cvttps_epi32(idx));
+					return _mm256_setr_ps(table[i[0]], table[i[1]], table[i[2]], table[i[3]], table[i[4]], table[i[5]], table[i[6]], table[i[7]]);
+#endif
+				}
+			};
+#endif
+
+#ifdef __AVX512F__
+			//only in translation units compiled with AVX-512 flags (cnnpp_simd_avx512_v4.cpp)
+			template <>
+			struct VecOps<__m512>
+			{
+				enum { size = 16 };
+				static inline __m512 load(const float* p) { return _mm512_loadu_ps(p); }
+				static inline void store(float* p, const __m512 x) { _mm512_storeu_ps(p, x); }
+				static inline __m512 set1(const float x) { return _mm512_set1_ps(x); }
+				static inline __m512 add(const __m512 a, const __m512 b) { return _mm512_add_ps(a, b); }
+				static inline __m512 sub(const __m512 a, const __m512 b) { return _mm512_sub_ps(a, b); }
+				static inline __m512 mul(const __m512 a, const __m512 b) { return _mm512_mul_ps(a, b); }
+				static inline __m512 div(const __m512 a, const __m512 b) { return _mm512_div_ps(a, b); }
+				static inline __m512 fmadd(const __m512 a, const __m512 b, const __m512 c) { return _mm512_fmadd_ps(a, b, c); }
+				static inline __m512 min(const __m512 a, const __m512 b) { return _mm512_min_ps(a, b); }
+				static inline __m512 max(const __m512 a, const __m512 b) { return _mm512_max_ps(a, b); }
+				static inline __m512 abs(const __m512 x) { return _mm512_and_ps(_mm512_castsi512_ps(_mm512_set1_epi32(0x7FFFFFFF)), x); }
+				static inline __m512 floor(const __m512 x) { return _mm512_roundscale_ps(x, _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC); }
+				//AVX2 reciprocal in each 256 bit half, _mm512_rcp14_ps is more accurate and would change results of AVX2 kernels
+				static inline __m512 rcp(const __m512 x)
+				{
+#ifdef USE_FAST_DIV
+					const __m256 lo = _mm256_rcp_ps(_mm512_castps512_ps256(x));
+					const __m256 hi = _mm256_rcp_ps(_mm512_extractf32x8_ps(x, 1));
+					return _mm512_insertf32x8(_mm512_castps256_ps512(lo), hi, 1);
+#else
+					return _mm512_div_ps(_mm512_set1_ps(1.f), x);
+#endif
+				}
+				static inline __m512 or_sign(const __m512 y, const __m512 x) { return _mm512_or_ps(y, _mm512_andnot_ps(_mm512_castsi512_ps(_mm512_set1_epi32(0x7FFFFFFF)), x)); }
+				static inline __m512 select_lt(const __m512 a, const __m512 b, const __m512 x, const __m512 y) { return _mm512_mask_blend_ps(_mm512_cmp_ps_mask(a, b, _CMP_LT_OQ), y, x); }
+				static inline __m512 pow2i(const __m512 n) { return _mm512_castsi512_ps(_mm512_slli_epi32(_mm512_add_epi32(_mm512_cvtps_epi32(n), _mm512_set1_epi32(127)), 23)); }
+				static inline __m512 gather(const float* table, const __m512 idx) { return _mm512_i32gather_ps(_mm512_cvttps_epi32(idx), table, 4); }
+			};
+#endif
+
+			//---------------------------------------------------------------------------
+
+			//1 - 1 / (1 + |x| + x^2 + a x^4) with the sign of x, the approximation of USE_FAST_TANH used by all kernels so far
+			struct TanhFast
+			{
+				template <typename V>
+				inline V operator()(const V x) const
+				{
+					typedef VecOps<V> O;
+					const V one = O::set1(1.f);
+					const V x2 = O::mul(x, x);
+					V d = O::add(O::add(one, O::abs(x)), x2);
+					d = O::fmadd(O::mul(x2, x2), O::set1(1.41645f), d);
+					return O::or_sign(O::sub(one, O::rcp(d)), x);
+				}
+			};
+
+			//order of operations of the C++ kernels
+			template <>
+			inline float TanhFast::operator()<float>(const float x) const
+			{
+				const float sgn = x < 0.f ? -1.f : 1.f;
+				return sgn * (1.f - 1.f / (1.f + fabsf(x) + x * x + 1.41645f * x * x * x * x));
+			}
+
+			//13/6 rational approximation on [-7.9, 7.9] (coefficients of Eigen), x for |x| < 4e-4
+			struct TanhRational
+			{
+				template <typename V>
+				inline V operator()(const V x) const
+				{
+					typedef VecOps<V> O;
+					const V a = O::abs(x);
+					const V c = O::min(a, O::set1(7.90531110763549805f));
+					const V c2 = O::mul(c, c);
+
+					V p = O::fmadd(c2, O::set1(-2.76076847742355e-16f), O::set1(2.00018790482477e-13f));
+					p = O::fmadd(c2, p, O::set1(-8.60467152213735e-11f));
+					p = O::fmadd(c2, p, O::set1(5.12229709037114e-08f));
+					p = O::fmadd(c2, p, O::set1(1.48572235717979e-05f));
+					p = O::fmadd(c2, p, O::set1(6.37261928875436e-04f));
+					p = O::fmadd(c2, p, O::set1(4.89352455891786e-03f));
+					p = O::mul(c, p);
+
+					V q = O::fmadd(c2, O::set1(1.19825839466702e-06f), O::set1(1.18534705686654e-04f));
+					q = O::fmadd(c2, q, O::set1(2.26843463243900e-03f));
+					q = O::fmadd(c2, q, O::set1(4.89352518554385e-03f));
+
+					const V y = O::select_lt(a, O::set1(0.0004f), a, O::div(p, q));
+					return O::or_sign(y, x);
+				}
+			};
+
+			//odd polynomial for |x| < 0.625, 1 - 2 / (exp(2|x|) + 1) with polynomial exp above (Cephes tanhf)
+			struct TanhPoly
+			{
+				template <typename V>
+				inline V operator()(const V x) const
+				{
+					typedef VecOps<V> O;
+					const V one = O::set1(1.f);
+					const V a = O::abs(x);
+
+					const V a2 = O::mul(a, a);
+					V p = O::fmadd(a2, O::set1(-5.70498872745e-3f), O::set1(2.06390887954e-2f));
+					p = O::fmadd(a2, p, O::set1(-5.37397155531e-2f));
+					p = O::fmadd(a2, p, O::set1(1.33314422036e-1f));
+					p = O::fmadd(a2, p, O::set1(-3.33332819422e-1f));
+					const V small = O::fmadd(O::mul(a2, p), a, a);
+
+					//exp(2|x|) = 2^n exp(r), |r| <= ln2 / 2, tanh(9) rounds to 1
+					const V c = O::min(a, O::set1(9.f));
+					const V e = O::add(c, c);
+					const V n = O::floor(O::fmadd(e, O::set1(1.44269504088896341f), O::set1(0.5f)));
+					V r = O::sub(e, O::mul(n, O::set1(0.693359375f)));
+					r = O::sub(r, O::mul(n, O::set1(-2.12194440e-4f)));
+
+					V q = O::fmadd(r, O::set1(1.9875691500e-4f), O::set1(1.3981999507e-3f));
+					q = O::fmadd(r, q, O::set1(8.3334519073e-3f));
+					q = O::fmadd(r, q, O::set1(4.1665795894e-2f));
+					q = O::fmadd(r, q, O::set1(1.6666665459e-1f));
+					q = O::fmadd(r, q, O::set1(5.0000001201e-1f));
+					q = O::add(O::fmadd(O::mul(r, r), q, r), one);
+					q = O::mul(q, O::pow2i(n));
+
+					const V large = O::sub(one, O::div(O::set1(2.f), O::add(q, one)));
+
+					return O::or_sign(O::select_lt(a, O::set1(0.625f), small, large), x);
+				}
+			};
+
+			//linear interpolation of 1024 intervals on [0, 8), 1 above
+			struct TanhTable
+			{
+				enum { size = 1024 };
+
+				const float* value;
+				const float* delta;
+
+				TanhTable()
+				{
+					static const Table table;
+					value = table.value;
+					delta = table.delta;
+				}
+
+				template <typename V>
+				inline V operator()(const V x) const
+				{
+					typedef VecOps<V> O;
+					const V a = O::abs(x);
+					const V t = O::min(O::mul(a, O::set1(float(size) / 8.f)), O::set1(float(size - 1)));
+					const V i = O::floor(t);
+					const V y = O::fmadd(O::sub(t, i), O::gather(delta, i), O::gather(value, i));
+					return O::or_sign(O::select_lt(a, O::set1(8.f), y, O::set1(1.f)), x);
+				}
+
+			private:
+				struct Table
+				{
+					ALIGN(ALIGN_AVX) float value[size];
+					ALIGN(ALIGN_AVX) float delta[size];
+
+					Table()
+					{
+						for (int i = 0; i < size; ++i)
+						{
+							const double y0 = std::tanh(8. * i / size);
+							const double y1 = std::tanh(8. * (i + 1) / size);
+							value[i] = float(y0);
+							delta[i] = float(y1 - y0);
+						}
+					}
+				};
+			};
+
+			//tanh of kernels, -DTANH_TIER=TanhRational etc. selects another tier
+#if defined(TANH_TIER)
+			typedef TANH_TIER tanh_tier;
+#elif defined(USE_FAST_TANH)
+			typedef TanhFast tanh_tier;
+#else
+			typedef TanhRational tanh_tier;
+#endif
+
+			//---------------------------------------------------------------------------
+
+			//s tanh(w x), LeCun's 1.7159 tanh(2x/3) by default
+			template <typename TanhT = tanh_tier>
+			struct ScaledTanh
+			{
+				TanhT tanh;
+				float w, s;
+
+				ScaledTanh(const float w = 2.f / 3.f, const float s = 1.7159f) : w(w), s(s) { }
+
+				template <typename V>
+				inline V operator()(const V x) const
+				{
+					typedef VecOps<V> O;
+					return O::mul(tanh(O::mul(x, O::set1(w))), O::set1(s));
+				}
+			};
+
+			//1 / (1 + exp(-x)) = 0.5 tanh(x/2) + 0.5
+			template <typename TanhT = tanh_tier>
+			struct Sigmoid
+			{
+				TanhT tanh;
+
+				template <typename V>
+				inline V operator()(const V x) const
+				{
+					typedef VecOps<V> O;
+					const V half = O::set1(0.5f);
+					return O::fmadd(tanh(O::mul(x, half)), half, half);
+				}
+			};
+
+			//w1 x + w2 max(x, 0)
+			struct LeakyReLU
+			{
+				float w1, w2;
+
+				LeakyReLU(const float w1 = 0.1f, const float w2 = 0.9f) : w1(w1), w2(w2) { }
+
+				template <typename V>
+				inline V operator()(const V x) const
+				{
+					typedef VecOps<V> O;
+					return O::fmadd(O::set1(w1), x, O::mul(O::set1(w2), O::max(x, O::set1(0.f))));
+				}
+			};
+
+			//---------------------------------------------------------------------------
+
+			enum Function { tanh_func, scaled_tanh_func, sigmoid_func, lrelu_func };
+			enum Tier { fast_tier, rational_tier, poly_tier, table_tier };
+
+			//dst[i] = f(src[i]), size is a multiple of vector size
+			template <typename V, typename F>
+			inline void transform(float* dst, const float* src, size_t size, const F& f)
+			{
+				for (size_t i = 0; i < size; i += VecOps<V>::size)
+				{
+					VecOps<V>::store(dst + i, f(VecOps<V>::load(src + i)));
+				}
+			}
+
+			template <typename V, typename TanhT>
+			inline void transform(Function func, float* dst, const float* src, size_t size)
+			{
+				switch (func)
+				{
+				case tanh_func: transform<V>(dst, src, size, TanhT()); break;
+				case scaled_tanh_func: transform<V>(dst, src, size, ScaledTanh<TanhT>()); break;
+				case sigmoid_func: transform<V>(dst, src, size, Sigmoid<TanhT>()); break;
+				case lrelu_func: transform<V>(dst, src, size, LeakyReLU()); break;
+				}
+			}
+
+			//runtime selection of function and tier (benchmarks)
+			template <typename V>
+			inline void transform(Function func, Tier tier, float* dst, const float* src, size_t size)
+			{
+				switch (tier)
+				{
+				case fast_tier: transform<V, TanhFast>(func, dst, src, size); break;
+				case rational_tier: transform<V, TanhRational>(func, dst, src, size); break;
+				case poly_tier: transform<V, TanhPoly>(func, dst, src, size); break;
+				case table_tier: transform<V, TanhTable>(func, dst, src, size); break;
+				}
+			}
+
+#if defined(USE_FIXED_POINT) && defined(USE_AVX512)
+			//transform<__m512>, compiled with AVX-512 flags in cnnpp_simd_avx512_v4.cpp, cpu support is checked by CNNPP_v4::isSupported()
+			void transform_avx512(Function func, Tier tier, float* dst, const float* src, size_t size);
+#endif
+		}
+	}
+}
+
+#if defined(__GNUC__) && !defined(__clang__)
+#	pragma GCC diagnostic pop
+#endif
@@ -37,17 +37,17 @@ namespace NeuralNetworksLib
 			std::stringstream data_bin;
 			if (file_name.size() < 255)
 			{
-				std::fstream data_bin;
-				data_bin.open(file_name.c_str(), std::fstream::binary | std::fstream::in);
+				std::fstream file_bin;
+				file_bin.open(file_name.c_str(), std::fstream::binary | std::fstream::in);
 
-				if (!data_bin.is_open())
+				if (!file_bin.is_open())
 				{
 					printf("[CL::CNN] Configuration file not found!\n");
 					return;
 				}
 
-				data_bin << data_bin.rdbuf();
-				data_bin.close();
+				data_bin << file_bin.rdbuf();
+				file_bin.close();
 			}
 			else
 			{
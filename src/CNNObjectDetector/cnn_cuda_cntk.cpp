@@ -40,17 +40,17 @@ namespace NeuralNetworksLib
 			std::stringstream data_bin;
 			if (file_name.size() < 255)
 			{
-				std::fstream data_bin;
-				data_bin.open(file_name.c_str(), std::fstream::binary | std::fstream::in);
+				std::fstream file_bin;
+				file_bin.open(file_name.c_str(), std::fstream::binary | std::fstream::in);
 
-				if (!data_bin.is_open())
+				if (!file_bin.is_open())
 				{
 					printf("[CUDA::CNN] Configuration file not found!\n");
 					return;
 				}
 
-				data_bin << data_bin.rdbuf();
-				data_bin.close();
+				data_bin << file_bin.rdbuf();
+				file_bin.close();
 			}
 			else
 			{
@@ -61,7 +61,8 @@ namespace NeuralNetworksLib
 			float format_version = 0.0f;
 			FB_READ(data_bin, format_version);
 
-			if (format_version < 1.0f || format_version > 1.1f)
+			//int8 section of format 1.2 is not used, the network stays float
+			if (format_version < 1.0f || format_version > 1.2f)
 			{
 				printf("[CUDA::CNN] Configuration file format is not supported!\n");
 				return;
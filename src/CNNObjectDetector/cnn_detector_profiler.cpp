@@ -0,0 +1,537 @@
+/*
+*	Copyright (c) 2018, Ilya Kalinovskiy
+*	All rights reserved.
+*
+*	This is an implementation of the algorithm described in the following paper:
+*		I.A. Kalinovskiy, V.G. Spitsyn,
+*		Compact Convolutional Neural Network Cascade for Face Detection,
+*		http://arxiv.org/abs/1508.01292.
+*
+*	Redistribution and use of this program as source code or in binary form, with or without modifications, are permitted provided that the following conditions are met:
+*		1. Redistributions may not be sold, nor may they be used in a commercial product or activity without prior permission from the copyright holder (contact him at kua_21@mail.ru).
+*		2. Redistributions may not be used for military purposes.
+*		3. Any published work which utilizes this program shall include the reference to the paper available at http://arxiv.org/abs/1508.01292
+*		4. Redistributions must retain the above copyright notice and the reference to the algorithm on which the implementation is based on, this list of conditions and the following disclaimer.
+*
+*	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+*	IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#include "cnn_detector_profiler.h"
+
+#include <sstream>
+#include <fstream>
+#include <cstdio>
+#include <cstring>
+
+#ifdef __linux__
+#	include <linux/perf_event.h>
+#	include <sys/syscall.h>
+#	include <unistd.h>
+#endif
+
+
+//========================================================================================================
+
+
+namespace NeuralNetworksLib
+{
+
+	static std::atomic<long long> profiler_uid(0);
+
+	DetectorProfiler::DetectorProfiler(bool _enabled) : 
+		enabled(_enabled), tracing(false), trace_frames(0), trace_frame_id(0), trace_frame(0), hardware_counters(false), hardware_events(0),
+		time_origin(std::chrono::steady_clock::now()), uid(profiler_uid++) { }
+
+	DetectorProfiler::ThreadData::~ThreadData()
+	{
+		if (hardware_state > 0)
+		{
+			closeHardwareCounters(hardware_fd, hardware_slot);
+		}
+	}
+
+	DetectorProfiler::ThreadData* DetectorProfiler::getThreadData()
+	{
+		struct Cache
+		{
+			long long uid = -1;
+			ThreadData* data = nullptr;
+		};
+		static thread_local Cache cache;
+
+		if (cache.uid == uid)
+		{
+			return cache.data;
+		}
+
+		std::lock_guard<std::mutex> lock(mutex);
+
+		std::unique_ptr<ThreadData>& data = thread_data[std::this_thread::get_id()];
+		if (!data)
+		{
+			data.reset(new ThreadData());
+			data->tid = (int)thread_data.size();
+		}
+
+		cache.uid = uid;
+		cache.data = data.get();
+
+		return cache.data;
+	}
+
+	void DetectorProfiler::setScales(const std::vector<float>& _scales)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		scales = _scales;
+	}
+	void DetectorProfiler::reset()
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		for (auto it = thread_data.begin(); it != thread_data.end(); ++it)
+		{
+			ThreadData* data = it->second.get();
+			for (int stage = 0; stage < num_stages; ++stage)
+			{
+				for (int scl = 0; scl <= max_scales; ++scl)
+				{
+					data->time[stage][scl].store(0, std::memory_order_relaxed);
+					data->calls[stage][scl].store(0, std::memory_order_relaxed);
+				}
+			}
+			for (int counter = 0; counter < num_counters; ++counter)
+			{
+				data->counter[counter].store(0, std::memory_order_relaxed);
+			}
+			for (int stage = 0; stage < num_stages; ++stage)
+			{
+				for (int event = 0; event < num_hardware_events; ++event)
+				{
+					data->hardware[stage][event].store(0, std::memory_order_relaxed);
+				}
+				data->hardware_calls[stage].store(0, std::memory_order_relaxed);
+				data->pixels[stage].store(0, std::memory_order_relaxed);
+			}
+		}
+	}
+
+	void DetectorProfiler::startTrace(int num_frames)
+	{
+		clearTrace();
+		trace_frames.store(MAX(0, num_frames));
+		trace_frame_id.store(0);
+	}
+	int DetectorProfiler::newFrame()
+	{
+		if (trace_frames.load(std::memory_order_relaxed) > 0)
+		{
+			trace_frames--;
+			return ++trace_frame_id;
+		}
+
+		return 0;
+	}
+	void DetectorProfiler::setFrame(int frame)
+	{
+		trace_frame.store(frame);
+		tracing.store(frame > 0);
+	}
+	void DetectorProfiler::clearTrace()
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		for (auto it = thread_data.begin(); it != thread_data.end(); ++it)
+		{
+			std::lock_guard<std::mutex> event_lock(it->second->event_mutex);
+			it->second->events.clear();
+		}
+	}
+	void DetectorProfiler::addSpan(Stage stage, int scl, std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end, int frame)
+	{
+		const long long duration = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+		if (isEnabled())
+		{
+			addTime(stage, scl, duration);
+		}
+
+		if (frame < 0 ? isTracing() : frame > 0)
+		{
+			Event event;
+			event.stage = (int)stage;
+			event.scl = scl;
+			event.frame = frame < 0 ? trace_frame.load(std::memory_order_relaxed) : frame;
+			event.start = std::chrono::duration_cast<std::chrono::nanoseconds>(start - time_origin).count();
+			event.duration = duration;
+
+			ThreadData* data = getThreadData();
+			std::lock_guard<std::mutex> lock(data->event_mutex);
+			data->events.push_back(event);
+		}
+	}
+	std::string DetectorProfiler::toTraceJSON() const
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+
+		std::stringstream json;
+		json << "{\n\t\"displayTimeUnit\": \"ms\",\n\t\"traceEvents\": [\n";
+
+		bool first = true;
+		for (auto it = thread_data.begin(); it != thread_data.end(); ++it)
+		{
+			ThreadData* data = it->second.get();
+			json << (first ? "" : ",\n") << "\t\t{ \"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": " << data->tid
+				<< ", \"args\": { \"name\": \"detector thread " << data->tid << "\" } }";
+			first = false;
+
+			std::lock_guard<std::mutex> event_lock(data->event_mutex);
+			for (auto event = data->events.begin(); event != data->events.end(); ++event)
+			{
+				json << ",\n\t\t{ \"name\": \"" << getStageName((Stage)event->stage) << "\", \"cat\": \"detector\", \"ph\": \"X\", \"pid\": 1, \"tid\": " << data->tid
+					<< ", \"ts\": " << 1.e-3 * (double)event->start << ", \"dur\": " << 1.e-3 * (double)event->duration
+					<< ", \"args\": { \"frame\": " << event->frame;
+				if (event->scl >= 0)
+				{
+					json << ", \"scl\": " << event->scl;
+					if (event->scl < (int)scales.size())
+					{
+						json << ", \"scale\": " << scales[event->scl];
+					}
+				}
+				json << " } }";
+			}
+		}
+		json << "\n\t]\n}\n";
+
+		return json.str();
+	}
+	int DetectorProfiler::saveTrace(const std::string& file_name) const
+	{
+		std::ofstream file(file_name.c_str());
+		if (!file.is_open())
+		{
+			printf("[DetectorProfiler] Could not open file %s!\n", file_name.c_str());
+			return -1;
+		}
+
+		file << toTraceJSON();
+		file.close();
+
+		return 0;
+	}
+
+	int DetectorProfiler::openHardwareCounters(int fd[num_hardware_events], int slot[num_hardware_events], int& count)
+	{
+		for (int event = 0; event < num_hardware_events; ++event)
+		{
+			fd[event] = -1;
+			slot[event] = -1;
+		}
+		count = 0;
+
+		int mask = 0;
+
+#ifdef __linux__
+		//task clock is software event and leads group, so that group can be opened without PMU (e.g. virtual machines)
+		static const unsigned int type[num_hardware_events] = { PERF_TYPE_SOFTWARE, PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE };
+		static const unsigned long long config[num_hardware_events] = { PERF_COUNT_SW_TASK_CLOCK, PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+			PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES };
+
+		for (int event = 0; event < num_hardware_events; ++event)
+		{
+			perf_event_attr attr;
+			memset(&attr, 0, sizeof(attr));
+			attr.size = sizeof(attr);
+			attr.type = type[event];
+			attr.config = config[event];
+			attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+			attr.exclude_kernel = 1;
+			attr.exclude_hv = 1;
+
+			//calling thread on any cpu
+			const int event_fd = (int)syscall(__NR_perf_event_open, &attr, 0, -1, fd[task_clock], 0);
+			if (event_fd < 0)
+			{
+				if (event == task_clock) break;
+				continue;
+			}
+
+			fd[event] = event_fd;
+			slot[event] = count++;
+			mask |= 1 << event;
+		}
+#endif
+
+		return mask;
+	}
+	void DetectorProfiler::closeHardwareCounters(int fd[num_hardware_events], int slot[num_hardware_events])
+	{
+#ifdef __linux__
+		//members first, then group leader
+		for (int event = num_hardware_events - 1; event >= 0; --event)
+		{
+			if (slot[event] >= 0)
+			{
+				close(fd[event]);
+			}
+			fd[event] = -1;
+			slot[event] = -1;
+		}
+#endif
+	}
+	bool DetectorProfiler::setHardwareCounters(bool _enabled)
+	{
+		if (!_enabled)
+		{
+			hardware_counters.store(false);
+			return false;
+		}
+
+		//probe on calling thread, profiled threads open own groups on first span
+		int fd[num_hardware_events];
+		int slot[num_hardware_events];
+		int count = 0;
+		const int mask = openHardwareCounters(fd, slot, count);
+		closeHardwareCounters(fd, slot);
+
+		if (mask == 0)
+		{
+			printf("[DetectorProfiler] Hardware counters are not available!\n");
+			hardware_counters.store(false);
+			return false;
+		}
+
+		hardware_events.store(mask);
+		hardware_counters.store(true);
+
+		return true;
+	}
+	bool DetectorProfiler::readHardwareCounters(long long values[num_hardware_events])
+	{
+		ThreadData* data = getThreadData();
+		if (data->hardware_state == 0)
+		{
+			const int mask = openHardwareCounters(data->hardware_fd, data->hardware_slot, data->hardware_count);
+			data->hardware_state = mask != 0 ? 1 : -1;
+		}
+		if (data->hardware_state < 0)
+		{
+			return false;
+		}
+
+#ifdef __linux__
+		//nr, time_enabled, time_running, values
+		unsigned long long buffer[3 + num_hardware_events];
+		const ssize_t size = read(data->hardware_fd[task_clock], buffer, sizeof(buffer));
+		if (size < (ssize_t)((3 + data->hardware_count) * sizeof(unsigned long long)))
+		{
+			return false;
+		}
+
+		//extrapolate if group was multiplexed
+		const double scale = buffer[2] > 0 && buffer[2] < buffer[1] ? (double)buffer[1] / (double)buffer[2] : 1.;
+		for (int event = 0; event < num_hardware_events; ++event)
+		{
+			const int slot = data->hardware_slot[event];
+			values[event] = slot >= 0 ? (long long)(scale * (double)buffer[3 + slot]) : 0;
+		}
+
+		return true;
+#else
+		return false;
+#endif
+	}
+	void DetectorProfiler::addHardware(Stage stage, const long long start[num_hardware_events], const long long end[num_hardware_events], long long pixels)
+	{
+		ThreadData* data = getThreadData();
+		for (int event = 0; event < num_hardware_events; ++event)
+		{
+			std::atomic<long long>& value = data->hardware[stage][event];
+			value.store(value.load(std::memory_order_relaxed) + end[event] - start[event], std::memory_order_relaxed);
+		}
+		std::atomic<long long>& calls = data->hardware_calls[stage];
+		calls.store(calls.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+		std::atomic<long long>& pix = data->pixels[stage];
+		pix.store(pix.load(std::memory_order_relaxed) + pixels, std::memory_order_relaxed);
+	}
+
+	void DetectorProfiler::addTime(Stage stage, int scl, long long time_ns)
+	{
+		if (scl < 0 || scl >= max_scales)
+		{
+			scl = max_scales;
+		}
+
+		ThreadData* data = getThreadData();
+		std::atomic<long long>& time = data->time[stage][scl];
+		std::atomic<long long>& calls = data->calls[stage][scl];
+		time.store(time.load(std::memory_order_relaxed) + time_ns, std::memory_order_relaxed);
+		calls.store(calls.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+	}
+
+	DetectorProfiler::Report DetectorProfiler::getReport() const
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+
+		Report report;
+		report.scales = scales;
+		report.hardware_events = isHardwareCounters() ? hardware_events.load() : 0;
+
+		const int num_scales = MIN(max_scales, (int)scales.size());
+		for (int stage = 0; stage < num_stages; ++stage)
+		{
+			report.stage_scale[stage].resize(num_scales);
+		}
+		for (int counter = 0; counter < num_counters; ++counter)
+		{
+			report.counter[counter] = 0;
+		}
+
+		for (auto it = thread_data.begin(); it != thread_data.end(); ++it)
+		{
+			const ThreadData* data = it->second.get();
+			for (int stage = 0; stage < num_stages; ++stage)
+			{
+				for (int scl = 0; scl <= max_scales; ++scl)
+				{
+					const long long calls = data->calls[stage][scl].load(std::memory_order_relaxed);
+					const double time = 1.e-6 * (double)data->time[stage][scl].load(std::memory_order_relaxed);
+
+					report.stage[stage].calls += calls;
+					report.stage[stage].time += time;
+					if (scl < num_scales)
+					{
+						report.stage_scale[stage][scl].calls += calls;
+						report.stage_scale[stage][scl].time += time;
+					}
+				}
+			}
+			for (int counter = 0; counter < num_counters; ++counter)
+			{
+				report.counter[counter] += data->counter[counter].load(std::memory_order_relaxed);
+			}
+			for (int stage = 0; stage < num_stages; ++stage)
+			{
+				HardwareStat& stat = report.hardware[stage];
+				for (int event = 0; event < num_hardware_events; ++event)
+				{
+					stat.value[event] += data->hardware[stage][event].load(std::memory_order_relaxed);
+				}
+				stat.calls += data->hardware_calls[stage].load(std::memory_order_relaxed);
+				stat.pixels += data->pixels[stage].load(std::memory_order_relaxed);
+			}
+		}
+
+		return report;
+	}
+	std::string DetectorProfiler::toJSON() const
+	{
+		const Report report = getReport();
+
+		std::stringstream json;
+		json << "{\n";
+		json << "\t\"enabled\": " << (isEnabled() ? "true" : "false") << ",\n";
+		json << "\t\"counters\": {";
+		for (int counter = 0; counter < num_counters; ++counter)
+		{
+			json << (counter > 0 ? ", " : " ") << "\"" << getCounterName((Counter)counter) << "\": " << report.counter[counter];
+		}
+		json << " },\n";
+
+		//derived metrics: IPC, cycles per pixel and LLC miss traffic per pixel (64-byte lines)
+		auto value_or_null = [&json](bool available, double value)
+		{
+			if (available) json << value;
+			else json << "null";
+		};
+
+		json << "\t\"hardware\": { \"enabled\": " << (isHardwareCounters() ? "true" : "false") << ", \"events\": [";
+		for (int event = 0, count = 0; event < num_hardware_events; ++event)
+		{
+			if ((report.hardware_events & (1 << event)) == 0) continue;
+			json << (count++ > 0 ? ", " : " ") << "\"" << getHardwareEventName((HardwareEvent)event) << "\"";
+		}
+		json << " ], \"stages\": [";
+		for (int stage = 0, count = 0; stage < num_stages; ++stage)
+		{
+			const HardwareStat& stat = report.hardware[stage];
+			if (stat.calls == 0) continue;
+
+			const bool has_cycles = (report.hardware_events & (1 << cycles)) != 0;
+			const bool has_instructions = (report.hardware_events & (1 << instructions)) != 0;
+			const bool has_llc = (report.hardware_events & (1 << llc_misses)) != 0;
+			const bool has_pixels = stat.pixels > 0;
+
+			json << (count++ > 0 ? ",\n" : "\n") << "\t\t{ \"name\": \"" << getStageName((Stage)stage) << "\", \"calls\": " << stat.calls
+				<< ", \"task_clock_ms\": " << 1.e-6 * (double)stat.value[task_clock];
+			for (int event = cycles; event < num_hardware_events; ++event)
+			{
+				json << ", \"" << getHardwareEventName((HardwareEvent)event) << "\": ";
+				value_or_null((report.hardware_events & (1 << event)) != 0, (double)stat.value[event]);
+			}
+			json << ", \"ipc\": ";
+			value_or_null(has_cycles && has_instructions && stat.value[cycles] > 0, (double)stat.value[instructions] / (double)MAX(1ll, stat.value[cycles]));
+			json << ", \"pixels\": " << stat.pixels << ", \"cycles_per_pixel\": ";
+			value_or_null(has_cycles && has_pixels, (double)stat.value[cycles] / (double)MAX(1ll, stat.pixels));
+			json << ", \"bytes_per_pixel\": ";
+			value_or_null(has_llc && has_pixels, 64. * (double)stat.value[llc_misses] / (double)MAX(1ll, stat.pixels));
+			json << " }";
+		}
+		json << "\n\t] },\n";
+
+		json << "\t\"stages\": [\n";
+		for (int stage = 0; stage < num_stages; ++stage)
+		{
+			json << "\t\t{ \"name\": \"" << getStageName((Stage)stage) << "\", \"calls\": " << report.stage[stage].calls
+				<< ", \"time_ms\": " << report.stage[stage].time << ", \"scales\": [";
+
+			bool first = true;
+			for (int scl = 0; scl < (int)report.stage_scale[stage].size(); ++scl)
+			{
+				const StageStat& stat = report.stage_scale[stage][scl];
+				if (stat.calls == 0) continue;
+
+				json << (first ? " " : ", ") << "{ \"scl\": " << scl << ", \"scale\": " << report.scales[scl]
+					<< ", \"calls\": " << stat.calls << ", \"time_ms\": " << stat.time << " }";
+				first = false;
+			}
+			json << " ] }" << (stage + 1 < num_stages ? "," : "") << "\n";
+		}
+		json << "\t]\n";
+		json << "}\n";
+
+		return json.str();
+	}
+	int DetectorProfiler::saveJSON(const std::string& file_name) const
+	{
+		std::ofstream file(file_name.c_str());
+		if (!file.is_open())
+		{
+			printf("[DetectorProfiler] Could not open file %s!\n", file_name.c_str());
+			return -1;
+		}
+
+		file << toJSON();
+		file.close();
+
+		return 0;
+	}
+
+	const char* DetectorProfiler::getStageName(Stage stage)
+	{
+		static const char* names[num_stages] = { "gray", "resize", "stage1", "check", "patch", "stage2", "stage3", "merger", "detect", "transfer",
+			"stage1_l1", "stage1_l2", "stage1_l3" };
+		return names[stage];
+	}
+	const char* DetectorProfiler::getCounterName(Counter counter)
+	{
+		static const char* names[num_counters] = { "frames", "responses_stage1", "detections_stage1", "drop_stage1", "drop_check",
+			"call_stage2", "detections_stage2", "call_stage3", "detections_stage3", "detections_raw", "detections_result" };
+		return names[counter];
+	}
+	const char* DetectorProfiler::getHardwareEventName(HardwareEvent event)
+	{
+		static const char* names[num_hardware_events] = { "task_clock", "cycles", "instructions", "llc_misses", "branch_misses" };
+		return names[event];
+	}
+
+}
@@ -0,0 +1,260 @@
+/*
+*	Copyright (c) 2018, Ilya Kalinovskiy
+*	All rights reserved.
+*
+*	This is an implementation of the algorithm described in the following paper:
+*		I.A. Kalinovskiy, V.G. Spitsyn,
+*		Compact Convolutional Neural Network Cascade for Face Detection,
+*		http://arxiv.org/abs/1508.01292.
+*
+*	Redistribution and use of this program as source code or in binary form, with or without modifications, are permitted provided that the following conditions are met:
+*		1. Redistributions may not be sold, nor may they be used in a commercial product or activity without prior permission from the copyright holder (contact him at kua_21@mail.ru).
+*		2. Redistributions may not be used for military purposes.
+*		3. Any published work which utilizes this program shall include the reference to the paper available at http://arxiv.org/abs/1508.01292
+*		4. Redistributions must retain the above copyright notice and the reference to the algorithm on which the implementation is based on, this list of conditions and the following disclaimer.
+*
+*	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+*	IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#pragma once
+
+#include "config.h"
+#include "type.h"
+
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <chrono>
+
+
+//========================================================================================================
+
+
+namespace NeuralNetworksLib
+{
+
+	//runtime-enabled profiler of detection pipeline: per-stage and per-scale timings, cascade funnel counters
+	class DetectorProfiler
+	{
+	public:
+		enum Stage
+		{
+			gray = 0,
+			resize,
+			stage1,
+			check,
+			patch,
+			stage2,
+			stage3,
+			merger,
+			detect,
+			transfer,
+			stage1_l1,
+			stage1_l2,
+			stage1_l3,
+			num_stages
+		};
+		enum Counter
+		{
+			frames = 0,
+			responses_stage1,
+			detections_stage1,
+			drop_stage1,
+			drop_check,
+			call_stage2,
+			detections_stage2,
+			call_stage3,
+			detections_stage3,
+			detections_raw,
+			detections_result,
+			num_counters
+		};
+		enum HardwareEvent
+		{
+			task_clock = 0,
+			cycles,
+			instructions,
+			llc_misses,
+			branch_misses,
+			num_hardware_events
+		};
+
+		static const int max_scales = 64;
+
+		//timed scope of a stage on the calling thread, spans around GPU calls time the host side (launches and blocking copies)
+		class Span
+		{
+		private:
+			DetectorProfiler* profiler;
+			const Stage stage;
+			const int scl;
+			const long long pixels;
+			const int frame;
+			bool active;
+			bool hardware;
+			std::chrono::steady_clock::time_point start;
+			long long hardware_start[num_hardware_events];
+
+			inline void begin()
+			{
+				active = profiler != nullptr && (profiler->isEnabled() || (frame < 0 ? profiler->isTracing() : frame > 0));
+				hardware = active && profiler->isEnabled() && profiler->isHardwareCounters() && profiler->readHardwareCounters(hardware_start);
+				if (active) start = std::chrono::steady_clock::now();
+			}
+
+		public:
+			//pixels: amount of pixels processed by span, used for per-pixel hardware metrics,
+			//frame: trace frame of span running outside of current frame (see newFrame), -1 - current frame
+			Span(DetectorProfiler& _profiler, Stage _stage, int _scl = -1, long long _pixels = 0, int _frame = -1) :
+				profiler(&_profiler), stage(_stage), scl(_scl), pixels(_pixels), frame(_frame)
+			{
+				begin();
+			}
+			//profiler may be null (networks used outside of detector)
+			Span(DetectorProfiler* _profiler, Stage _stage, int _scl = -1, long long _pixels = 0) :
+				profiler(_profiler), stage(_stage), scl(_scl), pixels(_pixels), frame(-1)
+			{
+				begin();
+			}
+			~Span()
+			{
+				if (!active) return;
+
+				const std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+				if (hardware)
+				{
+					long long hardware_end[num_hardware_events];
+					if (profiler->readHardwareCounters(hardware_end))
+					{
+						profiler->addHardware(stage, hardware_start, hardware_end, pixels);
+					}
+				}
+				profiler->addSpan(stage, scl, start, end, frame);
+			}
+		};
+
+		struct StageStat
+		{
+			long long calls = 0;
+			double time = 0.;				//ms
+		};
+		struct HardwareStat
+		{
+			long long calls = 0;
+			long long value[num_hardware_events] = { };		//task_clock in ns
+			long long pixels = 0;
+		};
+		struct Report
+		{
+			StageStat stage[num_stages];
+			HardwareStat hardware[num_stages];
+			int hardware_events = 0;			//bit mask of available hardware events
+			std::vector<StageStat> stage_scale[num_stages];
+			long long counter[num_counters];
+			std::vector<float> scales;
+		};
+
+	private:
+		struct Event
+		{
+			int stage = 0;
+			int scl = -1;
+			int frame = 0;
+			long long start = 0;		//ns from profiler creation
+			long long duration = 0;
+		};
+
+		//written only by owner thread, relaxed atomics make concurrent reading safe
+		struct ThreadData
+		{
+			std::atomic<long long> time[num_stages][max_scales + 1];
+			std::atomic<long long> calls[num_stages][max_scales + 1];
+			std::atomic<long long> counter[num_counters];
+			std::atomic<long long> hardware[num_stages][num_hardware_events];
+			std::atomic<long long> hardware_calls[num_stages];
+			std::atomic<long long> pixels[num_stages];
+
+			int tid = 0;
+			std::mutex event_mutex;
+			std::vector<Event> events;
+
+			//perf_event group of owner thread, opened on first read
+			int hardware_state = 0;			//0 - not opened, 1 - opened, -1 - not available
+			int hardware_fd[num_hardware_events];
+			int hardware_slot[num_hardware_events];		//position in group read, -1 if event is not opened
+			int hardware_count = 0;
+
+			~ThreadData();
+		};
+
+		std::atomic<bool> enabled;
+		std::atomic<bool> tracing;
+		std::atomic<int> trace_frames;
+		std::atomic<int> trace_frame_id;
+		std::atomic<int> trace_frame;
+		std::atomic<bool> hardware_counters;
+		std::atomic<int> hardware_events;
+		const std::chrono::steady_clock::time_point time_origin;
+		mutable std::mutex mutex;
+		std::map<std::thread::id, std::unique_ptr<ThreadData>> thread_data;
+		std::vector<float> scales;
+		const long long uid;
+
+		ThreadData* getThreadData();
+		static int openHardwareCounters(int fd[num_hardware_events], int slot[num_hardware_events], int& count);
+		static void closeHardwareCounters(int fd[num_hardware_events], int slot[num_hardware_events]);
+
+	public:
+		DetectorProfiler(bool _enabled = false);
+
+		inline bool isEnabled() const { return enabled.load(std::memory_order_relaxed); }
+		void setEnabled(bool _enabled) { enabled.store(_enabled, std::memory_order_relaxed); }
+		void setScales(const std::vector<float>& _scales);
+		void reset();
+
+		//Chrome trace event timeline of next num_frames frames
+		void startTrace(int num_frames);
+		void stopTrace() { trace_frames.store(0); tracing.store(false); }
+		inline bool isTracing() const { return tracing.load(std::memory_order_relaxed); }
+
+		//newFrame counts a frame entering the detector and returns its trace frame (0 - not traced),
+		//setFrame makes it the current frame of spans when the pipeline starts on it (frames in flight may overlap)
+		int newFrame();
+		void setFrame(int frame);
+		void nextFrame() { setFrame(newFrame()); }
+		std::string toTraceJSON() const;
+		int saveTrace(const std::string& file_name) const;
+		void clearTrace();
+
+		//hardware performance counters of profiled threads (Linux perf_event_open), counts user space of calling thread only;
+		//returns false if counters are not available, events which could not be opened are reported as null
+		bool setHardwareCounters(bool _enabled);
+		inline bool isHardwareCounters() const { return hardware_counters.load(std::memory_order_relaxed); }
+		bool readHardwareCounters(long long values[num_hardware_events]);
+		void addHardware(Stage stage, const long long start[num_hardware_events], const long long end[num_hardware_events], long long pixels);
+
+		void addTime(Stage stage, int scl, long long time_ns);
+		void addSpan(Stage stage, int scl, std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end, int frame = -1);
+		inline void addCount(Counter counter, long long value = 1)
+		{
+			if (!isEnabled()) return;
+			std::atomic<long long>& cnt = getThreadData()->counter[counter];
+			cnt.store(cnt.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+		}
+
+		Report getReport() const;
+		std::string toJSON() const;
+		int saveJSON(const std::string& file_name) const;
+
+		static const char* getStageName(Stage stage);
+		static const char* getCounterName(Counter counter);
+		static const char* getHardwareEventName(HardwareEvent event);
+	};
+
+}
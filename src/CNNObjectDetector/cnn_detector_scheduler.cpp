@@ -0,0 +1,330 @@
+/*
+*	Copyright (c) 2018, Ilya Kalinovskiy
+*	All rights reserved.
+*
+*	This is an implementation of the algorithm described in the following paper:
+*		I.A. Kalinovskiy, V.G. Spitsyn,
+*		Compact Convolutional Neural Network Cascade for Face Detection,
+*		http://arxiv.org/abs/1508.01292.
+*
+*	Redistribution and use of this program as source code or in binary form, with or without modifications, are permitted provided that the following conditions are met:
+*		1. Redistributions may not be sold, nor may they be used in a commercial product or activity without prior permission from the copyright holder (contact him at kua_21@mail.ru).
+*		2. Redistributions may not be used for military purposes.
+*		3. Any published work which utilizes this program shall include the reference to the paper available at http://arxiv.org/abs/1508.01292
+*		4. Redistributions must retain the above copyright notice and the reference to the algorithm on which the implementation is based on, this list of conditions and the following disclaimer.
+*
+*	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+*	IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#include "cnn_detector_scheduler.h"
+
+#include <cstring>
+
+
+//========================================================================================================
+
+
+namespace NeuralNetworksLib
+{
+
+	StreamScheduler::StreamScheduler(int num_workers, CNNDetector::Param* _param, CNNDetector::AdvancedParam* _advanced_param)
+	{
+		if (_param != 0)
+		{
+			param = *_param;
+		}
+		if (_advanced_param != 0)
+		{
+			advanced_param = *_advanced_param;
+		}
+
+		//one core per detector, the pool provides parallelism
+		param.pipeline = CNNDetector::Pipeline::CPU;
+		param.num_threads = 1;
+		advanced_param.detect_mode = advanced_param.detect_mode == CNNDetector::DetectMode::disable ? CNNDetector::DetectMode::disable : CNNDetector::DetectMode::sync;
+
+		//detectors are shared between streams, per-stream video state is not supported
+		advanced_param.tracking = false;
+		advanced_param.motion_mask = false;
+
+		if (num_workers <= 0)
+		{
+			num_workers = MAX(1, (int)std::thread::hardware_concurrency());
+		}
+
+		for (int i = 0; i < num_workers; ++i)
+		{
+			workers.push_back(std::thread(&StreamScheduler::RunWorker, this));
+		}
+	}
+	StreamScheduler::~StreamScheduler()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			exit = true;
+		}
+		cv_worker.notify_all();
+		cv_done.notify_all();
+
+		for (auto it = workers.begin(); it != workers.end(); ++it)
+		{
+			it->join();
+		}
+		workers.clear();
+		streams.clear();
+	}
+
+	int StreamScheduler::AddStream(const StreamParam& stream_param, Callback callback)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+
+		std::unique_ptr<Stream> stream(new Stream());
+		stream->param = stream_param;
+		stream->param.queue_size = MAX(1, stream->param.queue_size);
+		stream->callback = callback;
+		stream->rate_tokens = rate_burst;
+		stream->last_submit = Clock::now();
+
+		const int id = stream_id++;
+		streams[id] = std::move(stream);
+
+		return id;
+	}
+	void StreamScheduler::RemoveStream(int id)
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+
+			auto it = streams.find(id);
+			if (it == streams.end()) return;
+
+			it->second->removed = true;
+			it->second->queue.clear();
+			ReleaseStreams();
+		}
+		cv_done.notify_all();
+	}
+	void StreamScheduler::ReleaseStreams()
+	{
+		for (auto it = streams.begin(); it != streams.end();)
+		{
+			if (it->second->removed && it->second->running == 0)
+			{
+				it = streams.erase(it);
+			}
+			else
+			{
+				++it;
+			}
+		}
+	}
+
+	long long StreamScheduler::Submit(int id, SIMD::Image_8u& image)
+	{
+		const Clock::time_point now = Clock::now();
+
+		std::unique_lock<std::mutex> lock(mutex);
+
+		auto it = streams.find(id);
+		if (it == streams.end() || it->second->removed)
+		{
+			printf("[StreamScheduler] Stream %d not found!\n", id);
+			return -1;
+		}
+
+		Stream* stream = it->second.get();
+		stream->stat.num_submit++;
+
+		//token bucket on the target frame rate
+		if (stream->param.fps > 0.f)
+		{
+			const double dt = std::chrono::duration<double>(now - stream->last_submit).count();
+			stream->last_submit = now;
+			stream->rate_tokens = MIN(rate_burst, stream->rate_tokens + dt * (double)stream->param.fps);
+			if (stream->rate_tokens < 1.)
+			{
+				stream->stat.num_drop_rate++;
+				return -1;
+			}
+			stream->rate_tokens -= 1.;
+		}
+
+		std::unique_ptr<Frame> frame;
+		if ((int)stream->queue.size() >= stream->param.queue_size)
+		{
+			//reuse buffer of the oldest frame
+			frame = std::move(stream->queue.front());
+			stream->queue.pop_front();
+			stream->stat.num_drop_queue++;
+		}
+		else
+		{
+			frame.reset(new Frame());
+		}
+
+		frame->id = stream->frame_id++;
+		frame->submit = now;
+		const float latency = stream->param.max_latency > 0.f ? stream->param.max_latency : default_latency;
+		frame->deadline = now + std::chrono::microseconds((long long)(1000.f * latency));
+
+		lock.unlock();
+
+		if (frame->image.width != image.width || frame->image.height != image.height || frame->image.nChannel != image.nChannel)
+		{
+			frame->image = SIMD::Image_8u(image.width, image.height, image.nChannel, ALIGN_DEF, false);
+		}
+		for (int j = 0; j < image.height; ++j)
+		{
+			memcpy(frame->image.data + j * frame->image.widthStep, image.data + j * image.widthStep, image.width * image.nChannel);
+		}
+
+		lock.lock();
+
+		const long long frame_id = frame->id;
+		it = streams.find(id);
+		if (it == streams.end() || it->second->removed)
+		{
+			return -1;
+		}
+		it->second->queue.push_back(std::move(frame));
+
+		lock.unlock();
+		cv_worker.notify_one();
+
+		return frame_id;
+	}
+	void StreamScheduler::Wait()
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		cv_done.wait(lock, [this]
+		{
+			if (num_running > 0) return false;
+			for (auto it = streams.begin(); it != streams.end(); ++it)
+			{
+				if (it->second->queue.size() > 0) return false;
+			}
+			return true;
+		});
+	}
+
+	int StreamScheduler::getStat(int id, StreamStat& stat)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+
+		auto it = streams.find(id);
+		if (it == streams.end())
+		{
+			return -1;
+		}
+
+		stat = it->second->stat;
+		return 0;
+	}
+
+	int StreamScheduler::NextFrame(std::unique_ptr<Frame>& frame, Clock::time_point now)
+	{
+		//earliest deadline first, one frame per stream at a time keeps results of a stream in order
+		int id = -1;
+		Clock::time_point deadline_min = Clock::time_point::max();
+		for (auto it = streams.begin(); it != streams.end(); ++it)
+		{
+			Stream* stream = it->second.get();
+			if (stream->running > 0) continue;
+
+			if (stream->param.max_latency > 0.f)
+			{
+				while (stream->queue.size() > 0 && stream->queue.front()->deadline < now)
+				{
+					stream->queue.pop_front();
+					stream->stat.num_drop_stale++;
+				}
+			}
+			if (stream->queue.size() == 0) continue;
+
+			//streams without max_latency have deadline submit + default_latency
+			const Clock::time_point deadline = stream->queue.front()->deadline;
+			if (deadline < deadline_min)
+			{
+				deadline_min = deadline;
+				id = it->first;
+			}
+		}
+
+		if (id >= 0)
+		{
+			frame = std::move(streams[id]->queue.front());
+			streams[id]->queue.pop_front();
+		}
+
+		return id;
+	}
+
+	void StreamScheduler::RunWorker()
+	{
+		CNNDetector detector(&param, &advanced_param);
+
+		for (;;)
+		{
+			std::unique_ptr<Frame> frame;
+			int id = -1;
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				for (;;)
+				{
+					if (exit) return;
+
+					id = NextFrame(frame, Clock::now());
+					if (id >= 0) break;
+
+					cv_worker.wait(lock);
+				}
+
+				streams[id]->running++;
+				num_running++;
+			}
+
+			std::vector<CNNDetector::Detection> detections;
+			const Clock::time_point start = Clock::now();
+			const int err = detector.Detect(detections, frame->image);
+			const Clock::time_point end = Clock::now();
+
+			Callback callback;
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+
+				StreamStat& stat = streams[id]->stat;
+				const double latency = std::chrono::duration<double, std::milli>(end - frame->submit).count();
+				stat.num_processed++;
+				stat.latency_mean += (latency - stat.latency_mean) / (double)stat.num_processed;
+				stat.latency_max = MAX(stat.latency_max, latency);
+				stat.time_detect += std::chrono::duration<double, std::milli>(end - start).count();
+				if (streams[id]->param.max_latency > 0.f && end > frame->deadline)
+				{
+					stat.num_deadline_miss++;
+				}
+
+				if (!streams[id]->removed)
+				{
+					callback = streams[id]->callback;
+				}
+			}
+
+			if (callback)
+			{
+				callback(id, frame->id, err, detections);
+			}
+
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				streams[id]->running--;
+				num_running--;
+				ReleaseStreams();
+			}
+			cv_worker.notify_one();
+			cv_done.notify_all();
+		}
+	}
+
+}
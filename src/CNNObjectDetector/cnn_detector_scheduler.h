@@ -0,0 +1,130 @@
+/*
+*	Copyright (c) 2018, Ilya Kalinovskiy
+*	All rights reserved.
+*
+*	This is an implementation of the algorithm described in the following paper:
+*		I.A. Kalinovskiy, V.G. Spitsyn,
+*		Compact Convolutional Neural Network Cascade for Face Detection,
+*		http://arxiv.org/abs/1508.01292.
+*
+*	Redistribution and use of this program as source code or in binary form, with or without modifications, are permitted provided that the following conditions are met:
+*		1. Redistributions may not be sold, nor may they be used in a commercial product or activity without prior permission from the copyright holder (contact him at kua_21@mail.ru).
+*		2. Redistributions may not be used for military purposes.
+*		3. Any published work which utilizes this program shall include the reference to the paper available at http://arxiv.org/abs/1508.01292
+*		4. Redistributions must retain the above copyright notice and the reference to the algorithm on which the implementation is based on, this list of conditions and the following disclaimer.
+*
+*	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+*	IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#pragma once
+
+#include "config.h"
+#include "cnn_detector_v3.h"
+
+#include <vector>
+#include <deque>
+#include <map>
+#include <memory>
+#include <chrono>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+
+//========================================================================================================
+
+
+namespace NeuralNetworksLib
+{
+
+	//shared pool of detectors for many video streams
+	//frame level parallelism: each worker owns a whole CNNDetector (1 thread, no tracking and motion mask)
+	//and runs Detect on one frame, the stages of a frame are not split into tasks between workers
+	class StreamScheduler
+	{
+	public:
+		typedef std::chrono::steady_clock Clock;
+
+		struct StreamParam
+		{
+			float fps = 0.f;				//frames above rate are dropped (0 - no limit)
+			float max_latency = 0.f;		//ms, frames which can't start before deadline are dropped (0 - no drop, scheduled as default_latency)
+			int queue_size = 2;				//oldest frame is dropped on overflow
+		};
+
+		struct StreamStat
+		{
+			long long num_submit = 0;
+			long long num_processed = 0;
+			long long num_drop_rate = 0;
+			long long num_drop_queue = 0;
+			long long num_drop_stale = 0;
+			long long num_deadline_miss = 0;
+			double latency_mean = 0.;		//ms, from Submit to result
+			double latency_max = 0.;
+			double time_detect = 0.;		//ms, total
+		};
+
+		typedef std::function<void(int stream_id, long long frame_id, int err, std::vector<CNNDetector::Detection>& detections)> Callback;
+
+	private:
+		struct Frame
+		{
+			long long id = 0;
+			SIMD::Image_8u image;
+			Clock::time_point submit;
+			Clock::time_point deadline;
+		};
+
+		struct Stream
+		{
+			StreamParam param;
+			StreamStat stat;
+			Callback callback;
+			std::deque<std::unique_ptr<Frame>> queue;
+			Clock::time_point last_submit;
+			double rate_tokens = 0.;
+			long long frame_id = 0;
+			int running = 0;
+			bool removed = false;
+		};
+
+		CNNDetector::Param param;
+		CNNDetector::AdvancedParam advanced_param;
+
+		std::map<int, std::unique_ptr<Stream>> streams;
+		int stream_id = 0;
+
+		std::vector<std::thread> workers;
+		std::mutex mutex;
+		std::condition_variable cv_worker;		//frame queued, worker or stream freed, exit
+		std::condition_variable cv_done;		//frame finished or stream removed, for Wait
+		int num_running = 0;
+		bool exit = false;
+
+		const double rate_burst = 1.5;
+		const float default_latency = 1000.f;	//ms, deadline of streams without max_latency, they age into priority instead of preempting deadline streams
+
+		void RunWorker();
+		int NextFrame(std::unique_ptr<Frame>& frame, Clock::time_point now);
+		void ReleaseStreams();
+
+	public:
+		StreamScheduler(int num_workers = 0, CNNDetector::Param* _param = 0, CNNDetector::AdvancedParam* _advanced_param = 0);
+		~StreamScheduler();
+
+		int AddStream(const StreamParam& stream_param, Callback callback);
+		void RemoveStream(int id);
+
+		//image is copied, returns frame id or -1 if frame is dropped
+		long long Submit(int id, SIMD::Image_8u& image);
+		void Wait();
+
+		int getStat(int id, StreamStat& stat);
+		int getNumWorkers() const { return (int)workers.size(); }
+	};
+
+}
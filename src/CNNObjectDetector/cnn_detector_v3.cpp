@@ -21,6 +21,8 @@
 #include "cnn_detector_v3.h"
 #include "serialized_models.h"
 
+#include <algorithm>
+
 //#include <opencv2/opencv.hpp>
 
 #ifdef USE_OMP
@@ -61,6 +63,7 @@ namespace NeuralNetworksLib
 	}
 	CNNDetector::~CNNDetector()
 	{
+		StopAsync();
 		Clear();
 	}
 
@@ -203,6 +206,9 @@ namespace NeuralNetworksLib
 		system("pause");
 		*/
 
+#ifdef USE_CNTK_MODELS
+		cpu_cnn->setInt8(advanced_param.int8_models[0]);
+#endif
 		cpu_cnn->Init(advanced_param.path_model[0], advanced_param.index_output[0], hGrd);
 		//cpu_cnn->Init(leg_cnn, true);
 		//cpu_cnn->LoadCNTKModel("P:/face_train/dump.txt");
@@ -212,6 +218,13 @@ namespace NeuralNetworksLib
 			cpu_cnn = NULL;
 			return -1;
 		}
+#ifdef USE_AVX
+		cpu_cnn->setProfiler(&profiler);
+#endif
+#ifdef USE_CNTK_MODELS
+		cpu_cnn->setWinogradLayers(advanced_param.winograd_layers[0]);
+		cpu_cnn->setTemplateLayers(advanced_param.template_layers[0]);
+#endif
 
 		/*
 		cpu_cnn->Clear();
@@ -299,7 +312,7 @@ namespace NeuralNetworksLib
 			if (advanced_param.gray_image_only && max_scale < 0.8f)
 			{
 				Size input_size = param.max_image_size * max_scale;
-				cpu_input_img = SIMD::Image_8u(input_size.width, input_size.height);
+				cpu_input_img = SIMD::Image_8u(input_size.width, input_size.height, ALIGN_DEF, false);
 				cpu_input_img_resizer = new SIMD::ImageResizer(input_size, param.max_image_size);
 				cpu_input_img_scale = max_scale;
 				max_scale = 1.f;
@@ -349,48 +362,50 @@ namespace NeuralNetworksLib
 		//init packet CNN
 		if (advanced_param.packet_detection)
 		{
-			float area_ratio_max = packing2D.packing(&pack, &pack_size, scales, param.max_image_size, int(1.f + scales[0]) * param.max_image_size.width);
-			for (int i = 1; i < MIN(4, (int)scales.size()); ++i)
+			packing2D.setPattern(pattern_size, (int)cpu_cnn->getInputOutputRatio());
+			const Packing2D::Layout* layout = packing2D.getLayout(param.max_image_size, scales);
+			if (layout == NULL)
 			{
-				std::vector<Rect> pack_temp;
-				Size pack_size_temp;
-				float area_ratio = packing2D.packing(&pack_temp, &pack_size_temp, scales, param.max_image_size, int(1.f + scales[i]) * param.max_image_size.width);
-				if (area_ratio > area_ratio_max)
-				{
-					pack.clear();
-					pack = pack_temp;
-					pack_size = pack_size_temp;
-					area_ratio_max = area_ratio;
-				}
+				printf("[CNNDetector] Could not pack image pyramid!\n");
+				return -1;
 			}
-			pack_size.height = int(1.2f * pack_size.height);
+
+			pack_layout = *layout;
+			pack = pack_layout.rects;
+			pack_size = pack_layout.size;
+
+			//canvas is allocated with reserve for layouts of other image sizes, stage 1 runs on layout only
+			pack_capacity = Size(pack_size.width, int(1.2f * pack_size.height));
 
 			if (param.pipeline != Pipeline::GPU)
 			{
-				pack_cpu_img_scale = SIMD::Image_32f(pack_size.width, pack_size.height, ALIGN_DEF, true);
+				pack_cpu_img_scale = SIMD::Image_32f(pack_capacity.width, pack_capacity.height, ALIGN_DEF, true);
+				pack_cpu_img_scale.setSize(pack_size);
 			}
 
 			if ((int)param.pipeline > 0)
 			{
 #ifdef USE_CUDA
 				pack_cu_img_scale = CUDA::Image_32f(
-					pack_size.width,
-					pack_size.height,
-					roundUpMul(pack_size.width, REG_SIZE),
-					addRoundUpMul(pack_size.width, cu_cnn[0]->getBlockSize().width),
-					addRoundUpMul(pack_size.height, cu_cnn[0]->getBlockSize().height),
+					pack_capacity.width,
+					pack_capacity.height,
+					roundUpMul(pack_capacity.width, REG_SIZE),
+					addRoundUpMul(pack_capacity.width, cu_cnn[0]->getBlockSize().width),
+					addRoundUpMul(pack_capacity.height, cu_cnn[0]->getBlockSize().height),
 					ALIGN_DEF);
+				pack_cu_img_scale.setSize(pack_size);
 #endif
 #ifdef USE_CL
 				pack_cl_img_scale = CL::Image_32f(
 					cl_context,
 					cl_queue,
-					pack_size.width,
-					pack_size.height,
-					roundUpMul(pack_size.width, REG_SIZE),
-					addRoundUpMul(pack_size.width, cl_cnn->getBlockSize().width),
-					addRoundUpMul(pack_size.height, cl_cnn->getBlockSize().height),
+					pack_capacity.width,
+					pack_capacity.height,
+					roundUpMul(pack_capacity.width, REG_SIZE),
+					addRoundUpMul(pack_capacity.width, cl_cnn->getBlockSize().width),
+					addRoundUpMul(pack_capacity.height, cl_cnn->getBlockSize().height),
 					ALIGN_DEF);
+				pack_cl_img_scale.setSize(pack_size);
 #endif
 
 				if (advanced_param.detect_mode != DetectMode::disable)
@@ -602,6 +617,7 @@ namespace NeuralNetworksLib
 
 		num_scales = (int)scales.size();
 		data_transfer_flag = new volatile long[scales.size()];
+		scale_roi.resize(scales.size());
 
 #ifdef PROFILE_DETECTOR
 		stat.max_image = param.max_image_size;
@@ -610,6 +626,8 @@ namespace NeuralNetworksLib
 		stat.num_scales = (int)scales.size();
 #endif
 
+		profiler.setScales(scales);
+
 		return 0;
 	}
 	int CNNDetector::InitCNNBuffers()
@@ -618,7 +636,7 @@ namespace NeuralNetworksLib
 		Size init_size = param.max_image_size * scales[0];
 		if (advanced_param.packet_detection)
 		{
-			init_size = pack_size;
+			init_size = pack_capacity;
 		}
 
 		if (param.pipeline != Pipeline::GPU)
@@ -653,6 +671,21 @@ namespace NeuralNetworksLib
 						pack_cpu_response_map.widthStep);
 				}
 			}
+
+			if (advanced_param.approx_pyramid && !advanced_param.packet_detection && scales.size() > 1 && cpu_cnn->getFeatureMapsCount() > 0)
+			{
+				approx_step = advanced_param.approx_step;
+				if (approx_step <= 0)
+				{
+					approx_step = param.scale_factor > 1.f ? int(roundf(logf(2.f) / logf(param.scale_factor))) : 1;
+				}
+				approx_step = MAX(1, approx_step);
+
+				//resampled layer 2 maps fit the largest intermediate scale
+				const Size maps_size = cpu_cnn->getFeatureMapsSize(cpu_img_scale[1].getSize());
+				approx_anchor_maps.resize(scales.size());
+				approx_maps = SIMD::Image_32f(MAX(1, maps_size.width), MAX(1, cpu_cnn->getFeatureMapsCount() * maps_size.height), ALIGN_DEF, true);
+			}
 		}
 
 		if ((int)param.pipeline > 0)
@@ -749,6 +782,9 @@ namespace NeuralNetworksLib
 
 				auto it = cpu_cnn_check1.end() - 1;
 
+#ifdef USE_CNTK_MODELS
+				(*it)->setInt8(advanced_param.int8_models[1]);
+#endif
 				(*it)->Init(advanced_param.path_model[1], advanced_param.index_output[1], hGrd);
 				//(*it)->Init(&CNN_OLD);
 				if ((*it)->isEmpty())
@@ -766,6 +802,10 @@ namespace NeuralNetworksLib
 
 				(*it)->AllocateMemory(ext_pattern_size_cd);
 				(*it)->setNumThreads(1);
+#ifdef USE_CNTK_MODELS
+				(*it)->setWinogradLayers(advanced_param.winograd_layers[1]);
+				(*it)->setTemplateLayers(advanced_param.template_layers[1]);
+#endif
 			}
 
 			//init cpu_cnn_check2
@@ -776,6 +816,9 @@ namespace NeuralNetworksLib
 				//Legacy::ConvNeuralNetwork CNN_OLD(advanced_param.path_model[2]);
 				auto it = cpu_cnn_check2.end() - 1;
 
+#ifdef USE_CNTK_MODELS
+				(*it)->setInt8(advanced_param.int8_models[2]);
+#endif
 				(*it)->Init(advanced_param.path_model[2], advanced_param.index_output[2], hGrd);
 				//(*it)->Init(&CNN_OLD);
 				if ((*it)->isEmpty())
@@ -787,6 +830,10 @@ namespace NeuralNetworksLib
 
 				(*it)->AllocateMemory(ext_pattern_size_cd);
 				(*it)->setNumThreads(1);
+#ifdef USE_CNTK_MODELS
+				(*it)->setWinogradLayers(advanced_param.winograd_layers[2]);
+				(*it)->setTemplateLayers(advanced_param.template_layers[2]);
+#endif
 			}
 
 			//init cpu_cnn_fa
@@ -908,17 +955,20 @@ namespace NeuralNetworksLib
 	{
 		printf("[CNNDetector] Initializing with max image size (%d, %d)!\n", param.max_image_size.width, param.max_image_size.height);
 
+		//embedded models if model files are not set (int8 models are set by files)
 #	ifndef USE_CNTK_MODELS
-		advanced_param.path_model[0] = DUMP::get_serialized_model("cnn4face1_new.bin");
-		advanced_param.path_model[1] = DUMP::get_serialized_model("cnn4face2_new.bin");
-		advanced_param.path_model[2] = DUMP::get_serialized_model("cnn4face3_new.bin");
+		const char* model_names[4] = { "cnn4face1_new.bin", "cnn4face2_new.bin", "cnn4face3_new.bin", nullptr };
 		advanced_param.facial_analysis = false;
 #	else
-		advanced_param.path_model[0] = DUMP::get_serialized_model("cnn4face1_cntk.bin");
-		advanced_param.path_model[1] = DUMP::get_serialized_model("cnn4face2_cntk.bin");
-		advanced_param.path_model[2] = DUMP::get_serialized_model("cnn4face3_cntk.bin");
-		advanced_param.path_model[3] = DUMP::get_serialized_model("cnn4landmarks_cntk.bin");
+		const char* model_names[4] = { "cnn4face1_cntk.bin", "cnn4face2_cntk.bin", "cnn4face3_cntk.bin", "cnn4landmarks_cntk.bin" };
 #	endif
+		for (int i = 0; i < 4; ++i)
+		{
+			if (model_names[i] != nullptr && advanced_param.path_model[i].empty())
+			{
+				advanced_param.path_model[i] = DUMP::get_serialized_model(model_names[i]);
+			}
+		}
 		
 		if (advanced_param.detect_precision == DetectPrecision::def)
 		{
@@ -985,6 +1035,7 @@ namespace NeuralNetworksLib
 	}
 	void CNNDetector::Clear()
 	{
+		WaitAsync();
 		if (isEmpty()) return;
 
 		//clear img_buffer
@@ -1010,6 +1061,8 @@ namespace NeuralNetworksLib
 		{
 			pack.clear();
 			pack_size = Size(0, 0);
+			pack_capacity = Size(0, 0);
+			pack_layout = Packing2D::Layout();
 
 			if (param.pipeline != Pipeline::GPU)
 			{
@@ -1086,6 +1139,30 @@ namespace NeuralNetworksLib
 		}
 
 		scales.clear();
+		scale_roi.clear();
+
+		track_frame = 0;
+		track_active = false;
+		track_rect.clear();
+
+		motion_frame = 0;
+		motion_active = false;
+		motion_prev_gray.clear();
+		motion_dirty.clear();
+
+		coarse_active = false;
+		coarse_done.clear();
+
+		approx_active = false;
+		approx_step = 1;
+		approx_done.clear();
+		approx_anchor_maps.clear();
+		approx_maps.clear();
+
+		async_img_gray[0].clear();
+		async_img_gray[1].clear();
+		async_img_input[0].clear();
+		async_img_input[1].clear();
 
 		//clear fast image resizing
 		if (param.pipeline != Pipeline::GPU)
@@ -1221,24 +1298,405 @@ namespace NeuralNetworksLib
 		}
 	}
 
-	int CNNDetector::PacketReallocate(Size size)
+	bool CNNDetector::GetScaleROI(Rect& roi, const int scl, const Size& img_size) const
+	{
+		roi = Rect(0, 0, img_size.width, img_size.height);
+		if (advanced_param.scale_regions.size() == 0 || advanced_param.packet_detection)
+		{
+			return true;
+		}
+
+		//regions are set in input image coordinates
+		const float region_scale = cpu_input_img_resizer != nullptr ? cpu_input_img_scale : 1.f;
+		const float obj_width = (float)pattern_size.width / scales[scl];
+		const float obj_height = (float)pattern_size.height / scales[scl];
+
+		int x1 = img_size.width;
+		int y1 = img_size.height;
+		int x2 = 0;
+		int y2 = 0;
+		for (auto it = advanced_param.scale_regions.begin(); it != advanced_param.scale_regions.end(); ++it)
+		{
+			//neighbouring scales also respond to the object, so keep one scale_factor step of tolerance
+			const float min_height = region_scale * (float)it->min_obj_size.height;
+			const float max_height = region_scale * (float)it->max_obj_size.height;
+			if (obj_height * param.scale_factor < min_height) continue;
+			if (max_height > 0.f && obj_height > max_height * param.scale_factor) continue;
+
+			//any window overlapping the region
+			x1 = MIN(x1, int(region_scale * (float)it->rect.x - obj_width));
+			y1 = MIN(y1, int(region_scale * (float)it->rect.y - obj_height));
+			x2 = MAX(x2, int(region_scale * (float)it->rect.x2 + obj_width));
+			y2 = MAX(y2, int(region_scale * (float)it->rect.y2 + obj_height));
+		}
+
+		x1 = MAX(x1, 0);
+		y1 = MAX(y1, 0);
+		x2 = MIN(x2, img_size.width);
+		y2 = MIN(y2, img_size.height);
+		if (x2 - x1 < int(obj_width) || y2 - y1 < int(obj_height))
+		{
+			return false;
+		}
+
+		roi = Rect(x1, y1, x2 - x1, y2 - y1);
+		return true;
+	}
+	bool CNNDetector::GetTrackROI(Rect& roi, const int scl) const
+	{
+		if (!track_active || advanced_param.packet_detection || scl >= (int)scales.size() - advanced_param.tracking_sweep_scales)
+		{
+			return true;
+		}
+
+		const float obj_height = (float)pattern_size.height / scales[scl];
+		const float tolerance = param.scale_factor * param.scale_factor;
+
+		int x1 = roi.x2;
+		int y1 = roi.y2;
+		int x2 = roi.x;
+		int y2 = roi.y;
+		for (auto it = track_rect.begin(); it != track_rect.end(); ++it)
+		{
+			//only the few scales matching the previous object size
+			if ((float)it->height * tolerance < obj_height || (float)it->height > obj_height * tolerance) continue;
+
+			const int dx = MAX(int(advanced_param.tracking_expand * (float)it->width), 1);
+			const int dy = MAX(int(advanced_param.tracking_expand * (float)it->height), 1);
+			x1 = MIN(x1, it->x - dx);
+			y1 = MIN(y1, it->y - dy);
+			x2 = MAX(x2, it->x2 + dx);
+			y2 = MAX(y2, it->y2 + dy);
+		}
+
+		x1 = MAX(x1, roi.x);
+		y1 = MAX(y1, roi.y);
+		x2 = MIN(x2, roi.x2);
+		y2 = MIN(y2, roi.y2);
+		if (x2 - x1 < int(obj_height) || y2 - y1 < int(obj_height))
+		{
+			return false;
+		}
+
+		roi = Rect(x1, y1, x2 - x1, y2 - y1);
+		return true;
+	}
+
+	void CNNDetector::UpdateMotionMask()
+	{
+		const int block = MAX(1, advanced_param.motion_block);
+		const Size grid(blockCount(cpu_img_gray.width, block), blockCount(cpu_img_gray.height, block));
+
+		motion_refresh_frame = motion_frame % MAX(1, advanced_param.motion_refresh) == 0;
+		if (motion_prev_gray.isEmpty() || grid.width != motion_grid.width || grid.height != motion_grid.height)
+		{
+			if (motion_prev_gray.isEmpty())
+			{
+				motion_prev_gray = SIMD::Image_32f(param.max_image_size.width, param.max_image_size.height, ALIGN_DEF, true);
+			}
+			motion_grid = grid;
+			motion_dirty.resize(grid.width * grid.height);
+			motion_refresh_frame = true;
+			motion_frame = 0;
+		}
+		motion_frame++;
+
+		if (!motion_refresh_frame)
+		{
+			OMP_PRAGMA(omp parallel for num_threads(num_threads))
+			for (int by = 0; by < grid.height; ++by)
+			{
+				const int y1 = by * block;
+				const int y2 = MIN(y1 + block, cpu_img_gray.height);
+				for (int bx = 0; bx < grid.width; ++bx)
+				{
+					const int x1 = bx * block;
+					const int x2 = MIN(x1 + block, cpu_img_gray.width);
+
+					float sad = 0.f;
+					for (int y = y1; y < y2; ++y)
+					{
+						const float* cur = cpu_img_gray.data + y * cpu_img_gray.widthStep;
+						const float* prev = motion_prev_gray.data + y * motion_prev_gray.widthStep;
+						for (int x = x1; x < x2; ++x)
+						{
+							sad += fabsf(cur[x] - prev[x]);
+						}
+					}
+
+					motion_dirty[by * grid.width + bx] = sad > advanced_param.motion_threshold * float((x2 - x1) * (y2 - y1));
+				}
+			}
+		}
+
+		motion_prev_gray.width = cpu_img_gray.width;
+		motion_prev_gray.height = cpu_img_gray.height;
+		motion_prev_gray.copyData(cpu_img_gray);
+	}
+	void CNNDetector::GetMotionROI(std::vector<Rect>& rois, const int scl, const Rect& roi) const
 	{
-		float area_ratio_max = packing2D.packing(&pack, &pack_size, scales, size, int(1.f + scales[0]) * size.width);
-		for (int i = 1; i < MIN(4, (int)scales.size()); ++i)
+		const int block = MAX(1, advanced_param.motion_block);
+		const int obj_width = int((float)pattern_size.width / scales[scl]) + 1;
+		const int obj_height = int((float)pattern_size.height / scales[scl]) + 1;
+
+		//bands of dirty block rows, expanded by one window to recompute every window touching a change
+		int bx1 = motion_grid.width;
+		int bx2 = -1;
+		int by1 = -1;
+		for (int by = 0; by <= motion_grid.height; ++by)
 		{
-			std::vector<Rect> pack_temp;
-			Size pack_size_temp;
-			float area_ratio = packing2D.packing(&pack_temp, &pack_size_temp, scales, size, int(1.f + scales[i]) * size.width);
-			if (area_ratio > area_ratio_max)
+			int row_x1 = motion_grid.width;
+			int row_x2 = -1;
+			if (by < motion_grid.height)
+			{
+				const char* dirty = &motion_dirty[by * motion_grid.width];
+				for (int bx = 0; bx < motion_grid.width; ++bx)
+				{
+					if (dirty[bx])
+					{
+						row_x1 = MIN(row_x1, bx);
+						row_x2 = bx;
+					}
+				}
+			}
+
+			if (row_x2 >= 0)
 			{
-				pack.clear();
-				pack = pack_temp;
-				pack_size = pack_size_temp;
-				area_ratio_max = area_ratio;
+				if (by1 < 0) by1 = by;
+				bx1 = MIN(bx1, row_x1);
+				bx2 = MAX(bx2, row_x2);
+				continue;
 			}
+
+			if (by1 >= 0)
+			{
+				const int x1 = MAX(roi.x, bx1 * block - obj_width);
+				const int y1 = MAX(roi.y, by1 * block - obj_height);
+				const int x2 = MIN(roi.x2, (bx2 + 1) * block + obj_width);
+				const int y2 = MIN(roi.y2, by * block + obj_height);
+
+				if (x2 - x1 >= obj_width && y2 - y1 >= obj_height)
+				{
+					Rect band(x1, y1, x2 - x1, y2 - y1);
+					if (rois.size() > 0 && rois.back().intersects(band) > 0)
+					{
+						const Rect& last = rois.back();
+						band = Rect(MIN(last.x, x1), MIN(last.y, y1), MAX(last.x2, x2) - MIN(last.x, x1), MAX(last.y2, y2) - MIN(last.y, y1));
+						rois.pop_back();
+					}
+					rois.push_back(band);
+				}
+
+				bx1 = motion_grid.width;
+				bx2 = -1;
+				by1 = -1;
+			}
+		}
+	}
+	void CNNDetector::CPUMotionForward(const int scl, const Rect& roi, const Size& img_resize)
+	{
+		const SIMD::Image_32f& response_map = cpu_response_map[scl];
+		const Size output_size = cpu_cnn->getOutputImgSize(img_resize);
+
+		std::vector<Rect> update_rect;
+		if (motion_refresh_frame || response_map.width != output_size.width || response_map.height != output_size.height)
+		{
+			ResetResponseMap(scl, img_resize);
+			update_rect.push_back(roi);
+		}
+		else
+		{
+			GetMotionROI(update_rect, scl, roi);
 		}
+		scale_roi[scl] = Rect(0, 0, img_resize.width, img_resize.height);
 
-		if (pack.size() == 0) return -1;
+		CPUForwardROI(scl, update_rect);
+	}
+	bool CNNDetector::GetCoarseROI(std::vector<Rect>& rois, const int scl, const Rect& roi) const
+	{
+		const float obj_width = (float)pattern_size.width / scales[scl];
+		const float obj_height = (float)pattern_size.height / scales[scl];
+
+		//windows of coarse responses on neighbouring scales, expanded to cover windows of this scale
+		std::vector<Rect> windows;
+		for (int c = scl - 1; c <= scl + 1; c += 2)
+		{
+			if (c < 0 || c >= (int)scales.size() || !coarse_done[c]) continue;
+
+			const SIMD::Image_32f& response_map = cpu_response_map[c];
+			const float inv_scale = 1.f / scales[c];
+			const float width = MAX((float)pattern_size.width * inv_scale, obj_width);
+			const float height = MAX((float)pattern_size.height * inv_scale, obj_height);
+			const float dx = advanced_param.coarse_expand * width;
+			const float dy = advanced_param.coarse_expand * height;
+
+			for (int j = 0; j < response_map.height; ++j)
+			{
+				const float* resp_map_ptr = response_map.data + j * response_map.widthStep;
+				for (int i = 0; i < response_map.width; ++i)
+				{
+					if (resp_map_ptr[i] <= advanced_param.coarse_treshold) continue;
+
+					const float x = (float)(scale_roi[c].x + i * shift_pattern) * inv_scale;
+					const float y = (float)(scale_roi[c].y + j * shift_pattern) * inv_scale;
+					const int x1 = MAX(roi.x, int(x - dx));
+					const int y1 = MAX(roi.y, int(y - dy));
+					const int x2 = MIN(roi.x2, int(x + width + dx) + 1);
+					const int y2 = MIN(roi.y2, int(y + height + dy) + 1);
+					if (x2 - x1 < int(obj_width) || y2 - y1 < int(obj_height)) continue;
+
+					windows.push_back(Rect(x1, y1, x2 - x1, y2 - y1));
+				}
+			}
+		}
+
+		//union of overlapping windows
+		for (auto it = windows.begin(); it != windows.end(); ++it)
+		{
+			Rect rect = *it;
+			for (bool merged = true; merged;)
+			{
+				merged = false;
+				for (auto jt = rois.begin(); jt != rois.end(); ++jt)
+				{
+					if (jt->intersects(rect) > 0)
+					{
+						rect = Rect(MIN(jt->x, rect.x), MIN(jt->y, rect.y), MAX(jt->x2, rect.x2) - MIN(jt->x, rect.x), MAX(jt->y2, rect.y2) - MIN(jt->y, rect.y));
+						rois.erase(jt);
+						merged = true;
+						break;
+					}
+				}
+			}
+			rois.push_back(rect);
+		}
+
+		//windows of ROIs overlap, so large search area is cheaper in one pass
+		long long area = 0;
+		for (auto it = rois.begin(); it != rois.end(); ++it)
+		{
+			area += (long long)it->width * (long long)it->height;
+		}
+		if ((double)area > advanced_param.coarse_max_area * (double)roi.width * (double)roi.height)
+		{
+			rois.assign(1, roi);
+			return false;
+		}
+
+		return true;
+	}
+	void CNNDetector::ResetResponseMap(const int scl, const Size& img_resize)
+	{
+		//responses outside of computed ROIs are below threshold
+		SIMD::Image_32f& response_map = cpu_response_map[scl];
+		const Size output_size = cpu_cnn->getOutputImgSize(img_resize);
+
+		response_map.width = output_size.width;
+		response_map.height = output_size.height;
+		const float empty_response = advanced_param.treshold_1 - 1.f;
+		for (int j = 0; j < response_map.height; ++j)
+		{
+			std::fill_n(response_map.data + j * response_map.widthStep, response_map.width, empty_response);
+		}
+	}
+	void CNNDetector::CPUForwardROI(const int scl, const std::vector<Rect>& rois)
+	{
+		const float scale = scales[scl];
+		SIMD::Image_32f& response_map = cpu_response_map[scl];
+
+		for (auto it = rois.begin(); it != rois.end(); ++it)
+		{
+			//align to the response map grid
+			const int ox = (int((float)it->x * scale) / shift_pattern) * shift_pattern;
+			const int oy = (int((float)it->y * scale) / shift_pattern) * shift_pattern;
+			const int sx = int((float)ox / scale);
+			const int sy = int((float)oy / scale);
+
+			const Size roi_resize = Size(it->x2 - sx, it->y2 - sy) * scale;
+			if (roi_resize.width < pattern_size.width || roi_resize.height < pattern_size.height) continue;
+
+			SIMD::Image_32f cpu_img_roi(
+				it->x2 - sx,
+				it->y2 - sy,
+				1,
+				cpu_img_gray.data + sy * cpu_img_gray.widthStep + sx,
+				cpu_img_gray.widthStep);
+
+			cpu_img_scale[scl].setSize(roi_resize);
+
+			SIMD::Image_32f cpu_img_temp;
+			cpu_img_temp.clone(cpu_img_scale[scl]);
+
+			{
+				DetectorProfiler::Span span(profiler, DetectorProfiler::resize, scl, (long long)cpu_img_temp.width * (long long)cpu_img_temp.height);
+				PROFILE_TIMER(cpu_timer_cnn, stat.time_cpu_img_resize,
+				if (scale > 0.7f)
+					cpu_img_resizer[scl]->FastImageResize(cpu_img_temp, cpu_img_roi, (int)ImgResize::NearestNeighbor, num_threads);
+				else
+					cpu_img_resizer[scl]->FastImageResize(cpu_img_temp, cpu_img_roi, (int)ImgResize::Bilinear, num_threads);)
+			}
+
+			SIMD::Image_32f response_roi;
+			{
+				DetectorProfiler::Span span(profiler, DetectorProfiler::stage1, scl, (long long)cpu_img_temp.width * (long long)cpu_img_temp.height);
+				PROFILE_TIMER(cpu_timer_cnn, stat.time_cpu_cnn,
+				cpu_cnn->Forward(response_roi, cpu_img_temp);)
+			}
+
+			const int rx = ox / shift_pattern;
+			const int ry = oy / shift_pattern;
+			const int cols = MIN(response_roi.width, response_map.width - rx);
+			const int rows = MIN(response_roi.height, response_map.height - ry);
+			for (int j = 0; j < rows; ++j)
+			{
+				memcpy(response_map.data + (ry + j) * response_map.widthStep + rx,
+					response_roi.data + j * response_roi.widthStep, 
+					cols * sizeof(float));
+			}
+		}
+	}
+
+	bool CNNDetector::CPUApproxForward(const int scl, const Rect& roi, const Size& img_resize)
+	{
+		//maps of full image are resampled from the nearest larger anchor scale
+		const int anchor = scl - scl % approx_step;
+		if (!approx_done[anchor] || roi.width != cpu_img_gray.width || roi.height != cpu_img_gray.height) return false;
+
+		const Size maps_size = cpu_cnn->getFeatureMapsSize(img_resize);
+		if (maps_size.width <= 0 || maps_size.height <= 0) return false;
+
+		//cell q of this scale is centered at anchor pixel r * (stride * q + offset)
+		const Size anchor_resize = cpu_img_gray.getSize() * scales[anchor];
+		const float rx = (float)anchor_resize.width / (float)img_resize.width;
+		const float ry = (float)anchor_resize.height / (float)img_resize.height;
+		const float offset = cpu_cnn->getFeatureMapsOffset() / cpu_cnn->getFeatureMapsStride();
+		const int map_count = cpu_cnn->getFeatureMapsCount();
+
+		approx_maps.setSize(Size(maps_size.width, map_count * maps_size.height));
+		{
+			DetectorProfiler::Span span(profiler, DetectorProfiler::resize, scl, (long long)img_resize.width * (long long)img_resize.height);
+			PROFILE_TIMER(cpu_timer_cnn, stat.time_cpu_img_resize,
+			SIMD::FeatureMapsResize(approx_maps, approx_anchor_maps[anchor], map_count, rx, offset * (rx - 1.f), ry, offset * (ry - 1.f), num_threads);)
+		}
+		{
+			DetectorProfiler::Span span(profiler, DetectorProfiler::stage1, scl, (long long)img_resize.width * (long long)img_resize.height);
+			PROFILE_TIMER(cpu_timer_cnn, stat.time_cpu_cnn,
+			cpu_cnn->ForwardFeatureMaps(cpu_response_map[scl], approx_maps, img_resize);)
+		}
+
+		scale_roi[scl] = Rect(0, 0, img_resize.width, img_resize.height);
+		return true;
+	}
+
+	int CNNDetector::PacketReallocate(Size size)
+	{
+		//layout must fit allocated canvas
+		const Packing2D::Layout* layout = packing2D.getLayout(size, scales, pack_capacity);
+		if (layout == NULL) return -1;
+
+		pack_layout = *layout;
+		pack = pack_layout.rects;
+		pack_size = pack_layout.size;
 
 		if (param.pipeline != Pipeline::GPU)
 		{
@@ -1375,6 +1833,8 @@ namespace NeuralNetworksLib
 								offset += pack_pattern.width;
 							}
 
+							DetectorProfiler::Span span(profiler, DetectorProfiler::patch);
+
 							const int rx = MIN(MAX(x, 0), cpu_img_gray.width);
 							const int ry = MIN(MAX(y, 0), cpu_img_gray.height);
 							const int rcols = MIN(MAX(x + width, 0), cpu_img_gray.width) - rx;
@@ -1427,12 +1887,15 @@ namespace NeuralNetworksLib
 			pack_cu_img_check_32f.height = pack_cu_img_check_8u.height;
 
 			//run on GPU
-			PROFILE_TIMER(cu_timer, stat.time_pack_check_gpu_cnn,
-			pack_cu_img_check_8u.updateDataDevice(true, cu_stream0, true);
-			CUDA::ImageConverter::Img8uToImg32fGRAY_tex((CUDA::Image_32f_pinned*)&pack_cu_img_check_32f, &pack_cu_img_check_8u, cu_stream0);
-			cu_cnn_check->Forward(&pack_cu_response_map_check, &pack_cu_img_check_32f, cu_stream0);
-			pack_cu_response_map_check.updateDataHost(true, cu_stream0, true);
-			cuERR(cudaStreamSynchronize(cu_stream0));)
+			{
+				DetectorProfiler::Span span(profiler, DetectorProfiler::stage2, -1, (long long)pack_cu_img_check_32f.width * (long long)pack_cu_img_check_32f.height);
+				PROFILE_TIMER(cu_timer, stat.time_pack_check_gpu_cnn,
+				pack_cu_img_check_8u.updateDataDevice(true, cu_stream0, true);
+				CUDA::ImageConverter::Img8uToImg32fGRAY_tex((CUDA::Image_32f_pinned*)&pack_cu_img_check_32f, &pack_cu_img_check_8u, cu_stream0);
+				cu_cnn_check->Forward(&pack_cu_response_map_check, &pack_cu_img_check_32f, cu_stream0);
+				pack_cu_response_map_check.updateDataHost(true, cu_stream0, true);
+				cuERR(cudaStreamSynchronize(cu_stream0));)
+			}
 			
 			Size resp_map_size = cu_cnn_check->getOutputImgSize(ext_pattern_size_cd);
 			const Size pack_resp_map_step = pack_pattern * (1.f / (float)shift_pattern);
@@ -1522,6 +1985,7 @@ namespace NeuralNetworksLib
 						if (overlap > 0.5f)
 						{
 							PROFILE_COUNTER_INC(stat.num_check_hor_drop)
+							profiler.addCount(DetectorProfiler::drop_check);
 							rect.push_back(Detection(new_rect, it->score, scale, it->knn));
 							bl = true;
 							break;
@@ -1550,6 +2014,8 @@ namespace NeuralNetworksLib
 				height = static_cast<int>(height + height * k);
 			}
 
+			DetectorProfiler::Span span(profiler, DetectorProfiler::patch);
+
 			rx = MIN(MAX(x, 0), img.width);
 			ry = MIN(MAX(y, 0), img.height);
 			rcols = MIN(MAX(x + width, 0), img.width) - rx;
@@ -1612,6 +2078,9 @@ namespace NeuralNetworksLib
 			SIMD::Image_32f response_map;
 			if (icx == -1)
 			{
+				DetectorProfiler::Span span(profiler, DetectorProfiler::stage2, -1, (long long)cpu_img_check_32f[index].width * (long long)cpu_img_check_32f[index].height);
+				profiler.addCount(DetectorProfiler::call_stage2);
+
 				PROFILE_COUNTER_INC(stat.num_check_call_cnn2)
 				PROFILE_TIMER(cpu_timer_check2, stat.time_check_cpu_cnn2,
 				if (!advanced_param.packet_detection || pack_id < 0)
@@ -1631,6 +2100,9 @@ namespace NeuralNetworksLib
 			}
 			else
 			{
+				DetectorProfiler::Span span(profiler, DetectorProfiler::stage3, -1, (long long)cpu_img_check_32f[index].width * (long long)cpu_img_check_32f[index].height);
+				profiler.addCount(DetectorProfiler::call_stage3);
+
 				PROFILE_COUNTER_INC(stat.num_check_call_cnn3)
 				PROFILE_TIMER(cpu_timer_check2, stat.time_check_cpu_cnn3,
 				if (!advanced_param.uniform_noise)
@@ -1706,6 +2178,9 @@ namespace NeuralNetworksLib
 			if (advanced_param.type_check == 2 && knn_count1 < min_neighbors) break;
 		}
 
+		profiler.addCount(DetectorProfiler::detections_stage2, knn_count1);
+		profiler.addCount(DetectorProfiler::detections_stage3, knn_count2);
+
 		switch (advanced_param.type_check)
 		{
 		case 0: 
@@ -1731,14 +2206,23 @@ namespace NeuralNetworksLib
 			FacialData fd;
 			if (cpu_cnn_fa.size() != 0)
 			{
+				//5 landmarks, gender, smile and glasses: outputs 0-12 on one pass of conv and hidden layers
 				SIMD::Image_32f response_map;
+				std::vector<SIMD::Image_32f> response_maps;
+#ifdef USE_CNTK_MODELS
+				static const std::vector<int> fa_outputs = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12 };
+				if (!cpu_cnn_fa[index]->isGraph())
+					cpu_cnn_fa[index]->ForwardOutputs(response_maps, cpu_img_check_resize_32f[index], fa_outputs);
+				else
+#endif
 				cpu_cnn_fa[index]->Forward(response_map, cpu_img_check_resize_32f[index]);
+				auto fa_output = [&](int k) { return response_maps.empty() ? response_map.data[k * response_map.widthStep] : response_maps[k].data[0]; };
 
 				int zero_landmarks = 0;
 				for (int t = 0; t < 5; ++t)
 				{
-					fd.landmarks[t].x = int(response_map.data[2 * t * response_map.widthStep] * float(rcols));
-					fd.landmarks[t].y = int(response_map.data[(2 * t + 1) * response_map.widthStep] * float(rrows));
+					fd.landmarks[t].x = int(fa_output(2 * t) * float(rcols));
+					fd.landmarks[t].y = int(fa_output(2 * t + 1) * float(rrows));
 
 					if (fd.landmarks[t].x < (rcols >> 1) && fd.landmarks[t].y < (rrows >> 1))
 						zero_landmarks++;
@@ -1748,9 +2232,9 @@ namespace NeuralNetworksLib
 				}
 				if (zero_landmarks == 5) return;
 
-				fd.gender = int(response_map.data[10 * response_map.widthStep] + 0.5f);
-				fd.smile = int(response_map.data[11 * response_map.widthStep] + 0.5f);
-				fd.glasses = int(response_map.data[12 * response_map.widthStep] + 0.5f);
+				fd.gender = int(fa_output(10) + 0.5f);
+				fd.smile = int(fa_output(11) + 0.5f);
+				fd.glasses = int(fa_output(12) + 0.5f);
 			}
 
 			OMP_PRAGMA(omp critical(add_rect))
@@ -1843,6 +2327,8 @@ namespace NeuralNetworksLib
 	{
 		OMP_PRAGMA(omp critical(check_rect))
 		{
+			DetectorProfiler::Span span(profiler, DetectorProfiler::check, scl);
+
 			std::vector<Detection>* detect_rect;
 
 #if defined(USE_CUDA) || defined(USE_CL)
@@ -1859,15 +2345,15 @@ namespace NeuralNetworksLib
 			std::vector<std::pair<Point, float>> detect_point;
 			detect_point.reserve(20);
 
-			const float scale = scales[scl];
-			const float inv_scale = 1.f / scale;
-
 			PROFILE_TIMER(cpu_timer_check1, stat.time_check_ver_drop,
 			GPU_ONLY(
 			if (device > 0)
 			{
 				PROFILE_COUNTER_INC(stat.num_call_check_gpu)
 
+				const float scale = scales[scl];
+				const float inv_scale = 1.f / scale;
+
 				CUDA_CODE(
 				PROFILE_COUNTER_ADD(stat.num_responses_stage1, cu_response_map[scl].size)
 				for (int j = 0; j < cu_response_map[scl].height; ++j)
@@ -1912,102 +2398,121 @@ namespace NeuralNetworksLib
 			}
 			else)	
 			{
-				PROFILE_COUNTER_INC(stat.num_call_check_cpu)
-				PROFILE_COUNTER_ADD(stat.num_responses_stage1, cpu_response_map[scl].size)
+				CollectResponses(detect_point,* detect_rect, cpu_response_map[scl], Point(scale_roi[scl].x, scale_roi[scl].y), scl);
+			})
 
-				for (int j = 0; j < cpu_response_map[scl].height; ++j)
-				{
-					float* resp_map_ptr = cpu_response_map[scl].data + j * cpu_response_map[scl].widthStep;
-					for (int i = 0; i < cpu_response_map[scl].width; ++i)
-					{
-						const float score = *(resp_map_ptr++);
-						if (score > advanced_param.treshold_1)
-						{
-							const Point point(i * shift_pattern, j * shift_pattern);
-							
-							if (advanced_param.drop_detect)
-							{
-								Rect new_rect(
-									static_cast<int>((float)point.x * inv_scale),
-									static_cast<int>((float)point.y * inv_scale),
-									static_cast<int>((float)pattern_size.width * inv_scale),
-									static_cast<int>((float)pattern_size.height * inv_scale));
+			CheckDetectPoints(*detect_rect, detect_point, cpu_img_gray, scl);
 
-								if (DropDetection(new_rect,* detect_rect,* detect_rect, scale))
-								{
-									PROFILE_COUNTER_ADD(stat.num_check_ver_drop, 1.)
-										continue;
-								}
-							}
+			detect_point.clear();
+		}
+	}
+	void CNNDetector::CollectResponses(std::vector<std::pair<Point, float>>& detect_point, std::vector<Detection>& detect_rect, 
+		const SIMD::Image_32f& response_map, const Point& roi_offset, const int scl)
+	{
+		const float scale = scales[scl];
+		const float inv_scale = 1.f / scale;
 
-							detect_point.push_back(std::pair<Point, float>(point, score));
-							PROFILE_COUNTER_ADD(stat.num_detections_stage1, 1.)
-						}
-					}
-				}
-			})
+		PROFILE_COUNTER_INC(stat.num_call_check_cpu)
+		PROFILE_COUNTER_ADD(stat.num_responses_stage1, response_map.size)
+		profiler.addCount(DetectorProfiler::responses_stage1, response_map.width * response_map.height);
 
-			PROFILE_TIMER(cpu_timer_check1, stat.time_check,
-			if (advanced_param.detect_mode != DetectMode::disable && detect_point.size() > 0)
+		for (int j = 0; j < response_map.height; ++j)
+		{
+			float* resp_map_ptr = response_map.data + j * response_map.widthStep;
+			for (int i = 0; i < response_map.width; ++i)
 			{
-				if (advanced_param.uniform_noise)
+				const float score = *(resp_map_ptr++);
+				if (score > advanced_param.treshold_1)
 				{
-					const float rnd = -20.f / (float)RAND_MAX;
-					char* ptr = cpu_img_urnd.data;
-					for (int k = 0; k < cpu_img_urnd.widthStep * cpu_img_urnd.height; ++k)
+					const Point point(roi_offset.x + i * shift_pattern, roi_offset.y + j * shift_pattern);
+					
+					if (advanced_param.drop_detect)
 					{
-						*ptr++ = char(10.f + rnd * (float)std::rand());
+						Rect new_rect(
+							static_cast<int>((float)point.x * inv_scale),
+							static_cast<int>((float)point.y * inv_scale),
+							static_cast<int>((float)pattern_size.width * inv_scale),
+							static_cast<int>((float)pattern_size.height * inv_scale));
+
+						if (DropDetection(new_rect, detect_rect, detect_rect, scale))
+						{
+							PROFILE_COUNTER_ADD(stat.num_check_ver_drop, 1.)
+							profiler.addCount(DetectorProfiler::drop_stage1);
+								continue;
+						}
 					}
+
+					detect_point.push_back(std::pair<Point, float>(point, score));
+					PROFILE_COUNTER_ADD(stat.num_detections_stage1, 1.)
 				}
+			}
+		}
+	}
+	void CNNDetector::CheckDetectPoints(std::vector<Detection>& detect_rect, std::vector<std::pair<Point, float>>& detect_point, const SIMD::Image_32f& img_gray, const int scl)
+	{
+		const float scale = scales[scl];
+		const float inv_scale = 1.f / scale;
 
-				const int detect_rect_size = static_cast<const int>(detect_rect->size());
+		profiler.addCount(DetectorProfiler::detections_stage1, (long long)detect_point.size());
 
-				int num_trd = num_threads;
-				if (param.pipeline != Pipeline::GPU && advanced_param.detect_mode == DetectMode::async)
+		PROFILE_TIMER(cpu_timer_check1, stat.time_check,
+		if (advanced_param.detect_mode != DetectMode::disable && detect_point.size() > 0)
+		{
+			if (advanced_param.uniform_noise)
+			{
+				const float rnd = -20.f / (float)RAND_MAX;
+				char* ptr = cpu_img_urnd.data;
+				for (int k = 0; k < cpu_img_urnd.widthStep * cpu_img_urnd.height; ++k)
 				{
-					num_trd = 1;
+					*ptr++ = char(10.f + rnd * (float)std::rand());
 				}
+			}
 
-				OMP_PRAGMA(omp parallel for num_threads(num_trd) schedule(static))
-				for (int p = 0; p < (int)detect_point.size(); ++p)
-				{
-					int pack_id = -1;
-					if (advanced_param.packet_detection)
-					{
-						CUDA_CODE({
-							for (auto it = pack_pos_check.begin(); it != pack_pos_check.end(); ++it)
-							{
-								if (it->scl == scl &&
-									it->x == detect_point[p].first.x / shift_pattern &&
-									it->y == detect_point[p].first.y / shift_pattern)
-								{
-									pack_id = it->pack_id;
-									break;
-								}
-							}
-						})
-					}
+			const int detect_rect_size = static_cast<const int>(detect_rect.size());
 
-					CPUCheckDetect(*detect_rect, detect_rect_size, detect_point[p].first, detect_point[p].second, cpu_img_gray, scale, 0, pack_id);
-				}
+			int num_trd = num_threads;
+			if (param.pipeline != Pipeline::GPU && advanced_param.detect_mode == DetectMode::async)
+			{
+				num_trd = 1;
 			}
-			else
+
+			OMP_PRAGMA(omp parallel for num_threads(num_trd) schedule(static))
+			for (int p = 0; p < (int)detect_point.size(); ++p)
 			{
-				for (int p = 0; p < (int)detect_point.size(); ++p)
+				int pack_id = -1;
+				if (advanced_param.packet_detection)
 				{
-					detect_rect->push_back(Detection(
-						int((float)detect_point[p].first.x * inv_scale),
-						int((float)detect_point[p].first.y * inv_scale),
-						int((float)pattern_size.width * inv_scale), 
-						int((float)pattern_size.height * inv_scale), 
-						detect_point[p].second,
-						scale, 
-						0));
+					CUDA_CODE({
+						for (auto it = pack_pos_check.begin(); it != pack_pos_check.end(); ++it)
+						{
+							if (it->scl == scl &&
+								it->x == detect_point[p].first.x / shift_pattern &&
+								it->y == detect_point[p].first.y / shift_pattern)
+							{
+								pack_id = it->pack_id;
+								break;
+							}
+						}
+					})
 				}
-			})
 
-			detect_point.clear();
+				CPUCheckDetect(detect_rect, detect_rect_size, detect_point[p].first, detect_point[p].second, img_gray, scale, 0, pack_id);
+			}
 		}
+		else
+		{
+			for (int p = 0; p < (int)detect_point.size(); ++p)
+			{
+				detect_rect.push_back(Detection(
+					int((float)detect_point[p].first.x * inv_scale),
+					int((float)detect_point[p].first.y * inv_scale),
+					int((float)pattern_size.width * inv_scale), 
+					int((float)pattern_size.height * inv_scale), 
+					detect_point[p].second,
+					scale, 
+					0));
+			}
+		})
 	}
 	void CNNDetector::RunCheckDetectAsync()
 	{
@@ -2074,9 +2579,30 @@ namespace NeuralNetworksLib
 
 		const int scl_max = num_scales - 1;
 
+		//coarse scales go first, the others are searched around their responses,
+		//anchor scales of approximate pyramid go first, the others are resampled from them
+		std::vector<int> scale_order;
+		for (int pass = coarse_active || approx_active ? 0 : 1; pass < 2; ++pass)
+		{
+			for (int scl = scl_max; scl >= 0; --scl)
+			{
+				const bool first_pass = (coarse_active && IsCoarseScale(scl)) || (approx_active && IsAnchorScale(scl));
+				if ((pass == 0) == first_pass) scale_order.push_back(scl);
+			}
+		}
+		if (coarse_active)
+		{
+			coarse_done.assign(scales.size(), 0);
+		}
+		if (approx_active)
+		{
+			approx_done.assign(scales.size(), 0);
+		}
+
 		SIMD::Image_32f cpu_img_temp;
-		for (int scl = scl_max; scl >= 0; --scl)
+		for (auto it_scl = scale_order.begin(); it_scl != scale_order.end(); ++it_scl)
 		{
+			const int scl = *it_scl;
 			if (AtomicCompareExchangeSwap(&data_transfer_flag[scl], 1, 0) == 0)
 			{
 				const Size img_resize = cpu_img_gray.getSize() * scales[scl];
@@ -2086,17 +2612,91 @@ namespace NeuralNetworksLib
 					num_scales = MIN(scl, num_scales);
 					continue;
 				}
-				cpu_img_scale[scl].setSize(img_resize);
+
+				Rect roi;
+				if (!GetScaleROI(roi, scl, cpu_img_gray.getSize()) || !GetTrackROI(roi, scl))
+				{
+					//no region allows objects of this size or no object is tracked at this scale
+					AtomicCompareExchangeSwap(&data_transfer_flag[scl], 3, data_transfer_flag[scl]);
+					continue;
+				}
+
+				if (coarse_active && !IsCoarseScale(scl))
+				{
+					std::vector<Rect> rois;
+					if (GetCoarseROI(rois, scl, roi))
+					{
+						if (rois.empty())
+						{
+							AtomicCompareExchangeSwap(&data_transfer_flag[scl], 3, data_transfer_flag[scl]);
+							continue;
+						}
+
+						ResetResponseMap(scl, img_resize);
+						scale_roi[scl] = Rect(0, 0, img_resize.width, img_resize.height);
+						CPUForwardROI(scl, rois);
+
+						AtomicCompareExchangeSwap(&data_transfer_flag[scl], 2, 1);
+#if defined(_MSC_VER)
+						SetEvent(check_detect_event);
+#endif
+						continue;
+					}
+				}
+
+				if (approx_active && !IsAnchorScale(scl) && CPUApproxForward(scl, roi, img_resize))
+				{
+					AtomicCompareExchangeSwap(&data_transfer_flag[scl], 2, 1);
+#if defined(_MSC_VER)
+					SetEvent(check_detect_event);
+#endif
+					continue;
+				}
+
+				if (motion_active)
+				{
+					CPUMotionForward(scl, roi, img_resize);
+
+					AtomicCompareExchangeSwap(&data_transfer_flag[scl], 2, 1);
+#if defined(_MSC_VER)
+					SetEvent(check_detect_event);
+#endif
+					continue;
+				}
+
+				SIMD::Image_32f cpu_img_roi;
+				cpu_img_roi.clone(cpu_img_gray);
+
+				const bool full_image = roi.width == cpu_img_gray.width && roi.height == cpu_img_gray.height;
+				if (full_image)
+				{
+					scale_roi[scl] = Rect(0, 0, img_resize.width, img_resize.height);
+					cpu_img_scale[scl].setSize(img_resize);
+				}
+				else
+				{
+					cpu_img_roi = SIMD::Image_32f(
+						roi.width,
+						roi.height,
+						1,
+						cpu_img_gray.data + roi.y * cpu_img_gray.widthStep + roi.x,
+						cpu_img_gray.widthStep);
+
+					const Size roi_resize = Size(roi.width, roi.height) * scales[scl];
+					scale_roi[scl] = Rect(int((float)roi.x * scales[scl]), int((float)roi.y * scales[scl]), roi_resize.width, roi_resize.height);
+					cpu_img_scale[scl].setSize(roi_resize);
+				}
 
 				cpu_img_temp.clone(cpu_img_scale[scl]);
 
-				if (scales[scl] != 1.f || advanced_param.packet_detection)
+				if (scales[scl] != 1.f || advanced_param.packet_detection || !full_image)
 				{
+					DetectorProfiler::Span span(profiler, DetectorProfiler::resize, scl, (long long)cpu_img_temp.width * (long long)cpu_img_temp.height);
 					PROFILE_TIMER(cpu_timer_cnn, stat.time_cpu_img_resize,
 					if (scales[scl] > 0.7f)
-						cpu_img_resizer[scl]->FastImageResize(cpu_img_temp, cpu_img_gray, (int)ImgResize::NearestNeighbor, num_threads);
+						cpu_img_resizer[scl]->FastImageResize(cpu_img_temp, cpu_img_roi, (int)ImgResize::NearestNeighbor, num_threads);
 					else
-						cpu_img_resizer[scl]->FastImageResize(cpu_img_temp, cpu_img_gray, (int)ImgResize::Bilinear, num_threads);)
+						cpu_img_resizer[scl]->FastImageResize(cpu_img_temp, cpu_img_roi, (int)ImgResize::Bilinear, num_threads);)
 				}
 				else
 				{
@@ -2105,8 +2705,20 @@ namespace NeuralNetworksLib
 
 				if (!advanced_param.packet_detection)
 				{
-					PROFILE_TIMER(cpu_timer_cnn, stat.time_cpu_cnn,
-					cpu_cnn->Forward(cpu_response_map[scl], cpu_img_temp);)
+					{
+						DetectorProfiler::Span span(profiler, DetectorProfiler::stage1, scl, (long long)cpu_img_temp.width * (long long)cpu_img_temp.height);
+						PROFILE_TIMER(cpu_timer_cnn, stat.time_cpu_cnn,
+						cpu_cnn->Forward(cpu_response_map[scl], cpu_img_temp);)
+					}
+					if (coarse_active)
+					{
+						coarse_done[scl] = 1;
+					}
+					if (approx_active && IsAnchorScale(scl) && full_image && cpu_response_map[scl].width > 0)
+					{
+						cpu_cnn->getFeatureMaps(approx_anchor_maps[scl]);
+						approx_done[scl] = 1;
+					}
 
 #if 0
 					if (0)
@@ -2224,6 +2836,7 @@ namespace NeuralNetworksLib
 
 		if (advanced_param.packet_detection)
 		{
+			DetectorProfiler::Span span(profiler, DetectorProfiler::stage1, -1, (long long)pack_cpu_img_scale.width * (long long)pack_cpu_img_scale.height);
 			PROFILE_TIMER(cpu_timer_cnn, stat.time_pack_cpu_cnn,
 			cpu_cnn->Forward(pack_cpu_response_map, pack_cpu_img_scale);)
 		}
@@ -2284,6 +2897,7 @@ namespace NeuralNetworksLib
 
 				if (scales[scl] != 1.f || advanced_param.packet_detection)
 				{
+					DetectorProfiler::Span span(profiler, DetectorProfiler::resize, scl, (long long)img_resize.width * (long long)img_resize.height);
 					PROFILE_TIMER(cu_timer, stat.time_gpu_img_resize,
 					if (scales[scl] > 0.7f)
 						CUDA::ImageResizer::FastImageResize(&cu_img_temp, &cu_img_gray, (int)ImgResize::NearestNeighbor, cu_stream_temp);
@@ -2302,8 +2916,11 @@ namespace NeuralNetworksLib
 					//Nvidia Hyper-Q not supported!
 					cuERR(cudaStreamWaitEvent(cu_stream_temp, cu_event_calc_cnn, 0));
 
-					PROFILE_TIMER(cu_timer, stat.time_gpu_cnn,
-					cu_cnn[t % advanced_param.num_cnn_copy]->Forward(&cu_response_map[scl], &cu_img_scale[scl], cu_stream_temp);)
+					{
+						DetectorProfiler::Span span(profiler, DetectorProfiler::stage1, scl, (long long)img_resize.width * (long long)img_resize.height);
+						PROFILE_TIMER(cu_timer, stat.time_gpu_cnn,
+						cu_cnn[t % advanced_param.num_cnn_copy]->Forward(&cu_response_map[scl], &cu_img_scale[scl], cu_stream_temp);)
+					}
 					
 					cuERR(cudaEventRecord(cu_event_calc_cnn, cu_stream_temp));
 
@@ -2316,6 +2933,7 @@ namespace NeuralNetworksLib
 
 		if (advanced_param.packet_detection)
 		{
+			DetectorProfiler::Span span(profiler, DetectorProfiler::stage1, -1, (long long)pack_cu_img_scale.width * (long long)pack_cu_img_scale.height);
 			PROFILE_TIMER(cu_timer, stat.time_pack_gpu_cnn,
 			cu_cnn[0]->Forward(&pack_cu_response_map, &pack_cu_img_scale, cu_stream0);
 			pack_cu_response_map.updateDataHost(true, cu_stream0);)
@@ -2387,6 +3005,7 @@ namespace NeuralNetworksLib
 
 				if (scales[scl] != 1.f || advanced_param.packet_detection)
 				{
+					DetectorProfiler::Span span(profiler, DetectorProfiler::resize, scl, (long long)img_resize.width * (long long)img_resize.height);
 					PROFILE_TIMER(cl_timer, stat.time_gpu_img_resize,
 					if (scales[scl] > 0.7f)
 						CL::ImageResizer::FastImageResize(&cl_img_temp, &cl_img_gray, (int)ImgResize::NearestNeighbor, cl_queue);
@@ -2400,8 +3019,11 @@ namespace NeuralNetworksLib
 
 				if (!advanced_param.packet_detection)
 				{
-					PROFILE_TIMER(cl_timer, stat.time_gpu_cnn,
-					cl_cnn->Forward(&cl_response_map[scl], &cl_img_temp);)
+					{
+						DetectorProfiler::Span span(profiler, DetectorProfiler::stage1, scl, (long long)img_resize.width * (long long)img_resize.height);
+						PROFILE_TIMER(cl_timer, stat.time_gpu_cnn,
+						cl_cnn->Forward(&cl_response_map[scl], &cl_img_temp);)
+					}
 
 					if (i_scl % 3 == 0)
 					{
@@ -2447,6 +3069,7 @@ namespace NeuralNetworksLib
 
 		if (advanced_param.packet_detection)
 		{
+			DetectorProfiler::Span span(profiler, DetectorProfiler::stage1, -1, (long long)pack_cl_img_scale.width * (long long)pack_cl_img_scale.height);
 			PROFILE_TIMER(cl_timer, stat.time_pack_gpu_cnn,
 			cl_cnn->Forward(&pack_cl_response_map, &pack_cl_img_scale);
 			pack_cl_response_map.updateDataHost(true);)
@@ -2480,8 +3103,13 @@ namespace NeuralNetworksLib
 	}
 #endif
 
-	int  CNNDetector::Detect(std::vector<Detection>& detections, SIMD::Image_8u& image)
+	int CNNDetector::PrepareImage(SIMD::Image_8u& image, Size* packet_size, int trace_frame, bool resize_input)
 	{
+		if (packet_size != nullptr)
+		{
+			*packet_size = Size(0, 0);
+		}
+
 		if (isEmpty())
 		{
 			if (Init() < 0)
@@ -2515,11 +3143,13 @@ namespace NeuralNetworksLib
 		{
 			if (image.width != param.max_image_size.width || image.height != param.max_image_size.height)
 			{
-				num_scales = (int)scales.size();
-
 				if (advanced_param.packet_detection)
 				{
-					if (PacketReallocate(image.getSize()) < 0)
+					if (packet_size != nullptr)
+					{
+						*packet_size = image.getSize();
+					}
+					else if (PacketReallocate(image.getSize()) < 0)
 					{
 						printf("[CNNDetector] Packet buffers no initialized!\n");
 						return -1;
@@ -2532,20 +3162,83 @@ namespace NeuralNetworksLib
 		{
 			if (image.nChannel == 1)
 			{
-				PROFILE_TIMER(cpu_timer_detector, stat.time_cpu_input_img_resize,
-				cpu_input_img.setSize(image.getSize() * cpu_input_img_scale);
-				cpu_input_img_resizer->FastImageResize(cpu_input_img, image, (int)ImgResize::Bilinear, num_threads);
-				image.clone(cpu_input_img);)
+				if (resize_input)
+				{
+					PROFILE_TIMER(cpu_timer_detector, stat.time_cpu_input_img_resize,
+					ResizeInputImage(cpu_input_img, image, trace_frame);)
+					image.clone(cpu_input_img);
+				}
 			}
 			else
 			{
 				printf("[CNNDetector] gray_image_only flag set to false!\n");
 				advanced_param.gray_image_only = false;
 				Clear();
-				return Detect(detections, image);
+				return PrepareImage(image, packet_size, trace_frame, resize_input);
+			}
+		}
+
+		return 1;
+	}
+	void CNNDetector::ResizeInputImage(SIMD::Image_8u& img_input, SIMD::Image_8u& image, int trace_frame)
+	{
+		DetectorProfiler::Span span(profiler, DetectorProfiler::resize, -1, (long long)image.width * (long long)image.height, trace_frame);
+
+		img_input.setSize(image.getSize() * cpu_input_img_scale);
+		cpu_input_img_resizer->FastImageResize(img_input, image, (int)ImgResize::Bilinear, num_threads);
+	}
+	int CNNDetector::ConvertGrayImage(SIMD::Image_32f& img_gray, SIMD::Image_8u& image, int trace_frame)
+	{
+		DetectorProfiler::Span span(profiler, DetectorProfiler::gray, -1, (long long)image.width * (long long)image.height, trace_frame);
+
+		img_gray.width = image.width;
+		img_gray.height = image.height;
+
+		auto convert = [&]()
+		{
+			if (advanced_param.blur)
+			{
+				return SIMD::ImageConverter::Img8uToImg32fGRAY_blur(img_gray, image, col_filter3_kernel(), row_filter3_kernel(), num_threads);
 			}
+			return SIMD::ImageConverter::Img8uToImg32fGRAY(img_gray, image, num_threads);
+		};
+
+		int err = 0;
+		if (trace_frame >= 0)
+		{
+			//DetectAsync: the timers and stat belong to the worker thread
+			err = convert();
+		}
+		else
+		{
+			PROFILE_TIMER(cpu_timer_detector, stat.time_cpu_RGBtoGray,
+			err = convert();)
 		}
 
+		if (err < 0)
+		{
+			printf("[CNNDetector] This type image is not supported!\n");
+			return -1;
+		}
+
+		return 0;
+	}
+
+	int  CNNDetector::Detect(std::vector<Detection>& detections, SIMD::Image_8u& image)
+	{
+		WaitAsync();
+		profiler.nextFrame();
+
+		const int err = PrepareImage(image);
+		if (err <= 0)
+		{
+			return err;
+		}
+
+		return DetectImage(detections, image);
+	}
+	int CNNDetector::DetectImage(std::vector<Detection>& detections, SIMD::Image_8u& image)
+	{
 		PROFILE_COUNTER_INC(stat.num_call_detect)
 
 		if ((int)param.pipeline > 0)
@@ -2555,8 +3248,11 @@ namespace NeuralNetworksLib
 			cu_img_input.height = image.height;
 			cu_img_input.nChannel = image.nChannel;
 
-			PROFILE_TIMER(cu_timer, stat.time_img_HD_copy,
-			cu_img_input.copyData(&image, true, cu_stream0);)
+			{
+				DetectorProfiler::Span span(profiler, DetectorProfiler::transfer);
+				PROFILE_TIMER(cu_timer, stat.time_img_HD_copy,
+				cu_img_input.copyData(&image, true, cu_stream0);)
+			}
 
 			cu_img_gray.width = image.width;
 			cu_img_gray.height = image.height;
@@ -2578,8 +3274,11 @@ namespace NeuralNetworksLib
 				return -1;
 			}
 
-			PROFILE_TIMER(cu_timer, stat.time_img_DH_copy,
-			cu_img_gray.updateDataHost(true, cu_stream0);)
+			{
+				DetectorProfiler::Span span(profiler, DetectorProfiler::transfer);
+				PROFILE_TIMER(cu_timer, stat.time_img_DH_copy,
+				cu_img_gray.updateDataHost(true, cu_stream0);)
+			}
 			cuERR(cudaEventRecord(cu_event_img_gray, cu_stream0));
 
 			cpu_img_gray = SIMD::Image_32f(
@@ -2594,8 +3293,11 @@ namespace NeuralNetworksLib
 			cl_img_input.height = image.height;
 			cl_img_input.nChannel = image.nChannel;
 
-			PROFILE_TIMER(cl_timer, stat.time_img_HD_copy,
-			cl_img_input.copyData(&image, true);)
+			{
+				DetectorProfiler::Span span(profiler, DetectorProfiler::transfer);
+				PROFILE_TIMER(cl_timer, stat.time_img_HD_copy,
+				cl_img_input.copyData(&image, true);)
+			}
 
 			cl_img_gray.width = image.width;
 			cl_img_gray.height = image.height;
@@ -2617,8 +3319,11 @@ namespace NeuralNetworksLib
 				return -1;
 			}
 
-			PROFILE_TIMER(cl_timer, stat.time_img_DH_copy,
-			cl_img_gray.updateDataHost(true, &cl_event_img_gray);)
+			{
+				DetectorProfiler::Span span(profiler, DetectorProfiler::transfer);
+				PROFILE_TIMER(cl_timer, stat.time_img_DH_copy,
+				cl_img_gray.updateDataHost(true, &cl_event_img_gray);)
+			}
 
 			cpu_img_gray = SIMD::Image_32f(
 				cl_img_gray.width, 
@@ -2630,25 +3335,52 @@ namespace NeuralNetworksLib
 		}
 		else
 		{
-			cpu_img_gray.width = image.width;
-			cpu_img_gray.height = image.height;
-
-			int err = 0;
-			PROFILE_TIMER(cpu_timer_detector, stat.time_cpu_RGBtoGray,
-			if (advanced_param.blur)
+			if (ConvertGrayImage(cpu_img_gray, image) < 0)
 			{
-				err = SIMD::ImageConverter::Img8uToImg32fGRAY_blur(cpu_img_gray, image, col_filter3_kernel(), row_filter3_kernel(), num_threads);
+				return -1;
 			}
-			else
+		}
+
+		return RunDetect(detections);
+	}
+	int CNNDetector::RunDetect(std::vector<Detection>& detections)
+	{
+		DetectorProfiler::Span span(profiler, DetectorProfiler::detect);
+		profiler.addCount(DetectorProfiler::frames);
+
+		if (cpu_img_gray.width != param.max_image_size.width || cpu_img_gray.height != param.max_image_size.height)
+		{
+			num_scales = (int)scales.size();
+		}
+
+		if (advanced_param.tracking && param.pipeline == Pipeline::CPU)
+		{
+			if (cpu_img_gray.width != track_image_size.width || cpu_img_gray.height != track_image_size.height)
 			{
-				err = SIMD::ImageConverter::Img8uToImg32fGRAY(cpu_img_gray, image, num_threads);
-			})
+				track_frame = 0;
+				track_image_size = cpu_img_gray.getSize();
+			}
 
-			if (err < 0)
+			//nothing to track, full scan until an object is found
+			if (track_rect.empty())
 			{
-				printf("[CNNDetector] This type image is not supported!\n");
-				return -1;
+				track_frame = 0;
 			}
+
+			track_active = track_frame % MAX(1, advanced_param.tracking_refresh) != 0;
+			track_frame++;
+		}
+		else
+		{
+			track_active = false;
+		}
+
+		motion_active = param.pipeline == Pipeline::CPU && advanced_param.motion_mask && !advanced_param.tracking && !advanced_param.packet_detection;
+		coarse_active = param.pipeline == Pipeline::CPU && advanced_param.coarse_to_fine && !motion_active && !advanced_param.packet_detection;
+		approx_active = param.pipeline == Pipeline::CPU && !approx_anchor_maps.empty() && !motion_active && !coarse_active;
+		if (motion_active)
+		{
+			UpdateMotionMask();
 		}
 
 		SIMD::mm_erase((void*)data_transfer_flag, int(scales.size() * sizeof(data_transfer_flag[0])));
@@ -2742,7 +3474,17 @@ namespace NeuralNetworksLib
 			*/
 		})
 
+		track_rect.clear();
+
+		DetectorProfiler::Span span_merger(profiler, DetectorProfiler::merger);
+
 		PROFILE_TIMER(cpu_timer_detector, stat.time_post_proc,
+		MergeDetections(detections);)
+
+		return 0;
+	}
+	void CNNDetector::MergeDetections(std::vector<Detection>& detections)
+	{
 		std::reverse_copy(cpu_detect_rect.begin(), cpu_detect_rect.end(), std::back_inserter(gpu_detect_rect));
 
 		if (gpu_detect_rect.size() > 0)
@@ -2750,6 +3492,7 @@ namespace NeuralNetworksLib
 			std::sort(gpu_detect_rect.begin(), gpu_detect_rect.end(), [](Detection& a, Detection& b) { return b.scale < a.scale; });
 
 			PROFILE_COUNTER_ADD(stat.num_detections_raw, gpu_detect_rect.size())
+			profiler.addCount(DetectorProfiler::detections_raw, (long long)gpu_detect_rect.size());
 			if (advanced_param.merger_detect)
 			{
 				std::vector<Detection> detections_temp = detections;
@@ -2779,6 +3522,15 @@ namespace NeuralNetworksLib
 				std::copy(gpu_detect_rect.begin(), gpu_detect_rect.end(), detections.begin());
 			}
 			PROFILE_COUNTER_ADD(stat.num_detections_result, detections.size())
+			profiler.addCount(DetectorProfiler::detections_result, (long long)detections.size());
+
+			if (advanced_param.tracking)
+			{
+				for (auto it = detections.begin(); it != detections.end(); ++it)
+				{
+					track_rect.push_back(it->rect);
+				}
+			}
 
 			if (cpu_input_img_resizer != nullptr)
 			{
@@ -2807,10 +3559,195 @@ namespace NeuralNetworksLib
 
 			cpu_detect_rect.clear();
 			gpu_detect_rect.clear();
-		})
+		}
+	}
+	std::future<CNNDetector::AsyncResult> CNNDetector::DetectAsync(SIMD::Image_8u& image, AsyncCallback callback)
+	{
+		std::promise<AsyncResult> promise;
+		std::future<AsyncResult> future = promise.get_future();
 
-		return 0;
+		//reinitialization is not allowed while frames are in flight, other pipelines run synchronously
+		if (isEmpty() || param.pipeline != Pipeline::CPU ||
+			image.width > param.max_image_size.width || image.height > param.max_image_size.height ||
+			(advanced_param.gray_image_only && cpu_input_img_resizer != nullptr && image.nChannel != 1))
+		{
+			WaitAsync();
+		}
+
+		//spans of the calling thread belong to this frame, the worker makes it current when detection starts
+		const int trace_frame = profiler.newFrame();
+
+		//packet buffers are used by the frame in flight, they are reallocated on the worker thread
+		//gray_image_only resize goes to the slot of the frame, other detector state is left to the worker
+		AsyncResult result;
+		Size packet_size;
+		result.err = PrepareImage(image, &packet_size, trace_frame, false);
+		const bool resize_input = advanced_param.gray_image_only && cpu_input_img_resizer != nullptr;
+		if (result.err <= 0 || param.pipeline != Pipeline::CPU)
+		{
+			if (result.err > 0)
+			{
+				profiler.setFrame(trace_frame);
+				if (resize_input)
+				{
+					ResizeInputImage(cpu_input_img, image, trace_frame);
+					image.clone(cpu_input_img);
+				}
+				if (packet_size.width > 0 && PacketReallocate(packet_size) < 0)
+				{
+					printf("[CNNDetector] Packet buffers no initialized!\n");
+					result.err = -1;
+				}
+				else
+				{
+					result.err = DetectImage(result.detections, image);
+				}
+			}
+
+			if (callback) callback(result);
+			promise.set_value(std::move(result));
+			return future;
+		}
+
+		//wait for free gray image buffer
+		int slot = -1;
+		{
+			std::unique_lock<std::mutex> lock(async_mutex);
+			async_cv.wait(lock, [this] { return async_free_slot.size() > 0; });
+			slot = async_free_slot.back();
+			async_free_slot.pop_back();
+		}
+
+		SIMD::Image_32f& img_gray = async_img_gray[slot];
+		if (img_gray.isEmpty())
+		{
+			img_gray = SIMD::Image_32f(
+				param.max_image_size.width,
+				param.max_image_size.height,
+				roundUpMul(param.max_image_size.width + 1, REG_SIZE),
+				ALIGN_DEF);
+		}
+
+		SIMD::Image_8u img_input;
+		img_input.clone(image);
+		if (resize_input)
+		{
+			if (async_img_input[slot].isEmpty())
+			{
+				const Size input_size = param.max_image_size * cpu_input_img_scale;
+				async_img_input[slot] = SIMD::Image_8u(input_size.width, input_size.height, ALIGN_DEF, false);
+			}
+			ResizeInputImage(async_img_input[slot], image, trace_frame);
+			img_input.clone(async_img_input[slot]);
+		}
+
+		if (ConvertGrayImage(img_gray, img_input, trace_frame) < 0)
+		{
+			{
+				std::lock_guard<std::mutex> lock(async_mutex);
+				async_free_slot.push_back(slot);
+			}
+			async_cv.notify_all();
+
+			result.err = -1;
+			if (callback) callback(result);
+			promise.set_value(std::move(result));
+			return future;
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(async_mutex);
+			if (!async_worker.joinable())
+			{
+				async_exit = false;
+				async_worker = std::thread(&CNNDetector::RunAsyncWorker, this);
+			}
+
+			AsyncFrame frame;
+			frame.slot = slot;
+			frame.packet_size = packet_size;
+			frame.trace_frame = trace_frame;
+			frame.promise = std::move(promise);
+			frame.callback = callback;
+			async_queue.push_back(std::move(frame));
+			async_num_frames++;
+		}
+		async_cv.notify_all();
+
+		return future;
+	}
+	void CNNDetector::RunAsyncWorker()
+	{
+		for (;;)
+		{
+			AsyncFrame frame;
+			{
+				std::unique_lock<std::mutex> lock(async_mutex);
+				async_cv.wait(lock, [this] { return async_exit || async_queue.size() > 0; });
+				if (async_queue.size() == 0) return;
+
+				frame = std::move(async_queue.front());
+				async_queue.pop_front();
+			}
+
+			//gray image of the frame becomes the working buffer of the detector
+			AsyncResult result;
+			profiler.setFrame(frame.trace_frame);
+			PROFILE_COUNTER_INC(stat.num_call_detect)
+			if (frame.packet_size.width > 0 && PacketReallocate(frame.packet_size) < 0)
+			{
+				printf("[CNNDetector] Packet buffers no initialized!\n");
+				result.err = -1;
+			}
+			else
+			{
+				SwapImage(cpu_img_gray, async_img_gray[frame.slot]);
+				result.err = RunDetect(result.detections);
+				SwapImage(cpu_img_gray, async_img_gray[frame.slot]);
+			}
+
+			{
+				std::lock_guard<std::mutex> lock(async_mutex);
+				async_free_slot.push_back(frame.slot);
+			}
+			async_cv.notify_all();
+
+			if (frame.callback) frame.callback(result);
+			frame.promise.set_value(std::move(result));
+
+			{
+				std::lock_guard<std::mutex> lock(async_mutex);
+				async_num_frames--;
+			}
+			async_cv.notify_all();
+		}
+	}
+	void CNNDetector::WaitAsync()
+	{
+		std::unique_lock<std::mutex> lock(async_mutex);
+		async_cv.wait(lock, [this] { return async_num_frames == 0; });
 	}
+	void CNNDetector::StopAsync()
+	{
+		{
+			std::lock_guard<std::mutex> lock(async_mutex);
+			async_exit = true;
+		}
+		async_cv.notify_all();
+
+		if (async_worker.joinable())
+		{
+			async_worker.join();
+		}
+	}
+	void CNNDetector::SwapImage(SIMD::Image_32f& img_1, SIMD::Image_32f& img_2)
+	{
+		SIMD::Image_32f img_temp;
+		img_temp = img_1;
+		img_1 = img_2;
+		img_2 = img_temp;
+	}
+
 	void CNNDetector::Merger(std::vector<Detection>& detections, std::vector<Detection>& rect, float threshold, bool del)
 	{
 		std::vector<int> X(4);
@@ -54,12 +54,19 @@
 #endif
 
 #include "packing_2D.h"
+#include "cnn_detector_profiler.h"
 
 #include <vector>
 #include <iterator>
 #include <list>
+#include <deque>
 #include <sstream>
 #include <fstream>
+#include <functional>
+#include <future>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
 
 #if defined(_MSC_VER)
 #	include <windows.h>
@@ -121,6 +128,21 @@ namespace NeuralNetworksLib
 			int min_neighbors = 2;
 			int num_threads = 0;
 		};
+		struct ScaleRegion
+		{
+			//image region (row band for fixed cameras) and face size range allowed in it
+			Rect rect;
+			Size min_obj_size = Size(0, 0);
+			Size max_obj_size = Size(0, 0);
+
+			ScaleRegion() { }
+			ScaleRegion(Rect _rect, Size _min_obj_size, Size _max_obj_size = Size(0, 0))
+			{
+				rect = _rect;
+				min_obj_size = _min_obj_size;
+				max_obj_size = _max_obj_size;
+			}
+		};
 		struct AdvancedParam
 		{
 		public:
@@ -157,6 +179,43 @@ namespace NeuralNetworksLib
 			bool uniform_noise = false;
 			bool merger_detect = true;
 
+			//region (CPU pipeline only, empty - scan full image at all scales)
+			std::vector<ScaleRegion> scale_regions;
+
+			//video (CPU pipeline only)
+			bool tracking = false;
+			int tracking_refresh = 15;		//full scan every N frames
+			int tracking_sweep_scales = 0;	//number of smallest scales scanned on every frame
+			float tracking_expand = 0.5f;	//search window around previous detection
+			bool motion_mask = false;		//stage-1 only on changed blocks for static cameras
+			int motion_block = 16;
+			float motion_threshold = 6.f;	//mean absolute difference of gray level in block
+			int motion_refresh = 30;		//full stage-1 every N frames
+
+			//coarse-to-fine (CPU pipeline only): stage 1 on every other scale first,
+			//remaining scales only around responses of neighbouring coarse scales
+			bool coarse_to_fine = false;
+			float coarse_treshold = -1.f;	//looser threshold of stage 1 on coarse scales
+			float coarse_expand = 0.75f;	//search window around coarse response, in window sizes
+			float coarse_max_area = 0.5f;	//share of scale above which it is computed in full
+
+			//approximate feature pyramid (CPU pipeline only): layers 1-2 of stage 1 are computed on anchor scales only,
+			//intermediate scales resample layer 2 maps of the nearest larger anchor
+			bool approx_pyramid = false;
+			int approx_step = 0;			//scales per anchor, 0 - one octave
+
+			//Winograd F(2x2, 3x3) for 3x3 conv layers of float CNTK models (CPU pipeline only):
+			//bit l of winograd_layers[i] - conv layer l + 1 of stage i + 1
+			int winograd_layers[3];
+
+			//generated conv + lrelu + bn (+ max pool) kernels of float CNTK models (CPU pipeline only, SIMD::ConvTemplate):
+			//bit l of template_layers[i] - conv layer l + 1 of stage i + 1, layers without direct kernels use them anyway
+			int template_layers[3];
+
+			//int8 conv layers of format 1.2 models of stage i + 1 (CPU pipeline of AVX2 builds only), otherwise their float weights are used;
+			//int8 models are opt-in
+			bool int8_models[3];
+
 			std::string path_model[4];
 			int index_output[4];
 
@@ -171,6 +230,18 @@ namespace NeuralNetworksLib
 				index_output[1] = 0;
 				index_output[2] = 0;
 				index_output[3] = -1;
+
+				winograd_layers[0] = 0;
+				winograd_layers[1] = 0;
+				winograd_layers[2] = 0;
+
+				template_layers[0] = 0;
+				template_layers[1] = 0;
+				template_layers[2] = 0;
+
+				int8_models[0] = false;
+				int8_models[1] = false;
+				int8_models[2] = false;
 			}
 		};
 
@@ -215,7 +286,23 @@ namespace NeuralNetworksLib
 			bool isCheck() { return checked; }
 		};
 
+		struct AsyncResult
+		{
+			int err = 0;
+			std::vector<Detection> detections;
+		};
+		typedef std::function<void(AsyncResult&)> AsyncCallback;
+
 	private:
+		struct AsyncFrame
+		{
+			int slot = 0;
+			Size packet_size;
+			int trace_frame = 0;
+			std::promise<AsyncResult> promise;
+			AsyncCallback callback;
+		};
+
 		struct PackPos
 		{
 			int scl = 0;
@@ -324,11 +411,46 @@ namespace NeuralNetworksLib
 
 		std::vector<float> scales;
 		int num_scales = 0;
+		std::vector<Rect> scale_roi;
+
+		int track_frame = 0;
+		bool track_active = false;
+		Size track_image_size;
+		std::vector<Rect> track_rect;
+
+		int motion_frame = 0;
+		bool motion_active = false;
+		bool motion_refresh_frame = false;
+		SIMD::Image_32f motion_prev_gray;
+		Size motion_grid;
+		std::vector<char> motion_dirty;
+
+		bool coarse_active = false;
+		std::vector<char> coarse_done;
+
+		bool approx_active = false;
+		int approx_step = 1;
+		std::vector<char> approx_done;
+		std::vector<SIMD::Image_32f> approx_anchor_maps;
+		SIMD::Image_32f approx_maps;
+
+		//double-buffered gray images of frames in flight (CPU pipeline), with their gray_image_only resize buffers
+		SIMD::Image_32f async_img_gray[2];
+		SIMD::Image_8u async_img_input[2];
+		std::vector<int> async_free_slot = { 0, 1 };
+		std::deque<AsyncFrame> async_queue;
+		int async_num_frames = 0;
+		bool async_exit = false;
+		std::thread async_worker;
+		std::mutex async_mutex;
+		std::condition_variable async_cv;
 
 		int num_threads = 0; //OpenMP only
 
 		Packing2D packing2D;
+		Packing2D::Layout pack_layout;
 		Size pack_size;
+		Size pack_capacity;
 		std::vector<Rect> pack;
 
 		std::vector<Detection> cpu_detect_rect;
@@ -342,6 +464,8 @@ namespace NeuralNetworksLib
 		int ext_pattern_offset = 0;		//15;
 		int x_pattern_offset = 0;		//4;
 
+		DetectorProfiler profiler;
+
 		SIMD::Array_32f col_filter3_kernel;
 		SIMD::Array_32f row_filter3_kernel;
 
@@ -373,11 +497,40 @@ namespace NeuralNetworksLib
 		inline void CPUCheckDetect(std::vector<Detection>& rect, const int rect_size, const Point& point, const float score0,
 									const SIMD::Image_32f& img, const float scale, const int mod = 0, const int pack_id = 0);
 
+		bool GetScaleROI(Rect& roi, const int scl, const Size& img_size) const;
+		bool GetTrackROI(Rect& roi, const int scl) const;
+		void UpdateMotionMask();
+		void GetMotionROI(std::vector<Rect>& rois, const int scl, const Rect& roi) const;
+		void CPUMotionForward(const int scl, const Rect& roi, const Size& img_resize);
+		inline bool IsCoarseScale(const int scl) const { return scl % 2 == 1 || (int)scales.size() == 1; }
+		bool GetCoarseROI(std::vector<Rect>& rois, const int scl, const Rect& roi) const;
+		void ResetResponseMap(const int scl, const Size& img_resize);
+		void CPUForwardROI(const int scl, const std::vector<Rect>& rois);
+		inline bool IsAnchorScale(const int scl) const { return scl % approx_step == 0; }
+		bool CPUApproxForward(const int scl, const Rect& roi, const Size& img_resize);
+
+		//packet_size != nullptr: packet buffers are not reallocated, packet_size is the size to reallocate them for (0 x 0 if not needed),
+		//trace_frame: frame of profiler spans if the frame is not current (DetectAsync), -1 - current frame
+		//resize_input: gray_image_only resize into cpu_input_img, DetectAsync resizes into its slot with ResizeInputImage
+		int PrepareImage(SIMD::Image_8u& image, Size* packet_size = nullptr, int trace_frame = -1, bool resize_input = true);
+		void ResizeInputImage(SIMD::Image_8u& img_input, SIMD::Image_8u& image, int trace_frame = -1);
+		int ConvertGrayImage(SIMD::Image_32f& img_gray, SIMD::Image_8u& image, int trace_frame = -1);
+		int DetectImage(std::vector<Detection>& detections, SIMD::Image_8u& image);
+		int RunDetect(std::vector<Detection>& detections);
+		void MergeDetections(std::vector<Detection>& detections);
+
+		void RunAsyncWorker();
+		void StopAsync();
+		static void SwapImage(SIMD::Image_32f& img_1, SIMD::Image_32f& img_2);
+
 		int PacketReallocate(Size size);
 		void PacketCPUCheckDetect();
 
 		bool DropDetection(Rect& new_rect, std::vector<Detection>& detect_rect_in, std::vector<Detection>& detect_rect_out, float scale);
 		
+		void CollectResponses(std::vector<std::pair<Point, float>>& detect_point, std::vector<Detection>& detect_rect, 
+			const SIMD::Image_32f& response_map, const Point& roi_offset, const int scl);
+		void CheckDetectPoints(std::vector<Detection>& detect_rect, std::vector<std::pair<Point, float>>& detect_point, const SIMD::Image_32f& img_gray, const int scl);
 		void RunCheckDetect(const int scl, const int device);
 		void RunCheckDetectAsync();
 
@@ -395,6 +548,15 @@ namespace NeuralNetworksLib
 		bool isEmpty() const;
 		
 		int Detect(std::vector<Detection>& detections, SIMD::Image_8u& image);
+
+		//CPU pipeline: image is converted to gray (and resized if gray_image_only) into one of two buffers on the calling thread,
+		//detection runs on the worker thread, up to two frames are in flight
+		//limitation: only gray conversion of the next frame overlaps detection of the current one, pyramid building
+		//and stages 1-3 are not pipelined, they run frame by frame on the worker;
+		//frames which reinitialize the detector (larger image, gray_image_only with color image) wait for the frames in flight;
+		//other pipelines run synchronously
+		std::future<AsyncResult> DetectAsync(SIMD::Image_8u& image, AsyncCallback callback = nullptr);
+		void WaitAsync();
 		void NMS(std::vector<Detection>& detections, std::vector<Detection>& rect)
 		{
 			Merger(detections, rect);
@@ -435,9 +597,14 @@ namespace NeuralNetworksLib
 			param.max_obj_size = _max_obj_size;
 		}
 
+		DetectorProfiler& getProfiler() { return profiler; }
+		const Packing2D::Layout& getPacketLayout() const { return pack_layout; }
+
 		int  getNumThreads() const { return num_threads; }
 		void setNumThreads(int _num_threads);
 
+		void ResetTracking() { track_frame = 0; }
+
 		int getGrayImage(SIMD::Image_32f* image) const;
 #ifdef USE_CUDA
 		int getGrayImage(CUDA::Image_32f_pinned* image) const;
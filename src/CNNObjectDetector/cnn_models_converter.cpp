@@ -19,9 +19,13 @@
 
 
 #include "cnn_models_converter.h"
+#include "cnn_simd_cntk.h"
+#include "image_resize.h"
+
 #include <fstream>
 #include <sstream>
 #include <iterator>
+#include <cmath>
 
 
 //================================================================================================================================================
@@ -74,6 +78,18 @@ namespace NeuralNetworksLib
 		cnn.snn_ol_neuron_count = 0;
 
 		cnn.snn_ol_bias.clear();
+
+		//int8 layers
+		Layer_filter* conv_l[3] = { &cnn.conv_l1, &cnn.conv_l2, &cnn.conv_l3 };
+		for (int l = 0; l < 3; ++l)
+		{
+			conv_l[l]->q8_in_scale = 0.f;
+			conv_l[l]->q8_zero_point = 0;
+			conv_l[l]->q8_kernel_scale.clear();
+			conv_l[l]->q8_kernels.clear();
+		}
+		cnn.quantized = false;
+		cnn.calibrated = false;
 	}
 
 	void CNNModelsConverter::ParserDump(std::vector<float>& param, std::vector<std::string>& dump, std::string l_name, std::string p_name, int idx)
@@ -615,8 +631,14 @@ namespace NeuralNetworksLib
 
 		if (!file_bin.is_open()) return;
 
+		WriteBinary(file_bin, cnn.quantized);
+
+		file_bin.close();
+	}
+	void CNNModelsConverter::WriteBinary(std::ostream& file_bin, bool int8_layers)
+	{
 		//version
-		float format_version = 1.1f;
+		float format_version = int8_layers ? 1.2f : 1.1f;
 		FB_WRITE(file_bin, format_version);
 
 		//max pool
@@ -740,8 +762,525 @@ namespace NeuralNetworksLib
 
 		FB_WRITE(file_bin, cnn.snn_ol_tanh_w);
 
+		//int8 conv layers
+		if (int8_layers)
+		{
+			Layer_filter* conv_l[3] = { &cnn.conv_l1, &cnn.conv_l2, &cnn.conv_l3 };
+			for (int l = 0; l < cnn.layer_count; ++l)
+			{
+				FB_WRITE(file_bin, conv_l[l]->q8_in_scale);
+				FB_WRITE(file_bin, conv_l[l]->q8_zero_point);
+				for (int i = 0; i < cnn.layer_buffer[l].map_count; ++i)
+				{
+					FB_WRITE(file_bin, conv_l[l]->q8_kernel_scale[i]);
+					for (int j = 0; j < conv_l[l]->size.size; ++j)
+					{
+						FB_WRITE(file_bin, conv_l[l]->q8_kernels[i][j]);
+					}
+				}
+			}
+		}
+	}
+
+	void CNNModelsConverter::SaveToGraphFile(std::string file_name)
+	{
+		if (file_name == "" || isEmpty()) return;
+
+		if (cnn.quantized)
+		{
+			printf("[CNNModelsConverter] Layer graph of int8 model is not supported!\n");
+			return;
+		}
+
+		if (file_name.find(".bin") == std::string::npos)
+		{
+			file_name.append(".bin");
+		}
+
+		std::fstream file_bin;
+		file_bin.open(file_name.c_str(), std::fstream::binary | std::fstream::out);
+
+		if (!file_bin.is_open()) return;
+
+		const float one = 1.f;
+		const float half = 0.5f;
+		const float zero = 0.f;
+		const int pool_size = 2;
+
+		//version
+		const float format_version = 2.0f;
+		FB_WRITE(file_bin, format_version);
+
+		//min input_image, input maps, layers
+		const int input_maps = 1;
+		const int layer_count = 4 + 4 + 3 + 4 + 3;
+		FB_WRITE(file_bin, cnn.min_image_size.width);
+		FB_WRITE(file_bin, cnn.min_image_size.height);
+		FB_WRITE(file_bin, input_maps);
+		FB_WRITE(file_bin, layer_count);
+
+		//conv l1 - l3: conv + lrelu + bn (bn weight is folded into lrelu) + max pool of layers 1, 2
+		Layer_filter* conv_l[3] = { &cnn.conv_l1, &cnn.conv_l2, &cnn.conv_l3 };
+		for (int l = 0; l < 3; ++l)
+		{
+			const int maps = cnn.layer_buffer[l].map_count;
+			const int connection = l == 0 ? LayerGraph::ConvFull : LayerGraph::ConvNeighbours;
+
+			int type = LayerGraph::Conv;
+			FB_WRITE(file_bin, type);
+			FB_WRITE(file_bin, maps);
+			FB_WRITE(file_bin, conv_l[l]->size.cols);
+			FB_WRITE(file_bin, conv_l[l]->size.rows);
+			FB_WRITE(file_bin, connection);
+			for (int i = 0; i < maps; ++i)
+			{
+				for (int j = 0; j < conv_l[l]->size.size; ++j)
+				{
+					FB_WRITE(file_bin, conv_l[l]->kernels[i][j]);
+				}
+			}
+			for (int i = 0; i < maps; ++i)
+			{
+				FB_WRITE(file_bin, cnn.conv_bias[l][i]);
+			}
+
+			type = LayerGraph::LeakyReLU;
+			FB_WRITE(file_bin, type);
+			for (int i = 0; i < maps; ++i)
+			{
+				FB_WRITE(file_bin, cnn.leakyReLU_w1[l][i]);
+			}
+			for (int i = 0; i < maps; ++i)
+			{
+				FB_WRITE(file_bin, cnn.leakyReLU_w2[l][i]);
+			}
+
+			type = LayerGraph::BatchNorm;
+			FB_WRITE(file_bin, type);
+			for (int i = 0; i < maps; ++i)
+			{
+				FB_WRITE(file_bin, one);
+			}
+			for (int i = 0; i < maps; ++i)
+			{
+				FB_WRITE(file_bin, cnn.bn_bias[l][i]);
+			}
+
+			if (l < 2)
+			{
+				type = LayerGraph::MaxPool;
+				FB_WRITE(file_bin, type);
+				FB_WRITE(file_bin, pool_size);
+			}
+		}
+
+		//hidden layer: neuron n = hl_scale * i + t of maps i, .., i + snn_connect_count - 1 of layer 3 (as Run_HL), 0.5 tanh + 0.5 and bn of t
+		const int maps = cnn.layer_buffer[2].map_count;
+		const int hl_group = cnn.snn_hl_size / cnn.hl_scale;
+
+		int type = LayerGraph::Dense;
+		FB_WRITE(file_bin, type);
+		FB_WRITE(file_bin, cnn.snn_hl_size);
+		for (int n = 0; n < cnn.snn_hl_size; ++n)
+		{
+			const int i = n / cnn.hl_scale;
+			for (int j = 0; j < maps; ++j)
+			{
+				const float w = j >= i && j < i + cnn.snn_connect_count ? cnn.snn_hl_weight[n][j - i] : 0.f;
+				FB_WRITE(file_bin, w);
+			}
+		}
+		for (int n = 0; n < cnn.snn_hl_size; ++n)
+		{
+			FB_WRITE(file_bin, cnn.snn_hl_bias[n]);
+		}
+
+		type = LayerGraph::Tanh;
+		FB_WRITE(file_bin, type);
+		for (int n = 0; n < cnn.snn_hl_size; ++n)
+		{
+			FB_WRITE(file_bin, cnn.snn_hl_tanh_w[n / cnn.hl_scale]);
+		}
+
+		type = LayerGraph::BatchNorm;
+		FB_WRITE(file_bin, type);
+		for (int n = 0; n < 2 * cnn.snn_hl_size; ++n)
+		{
+			FB_WRITE(file_bin, half);
+		}
+
+		FB_WRITE(file_bin, type);
+		for (int n = 0; n < cnn.snn_hl_size; ++n)
+		{
+			FB_WRITE(file_bin, cnn.snn_hl_bn_weight[n % cnn.hl_scale]);
+		}
+		for (int n = 0; n < cnn.snn_hl_size; ++n)
+		{
+			FB_WRITE(file_bin, cnn.snn_hl_bn_bias[n % cnn.hl_scale]);
+		}
+
+		//output layer: weight of hidden neuron hl_scale * i + t is snn_ol_weight[t * (hl_size / hl_scale) + i],
+		//af_scale * tanh or 0.5 tanh + 0.5 (af_scale = 0)
+		const float af_scale = fabsf(cnn.af_scale);
+
+		type = LayerGraph::Dense;
+		FB_WRITE(file_bin, type);
+		FB_WRITE(file_bin, cnn.snn_ol_neuron_count);
+		for (int k = 0; k < cnn.snn_ol_neuron_count; ++k)
+		{
+			for (int n = 0; n < cnn.snn_hl_size; ++n)
+			{
+				FB_WRITE(file_bin, cnn.snn_ol_weight[k][(n % cnn.hl_scale) * hl_group + n / cnn.hl_scale]);
+			}
+		}
+		for (int k = 0; k < cnn.snn_ol_neuron_count; ++k)
+		{
+			FB_WRITE(file_bin, cnn.snn_ol_bias[k]);
+		}
+
+		type = LayerGraph::Tanh;
+		FB_WRITE(file_bin, type);
+		for (int k = 0; k < cnn.snn_ol_neuron_count; ++k)
+		{
+			FB_WRITE(file_bin, cnn.snn_ol_tanh_w);
+		}
+
+		type = LayerGraph::BatchNorm;
+		FB_WRITE(file_bin, type);
+		const float ol_bn_weight = af_scale != 0.f ? af_scale : half;
+		const float ol_bn_bias = af_scale != 0.f ? zero : half;
+		for (int k = 0; k < cnn.snn_ol_neuron_count; ++k)
+		{
+			FB_WRITE(file_bin, ol_bn_weight);
+		}
+		for (int k = 0; k < cnn.snn_ol_neuron_count; ++k)
+		{
+			FB_WRITE(file_bin, ol_bn_bias);
+		}
+
+		//scale of output selected alone, output 0 is negated (index_output of SIMD::ConvNeuralNetwork)
+		for (int k = 0; k < cnn.snn_ol_neuron_count; ++k)
+		{
+			const float select_scale = k == 0 && af_scale != 0.f ? -one : one;
+			FB_WRITE(file_bin, select_scale);
+		}
+
 		file_bin.close();
 	}
 
+	void CNNModelsConverter::LoadBinaryModel(std::string file_name)
+	{
+		Clear();
+
+		std::stringstream data_bin;
+		if (file_name.size() < 255)
+		{
+			std::fstream file_bin;
+			file_bin.open(file_name.c_str(), std::fstream::binary | std::fstream::in);
+
+			if (!file_bin.is_open())
+			{
+				printf("[CNNModelsConverter] Configuration file not found!\n");
+				return;
+			}
+
+			data_bin << file_bin.rdbuf();
+			file_bin.close();
+		}
+		else
+		{
+			data_bin << file_name;
+		}
+
+		//version
+		float format_version = 0.0f;
+		FB_READ(data_bin, format_version);
+
+		if (format_version < 1.0f || format_version > 1.2f)
+		{
+			printf("[CNNModelsConverter] Configuration file format is not supported!\n");
+			return;
+		}
+
+		//max pool
+		FB_READ(data_bin, cnn.max_pool);
+
+		//min input size
+		FB_READ(data_bin, cnn.min_image_size.width);
+		FB_READ(data_bin, cnn.min_image_size.height);
+
+		//cnn_layers
+		FB_READ(data_bin, cnn.layer_count);
+		if (cnn.layer_count != 3)
+		{
+			printf("[CNNModelsConverter] Configuration file is corrupted!\n");
+			cnn.min_image_size = Size(0, 0);
+			return;
+		}
+
+		cnn.layer_buffer.resize(cnn.layer_count);
+		for (int i = 0; i < cnn.layer_count; ++i)
+		{
+			FB_READ(data_bin, cnn.layer_buffer[i].map_count);
+		}
+
+		//conv kernels
+		Layer_filter* conv_l[3] = { &cnn.conv_l1, &cnn.conv_l2, &cnn.conv_l3 };
+		for (int l = 0; l < cnn.layer_count; ++l)
+		{
+			int kernel_width = 0;
+			int kernel_height = 0;
+			FB_READ(data_bin, kernel_width);
+			FB_READ(data_bin, kernel_height);
+
+			conv_l[l]->size = Size2d(kernel_width, kernel_height);
+			conv_l[l]->kernels.resize(cnn.layer_buffer[l].map_count);
+			for (int i = 0; i < cnn.layer_buffer[l].map_count; ++i)
+			{
+				conv_l[l]->kernels[i] = Array_32f(conv_l[l]->size.size, ALIGN_DEF);
+				for (int j = 0; j < conv_l[l]->size.size; ++j)
+				{
+					FB_READ(data_bin, conv_l[l]->kernels[i][j]);
+				}
+			}
+		}
+
+		//conv nn weight
+		FB_READ(data_bin, cnn.af_scale);
+
+		cnn.conv_bias.resize(cnn.layer_count);
+		cnn.leakyReLU_w1.resize(cnn.layer_count);
+		cnn.leakyReLU_w2.resize(cnn.layer_count);
+		cnn.bn_weight.resize(cnn.layer_count);
+		cnn.bn_bias.resize(cnn.layer_count);
+		for (int i = 0; i < cnn.layer_count; ++i)
+		{
+			const int map_count = cnn.layer_buffer[i].map_count;
+			cnn.conv_bias[i] = Array_32f(map_count, ALIGN_DEF);
+			cnn.leakyReLU_w1[i] = Array_32f(map_count, ALIGN_DEF);
+			cnn.leakyReLU_w2[i] = Array_32f(map_count, ALIGN_DEF);
+			cnn.bn_weight[i] = Array_32f(map_count, ALIGN_DEF);
+			cnn.bn_bias[i] = Array_32f(map_count, ALIGN_DEF);
+			for (int j = 0; j < map_count; ++j)
+			{
+				FB_READ(data_bin, cnn.conv_bias[i][j]);
+				FB_READ(data_bin, cnn.leakyReLU_w1[i][j]);
+				FB_READ(data_bin, cnn.leakyReLU_w2[i][j]);
+				FB_READ(data_bin, cnn.bn_weight[i][j]);
+				FB_READ(data_bin, cnn.bn_bias[i][j]);
+			}
+		}
+
+		//simple nn weight
+		FB_READ(data_bin, cnn.snn_full_connect);
+		FB_READ(data_bin, cnn.snn_hl_size);
+		FB_READ(data_bin, cnn.snn_connect_count);
+		FB_READ(data_bin, cnn.hl_scale);
+		if (cnn.snn_hl_size <= 0 || cnn.hl_scale <= 0)
+		{
+			printf("[CNNModelsConverter] Configuration file is corrupted!\n");
+			cnn.min_image_size = Size(0, 0);
+			return;
+		}
+
+		const int hl_connect_count = cnn.snn_full_connect ? cnn.layer_buffer[cnn.layer_count - 1].map_count : cnn.snn_connect_count;
+		cnn.snn_hl_weight.resize(cnn.snn_hl_size);
+		for (int i = 0; i < cnn.snn_hl_size; ++i)
+		{
+			cnn.snn_hl_weight[i] = Array_32f(hl_connect_count, ALIGN_DEF);
+			for (int j = 0; j < hl_connect_count; ++j)
+			{
+				FB_READ(data_bin, cnn.snn_hl_weight[i][j]);
+			}
+		}
+
+		cnn.snn_hl_bias = Array_32f(cnn.snn_hl_size, ALIGN_DEF);
+		for (int i = 0; i < cnn.snn_hl_size; ++i)
+		{
+			FB_READ(data_bin, cnn.snn_hl_bias[i]);
+		}
+
+		cnn.snn_hl_tanh_w = Array_32f(cnn.snn_hl_size / cnn.hl_scale, ALIGN_DEF);
+		for (int i = 0; i < (cnn.snn_hl_size / cnn.hl_scale); ++i)
+		{
+			FB_READ(data_bin, cnn.snn_hl_tanh_w[i]);
+		}
+
+		cnn.snn_hl_bn_weight = Array_32f(cnn.hl_scale, ALIGN_DEF);
+		cnn.snn_hl_bn_bias = Array_32f(cnn.hl_scale, ALIGN_DEF);
+		for (int i = 0; i < cnn.hl_scale; ++i)
+		{
+			FB_READ(data_bin, cnn.snn_hl_bn_weight[i]);
+			FB_READ(data_bin, cnn.snn_hl_bn_bias[i]);
+		}
+
+		FB_READ(data_bin, cnn.snn_ol_neuron_count);
+		cnn.snn_ol_weight.resize(cnn.snn_ol_neuron_count);
+		for (int i = 0; i < cnn.snn_ol_neuron_count; ++i)
+		{
+			cnn.snn_ol_weight[i] = Array_32f(cnn.snn_hl_size, ALIGN_DEF);
+			for (int j = 0; j < cnn.snn_hl_size; ++j)
+			{
+				FB_READ(data_bin, cnn.snn_ol_weight[i][j]);
+			}
+		}
+
+		cnn.snn_ol_bias = Array_32f(cnn.snn_ol_neuron_count, ALIGN_DEF);
+		for (int i = 0; i < cnn.snn_ol_neuron_count; ++i)
+		{
+			FB_READ(data_bin, cnn.snn_ol_bias[i]);
+		}
+
+		FB_READ(data_bin, cnn.snn_ol_tanh_w);
+
+		//int8 conv layers
+		if (format_version > 1.1f)
+		{
+			for (int l = 0; l < cnn.layer_count; ++l)
+			{
+				FB_READ(data_bin, conv_l[l]->q8_in_scale);
+				FB_READ(data_bin, conv_l[l]->q8_zero_point);
+
+				conv_l[l]->q8_kernel_scale.resize(cnn.layer_buffer[l].map_count);
+				conv_l[l]->q8_kernels.resize(cnn.layer_buffer[l].map_count);
+				for (int i = 0; i < cnn.layer_buffer[l].map_count; ++i)
+				{
+					FB_READ(data_bin, conv_l[l]->q8_kernel_scale[i]);
+					conv_l[l]->q8_kernels[i].resize(conv_l[l]->size.size);
+					for (int j = 0; j < conv_l[l]->size.size; ++j)
+					{
+						FB_READ(data_bin, conv_l[l]->q8_kernels[i][j]);
+					}
+				}
+			}
+			cnn.quantized = true;
+		}
+
+		if (!data_bin)
+		{
+			printf("[CNNModelsConverter] Configuration file is corrupted!\n");
+			Clear();
+		}
+	}
+
+	void CNNModelsConverter::Calibrate(std::vector<Image_32f>& images, float scale_factor, int num_threads)
+	{
+		if (isEmpty() || images.empty()) return;
+
+		//float network of current model
+		std::stringstream data_bin;
+		WriteBinary(data_bin, false);
+
+		SIMD::ConvNeuralNetwork cnn_float;
+		cnn_float.Init(data_bin.str());
+		if (cnn_float.isEmpty())
+		{
+			printf("[CNNModelsConverter] Float model is not initialized!\n");
+			return;
+		}
+
+		Size max_image_size(0, 0);
+		for (auto image = images.begin(); image != images.end(); ++image)
+		{
+			max_image_size.width = MAX(max_image_size.width, image->width);
+			max_image_size.height = MAX(max_image_size.height, image->height);
+		}
+
+		cnn_float.AllocateMemory(max_image_size);
+		cnn_float.setNumThreads(num_threads);
+		cnn_float.setCalibration(true);
+
+		const Size min_image_size = cnn_float.getMinInputImgSize();
+		scale_factor = MAX(1.01f, scale_factor);
+
+		//ranges over image pyramids
+		SIMD::ImageResizer resizer;
+		for (auto image = images.begin(); image != images.end(); ++image)
+		{
+			for (float scale = 1.f; ; scale *= scale_factor)
+			{
+				const Size size(int((float)image->width / scale), int((float)image->height / scale));
+				if (size.width < min_image_size.width || size.height < min_image_size.height) break;
+
+				Image_32f response_map;
+				if (size.width == image->width && size.height == image->height)
+				{
+					cnn_float.Forward(response_map, *image);
+				}
+				else
+				{
+					Image_32f img_resize(size.width, size.height, ALIGN_DEF, true);
+					resizer.FastImageResize(img_resize, *image, 1, num_threads);
+					cnn_float.Forward(response_map, img_resize);
+				}
+			}
+		}
+
+		for (int l = 0; l < cnn.layer_count; ++l)
+		{
+			float min_val = 0.f;
+			float max_val = 0.f;
+			cnn_float.getCalibrationRange(l, min_val, max_val);
+
+			cnn.calibration_min[l] = cnn.calibrated ? MIN(cnn.calibration_min[l], min_val) : min_val;
+			cnn.calibration_max[l] = cnn.calibrated ? MAX(cnn.calibration_max[l], max_val) : max_val;
+		}
+		cnn.calibrated = true;
+	}
+	void CNNModelsConverter::Quantize()
+	{
+		if (isEmpty()) return;
+
+		if (!cnn.calibrated)
+		{
+			printf("[CNNModelsConverter] Model is not calibrated!\n");
+			return;
+		}
+
+		Layer_filter* conv_l[3] = { &cnn.conv_l1, &cnn.conv_l2, &cnn.conv_l3 };
+		for (int l = 0; l < cnn.layer_count; ++l)
+		{
+			Layer_filter& filter = *conv_l[l];
+
+			//asymmetric u8 activations, zero is exactly representable
+			const float min_val = MIN(0.f, cnn.calibration_min[l]);
+			const float max_val = MAX(0.f, cnn.calibration_max[l]);
+			filter.q8_in_scale = max_val > min_val ? (max_val - min_val) / 255.f : 1.f;
+			filter.q8_zero_point = MIN(255, MAX(0, (int)lrintf(-min_val / filter.q8_in_scale)));
+
+			//symmetric per map weights of 7 bit, u8 x s7 pairs of int8 kernels do not saturate int16
+			const int map_count = cnn.layer_buffer[l].map_count;
+			filter.q8_kernel_scale.resize(map_count);
+			filter.q8_kernels.resize(map_count);
+			for (int i = 0; i < map_count; ++i)
+			{
+				float abs_max = 0.f;
+				for (int j = 0; j < filter.size.size; ++j)
+				{
+					abs_max = MAX(abs_max, fabsf(filter.kernels[i][j]));
+				}
+
+				filter.q8_kernel_scale[i] = abs_max > 0.f ? abs_max / 63.f : 1.f;
+				filter.q8_kernels[i].resize(filter.size.size);
+				for (int j = 0; j < filter.size.size; ++j)
+				{
+					const int kernel_val = (int)lrintf(filter.kernels[i][j] / filter.q8_kernel_scale[i]);
+					filter.q8_kernels[i][j] = (signed char)MIN(63, MAX(-63, kernel_val));
+				}
+			}
+		}
+
+		cnn.quantized = true;
+	}
+	void CNNModelsConverter::getCalibrationRange(int layer, float& min_val, float& max_val) const
+	{
+		min_val = 0.f;
+		max_val = 0.f;
+		if (!cnn.calibrated || layer < 0 || layer >= cnn.layer_count) return;
+
+		min_val = cnn.calibration_min[layer];
+		max_val = cnn.calibration_max[layer];
+	}
+
 #endif
 }
\ No newline at end of file
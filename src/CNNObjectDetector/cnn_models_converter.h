@@ -25,6 +25,7 @@
 
 #include <vector>
 #include <string>
+#include <ostream>
 
 
 using namespace NeuralNetworksLib::SIMD;
@@ -59,6 +60,12 @@ namespace NeuralNetworksLib
 
 			Size2d size;
 			std::vector<Array_32f> kernels;
+
+			//int8 layer: u8 input of scale q8_in_scale and zero point, per map kernel scale and 7 bit weights
+			float q8_in_scale = 0.f;
+			int q8_zero_point = 0;
+			std::vector<float> q8_kernel_scale;
+			std::vector<std::vector<signed char>> q8_kernels;
 		};
 		struct CNN
 		{
@@ -103,21 +110,38 @@ namespace NeuralNetworksLib
 			float af_scale = 0.f;
 			bool max_pool = false;
 			bool snn_full_connect = false;
+
+			bool quantized = false;
+			bool calibrated = false;
+			float calibration_min[3];
+			float calibration_max[3];
 		};
 
 		CNN cnn;
 
 		void Clear();
 		void ParserDump(std::vector<float>& param, std::vector<std::string>& dump, std::string l_name, std::string p_name, int idx = -1);
-		
+		void WriteBinary(std::ostream& file_bin, bool int8_layers);
+
 	public:
 		CNNModelsConverter() { }
 		~CNNModelsConverter() { Clear(); }
 
 		inline bool isEmpty() const { return cnn.min_image_size.width == 0 || cnn.min_image_size.height == 0; }
 
+		inline bool isQuantized() const { return cnn.quantized; }
+
 		void LoadCNTKModel(std::string file_name, bool preprocessing = true);
+		void LoadBinaryModel(std::string file_name);
 		void SaveToBinaryFile(std::string file_name, void* hGrd = 0);
+		//float model as format 2.0 layer graph (SIMD::LayerGraph)
+		void SaveToGraphFile(std::string file_name);
+
+		//int8 models: ranges of conv layers inputs are collected by float network on image pyramids of calibration images,
+		//Quantize sets u8 activations and per map 7 bit weights, SaveToBinaryFile writes format 1.2
+		void Calibrate(std::vector<Image_32f>& images, float scale_factor = 1.15f, int num_threads = 1);
+		void Quantize();
+		void getCalibrationRange(int layer, float& min_val, float& max_val) const;
 	};
 
 #endif
@@ -42,17 +42,17 @@ namespace NeuralNetworksLib
 			std::stringstream data_bin;
 			if (file_name.size() < 255)
 			{
-				std::fstream data_bin;
-				data_bin.open(file_name.c_str(), std::fstream::binary | std::fstream::in);
+				std::fstream file_bin;
+				file_bin.open(file_name.c_str(), std::fstream::binary | std::fstream::in);
 
-				if (!data_bin.is_open())
+				if (!file_bin.is_open())
 				{
 					printf("[SIMD::CNN] Configuration file not found!\n");
 					return;
 				}
 
-				data_bin << data_bin.rdbuf();
-				data_bin.close();
+				data_bin << file_bin.rdbuf();
+				file_bin.close();
 			}
 			else
 			{
@@ -681,6 +681,33 @@ namespace NeuralNetworksLib
 			printf("	cnn_simd: run_L2 = %7.3f ms (sum, conv_l2, tanh_avr_tanh)\n", timer.get(1000));
 #endif
 
+			Run_single_thread_L3();
+
+#ifdef CHECK_TEST
+			int count4 = 0;
+			double d4 = 0;
+			for (int y = 0; y < cnn_old.snn.output_neuron.row_count(); ++y)
+			{
+				for (int x = 0; x < cnn_old.snn.output_neuron.col_count(); ++x)
+				{
+					double d = cnn_old.snn.output_neuron[y][x][0] - cnn.layer_buffer[2].pool_buffer[0][y * cnn.output_buffer_size.step + x];
+					if (abs(d) > 1.E-4)
+					{
+						d4 += abs(d);
+						count4++;
+					}
+				}
+			}
+			printf("	d4 = %f, count4 = %d\n", d4, count4);
+			if (abs(d4) > 0.) system("pause");
+#endif
+		}
+		void ConvNeuralNetwork::Run_single_thread_L3()
+		{
+#ifdef PROFILE_CNN_SIMD
+			Timer timer(1, true);
+#endif
+
 			if (!cnn.snn_full_connect)
 			{
 #ifdef PROFILE_CNN_SIMD
@@ -802,12 +829,16 @@ namespace NeuralNetworksLib
 
 				const int it3 = cnn.snn_hl_size;
 				it2 = it2 << 1; // mul on 2;
+
+				//pool buffers of this network, must not be shared between networks (stage 1-3 and detector instances)
+				Array_32f_ref pool_ref;
+				if (it2 == 24) pool_ref = Array_32f_ref(cnn.layer_buffer[2].pool_buffer.data(), 24);
+
 				for (int i = 0; i < it3; ++i)
 				{
 					if (it2 == 24)
 					{
-						static Array_32f_ref temp_buff(cnn.layer_buffer[2].pool_buffer.data(), 24);
-						cnnpp.mulC24_add_tanh(cnn.hl_buffer[i](), temp_buff(), cnn.layer_buffer[2].pool_buffer_size.size, cnn.snn_hl_weight_fc[i](), &(cnn.snn_hl_bias[i]), &(cnn.af_scale), &(cnn.snn_ol_weight[i]));
+						cnnpp.mulC24_add_tanh(cnn.hl_buffer[i](), pool_ref(), cnn.layer_buffer[2].pool_buffer_size.size, cnn.snn_hl_weight_fc[i](), &(cnn.snn_hl_bias[i]), &(cnn.af_scale), &(cnn.snn_ol_weight[i]));
 					}
 					else
 					{
@@ -852,25 +883,6 @@ namespace NeuralNetworksLib
 				printf("	cnn_simd: run_HL = %7.3f ms (sum, mul, tanh, sum, tanh)\n", timer.get(1000));
 #endif
 			}
-
-#ifdef CHECK_TEST
-			int count4 = 0;
-			double d4 = 0;
-			for (int y = 0; y < cnn_old.snn.output_neuron.row_count(); ++y)
-			{
-				for (int x = 0; x < cnn_old.snn.output_neuron.col_count(); ++x)
-				{
-					double d = cnn_old.snn.output_neuron[y][x][0] - cnn.layer_buffer[2].pool_buffer[0][y * cnn.output_buffer_size.step + x];
-					if (abs(d) > 1.E-4)
-					{
-						d4 += abs(d);
-						count4++;
-					}
-				}
-			}
-			printf("	d4 = %f, count4 = %d\n", d4, count4);
-			if (abs(d4) > 0.) system("pause");
-#endif
 		}
 		void ConvNeuralNetwork::Run_multi_threads(Image_32f& image)
 		{
@@ -1008,6 +1020,33 @@ namespace NeuralNetworksLib
 			printf("	cnn_simd: run_L2 = %7.3f ms (sum, conv_l2, tanh_avr_tanh)\n", timer.get(1000));
 #endif
 
+			Run_multi_threads_L3();
+
+#ifdef CHECK_TEST
+			int count4 = 0;
+			double d4 = 0;
+			for (int y = 0; y < cnn_old.snn.output_neuron.row_count(); ++y)
+			{
+				for (int x = 0; x < cnn_old.snn.output_neuron.col_count(); ++x)
+				{
+					double d = cnn_old.snn.output_neuron[y][x][0] - cnn.layer_buffer[2].pool_buffer[0][y * cnn.output_buffer_size.step + x];
+					if (abs(d) > 1.E-4)
+					{
+						d4 += abs(d);
+						count4++;
+					}
+				}
+			}
+			printf("	d4 = %f, count4 = %d\n", d4, count4);
+			if (abs(d4) > 0.) system("pause");
+#endif
+		}
+		void ConvNeuralNetwork::Run_multi_threads_L3()
+		{
+#ifdef PROFILE_CNN_SIMD
+			Timer timer(1, true);
+#endif
+
 			if (!cnn.snn_full_connect)
 			{
 #ifdef PROFILE_CNN_SIMD
@@ -1195,25 +1234,6 @@ namespace NeuralNetworksLib
 				printf("	cnn_simd: run_HL = %7.3f ms (sum, mul, tanh, sum, tanh)\n", timer.get(1000));
 #endif
 			}
-
-#ifdef CHECK_TEST
-			int count4 = 0;
-			double d4 = 0;
-			for (int y = 0; y < cnn_old.snn.output_neuron.row_count(); ++y)
-			{
-				for (int x = 0; x < cnn_old.snn.output_neuron.col_count(); ++x)
-				{
-					double d = cnn_old.snn.output_neuron[y][x][0] - cnn.layer_buffer[2].pool_buffer[0][y * cnn.output_buffer_size.step + x];
-					if (abs(d) > 1.E-4)
-					{
-						d4 += abs(d);
-						count4++;
-					}
-				}
-			}
-			printf("	d4 = %f, count4 = %d\n", d4, count4);
-			if (abs(d4) > 0.) system("pause");
-#endif
 		}
 
 		void ConvNeuralNetwork::Forward(Image_32f& response_map, Image_32f& image)
@@ -1274,6 +1294,94 @@ namespace NeuralNetworksLib
 
 			return Size(cnn_conv_l3_ROI_cols, cnn_conv_l3_ROI_rows);
 		}
+
+		Size ConvNeuralNetwork::getFeatureMapsSize(const Size size)
+		{
+			//size layer2
+			int cnn_conv_l2_ROI_cols = ((size.width - (cnn.conv_l1.size.cols - 1)) >> 1) - (cnn.conv_l2.size.cols - 1);
+			int cnn_conv_l2_ROI_rows = ((size.height - (cnn.conv_l1.size.rows - 1)) >> 1) - (cnn.conv_l2.size.rows - 1);
+
+			return Size(cnn_conv_l2_ROI_cols >> 1, cnn_conv_l2_ROI_rows >> 1);
+		}
+		void ConvNeuralNetwork::getFeatureMaps(Image_32f& maps)
+		{
+			const int cols = cnn.conv_l2.ROI.cols >> 1;
+			const int rows = cnn.conv_l2.ROI.rows >> 1;
+			const int map_count = cnn.layer_buffer[1].map_count;
+
+			if (maps.width != cols || maps.height != map_count * rows)
+			{
+				maps = Image_32f(cols, map_count * rows, ALIGN_DEF, false);
+			}
+
+			for (int i = 0; i < map_count; ++i)
+			{
+				for (int y = 0; y < rows; ++y)
+				{
+					memcpy(maps.data + (i * rows + y) * maps.widthStep, cnn.layer_buffer[1].pool_buffer[i](y * cnn.layer_buffer[1].pool_buffer_size.cols), cols * sizeof(float));
+				}
+			}
+		}
+		void ConvNeuralNetwork::ForwardFeatureMaps(Image_32f& response_map, Image_32f& maps, const Size size)
+		{
+			if (size.width != cnn.input_buffer_size.cols || size.height != cnn.input_buffer_size.rows)
+			{
+				if (size.width < cnn.min_image_size.width || size.height < cnn.min_image_size.height ||
+					size.width > cnn.max_image_size.width || size.height > cnn.max_image_size.height)
+				{
+					response_map.width = 0;
+					response_map.height = 0;
+					return;
+				}
+
+				ResizeBuffers(size);
+			}
+
+			const int cols = cnn.conv_l2.ROI.cols >> 1;
+			const int rows = cnn.conv_l2.ROI.rows >> 1;
+			const int map_count = cnn.layer_buffer[1].map_count;
+
+			if (maps.width != cols || maps.height != map_count * rows)
+			{
+				response_map.width = 0;
+				response_map.height = 0;
+				return;
+			}
+
+			for (int i = 0; i < map_count; ++i)
+			{
+				for (int y = 0; y < rows; ++y)
+				{
+					memcpy(cnn.layer_buffer[1].pool_buffer[i](y * cnn.layer_buffer[1].pool_buffer_size.cols), maps.data + (i * rows + y) * maps.widthStep, cols * sizeof(float));
+				}
+			}
+
+#ifdef USE_OMP
+			if (num_threads > 1)
+			{
+				Run_multi_threads_L3();
+			}
+			else
+#endif
+			{
+				Run_single_thread_L3();
+			}
+
+			if (response_map.isEmpty())
+			{
+				response_map.width = cnn.output_buffer_size.cols;
+				response_map.height = cnn.output_buffer_size.rows;
+				response_map.widthStep = cnn.output_buffer_size.step;
+				response_map.data = cnn.layer_buffer[2].pool_buffer[0].data;
+				response_map.sharingData = true;
+			}
+			else
+			{
+				response_map.width = cnn.output_buffer_size.cols;
+				response_map.height = cnn.output_buffer_size.rows;
+				response_map.copyData(cnn.output_buffer_size.cols, cnn.output_buffer_size.rows, cnn.layer_buffer[2].pool_buffer[0](), cnn.output_buffer_size.step);
+			}
+		}
 	}
 
 #endif
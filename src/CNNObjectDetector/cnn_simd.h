@@ -125,6 +125,8 @@ namespace NeuralNetworksLib
 			void ResizeBuffers(const Size size);
 			void Run_single_thread(Image_32f& image);
 			void Run_multi_threads(Image_32f& image);
+			void Run_single_thread_L3();
+			void Run_multi_threads_L3();
 
 		public:
 			ConvNeuralNetwork() { }
@@ -148,6 +150,17 @@ namespace NeuralNetworksLib
 			inline int getNumThreads() const { return num_threads; }
 			inline void setNumThreads(int _num_threads) { num_threads = MAX(1, _num_threads); }
 
+			//approximate feature pyramid: pooled layer 2 maps stacked by rows (getFeatureMapsCount maps of getFeatureMapsSize),
+			//layer 2 cell (x, y) is centered at input pixel getFeatureMapsStride() * (x, y) + getFeatureMapsOffset()
+			Size getFeatureMapsSize(const Size size);
+			inline int getFeatureMapsCount() const { return cnn.layer_buffer[1].map_count; }
+			inline float getFeatureMapsStride() const { return 4.f; }
+			inline float getFeatureMapsOffset() const { return 1.5f + 0.5f * float(cnn.conv_l1.size.cols - 1) + float(cnn.conv_l2.size.cols - 1); }
+			//layer 2 maps of last Forward
+			void getFeatureMaps(Image_32f& maps);
+			//layers 3+ of image of given size on layer 2 maps
+			void ForwardFeatureMaps(Image_32f& response_map, Image_32f& maps, const Size size);
+
 #if 0
 			void SaveToBinaryFile(std::string file_name, void* hGrd = 0);
 			void Init(Legacy::ConvNeuralNetwork* _cnn, bool _max_pool = false, bool preprocessing = true);
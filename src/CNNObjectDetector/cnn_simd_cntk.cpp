@@ -19,6 +19,7 @@
 
 
 #include "cnn_simd_cntk.h"
+#include "timer.h"
 #include <fstream>
 #include <sstream>
 #include <iterator>
@@ -39,6 +40,32 @@ namespace NeuralNetworksLib
 
 	namespace SIMD
 	{
+		//value i of kernel_h x kernel_w kernel in layout of Init
+		static inline float kernelValue(Array_32f& kernel, int layer, const Size2d& size, int i)
+		{
+#if defined(USE_SSE) || defined(USE_AVX)
+			if (layer == 0) return kernel[(i >> 2) * 4 * MAX(1, REG_SIZE / 4) + (i & 3)];
+			if (layer == 1) return kernel[(i / 3) * 4 * MAX(1, REG_SIZE / 4) + i % 3];
+			if (size.cols < 8) return kernel[(i / size.cols) * 8 * MAX(1, REG_SIZE / 8) + i % size.cols];
+#endif
+			return kernel[i];
+		}
+
+		//kernel sizes of conv_* calls of Conv_L1, Conv_L2, Conv_L3 (conv_5x5, conv_6x6, conv_7x7, conv_8x8 of AVX builds are empty)
+		static inline bool hasDirectKernel(int layer, const Size2d& size)
+		{
+			const int w = size.cols;
+			const int h = size.rows;
+			if (layer < 2) return (w == 3 && h == 3) || (layer == 0 && w == 4 && h == 4);
+			if (w == 3 && h == 3) return true;
+			if (w == 4 && (h == 4 || h == 5)) return true;
+			if ((w == 5 && h == 6) || (w == 7 && h == 8) || (w == 10 && h == 11) || (w == 11 && h == 11)) return true;
+#ifndef USE_AVX
+			if ((w == 5 && h == 5) || (w == 6 && h == 6) || (w == 7 && h == 7) || (w == 8 && h == 8)) return true;
+#endif
+			return false;
+		}
+
 		void ConvNeuralNetwork::Init(std::string file_name, int index_output, void* hGrd)
 		{
 			//if (file_name.find(".txt") != std::string::npos)
@@ -71,7 +98,20 @@ namespace NeuralNetworksLib
 			float format_version = 0.0f;
 			FB_READ(data_bin, format_version);
 
-			if (format_version < 1.0f || format_version > 1.1f)
+			//layer graph
+			if (format_version > 1.9f)
+			{
+				graph = new LayerGraph();
+				graph->Init(file_name, index_output);
+				if (graph->isEmpty())
+				{
+					delete graph;
+					graph = nullptr;
+				}
+				return;
+			}
+
+			if (format_version < 1.0f || format_version > 1.2f)
 			{
 				printf("[SIMD::CNN] Configuration file format is not supported!\n");
 				return;
@@ -320,8 +360,7 @@ namespace NeuralNetworksLib
 			FB_READ(data_bin, cnn.hl_scale);
 
 			if (!cnn.max_pool ||
-				cnn.layer_count != 3 ||
-				cnn.conv_l2.size.size != 9)
+				cnn.layer_count != 3)
 			{
 				printf("[SIMD::CNN] This configuration cnn models is not supported!\n");
 				Clear();
@@ -393,6 +432,120 @@ namespace NeuralNetworksLib
 
 			FB_READ(data_bin, cnn.snn_ol_tanh_w);
 
+			//int8 conv layers (format 1.2): input scale and zero point, per map kernel scale and 7 bit weights
+			if (format_version > 1.1f && int8)
+			{
+#ifdef USE_AVX2
+				Layer_filter* conv_l[3] = { &cnn.conv_l1, &cnn.conv_l2, &cnn.conv_l3 };
+				for (int l = 0; l < cnn.layer_count; ++l)
+				{
+					Layer_filter& filter = *conv_l[l];
+					const int map_count = cnn.layer_buffer[l].map_count;
+					const int maps = l == 0 ? map_count : 2;
+
+					float in_scale = 0.f;
+					FB_READ(data_bin, in_scale);
+					FB_READ(data_bin, filter.q8_zero_point);
+					filter.q8_inv_scale = in_scale > 0.f ? 1.f / in_scale : 0.f;
+
+					std::vector<signed char> kernels(map_count * filter.size.size);
+					filter.q8_params = Array_32f(map_count * ConvTemplate::Q8_PARAMS, ALIGN_DEF);
+					for (int k = 0; k < map_count; ++k)
+					{
+						float kernel_scale = 0.f;
+						FB_READ(data_bin, kernel_scale);
+
+						int kernel_sum = 0;
+						for (int i = 0; i < filter.size.size; ++i)
+						{
+							signed char kernel_val = 0;
+							FB_READ(data_bin, kernel_val);
+
+							//u8 x s7 products of _mm256_maddubs_epi16 do not saturate int16 pairs
+							if (kernel_val < -63 || kernel_val > 63)
+							{
+								printf("[SIMD::CNN] Quantized weights are out of range!\n");
+								Clear();
+								return;
+							}
+
+							kernels[k * filter.size.size + i] = kernel_val;
+							kernel_sum += kernel_val;
+						}
+
+						//zero point of input is folded into bias of conv sums
+						float* params = filter.q8_params(k * ConvTemplate::Q8_PARAMS);
+						params[0] = in_scale * kernel_scale;
+						params[1] = cnn.conv_bias[l][k] - float(filter.q8_zero_point * kernel_sum) * params[0];
+						params[2] = cnn.leakyReLU_w1[l][k];
+						params[3] = cnn.leakyReLU_w2[l][k];
+						params[4] = cnn.bn_bias[l][k];
+					}
+
+					filter.q8_kernels.resize(map_count * filter.size.rows * ((filter.size.cols + 3) >> 2));
+					ConvTemplate::packKernelsQ8(filter.q8_kernels.data(), kernels.data(), filter.size.cols, filter.size.rows, map_count);
+
+					if (l < 2)
+					{
+						filter.q8_pool_kernel = ConvTemplate::findPoolQ8(filter.size.cols, filter.size.rows, maps);
+					}
+					else
+					{
+						filter.q8_kernel = ConvTemplate::findQ8(filter.size.cols, filter.size.rows, maps);
+					}
+					if ((filter.q8_pool_kernel == nullptr && filter.q8_kernel == nullptr) || map_count > ConvTemplate::Q8_MAX_MAPS)
+					{
+						printf("[SIMD::CNN] This configuration of int8 cnn models is not supported!\n");
+						Clear();
+						return;
+					}
+				}
+
+				if (!data_bin)
+				{
+					printf("[SIMD::CNN] Configuration file is corrupted!\n");
+					Clear();
+					return;
+				}
+				cnn.quantized = true;
+#else
+				printf("[SIMD::CNN] Int8 layers are not supported by this build, float weights are used!\n");
+#endif
+			}
+
+			//kernels of all maps in one matrix (generated kernels)
+			Layer_filter* conv_l[3] = { &cnn.conv_l1, &cnn.conv_l2, &cnn.conv_l3 };
+			for (int l = 0; l < cnn.layer_count; ++l)
+			{
+				Layer_filter& filter = *conv_l[l];
+				const int K = filter.size.cols * filter.size.rows;
+				filter.gemm_kernels = Array_32f(cnn.layer_buffer[l].map_count * K, ALIGN_DEF);
+				for (int k = 0; k < cnn.layer_buffer[l].map_count; ++k)
+				{
+					for (int i = 0; i < K; ++i)
+					{
+						filter.gemm_kernels[k * K + i] = kernelValue(filter.kernels[k], l, filter.size, i);
+					}
+				}
+			}
+
+			//direct and generated kernels of conv layers: maps of layer 1 on image, 2 maps per input map of layers 2, 3
+			for (int l = 0; l < cnn.layer_count; ++l)
+			{
+				Layer_filter& filter = *conv_l[l];
+				filter.direct = hasDirectKernel(l, filter.size);
+				filter.conv_template = ConvTemplate::find(filter.size.cols, filter.size.rows, l == 0 ? cnn.layer_buffer[0].map_count : 2, l < 2);
+
+				if (!filter.direct && filter.conv_template == nullptr)
+				{
+					printf("[SIMD::CNN] This configuration cnn models is not supported!\n");
+					Clear();
+					return;
+				}
+			}
+			cnn.maps_dst.resize(MAX(cnn.layer_buffer[0].map_count, cnn.layer_buffer[cnn.layer_count - 1].map_count));
+			setTemplateLayers(0);
+
 			cnn.index_output = MIN(index_output, cnn.snn_ol_neuron_count - 1);
 			cnn.af_scale = cnn.index_output == 0 ? -cnn.af_scale : cnn.af_scale;
 
@@ -404,6 +557,12 @@ namespace NeuralNetworksLib
 		}	
 		void ConvNeuralNetwork::AllocateMemory(const Size size)
 		{
+			if (graph != nullptr)
+			{
+				graph->AllocateMemory(size);
+				return;
+			}
+
 			if (size.width < cnn.min_image_size.width || size.height < cnn.min_image_size.height)
 			{
 				return;
@@ -512,7 +671,7 @@ namespace NeuralNetworksLib
 			{
 				cnn.layer_buffer[2].pool_buffer[i] = Array_32f(iBufferSize, ALIGN_DEF);
 			}
-			cnn.pool3_buffer_ref = Array_32f_ref(cnn.layer_buffer[2].pool_buffer.data(), cnn.layer_buffer[2].pool_buffer.size());
+			cnn.pool3_strip.resize(cnn.layer_buffer[2].map_count);
 
 			//sum buffer
 			cnn.layer_buffer[2].sum_buffer.clear();
@@ -536,9 +695,34 @@ namespace NeuralNetworksLib
 			cnn.output_buffer_size = Size2d(cnn.conv_l3.ROI.cols,
 											num_out_map * cnn.conv_l3.ROI.rows,
 											cnn.ol_buffer_size.step);
+
+#ifdef USE_AVX2
+			//u8 image and u8 inputs of layers 2, 3 (int8 kernels read rows in blocks past their ends)
+			if (cnn.quantized)
+			{
+				cnn.q8_input_step = 32 * ((size.width + 31) / 32);
+				cnn.q8_input_buffer = Array_8u(cnn.q8_input_step * size.height + ConvTemplate::Q8_PADDING, ALIGN_DEF);
+				for (int l = 0; l < 2; ++l)
+				{
+					cnn.layer_buffer[l].q8_buffer.resize(cnn.layer_buffer[l].map_count);
+					for (int i = 0; i < cnn.layer_buffer[l].map_count; ++i)
+					{
+						cnn.layer_buffer[l].q8_buffer[i] = Array_8u(cnn.layer_buffer[l].pool_buffer_size.size + ConvTemplate::Q8_PADDING, ALIGN_DEF);
+					}
+				}
+			}
+#endif
+
+			FindFixedKernels();
 		}
 		void ConvNeuralNetwork::Clear()
 		{
+			if (graph != nullptr)
+			{
+				delete graph;
+				graph = nullptr;
+			}
+
 			if (isEmpty()) return;
 
 			cnn.min_image_size = Size(0, 0);
@@ -548,7 +732,8 @@ namespace NeuralNetworksLib
 			cnn.layer_buffer.clear();
 			cnn.hl_buffer.clear();
 			cnn.ol_buffer.clear();
-			cnn.pool3_buffer_ref.clear();
+			cnn.heads_buffer.clear();
+			cnn.pool3_strip.clear();
 
 			//clear weight
 			//conv kernels L1
@@ -581,6 +766,34 @@ namespace NeuralNetworksLib
 			cnn.snn_ol_neuron_count = 0;
 
 			cnn.snn_ol_bias.clear();
+
+			//int8 conv layers
+			cnn.quantized = false;
+			cnn.q8_input_step = 0;
+			cnn.q8_input_buffer.clear();
+			Layer_filter* conv_l[3] = { &cnn.conv_l1, &cnn.conv_l2, &cnn.conv_l3 };
+			for (int l = 0; l < 3; ++l)
+			{
+				conv_l[l]->q8_kernels.clear();
+				conv_l[l]->q8_params.clear();
+#ifdef USE_AVX2
+				conv_l[l]->q8_pool_kernel = nullptr;
+				conv_l[l]->q8_kernel = nullptr;
+#endif
+				conv_l[l]->wino_kernels.clear();
+				conv_l[l]->gemm_kernels.clear();
+			}
+			cnn.winograd_layers = 0;
+
+			//generated kernels
+			for (int l = 0; l < 3; ++l)
+			{
+				conv_l[l]->conv_template = nullptr;
+				conv_l[l]->conv_fixed = nullptr;
+				conv_l[l]->direct = false;
+			}
+			cnn.template_layers = 0;
+			cnn.maps_dst.clear();
 		}
 
 		void ConvNeuralNetwork::ResizeBuffers(const Size size)
@@ -636,31 +849,45 @@ namespace NeuralNetworksLib
 			cnn.output_buffer_size = Size2d(cnn.conv_l3.ROI.cols,
 											out_map * cnn.conv_l3.ROI.rows,
 											cnn.ol_buffer_size.step);
+
+			FindFixedKernels();
+		}
+		void ConvNeuralNetwork::FindFixedKernels()
+		{
+			Layer_filter* conv_l[3] = { &cnn.conv_l1, &cnn.conv_l2, &cnn.conv_l3 };
+			for (int l = 0; l < cnn.layer_count; ++l)
+			{
+				Layer_filter& filter = *conv_l[l];
+				filter.conv_fixed = nullptr;
+				if (cnn.quantized || (cnn.winograd_layers & (1 << l))) continue;
+
+				filter.conv_fixed = ConvTemplate::findFixed(filter.size.cols, filter.size.rows, l == 0 ? cnn.layer_buffer[0].map_count : 2, l < 2, filter.ROI.cols, filter.ROI.rows);
+			}
 		}
 		void ConvNeuralNetwork::Run(Image_32f& image)
 		{
+			if (cnn.quantized)
+			{
+				Run_Q8(image);
+				return;
+			}
+
+			if (cnn.calibration)
+			{
+				UpdateCalibrationRange(0, image.data, image.widthStep, image.width, image.height);
+			}
+
 #ifdef PROFILE_CNN_SIMD
 			printf("\n	cnn_simd: run single thread");
 			printf("\n	cnn_simd: image size = (%d, %d)\n", image.width, image.height);
 			Timer timer(1, true);
 #endif
 
-			//OMP_PRAGMA(omp parallel for num_threads(num_threads))
 			for (int i = 0; i < cnn.layer_buffer[0].map_count; ++i)
 			{
-				if (cnn.conv_l1.size.rows == 4 && cnn.conv_l1.size.cols == 4)
-				{
-					cnnpp.conv_4x4(cnn.layer_buffer[0].conv_buffer[i](), cnn.layer_buffer[0].conv_buffer_size.cols, image.data, image.widthStep, cnn.input_buffer_size.rows, cnn.conv_l1.kernels[i](), cnn.conv_l1.ROI.cols, cnn.conv_l1.ROI.rows);
-					goto AF1;
-				}
-				if (cnn.conv_l1.size.rows == 3 && cnn.conv_l1.size.cols == 3)
-				{
-					cnnpp.conv_3x3(cnn.layer_buffer[0].conv_buffer[i](), cnn.layer_buffer[0].conv_buffer_size.cols, image.data, image.widthStep, cnn.input_buffer_size.rows, cnn.conv_l1.kernels[i](), cnn.conv_l1.ROI.cols, cnn.conv_l1.ROI.rows);
-					goto AF1;
-				}
-				AF1:
-				cnnpp.lrelu_bn_max(cnn.layer_buffer[0].pool_buffer[i](), cnn.layer_buffer[0].pool_buffer_size.cols, cnn.layer_buffer[0].conv_buffer[i](), cnn.layer_buffer[0].conv_buffer_size.cols, cnn.layer_buffer[0].conv_buffer_size.rows, &(cnn.conv_bias[0][i]), &(cnn.leakyReLU_w1[0][i]), &(cnn.leakyReLU_w2[0][i]), &(cnn.bn_weight[0][i]), &(cnn.bn_bias[0][i]));
+				cnn.maps_dst[i] = cnn.layer_buffer[0].pool_buffer[i]();
 			}
+			ConvMaps_L1(cnn.maps_dst.data(), image);
 
 			//for (int i = 0; i < cnn.layer_buffer[0].map_count; ++i)
 			//{
@@ -706,28 +933,15 @@ namespace NeuralNetworksLib
 			//OMP_PRAGMA(omp parallel for num_threads(num_threads))
 			for (int i = 0; i < it1; ++i)
 			{
-				if (i > 0 && i < it1 - 1)
-				{
-					cnnpp.add2(cnn.layer_buffer[0].sum_buffer[i](), cnn.layer_buffer[0].pool_buffer[i - 1](), cnn.layer_buffer[0].pool_buffer[i](), cnn.layer_buffer[0].pool_buffer[i + 1](), cnn.layer_buffer[0].pool_buffer_size.size);
-				}
-				else
+				float* sum = SumPoolMaps(0, i, it1);
+
+				if (cnn.calibration)
 				{
-					if (i == 0)
-					{
-						cnnpp.add(cnn.layer_buffer[0].sum_buffer[0](), cnn.layer_buffer[0].pool_buffer[0](), cnn.layer_buffer[0].pool_buffer[1](), cnn.layer_buffer[0].pool_buffer_size.size);
-					}
-					else
-					{
-						const int t = cnn.layer_buffer[0].map_count;
-						cnnpp.add(cnn.layer_buffer[0].sum_buffer[t - 1](), cnn.layer_buffer[0].pool_buffer[t - 2](), cnn.layer_buffer[0].pool_buffer[t - 1](), cnn.layer_buffer[0].pool_buffer_size.size);
-					}
+					UpdateCalibrationRange(1, sum, cnn.layer_buffer[0].pool_buffer_size.cols, cnn.conv_l1.ROI.cols >> 1, cnn.conv_l1.ROI.rows >> 1);
 				}
 
-				cnnpp.conv_3x3(cnn.layer_buffer[1].conv_buffer[2 * i](), cnn.layer_buffer[1].conv_buffer_size.cols, cnn.layer_buffer[0].sum_buffer[i](), cnn.layer_buffer[0].pool_buffer_size.cols, cnn.layer_buffer[0].pool_buffer_size.rows, cnn.conv_l2.kernels[2 * i](), cnn.conv_l2.ROI.cols, cnn.conv_l2.ROI.rows);
-				cnnpp.lrelu_bn_max(cnn.layer_buffer[1].pool_buffer[2 * i](), cnn.layer_buffer[1].pool_buffer_size.cols, cnn.layer_buffer[1].conv_buffer[2 * i](), cnn.layer_buffer[1].conv_buffer_size.cols, cnn.layer_buffer[1].conv_buffer_size.rows, &(cnn.conv_bias[1][2 * i]), &(cnn.leakyReLU_w1[1][2 * i]), &(cnn.leakyReLU_w2[1][2 * i]), &(cnn.bn_weight[1][2 * i]), &(cnn.bn_bias[1][2 * i]));
-
-				cnnpp.conv_3x3(cnn.layer_buffer[1].conv_buffer[2 * i + 1](), cnn.layer_buffer[1].conv_buffer_size.cols, cnn.layer_buffer[0].sum_buffer[i](), cnn.layer_buffer[0].pool_buffer_size.cols, cnn.layer_buffer[0].pool_buffer_size.rows, cnn.conv_l2.kernels[2 * i + 1](), cnn.conv_l2.ROI.cols, cnn.conv_l2.ROI.rows);
-				cnnpp.lrelu_bn_max(cnn.layer_buffer[1].pool_buffer[2 * i + 1](), cnn.layer_buffer[1].pool_buffer_size.cols, cnn.layer_buffer[1].conv_buffer[2 * i + 1](), cnn.layer_buffer[1].conv_buffer_size.cols, cnn.layer_buffer[1].conv_buffer_size.rows, &(cnn.conv_bias[1][2 * i + 1]), &(cnn.leakyReLU_w1[1][2 * i + 1]), &(cnn.leakyReLU_w2[1][2 * i + 1]), &(cnn.bn_weight[1][2 * i + 1]), &(cnn.bn_bias[1][2 * i + 1]));
+				float* dst[2] = { cnn.layer_buffer[1].pool_buffer[2 * i](), cnn.layer_buffer[1].pool_buffer[2 * i + 1]() };
+				ConvMaps_L2(dst, i, sum);
 			}
 
 			//for (int i = 0; i < cnn.layer_buffer[1].map_count; ++i)
@@ -752,99 +966,29 @@ namespace NeuralNetworksLib
 
 #ifdef PROFILE_CNN_SIMD
 			printf("	cnn_simd: run_L2 = %7.3f ms (sum, conv_l2, tanh_avr_tanh)\n", timer.get(1000));
-			timer.start();
 #endif
 
-			int it2 = cnn.layer_buffer[2].map_count >> 1; // div on 2
+			Run_L3();
+		}
+		void ConvNeuralNetwork::Run_L3()
+		{
+#ifdef PROFILE_CNN_SIMD
+			Timer timer(1, true);
+#endif
+
+			const int it2 = cnn.layer_buffer[2].map_count >> 1; // div on 2
 			//OMP_PRAGMA(omp parallel for num_threads(num_threads))
 			for (int i = 0; i < it2; ++i)
 			{
-				if (i > 0 && i < it2 - 1)
-				{
-					cnnpp.add2(cnn.layer_buffer[1].sum_buffer[i](), cnn.layer_buffer[1].pool_buffer[i - 1](), cnn.layer_buffer[1].pool_buffer[i](), cnn.layer_buffer[1].pool_buffer[i + 1](), cnn.layer_buffer[1].pool_buffer_size.size);
-				}
-				else
-				{
-					if (i == 0)
-					{
-						cnnpp.add(cnn.layer_buffer[1].sum_buffer[0](), cnn.layer_buffer[1].pool_buffer[0](), cnn.layer_buffer[1].pool_buffer[1](), cnn.layer_buffer[1].pool_buffer_size.size);
-					}
-					else
-					{
-						int t = cnn.layer_buffer[1].map_count;
-						cnnpp.add(cnn.layer_buffer[1].sum_buffer[t - 1](), cnn.layer_buffer[1].pool_buffer[t - 2](), cnn.layer_buffer[1].pool_buffer[t - 1](), cnn.layer_buffer[1].pool_buffer_size.size);
-					}
-				}
+				float* sum = SumPoolMaps(1, i, it2);
 
-				if (cnn.conv_l3.size.rows == 8 && cnn.conv_l3.size.cols == 7)
-				{
-					cnnpp.conv_8x7(cnn.layer_buffer[2].conv_buffer[2 * i](), cnn.layer_buffer[2].conv_buffer_size.cols, cnn.layer_buffer[1].sum_buffer[i](), cnn.layer_buffer[1].pool_buffer_size.cols, cnn.layer_buffer[1].pool_buffer_size.rows, cnn.conv_l3.kernels[2 * i](), cnn.conv_l3.ROI.cols, cnn.conv_l3.ROI.rows);
-					cnnpp.conv_8x7(cnn.layer_buffer[2].conv_buffer[2 * i + 1](), cnn.layer_buffer[2].conv_buffer_size.cols, cnn.layer_buffer[1].sum_buffer[i](), cnn.layer_buffer[1].pool_buffer_size.cols, cnn.layer_buffer[1].pool_buffer_size.rows, cnn.conv_l3.kernels[2 * i + 1](), cnn.conv_l3.ROI.cols, cnn.conv_l3.ROI.rows);
-					goto AF3;
-				}
-				if (cnn.conv_l3.size.rows == 3 && cnn.conv_l3.size.cols == 3)
-				{
-					cnnpp.conv_3x3(cnn.layer_buffer[2].conv_buffer[2 * i](), cnn.layer_buffer[2].conv_buffer_size.cols, cnn.layer_buffer[1].sum_buffer[i](), cnn.layer_buffer[1].pool_buffer_size.cols, cnn.layer_buffer[1].pool_buffer_size.rows, cnn.conv_l3.kernels[2 * i](), cnn.conv_l3.ROI.cols, cnn.conv_l3.ROI.rows);
-					cnnpp.conv_3x3(cnn.layer_buffer[2].conv_buffer[2 * i + 1](), cnn.layer_buffer[2].conv_buffer_size.cols, cnn.layer_buffer[1].sum_buffer[i](), cnn.layer_buffer[1].pool_buffer_size.cols, cnn.layer_buffer[1].pool_buffer_size.rows, cnn.conv_l3.kernels[2 * i + 1](), cnn.conv_l3.ROI.cols, cnn.conv_l3.ROI.rows);
-					goto AF3;
-				}
-				if (cnn.conv_l3.size.rows == 4 && cnn.conv_l3.size.cols == 4)
-				{
-					cnnpp.conv_4x4(cnn.layer_buffer[2].conv_buffer[2 * i](), cnn.layer_buffer[2].conv_buffer_size.cols, cnn.layer_buffer[1].sum_buffer[i](), cnn.layer_buffer[1].pool_buffer_size.cols, cnn.layer_buffer[1].pool_buffer_size.rows, cnn.conv_l3.kernels[2 * i](), cnn.conv_l3.ROI.cols, cnn.conv_l3.ROI.rows);
-					cnnpp.conv_4x4(cnn.layer_buffer[2].conv_buffer[2 * i + 1](), cnn.layer_buffer[2].conv_buffer_size.cols, cnn.layer_buffer[1].sum_buffer[i](), cnn.layer_buffer[1].pool_buffer_size.cols, cnn.layer_buffer[1].pool_buffer_size.rows, cnn.conv_l3.kernels[2 * i + 1](), cnn.conv_l3.ROI.cols, cnn.conv_l3.ROI.rows);
-					goto AF3;
-				}
-				if (cnn.conv_l3.size.rows == 5 && cnn.conv_l3.size.cols == 4)
-				{
-					cnnpp.conv_5x4(cnn.layer_buffer[2].conv_buffer[2 * i](), cnn.layer_buffer[2].conv_buffer_size.cols, cnn.layer_buffer[1].sum_buffer[i](), cnn.layer_buffer[1].pool_buffer_size.cols, cnn.layer_buffer[1].pool_buffer_size.rows, cnn.conv_l3.kernels[2 * i](), cnn.conv_l3.ROI.cols, cnn.conv_l3.ROI.rows);
-					cnnpp.conv_5x4(cnn.layer_buffer[2].conv_buffer[2 * i + 1](), cnn.layer_buffer[2].conv_buffer_size.cols, cnn.layer_buffer[1].sum_buffer[i](), cnn.layer_buffer[1].pool_buffer_size.cols, cnn.layer_buffer[1].pool_buffer_size.rows, cnn.conv_l3.kernels[2 * i + 1](), cnn.conv_l3.ROI.cols, cnn.conv_l3.ROI.rows);
-					goto AF3;
-				}
-				if (cnn.conv_l3.size.rows == 5 && cnn.conv_l3.size.cols == 5)
-				{
-					cnnpp.conv_5x5(cnn.layer_buffer[2].conv_buffer[2 * i](), cnn.layer_buffer[2].conv_buffer_size.cols, cnn.layer_buffer[1].sum_buffer[i](), cnn.layer_buffer[1].pool_buffer_size.cols, cnn.layer_buffer[1].pool_buffer_size.rows, cnn.conv_l3.kernels[2 * i](), cnn.conv_l3.ROI.cols, cnn.conv_l3.ROI.rows);
-					cnnpp.conv_5x5(cnn.layer_buffer[2].conv_buffer[2 * i + 1](), cnn.layer_buffer[2].conv_buffer_size.cols, cnn.layer_buffer[1].sum_buffer[i](), cnn.layer_buffer[1].pool_buffer_size.cols, cnn.layer_buffer[1].pool_buffer_size.rows, cnn.conv_l3.kernels[2 * i + 1](), cnn.conv_l3.ROI.cols, cnn.conv_l3.ROI.rows);
-					goto AF3;
-				}
-				if (cnn.conv_l3.size.rows == 6 && cnn.conv_l3.size.cols == 5)
-				{
-					cnnpp.conv_6x5(cnn.layer_buffer[2].conv_buffer[2 * i](), cnn.layer_buffer[2].conv_buffer_size.cols, cnn.layer_buffer[1].sum_buffer[i](), cnn.layer_buffer[1].pool_buffer_size.cols, cnn.layer_buffer[1].pool_buffer_size.rows, cnn.conv_l3.kernels[2 * i](), cnn.conv_l3.ROI.cols, cnn.conv_l3.ROI.rows);
-					cnnpp.conv_6x5(cnn.layer_buffer[2].conv_buffer[2 * i + 1](), cnn.layer_buffer[2].conv_buffer_size.cols, cnn.layer_buffer[1].sum_buffer[i](), cnn.layer_buffer[1].pool_buffer_size.cols, cnn.layer_buffer[1].pool_buffer_size.rows, cnn.conv_l3.kernels[2 * i + 1](), cnn.conv_l3.ROI.cols, cnn.conv_l3.ROI.rows);
-					goto AF3;
-				}
-				if (cnn.conv_l3.size.rows == 6 && cnn.conv_l3.size.cols == 6)
-				{
-					cnnpp.conv_6x6(cnn.layer_buffer[2].conv_buffer[2 * i](), cnn.layer_buffer[2].conv_buffer_size.cols, cnn.layer_buffer[1].sum_buffer[i](), cnn.layer_buffer[1].pool_buffer_size.cols, cnn.layer_buffer[1].pool_buffer_size.rows, cnn.conv_l3.kernels[2 * i](), cnn.conv_l3.ROI.cols, cnn.conv_l3.ROI.rows);
-					cnnpp.conv_6x6(cnn.layer_buffer[2].conv_buffer[2 * i + 1](), cnn.layer_buffer[2].conv_buffer_size.cols, cnn.layer_buffer[1].sum_buffer[i](), cnn.layer_buffer[1].pool_buffer_size.cols, cnn.layer_buffer[1].pool_buffer_size.rows, cnn.conv_l3.kernels[2 * i + 1](), cnn.conv_l3.ROI.cols, cnn.conv_l3.ROI.rows);
-					goto AF3;
-				}
-				if (cnn.conv_l3.size.rows == 7 && cnn.conv_l3.size.cols == 7)
+				if (cnn.calibration)
 				{
-					cnnpp.conv_7x7(cnn.layer_buffer[2].conv_buffer[2 * i](), cnn.layer_buffer[2].conv_buffer_size.cols, cnn.layer_buffer[1].sum_buffer[i](), cnn.layer_buffer[1].pool_buffer_size.cols, cnn.layer_buffer[1].pool_buffer_size.rows, cnn.conv_l3.kernels[2 * i](), cnn.conv_l3.ROI.cols, cnn.conv_l3.ROI.rows);
-					cnnpp.conv_7x7(cnn.layer_buffer[2].conv_buffer[2 * i + 1](), cnn.layer_buffer[2].conv_buffer_size.cols, cnn.layer_buffer[1].sum_buffer[i](), cnn.layer_buffer[1].pool_buffer_size.cols, cnn.layer_buffer[1].pool_buffer_size.rows, cnn.conv_l3.kernels[2 * i + 1](), cnn.conv_l3.ROI.cols, cnn.conv_l3.ROI.rows);
-					goto AF3;
+					UpdateCalibrationRange(2, sum, cnn.layer_buffer[1].pool_buffer_size.cols, cnn.conv_l2.ROI.cols >> 1, cnn.conv_l2.ROI.rows >> 1);
 				}
-				if (cnn.conv_l3.size.rows == 8 && cnn.conv_l3.size.cols == 8)
-				{
-					cnnpp.conv_8x8(cnn.layer_buffer[2].conv_buffer[2 * i](), cnn.layer_buffer[2].conv_buffer_size.cols, cnn.layer_buffer[1].sum_buffer[i](), cnn.layer_buffer[1].pool_buffer_size.cols, cnn.layer_buffer[1].pool_buffer_size.rows, cnn.conv_l3.kernels[2 * i](), cnn.conv_l3.ROI.cols, cnn.conv_l3.ROI.rows);
-					cnnpp.conv_8x8(cnn.layer_buffer[2].conv_buffer[2 * i + 1](), cnn.layer_buffer[2].conv_buffer_size.cols, cnn.layer_buffer[1].sum_buffer[i](), cnn.layer_buffer[1].pool_buffer_size.cols, cnn.layer_buffer[1].pool_buffer_size.rows, cnn.conv_l3.kernels[2 * i + 1](), cnn.conv_l3.ROI.cols, cnn.conv_l3.ROI.rows);
-					goto AF3;
-				}
-				if (cnn.conv_l3.size.rows == 11 && cnn.conv_l3.size.cols == 10)
-				{
-					cnnpp.conv_11x10(cnn.layer_buffer[2].conv_buffer[2 * i](), cnn.layer_buffer[2].conv_buffer_size.cols, cnn.layer_buffer[1].sum_buffer[i](), cnn.layer_buffer[1].pool_buffer_size.cols, cnn.layer_buffer[1].pool_buffer_size.rows, cnn.conv_l3.kernels[2 * i](), cnn.conv_l3.ROI.cols, cnn.conv_l3.ROI.rows);
-					cnnpp.conv_11x10(cnn.layer_buffer[2].conv_buffer[2 * i + 1](), cnn.layer_buffer[2].conv_buffer_size.cols, cnn.layer_buffer[1].sum_buffer[i](), cnn.layer_buffer[1].pool_buffer_size.cols, cnn.layer_buffer[1].pool_buffer_size.rows, cnn.conv_l3.kernels[2 * i + 1](), cnn.conv_l3.ROI.cols, cnn.conv_l3.ROI.rows);
-					goto AF3;
-				}
-				if (cnn.conv_l3.size.rows == 11 && cnn.conv_l3.size.cols == 11)
-				{
-					cnnpp.conv_11x11(cnn.layer_buffer[2].conv_buffer[2 * i](), cnn.layer_buffer[2].conv_buffer_size.cols, cnn.layer_buffer[1].sum_buffer[i](), cnn.layer_buffer[1].pool_buffer_size.cols, cnn.layer_buffer[1].pool_buffer_size.rows, cnn.conv_l3.kernels[2 * i](), cnn.conv_l3.ROI.cols, cnn.conv_l3.ROI.rows);
-					cnnpp.conv_11x11(cnn.layer_buffer[2].conv_buffer[2 * i + 1](), cnn.layer_buffer[2].conv_buffer_size.cols, cnn.layer_buffer[1].sum_buffer[i](), cnn.layer_buffer[1].pool_buffer_size.cols, cnn.layer_buffer[1].pool_buffer_size.rows, cnn.conv_l3.kernels[2 * i + 1](), cnn.conv_l3.ROI.cols, cnn.conv_l3.ROI.rows);
-					goto AF3;
-				}
-				AF3:
-				cnnpp.lrelu_bn(cnn.layer_buffer[2].pool_buffer[2 * i](), cnn.layer_buffer[2].conv_buffer[2 * i](), cnn.layer_buffer[2].pool_buffer_size.size, &(cnn.conv_bias[2][2 * i]), &(cnn.leakyReLU_w1[2][2 * i]), &(cnn.leakyReLU_w2[2][2 * i]), &(cnn.bn_weight[2][2 * i]), &(cnn.bn_bias[2][2 * i]));
-				cnnpp.lrelu_bn(cnn.layer_buffer[2].pool_buffer[2 * i + 1](), cnn.layer_buffer[2].conv_buffer[2 * i + 1](), cnn.layer_buffer[2].pool_buffer_size.size, &(cnn.conv_bias[2][2 * i + 1]), &(cnn.leakyReLU_w1[2][2 * i + 1]), &(cnn.leakyReLU_w2[2][2 * i + 1]), &(cnn.bn_weight[2][2 * i + 1]), &(cnn.bn_bias[2][2 * i + 1]));
+
+				float* dst[2] = { cnn.layer_buffer[2].pool_buffer[2 * i](), cnn.layer_buffer[2].pool_buffer[2 * i + 1]() };
+				ConvMaps_L3(dst, i, sum);
 			}
 
 			//for (int i = 0; i < cnn.layer_buffer[2].map_count; ++i)
@@ -868,88 +1012,94 @@ namespace NeuralNetworksLib
 
 #ifdef PROFILE_CNN_SIMD
 			printf("	cnn_simd: run_L3 = %7.3f ms (sum, conv_l3, tanh_tanh)\n", timer.get(1000));
-			timer.start();
 #endif
 
-			const int it3 = cnn.snn_hl_size;
-			it2 = it2 << 1; // mul on 2;
-			//OMP_PRAGMA(omp parallel for num_threads(num_threads))			
-			for (int i = 0; i < (it3 / cnn.hl_scale); ++i)
+			Run_HL();
+		}
+		void ConvNeuralNetwork::Run_HL()
+		{
+#ifdef PROFILE_CNN_SIMD
+			Timer timer(1, true);
+#endif
+
+			float* ol_buffer = cnn.ol_buffer();
+			const int size = cnn.layer_buffer[2].pool_buffer_size.size;
+
+			//hidden and output layers are pointwise: they run on strips of hl_strip values of maps, so hidden maps of a strip stay in cache
+			for (int offset = 0; offset < size; offset += cnn.hl_strip)
 			{
-				for (int t = 0; t < cnn.hl_scale; ++t)
+				const int strip = MIN(cnn.hl_strip, size - offset);
+				for (int k = 0; k < cnn.layer_buffer[2].map_count; ++k)
 				{
-					cnnpp.mulCN_add_tanhW(cnn.snn_connect_count, cnn.hl_buffer[cnn.hl_scale * i + t](), cnn.pool3_buffer_ref(i), cnn.layer_buffer[2].pool_buffer_size.size, cnn.snn_hl_weight[cnn.hl_scale * i + t](), &(cnn.snn_hl_bias[cnn.hl_scale * i + t]), &(cnn.snn_hl_tanh_w[i]), &(cnn.snn_hl_bn_weight[t]), &(cnn.snn_hl_bn_bias[t]));
+					cnn.pool3_strip[k] = cnn.layer_buffer[2].pool_buffer[k]() + offset;
 				}
-			}
 
-			if (cnn.index_output >= 0)
-			{
+				const int it3 = cnn.snn_hl_size;
+				//OMP_PRAGMA(omp parallel for num_threads(num_threads))			
 				for (int i = 0; i < (it3 / cnn.hl_scale); ++i)
 				{
 					for (int t = 0; t < cnn.hl_scale; ++t)
 					{
-						if (i == 0 && t == 0) {
-							cnnpp.mulC(cnn.ol_buffer(), cnn.hl_buffer[cnn.hl_scale * i + t](), cnn.layer_buffer[2].pool_buffer_size.size, &(cnn.snn_ol_weight[cnn.index_output][t * (it3 / cnn.hl_scale) + i]));
-						}
-						else {
-							cnnpp.mulC1_add(cnn.ol_buffer(), cnn.hl_buffer[cnn.hl_scale * i + t](), cnn.ol_buffer(), cnn.layer_buffer[2].pool_buffer_size.size, &(cnn.snn_ol_weight[cnn.index_output][t * (it3 / cnn.hl_scale) + i]));
-						}
+						cnnpp.mulCN_add_tanhW(cnn.snn_connect_count, cnn.hl_buffer[cnn.hl_scale * i + t](offset), cnn.pool3_strip.data() + i, strip, cnn.snn_hl_weight[cnn.hl_scale * i + t](), &(cnn.snn_hl_bias[cnn.hl_scale * i + t]), &(cnn.snn_hl_tanh_w[i]), &(cnn.snn_hl_bn_weight[t]), &(cnn.snn_hl_bn_bias[t]));
 					}
 				}
 
-				cnnpp.tanhW(cnn.ol_buffer(), cnn.ol_buffer(), cnn.ol_buffer_size.size, &(cnn.snn_ol_bias[cnn.index_output]), &(cnn.snn_ol_tanh_w), &(cnn.af_scale));			}
-			else
-			{
-#if 0
-				//RTSD
-				float max_val = -1000.f;
-				int max_id = 0;
-
-				for (int out_id = 0; out_id < cnn.snn_ol_neuron_count; ++out_id)
+				if (!cnn.heads.empty())
+				{
+					//ForwardOutputs: output neurons of heads on one hidden layer, af_scale as of Init with index_output of head
+					//(networks of all outputs keep af_scale, as their Forward does)
+					for (int j = 0; j < (int)cnn.heads.size(); ++j)
+					{
+						float af_scale = cnn.index_output < 0 ? cnn.af_scale : cnn.heads[j] == 0 ? -fabsf(cnn.af_scale) : fabsf(cnn.af_scale);
+						Run_OL(cnn.heads_buffer(j * size), offset, strip, cnn.heads[j], &af_scale);
+					}
+				}
+				else if (cnn.index_output >= 0)
 				{
-					if (out_id == 26) continue;
-					if (out_id == 29) continue;
-					if (out_id == 30) continue;
-					if (out_id == 31) continue;
+					Run_OL(ol_buffer, offset, strip, cnn.index_output, &(cnn.af_scale));
+				}
+				else
+				{
+#if 0
+					//RTSD
+					float max_val = -1000.f;
+					int max_id = 0;
 
-					for (int i = 0; i < (it3 / cnn.hl_scale); ++i)
+					for (int out_id = 0; out_id < cnn.snn_ol_neuron_count; ++out_id)
 					{
-						for (int t = 0; t < cnn.hl_scale; ++t)
+						if (out_id == 26) continue;
+						if (out_id == 29) continue;
+						if (out_id == 30) continue;
+						if (out_id == 31) continue;
+
+						for (int i = 0; i < (it3 / cnn.hl_scale); ++i)
 						{
-							if (i == 0 && t == 0)
-								cnnpp.mulC(cnn.ol_buffer(), cnn.hl_buffer[cnn.hl_scale * i + t](), cnn.layer_buffer[2].pool_buffer_size.size, &(cnn.snn_ol_weight[out_id][t * (it3 / cnn.hl_scale) + i]));
-							else
-								cnnpp.mulC1_add(cnn.ol_buffer(), cnn.hl_buffer[cnn.hl_scale * i + t](), cnn.ol_buffer(), cnn.layer_buffer[2].pool_buffer_size.size, &(cnn.snn_ol_weight[out_id][t * (it3 / cnn.hl_scale) + i]));
+							for (int t = 0; t < cnn.hl_scale; ++t)
+							{
+								if (i == 0 && t == 0)
+									cnnpp.mulC(ol_buffer, cnn.hl_buffer[cnn.hl_scale * i + t](), size, &(cnn.snn_ol_weight[out_id][t * (it3 / cnn.hl_scale) + i]));
+								else
+									cnnpp.mulC1_add(ol_buffer, cnn.hl_buffer[cnn.hl_scale * i + t](), ol_buffer, size, &(cnn.snn_ol_weight[out_id][t * (it3 / cnn.hl_scale) + i]));
+							}
 						}
-					}
 
-					cnnpp.tanhW(cnn.ol_buffer(), cnn.ol_buffer(), cnn.ol_buffer_size.size, &(cnn.snn_ol_bias[out_id]), &(cnn.snn_ol_tanh_w), &(cnn.af_scale));
-					//printf("%f\n", cnn.ol_buffer[0]);
-					if (max_val < cnn.ol_buffer[0])
-					{
-						max_id = out_id;
-						max_val = cnn.ol_buffer[0];
+						cnnpp.tanhW(ol_buffer, ol_buffer, size, &(cnn.snn_ol_bias[out_id]), &(cnn.snn_ol_tanh_w), &(cnn.af_scale));
+						//printf("%f\n", ol_buffer[0]);
+						if (max_val < ol_buffer[0])
+						{
+							max_id = out_id;
+							max_val = ol_buffer[0];
+						}
 					}
-				}
 
-				if (max_id == 21) max_id = 27;
-				cnn.ol_buffer[0] = float(max_id);
+					if (max_id == 21) max_id = 27;
+					ol_buffer[0] = float(max_id);
 #endif
 
-				for (int out_id = 0; out_id < cnn.snn_ol_neuron_count; ++out_id)
-				{
-					for (int i = 0; i < (it3 / cnn.hl_scale); ++i)
+					for (int out_id = 0; out_id < cnn.snn_ol_neuron_count; ++out_id)
 					{
-						for (int t = 0; t < cnn.hl_scale; ++t)
-						{
-							if (i == 0 && t == 0)
-								cnnpp.mulC(cnn.ol_buffer(out_id * cnn.layer_buffer[2].pool_buffer_size.size), cnn.hl_buffer[cnn.hl_scale * i + t](), cnn.layer_buffer[2].pool_buffer_size.size, &(cnn.snn_ol_weight[out_id][t * (it3 / cnn.hl_scale) + i]));
-							else
-								cnnpp.mulC1_add(cnn.ol_buffer(out_id * cnn.layer_buffer[2].pool_buffer_size.size), cnn.hl_buffer[cnn.hl_scale * i + t](), cnn.ol_buffer(out_id * cnn.layer_buffer[2].pool_buffer_size.size), cnn.layer_buffer[2].pool_buffer_size.size, &(cnn.snn_ol_weight[out_id][t * (it3 / cnn.hl_scale) + i]));
-						}
+						Run_OL(ol_buffer + out_id * size, offset, strip, out_id, &(cnn.af_scale));
 					}
-
-					cnnpp.tanhW(cnn.ol_buffer(out_id * cnn.layer_buffer[2].pool_buffer_size.size), cnn.ol_buffer(out_id * cnn.layer_buffer[2].pool_buffer_size.size), cnn.layer_buffer[2].pool_buffer_size.size, &(cnn.snn_ol_bias[out_id]), &(cnn.snn_ol_tanh_w), &(cnn.af_scale));
 				}
 			}
 
@@ -961,8 +1111,198 @@ namespace NeuralNetworksLib
 			printf("	cnn_simd: run_HL = %7.3f ms (sum, mul, tanh, sum, tanh)\n", timer.get(1000));
 #endif
 		}
+		void ConvNeuralNetwork::Run_OL(float* ol_buffer, int offset, int size, int out_id, float* af_scale)
+		{
+			ol_buffer += offset;
+			const int it3 = cnn.snn_hl_size;
+			for (int i = 0; i < (it3 / cnn.hl_scale); ++i)
+			{
+				for (int t = 0; t < cnn.hl_scale; ++t)
+				{
+					if (i == 0 && t == 0)
+						cnnpp.mulC(ol_buffer, cnn.hl_buffer[cnn.hl_scale * i + t](offset), size, &(cnn.snn_ol_weight[out_id][t * (it3 / cnn.hl_scale) + i]));
+					else
+						cnnpp.mulC1_add(ol_buffer, cnn.hl_buffer[cnn.hl_scale * i + t](offset), size, &(cnn.snn_ol_weight[out_id][t * (it3 / cnn.hl_scale) + i]));
+				}
+			}
+
+			cnnpp.tanhW(ol_buffer, ol_buffer, size, &(cnn.snn_ol_bias[out_id]), &(cnn.snn_ol_tanh_w), af_scale);
+		}
+		void ConvNeuralNetwork::Conv_L1(float* dst, int i, Image_32f& image)
+		{
+			if (cnn.winograd_layers & 1)
+			{
+				cnnpp.conv_3x3_lrelu_bn_max_wino(dst, cnn.layer_buffer[0].pool_buffer_size.cols, image.data, image.widthStep, cnn.input_buffer_size.rows, cnn.conv_l1.wino_kernels[i](), &(cnn.conv_bias[0][i]), &(cnn.leakyReLU_w1[0][i]), &(cnn.leakyReLU_w2[0][i]), &(cnn.bn_weight[0][i]), &(cnn.bn_bias[0][i]), cnn.conv_l1.ROI.cols, cnn.conv_l1.ROI.rows);
+				return;
+			}
+
+			if (cnn.conv_l1.size.rows == 4 && cnn.conv_l1.size.cols == 4)
+			{
+				cnnpp.conv_4x4(cnn.layer_buffer[0].conv_buffer[i](), cnn.layer_buffer[0].conv_buffer_size.cols, image.data, image.widthStep, cnn.input_buffer_size.rows, cnn.conv_l1.kernels[i](), cnn.conv_l1.ROI.cols, cnn.conv_l1.ROI.rows);
+				goto AF1;
+			}
+			if (cnn.conv_l1.size.rows == 3 && cnn.conv_l1.size.cols == 3)
+			{
+				cnnpp.conv_3x3(cnn.layer_buffer[0].conv_buffer[i](), cnn.layer_buffer[0].conv_buffer_size.cols, image.data, image.widthStep, cnn.input_buffer_size.rows, cnn.conv_l1.kernels[i](), cnn.conv_l1.ROI.cols, cnn.conv_l1.ROI.rows);
+				goto AF1;
+			}
+			AF1:
+			cnnpp.lrelu_bn_max(dst, cnn.layer_buffer[0].pool_buffer_size.cols, cnn.layer_buffer[0].conv_buffer[i](), cnn.layer_buffer[0].conv_buffer_size.cols, cnn.layer_buffer[0].conv_buffer_size.rows, &(cnn.conv_bias[0][i]), &(cnn.leakyReLU_w1[0][i]), &(cnn.leakyReLU_w2[0][i]), &(cnn.bn_weight[0][i]), &(cnn.bn_bias[0][i]));
+		}
+		void ConvNeuralNetwork::Conv_L2(float* dst, int i, float* src)
+		{
+			if (cnn.winograd_layers & 2)
+			{
+				cnnpp.conv_3x3_lrelu_bn_max_wino(dst, cnn.layer_buffer[1].pool_buffer_size.cols, src, cnn.layer_buffer[0].pool_buffer_size.cols, cnn.layer_buffer[0].pool_buffer_size.rows, cnn.conv_l2.wino_kernels[i](), &(cnn.conv_bias[1][i]), &(cnn.leakyReLU_w1[1][i]), &(cnn.leakyReLU_w2[1][i]), &(cnn.bn_weight[1][i]), &(cnn.bn_bias[1][i]), cnn.conv_l2.ROI.cols, cnn.conv_l2.ROI.rows);
+				return;
+			}
+
+			cnnpp.conv_3x3(cnn.layer_buffer[1].conv_buffer[i](), cnn.layer_buffer[1].conv_buffer_size.cols, src, cnn.layer_buffer[0].pool_buffer_size.cols, cnn.layer_buffer[0].pool_buffer_size.rows, cnn.conv_l2.kernels[i](), cnn.conv_l2.ROI.cols, cnn.conv_l2.ROI.rows);
+			cnnpp.lrelu_bn_max(dst, cnn.layer_buffer[1].pool_buffer_size.cols, cnn.layer_buffer[1].conv_buffer[i](), cnn.layer_buffer[1].conv_buffer_size.cols, cnn.layer_buffer[1].conv_buffer_size.rows, &(cnn.conv_bias[1][i]), &(cnn.leakyReLU_w1[1][i]), &(cnn.leakyReLU_w2[1][i]), &(cnn.bn_weight[1][i]), &(cnn.bn_bias[1][i]));
+		}
+		void ConvNeuralNetwork::Conv_L3(float* dst, int i, float* src)
+		{
+			float* conv = cnn.layer_buffer[2].conv_buffer[i]();
+			const int conv_size_l = cnn.layer_buffer[2].conv_buffer_size.cols;
+			const int src_size_l = cnn.layer_buffer[1].pool_buffer_size.cols;
+			const int src_size_h = cnn.layer_buffer[1].pool_buffer_size.rows;
+			float* kernel = cnn.conv_l3.kernels[i]();
+
+			if (cnn.conv_l3.size.rows == 8 && cnn.conv_l3.size.cols == 7)
+			{
+				cnnpp.conv_8x7(conv, conv_size_l, src, src_size_l, src_size_h, kernel, cnn.conv_l3.ROI.cols, cnn.conv_l3.ROI.rows);
+				goto AF3;
+			}
+			if (cnn.winograd_layers & 4)
+			{
+				cnnpp.conv_3x3_wino(conv, conv_size_l, src, src_size_l, src_size_h, cnn.conv_l3.wino_kernels[i](), cnn.conv_l3.ROI.cols, cnn.conv_l3.ROI.rows);
+				goto AF3;
+			}
+			if (cnn.conv_l3.size.rows == 3 && cnn.conv_l3.size.cols == 3)
+			{
+				cnnpp.conv_3x3(conv, conv_size_l, src, src_size_l, src_size_h, kernel, cnn.conv_l3.ROI.cols, cnn.conv_l3.ROI.rows);
+				goto AF3;
+			}
+			if (cnn.conv_l3.size.rows == 4 && cnn.conv_l3.size.cols == 4)
+			{
+				cnnpp.conv_4x4(conv, conv_size_l, src, src_size_l, src_size_h, kernel, cnn.conv_l3.ROI.cols, cnn.conv_l3.ROI.rows);
+				goto AF3;
+			}
+			if (cnn.conv_l3.size.rows == 5 && cnn.conv_l3.size.cols == 4)
+			{
+				cnnpp.conv_5x4(conv, conv_size_l, src, src_size_l, src_size_h, kernel, cnn.conv_l3.ROI.cols, cnn.conv_l3.ROI.rows);
+				goto AF3;
+			}
+			if (cnn.conv_l3.size.rows == 5 && cnn.conv_l3.size.cols == 5)
+			{
+				cnnpp.conv_5x5(conv, conv_size_l, src, src_size_l, src_size_h, kernel, cnn.conv_l3.ROI.cols, cnn.conv_l3.ROI.rows);
+				goto AF3;
+			}
+			if (cnn.conv_l3.size.rows == 6 && cnn.conv_l3.size.cols == 5)
+			{
+				cnnpp.conv_6x5(conv, conv_size_l, src, src_size_l, src_size_h, kernel, cnn.conv_l3.ROI.cols, cnn.conv_l3.ROI.rows);
+				goto AF3;
+			}
+			if (cnn.conv_l3.size.rows == 6 && cnn.conv_l3.size.cols == 6)
+			{
+				cnnpp.conv_6x6(conv, conv_size_l, src, src_size_l, src_size_h, kernel, cnn.conv_l3.ROI.cols, cnn.conv_l3.ROI.rows);
+				goto AF3;
+			}
+			if (cnn.conv_l3.size.rows == 7 && cnn.conv_l3.size.cols == 7)
+			{
+				cnnpp.conv_7x7(conv, conv_size_l, src, src_size_l, src_size_h, kernel, cnn.conv_l3.ROI.cols, cnn.conv_l3.ROI.rows);
+				goto AF3;
+			}
+			if (cnn.conv_l3.size.rows == 8 && cnn.conv_l3.size.cols == 8)
+			{
+				cnnpp.conv_8x8(conv, conv_size_l, src, src_size_l, src_size_h, kernel, cnn.conv_l3.ROI.cols, cnn.conv_l3.ROI.rows);
+				goto AF3;
+			}
+			if (cnn.conv_l3.size.rows == 11 && cnn.conv_l3.size.cols == 10)
+			{
+				cnnpp.conv_11x10(conv, conv_size_l, src, src_size_l, src_size_h, kernel, cnn.conv_l3.ROI.cols, cnn.conv_l3.ROI.rows);
+				goto AF3;
+			}
+			if (cnn.conv_l3.size.rows == 11 && cnn.conv_l3.size.cols == 11)
+			{
+				cnnpp.conv_11x11(conv, conv_size_l, src, src_size_l, src_size_h, kernel, cnn.conv_l3.ROI.cols, cnn.conv_l3.ROI.rows);
+				goto AF3;
+			}
+			AF3:
+			cnnpp.lrelu_bn(dst, conv, cnn.layer_buffer[2].pool_buffer_size.size, &(cnn.conv_bias[2][i]), &(cnn.leakyReLU_w1[2][i]), &(cnn.leakyReLU_w2[2][i]), &(cnn.bn_weight[2][i]), &(cnn.bn_bias[2][i]));
+		}
+		void ConvNeuralNetwork::ConvMaps_L1(float** dst, Image_32f& image)
+		{
+			if (cnn.conv_l1.conv_fixed != nullptr)
+			{
+				cnn.conv_l1.conv_fixed(dst, cnn.layer_buffer[0].pool_buffer_size.cols, image.data, image.widthStep, cnn.conv_l1.gemm_kernels(),
+									   cnn.conv_bias[0](), cnn.leakyReLU_w1[0](), cnn.leakyReLU_w2[0](), cnn.bn_bias[0]());
+				return;
+			}
+
+			if (cnn.template_layers & 1)
+			{
+				cnn.conv_l1.conv_template(dst, cnn.layer_buffer[0].pool_buffer_size.cols, image.data, image.widthStep, cnn.conv_l1.gemm_kernels(),
+										  cnn.conv_bias[0](), cnn.leakyReLU_w1[0](), cnn.leakyReLU_w2[0](), cnn.bn_bias[0](), cnn.conv_l1.ROI.cols, cnn.conv_l1.ROI.rows);
+				return;
+			}
+
+			//OMP_PRAGMA(omp parallel for num_threads(num_threads))
+			for (int i = 0; i < cnn.layer_buffer[0].map_count; ++i)
+			{
+				Conv_L1(dst[i], i, image);
+			}
+		}
+		void ConvNeuralNetwork::ConvMaps_L2(float** dst, int i, float* src)
+		{
+			if (cnn.conv_l2.conv_fixed != nullptr)
+			{
+				const int k = 2 * i;
+				cnn.conv_l2.conv_fixed(dst, cnn.layer_buffer[1].pool_buffer_size.cols, src, cnn.layer_buffer[0].pool_buffer_size.cols, cnn.conv_l2.gemm_kernels(k * cnn.conv_l2.size.size),
+									   &(cnn.conv_bias[1][k]), &(cnn.leakyReLU_w1[1][k]), &(cnn.leakyReLU_w2[1][k]), &(cnn.bn_bias[1][k]));
+				return;
+			}
+
+			if (cnn.template_layers & 2)
+			{
+				const int k = 2 * i;
+				cnn.conv_l2.conv_template(dst, cnn.layer_buffer[1].pool_buffer_size.cols, src, cnn.layer_buffer[0].pool_buffer_size.cols, cnn.conv_l2.gemm_kernels(k * cnn.conv_l2.size.size),
+										  &(cnn.conv_bias[1][k]), &(cnn.leakyReLU_w1[1][k]), &(cnn.leakyReLU_w2[1][k]), &(cnn.bn_bias[1][k]), cnn.conv_l2.ROI.cols, cnn.conv_l2.ROI.rows);
+				return;
+			}
+
+			Conv_L2(dst[0], 2 * i, src);
+			Conv_L2(dst[1], 2 * i + 1, src);
+		}
+		void ConvNeuralNetwork::ConvMaps_L3(float** dst, int i, float* src)
+		{
+			if (cnn.conv_l3.conv_fixed != nullptr)
+			{
+				const int k = 2 * i;
+				cnn.conv_l3.conv_fixed(dst, cnn.layer_buffer[2].pool_buffer_size.cols, src, cnn.layer_buffer[1].pool_buffer_size.cols, cnn.conv_l3.gemm_kernels(k * cnn.conv_l3.size.size),
+									   &(cnn.conv_bias[2][k]), &(cnn.leakyReLU_w1[2][k]), &(cnn.leakyReLU_w2[2][k]), &(cnn.bn_bias[2][k]));
+				return;
+			}
+
+			if (cnn.template_layers & 4)
+			{
+				const int k = 2 * i;
+				cnn.conv_l3.conv_template(dst, cnn.layer_buffer[2].pool_buffer_size.cols, src, cnn.layer_buffer[1].pool_buffer_size.cols, cnn.conv_l3.gemm_kernels(k * cnn.conv_l3.size.size),
+										  &(cnn.conv_bias[2][k]), &(cnn.leakyReLU_w1[2][k]), &(cnn.leakyReLU_w2[2][k]), &(cnn.bn_bias[2][k]), cnn.conv_l3.ROI.cols, cnn.conv_l3.ROI.rows);
+				return;
+			}
+
+			Conv_L3(dst[0], 2 * i, src);
+			Conv_L3(dst[1], 2 * i + 1, src);
+		}
 		void ConvNeuralNetwork::Forward(Image_32f& response_map, Image_32f& image)
 		{
+			if (graph != nullptr)
+			{
+				graph->Forward(response_map, image);
+				return;
+			}
+
 			if (image.width != cnn.input_buffer_size.cols || image.height != cnn.input_buffer_size.rows)
 			{
 				if (image.width < cnn.min_image_size.width || image.height < cnn.min_image_size.height ||
@@ -993,9 +1333,78 @@ namespace NeuralNetworksLib
 				response_map.copyData(cnn.output_buffer_size.cols, cnn.output_buffer_size.rows, cnn.ol_buffer(), cnn.output_buffer_size.step);
 			}
 		}
+		void ConvNeuralNetwork::ForwardOutputs(std::vector<Image_32f>& response_maps, Image_32f& image, const std::vector<int>& index_outputs)
+		{
+			const int count = (int)index_outputs.size();
+			response_maps.resize(count);
+			if (count == 0) return;
+
+			if (graph != nullptr || cnn.snn_ol_neuron_count == 0)
+			{
+				printf("[SIMD::CNN] ForwardOutputs is not supported by layer graph models!\n");
+				for (int j = 0; j < count; ++j)
+				{
+					response_maps[j].width = 0;
+					response_maps[j].height = 0;
+				}
+				return;
+			}
+
+			if (image.width != cnn.input_buffer_size.cols || image.height != cnn.input_buffer_size.rows)
+			{
+				if (image.width < cnn.min_image_size.width || image.height < cnn.min_image_size.height ||
+					image.width > cnn.max_image_size.width || image.height > cnn.max_image_size.height)
+				{
+					for (int j = 0; j < count; ++j)
+					{
+						response_maps[j].width = 0;
+						response_maps[j].height = 0;
+					}
+					return;
+				}
+
+				ResizeBuffers(image.getSize());
+			}
+
+			const Size2d& map_size = cnn.layer_buffer[2].pool_buffer_size;
+			if (cnn.heads_buffer.size < count * map_size.size)
+			{
+				cnn.heads_buffer = Array_32f(count * map_size.size, ALIGN_DEF);
+			}
+
+			cnn.heads.resize(count);
+			for (int j = 0; j < count; ++j)
+			{
+				cnn.heads[j] = MIN(MAX(0, index_outputs[j]), cnn.snn_ol_neuron_count - 1);
+			}
+
+			Run(image);
+			cnn.heads.clear();
+
+			for (int j = 0; j < count; ++j)
+			{
+				Image_32f& response_map = response_maps[j];
+				if (response_map.isEmpty() || response_map.sharingData)
+				{
+					response_map.width = cnn.conv_l3.ROI.cols;
+					response_map.height = cnn.conv_l3.ROI.rows;
+					response_map.widthStep = map_size.cols;
+					response_map.data = cnn.heads_buffer(j * map_size.size);
+					response_map.sharingData = true;
+				}
+				else
+				{
+					response_map.width = cnn.conv_l3.ROI.cols;
+					response_map.height = cnn.conv_l3.ROI.rows;
+					response_map.copyData(cnn.conv_l3.ROI.cols, cnn.conv_l3.ROI.rows, cnn.heads_buffer(j * map_size.size), map_size.cols);
+				}
+			}
+		}
 
 		Size ConvNeuralNetwork::getOutputImgSize(const Size size)
 		{
+			if (graph != nullptr) return graph->getOutputImgSize(size);
+
 			//size layer1
 			int cnn_conv_l1_ROI_cols = size.width - (cnn.conv_l1.size.cols - 1);
 			int cnn_conv_l1_ROI_rows = size.height - (cnn.conv_l1.size.rows - 1);
@@ -1011,6 +1420,313 @@ namespace NeuralNetworksLib
 			return Size(cnn_conv_l3_ROI_cols, cnn_conv_l3_ROI_rows);
 		}
 
+		Size ConvNeuralNetwork::getFeatureMapsSize(const Size size)
+		{
+			if (graph != nullptr) return Size(0, 0);
+
+			//size layer2
+			int cnn_conv_l2_ROI_cols = ((size.width - (cnn.conv_l1.size.cols - 1)) >> 1) - (cnn.conv_l2.size.cols - 1);
+			int cnn_conv_l2_ROI_rows = ((size.height - (cnn.conv_l1.size.rows - 1)) >> 1) - (cnn.conv_l2.size.rows - 1);
+
+			return Size(cnn_conv_l2_ROI_cols >> 1, cnn_conv_l2_ROI_rows >> 1);
+		}
+		void ConvNeuralNetwork::getFeatureMaps(Image_32f& maps)
+		{
+			if (graph != nullptr || cnn.quantized) return;
+
+			const int cols = cnn.conv_l2.ROI.cols >> 1;
+			const int rows = cnn.conv_l2.ROI.rows >> 1;
+			const int map_count = cnn.layer_buffer[1].map_count;
+
+			if (maps.width != cols || maps.height != map_count * rows)
+			{
+				maps = Image_32f(cols, map_count * rows, ALIGN_DEF, false);
+			}
+
+			for (int i = 0; i < map_count; ++i)
+			{
+				for (int y = 0; y < rows; ++y)
+				{
+					memcpy(maps.data + (i * rows + y) * maps.widthStep, cnn.layer_buffer[1].pool_buffer[i](y * cnn.layer_buffer[1].pool_buffer_size.cols), cols * sizeof(float));
+				}
+			}
+		}
+		void ConvNeuralNetwork::ForwardFeatureMaps(Image_32f& response_map, Image_32f& maps, const Size size)
+		{
+			if (graph != nullptr || cnn.quantized)
+			{
+				response_map.width = 0;
+				response_map.height = 0;
+				return;
+			}
+
+			if (size.width != cnn.input_buffer_size.cols || size.height != cnn.input_buffer_size.rows)
+			{
+				if (size.width < cnn.min_image_size.width || size.height < cnn.min_image_size.height ||
+					size.width > cnn.max_image_size.width || size.height > cnn.max_image_size.height)
+				{
+					response_map.width = 0;
+					response_map.height = 0;
+					return;
+				}
+
+				ResizeBuffers(size);
+			}
+
+			const int cols = cnn.conv_l2.ROI.cols >> 1;
+			const int rows = cnn.conv_l2.ROI.rows >> 1;
+			const int map_count = cnn.layer_buffer[1].map_count;
+
+			if (maps.width != cols || maps.height != map_count * rows)
+			{
+				response_map.width = 0;
+				response_map.height = 0;
+				return;
+			}
+
+			for (int i = 0; i < map_count; ++i)
+			{
+				for (int y = 0; y < rows; ++y)
+				{
+					memcpy(cnn.layer_buffer[1].pool_buffer[i](y * cnn.layer_buffer[1].pool_buffer_size.cols), maps.data + (i * rows + y) * maps.widthStep, cols * sizeof(float));
+				}
+			}
+
+			Run_L3();
+
+			if (response_map.isEmpty())
+			{
+				response_map.width = cnn.output_buffer_size.cols;
+				response_map.height = cnn.output_buffer_size.rows;
+				response_map.widthStep = cnn.output_buffer_size.step;
+				response_map.data = cnn.ol_buffer();
+				response_map.sharingData = true;
+			}
+			else
+			{
+				response_map.width = cnn.output_buffer_size.cols;
+				response_map.height = cnn.output_buffer_size.rows;
+				response_map.copyData(cnn.output_buffer_size.cols, cnn.output_buffer_size.rows, cnn.ol_buffer(), cnn.output_buffer_size.step);
+			}
+		}
+
+		float* ConvNeuralNetwork::SumPoolMaps(int layer, int i, int it)
+		{
+			Layer_buffer& buffer = cnn.layer_buffer[layer];
+			if (i > 0 && i < it - 1)
+			{
+				cnnpp.add2(buffer.sum_buffer[i](), buffer.pool_buffer[i - 1](), buffer.pool_buffer[i](), buffer.pool_buffer[i + 1](), buffer.pool_buffer_size.size);
+			}
+			else
+			{
+				if (i == 0)
+				{
+					cnnpp.add(buffer.sum_buffer[0](), buffer.pool_buffer[0](), buffer.pool_buffer[1](), buffer.pool_buffer_size.size);
+				}
+				else
+				{
+					const int t = buffer.map_count;
+					cnnpp.add(buffer.sum_buffer[t - 1](), buffer.pool_buffer[t - 2](), buffer.pool_buffer[t - 1](), buffer.pool_buffer_size.size);
+				}
+			}
+			return buffer.sum_buffer[i]();
+		}
+		void ConvNeuralNetwork::Run_Q8(Image_32f& image)
+		{
+#ifdef USE_AVX2
+			//layers 1, 2 write u8 inputs of next layer, layer 3 writes float maps of hidden layer
+			ConvTemplate::quantizeQ8(cnn.q8_input_buffer(), cnn.q8_input_step, image.data, image.widthStep, image.width, image.height, cnn.conv_l1.q8_inv_scale, cnn.conv_l1.q8_zero_point);
+
+			const uchar_* src[ConvTemplate::Q8_MAX_MAPS];
+			uchar_* dst[ConvTemplate::Q8_MAX_MAPS];
+
+			src[0] = cnn.q8_input_buffer();
+			for (int i = 0; i < cnn.layer_buffer[0].map_count; ++i)
+			{
+				dst[i] = cnn.layer_buffer[0].q8_buffer[i]();
+			}
+			cnn.conv_l1.q8_pool_kernel(dst, cnn.layer_buffer[0].pool_buffer_size.cols, src, cnn.q8_input_step, 1, cnn.conv_l1.q8_kernels.data(), cnn.conv_l1.q8_params(),
+									   cnn.conv_l2.q8_inv_scale, cnn.conv_l2.q8_zero_point, cnn.conv_l1.ROI.cols, cnn.conv_l1.ROI.rows);
+
+			for (int i = 0; i < cnn.layer_buffer[0].map_count; ++i)
+			{
+				src[i] = cnn.layer_buffer[0].q8_buffer[i]();
+			}
+			for (int i = 0; i < cnn.layer_buffer[1].map_count; ++i)
+			{
+				dst[i] = cnn.layer_buffer[1].q8_buffer[i]();
+			}
+			cnn.conv_l2.q8_pool_kernel(dst, cnn.layer_buffer[1].pool_buffer_size.cols, src, cnn.layer_buffer[0].pool_buffer_size.cols, cnn.layer_buffer[0].map_count,
+									   cnn.conv_l2.q8_kernels.data(), cnn.conv_l2.q8_params(), cnn.conv_l3.q8_inv_scale, cnn.conv_l3.q8_zero_point, cnn.conv_l2.ROI.cols, cnn.conv_l2.ROI.rows);
+
+			for (int i = 0; i < cnn.layer_buffer[1].map_count; ++i)
+			{
+				src[i] = cnn.layer_buffer[1].q8_buffer[i]();
+			}
+			for (int i = 0; i < cnn.layer_buffer[2].map_count; ++i)
+			{
+				cnn.maps_dst[i] = cnn.layer_buffer[2].pool_buffer[i]();
+			}
+			cnn.conv_l3.q8_kernel(cnn.maps_dst.data(), cnn.layer_buffer[2].pool_buffer_size.cols, src, cnn.layer_buffer[1].pool_buffer_size.cols, cnn.layer_buffer[1].map_count,
+								  cnn.conv_l3.q8_kernels.data(), cnn.conv_l3.q8_params(), cnn.conv_l3.ROI.cols, cnn.conv_l3.ROI.rows);
+
+			//hidden and output layers of outputs of Run_HL in registers, strips of Run_HL for more outputs
+			const int size = cnn.layer_buffer[2].pool_buffer_size.size;
+			const int out_count = !cnn.heads.empty() ? (int)cnn.heads.size() : (cnn.index_output >= 0 ? 1 : cnn.snn_ol_neuron_count);
+			if (out_count > ConvTemplate::Q8_MAX_OUTPUTS)
+			{
+				Run_HL();
+				return;
+			}
+
+			float* ol_dst[ConvTemplate::Q8_MAX_OUTPUTS];
+			const float* ol_w[ConvTemplate::Q8_MAX_OUTPUTS];
+			float ol_b[ConvTemplate::Q8_MAX_OUTPUTS];
+			float af_scale[ConvTemplate::Q8_MAX_OUTPUTS];
+			for (int k = 0; k < out_count; ++k)
+			{
+				int out_id = k;
+				ol_dst[k] = cnn.ol_buffer() + k * size;
+				af_scale[k] = cnn.af_scale;
+				if (!cnn.heads.empty())
+				{
+					out_id = cnn.heads[k];
+					ol_dst[k] = cnn.heads_buffer(k * size);
+					af_scale[k] = cnn.index_output < 0 ? cnn.af_scale : out_id == 0 ? -fabsf(cnn.af_scale) : fabsf(cnn.af_scale);
+				}
+				else if (cnn.index_output >= 0)
+				{
+					out_id = cnn.index_output;
+				}
+				ol_w[k] = cnn.snn_ol_weight[out_id]();
+				ol_b[k] = cnn.snn_ol_bias[out_id];
+			}
+
+			std::vector<const float*> hl_w(cnn.snn_hl_size);
+			for (int n = 0; n < cnn.snn_hl_size; ++n)
+			{
+				hl_w[n] = cnn.snn_hl_weight[n]();
+			}
+
+			ConvTemplate::hiddenOutputQ8(ol_dst, cnn.maps_dst.data(), size, cnn.snn_connect_count, cnn.snn_hl_size, cnn.hl_scale, hl_w.data(),
+										 cnn.snn_hl_bias(), cnn.snn_hl_tanh_w(), cnn.snn_hl_bn_weight(), cnn.snn_hl_bn_bias(), out_count, ol_w, ol_b, cnn.snn_ol_tanh_w, af_scale);
+#else
+			(void)image;
+#endif
+		}
+
+		void ConvNeuralNetwork::setCalibration(bool enabled)
+		{
+			cnn.calibration = enabled;
+			for (int l = 0; l < 3; ++l)
+			{
+				cnn.calibration_min[l] = 0.f;
+				cnn.calibration_max[l] = 0.f;
+			}
+		}
+		void ConvNeuralNetwork::getCalibrationRange(int layer, float& min_val, float& max_val) const
+		{
+			min_val = cnn.calibration_min[layer];
+			max_val = cnn.calibration_max[layer];
+		}
+		void ConvNeuralNetwork::setWinogradLayers(int layers)
+		{
+			cnn.winograd_layers = 0;
+			if (isEmpty() || graph != nullptr || cnn.quantized) return;
+
+			Layer_filter* conv_l[3] = { &cnn.conv_l1, &cnn.conv_l2, &cnn.conv_l3 };
+			for (int l = 0; l < cnn.layer_count; ++l)
+			{
+				Layer_filter& filter = *conv_l[l];
+				filter.wino_kernels.clear();
+
+				if ((layers & (1 << l)) == 0 || filter.size.cols != 3 || filter.size.rows != 3) continue;
+
+				const int map_count = cnn.layer_buffer[l].map_count;
+				filter.wino_kernels.resize(map_count);
+				for (int k = 0; k < map_count; ++k)
+				{
+					//3x3 kernel from layout of Init
+					float kernel[9];
+					for (int i = 0; i < 9; ++i)
+					{
+#if defined(USE_SSE) || defined(USE_AVX)
+						int t = (i / 3) * 8 * MAX(1, REG_SIZE / 8) + i % 3;
+						if (l == 0) t = (i >> 2) * 4 * MAX(1, REG_SIZE / 4) + (i & 3);
+						if (l == 1) t = (i / 3) * 4 * MAX(1, REG_SIZE / 4) + i % 3;
+#else
+						const int t = i;
+#endif
+						kernel[i] = filter.kernels[k][t];
+					}
+
+					filter.wino_kernels[k] = Array_32f(16, ALIGN_DEF);
+					WinogradKernel3x3(filter.wino_kernels[k](), 1, kernel, 3, 1);
+				}
+
+				cnn.winograd_layers |= 1 << l;
+			}
+
+			FindFixedKernels();
+		}
+		void ConvNeuralNetwork::setTemplateLayers(int layers)
+		{
+			cnn.template_layers = 0;
+			if (isEmpty() || graph != nullptr || cnn.quantized) return;
+
+			Layer_filter* conv_l[3] = { &cnn.conv_l1, &cnn.conv_l2, &cnn.conv_l3 };
+			for (int l = 0; l < cnn.layer_count; ++l)
+			{
+				if (conv_l[l]->conv_template == nullptr || (cnn.winograd_layers & (1 << l))) continue;
+
+				if ((layers & (1 << l)) || !conv_l[l]->direct)
+				{
+					cnn.template_layers |= 1 << l;
+				}
+			}
+		}
+		void ConvNeuralNetwork::WinogradKernel3x3(float* dst, int dst_step, const float* kernel, int row_step, int col_step)
+		{
+			const float G[4][3] = {
+				{ 1.f, 0.f, 0.f },
+				{ 0.5f, 0.5f, 0.5f },
+				{ 0.5f, -0.5f, 0.5f },
+				{ 0.f, 0.f, 1.f } };
+
+			for (int a = 0; a < 4; ++a)
+			{
+				for (int b = 0; b < 4; ++b)
+				{
+					float sum = 0.f;
+					for (int r = 0; r < 3; ++r)
+					{
+						for (int c = 0; c < 3; ++c)
+						{
+							sum += G[a][r] * kernel[r * row_step + c * col_step] * G[b][c];
+						}
+					}
+					dst[(a * 4 + b) * dst_step] = sum;
+				}
+			}
+		}
+
+		void ConvNeuralNetwork::UpdateCalibrationRange(int layer, float* src, int src_size_l, int cols, int rows)
+		{
+			float min_val = cnn.calibration_min[layer];
+			float max_val = cnn.calibration_max[layer];
+			for (int y = 0; y < rows; ++y)
+			{
+				const float* row = src + y * src_size_l;
+				for (int x = 0; x < cols; ++x)
+				{
+					min_val = MIN(min_val, row[x]);
+					max_val = MAX(max_val, row[x]);
+				}
+			}
+			cnn.calibration_min[layer] = min_val;
+			cnn.calibration_max[layer] = max_val;
+		}
+
 #if 0
 		void ConvNeuralNetwork::SaveToBinaryFile(std::string file_name, void* hGrd)
 		{
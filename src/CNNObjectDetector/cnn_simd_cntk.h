@@ -40,6 +40,9 @@
 #	endif
 #endif
 
+#include "cnnpp_simd_template.h"
+#include "cnn_simd_graph.h"
+
 
 //================================================================================================================================================
 
@@ -65,6 +68,9 @@ namespace NeuralNetworksLib
 
 				Size2d sum_buffer_size;
 				std::vector<Array_32f> sum_buffer;
+
+				//int8 mode: u8 inputs of next layer (quantized sums of pooled maps), rows of pool_buffer_size.cols bytes
+				std::vector<Array_8u> q8_buffer;
 			};
 			struct Layer_filter
 			{
@@ -72,6 +78,31 @@ namespace NeuralNetworksLib
 
 				Size2d size;
 				std::vector<Array_32f> kernels;
+
+				//int8 mode (AVX2 builds): weights packed by ConvTemplate::packKernelsQ8, ConvTemplate::Q8_PARAMS of maps,
+				//quantization of layer input and kernel of layer (pool kernel of layers 1, 2, q8_kernel of layer 3)
+				std::vector<int> q8_kernels;
+				Array_32f q8_params;
+				float q8_inv_scale = 0.f;
+				int q8_zero_point = 0;
+#ifdef USE_AVX2
+				ConvTemplate::PoolKernelQ8 q8_pool_kernel = nullptr;
+				ConvTemplate::KernelQ8 q8_kernel = nullptr;
+#endif
+
+				//Winograd F(2x2, 3x3) mode: 4x4 transformed kernels
+				std::vector<Array_32f> wino_kernels;
+
+				//kernels of all maps as rows of matrix map_count x (size.cols * size.rows)
+				Array_32f gemm_kernels;
+
+				//generated conv + lrelu + bn (+ max pool) kernel of layer shape (on gemm_kernels), null if the shape is not instantiated
+				ConvTemplate::Kernel conv_template = nullptr;
+				//generated kernel of layer shape and ROI of input size of AllocateMemory or last resize (stage 2/3 patches),
+				//runs instead of direct and conv_template kernels, null if the geometry is not instantiated or for Winograd layers
+				ConvTemplate::FixedKernel conv_fixed = nullptr;
+				//direct kernels of Conv_L1, Conv_L2, Conv_L3 for layer size
+				bool direct = false;
 			};
 			struct CNN
 			{
@@ -83,7 +114,9 @@ namespace NeuralNetworksLib
 
 				int layer_count = 0;
 				std::vector<Layer_buffer> layer_buffer;
-				Array_32f_ref pool3_buffer_ref;
+				//maps of layer 3 at offset of strip of Run_HL
+				int hl_strip = 2048;
+				std::vector<float*> pool3_strip;
 
 				Size2d hl_buffer_size;
 				std::vector<Array_32f> hl_buffer;
@@ -91,6 +124,10 @@ namespace NeuralNetworksLib
 				Size2d ol_buffer_size;
 				Array_32f ol_buffer;
 
+				//output neurons of ForwardOutputs (empty: index_output), maps of heads of pool_buffer_size of layer 3 one by one
+				std::vector<int> heads;
+				Array_32f heads_buffer;
+
 				Layer_filter conv_l1;
 				Layer_filter conv_l2;
 				Layer_filter conv_l3;
@@ -122,15 +159,56 @@ namespace NeuralNetworksLib
 				float af_scale = 0.f;
 				bool max_pool = false;
 				bool snn_full_connect = false;
+
+				//int8 conv layers of format 1.2 models, u8 image of layer 1
+				bool quantized = false;
+				int q8_input_step = 0;
+				Array_8u q8_input_buffer;
+
+				//ranges of conv layers inputs (calibration of int8 models)
+				bool calibration = false;
+				float calibration_min[3] = { 0.f, 0.f, 0.f };
+				float calibration_max[3] = { 0.f, 0.f, 0.f };
+
+				//bit l: conv layer l + 1 is run by Winograd F(2x2, 3x3)
+				int winograd_layers = 0;
+
+				//bit l: conv layer l + 1 is run by generated kernel conv_template (Winograd layers excluded)
+				int template_layers = 0;
+				//dst maps of ConvMaps_L1 and of int8 layer 3
+				std::vector<float*> maps_dst;
 			};
 
 			CNN cnn;
 			CNNPP cnnpp;
 
+			//format 2.0 models run as layer graph, members of cnn stay empty
+			LayerGraph* graph = nullptr;
+
 			int num_threads = 0; //OpenMP only
 
+			//int8 section of format 1.2 models is loaded by Init (setInt8)
+			bool int8 = false;
+
 			void ResizeBuffers(const Size size);
+			void FindFixedKernels();
 			void Run(Image_32f& image);
+			void Run_L3();
+			void Run_HL();
+			void Run_OL(float* ol_buffer, int offset, int size, int out_id, float* af_scale);
+
+			//conv + activation (+ max pool) of map i of layers 1, 2, 3, dst and src are of layout of pool_buffer
+			void Conv_L1(float* dst, int i, Image_32f& image);
+			void Conv_L2(float* dst, int i, float* src);
+			void Conv_L3(float* dst, int i, float* src);
+			//all maps of layer 1, maps 2i, 2i + 1 of layers 2, 3: one call of generated kernel or map by map
+			void ConvMaps_L1(float** dst, Image_32f& image);
+			void ConvMaps_L2(float** dst, int i, float* src);
+			void ConvMaps_L3(float** dst, int i, float* src);
+
+			void Run_Q8(Image_32f& image);
+			float* SumPoolMaps(int layer, int i, int it);
+			void UpdateCalibrationRange(int layer, float* src, int src_size_l, int cols, int rows);
 
 		public:
 			ConvNeuralNetwork() { }
@@ -142,18 +220,56 @@ namespace NeuralNetworksLib
 
 			void Forward(Image_32f& response_map, Image_32f& image);
 
-			inline bool isEmpty() const { return cnn.min_image_size.width == 0 || cnn.min_image_size.height == 0; }
+			//output neurons index_outputs of one image: conv layers and hidden layer run once, response maps share buffer of network until next call
+			//(output 0 negated as by Init with index_output 0, unless the network is loaded with index_output -1), not supported by layer graph models
+			void ForwardOutputs(std::vector<Image_32f>& response_maps, Image_32f& image, const std::vector<int>& index_outputs);
+			inline int getOutputCount() const { return graph != nullptr ? 0 : cnn.snn_ol_neuron_count; }
 
-			inline Size getMinInputImgSize()  const { return cnn.min_image_size; }
-			inline Size getMaxInputImgSize()  const { return cnn.max_image_size; }
-			inline Size getInputImgSize()	  const { return Size(cnn.input_buffer_size.cols, cnn.input_buffer_size.rows); }
-			inline Size getOutputImgSize()	  const { return Size(cnn.output_buffer_size.cols, cnn.output_buffer_size.rows); }
+			inline bool isEmpty() const { return graph != nullptr ? graph->isEmpty() : cnn.min_image_size.width == 0 || cnn.min_image_size.height == 0; }
+			//model of format 2.0 (LayerGraph)
+			inline bool isGraph() const { return graph != nullptr; }
+
+			inline Size getMinInputImgSize()  const { return graph != nullptr ? graph->getMinInputImgSize() : cnn.min_image_size; }
+			inline Size getMaxInputImgSize()  const { return graph != nullptr ? graph->getMaxInputImgSize() : cnn.max_image_size; }
+			inline Size getInputImgSize()	  const { return graph != nullptr ? graph->getInputImgSize() : Size(cnn.input_buffer_size.cols, cnn.input_buffer_size.rows); }
+			inline Size getOutputImgSize()	  const { return graph != nullptr ? graph->getOutputImgSize() : Size(cnn.output_buffer_size.cols, cnn.output_buffer_size.rows); }
 			Size getOutputImgSize(const Size size);
-			inline float getInputOutputRatio() const { return 4.f; /*(float)cnn.input_buffer_size.rows / (float)cnn.output_buffer_size.rows;*/ }
+			inline float getInputOutputRatio() const { return graph != nullptr ? graph->getInputOutputRatio() : 4.f; /*(float)cnn.input_buffer_size.rows / (float)cnn.output_buffer_size.rows;*/ }
 
 			inline int getNumThreads() const { return num_threads; }
 			inline void setNumThreads(int _num_threads) { num_threads = MAX(1, _num_threads); }
 
+			//approximate feature pyramid: pooled layer 2 maps stacked by rows (getFeatureMapsCount maps of getFeatureMapsSize),
+			//layer 2 cell (x, y) is centered at input pixel getFeatureMapsStride() * (x, y) + getFeatureMapsOffset(), no maps of graph
+			//and int8 models (layer 2 maps are u8 sums)
+			Size getFeatureMapsSize(const Size size);
+			inline int getFeatureMapsCount() const { return graph != nullptr || cnn.quantized ? 0 : cnn.layer_buffer[1].map_count; }
+			inline float getFeatureMapsStride() const { return 4.f; }
+			inline float getFeatureMapsOffset() const { return 1.5f + 0.5f * float(cnn.conv_l1.size.cols - 1) + float(cnn.conv_l2.size.cols - 1); }
+			//layer 2 maps of last Forward
+			void getFeatureMaps(Image_32f& maps);
+			//layers 3+ of image of given size on layer 2 maps
+			void ForwardFeatureMaps(Image_32f& response_map, Image_32f& maps, const Size size);
+
+			//int8 conv layers, format 1.2 models written by CNNModelsConverter::Quantize; opt-in before Init, otherwise float weights
+			//of these models are used; AVX2 builds only (vpdpbusd on VNNI cpus), other builds load float weights
+			inline void setInt8(bool enabled) { int8 = enabled; }
+			inline bool isQuantized() const { return cnn.quantized; }
+			//min/max of conv layers inputs over Forward calls of float model (calibration of int8 models)
+			void setCalibration(bool enabled);
+			void getCalibrationRange(int layer, float& min_val, float& max_val) const;
+
+			//Winograd F(2x2, 3x3) for 3x3 conv layers of float model, bit l of layers is conv layer l + 1
+			void setWinogradLayers(int layers);
+			inline int getWinogradLayers() const { return cnn.winograd_layers; }
+
+			//generated conv + lrelu + bn (+ max pool) kernels (ConvTemplate), bit l of layers is conv layer l + 1; layers without direct kernels
+			//always run them, layers without generated kernel of their shape are kept
+			void setTemplateLayers(int layers);
+			inline int getTemplateLayers() const { return cnn.template_layers; }
+			//dst[(a * 4 + b) * dst_step] = (G g G^T)[a][b], g[r][c] = kernel[r * row_step + c * col_step]
+			static void WinogradKernel3x3(float* dst, int dst_step, const float* kernel, int row_step, int col_step);
+
 #if 0
 			void SaveToBinaryFile(std::string file_name, void* hGrd = 0);
 			void LoadCNTKModel(std::string file_name, bool preprocessing = true);
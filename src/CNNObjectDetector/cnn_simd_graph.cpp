@@ -0,0 +1,922 @@
+/*
+*	Copyright (c) 2018, Ilya Kalinovskiy
+*	All rights reserved.
+*
+*	This is an implementation of the algorithm described in the following paper:
+*		I.A. Kalinovskiy, V.G. Spitsyn,
+*		Compact Convolutional Neural Network Cascade for Face Detection,
+*		http://arxiv.org/abs/1508.01292.
+*
+*	Redistribution and use of this program as source code or in binary form, with or without modifications, are permitted provided that the following conditions are met:
+*		1. Redistributions may not be sold, nor may they be used in a commercial product or activity without prior permission from the copyright holder (contact him at kua_21@mail.ru).
+*		2. Redistributions may not be used for military purposes.
+*		3. Any published work which utilizes this program shall include the reference to the paper available at http://arxiv.org/abs/1508.01292
+*		4. Redistributions must retain the above copyright notice and the reference to the algorithm on which the implementation is based on, this list of conditions and the following disclaimer.
+*
+*	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+*	IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#include "cnn_simd_graph.h"
+#include <fstream>
+#include <sstream>
+#include <immintrin.h>
+#include <cstring>
+
+
+//================================================================================================================================================
+
+
+namespace NeuralNetworksLib
+{
+#ifdef USE_CNTK_MODELS
+
+	namespace SIMD
+	{
+		void LayerGraph::Epilogue::init(int maps)
+		{
+			form = Linear;
+			b.assign(maps, 0.f);
+			w1.assign(maps, 1.f);
+			w2.assign(maps, 0.f);
+			t.assign(maps, 0.f);
+			tanh_w.assign(maps, 1.f);
+			scale.assign(maps, 1.f);
+		}
+
+		void LayerGraph::Init(std::string file_name, int index_output)
+		{
+			std::stringstream data_bin;
+			if (file_name.size() < 255)
+			{
+				std::fstream file_bin;
+				file_bin.open(file_name.c_str(), std::fstream::binary | std::fstream::in);
+
+				if (!file_bin.is_open())
+				{
+					printf("[SIMD::LayerGraph] Configuration file not found!\n");
+					return;
+				}
+
+				data_bin << file_bin.rdbuf();
+				file_bin.close();
+			}
+			else
+			{
+				data_bin << file_name;
+			}
+
+			//version
+			float format_version = 0.0f;
+			FB_READ(data_bin, format_version);
+
+			if (format_version < 1.9f || format_version > 2.0f)
+			{
+				printf("[SIMD::LayerGraph] Configuration file format is not supported!\n");
+				return;
+			}
+
+			std::vector<Layer> layers;
+			std::vector<float> select_scale;
+			if (!ReadLayers(data_bin, layers, select_scale))
+			{
+				printf("[SIMD::LayerGraph] Configuration file is corrupted!\n");
+				Clear();
+				return;
+			}
+
+			if (!SelectOutput(layers, select_scale, index_output) || !Fuse(layers))
+			{
+				printf("[SIMD::LayerGraph] This configuration cnn models is not supported!\n");
+				Clear();
+				return;
+			}
+
+			PlanBuffers();
+
+			const Size min_output_size = getOutputImgSize(graph.min_image_size);
+			if (min_output_size.width < 1 || min_output_size.height < 1)
+			{
+				printf("[SIMD::LayerGraph] Configuration file is corrupted!\n");
+				Clear();
+				return;
+			}
+		}
+		bool LayerGraph::ReadLayers(std::istream& data_bin, std::vector<Layer>& layers, std::vector<float>& select_scale)
+		{
+			FB_READ(data_bin, graph.min_image_size.width);
+			FB_READ(data_bin, graph.min_image_size.height);
+
+			int maps = 0;
+			int layer_count = 0;
+			FB_READ(data_bin, maps);
+			FB_READ(data_bin, layer_count);
+
+			if (!data_bin || maps != 1 || layer_count <= 0 || layer_count > 256) return false;
+
+			layers.resize(layer_count);
+			for (int l = 0; l < layer_count; ++l)
+			{
+				Layer& layer = layers[l];
+				FB_READ(data_bin, layer.type);
+				if (!data_bin) return false;
+
+				int weight_count = 0;
+				int bias_count = 0;
+				switch (layer.type)
+				{
+				case Conv:
+				{
+					int kernel_width = 0;
+					int kernel_height = 0;
+					FB_READ(data_bin, layer.maps);
+					FB_READ(data_bin, kernel_width);
+					FB_READ(data_bin, kernel_height);
+					FB_READ(data_bin, layer.connection);
+					layer.kernel = Size2d(kernel_width, kernel_height);
+
+					if (layer.maps <= 0 || kernel_width <= 0 || kernel_height <= 0) return false;
+					if (layer.connection == ConvNeighbours)
+					{
+						if (layer.maps % maps != 0) return false;
+						weight_count = layer.maps * layer.kernel.size;
+					}
+					else if (layer.connection == ConvFull)
+					{
+						weight_count = layer.maps * maps * layer.kernel.size;
+					}
+					else
+					{
+						return false;
+					}
+					bias_count = layer.maps;
+					maps = layer.maps;
+					break;
+				}
+				case MaxPool:
+					FB_READ(data_bin, layer.pool);
+					if (layer.pool != 2) return false;
+					layer.maps = maps;
+					break;
+
+				case BatchNorm:
+				case LeakyReLU:
+					layer.maps = maps;
+					weight_count = maps;
+					bias_count = maps;
+					break;
+
+				case Tanh:
+					layer.maps = maps;
+					weight_count = maps;
+					break;
+
+				case Dense:
+					FB_READ(data_bin, layer.maps);
+					if (layer.maps <= 0) return false;
+					weight_count = layer.maps * maps;
+					bias_count = layer.maps;
+					maps = layer.maps;
+					break;
+
+				default:
+					return false;
+				}
+
+				layer.weight.resize(weight_count);
+				for (int i = 0; i < weight_count; ++i)
+				{
+					FB_READ(data_bin, layer.weight[i]);
+				}
+				layer.bias.resize(bias_count);
+				for (int i = 0; i < bias_count; ++i)
+				{
+					FB_READ(data_bin, layer.bias[i]);
+				}
+			}
+
+			//scales of maps of last layer when they are selected by index_output
+			select_scale.resize(maps);
+			for (int i = 0; i < maps; ++i)
+			{
+				FB_READ(data_bin, select_scale[i]);
+			}
+
+			return !!data_bin;
+		}
+		bool LayerGraph::SelectOutput(std::vector<Layer>& layers, std::vector<float>& select_scale, int index_output)
+		{
+			graph.index_output = -1;
+			if (index_output < 0) return true;
+
+			const int maps = layers.back().maps;
+			const int k = MIN(index_output, maps - 1);
+			graph.index_output = k;
+
+			//trailing per map layers keep map k, the last conv or dense layer keeps output k
+			for (int l = (int)layers.size() - 1; l >= 0; --l)
+			{
+				Layer& layer = layers[l];
+				if (layer.type == MaxPool)
+				{
+					layer.maps = 1;
+					continue;
+				}
+				if (layer.type == BatchNorm || layer.type == LeakyReLU || layer.type == Tanh)
+				{
+					layer.maps = 1;
+					layer.weight = std::vector<float>(1, layer.weight[k]);
+					if (!layer.bias.empty()) layer.bias = std::vector<float>(1, layer.bias[k]);
+					continue;
+				}
+				if (layer.type == Conv && layer.connection == ConvNeighbours && layer.maps > 1)
+				{
+					return false;
+				}
+
+				const int row = (int)layer.weight.size() / layer.maps;
+				layer.weight = std::vector<float>(layer.weight.begin() + k * row, layer.weight.begin() + (k + 1) * row);
+				layer.bias = std::vector<float>(1, layer.bias[k]);
+				layer.maps = 1;
+				break;
+			}
+
+			if (select_scale[k] != 1.f)
+			{
+				Layer bn;
+				bn.type = BatchNorm;
+				bn.maps = 1;
+				bn.weight = std::vector<float>(1, select_scale[k]);
+				bn.bias = std::vector<float>(1, 0.f);
+				layers.push_back(bn);
+			}
+
+			return true;
+		}
+		bool LayerGraph::Fuse(std::vector<Layer>& layers)
+		{
+			//the first layer reads the image
+			if (layers.empty() || layers[0].type != Conv) return false;
+
+			graph.steps.clear();
+			graph.tensors.assign(1, Tensor());
+			graph.tensors[0].maps = 1;
+			graph.stride = 1;
+
+			int src = 0;
+			for (size_t l = 0; l < layers.size(); )
+			{
+				Layer& layer = layers[l];
+				const int in_maps = graph.tensors[src].maps;
+
+				Step step;
+				step.src = src;
+				step.af.init(layer.maps);
+
+				if (layer.type == Conv)
+				{
+					step.kind = Step::ConvStep;
+					step.kernel = layer.kernel;
+					step.connection = layer.connection;
+					step.kernels = layer.weight;
+					step.af.b = layer.bias;
+					l++;
+				}
+				else if (layer.type == Dense)
+				{
+					step.kind = Step::DenseStep;
+					step.inputs.resize(layer.maps);
+					step.weights.resize(layer.maps);
+					for (int k = 0; k < layer.maps; ++k)
+					{
+						for (int i = 0; i < in_maps; ++i)
+						{
+							const float w = layer.weight[k * in_maps + i];
+							if (w == 0.f) continue;
+							step.inputs[k].push_back(i);
+							step.weights[k].push_back(w);
+						}
+						if (step.inputs[k].empty())
+						{
+							step.inputs[k].push_back(0);
+							step.weights[k].push_back(0.f);
+						}
+					}
+					step.af.b = layer.bias;
+					l++;
+				}
+				else
+				{
+					step.kind = Step::ActStep;
+				}
+
+				//per map layers and max pool of conv are fused into epilogue of step
+				Epilogue& af = step.af;
+				const int maps = layer.maps;
+				for (; l < layers.size() && !step.pool; ++l)
+				{
+					const Layer& next = layers[l];
+					if (next.type == Conv || next.type == Dense) break;
+
+					if (next.type == MaxPool)
+					{
+						if (step.kind == Step::DenseStep || af.form != Epilogue::Linear) break;
+						step.pool = true;
+						graph.stride *= 2;
+						continue;
+					}
+
+					bool linear = af.form == Epilogue::Linear;
+					bool relu_free = linear;
+					bool identity = linear;
+					for (int k = 0; k < maps; ++k)
+					{
+						relu_free = relu_free && af.w2[k] == 0.f && af.t[k] == 0.f;
+						identity = identity && af.w1[k] == 1.f && af.w2[k] == 0.f && af.t[k] == 0.f;
+					}
+
+					if (next.type == BatchNorm)
+					{
+						for (int k = 0; k < maps; ++k)
+						{
+							const float s = next.weight[k];
+							const float c = next.bias[k];
+
+							//bn of conv and dense outputs is folded into weights
+							if (identity && step.kind != Step::ActStep)
+							{
+								if (step.kind == Step::ConvStep)
+								{
+									const int K = (int)step.kernels.size() / maps;
+									for (int i = 0; i < K; ++i) step.kernels[k * K + i] *= s;
+								}
+								else
+								{
+									for (size_t i = 0; i < step.weights[k].size(); ++i) step.weights[k][i] *= s;
+								}
+								af.b[k] = s * af.b[k] + c;
+							}
+							else if (linear)
+							{
+								af.w1[k] *= s;
+								af.w2[k] *= s;
+								af.t[k] = s * af.t[k] + c;
+							}
+							else
+							{
+								af.scale[k] *= s;
+								af.t[k] = s * af.t[k] + c;
+							}
+						}
+						continue;
+					}
+
+					if (next.type == LeakyReLU)
+					{
+						//relu of w1 * x is w1 * relu(x) for w1 > 0
+						bool positive = relu_free;
+						for (int k = 0; k < maps; ++k) positive = positive && af.w1[k] > 0.f;
+						if (!positive) break;
+
+						for (int k = 0; k < maps; ++k)
+						{
+							af.w2[k] = next.bias[k] * af.w1[k];
+							af.w1[k] = next.weight[k] * af.w1[k];
+						}
+						continue;
+					}
+
+					if (next.type == Tanh)
+					{
+						if (step.kind == Step::ConvStep || !relu_free) break;
+
+						af.form = Epilogue::Tanh;
+						for (int k = 0; k < maps; ++k)
+						{
+							af.tanh_w[k] = next.weight[k] * af.w1[k];
+							af.scale[k] = 1.f;
+						}
+
+						//0.5 tanh + 0.5 of next bn
+						if (l + 1 < layers.size() && layers[l + 1].type == BatchNorm)
+						{
+							bool sigmoid = true;
+							for (int k = 0; k < maps; ++k)
+							{
+								sigmoid = sigmoid && layers[l + 1].weight[k] == 0.5f && layers[l + 1].bias[k] == 0.5f;
+							}
+							if (sigmoid)
+							{
+								af.form = Epilogue::Sigmoid;
+								l++;
+							}
+						}
+						continue;
+					}
+				}
+
+				if (step.kind == Step::ConvStep)
+				{
+					const int groups = step.connection == ConvNeighbours ? in_maps : 1;
+					if (step.connection == ConvNeighbours || in_maps == 1)
+					{
+						step.conv_template = ConvTemplate::find(step.kernel.cols, step.kernel.rows, maps / groups, step.pool);
+					}
+				}
+
+				if (step.kind == Step::DenseStep && af.form == Epilogue::Sigmoid)
+				{
+					//CNNPP::mulCN_add_tanhW sums up to 96 inputs
+					step.sigmoid_sum = true;
+					for (int k = 0; k < maps; ++k)
+					{
+						step.sigmoid_sum = step.sigmoid_sum && step.inputs[k].size() <= 96;
+					}
+				}
+
+				//activations without max pool run in place
+				if (step.kind == Step::ActStep && !step.pool)
+				{
+					step.dst = src;
+				}
+				else
+				{
+					Tensor tensor;
+					tensor.maps = maps;
+					graph.tensors.push_back(tensor);
+					step.dst = (int)graph.tensors.size() - 1;
+				}
+				src = step.dst;
+
+				graph.steps.push_back(step);
+			}
+
+			return true;
+		}
+		void LayerGraph::PlanBuffers()
+		{
+			//last step reading or writing tensor, output tensor lives after Forward
+			const int step_count = (int)graph.steps.size();
+			std::vector<int> last_use(graph.tensors.size(), -1);
+			for (int s = 0; s < step_count; ++s)
+			{
+				last_use[graph.steps[s].src] = s;
+				last_use[graph.steps[s].dst] = s;
+			}
+			last_use[graph.steps.back().dst] = step_count;
+
+			//tensor of a step takes buffer which is free after previous steps
+			std::vector<int> buffer_tensor;
+			for (int s = 0; s < step_count; ++s)
+			{
+				const int dst = graph.steps[s].dst;
+				if (dst == graph.steps[s].src || graph.tensors[dst].buffer >= 0) continue;
+
+				int buffer = -1;
+				for (int b = 0; b < (int)buffer_tensor.size() && buffer < 0; ++b)
+				{
+					if (last_use[buffer_tensor[b]] < s) buffer = b;
+				}
+				if (buffer < 0)
+				{
+					buffer = (int)buffer_tensor.size();
+					buffer_tensor.push_back(dst);
+				}
+
+				buffer_tensor[buffer] = dst;
+				graph.tensors[dst].buffer = buffer;
+			}
+
+			graph.buffer_size.assign(buffer_tensor.size(), 0);
+		}
+
+		Size LayerGraph::getOutputImgSize(const Size size) const
+		{
+			Size output = size;
+			for (size_t s = 0; s < graph.steps.size(); ++s)
+			{
+				const Step& step = graph.steps[s];
+				if (step.kind == Step::ConvStep)
+				{
+					output.width -= step.kernel.cols - 1;
+					output.height -= step.kernel.rows - 1;
+				}
+				if (step.pool)
+				{
+					output.width >>= 1;
+					output.height >>= 1;
+				}
+			}
+
+			return output;
+		}
+		Size LayerGraph::getOutputImgSize() const
+		{
+			if (graph.steps.empty()) return Size(0, 0);
+
+			const Tensor& output = graph.tensors[graph.steps.back().dst];
+			return Size(output.size.cols, output.maps * output.size.rows);
+		}
+		void LayerGraph::ResizeTensors(const Size size)
+		{
+			graph.input_size = size;
+			graph.tensors[0].size = Size2d(size.width, size.height);
+
+			for (size_t s = 0; s < graph.steps.size(); ++s)
+			{
+				const Step& step = graph.steps[s];
+				const Tensor& src = graph.tensors[step.src];
+				Tensor& dst = graph.tensors[step.dst];
+				if (step.dst == step.src) continue;
+
+				int cols = src.size.cols;
+				int rows = src.size.rows;
+				if (step.kind == Step::ConvStep)
+				{
+					cols -= step.kernel.cols - 1;
+					rows -= step.kernel.rows - 1;
+				}
+
+				//CNNPP::lrelu_bn_max writes half of src rows, dense maps keep layout of input maps
+				int step_l = 0;
+				if (step.pool)
+				{
+					cols >>= 1;
+					rows >>= 1;
+					step_l = step.kind == Step::ActStep ? src.size.step >> 1 : 0;
+				}
+				if (step.kind == Step::DenseStep)
+				{
+					step_l = src.size.step;
+				}
+
+				dst.size = Size2d(cols, rows, roundUpMul(MAX(1, MAX(cols, step_l)), 2 * REG_SIZE));
+				dst.plane = dst.size.size;
+			}
+		}
+		void LayerGraph::AllocateMemory(const Size size)
+		{
+			if (isEmpty()) return;
+
+			if (size.width < graph.min_image_size.width || size.height < graph.min_image_size.height)
+			{
+				return;
+			}
+
+			graph.max_image_size = size;
+			ResizeTensors(size);
+
+			//buffers of max size, sum of neighbours has plane of conv input
+			int sum_size = 0;
+			graph.buffer_size.assign(graph.buffer_size.size(), 0);
+			for (size_t s = 0; s < graph.steps.size(); ++s)
+			{
+				const Step& step = graph.steps[s];
+				const Tensor& dst = graph.tensors[step.dst];
+				if (dst.buffer >= 0)
+				{
+					graph.buffer_size[dst.buffer] = MAX(graph.buffer_size[dst.buffer], dst.maps * dst.plane);
+				}
+				if (step.kind == Step::ConvStep && step.connection == ConvNeighbours && step.src > 0)
+				{
+					sum_size = MAX(sum_size, graph.tensors[step.src].plane);
+				}
+			}
+
+			graph.buffers.clear();
+			graph.buffers.resize(graph.buffer_size.size());
+			for (size_t b = 0; b < graph.buffers.size(); ++b)
+			{
+				graph.buffers[b] = Array_32f(graph.buffer_size[b], ALIGN_DEF);
+				graph.buffers[b].erase();
+			}
+
+			graph.sum_buffer.clear();
+			if (sum_size > 0)
+			{
+				graph.sum_buffer = Array_32f(sum_size, ALIGN_DEF);
+				graph.sum_buffer.erase();
+			}
+		}
+		void LayerGraph::Clear()
+		{
+			graph.min_image_size = Size(0, 0);
+			graph.max_image_size = Size(0, 0);
+			graph.input_size = Size(0, 0);
+
+			graph.steps.clear();
+			graph.tensors.clear();
+
+			graph.buffer_size.clear();
+			graph.buffers.clear();
+			graph.sum_buffer.clear();
+			graph.gemm_panel.clear();
+			graph.gemm_result.clear();
+
+			graph.src_ptr.clear();
+			graph.dst_ptr.clear();
+
+			graph.stride = 1;
+			graph.index_output = -1;
+		}
+
+		void LayerGraph::ApplyEpilogue(Epilogue& af, int k, float* dst, float* src, int size)
+		{
+			float zero = 0.f;
+			float one = 1.f;
+
+			switch (af.form)
+			{
+			case Epilogue::Linear:
+				if (dst == src)
+				{
+					cnnpp.lrelu_bn(dst, size, &(af.b[k]), &(af.w1[k]), &(af.w2[k]), &(af.w1[k]), &(af.t[k]));
+					return;
+				}
+				cnnpp.lrelu_bn(dst, src, size, &(af.b[k]), &(af.w1[k]), &(af.w2[k]), &(af.w1[k]), &(af.t[k]));
+				return;
+
+			case Epilogue::Tanh:
+				if (af.scale[k] != 0.f && af.t[k] == 0.f)
+				{
+					cnnpp.tanhW(dst, src, size, &(af.b[k]), &(af.tanh_w[k]), &(af.scale[k]));
+					return;
+				}
+				cnnpp.tanhW(dst, src, size, &(af.b[k]), &(af.tanh_w[k]), &one);
+				break;
+
+			case Epilogue::Sigmoid:
+				cnnpp.tanhW(dst, src, size, &(af.b[k]), &(af.tanh_w[k]), &zero);
+				if (af.scale[k] == 1.f && af.t[k] == 0.f) return;
+				break;
+			}
+
+			cnnpp.lrelu_bn(dst, size, &zero, &(af.scale[k]), &zero, &(af.scale[k]), &(af.t[k]));
+		}
+		void LayerGraph::RunConvMaps(Step& step, float** dst, int dst_size_l, const float* src, int src_size_l, int group, int L, int H, int in_maps)
+		{
+			const int M = (int)step.af.b.size() / (step.connection == ConvNeighbours ? in_maps : 1);
+			const int k = group * M;
+
+			step.conv_template(dst, dst_size_l, src, src_size_l, &(step.kernels[k * step.kernel.size]),
+							   &(step.af.b[k]), &(step.af.w1[k]), &(step.af.w2[k]), &(step.af.t[k]), L, H);
+		}
+		void LayerGraph::RunConvGEMM(Step& step, float** dst, int dst_size_l, const float** src, int src_size_l, int group, int in_maps, int L, int H)
+		{
+			//columns of GEMM: output rows (pairs of conv rows with max pool), rows: output maps of group,
+			//K: kernel of each input map
+			const int kernel_w = step.kernel.cols;
+			const int kernel_h = step.kernel.rows;
+			const int K1 = kernel_w * kernel_h;
+			const int K = in_maps * K1;
+			const int M = (int)step.af.b.size() / (step.connection == ConvNeighbours ? graph.tensors[step.src].maps : 1);
+			const int k0 = group * M;
+
+			const int dst_cols = step.pool ? L >> 1 : L;
+			const int dst_rows = step.pool ? H >> 1 : H;
+			const int conv_cols = step.pool ? 2 * dst_cols : dst_cols;
+			const int conv_rows = step.pool ? 2 : 1;
+			const int unit_cols = conv_rows * conv_cols;
+
+			//panel of about 32 KB, units are not split between panels
+			const int block = 4 * REG_SIZE;
+			const int unit_count = MAX(1, MAX(block, (8192 / K) / block * block) / unit_cols);
+			const int panel_step = roundUpMul(unit_count * unit_cols, block);
+
+			if (graph.gemm_panel.size < K * panel_step)
+			{
+				graph.gemm_panel = Array_32f(K * panel_step, ALIGN_DEF);
+				graph.gemm_panel.erase();
+			}
+			if (graph.gemm_result.size < M * panel_step)
+			{
+				graph.gemm_result = Array_32f(M * panel_step, ALIGN_DEF);
+			}
+
+			float* panel = graph.gemm_panel();
+			float* result = graph.gemm_result();
+
+			int unit_begin = 0;
+			for (int u = 0; u < dst_rows; ++u)
+			{
+				//im2col
+				for (int c = 0; c < in_maps; ++c)
+				{
+					for (int dy = 0; dy < conv_rows; ++dy)
+					{
+						const float* pSrc = src[c] + (conv_rows * u + dy) * src_size_l;
+						float* pDst = panel + c * K1 * panel_step + (u - unit_begin) * unit_cols + dy * conv_cols;
+						for (int ky = 0; ky < kernel_h; ++ky)
+						{
+							for (int kx = 0; kx < kernel_w; ++kx)
+							{
+								memcpy(pDst + (ky * kernel_w + kx) * panel_step, pSrc + ky * src_size_l + kx, conv_cols * sizeof(float));
+							}
+						}
+					}
+				}
+
+				if (u - unit_begin + 1 < unit_count && u < dst_rows - 1) continue;
+
+				const int N = (u - unit_begin + 1) * unit_cols;
+				cnnpp.gemm(result, panel_step, panel, panel_step, &(step.kernels[k0 * K]), M, K, roundUpMul(N, block));
+
+				for (int m = 0; m < M; ++m)
+				{
+					const int k = k0 + m;
+					float* res = result + m * panel_step;
+					cnnpp.lrelu_bn(res, roundUpMul(N, REG_SIZE), &(step.af.b[k]), &(step.af.w1[k]), &(step.af.w2[k]), &(step.af.w1[k]), &(step.af.t[k]));
+
+					for (int t = unit_begin; t <= u; ++t)
+					{
+						const float* pSrc = res + (t - unit_begin) * unit_cols;
+						float* pDst = dst[m] + t * dst_size_l;
+						if (step.pool)
+						{
+							for (int x = 0; x < dst_cols; ++x)
+							{
+								pDst[x] = MAX(MAX(pSrc[2 * x], pSrc[2 * x + 1]), MAX(pSrc[conv_cols + 2 * x], pSrc[conv_cols + 2 * x + 1]));
+							}
+						}
+						else
+						{
+							memcpy(pDst, pSrc, dst_cols * sizeof(float));
+						}
+					}
+				}
+
+				unit_begin = u + 1;
+			}
+		}
+		void LayerGraph::RunConv(Step& step, Image_32f& image)
+		{
+			const Tensor& src = graph.tensors[step.src];
+			const Tensor& dst = graph.tensors[step.dst];
+			const int in_maps = src.maps;
+
+			const int L = src.size.cols - (step.kernel.cols - 1);
+			const int H = src.size.rows - (step.kernel.rows - 1);
+			const int src_size_l = step.src == 0 ? image.widthStep : src.size.step;
+
+			graph.src_ptr.resize(in_maps);
+			for (int i = 0; i < in_maps; ++i)
+			{
+				graph.src_ptr[i] = step.src == 0 ? image.data : tensorMap(src, i);
+			}
+			graph.dst_ptr.resize(dst.maps);
+			for (int k = 0; k < dst.maps; ++k)
+			{
+				graph.dst_ptr[k] = tensorMap(dst, k);
+			}
+
+			//full connection: one group of all input maps
+			if (step.connection == ConvFull)
+			{
+				if (step.conv_template != nullptr)
+				{
+					RunConvMaps(step, graph.dst_ptr.data(), dst.size.step, graph.src_ptr[0], src_size_l, 0, L, H, in_maps);
+				}
+				else
+				{
+					RunConvGEMM(step, graph.dst_ptr.data(), dst.size.step, (const float**)graph.src_ptr.data(), src_size_l, 0, in_maps, L, H);
+				}
+				return;
+			}
+
+			//neighbours: group i on sum of input maps i - 1, i, i + 1
+			const int M = dst.maps / in_maps;
+			for (int i = 0; i < in_maps; ++i)
+			{
+				const float* sum = graph.src_ptr[i];
+				if (in_maps > 1)
+				{
+					float* buffer = graph.sum_buffer();
+					if (i > 0 && i < in_maps - 1)
+					{
+						cnnpp.add2(buffer, graph.src_ptr[i - 1], graph.src_ptr[i], graph.src_ptr[i + 1], src.plane);
+					}
+					else if (i == 0)
+					{
+						cnnpp.add(buffer, graph.src_ptr[0], graph.src_ptr[1], src.plane);
+					}
+					else
+					{
+						cnnpp.add(buffer, graph.src_ptr[in_maps - 2], graph.src_ptr[in_maps - 1], src.plane);
+					}
+					sum = buffer;
+				}
+
+				if (step.conv_template != nullptr)
+				{
+					RunConvMaps(step, graph.dst_ptr.data() + i * M, dst.size.step, sum, src_size_l, i, L, H, in_maps);
+				}
+				else
+				{
+					RunConvGEMM(step, graph.dst_ptr.data() + i * M, dst.size.step, &sum, src_size_l, i, 1, L, H);
+				}
+			}
+		}
+		void LayerGraph::RunDense(Step& step)
+		{
+			const Tensor& src = graph.tensors[step.src];
+			const Tensor& dst = graph.tensors[step.dst];
+			const int size = dst.plane;
+
+			for (int k = 0; k < dst.maps; ++k)
+			{
+				const std::vector<int>& inputs = step.inputs[k];
+				std::vector<float>& weights = step.weights[k];
+				float* pDst = tensorMap(dst, k);
+
+				graph.src_ptr.resize(inputs.size());
+				for (size_t i = 0; i < inputs.size(); ++i)
+				{
+					graph.src_ptr[i] = tensorMap(src, inputs[i]);
+				}
+
+				if (step.sigmoid_sum)
+				{
+					cnnpp.mulCN_add_tanhW((int)inputs.size(), pDst, graph.src_ptr.data(), size, weights.data(), &(step.af.b[k]), &(step.af.tanh_w[k]), &(step.af.scale[k]), &(step.af.t[k]));
+					continue;
+				}
+
+				cnnpp.mulC(pDst, graph.src_ptr[0], size, &(weights[0]));
+				for (size_t i = 1; i < inputs.size(); ++i)
+				{
+					cnnpp.mulC1_add(pDst, graph.src_ptr[i], size, &(weights[i]));
+				}
+				ApplyEpilogue(step.af, k, pDst, pDst, size);
+			}
+		}
+		void LayerGraph::RunAct(Step& step)
+		{
+			const Tensor& src = graph.tensors[step.src];
+			const Tensor& dst = graph.tensors[step.dst];
+			Epilogue& af = step.af;
+
+			for (int k = 0; k < src.maps; ++k)
+			{
+				float* pSrc = tensorMap(src, k);
+				if (step.pool)
+				{
+					cnnpp.lrelu_bn_max(tensorMap(dst, k), dst.size.step, pSrc, src.size.step, src.size.rows & ~1, &(af.b[k]), &(af.w1[k]), &(af.w2[k]), &(af.w1[k]), &(af.t[k]));
+				}
+				else
+				{
+					ApplyEpilogue(af, k, pSrc, pSrc, src.plane);
+				}
+			}
+		}
+
+		void LayerGraph::Forward(Image_32f& response_map, Image_32f& image)
+		{
+			if (image.width != graph.input_size.width || image.height != graph.input_size.height)
+			{
+				if (image.width < graph.min_image_size.width || image.height < graph.min_image_size.height ||
+					image.width > graph.max_image_size.width || image.height > graph.max_image_size.height)
+				{
+					response_map.width = 0;
+					response_map.height = 0;
+					return;
+				}
+
+				ResizeTensors(image.getSize());
+			}
+
+			for (size_t s = 0; s < graph.steps.size(); ++s)
+			{
+				Step& step = graph.steps[s];
+				switch (step.kind)
+				{
+				case Step::ConvStep: RunConv(step, image); break;
+				case Step::DenseStep: RunDense(step); break;
+				case Step::ActStep: RunAct(step); break;
+				}
+			}
+
+#ifdef USE_AVX
+			_mm256_zeroupper();
+#endif
+
+			const Tensor& output = graph.tensors[graph.steps.back().dst];
+			float* data = tensorMap(output, 0);
+			if (response_map.isEmpty())
+			{
+				response_map.width = output.size.cols;
+				response_map.height = output.maps * output.size.rows;
+				response_map.widthStep = output.size.step;
+				response_map.data = data;
+				response_map.sharingData = true;
+			}
+			else
+			{
+				response_map.width = output.size.cols;
+				response_map.height = output.maps * output.size.rows;
+				response_map.copyData(output.size.cols, output.maps * output.size.rows, data, output.size.step);
+			}
+		}
+	}
+
+#endif
+}
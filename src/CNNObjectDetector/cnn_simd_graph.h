@@ -0,0 +1,201 @@
+/*
+*	Copyright (c) 2018, Ilya Kalinovskiy
+*	All rights reserved.
+*
+*	This is an implementation of the algorithm described in the following paper:
+*		I.A. Kalinovskiy, V.G. Spitsyn,
+*		Compact Convolutional Neural Network Cascade for Face Detection,
+*		http://arxiv.org/abs/1508.01292.
+*
+*	Redistribution and use of this program as source code or in binary form, with or without modifications, are permitted provided that the following conditions are met:
+*		1. Redistributions may not be sold, nor may they be used in a commercial product or activity without prior permission from the copyright holder (contact him at kua_21@mail.ru).
+*		2. Redistributions may not be used for military purposes.
+*		3. Any published work which utilizes this program shall include the reference to the paper available at http://arxiv.org/abs/1508.01292
+*		4. Redistributions must retain the above copyright notice and the reference to the algorithm on which the implementation is based on, this list of conditions and the following disclaimer.
+*
+*	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+*	IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#pragma once
+
+#include "config.h"
+#include "image.h"
+
+#include <vector>
+#include <string>
+
+#ifdef USE_SSE
+#	include "cnnpp_simd_sse.h"
+#else
+#	ifdef USE_AVX
+#		include "cnnpp_simd_avx.h"
+#	else
+#		include "cnnpp_cplusplus.h"
+#	endif
+#endif
+
+#include "cnnpp_simd_template.h"
+
+
+//================================================================================================================================================
+
+
+namespace NeuralNetworksLib
+{
+#ifdef USE_CNTK_MODELS
+
+	namespace SIMD
+	{
+		//network of format 2.0 models: list of layers (conv, max pool, bn, leaky ReLU, tanh, 1x1 dense) on one input map,
+		//layers are fused into steps and buffers of steps are planned at load time, steps run on CNNPP and ConvTemplate kernels
+		class LayerGraph
+		{
+		public:
+			enum LayerType
+			{
+				Conv = 0,		//maps, kernel_w, kernel_h, connection, weights[maps][in maps or 1][kernel_h][kernel_w], bias[maps]
+				MaxPool = 1,	//size (2 x 2, stride 2)
+				BatchNorm = 2,	//weight[maps], bias[maps]
+				LeakyReLU = 3,	//w1[maps], w2[maps]: w1 * x + w2 * max(0, x)
+				Tanh = 4,		//w[maps]: tanh(w * x)
+				Dense = 5		//maps, weights[maps][in maps], bias[maps]: 1x1 conv over all input maps
+			};
+			enum ConvConnection
+			{
+				ConvFull = 0,		//output map sums conv of all input maps
+				ConvNeighbours = 1	//maps / (in maps) output maps per input map i on sum of input maps i - 1, i, i + 1 (layers 2, 3 of cntk models)
+			};
+
+		private:
+			struct Layer
+			{
+				int type = 0;
+				int maps = 0;
+				Size2d kernel;
+				int connection = 0;
+				int pool = 0;
+				std::vector<float> weight;
+				std::vector<float> bias;
+			};
+
+			//per map y = w1 * (x + b) + w2 * max(0, x + b) + t (Linear),
+			//y = scale * tanh(tanh_w * (x + b)) + t (Tanh) or y = scale * (0.5 tanh(tanh_w * (x + b)) + 0.5) + t (Sigmoid)
+			struct Epilogue
+			{
+				enum Form { Linear = 0, Tanh = 1, Sigmoid = 2 };
+
+				int form = Linear;
+				std::vector<float> b, w1, w2, t;
+				std::vector<float> tanh_w, scale;
+
+				void init(int maps);
+			};
+
+			struct Tensor
+			{
+				int maps = 0;
+				Size2d size;		//cols x rows of valid outputs, step of map rows
+				int plane = 0;		//offset of maps
+				int buffer = -1;	//index of buffers, -1 for input image
+			};
+
+			struct Step
+			{
+				enum Kind { ConvStep = 0, DenseStep = 1, ActStep = 2 };
+
+				int kind = ActStep;
+				int src = 0;
+				int dst = 0;
+				bool pool = false;
+
+				//conv: kernels of output maps (row-major, input maps of full connection one by one), generated kernel of one input map
+				Size2d kernel;
+				int connection = 0;
+				std::vector<float> kernels;
+				ConvTemplate::Kernel conv_template = nullptr;
+
+				//dense: nonzero inputs and weights of output maps
+				std::vector<std::vector<int>> inputs;
+				std::vector<std::vector<float>> weights;
+				bool sigmoid_sum = false;
+
+				Epilogue af;
+			};
+
+			struct Graph
+			{
+				Size min_image_size;
+				Size max_image_size;
+				Size input_size;
+
+				std::vector<Step> steps;
+				std::vector<Tensor> tensors;
+
+				//buffers shared by tensors of disjoint lifetimes
+				std::vector<int> buffer_size;
+				std::vector<Array_32f> buffers;
+
+				//sum of input maps of neighbours connection, im2col panel and GEMM result
+				Array_32f sum_buffer;
+				Array_32f gemm_panel;
+				Array_32f gemm_result;
+
+				std::vector<float*> src_ptr;
+				std::vector<float*> dst_ptr;
+
+				int stride = 1;
+				int index_output = -1;
+			};
+
+			Graph graph;
+			CNNPP cnnpp;
+
+			bool ReadLayers(std::istream& data_bin, std::vector<Layer>& layers, std::vector<float>& select_scale);
+			bool SelectOutput(std::vector<Layer>& layers, std::vector<float>& select_scale, int index_output);
+			bool Fuse(std::vector<Layer>& layers);
+			void PlanBuffers();
+			void ResizeTensors(const Size size);
+
+			void RunConv(Step& step, Image_32f& image);
+			void RunConvMaps(Step& step, float** dst, int dst_size_l, const float* src, int src_size_l, int group, int L, int H, int in_maps);
+			void RunConvGEMM(Step& step, float** dst, int dst_size_l, const float** src, int src_size_l, int group, int in_maps, int L, int H);
+			void RunDense(Step& step);
+			void RunAct(Step& step);
+			void ApplyEpilogue(Epilogue& af, int k, float* dst, float* src, int size);
+
+			inline float* tensorMap(const Tensor& tensor, int k) { return graph.buffers[tensor.buffer](k * tensor.plane); }
+
+		public:
+			LayerGraph() { }
+			~LayerGraph() { Clear(); }
+
+			//index_output >= 0 keeps one map of the last layer
+			void Init(std::string file_name, int index_output = -1);
+			void AllocateMemory(const Size size);
+			void Clear();
+
+			//response map: maps of the last layer stacked by rows
+			void Forward(Image_32f& response_map, Image_32f& image);
+
+			inline bool isEmpty() const { return graph.min_image_size.width == 0 || graph.min_image_size.height == 0; }
+
+			inline Size getMinInputImgSize() const { return graph.min_image_size; }
+			inline Size getMaxInputImgSize() const { return graph.max_image_size; }
+			inline Size getInputImgSize() const { return graph.input_size; }
+			Size getOutputImgSize() const;
+			Size getOutputImgSize(const Size size) const;
+			inline float getInputOutputRatio() const { return float(graph.stride); }
+
+			//count of fused steps and buffers (tests, benchmarks)
+			inline int getStepCount() const { return (int)graph.steps.size(); }
+			inline int getBufferCount() const { return (int)graph.buffer_size.size(); }
+
+			LayerGraph(const LayerGraph&) = delete;
+			LayerGraph& operator=(const LayerGraph&) = delete;
+		};
+	}
+
+#endif
+}
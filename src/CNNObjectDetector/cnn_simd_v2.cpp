@@ -19,6 +19,7 @@
 
 
 #include "cnn_simd_v2.h"
+#include "cnn_detector_profiler.h"
 #include <fstream>
 #include <sstream>
 #include <iterator>
@@ -42,17 +43,17 @@ namespace NeuralNetworksLib
 			std::stringstream data_bin;
 			if (file_name.size() < 255)
 			{
-				std::fstream data_bin;
-				data_bin.open(file_name.c_str(), std::fstream::binary | std::fstream::in);
+				std::fstream file_bin;
+				file_bin.open(file_name.c_str(), std::fstream::binary | std::fstream::in);
 
-				if (!data_bin.is_open())
+				if (!file_bin.is_open())
 				{
 					printf("[SIMD::CNN_v2] Configuration file not found!\n");
 					return;
 				}
 
-				data_bin << data_bin.rdbuf();
-				data_bin.close();
+				data_bin << file_bin.rdbuf();
+				file_bin.close();
 			}
 			else
 			{
@@ -487,6 +488,78 @@ namespace NeuralNetworksLib
 			cnn.output_buffer_size.size = cnn.output_buffer_size.rows * cnn.output_buffer_size.step;
 		}
 
+		void ConvNeuralNetwork_v2::Run_L3(const long long pixels)
+		{
+#ifdef PROFILE_CNN_SIMD
+			Timer timer(1, true);
+#endif
+
+			{
+				DetectorProfiler::Span span(profiler, DetectorProfiler::stage1_l3, -1, pixels);
+
+				//6x5 only
+				cnnpp.conv_6x5(
+								cnn.layer_buffer[2].conv_buffer(),
+								cnn.layer_buffer[2].conv_buffer_size.cols, 
+								cnn.layer_buffer[1].pool_buffer(),
+								cnn.layer_buffer[1].pool_buffer_size.cols, 
+								cnn.layer_buffer[1].pool_buffer_size.rows, 
+								cnn.conv_l3.kernels(),
+								cnn.conv_l3.ROI.cols, 
+								cnn.conv_l3.ROI.rows,
+								num_threads);
+			
+				//full_connect no support
+				cnnpp.tanh_tanh_2tanh(
+							cnn.layer_buffer[2].pool_buffer(),
+							cnn.layer_buffer[2].pool_buffer_size.cols,
+							cnn.layer_buffer[2].conv_buffer(),
+							cnn.layer_buffer[2].conv_buffer_size.cols,
+							cnn.layer_buffer[2].conv_buffer_size.rows,
+							cnn.conv_bias[2](), cnn.subs_weight[2](),
+							cnn.subs_bias[2](),
+							&(cnn.af_scale), 
+							cnn.snn_hl_weight(),
+							cnn.snn_hl_bias(),
+							cnn.snn_hl_weight(8),
+							cnn.snn_hl_bias(8),
+							cnn.snn_ol_weight(),
+							cnn.snn_ol_weight(8),
+							num_threads);
+			
+				cnnpp.tanh_tanh_2tanh(
+							cnn.layer_buffer[2].pool_buffer(1),
+							cnn.layer_buffer[2].pool_buffer_size.cols,
+							cnn.layer_buffer[2].conv_buffer(cnn.layer_buffer[2].conv_buffer_size.cols / 2),
+							cnn.layer_buffer[2].conv_buffer_size.cols,
+							cnn.layer_buffer[2].conv_buffer_size.rows,
+							cnn.conv_bias[2](8),
+							cnn.subs_weight[2](8),
+							cnn.subs_bias[2](8),
+							&(cnn.af_scale), 
+							cnn.snn_hl_weight(16),
+							cnn.snn_hl_bias(16),
+							cnn.snn_hl_weight(16 + 8),
+							cnn.snn_hl_bias(16 + 8),
+							cnn.snn_ol_weight(16),
+							cnn.snn_ol_weight(16 + 8),
+							num_threads);
+
+				cnnpp.tanh(
+						cnn.layer_buffer[2].pool_buffer(),
+						cnn.layer_buffer[2].pool_buffer_size.cols, 
+						cnn.layer_buffer[2].pool_buffer(),
+						cnn.layer_buffer[2].pool_buffer_size.cols,
+						cnn.layer_buffer[2].pool_buffer_size.rows,
+						&(cnn.snn_ol_bias), 
+						&(cnn.af_scale),
+						num_threads);
+			}
+
+#ifdef PROFILE_CNN_SIMD
+			printf("	cnn_simd_v2: run_L3 = %7.3f ms (sum, conv_l3, tanh_tanh_2tanh_tanh)\n", timer.get(1000));
+#endif
+		}
 		void ConvNeuralNetwork_v2::Forward(Image_32f& response_map, Image_32f& image)
 		{
 			if (image.width != cnn.input_buffer_size.cols || image.height != cnn.input_buffer_size.rows)
@@ -517,29 +590,36 @@ namespace NeuralNetworksLib
 			Timer timer(1, true);
 #endif
 
-			cnnpp.conv_4x4(
-						cnn.layer_buffer[0].conv_buffer(), 
-						cnn.layer_buffer[0].conv_buffer_size.cols, 
-						image.data,
-						image.widthStep,
-						cnn.input_buffer_size.rows, 
-						cnn.conv_l1.kernels(),
-						cnn.conv_l1.ROI.cols,
-						cnn.conv_l1.ROI.rows,
-						num_threads);
+			//per-layer spans count input image pixels
+			const long long pixels = (long long)image.width * (long long)image.height;
 
-			//max_pool only
-			cnnpp.max_tanh_tanh(
-							cnn.layer_buffer[0].pool_buffer(),
-							cnn.layer_buffer[0].pool_buffer_size.cols, 
-							cnn.layer_buffer[0].conv_buffer(),
-							cnn.layer_buffer[0].conv_buffer_size.cols,
-							cnn.layer_buffer[0].conv_buffer_size.rows, 
-							cnn.conv_bias[0](), cnn.subs_weight[0](),
-							cnn.subs_bias[0](),
-							&(cnn.af_scale),
+			{
+				DetectorProfiler::Span span(profiler, DetectorProfiler::stage1_l1, -1, pixels);
+
+				cnnpp.conv_4x4(
+							cnn.layer_buffer[0].conv_buffer(), 
+							cnn.layer_buffer[0].conv_buffer_size.cols, 
+							image.data,
+							image.widthStep,
+							cnn.input_buffer_size.rows, 
+							cnn.conv_l1.kernels(),
+							cnn.conv_l1.ROI.cols,
+							cnn.conv_l1.ROI.rows,
 							num_threads);
 
+				//max_pool only
+				cnnpp.max_tanh_tanh(
+								cnn.layer_buffer[0].pool_buffer(),
+								cnn.layer_buffer[0].pool_buffer_size.cols, 
+								cnn.layer_buffer[0].conv_buffer(),
+								cnn.layer_buffer[0].conv_buffer_size.cols,
+								cnn.layer_buffer[0].conv_buffer_size.rows, 
+								cnn.conv_bias[0](), cnn.subs_weight[0](),
+								cnn.subs_bias[0](),
+								&(cnn.af_scale),
+								num_threads);
+			}
+
 #ifdef CHECK_TEST
 			for (int i = 0; i < cnn.layer_buffer[0].map_count; ++i)
 			{
@@ -567,29 +647,33 @@ namespace NeuralNetworksLib
 			timer.start();
 #endif
 
-			cnnpp.conv_3x3(
-						cnn.layer_buffer[1].conv_buffer(),
-						cnn.layer_buffer[1].conv_buffer_size.cols, 
-						cnn.layer_buffer[0].pool_buffer(),
-						cnn.layer_buffer[0].pool_buffer_size.cols, 
-						cnn.layer_buffer[0].pool_buffer_size.rows, 
-						cnn.conv_l2.kernels(),
-						cnn.conv_l2.ROI.cols, 
-						cnn.conv_l2.ROI.rows,
-						num_threads);
-			
-			//max_pool only
-			cnnpp.max_tanh_tanh(
-							cnn.layer_buffer[1].pool_buffer(),
-							cnn.layer_buffer[1].pool_buffer_size.cols, 
+			{
+				DetectorProfiler::Span span(profiler, DetectorProfiler::stage1_l2, -1, pixels);
+
+				cnnpp.conv_3x3(
 							cnn.layer_buffer[1].conv_buffer(),
-							cnn.layer_buffer[1].conv_buffer_size.cols,
-							cnn.layer_buffer[1].conv_buffer_size.rows, 
-							cnn.conv_bias[1](),
-							cnn.subs_weight[1](),
-							cnn.subs_bias[1](),
-							&(cnn.af_scale),
+							cnn.layer_buffer[1].conv_buffer_size.cols, 
+							cnn.layer_buffer[0].pool_buffer(),
+							cnn.layer_buffer[0].pool_buffer_size.cols, 
+							cnn.layer_buffer[0].pool_buffer_size.rows, 
+							cnn.conv_l2.kernels(),
+							cnn.conv_l2.ROI.cols, 
+							cnn.conv_l2.ROI.rows,
 							num_threads);
+			
+				//max_pool only
+				cnnpp.max_tanh_tanh(
+								cnn.layer_buffer[1].pool_buffer(),
+								cnn.layer_buffer[1].pool_buffer_size.cols, 
+								cnn.layer_buffer[1].conv_buffer(),
+								cnn.layer_buffer[1].conv_buffer_size.cols,
+								cnn.layer_buffer[1].conv_buffer_size.rows, 
+								cnn.conv_bias[1](),
+								cnn.subs_weight[1](),
+								cnn.subs_bias[1](),
+								&(cnn.af_scale),
+								num_threads);
+			}
 
 #ifdef CHECK_TEST
 			for (int i = 0; i < cnn.layer_buffer[1].map_count; ++i)
@@ -615,70 +699,9 @@ namespace NeuralNetworksLib
 
 #ifdef PROFILE_CNN_SIMD
 			printf("	cnn_simd_v2: run_L2 = %7.3f ms (sum, conv_l2, tanh_avr_tanh)\n", timer.get(1000));
-			timer.start();
 #endif
 
-			//6x5 only
-			cnnpp.conv_6x5(
-							cnn.layer_buffer[2].conv_buffer(),
-							cnn.layer_buffer[2].conv_buffer_size.cols, 
-							cnn.layer_buffer[1].pool_buffer(),
-							cnn.layer_buffer[1].pool_buffer_size.cols, 
-							cnn.layer_buffer[1].pool_buffer_size.rows, 
-							cnn.conv_l3.kernels(),
-							cnn.conv_l3.ROI.cols, 
-							cnn.conv_l3.ROI.rows,
-							num_threads);
-			
-			//full_connect no support
-			cnnpp.tanh_tanh_2tanh(
-						cnn.layer_buffer[2].pool_buffer(),
-						cnn.layer_buffer[2].pool_buffer_size.cols,
-						cnn.layer_buffer[2].conv_buffer(),
-						cnn.layer_buffer[2].conv_buffer_size.cols,
-						cnn.layer_buffer[2].conv_buffer_size.rows,
-						cnn.conv_bias[2](), cnn.subs_weight[2](),
-						cnn.subs_bias[2](),
-						&(cnn.af_scale), 
-						cnn.snn_hl_weight(),
-						cnn.snn_hl_bias(),
-						cnn.snn_hl_weight(8),
-						cnn.snn_hl_bias(8),
-						cnn.snn_ol_weight(),
-						cnn.snn_ol_weight(8),
-						num_threads);
-			
-			cnnpp.tanh_tanh_2tanh(
-						cnn.layer_buffer[2].pool_buffer(1),
-						cnn.layer_buffer[2].pool_buffer_size.cols,
-						cnn.layer_buffer[2].conv_buffer(cnn.layer_buffer[2].conv_buffer_size.cols / 2),
-						cnn.layer_buffer[2].conv_buffer_size.cols,
-						cnn.layer_buffer[2].conv_buffer_size.rows,
-						cnn.conv_bias[2](8),
-						cnn.subs_weight[2](8),
-						cnn.subs_bias[2](8),
-						&(cnn.af_scale), 
-						cnn.snn_hl_weight(16),
-						cnn.snn_hl_bias(16),
-						cnn.snn_hl_weight(16 + 8),
-						cnn.snn_hl_bias(16 + 8),
-						cnn.snn_ol_weight(16),
-						cnn.snn_ol_weight(16 + 8),
-						num_threads);
-
-			cnnpp.tanh(
-					cnn.layer_buffer[2].pool_buffer(),
-					cnn.layer_buffer[2].pool_buffer_size.cols, 
-					cnn.layer_buffer[2].pool_buffer(),
-					cnn.layer_buffer[2].pool_buffer_size.cols,
-					cnn.layer_buffer[2].pool_buffer_size.rows,
-					&(cnn.snn_ol_bias), 
-					&(cnn.af_scale),
-					num_threads);
-
-#ifdef PROFILE_CNN_SIMD
-			printf("	cnn_simd_v2: run_L3 = %7.3f ms (sum, conv_l3, tanh_tanh_2tanh_tanh)\n", timer.get(1000));
-#endif
+			Run_L3(pixels);
 
 #ifdef CHECK_TEST
 			int count4 = 0;
@@ -731,6 +754,100 @@ namespace NeuralNetworksLib
 
 			return Size(cnn_conv_l3_ROI_cols, cnn_conv_l3_ROI_rows);
 		}
+
+		Size ConvNeuralNetwork_v2::getFeatureMapsSize(const Size size)
+		{
+			//size layer2
+			int cnn_conv_l2_ROI_cols = ((size.width - (cnn.conv_l1.size.cols - 1)) >> 1) - (cnn.conv_l2.size.cols - 1);
+			int cnn_conv_l2_ROI_rows = ((size.height - (cnn.conv_l1.size.rows - 1)) >> 1) - (cnn.conv_l2.size.rows - 1);
+
+			return Size(cnn_conv_l2_ROI_cols >> 1, cnn_conv_l2_ROI_rows >> 1);
+		}
+		void ConvNeuralNetwork_v2::getFeatureMaps(Image_32f& maps)
+		{
+			const int cols = cnn.conv_l2.ROI.cols >> 1;
+			const int rows = cnn.conv_l2.ROI.rows >> 1;
+			const int map_count = cnn.layer_buffer[1].map_count;
+
+			if (maps.width != cols || maps.height != map_count * rows)
+			{
+				maps = Image_32f(cols, map_count * rows, ALIGN_DEF, false);
+			}
+
+			//maps are interleaved in layer 2 buffer
+			const float* src = cnn.layer_buffer[1].pool_buffer();
+			const int src_step = cnn.layer_buffer[1].pool_buffer_size.cols;
+			for (int i = 0; i < map_count; ++i)
+			{
+				for (int y = 0; y < rows; ++y)
+				{
+					const float* pSrc = src + y * src_step + i;
+					float* pDst = maps.data + (i * rows + y) * maps.widthStep;
+					for (int x = 0; x < cols; ++x)
+					{
+						pDst[x] = pSrc[map_count * x];
+					}
+				}
+			}
+		}
+		void ConvNeuralNetwork_v2::ForwardFeatureMaps(Image_32f& response_map, Image_32f& maps, const Size size)
+		{
+			if (size.width != cnn.input_buffer_size.cols || size.height != cnn.input_buffer_size.rows)
+			{
+				if (size.width < cnn.min_image_size.width || size.height < cnn.min_image_size.height ||
+					size.width > cnn.max_image_size.width || size.height > cnn.max_image_size.height)
+				{
+					response_map.width = 0;
+					response_map.height = 0;
+					return;
+				}
+
+				ResizeBuffers(size);
+			}
+
+			const int cols = cnn.conv_l2.ROI.cols >> 1;
+			const int rows = cnn.conv_l2.ROI.rows >> 1;
+			const int map_count = cnn.layer_buffer[1].map_count;
+
+			if (maps.width != cols || maps.height != map_count * rows)
+			{
+				response_map.width = 0;
+				response_map.height = 0;
+				return;
+			}
+
+			float* dst = cnn.layer_buffer[1].pool_buffer();
+			const int dst_step = cnn.layer_buffer[1].pool_buffer_size.cols;
+			for (int i = 0; i < map_count; ++i)
+			{
+				for (int y = 0; y < rows; ++y)
+				{
+					const float* pSrc = maps.data + (i * rows + y) * maps.widthStep;
+					float* pDst = dst + y * dst_step + i;
+					for (int x = 0; x < cols; ++x)
+					{
+						pDst[map_count * x] = pSrc[x];
+					}
+				}
+			}
+
+			Run_L3((long long)size.width * (long long)size.height);
+
+			if (response_map.isEmpty())
+			{
+				response_map.width = cnn.output_buffer_size.cols;
+				response_map.height = cnn.output_buffer_size.rows;
+				response_map.widthStep = cnn.output_buffer_size.step;
+				response_map.data = cnn.layer_buffer[2].pool_buffer();
+				response_map.sharingData = true;
+			}
+			else
+			{
+				response_map.width = cnn.output_buffer_size.cols;
+				response_map.height = cnn.output_buffer_size.rows;
+				response_map.copyData(cnn.output_buffer_size.cols, cnn.output_buffer_size.rows, cnn.layer_buffer[2].pool_buffer(), cnn.output_buffer_size.step);
+			}
+		}
 	}
 
 #endif
@@ -44,6 +44,8 @@ namespace NeuralNetworksLib
 {
 #if defined(USE_AVX) && !defined(USE_CNTK_MODELS)
 
+	class DetectorProfiler;
+
 	namespace SIMD
 	{
 		class ConvNeuralNetwork_v2
@@ -104,8 +106,10 @@ namespace NeuralNetworksLib
 			CNNPP_v2 cnnpp;
 
 			int num_threads = 0; //OpenMP only
+			DetectorProfiler* profiler = nullptr;
 
 			void ResizeBuffers(const Size size);
+			void Run_L3(const long long pixels);
 
 		public:
 			ConvNeuralNetwork_v2() { }
@@ -129,6 +133,20 @@ namespace NeuralNetworksLib
 			inline int getNumThreads() const { return num_threads; }
 			inline void setNumThreads(int _num_threads) { num_threads = MAX(1, _num_threads); }
 
+			//approximate feature pyramid: pooled layer 2 maps stacked by rows (getFeatureMapsCount maps of getFeatureMapsSize),
+			//layer 2 cell (x, y) is centered at input pixel getFeatureMapsStride() * (x, y) + getFeatureMapsOffset()
+			Size getFeatureMapsSize(const Size size);
+			inline int getFeatureMapsCount() const { return cnn.layer_buffer[1].map_count; }
+			inline float getFeatureMapsStride() const { return 4.f; }
+			inline float getFeatureMapsOffset() const { return 1.5f + 0.5f * float(cnn.conv_l1.size.cols - 1) + float(cnn.conv_l2.size.cols - 1); }
+			//layer 2 maps of last Forward
+			void getFeatureMaps(Image_32f& maps);
+			//layers 3+ of image of given size on layer 2 maps
+			void ForwardFeatureMaps(Image_32f& response_map, Image_32f& maps, const Size size);
+
+			//layer spans of stage 1
+			inline void setProfiler(DetectorProfiler* _profiler) { profiler = _profiler; }
+
 #ifdef CHECK_TEST
 			private: Legacy::ConvNeuralNetwork* cnn_ref = NULL;
 			public:  inline void setCNNRef(Legacy::ConvNeuralNetwork* _cnn) { cnn_ref = _cnn; }
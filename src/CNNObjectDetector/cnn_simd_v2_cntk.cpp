@@ -19,10 +19,12 @@
 
 
 #include "cnn_simd_v2_cntk.h"
+#include "cnn_detector_profiler.h"
 #include <fstream>
 #include <sstream>
 #include <iterator>
 #include <immintrin.h>
+#include <cmath>
 
 #ifdef USE_OMP
 #	include <omp.h>
@@ -38,6 +40,63 @@ namespace NeuralNetworksLib
 
 	namespace SIMD
 	{
+		//topology of kernels of CNNPP_v2: max pool, 3 conv layers of 4, 8, 16 maps with 4x4, 3x3, 4x5 (w x h) kernels
+		static bool isSupportedTopology(std::stringstream& data_bin)
+		{
+			const std::streampos pos = data_bin.tellg();
+
+			bool max_pool = false;
+			Size min_image_size;
+			int layer_count = 0;
+			FB_READ(data_bin, max_pool);
+			FB_READ(data_bin, min_image_size.width);
+			FB_READ(data_bin, min_image_size.height);
+			FB_READ(data_bin, layer_count);
+
+			bool supported = max_pool && layer_count == 3;
+			if (supported)
+			{
+				const int maps[3] = { 4, 8, 16 };
+				const Size kernels[3] = { Size(4, 4), Size(3, 3), Size(4, 5) };
+
+				int map_count[3] = { 0, 0, 0 };
+				for (int l = 0; l < 3; ++l)
+				{
+					FB_READ(data_bin, map_count[l]);
+				}
+				for (int l = 0; l < 3 && supported && data_bin; ++l)
+				{
+					int kernel_width = 0;
+					int kernel_height = 0;
+					FB_READ(data_bin, kernel_width);
+					FB_READ(data_bin, kernel_height);
+					data_bin.seekg(kernel_width * kernel_height * map_count[l] * sizeof(float), std::ios_base::cur);
+
+					supported = map_count[l] == maps[l] && kernel_width == kernels[l].width && kernel_height == kernels[l].height;
+				}
+				supported = supported && !!data_bin;
+			}
+
+			data_bin.clear();
+			data_bin.seekg(pos);
+			return supported;
+		}
+
+		void ConvNeuralNetwork_v2::InitGeneric(std::string file_name, int index_output, void* hGrd)
+		{
+			cnn_generic = new ConvNeuralNetwork();
+			cnn_generic->setInt8(int8);
+			cnn_generic->Init(file_name, index_output, hGrd);
+			if (cnn_generic->isEmpty())
+			{
+				delete cnn_generic;
+				cnn_generic = nullptr;
+				return;
+			}
+
+			num_threads = cnn_generic->getNumThreads();
+		}
+
 		void ConvNeuralNetwork_v2::Init(std::string file_name, int index_output, void* hGrd)
 		{
 			std::stringstream data_bin;
@@ -64,12 +123,29 @@ namespace NeuralNetworksLib
 			float format_version = 0.0f;
 			FB_READ(data_bin, format_version);
 
-			if (format_version < 1.0f || format_version > 1.1f)
+			if (format_version < 1.0f || (format_version > 1.2f && format_version < 1.9f))
 			{
 				printf("[SIMD::CNN_v2] Configuration file format is not supported!\n");
 				return;
 			}
 
+			//int8 models (AVX2 builds), layer graph models and other topologies (retrained models of 6, 8 maps of layer 1 etc.);
+			//without setInt8 format 1.2 models run their float weights here
+#ifdef USE_AVX2
+			const bool q8 = format_version > 1.1f && int8;
+#else
+			const bool q8 = false;
+			if (format_version > 1.1f && int8)
+			{
+				printf("[SIMD::CNN_v2] Int8 layers are not supported by this build, float weights are used!\n");
+			}
+#endif
+			if (q8 || format_version > 1.2f || !isSupportedTopology(data_bin))
+			{
+				InitGeneric(file_name, index_output, hGrd);
+				return;
+			}
+
 			//max pool
 			FB_READ(data_bin, cnn.max_pool);
 
@@ -270,8 +346,8 @@ namespace NeuralNetworksLib
 				cnn.conv_l3.size.size != 20 ||
 				index_output < 0)
 			{
-				printf("[SIMD::CNN_v2] This configuration cnn models is not supported!\n");
 				Clear();
+				InitGeneric(file_name, index_output, hGrd);
 				return;
 			}
 
@@ -419,6 +495,12 @@ namespace NeuralNetworksLib
 		}
 		void ConvNeuralNetwork_v2::AllocateMemory(const Size size)
 		{
+			if (cnn_generic != nullptr)
+			{
+				cnn_generic->AllocateMemory(size);
+				return;
+			}
+
 			if (size.width < cnn.min_image_size.width || size.height < cnn.min_image_size.height)
 			{
 				return;
@@ -479,6 +561,12 @@ namespace NeuralNetworksLib
 		}
 		void ConvNeuralNetwork_v2::Clear()
 		{
+			if (cnn_generic != nullptr)
+			{
+				delete cnn_generic;
+				cnn_generic = nullptr;
+			}
+
 			if (isEmpty()) return;
 
 			cnn.min_image_size = Size(0, 0);
@@ -486,6 +574,9 @@ namespace NeuralNetworksLib
 
 			//clear buffers
 			cnn.layer_buffer.clear();
+			cnn.heads_buffer.clear();
+			cnn.heads_dst.clear();
+			cnn.heads_ol_weight.clear();
 
 			//clear weight
 			//conv kernels L1
@@ -493,6 +584,8 @@ namespace NeuralNetworksLib
 
 			//conv kernels L2
 			cnn.conv_l2.kernels.clear();
+			cnn.conv_l2.wino_kernels.clear();
+			cnn.winograd_layers = 0;
 
 			//conv kernels L3
 			cnn.conv_l3.kernels.clear();
@@ -565,8 +658,123 @@ namespace NeuralNetworksLib
 			cnn.output_buffer_size.step = cnn.layer_buffer[2].size.cols;
 			cnn.output_buffer_size.size = cnn.output_buffer_size.rows * cnn.output_buffer_size.step;
 		}
+		void ConvNeuralNetwork_v2::Run_L3(const long long pixels)
+		{
+#ifdef PROFILE_CNN_SIMD
+			Timer timer(1, true);
+#endif
+
+			{
+				DetectorProfiler::Span span(profiler, DetectorProfiler::stage1_l3, -1, pixels);
+
+				//5x4 only
+				cnnpp.conv_5x4_lrelu_bn(
+							cnn.layer_buffer[2].buffer(), 
+							cnn.layer_buffer[2].size.cols, 
+							cnn.layer_buffer[1].buffer(),
+							cnn.layer_buffer[1].size.cols,
+							cnn.layer_buffer[1].size.rows,
+							cnn.conv_l3.kernels(), 
+							cnn.conv_bias[2](),
+							cnn.leakyReLU_w1[2](),
+							cnn.leakyReLU_w2[2](),
+							cnn.bn_weight[2](),
+							cnn.bn_bias[2](),
+							cnn.conv_l3.ROI.cols, 
+							cnn.conv_l3.ROI.rows,
+							num_threads);
+			
+				if (!cnn.heads.empty())
+				{
+					//ForwardOutputs: hidden layer once, output neurons of heads on it, af_scale as of Init with index_output of head
+					cnnpp.mulCN_add_tanhW_add_N(
+								(int)cnn.heads.size(),
+								cnn.heads_dst.data(),
+								cnn.heads_size.step,
+								cnn.layer_buffer[2].buffer(),
+								cnn.layer_buffer[2].size.cols,
+								cnn.layer_buffer[2].size.rows,
+								cnn.snn_hl_weight_ref(),
+								cnn.snn_hl_bias_ref(),
+								cnn.snn_hl_tanh_w(),
+								cnn.snn_hl_bn_weight(),
+								cnn.snn_hl_bn_bias(),
+								cnn.heads_ol_weight.data(),
+								cnn.conv_l3.ROI.cols,
+								cnn.conv_l3.ROI.rows,
+								num_threads);
+
+					for (int j = 0; j < (int)cnn.heads.size(); ++j)
+					{
+						float af_scale = cnn.heads[j] == 0 ? -fabsf(cnn.af_scale) : fabsf(cnn.af_scale);
+						cnnpp.tanhW(
+									cnn.heads_dst[j],
+									cnn.heads_size.step,
+									cnn.heads_dst[j],
+									cnn.heads_size.step,
+									cnn.conv_l3.ROI.rows,
+									&(cnn.snn_ol_bias[cnn.heads[j]]),
+									&(cnn.snn_ol_tanh_w),
+									&af_scale,
+									cnn.conv_l3.ROI.cols,
+									cnn.conv_l3.ROI.rows,
+									num_threads);
+					}
+				}
+				else
+				{
+					Run_OL(cnn.layer_buffer[2].buffer(), cnn.layer_buffer[2].size.cols, cnn.index_output, &(cnn.af_scale));
+				}
+			}
+
+#ifdef USE_AVX
+			_mm256_zeroupper();
+#endif
+			
+#ifdef PROFILE_CNN_SIMD
+			printf("	cnn_simd_v2: run_L3 = %7.3f ms (sum, conv_l3, tanh_tanh_2tanh_tanh)\n", timer.get(1000));
+#endif
+		}
+		void ConvNeuralNetwork_v2::Run_OL(float* dst, int dst_size_l, int out_id, float* af_scale)
+		{
+			//full_connect no support
+			cnnpp.mulCN_add_tanhW_add(
+						dst,
+						dst_size_l,
+						cnn.layer_buffer[2].buffer(),
+						cnn.layer_buffer[2].size.cols,
+						cnn.layer_buffer[2].size.rows,
+						cnn.snn_hl_weight_ref(),
+						cnn.snn_hl_bias_ref(),
+						cnn.snn_hl_tanh_w(),
+						cnn.snn_hl_bn_weight(),
+						cnn.snn_hl_bn_bias(),
+						cnn.snn_ol_weight_ref[out_id](),
+						cnn.conv_l3.ROI.cols,
+						cnn.conv_l3.ROI.rows,
+						num_threads);
+
+			cnnpp.tanhW(
+						dst,
+						dst_size_l,
+						dst,
+						dst_size_l,
+						cnn.conv_l3.ROI.rows,
+						&(cnn.snn_ol_bias[out_id]),
+						&(cnn.snn_ol_tanh_w),
+						af_scale,
+						cnn.conv_l3.ROI.cols,
+						cnn.conv_l3.ROI.rows,
+						num_threads);
+		}
 		void ConvNeuralNetwork_v2::Forward(Image_32f& response_map, Image_32f& image)
 		{
+			if (cnn_generic != nullptr)
+			{
+				cnn_generic->Forward(response_map, image);
+				return;
+			}
+
 			if (image.width != cnn.input_buffer_size.cols || image.height != cnn.input_buffer_size.rows)
 			{
 				if (image.width < cnn.min_image_size.width || image.height < cnn.min_image_size.height ||
@@ -586,103 +794,85 @@ namespace NeuralNetworksLib
 			Timer timer(1, true);
 #endif
 
-			cnnpp.conv_4x4_lrelu_bn_max(
-						cnn.layer_buffer[0].buffer(),
-						cnn.layer_buffer[0].size.cols, 
-						image.data,
-						image.widthStep,
-						cnn.input_buffer_size.rows, 
-						cnn.conv_l1.kernels(),
-						cnn.conv_bias[0](),
-						cnn.leakyReLU_w1[0](), 
-						cnn.leakyReLU_w2[0](), 
-						cnn.bn_weight[0](),
-						cnn.bn_bias[0](),
-						cnn.conv_l1.ROI.cols,
-						cnn.conv_l1.ROI.rows,
-						num_threads);
+			//per-layer spans count input image pixels
+			const long long pixels = (long long)image.width * (long long)image.height;
+
+			{
+				DetectorProfiler::Span span(profiler, DetectorProfiler::stage1_l1, -1, pixels);
+
+				cnnpp.conv_4x4_lrelu_bn_max(
+							cnn.layer_buffer[0].buffer(),
+							cnn.layer_buffer[0].size.cols, 
+							image.data,
+							image.widthStep,
+							cnn.input_buffer_size.rows, 
+							cnn.conv_l1.kernels(),
+							cnn.conv_bias[0](),
+							cnn.leakyReLU_w1[0](), 
+							cnn.leakyReLU_w2[0](), 
+							cnn.bn_weight[0](),
+							cnn.bn_bias[0](),
+							cnn.conv_l1.ROI.cols,
+							cnn.conv_l1.ROI.rows,
+							num_threads);
+			}
 
 #ifdef PROFILE_CNN_SIMD
 			printf("	cnn_simd_v2: run_L1 = %7.3f ms (conv_l1, tanh_avr_tanh)\n", timer.get(1000));
 			timer.start();
 #endif
 
-			cnnpp.conv_3x3_lrelu_bn_max(
-						cnn.layer_buffer[1].buffer(),
-						cnn.layer_buffer[1].size.cols, 
-						cnn.layer_buffer[0].buffer(),
-						cnn.layer_buffer[0].size.cols,
-						cnn.layer_buffer[0].size.rows,
-						cnn.conv_l2.kernels(), 
-						cnn.conv_bias[1](),
-						cnn.leakyReLU_w1[1](), 
-						cnn.leakyReLU_w2[1](), 
-						cnn.bn_weight[1](),
-						cnn.bn_bias[1](),
-						cnn.conv_l2.ROI.cols, 
-						cnn.conv_l2.ROI.rows,
-						num_threads);
+			{
+				DetectorProfiler::Span span(profiler, DetectorProfiler::stage1_l2, -1, pixels);
 
-#ifdef PROFILE_CNN_SIMD
-			printf("	cnn_simd_v2: run_L2 = %7.3f ms (sum, conv_l2, tanh_avr_tanh)\n", timer.get(1000));
-			timer.start();
+#ifndef USE_FIXED_POINT
+				if (cnn.winograd_layers & 2)
+				{
+					cnnpp.conv_3x3_lrelu_bn_max_wino(
+							cnn.layer_buffer[1].buffer(),
+							cnn.layer_buffer[1].size.cols,
+							cnn.layer_buffer[0].buffer(),
+							cnn.layer_buffer[0].size.cols,
+							cnn.layer_buffer[0].size.rows,
+							cnn.conv_l2.wino_kernels(),
+							cnn.conv_bias[1](),
+							cnn.leakyReLU_w1[1](),
+							cnn.leakyReLU_w2[1](),
+							cnn.bn_weight[1](),
+							cnn.bn_bias[1](),
+							cnn.conv_l2.ROI.cols,
+							cnn.conv_l2.ROI.rows,
+							num_threads);
+				}
+				else
 #endif
+				cnnpp.conv_3x3_lrelu_bn_max(
+							cnn.layer_buffer[1].buffer(),
+							cnn.layer_buffer[1].size.cols, 
+							cnn.layer_buffer[0].buffer(),
+							cnn.layer_buffer[0].size.cols,
+							cnn.layer_buffer[0].size.rows,
+							cnn.conv_l2.kernels(), 
+							cnn.conv_bias[1](),
+							cnn.leakyReLU_w1[1](), 
+							cnn.leakyReLU_w2[1](), 
+							cnn.bn_weight[1](),
+							cnn.bn_bias[1](),
+							cnn.conv_l2.ROI.cols, 
+							cnn.conv_l2.ROI.rows,
+							num_threads);
+			}
 
-			//5x4 only
-			cnnpp.conv_5x4_lrelu_bn(
-						cnn.layer_buffer[2].buffer(), 
-						cnn.layer_buffer[2].size.cols, 
-						cnn.layer_buffer[1].buffer(),
-						cnn.layer_buffer[1].size.cols,
-						cnn.layer_buffer[1].size.rows,
-						cnn.conv_l3.kernels(), 
-						cnn.conv_bias[2](),
-						cnn.leakyReLU_w1[2](),
-						cnn.leakyReLU_w2[2](),
-						cnn.bn_weight[2](),
-						cnn.bn_bias[2](),
-						cnn.conv_l3.ROI.cols, 
-						cnn.conv_l3.ROI.rows,
-						num_threads);
-			
-			//full_connect no support
-			cnnpp.mulCN_add_tanhW_add(
-						cnn.layer_buffer[2].buffer(),
-						cnn.layer_buffer[2].size.cols,
-						cnn.layer_buffer[2].buffer(),
-						cnn.layer_buffer[2].size.cols,
-						cnn.layer_buffer[2].size.rows,
-						cnn.snn_hl_weight_ref(),
-						cnn.snn_hl_bias_ref(),
-						cnn.snn_hl_tanh_w(),
-						cnn.snn_hl_bn_weight(),
-						cnn.snn_hl_bn_bias(),
-						cnn.snn_ol_weight_ref[cnn.index_output](),
-						cnn.conv_l3.ROI.cols,
-						cnn.conv_l3.ROI.rows,
-						num_threads);
-
-			cnnpp.tanhW(
-						cnn.layer_buffer[2].buffer(),
-						cnn.layer_buffer[2].size.cols,
-						cnn.layer_buffer[2].buffer(),
-						cnn.layer_buffer[2].size.cols,
-						cnn.layer_buffer[2].size.rows,
-						&(cnn.snn_ol_bias[cnn.index_output]),
-						&(cnn.snn_ol_tanh_w),
-						&(cnn.af_scale),
-						cnn.conv_l3.ROI.cols,
-						cnn.conv_l3.ROI.rows,
-						num_threads);
-
-#ifdef USE_AVX
-			_mm256_zeroupper();
+#ifdef USE_FIXED_POINT
+			fct_l2 = cnnpp.getScale();
 #endif
-			
+
 #ifdef PROFILE_CNN_SIMD
-			printf("	cnn_simd_v2: run_L3 = %7.3f ms (sum, conv_l3, tanh_tanh_2tanh_tanh)\n", timer.get(1000));
+			printf("	cnn_simd_v2: run_L2 = %7.3f ms (sum, conv_l2, tanh_avr_tanh)\n", timer.get(1000));
 #endif
 
+			Run_L3(pixels);
+
 			if (response_map.isEmpty())
 			{
 				response_map.width = cnn.output_buffer_size.cols;
@@ -698,9 +888,76 @@ namespace NeuralNetworksLib
 				response_map.copyData(cnn.output_buffer_size.cols, cnn.output_buffer_size.rows, cnn.layer_buffer[2].buffer(), cnn.output_buffer_size.step);
 			}
 		}
+		void ConvNeuralNetwork_v2::ForwardOutputs(std::vector<Image_32f>& response_maps, Image_32f& image, const std::vector<int>& index_outputs)
+		{
+			if (cnn_generic != nullptr)
+			{
+				cnn_generic->ForwardOutputs(response_maps, image, index_outputs);
+				return;
+			}
+
+			const int count = (int)index_outputs.size();
+			response_maps.resize(count);
+			if (count == 0) return;
+
+			cnn.heads.resize(count);
+			for (int j = 0; j < count; ++j)
+			{
+				cnn.heads[j] = MIN(MAX(0, index_outputs[j]), cnn.snn_ol_neuron_count - 1);
+			}
+
+			const Size output_size = getOutputImgSize(image.getSize());
+			if (output_size.width > 0 && output_size.height > 0)
+			{
+				cnn.heads_size = Size2d(output_size.width, output_size.height, roundUpMul(output_size.width, REG_SIZE));
+				if (cnn.heads_buffer.size < count * cnn.heads_size.size)
+				{
+					cnn.heads_buffer = Array_32f(count * cnn.heads_size.size, ALIGN_DEF);
+				}
+
+				cnn.heads_dst.resize(count);
+				cnn.heads_ol_weight.resize(count);
+				for (int j = 0; j < count; ++j)
+				{
+					cnn.heads_dst[j] = cnn.heads_buffer(j * cnn.heads_size.size);
+					cnn.heads_ol_weight[j] = cnn.snn_ol_weight_ref[cnn.heads[j]]();
+				}
+			}
+
+			//layers 1, 2, 3 and hidden layer run once, Run_L3 evaluates heads into heads_buffer
+			Image_32f trunk_map;
+			Forward(trunk_map, image);
+			cnn.heads.clear();
+
+			for (int j = 0; j < count; ++j)
+			{
+				Image_32f& response_map = response_maps[j];
+				if (trunk_map.width == 0)
+				{
+					response_map.width = 0;
+					response_map.height = 0;
+				}
+				else if (response_map.isEmpty() || response_map.sharingData)
+				{
+					response_map.width = cnn.conv_l3.ROI.cols;
+					response_map.height = cnn.conv_l3.ROI.rows;
+					response_map.widthStep = cnn.heads_size.step;
+					response_map.data = cnn.heads_buffer(j * cnn.heads_size.size);
+					response_map.sharingData = true;
+				}
+				else
+				{
+					response_map.width = cnn.conv_l3.ROI.cols;
+					response_map.height = cnn.conv_l3.ROI.rows;
+					response_map.copyData(cnn.conv_l3.ROI.cols, cnn.conv_l3.ROI.rows, cnn.heads_buffer(j * cnn.heads_size.size), cnn.heads_size.step);
+				}
+			}
+		}
 
 		Size ConvNeuralNetwork_v2::getOutputImgSize(const Size size)
 		{
+			if (cnn_generic != nullptr) return cnn_generic->getOutputImgSize(size);
+
 			//size layer1
 			int cnn_conv_l1_ROI_cols = size.width - (cnn.conv_l1.size.cols - 1);
 			int cnn_conv_l1_ROI_rows = size.height - (cnn.conv_l1.size.rows - 1);
@@ -715,6 +972,163 @@ namespace NeuralNetworksLib
 
 			return Size(cnn_conv_l3_ROI_cols, cnn_conv_l3_ROI_rows);
 		}
+
+		void ConvNeuralNetwork_v2::setWinogradLayers(int layers)
+		{
+			cnn.winograd_layers = 0;
+			cnn.conv_l2.wino_kernels.clear();
+
+			if (cnn_generic != nullptr)
+			{
+				cnn_generic->setWinogradLayers(layers);
+				return;
+			}
+			if (isEmpty()) return;
+
+#ifndef USE_FIXED_POINT
+			if ((layers & 2) == 0 || cnn.conv_l2.size.cols != 3 || cnn.conv_l2.size.rows != 3) return;
+
+			//kernels of maps are interleaved: kernels[(r * 3 + c) * map_count + k]
+			const int map_count = cnn.layer_buffer[1].map_count;
+			cnn.conv_l2.wino_kernels = Array_32f(16 * map_count, ALIGN_DEF);
+			for (int k = 0; k < map_count; ++k)
+			{
+				ConvNeuralNetwork::WinogradKernel3x3(cnn.conv_l2.wino_kernels() + k, map_count, cnn.conv_l2.kernels() + k, 3 * map_count, map_count);
+			}
+
+			cnn.winograd_layers = 2;
+#endif
+		}
+
+		Size ConvNeuralNetwork_v2::getFeatureMapsSize(const Size size)
+		{
+			if (cnn_generic != nullptr) return cnn_generic->getFeatureMapsSize(size);
+
+			//size layer2
+			int cnn_conv_l2_ROI_cols = ((size.width - (cnn.conv_l1.size.cols - 1)) >> 1) - (cnn.conv_l2.size.cols - 1);
+			int cnn_conv_l2_ROI_rows = ((size.height - (cnn.conv_l1.size.rows - 1)) >> 1) - (cnn.conv_l2.size.rows - 1);
+
+			return Size(cnn_conv_l2_ROI_cols >> 1, cnn_conv_l2_ROI_rows >> 1);
+		}
+		void ConvNeuralNetwork_v2::getFeatureMaps(Image_32f& maps)
+		{
+			if (cnn_generic != nullptr)
+			{
+				cnn_generic->getFeatureMaps(maps);
+				return;
+			}
+
+			const int cols = cnn.conv_l2.ROI.cols >> 1;
+			const int rows = cnn.conv_l2.ROI.rows >> 1;
+			const int map_count = cnn.layer_buffer[1].map_count;
+
+			if (maps.width != cols || maps.height != map_count * rows)
+			{
+				maps = Image_32f(cols, map_count * rows, ALIGN_DEF, false);
+			}
+
+			//layer 2 buffer keeps cells of map_count interleaved maps per pooled column,
+			//max pooling of rows is fused into layer 3
+#ifdef USE_FIXED_POINT
+			const short* src = reinterpret_cast<const short*>(cnn.layer_buffer[1].buffer());
+			const int src_step = 2 * cnn.layer_buffer[1].size.cols;
+#else
+			const float* src = cnn.layer_buffer[1].buffer();
+			const int src_step = cnn.layer_buffer[1].size.cols;
+#endif
+			for (int i = 0; i < map_count; ++i)
+			{
+				for (int y = 0; y < rows; ++y)
+				{
+					const int offset = 2 * y * src_step + i;
+					float* pDst = maps.data + (i * rows + y) * maps.widthStep;
+					for (int x = 0; x < cols; ++x)
+					{
+						pDst[x] = float(MAX(src[offset + map_count * x], src[offset + src_step + map_count * x]));
+					}
+				}
+			}
+		}
+		void ConvNeuralNetwork_v2::ForwardFeatureMaps(Image_32f& response_map, Image_32f& maps, const Size size)
+		{
+			if (cnn_generic != nullptr)
+			{
+				cnn_generic->ForwardFeatureMaps(response_map, maps, size);
+				return;
+			}
+
+			if (size.width != cnn.input_buffer_size.cols || size.height != cnn.input_buffer_size.rows)
+			{
+				if (size.width < cnn.min_image_size.width || size.height < cnn.min_image_size.height ||
+					size.width > cnn.max_image_size.width || size.height > cnn.max_image_size.height)
+				{
+					response_map.width = 0;
+					response_map.height = 0;
+					return;
+				}
+
+				ResizeBuffers(size);
+			}
+
+			const int cols = cnn.conv_l2.ROI.cols >> 1;
+			const int rows = cnn.conv_l2.ROI.rows >> 1;
+			const int map_count = cnn.layer_buffer[1].map_count;
+
+			if (maps.width != cols || maps.height != map_count * rows)
+			{
+				response_map.width = 0;
+				response_map.height = 0;
+				return;
+			}
+
+#ifdef USE_FIXED_POINT
+			short* dst = reinterpret_cast<short*>(cnn.layer_buffer[1].buffer());
+			const int dst_step = 2 * cnn.layer_buffer[1].size.cols;
+#else
+			float* dst = cnn.layer_buffer[1].buffer();
+			const int dst_step = cnn.layer_buffer[1].size.cols;
+#endif
+			for (int i = 0; i < map_count; ++i)
+			{
+				for (int y = 0; y < rows; ++y)
+				{
+					const int offset = 2 * y * dst_step + i;
+					const float* pSrc = maps.data + (i * rows + y) * maps.widthStep;
+					for (int x = 0; x < cols; ++x)
+					{
+#ifdef USE_FIXED_POINT
+						const short value = (short)MIN(MAX(roundf(pSrc[x]), -32768.f), 32767.f);
+#else
+						const float value = pSrc[x];
+#endif
+						dst[offset + map_count * x] = value;
+						dst[offset + dst_step + map_count * x] = value;
+					}
+				}
+			}
+
+#ifdef USE_FIXED_POINT
+			//layer 3 continues fixed point scale of layer 2
+			cnnpp.setScale(fct_l2);
+#endif
+
+			Run_L3((long long)size.width * (long long)size.height);
+
+			if (response_map.isEmpty())
+			{
+				response_map.width = cnn.output_buffer_size.cols;
+				response_map.height = cnn.output_buffer_size.rows;
+				response_map.widthStep = cnn.output_buffer_size.step;
+				response_map.data = cnn.layer_buffer[2].buffer();
+				response_map.sharingData = true;
+			}
+			else
+			{
+				response_map.width = cnn.output_buffer_size.cols;
+				response_map.height = cnn.output_buffer_size.rows;
+				response_map.copyData(cnn.output_buffer_size.cols, cnn.output_buffer_size.rows, cnn.layer_buffer[2].buffer(), cnn.output_buffer_size.step);
+			}
+		}
 	}
 
 #endif
@@ -30,12 +30,16 @@
 #	include "timer.h"
 #endif
 
-#ifdef USE_FIXED_POINT
+#if defined(USE_FIXED_POINT) && defined(USE_AVX512)
+#	include "cnnpp_simd_avx512_v4.h"
+#elif defined(USE_FIXED_POINT)
 #	include "cnnpp_simd_avx_v3.h"
 #else
 #	include "cnnpp_simd_avx_v2.h"
 #endif
 
+#include "cnn_simd_cntk.h"
+
 
 //================================================================================================================================================
 
@@ -44,6 +48,8 @@ namespace NeuralNetworksLib
 {
 #if defined(USE_AVX) && defined(USE_CNTK_MODELS)
 
+	class DetectorProfiler;
+
 	namespace SIMD
 	{
 		class ConvNeuralNetwork_v2
@@ -62,6 +68,9 @@ namespace NeuralNetworksLib
 
 				Size2d size;
 				Array_32f kernels;
+
+				//Winograd F(2x2, 3x3) mode: 4x4 transformed kernels of maps
+				Array_32f wino_kernels;
 			};
 			struct CNN
 			{
@@ -105,21 +114,43 @@ namespace NeuralNetworksLib
 
 				int index_output = -1;
 
+				//output neurons of ForwardOutputs (empty: index_output), maps of heads of heads_size one by one
+				std::vector<int> heads;
+				Size2d heads_size;
+				Array_32f heads_buffer;
+				std::vector<float*> heads_dst;
+				std::vector<float**> heads_ol_weight;
+
 				float af_scale = 0.f;
 				bool max_pool = false;
 				bool snn_full_connect = false;
+
+				//bit l: conv layer l + 1 is run by Winograd F(2x2, 3x3)
+				int winograd_layers = 0;
 			};
 
 			CNN cnn;
-#ifdef USE_FIXED_POINT
+#if defined(USE_FIXED_POINT) && defined(USE_AVX512)
+			CNNPP_v4 cnnpp;
+			float fct_l2 = 0.f;		//fixed point scale of layer 2 output
+#elif defined(USE_FIXED_POINT)
 			CNNPP_v3 cnnpp;
+			float fct_l2 = 0.f;		//fixed point scale of layer 2 output
 #else
 			CNNPP_v2 cnnpp;
 #endif
 			
 			int num_threads = 0; //OpenMP only
+			DetectorProfiler* profiler = nullptr;
 
+			//int8 models (format 1.2, setInt8) and topologies without CNNPP_v2 kernels are run by generic network
+			ConvNeuralNetwork* cnn_generic = nullptr;
+			bool int8 = false;
+
+			void InitGeneric(std::string file_name, int index_output, void* hGrd);
 			void ResizeBuffers(const Size size);
+			void Run_L3(const long long pixels);
+			void Run_OL(float* dst, int dst_size_l, int out_id, float* af_scale);
 
 		public:
 			ConvNeuralNetwork_v2() { }
@@ -131,17 +162,63 @@ namespace NeuralNetworksLib
 
 			void Forward(Image_32f& response_map, Image_32f& image);
 
-			inline bool isEmpty() const { return cnn.min_image_size.width == 0 || cnn.min_image_size.height == 0; }
+			//output neurons index_outputs of one image: layers 1-3 and hidden layer run once, output layer per neuron,
+			//response maps share buffer of network until next call, output 0 negated as by Init with index_output 0
+			void ForwardOutputs(std::vector<Image_32f>& response_maps, Image_32f& image, const std::vector<int>& index_outputs);
+			inline int getOutputCount() const { return cnn_generic != nullptr ? cnn_generic->getOutputCount() : cnn.snn_ol_neuron_count; }
 
-			inline Size getMinInputImgSize()   const { return cnn.min_image_size; }
-			inline Size getMaxInputImgSize()   const { return cnn.max_image_size; }
-			inline Size getInputImgSize()	   const { return Size(cnn.input_buffer_size.cols, cnn.input_buffer_size.rows); }
-			inline Size getOutputImgSize()	   const { return Size(cnn.output_buffer_size.cols, cnn.output_buffer_size.rows); }
+			inline bool isEmpty() const
+			{
+				if (cnn_generic != nullptr) return cnn_generic->isEmpty();
+				return cnn.min_image_size.width == 0 || cnn.min_image_size.height == 0;
+			}
+
+			inline Size getMinInputImgSize()   const { return cnn_generic != nullptr ? cnn_generic->getMinInputImgSize() : cnn.min_image_size; }
+			inline Size getMaxInputImgSize()   const { return cnn_generic != nullptr ? cnn_generic->getMaxInputImgSize() : cnn.max_image_size; }
+			inline Size getInputImgSize()	   const { return cnn_generic != nullptr ? cnn_generic->getInputImgSize() : Size(cnn.input_buffer_size.cols, cnn.input_buffer_size.rows); }
+			inline Size getOutputImgSize()	   const { return cnn_generic != nullptr ? cnn_generic->getOutputImgSize() : Size(cnn.output_buffer_size.cols, cnn.output_buffer_size.rows); }
 			Size getOutputImgSize(const Size size);
-			inline float getInputOutputRatio() const { return 4.f; /*(float)cnn.input_buffer_size.rows / (float)cnn.output_buffer_size.rows;*/ }
+			inline float getInputOutputRatio() const { return cnn_generic != nullptr ? cnn_generic->getInputOutputRatio() : 4.f; /*(float)cnn.input_buffer_size.rows / (float)cnn.output_buffer_size.rows;*/ }
 
 			inline int getNumThreads() const { return num_threads; }
-			inline void setNumThreads(int _num_threads) { num_threads = MAX(1, _num_threads); }
+			inline void setNumThreads(int _num_threads)
+			{
+				num_threads = MAX(1, _num_threads);
+				if (cnn_generic != nullptr) cnn_generic->setNumThreads(num_threads);
+			}
+			//int8 conv layers of format 1.2 models (AVX2 builds), opt-in before Init: run by generic network, otherwise CNNPP_v2/v3 kernels run float weights
+			inline void setInt8(bool enabled) { int8 = enabled; }
+			inline bool isQuantized() const { return cnn_generic != nullptr && cnn_generic->isQuantized(); }
+
+			//approximate feature pyramid: pooled layer 2 maps stacked by rows (getFeatureMapsCount maps of getFeatureMapsSize),
+			//layer 2 cell (x, y) is centered at input pixel getFeatureMapsStride() * (x, y) + getFeatureMapsOffset()
+			Size getFeatureMapsSize(const Size size);
+			inline int getFeatureMapsCount() const { return cnn_generic != nullptr ? cnn_generic->getFeatureMapsCount() : cnn.layer_buffer[1].map_count; }
+			inline float getFeatureMapsStride() const { return 4.f; }
+			inline float getFeatureMapsOffset() const
+			{
+				if (cnn_generic != nullptr) return cnn_generic->getFeatureMapsOffset();
+				return 1.5f + 0.5f * float(cnn.conv_l1.size.cols - 1) + float(cnn.conv_l2.size.cols - 1);
+			}
+			//layer 2 maps of last Forward
+			void getFeatureMaps(Image_32f& maps);
+			//layers 3+ of image of given size on layer 2 maps (Forward must be called at least once before)
+			void ForwardFeatureMaps(Image_32f& response_map, Image_32f& maps, const Size size);
+
+			//Winograd F(2x2, 3x3) for 3x3 conv layers of float model, bit l of layers is conv layer l + 1
+			//(only layer 2 is 3x3, fixed point and int8 networks are not affected)
+			void setWinogradLayers(int layers);
+			inline int getWinogradLayers() const { return cnn_generic != nullptr ? cnn_generic->getWinogradLayers() : cnn.winograd_layers; }
+
+			//generated conv kernels of generic network (ConvNeuralNetwork::setTemplateLayers), CNNPP_v2 layers keep their kernels
+			inline void setTemplateLayers(int layers) { if (cnn_generic != nullptr) cnn_generic->setTemplateLayers(layers); }
+			inline int getTemplateLayers() const { return cnn_generic != nullptr ? cnn_generic->getTemplateLayers() : 0; }
+
+			//layer spans of stage 1
+			inline void setProfiler(DetectorProfiler* _profiler) { profiler = _profiler; }
+
+			ConvNeuralNetwork_v2(const ConvNeuralNetwork_v2&) = delete;
+			ConvNeuralNetwork_v2& operator=(const ConvNeuralNetwork_v2&) = delete;
 		};
 	}
 
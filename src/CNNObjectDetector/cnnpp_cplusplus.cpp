@@ -19,6 +19,7 @@
 
 
 #include "cnnpp_cplusplus.h"
+#include "activation_simd.h"
 #include <cmath>
 #include <stdio.h>
 #include <algorithm>
@@ -410,6 +411,8 @@ namespace NeuralNetworksLib
 
 		void CNNPP::tanh_avr_tanh(float* __restrict dst, int dst_size_l, float* __restrict src, int src_size_l, int src_size_h, float* __restrict conv_b, float* __restrict subs_w, float* __restrict subs_b, float* __restrict scale)
 		{
+			const Activation::tanh_tier tanh_f;
+
 			int  j2 = 0;
 			for (size_t j = 0; j < src_size_h; j += 2)
 			{
@@ -420,50 +423,19 @@ namespace NeuralNetworksLib
 				for (size_t i = 0; i < src_size_l; i += 2)
 				{
 					float c1 = *(pSrc0++) + *conv_b;
-#ifdef USE_FAST_TANH				
-					float sgn = 1.f;
-					if (c1 < 0.f) sgn = -1.f;
-					//(int&)sgn |= ((int&)c1&  0x80000000);
-					c1 = sgn * (1.f - 1.f / (1.f + fabsf(c1) + c1 * c1 + tanh_a * c1 * c1 * c1 * c1));
-#else
-					c1 = tanhf(c1);
-#endif
+					c1 = tanh_f(c1);
 
 					float c2 = *(pSrc0++) + *conv_b;
-#ifdef USE_FAST_TANH
-					sgn = 1.f;
-					if (c2 < 0.f) sgn = -1.f;
-					c2 = sgn * (1.f - 1.f / (1.f + fabsf(c2) + c2 * c2 + tanh_a * c2 * c2 * c2 * c2));
-#else
-					c2 = tanhf(c2);
-#endif
+					c2 = tanh_f(c2);
 
 					float c3 = *(pSrc1++) + *conv_b;
-#ifdef USE_FAST_TANH
-					sgn = 1.f;
-					if (c3 < 0.f) sgn = -1.f;
-					c3 = sgn * (1.f - 1.f / (1.f + fabsf(c3) + c3 * c3 + tanh_a * c3 * c3 * c3 * c3));
-#else
-					c3 = tanhf(c3);
-#endif
+					c3 = tanh_f(c3);
 
 					float c4 = *(pSrc1++) + *conv_b;
-#ifdef USE_FAST_TANH
-					sgn = 1.f;
-					if (c4 < 0.f) sgn = -1.f;
-					c4 = sgn * (1.f - 1.f / (1.f + fabsf(c4) + c4 * c4 + tanh_a * c4 * c4 * c4 * c4));
-#else
-					c4 = tanhf(c4);
-#endif
+					c4 = tanh_f(c4);
 
 					float avr = *subs_w * (c1 + c2 + c3 + c4) + *subs_b;
-#ifdef USE_FAST_TANH			
-					sgn = 1.f;
-					if (avr < 0.f) sgn = -1.f;
-					avr = sgn * (1.f - 1.f / (1.f + fabsf(avr) + avr * avr + tanh_a * avr * avr * avr * avr));
-#else
-					avr = tanhf(avr);
-#endif
+					avr = tanh_f(avr);
 
 					*(pDst++) = *scale * avr;
 				}
@@ -472,6 +444,8 @@ namespace NeuralNetworksLib
 		}
 		void CNNPP::max_tanh_tanh(float* __restrict dst, int dst_size_l, float* __restrict src, int src_size_l, int src_size_h, float* __restrict conv_b, float* __restrict subs_w, float* __restrict subs_b, float* __restrict scale)
 		{
+			const Activation::tanh_tier tanh_f;
+
 			int  j2 = 0;
 			for (size_t j = 0; j < src_size_h; j += 2)
 			{
@@ -482,50 +456,19 @@ namespace NeuralNetworksLib
 				for (size_t i = 0; i < src_size_l; i += 2)
 				{
 					float c1 = *(pSrc0++) + *conv_b;
-#ifdef USE_FAST_TANH				
-					float sgn = 1.f;
-					if (c1 < 0.f) sgn = -1.f;
-					//(int&)sgn |= ((int&)c1 & 0x80000000);
-					c1 = sgn * (1.f - 1.f / (1.f + fabsf(c1) + c1 * c1 + tanh_a * c1 * c1 * c1 * c1));
-#else
-					c1 = tanhf(c1);
-#endif
+					c1 = tanh_f(c1);
 
 					float c2 = *(pSrc0++) + *conv_b;
-#ifdef USE_FAST_TANH
-					sgn = 1.f;
-					if (c2 < 0.f) sgn = -1.f;
-					c2 = sgn * (1.f - 1.f / (1.f + fabsf(c2) + c2 * c2 + tanh_a * c2 * c2 * c2 * c2));
-#else
-					c2 = tanhf(c2);
-#endif
+					c2 = tanh_f(c2);
 
 					float c3 = *(pSrc1++) + *conv_b;
-#ifdef USE_FAST_TANH
-					sgn = 1.f;
-					if (c3 < 0.f) sgn = -1.f;
-					c3 = sgn * (1.f - 1.f / (1.f + fabsf(c3) + c3 * c3 + tanh_a * c3 * c3 * c3 * c3));
-#else
-					c3 = tanhf(c3);
-#endif
+					c3 = tanh_f(c3);
 
 					float c4 = *(pSrc1++) + *conv_b;
-#ifdef USE_FAST_TANH
-					sgn = 1.f;
-					if (c4 < 0.f) sgn = -1.f;
-					c4 = sgn * (1.f - 1.f / (1.f + fabsf(c4) + c4 * c4 + tanh_a * c4 * c4 * c4 * c4));
-#else
-					c4 = tanhf(c4);
-#endif
+					c4 = tanh_f(c4);
 
 					float avr = *subs_w * fmaxf(fmaxf(c1, c2), fmaxf(c3, c4)) + *subs_b;
-#ifdef USE_FAST_TANH			
-					sgn = 1.f;
-					if (avr < 0.f) sgn = -1.f;
-					avr = sgn * (1.f - 1.f / (1.f + fabsf(avr) + avr * avr + tanh_a * avr * avr * avr * avr));
-#else
-					avr = tanhf(avr);
-#endif
+					avr = tanh_f(avr);
 
 					*(pDst++) = *scale * avr;
 				}
@@ -534,6 +477,8 @@ namespace NeuralNetworksLib
 		}
 		void CNNPP::max_tanh_bn(float* __restrict dst, int dst_size_l, float* __restrict src, int src_size_l, int src_size_h, float* __restrict conv_b, float* __restrict bn_w, float* __restrict bn_b, float* __restrict scale)
 		{
+			const Activation::tanh_tier tanh_f;
+
 			int  j2 = 0;
 			for (size_t j = 0; j < src_size_h; j += 2)
 			{
@@ -544,40 +489,16 @@ namespace NeuralNetworksLib
 				for (size_t i = 0; i < src_size_l; i += 2)
 				{
 					float c1 = *(pSrc0++) + *conv_b;
-#ifdef USE_FAST_TANH				
-					float sgn = 1.f;
-					if (c1 < 0.f) sgn = -1.f;
-					c1 = sgn * (1.f - 1.f / (1.f + fabsf(c1) + c1 * c1 + tanh_a * c1 * c1 * c1 * c1));
-#else
-					c1 = tanhf(c1);
-#endif
+					c1 = tanh_f(c1);
 
 					float c2 = *(pSrc0++) + *conv_b;
-#ifdef USE_FAST_TANH
-					sgn = 1.f;
-					if (c2 < 0.f) sgn = -1.f;
-					c2 = sgn * (1.f - 1.f / (1.f + fabsf(c2) + c2 * c2 + tanh_a * c2 * c2 * c2 * c2));
-#else
-					c2 = tanhf(c2);
-#endif
+					c2 = tanh_f(c2);
 
 					float c3 = *(pSrc1++) + *conv_b;
-#ifdef USE_FAST_TANH
-					sgn = 1.f;
-					if (c3 < 0.f) sgn = -1.f;
-					c3 = sgn * (1.f - 1.f / (1.f + fabsf(c3) + c3 * c3 + tanh_a * c3 * c3 * c3 * c3));
-#else
-					c3 = tanhf(c3);
-#endif
+					c3 = tanh_f(c3);
 
 					float c4 = *(pSrc1++) + *conv_b;
-#ifdef USE_FAST_TANH
-					sgn = 1.f;
-					if (c4 < 0.f) sgn = -1.f;
-					c4 = sgn * (1.f - 1.f / (1.f + fabsf(c4) + c4 * c4 + tanh_a * c4 * c4 * c4 * c4));
-#else
-					c4 = tanhf(c4);
-#endif
+					c4 = tanh_f(c4);
 
 					float avr = fmaxf(fmaxf(c1, c2), fmaxf(c3, c4));
 					//avr = (*scale * avr -* bn_m) / sqrtf(*bn_v);
@@ -643,8 +564,26 @@ namespace NeuralNetworksLib
 				*(pDst++) = c4;
 			}
 		}
+		void CNNPP::lrelu_bn(float* __restrict dst, int size_, float* __restrict conv_b, float* __restrict lrelu_w1, float* __restrict lrelu_w2, float* __restrict bn_w, float* __restrict bn_b)
+		{
+			float* __restrict pDst = dst;
+			for (size_t i = 0; i < size_; i += 4)
+			{
+				float c1 = pDst[0] + *conv_b;
+				float c2 = pDst[1] + *conv_b;
+				float c3 = pDst[2] + *conv_b;
+				float c4 = pDst[3] + *conv_b;
+
+				*(pDst++) = *lrelu_w1 * c1 + *lrelu_w2 * fmaxf(0.f, c1) + *bn_b;
+				*(pDst++) = *lrelu_w1 * c2 + *lrelu_w2 * fmaxf(0.f, c2) + *bn_b;
+				*(pDst++) = *lrelu_w1 * c3 + *lrelu_w2 * fmaxf(0.f, c3) + *bn_b;
+				*(pDst++) = *lrelu_w1 * c4 + *lrelu_w2 * fmaxf(0.f, c4) + *bn_b;
+			}
+		}
 		void CNNPP::mulCN_add_tanhW(int N, float* __restrict dst, float** __restrict src_N, int size_, float* __restrict hl_w_N, float* __restrict hl_b, float* __restrict tanh_w, float* __restrict bn_w, float* __restrict bn_b)
 		{
+			const Activation::tanh_tier tanh_f;
+
 			float** __restrict pSrc = new float*[N];
 			for (size_t j = 0; j < N; ++j)
 			{
@@ -660,9 +599,7 @@ namespace NeuralNetworksLib
 				}
 
 				c1 *= *tanh_w;
-				float sgn = 1.f;
-				if (c1 < 0.f) sgn = -1.f;
-				c1 = sgn * (1.f - 1.f / (1.f + fabsf(c1) + c1 * c1 + tanh_a * c1 * c1 * c1 * c1));
+				c1 = tanh_f(c1);
 				c1 = 0.5f * c1 + 0.5f;
 
 				*(pDst++) = *bn_w * c1 + *bn_b;
@@ -672,15 +609,15 @@ namespace NeuralNetworksLib
 		}
 		void CNNPP::tanhW(float* dst, float* src, int size_, float* __restrict snn_ol_b, float* __restrict tanh_w, float* __restrict scale)
 		{
+			const Activation::tanh_tier tanh_f;
+
 			float* pSrc = src;
 			float* pDst = dst;
 			for (size_t i = 0; i < size_; ++i)
 			{
 				float c1 = *(pSrc++) + *snn_ol_b;
 				c1 *= *tanh_w;
-				float sgn = 1.f;
-				if (c1 < 0.f) sgn = -1.f;
-				c1 = sgn * (1.f - 1.f / (1.f + fabsf(c1) + c1 * c1 + tanh_a * c1 * c1 * c1 * c1));
+				c1 = tanh_f(c1);
 				
 				if (*scale == 0.f)
 					*(pDst++) = 0.5f * c1 + 0.5f;
@@ -691,85 +628,47 @@ namespace NeuralNetworksLib
 
 		void CNNPP::tanh_tanh_2tanh(float* __restrict dst, float* __restrict src, int size_, float* __restrict conv_b, float* __restrict subs_w, float* __restrict subs_b, float* __restrict scale, float* __restrict snn_hl_w0, float* __restrict snn_hl_b0, float* __restrict snn_hl_w1, float* __restrict snn_hl_b1, float* __restrict snn_ol_w0, float* __restrict snn_ol_w1)
 		{
+			const Activation::tanh_tier tanh_f;
+
 			float* __restrict pSrc = src;
 			float* __restrict pDst = dst;
 			for (size_t i = 0; i < size_; ++i)
 			{
 				float c = *(pSrc++) + *conv_b;
-#ifdef USE_FAST_TANH			
-				float sgn = 1.f;
-				if (c < 0.f) sgn = -1.f;
-				c = sgn * (1.f - 1.f / (1.f + fabsf(c) + c * c + tanh_a * c * c * c * c));
-#else
-				c = tanhf(c);
-#endif
+				c = tanh_f(c);
 
 				c = *subs_w * c + *subs_b;
-#ifdef USE_FAST_TANH
-				sgn = 1.f;
-				if (c < 0.f) sgn = -1.f;
-				c = sgn * (1.f - 1.f / (1.f + fabsf(c) + c * c + tanh_a * c * c * c * c));
-#else
-				c = tanhf(c);
-#endif
+				c = tanh_f(c);
 
 				float c_1 = *scale * *snn_hl_w0 * c + *snn_hl_b0;
-#ifdef USE_FAST_TANH
-				sgn = 1.f;
-				if (c_1 < 0.f) sgn = -1.f;
-				c_1 = sgn * (1.f - 1.f / (1.f + fabsf(c_1) + c_1 * c_1 + tanh_a * c_1 * c_1 * c_1 * c_1));
-#else
-				c_1 = tanhf(c_1);
-#endif
+				c_1 = tanh_f(c_1);
 
 				float c_2 = *scale * *snn_hl_w1 * c + *snn_hl_b1;
-#ifdef USE_FAST_TANH
-				sgn = 1.f;
-				if (c_2 < 0.f) sgn = -1.f;
-				c_2 = sgn * (1.f - 1.f / (1.f + fabsf(c_2) + c_2 * c_2 + tanh_a * c_2 * c_2 * c_2 * c_2));
-#else
-				c_2 = tanhf(c_2);
-#endif
+				c_2 = tanh_f(c_2);
 
 				*(pDst++) = *scale * (*snn_ol_w0 * c_1 + *snn_ol_w1 * c_2);
 			}
 		}
 		void CNNPP::tanh_bn_2tanh(float* __restrict dst, float* __restrict src, int size_, float* __restrict conv_b, float* __restrict bn_w, float* __restrict bn_b, float* __restrict scale, float* __restrict snn_hl_w0, float* __restrict snn_hl_b0, float* __restrict snn_hl_w1, float* __restrict snn_hl_b1, float* __restrict snn_ol_w0, float* __restrict snn_ol_w1)
 		{
+			const Activation::tanh_tier tanh_f;
+
 			float* __restrict pSrc = src;
 			float* __restrict pDst = dst;
 			for (size_t i = 0; i < size_; ++i)
 			{
 				float c = *(pSrc++) + *conv_b;
-#ifdef USE_FAST_TANH			
-				float sgn = 1.f;
-				if (c < 0.f) sgn = -1.f;
-				c = sgn * (1.f - 1.f / (1.f + fabsf(c) + c * c + tanh_a * c * c * c * c));
-#else
-				c = tanhf(c);
-#endif
+				c = tanh_f(c);
 
 				//c = (*scale * c -* bn_m) / sqrtf(*bn_v);
 				//c = *bn_s * c + *bn_b;
 				c = *bn_w * c + *bn_b;
 
 				float c_1 = *snn_hl_w0 * c + *snn_hl_b0;
-#ifdef USE_FAST_TANH
-				sgn = 1.f;
-				if (c_1 < 0.f) sgn = -1.f;
-				c_1 = sgn * (1.f - 1.f / (1.f + fabsf(c_1) + c_1 * c_1 + tanh_a * c_1 * c_1 * c_1 * c_1));
-#else
-				c_1 = tanhf(c_1);
-#endif
+				c_1 = tanh_f(c_1);
 
 				float c_2 = * snn_hl_w1 * c + *snn_hl_b1;
-#ifdef USE_FAST_TANH
-				sgn = 1.f;
-				if (c_2 < 0.f) sgn = -1.f;
-				c_2 = sgn * (1.f - 1.f / (1.f + fabsf(c_2) + c_2 * c_2 + tanh_a * c_2 * c_2 * c_2 * c_2));
-#else
-				c_2 = tanhf(c_2);
-#endif
+				c_2 = tanh_f(c_2);
 
 				*(pDst++) = *scale * (*snn_ol_w0 * c_1 + *snn_ol_w1 * c_2);
 			}
@@ -777,138 +676,70 @@ namespace NeuralNetworksLib
 
 		void CNNPP::tanh_tanh(float* __restrict dst, float* __restrict src, int size_, float* __restrict conv_b, float* __restrict subs_w, float* __restrict subs_b, float* __restrict scale)
 		{
+			const Activation::tanh_tier tanh_f;
+
 			float* __restrict pSrc = src;
 			float* __restrict pDst = dst;
 			for (size_t i = 0; i < size_; i += 4)
 			{
 				float c1 = *(pSrc++) + *conv_b;
-#ifdef USE_FAST_TANH
-				float sgn = 1.f;
-				if (c1 < 0.f) sgn = -1.f;
-				c1 = sgn * (1.f - 1.f / (1.f + fabsf(c1) + c1 * c1 + tanh_a * c1 * c1 * c1 * c1));
-#else
-				c1 = tanhf(c1);
-#endif
+				c1 = tanh_f(c1);
 
 				c1 = *subs_w * c1 + *subs_b;
-#ifdef USE_FAST_TANH
-				sgn = 1.f;
-				if (c1 < 0.f) sgn = -1.f;
-				c1 = sgn * (1.f - 1.f / (1.f + fabsf(c1) + c1 * c1 + tanh_a * c1 * c1 * c1 * c1));
-#else
-				c1 = tanhf(c1);
-#endif
+				c1 = tanh_f(c1);
 
 				*(pDst++) = *scale * c1;
 
 
 				float c2 = *(pSrc++) + *conv_b;
-#ifdef USE_FAST_TANH
-				sgn = 1.f;
-				if (c2 < 0.f) sgn = -1.f;
-				c2 = sgn * (1.f - 1.f / (1.f + fabsf(c2) + c2 * c2 + tanh_a * c2 * c2 * c2 * c2));
-#else
-				c2 = tanhf(c2);
-#endif
+				c2 = tanh_f(c2);
 
 				c2 = *subs_w * c2 + *subs_b;
-#ifdef USE_FAST_TANH
-				sgn = 1.f;
-				if (c2 < 0.f) sgn = -1.f;
-				c2 = sgn * (1.f - 1.f / (1.f + fabsf(c2) + c2 * c2 + tanh_a * c2 * c2 * c2 * c2));
-#else
-				c2 = tanhf(c2);
-#endif
+				c2 = tanh_f(c2);
 
 				*(pDst++) = *scale * c2;
 
 
 				float c3 = *(pSrc++) + *conv_b;
-#ifdef USE_FAST_TANH
-				sgn = 1.f;
-				if (c3 < 0.f) sgn = -1.f;
-				c3 = sgn * (1.f - 1.f / (1.f + fabsf(c3) + c3 * c3 + tanh_a * c3 * c3 * c3 * c3));
-#else
-				c3 = tanhf(c3);
-#endif
+				c3 = tanh_f(c3);
 
 				c3 = *subs_w * c3 + *subs_b;
-#ifdef USE_FAST_TANH
-				sgn = 1.f;
-				if (c3 < 0.f) sgn = -1.f;
-				c3 = sgn * (1.f - 1.f / (1.f + fabsf(c3) + c3 * c3 + tanh_a * c3 * c3 * c3 * c3));
-#else
-				c3 = tanhf(c3);
-#endif
+				c3 = tanh_f(c3);
 
 				*(pDst++) = *scale * c3;
 
 
 				float c4 = *(pSrc++) + *conv_b;
-#ifdef USE_FAST_TANH
-				sgn = 1.f;
-				if (c4 < 0.f) sgn = -1.f;
-				c4 = sgn * (1.f - 1.f / (1.f + fabsf(c4) + c4 * c4 + tanh_a * c4 * c4 * c4 * c4));
-#else
-				c4 = tanhf(c4);
-#endif
+				c4 = tanh_f(c4);
 
 				c4 = *subs_w * c4 + *subs_b;
-#ifdef USE_FAST_TANH
-				sgn = 1.f;
-				if (c4 < 0.f) sgn = -1.f;
-				c4 = sgn * (1.f - 1.f / (1.f + fabsf(c4) + c4 * c4 + tanh_a * c4 * c4 * c4 * c4));
-#else
-				c4 = tanhf(c4);
-#endif
+				c4 = tanh_f(c4);
 
 				*(pDst++) = *scale * c4;
 			}
 		}
 		void CNNPP::tanh(float* __restrict dst, float* __restrict src, int size_, float* __restrict snn_ol_b, float* __restrict scale)
 		{
+			const Activation::tanh_tier tanh_f;
+
 			float* __restrict pSrc = src;
 			float* __restrict pDst = dst;
 			for (size_t i = 0; i < size_; i += 4)
 			{
 				float c1 = *(pSrc++) + *snn_ol_b;
-#ifdef USE_FAST_TANH
-				float sgn = 1.f;
-				if (c1 < 0.f) sgn = -1.f;
-				c1 = sgn * (1.f - 1.f / (1.f + fabsf(c1) + c1 * c1 + tanh_a * c1 * c1 * c1 * c1));
-#else
-				c1 = tanhf(c1);
-#endif
+				c1 = tanh_f(c1);
 				*(pDst++) = *scale * c1;
 
 				float c2 = *(pSrc++) + *snn_ol_b;
-#ifdef USE_FAST_TANH
-				sgn = 1.f;
-				if (c2 < 0.f) sgn = -1.f;
-				c2 = sgn * (1.f - 1.f / (1.f + fabsf(c2) + c2 * c2 + tanh_a * c2 * c2 * c2 * c2));
-#else
-				c2 = tanhf(c2);
-#endif		
+				c2 = tanh_f(c2);
 				*(pDst++) = *scale * c2;
 
 				float c3 = *(pSrc++) + *snn_ol_b;
-#ifdef USE_FAST_TANH
-				sgn = 1.f;
-				if (c3 < 0.f) sgn = -1.f;
-				c3 = sgn * (1.f - 1.f / (1.f + fabsf(c3) + c3 * c3 + tanh_a * c3 * c3 * c3 * c3));
-#else
-				c3 = tanhf(c3);
-#endif	
+				c3 = tanh_f(c3);
 				*(pDst++) = *scale * c3;
 
 				float c4 = *(pSrc++) + *snn_ol_b;
-#ifdef USE_FAST_TANH
-				sgn = 1.f;
-				if (c4 < 0.f) sgn = -1.f;
-				c4 = sgn * (1.f - 1.f / (1.f + fabsf(c4) + c4 * c4 + tanh_a * c4 * c4 * c4 * c4));
-#else
-				c4 = tanhf(c4);
-#endif
+				c4 = tanh_f(c4);
 				*(pDst++) = *scale * c4;
 			}
 		}
@@ -982,6 +813,22 @@ namespace NeuralNetworksLib
 				*(pDst++) = *(pSrc1_mulC++) * *snn_hl_w + *(pSrc2++);
 			}
 		}
+		void CNNPP::mulC1_add(float* __restrict dst, float* __restrict src_mulC, int size_, float* __restrict snn_hl_w)
+		{
+			float* __restrict pSrc_mulC = src_mulC;
+			float* __restrict pDst = dst;
+			for (size_t i = 0; i < size_; i += 8)
+			{
+				*(pDst++) += *(pSrc_mulC++) * *snn_hl_w;
+				*(pDst++) += *(pSrc_mulC++) * *snn_hl_w;
+				*(pDst++) += *(pSrc_mulC++) * *snn_hl_w;
+				*(pDst++) += *(pSrc_mulC++) * *snn_hl_w;
+				*(pDst++) += *(pSrc_mulC++) * *snn_hl_w;
+				*(pDst++) += *(pSrc_mulC++) * *snn_hl_w;
+				*(pDst++) += *(pSrc_mulC++) * *snn_hl_w;
+				*(pDst++) += *(pSrc_mulC++) * *snn_hl_w;
+			}
+		}
 		void CNNPP::mulC2_add(float* __restrict dst, float* __restrict src1_mulC0, float* __restrict src2_mulC1, int size_, float* __restrict snn_hl_w0, float* __restrict snn_hl_w1)
 		{
 			float* __restrict pSrc1_mulC0 = src1_mulC0;
@@ -1002,6 +849,8 @@ namespace NeuralNetworksLib
 
 		void CNNPP::mulC24_add_tanh(float* __restrict dst, float* __restrict* src, int size_, float* __restrict snn_hl_w, float* __restrict snn_hl_b, float* __restrict scale, float* __restrict snn_ol_w)
 		{
+			const Activation::tanh_tier tanh_f;
+
 			float* __restrict pDst = dst;
 			for (size_t i = 0; i < size_; ++i)
 			{
@@ -1031,17 +880,182 @@ namespace NeuralNetworksLib
 					+ src[22][i] * *(snn_hl_w + 22)
 					+ src[23][i] * *(snn_hl_w + 23);
 
-#ifdef USE_FAST_TANH
-				float sgn = 1.f;
-				if (c < 0.f) sgn = -1.f;
-				c = sgn * (1.f - 1.f / (1.f + fabsf(c) + c * c + tanh_a * c * c * c * c));
-#else
-				c = tanhf(c);
-#endif
+				c = tanh_f(c);
 
 				*(pDst++) = *scale * c * *snn_ol_w;
 			}
 		}
+
+		//Winograd F(2x2, 3x3) of one tile: input transform B^T d B of 4x4 pixels of rows src[0..3],
+		//product with transformed kernel and output transform A^T m A, y = outputs (0, 0), (0, 1), (1, 0), (1, 1) of tile
+		static inline void wino_3x3(float* __restrict y, const float* const* __restrict src, const float* __restrict kernel)
+		{
+			float h[4][4];
+			for (int r = 0; r < 4; ++r)
+			{
+				const float* __restrict pSrc = src[r];
+				h[r][0] = pSrc[0] - pSrc[2];
+				h[r][1] = pSrc[1] + pSrc[2];
+				h[r][2] = pSrc[2] - pSrc[1];
+				h[r][3] = pSrc[1] - pSrc[3];
+			}
+
+			float t0[4];
+			float t1[4];
+			for (int c = 0; c < 4; ++c)
+			{
+				const float m0 = (h[0][c] - h[2][c]) * kernel[c];
+				const float m1 = (h[1][c] + h[2][c]) * kernel[4 + c];
+				const float m2 = (h[2][c] - h[1][c]) * kernel[8 + c];
+				const float m3 = (h[1][c] - h[3][c]) * kernel[12 + c];
+
+				t0[c] = m0 + m1 + m2;
+				t1[c] = m1 - m2 - m3;
+			}
+
+			y[0] = t0[0] + t0[1] + t0[2];
+			y[1] = t0[1] - t0[2] - t0[3];
+			y[2] = t1[0] + t1[1] + t1[2];
+			y[3] = t1[1] - t1[2] - t1[3];
+		}
+
+		void CNNPP::conv_3x3_wino(float* __restrict dst, int dst_size_l, float* __restrict src, int src_size_l, int src_size_h, float* __restrict kernel, size_t L, size_t H)
+		{
+			if (L == 0) L = src_size_l - 2;
+			if (H == 0) H = src_size_h - 2;
+
+			for (size_t j = 0; j < H; j += 2)
+			{
+				//last row of odd H: second output row of tiles is not stored
+				const float* pSrc[4] = {
+					src + j * src_size_l,
+					src + (j + 1) * src_size_l,
+					src + (j + 2) * src_size_l,
+					src + (j + 3 < (size_t)src_size_h ? j + 3 : j + 2) * src_size_l };
+
+				float* __restrict pDst0 = dst + j * dst_size_l;
+				float* __restrict pDst1 = pDst0 + dst_size_l;
+
+				for (size_t i = 0; i < L; i += 2)
+				{
+					float y[4];
+					if (i + 4 <= (size_t)src_size_l)
+					{
+						const float* pSrc_i[4] = { pSrc[0] + i, pSrc[1] + i, pSrc[2] + i, pSrc[3] + i };
+						wino_3x3(y, pSrc_i, kernel);
+					}
+					else
+					{
+						float buf[4][4];
+						const float* pBuf[4] = { buf[0], buf[1], buf[2], buf[3] };
+						for (int r = 0; r < 4; ++r)
+						{
+							for (size_t k = 0; k < 4; ++k)
+							{
+								buf[r][k] = i + k < (size_t)src_size_l ? pSrc[r][i + k] : 0.f;
+							}
+						}
+						wino_3x3(y, pBuf, kernel);
+					}
+
+					pDst0[i] = y[0];
+					if (i + 1 < L) pDst0[i + 1] = y[1];
+
+					if (j + 1 < H)
+					{
+						pDst1[i] = y[2];
+						if (i + 1 < L) pDst1[i + 1] = y[3];
+					}
+				}
+			}
+		}
+		void CNNPP::conv_3x3_lrelu_bn_max_wino(float* __restrict dst, int dst_size_l, float* __restrict src, int src_size_l, int src_size_h, float* __restrict kernel, float* __restrict conv_b, float* __restrict lrelu_w1, float* __restrict lrelu_w2, float* __restrict bn_w, float* __restrict bn_b, size_t L, size_t H)
+		{
+			if (L == 0) L = src_size_l - 2;
+			if (H == 0) H = src_size_h - 2;
+
+			//tile 2x2 of conv is max pool window
+			for (size_t j = 0; j < (H >> 1); ++j)
+			{
+				const float* pSrc[4] = {
+					src + (2 * j) * src_size_l,
+					src + (2 * j + 1) * src_size_l,
+					src + (2 * j + 2) * src_size_l,
+					src + (2 * j + 3) * src_size_l };
+
+				float* __restrict pDst = dst + j * dst_size_l;
+
+				for (size_t i = 0; i < (L >> 1); ++i)
+				{
+					const float* pSrc_i[4] = { pSrc[0] + 2 * i, pSrc[1] + 2 * i, pSrc[2] + 2 * i, pSrc[3] + 2 * i };
+
+					float y[4];
+					wino_3x3(y, pSrc_i, kernel);
+
+					for (int k = 0; k < 4; ++k)
+					{
+						const float c = y[k] + *conv_b;
+						y[k] = *lrelu_w1 * c + *lrelu_w2 * fmaxf(0.f, c) + *bn_b;
+					}
+
+					pDst[i] = fmaxf(fmaxf(y[0], y[1]), fmaxf(y[2], y[3]));
+				}
+			}
+		}
+
+		void CNNPP::gemm(float* __restrict dst, int dst_size_l, float* __restrict src, int src_size_l, float* __restrict kernel, int M, int K, int N)
+		{
+			//4 rows of dst share every row of src
+			int m = 0;
+			for (; m + 4 <= M; m += 4)
+			{
+				float* __restrict pDst0 = dst + m * dst_size_l;
+				float* __restrict pDst1 = pDst0 + dst_size_l;
+				float* __restrict pDst2 = pDst1 + dst_size_l;
+				float* __restrict pDst3 = pDst2 + dst_size_l;
+				for (int n = 0; n < N; ++n)
+				{
+					pDst0[n] = pDst1[n] = pDst2[n] = pDst3[n] = 0.f;
+				}
+
+				const float* __restrict pKernel = kernel + m * K;
+				for (int k = 0; k < K; ++k)
+				{
+					const float* __restrict pSrc = src + k * src_size_l;
+					const float a0 = pKernel[k];
+					const float a1 = pKernel[K + k];
+					const float a2 = pKernel[2 * K + k];
+					const float a3 = pKernel[3 * K + k];
+					for (int n = 0; n < N; ++n)
+					{
+						const float b = pSrc[n];
+						pDst0[n] += a0 * b;
+						pDst1[n] += a1 * b;
+						pDst2[n] += a2 * b;
+						pDst3[n] += a3 * b;
+					}
+				}
+			}
+
+			for (; m < M; ++m)
+			{
+				float* __restrict pDst = dst + m * dst_size_l;
+				for (int n = 0; n < N; ++n)
+				{
+					pDst[n] = 0.f;
+				}
+
+				for (int k = 0; k < K; ++k)
+				{
+					const float* __restrict pSrc = src + k * src_size_l;
+					const float a = kernel[m * K + k];
+					for (int n = 0; n < N; ++n)
+					{
+						pDst[n] += a * pSrc[n];
+					}
+				}
+			}
+		}
 	}
 
 #endif
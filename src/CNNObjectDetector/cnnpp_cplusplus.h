@@ -21,6 +21,7 @@
 #pragma once
 
 #include "config.h"
+#include <cstddef>
 
 
 //========================================================================================================
@@ -34,9 +35,6 @@ namespace NeuralNetworksLib
 	{
 		class CNNPP
 		{
-		private:
-			const float tanh_a = 1.41645f;
-
 		public:
 			CNNPP() { }
 			~CNNPP() { }
@@ -59,6 +57,7 @@ namespace NeuralNetworksLib
 
 			void lrelu_bn_max(float* __restrict dst, int dst_size_l, float* __restrict src, int src_size_l, int src_size_h, float* __restrict conv_b, float* __restrict lrelu_w1, float* __restrict lrelu_w2, float* __restrict bn_w, float* __restrict bn_b);
 			void lrelu_bn(float* __restrict dst, float* __restrict src, int size_, float* __restrict conv_b, float* __restrict lrelu_w1, float* __restrict lrelu_w2, float* __restrict bn_w, float* __restrict bn_b);
+			void lrelu_bn(float* __restrict dst, int size_, float* __restrict conv_b, float* __restrict lrelu_w1, float* __restrict lrelu_w2, float* __restrict bn_w, float* __restrict bn_b);	//in place
 			void mulCN_add_tanhW(int N, float* __restrict dst, float** __restrict src_N, int size_, float* __restrict hl_w_N, float* __restrict hl_b, float* __restrict tanh_w, float* __restrict bn_w, float* __restrict bn_b);
 			void tanhW(float* dst, float* src, int size_, float* __restrict snn_ol_b, float* __restrict tanh_w, float* __restrict scale);
 
@@ -72,10 +71,19 @@ namespace NeuralNetworksLib
 
 			void mulC(float* dst, float* src_mulC, int size_, float* __restrict snn_ol_w);
 			void mulC1_add(float* dst, float* src1_mulC, float* src2, int size_, float* __restrict snn_hl_w);
+			void mulC1_add(float* __restrict dst, float* __restrict src_mulC, int size_, float* __restrict snn_hl_w);	//dst += src_mulC * snn_hl_w
 			void mulC2_add(float* __restrict dst, float* __restrict src1_mulC0, float* __restrict src2_mulC1, int size_, float* __restrict snn_hl_w0, float* __restrict snn_hl_w1);
 
 			void mulC24_add_tanh(float* __restrict dst, float* __restrict* src, int size_, float* __restrict snn_hl_w, float* __restrict snn_hl_b, float* __restrict scale, float* __restrict snn_ol_w);
 
+			//Winograd F(2x2, 3x3) conv layers, kernel is 4x4 transformed kernel G g G^T (ConvNeuralNetwork::WinogradKernel3x3),
+			//conv_3x3_lrelu_bn_max_wino writes pooled maps: 2x2 output tile of conv is max pool window, (L / 2) x (H / 2) tiles
+			void conv_3x3_wino(float* __restrict dst, int dst_size_l, float* __restrict src, int src_size_l, int src_size_h, float* __restrict kernel, size_t L = 0, size_t H = 0);
+			void conv_3x3_lrelu_bn_max_wino(float* __restrict dst, int dst_size_l, float* __restrict src, int src_size_l, int src_size_h, float* __restrict kernel, float* __restrict conv_b, float* __restrict lrelu_w1, float* __restrict lrelu_w2, float* __restrict bn_w, float* __restrict bn_b, size_t L = 0, size_t H = 0);
+
+			//im2col conv layers of LayerGraph: dst[M x N] = kernel[M x K] * src[K x N], rows of src and dst are aligned and padded to 4 * REG_SIZE columns
+			void gemm(float* __restrict dst, int dst_size_l, float* __restrict src, int src_size_l, float* __restrict kernel, int M, int K, int N);
+
 			CNNPP(const CNNPP&) = delete;
 			CNNPP& operator=(const CNNPP&) = delete;
 		};
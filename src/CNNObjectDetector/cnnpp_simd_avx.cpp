@@ -19,7 +19,10 @@
 
 
 #include "cnnpp_simd_avx.h"
+#include "activation_simd.h"
 #include <immintrin.h>
+#include <cmath>
+#include <algorithm>
 
 
 //========================================================================================================
@@ -1998,6 +2001,35 @@ namespace NeuralNetworksLib
 			}
 
 		}
+		void CNNPP::lrelu_bn(float* __restrict dst, int size_, float* __restrict conv_b, float* __restrict lrelu_w1, float* __restrict lrelu_w2, float* __restrict bn_w, float* __restrict bn_b)
+		{
+			const __m256 ymm1 = _mm256_broadcast_ss(conv_b);
+			const __m256 ymm4 = _mm256_broadcast_ss(lrelu_w1);
+			const __m256 ymm5 = _mm256_broadcast_ss(lrelu_w2);
+			const __m256 ymm2 = _mm256_broadcast_ss(bn_b);
+			const __m256 ymm0 = _mm256_setzero_ps();
+
+			for (size_t i = 0; i < size_; i += REG_SIZE)
+			{
+				__m256 ymm3 = _mm256_load_ps(dst + i);
+
+				ymm3 = _mm256_add_ps(ymm3, ymm1);
+				__m256 ymm7 = _mm256_max_ps(ymm3, ymm0);
+
+#ifdef USE_FMA
+				ymm3 = _mm256_fmadd_ps(ymm3, ymm4, ymm2);
+				ymm3 = _mm256_fmadd_ps(ymm7, ymm5, ymm3);
+#else
+				ymm3 = _mm256_mul_ps(ymm3, ymm4);
+				ymm7 = _mm256_mul_ps(ymm7, ymm5);
+
+				ymm3 = _mm256_add_ps(ymm3, ymm7);
+				ymm3 = _mm256_add_ps(ymm3, ymm2);
+#endif
+
+				_mm256_store_ps(dst + i, ymm3);
+			}
+		}
 		void CNNPP::mulCN_add_tanhW(int N, float* __restrict dst, float** __restrict src_N, int size_, float* __restrict hl_w_N, float* __restrict hl_b, float* __restrict tanh_w, float* __restrict bn_w, float* __restrict bn_b)
 		{
 			//float** __restrict pSrc = new float*[N];
@@ -2026,9 +2058,7 @@ namespace NeuralNetworksLib
 			//delete[] pSrc;
 
 			const float scale = 0.5f;
-			const __m256 ymm14 = _mm256_broadcast_ss((float*)&abs_mask);
-			const __m256 ymm15 = _mm256_broadcast_ss(&one);
-			const __m256 ymm13 = _mm256_broadcast_ss(&tanh_a);
+			const Activation::tanh_tier tanh_f;
 			const __m256 ymm12 = _mm256_broadcast_ss(hl_b);
 			const __m256 ymm11 = _mm256_broadcast_ss(&scale);
 			const __m256 ymm10 = _mm256_broadcast_ss(tanh_w);
@@ -2097,30 +2127,7 @@ namespace NeuralNetworksLib
 
 				ymm0 = _mm256_mul_ps(ymm0, ymm10);
 				
-				__m256 ymm1 = _mm256_and_ps(ymm14, ymm0);
-				__m256 ymm3 = _mm256_add_ps(ymm15, ymm1);
-				__m256 ymm4 = _mm256_mul_ps(ymm0, ymm0);
-
-				ymm3 = _mm256_add_ps(ymm3, ymm4);
-				__m256 ymm5 = _mm256_mul_ps(ymm4, ymm4);
-
-#ifdef USE_FMA
-				ymm3 = _mm256_fmadd_ps(ymm5, ymm13, ymm3);
-#else	
-				ymm5 = _mm256_mul_ps(ymm5, ymm13);
-				ymm3 = _mm256_add_ps(ymm3, ymm5);
-#endif
-
-				__m256 ymm2 = _mm256_andnot_ps(ymm14, ymm0);
-
-#ifdef USE_FAST_DIV
-				ymm3 = _mm256_rcp_ps(ymm3);
-#else
-				ymm3 = _mm256_div_ps(ymm15, ymm3);
-#endif	
-
-				ymm3 = _mm256_sub_ps(ymm15, ymm3);
-				ymm3 = _mm256_or_ps(ymm3, ymm2);
+				__m256 ymm3 = tanh_f(ymm0);
 
 				ymm3 = _mm256_mul_ps(ymm3, ymm11);
 				ymm3 = _mm256_add_ps(ymm3, ymm11);
@@ -2154,9 +2161,7 @@ namespace NeuralNetworksLib
 			//	break;
 			//}
 
-			const __m256 ymm14 = _mm256_broadcast_ss((float*)&abs_mask);
-			const __m256 ymm15 = _mm256_broadcast_ss(&one);
-			const __m256 ymm13 = _mm256_broadcast_ss(&tanh_a);
+			const Activation::tanh_tier tanh_f;
 			const __m256 ymm12 = _mm256_broadcast_ss(snn_ol_b);
 			const __m256 ymm11 = _mm256_broadcast_ss(scale);
 			const __m256 ymm10 = _mm256_broadcast_ss(tanh_w);
@@ -2168,30 +2173,7 @@ namespace NeuralNetworksLib
 				ymm0 = _mm256_add_ps(ymm0, ymm12);
 				ymm0 = _mm256_mul_ps(ymm0, ymm10);
 
-				__m256 ymm1 = _mm256_and_ps(ymm14, ymm0);
-				__m256 ymm3 = _mm256_add_ps(ymm15, ymm1);
-				__m256 ymm4 = _mm256_mul_ps(ymm0, ymm0);
-
-				ymm3 = _mm256_add_ps(ymm3, ymm4);
-				__m256 ymm5 = _mm256_mul_ps(ymm4, ymm4);
-
-#ifdef USE_FMA
-				ymm3 = _mm256_fmadd_ps(ymm5, ymm13, ymm3);
-#else	
-				ymm5 = _mm256_mul_ps(ymm5, ymm13);
-				ymm3 = _mm256_add_ps(ymm3, ymm5);
-#endif
-
-				__m256 ymm2 = _mm256_andnot_ps(ymm14, ymm0);
-
-#ifdef USE_FAST_DIV
-				ymm3 = _mm256_rcp_ps(ymm3);
-#else
-				ymm3 = _mm256_div_ps(ymm15, ymm3);
-#endif	
-
-				ymm3 = _mm256_sub_ps(ymm15, ymm3);
-				ymm3 = _mm256_or_ps(ymm3, ymm2);
+				__m256 ymm3 = tanh_f(ymm0);
 
 				if (*scale == 0.f)
 				{
@@ -2611,6 +2593,25 @@ namespace NeuralNetworksLib
 				__m256 ymm0 = _mm256_load_ps(src1_mulC + i);
 				__m256 ymm1 = _mm256_load_ps(src2 + i);
 
+#ifdef USE_FMA
+				ymm0 = _mm256_fmadd_ps(ymm0, ymm3, ymm1);
+#else
+				ymm0 = _mm256_mul_ps(ymm0, ymm3);
+				ymm0 = _mm256_add_ps(ymm0, ymm1);
+#endif
+
+				_mm256_store_ps(dst + i, ymm0);
+			}
+		}
+		void CNNPP::mulC1_add(float* __restrict dst, float* __restrict src_mulC, int size_, float* __restrict snn_hl_w)
+		{
+			const __m256 ymm3 = _mm256_broadcast_ss(snn_hl_w);
+
+			for (size_t i = 0; i < size_; i += REG_SIZE)
+			{
+				__m256 ymm0 = _mm256_load_ps(src_mulC + i);
+				__m256 ymm1 = _mm256_load_ps(dst + i);
+
 #ifdef USE_FMA
 				ymm0 = _mm256_fmadd_ps(ymm0, ymm3, ymm1);
 #else
@@ -3812,6 +3813,317 @@ namespace NeuralNetworksLib
 				j2++;
 			}
 		}
+
+		//Winograd F(2x2, 3x3) of 8 neighbouring tiles: input transform B^T d B of rows src[0..3] (18 floats of each row are read),
+		//product with transformed kernel and output transform A^T m A, y = outputs (0, 0), (0, 1), (1, 0), (1, 1) of tiles
+		static inline void wino_3x3_x8(__m256* __restrict y, const float* const* __restrict src, const __m256* __restrict ymm_kernel)
+		{
+			__m256 ymm_h[4][4];
+			for (int r = 0; r < 4; ++r)
+			{
+				const float* __restrict pSrc = src[r];
+
+				//deinterleave of even and odd pixels
+				const __m256 ymm_a = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(pSrc + 0)), _mm_loadu_ps(pSrc + 8), 1);
+				const __m256 ymm_b = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(pSrc + 4)), _mm_loadu_ps(pSrc + 12), 1);
+				const __m256 ymm_c = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(pSrc + 2)), _mm_loadu_ps(pSrc + 10), 1);
+				const __m256 ymm_e = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(pSrc + 6)), _mm_loadu_ps(pSrc + 14), 1);
+
+				const __m256 ymm_d0 = _mm256_shuffle_ps(ymm_a, ymm_b, 136);
+				const __m256 ymm_d1 = _mm256_shuffle_ps(ymm_a, ymm_b, 221);
+				const __m256 ymm_d2 = _mm256_shuffle_ps(ymm_c, ymm_e, 136);
+				const __m256 ymm_d3 = _mm256_shuffle_ps(ymm_c, ymm_e, 221);
+
+				ymm_h[r][0] = _mm256_sub_ps(ymm_d0, ymm_d2);
+				ymm_h[r][1] = _mm256_add_ps(ymm_d1, ymm_d2);
+				ymm_h[r][2] = _mm256_sub_ps(ymm_d2, ymm_d1);
+				ymm_h[r][3] = _mm256_sub_ps(ymm_d1, ymm_d3);
+			}
+
+			__m256 ymm_t0[4];
+			__m256 ymm_t1[4];
+			for (int c = 0; c < 4; ++c)
+			{
+				const __m256 ymm_v0 = _mm256_sub_ps(ymm_h[0][c], ymm_h[2][c]);
+				const __m256 ymm_v1 = _mm256_add_ps(ymm_h[1][c], ymm_h[2][c]);
+				const __m256 ymm_v2 = _mm256_sub_ps(ymm_h[2][c], ymm_h[1][c]);
+				const __m256 ymm_v3 = _mm256_sub_ps(ymm_h[1][c], ymm_h[3][c]);
+
+#ifdef USE_FMA
+				ymm_t0[c] = _mm256_mul_ps(ymm_v0, ymm_kernel[c]);
+				ymm_t0[c] = _mm256_fmadd_ps(ymm_v1, ymm_kernel[4 + c], ymm_t0[c]);
+				ymm_t0[c] = _mm256_fmadd_ps(ymm_v2, ymm_kernel[8 + c], ymm_t0[c]);
+
+				ymm_t1[c] = _mm256_mul_ps(ymm_v1, ymm_kernel[4 + c]);
+				ymm_t1[c] = _mm256_fnmadd_ps(ymm_v2, ymm_kernel[8 + c], ymm_t1[c]);
+				ymm_t1[c] = _mm256_fnmadd_ps(ymm_v3, ymm_kernel[12 + c], ymm_t1[c]);
+#else
+				const __m256 ymm_m1 = _mm256_mul_ps(ymm_v1, ymm_kernel[4 + c]);
+				const __m256 ymm_m2 = _mm256_mul_ps(ymm_v2, ymm_kernel[8 + c]);
+
+				ymm_t0[c] = _mm256_add_ps(_mm256_mul_ps(ymm_v0, ymm_kernel[c]), ymm_m1);
+				ymm_t0[c] = _mm256_add_ps(ymm_t0[c], ymm_m2);
+
+				ymm_t1[c] = _mm256_sub_ps(ymm_m1, ymm_m2);
+				ymm_t1[c] = _mm256_sub_ps(ymm_t1[c], _mm256_mul_ps(ymm_v3, ymm_kernel[12 + c]));
+#endif
+			}
+
+			y[0] = _mm256_add_ps(_mm256_add_ps(ymm_t0[0], ymm_t0[1]), ymm_t0[2]);
+			y[1] = _mm256_sub_ps(_mm256_sub_ps(ymm_t0[1], ymm_t0[2]), ymm_t0[3]);
+			y[2] = _mm256_add_ps(_mm256_add_ps(ymm_t1[0], ymm_t1[1]), ymm_t1[2]);
+			y[3] = _mm256_sub_ps(_mm256_sub_ps(ymm_t1[1], ymm_t1[2]), ymm_t1[3]);
+		}
+
+		void CNNPP::conv_3x3_wino(float* __restrict dst, int dst_size_l, float* __restrict src, int src_size_l, int src_size_h, float* __restrict kernel, size_t L, size_t H)
+		{
+			if (L == 0) L = src_size_l - 2;
+			if (H == 0) H = src_size_h - 2;
+
+			__m256 ymm_kernel[16];
+			for (int k = 0; k < 16; ++k)
+			{
+				ymm_kernel[k] = _mm256_broadcast_ss(kernel + k);
+			}
+
+			for (int j = 0; j < (int)H; j += 2)
+			{
+				//last row of odd H: second output row of tiles is not stored
+				const float* pSrc[4] = {
+					src + j * src_size_l,
+					src + (j + 1) * src_size_l,
+					src + (j + 2) * src_size_l,
+					src + (j + 3 < src_size_h ? j + 3 : j + 2) * src_size_l };
+				const bool row_2 = j + 1 < (int)H;
+
+				float* __restrict pDst0 = dst + j * dst_size_l;
+				float* __restrict pDst1 = pDst0 + dst_size_l;
+
+				__m256 y[4];
+				int x = 0;
+				for (; x < (int)L && x + 18 <= src_size_l && x + 2 * REG_SIZE <= dst_size_l; x += 2 * REG_SIZE)
+				{
+					const float* pSrc_x[4] = { pSrc[0] + x, pSrc[1] + x, pSrc[2] + x, pSrc[3] + x };
+					wino_3x3_x8(y, pSrc_x, ymm_kernel);
+
+					__m256 ymm_lo = _mm256_unpacklo_ps(y[0], y[1]);
+					__m256 ymm_hi = _mm256_unpackhi_ps(y[0], y[1]);
+					_mm256_storeu_ps(pDst0 + x, _mm256_permute2f128_ps(ymm_lo, ymm_hi, 32));
+					_mm256_storeu_ps(pDst0 + x + REG_SIZE, _mm256_permute2f128_ps(ymm_lo, ymm_hi, 49));
+
+					if (row_2)
+					{
+						ymm_lo = _mm256_unpacklo_ps(y[2], y[3]);
+						ymm_hi = _mm256_unpackhi_ps(y[2], y[3]);
+						_mm256_storeu_ps(pDst1 + x, _mm256_permute2f128_ps(ymm_lo, ymm_hi, 32));
+						_mm256_storeu_ps(pDst1 + x + REG_SIZE, _mm256_permute2f128_ps(ymm_lo, ymm_hi, 49));
+					}
+				}
+
+				//tail: same tiles on zero padded copy of rows
+				if (x < (int)L)
+				{
+					ALIGN(ALIGN_DEF) float buf[4 * 3 * REG_SIZE];
+					ALIGN(ALIGN_DEF) float out[4 * REG_SIZE];
+					const int n = std::min(18, src_size_l - x);
+
+					const float* pBuf[4];
+					for (int r = 0; r < 4; ++r)
+					{
+						float* __restrict pRow = buf + r * 3 * REG_SIZE;
+						for (int i = 0; i < 3 * REG_SIZE; ++i)
+						{
+							pRow[i] = i < n ? pSrc[r][x + i] : 0.f;
+						}
+						pBuf[r] = pRow;
+					}
+
+					wino_3x3_x8(y, pBuf, ymm_kernel);
+
+					__m256 ymm_lo = _mm256_unpacklo_ps(y[0], y[1]);
+					__m256 ymm_hi = _mm256_unpackhi_ps(y[0], y[1]);
+					_mm256_store_ps(out, _mm256_permute2f128_ps(ymm_lo, ymm_hi, 32));
+					_mm256_store_ps(out + REG_SIZE, _mm256_permute2f128_ps(ymm_lo, ymm_hi, 49));
+
+					ymm_lo = _mm256_unpacklo_ps(y[2], y[3]);
+					ymm_hi = _mm256_unpackhi_ps(y[2], y[3]);
+					_mm256_store_ps(out + 2 * REG_SIZE, _mm256_permute2f128_ps(ymm_lo, ymm_hi, 32));
+					_mm256_store_ps(out + 3 * REG_SIZE, _mm256_permute2f128_ps(ymm_lo, ymm_hi, 49));
+
+					const int m = std::min((int)L - x, dst_size_l - x);
+					for (int i = 0; i < m; ++i)
+					{
+						pDst0[x + i] = out[i];
+						if (row_2) pDst1[x + i] = out[2 * REG_SIZE + i];
+					}
+				}
+			}
+		}
+		void CNNPP::conv_3x3_lrelu_bn_max_wino(float* __restrict dst, int dst_size_l, float* __restrict src, int src_size_l, int src_size_h, float* __restrict kernel, float* __restrict conv_b, float* __restrict lrelu_w1, float* __restrict lrelu_w2, float* __restrict bn_w, float* __restrict bn_b, size_t L, size_t H)
+		{
+			if (L == 0) L = src_size_l - 2;
+			if (H == 0) H = src_size_h - 2;
+
+			__m256 ymm_kernel[16];
+			for (int k = 0; k < 16; ++k)
+			{
+				ymm_kernel[k] = _mm256_broadcast_ss(kernel + k);
+			}
+
+			const __m256 ymm_conv_b = _mm256_broadcast_ss(conv_b);
+			const __m256 ymm_lrelu_w1 = _mm256_broadcast_ss(lrelu_w1);
+			const __m256 ymm_lrelu_w2 = _mm256_broadcast_ss(lrelu_w2);
+			const __m256 ymm_bn_b = _mm256_broadcast_ss(bn_b);
+			const __m256 ymm_zero = _mm256_setzero_ps();
+
+			//tile 2x2 of conv is max pool window
+			const int L2 = (int)L >> 1;
+			const int H2 = (int)H >> 1;
+			for (int j = 0; j < H2; ++j)
+			{
+				const float* pSrc[4] = {
+					src + (2 * j) * src_size_l,
+					src + (2 * j + 1) * src_size_l,
+					src + (2 * j + 2) * src_size_l,
+					src + (2 * j + 3) * src_size_l };
+
+				float* __restrict pDst = dst + j * dst_size_l;
+
+				__m256 y[4];
+				ALIGN(ALIGN_DEF) float buf[4 * 3 * REG_SIZE];
+				for (int i = 0; i < L2; i += REG_SIZE)
+				{
+					const int x = 2 * i;
+					const bool tail = x + 18 > src_size_l || i + REG_SIZE > dst_size_l;
+
+					const float* pSrc_x[4] = { pSrc[0] + x, pSrc[1] + x, pSrc[2] + x, pSrc[3] + x };
+					if (tail)
+					{
+						//same tiles on zero padded copy of rows
+						const int n = std::min(18, src_size_l - x);
+						for (int r = 0; r < 4; ++r)
+						{
+							float* __restrict pRow = buf + r * 3 * REG_SIZE;
+							for (int k = 0; k < 3 * REG_SIZE; ++k)
+							{
+								pRow[k] = k < n ? pSrc_x[r][k] : 0.f;
+							}
+							pSrc_x[r] = pRow;
+						}
+					}
+
+					wino_3x3_x8(y, pSrc_x, ymm_kernel);
+
+					for (int k = 0; k < 4; ++k)
+					{
+						y[k] = _mm256_add_ps(y[k], ymm_conv_b);
+						const __m256 ymm_relu = _mm256_max_ps(y[k], ymm_zero);
+
+#ifdef USE_FMA
+						y[k] = _mm256_fmadd_ps(y[k], ymm_lrelu_w1, ymm_bn_b);
+						y[k] = _mm256_fmadd_ps(ymm_relu, ymm_lrelu_w2, y[k]);
+#else
+						y[k] = _mm256_mul_ps(y[k], ymm_lrelu_w1);
+						y[k] = _mm256_add_ps(y[k], _mm256_mul_ps(ymm_relu, ymm_lrelu_w2));
+						y[k] = _mm256_add_ps(y[k], ymm_bn_b);
+#endif
+					}
+
+					const __m256 ymm_pool = _mm256_max_ps(_mm256_max_ps(y[0], y[1]), _mm256_max_ps(y[2], y[3]));
+
+					if (!tail)
+					{
+						_mm256_storeu_ps(pDst + i, ymm_pool);
+					}
+					else
+					{
+						ALIGN(ALIGN_DEF) float out[REG_SIZE];
+						_mm256_store_ps(out, ymm_pool);
+
+						const int m = std::min(L2 - i, dst_size_l - i);
+						for (int k = 0; k < m; ++k)
+						{
+							pDst[i + k] = out[k];
+						}
+					}
+				}
+			}
+		}
+
+		//MR x (NV * REG_SIZE) tile of dst = kernel * src, accumulators stay in registers over whole K
+		template <int MR, int NV>
+		static inline void gemm_tile(float* __restrict dst, int dst_size_l, const float* __restrict src, int src_size_l, const float* __restrict kernel, int K)
+		{
+			__m256 ymm_c[MR][NV];
+			for (int r = 0; r < MR; ++r)
+			{
+				for (int v = 0; v < NV; ++v)
+				{
+					ymm_c[r][v] = _mm256_setzero_ps();
+				}
+			}
+
+			for (int k = 0; k < K; ++k)
+			{
+				const float* __restrict pSrc = src + k * src_size_l;
+
+				__m256 ymm_b[NV];
+				for (int v = 0; v < NV; ++v)
+				{
+					ymm_b[v] = _mm256_load_ps(pSrc + v * REG_SIZE);
+				}
+
+				for (int r = 0; r < MR; ++r)
+				{
+					const __m256 ymm_a = _mm256_broadcast_ss(kernel + r * K + k);
+					for (int v = 0; v < NV; ++v)
+					{
+#ifdef USE_FMA
+						ymm_c[r][v] = _mm256_fmadd_ps(ymm_a, ymm_b[v], ymm_c[r][v]);
+#else
+						ymm_c[r][v] = _mm256_add_ps(ymm_c[r][v], _mm256_mul_ps(ymm_a, ymm_b[v]));
+#endif
+					}
+				}
+			}
+
+			for (int r = 0; r < MR; ++r)
+			{
+				for (int v = 0; v < NV; ++v)
+				{
+					_mm256_store_ps(dst + r * dst_size_l + v * REG_SIZE, ymm_c[r][v]);
+				}
+			}
+		}
+		template <int MR, int NV>
+		static inline void gemm_rows(float* __restrict dst, int dst_size_l, const float* __restrict src, int src_size_l, const float* __restrict kernel, int K, int N)
+		{
+			for (int n = 0; n < N; n += NV * REG_SIZE)
+			{
+				gemm_tile<MR, NV>(dst + n, dst_size_l, src + n, src_size_l, kernel, K);
+			}
+		}
+		void CNNPP::gemm(float* __restrict dst, int dst_size_l, float* __restrict src, int src_size_l, float* __restrict kernel, int M, int K, int N)
+		{
+			//6 x 16 tiles, 1-2 rows of A are tiled by 32 columns to keep 8 accumulators in flight
+			int m = 0;
+			for (; m + 6 <= M; m += 6)
+			{
+				gemm_rows<6, 2>(dst + m * dst_size_l, dst_size_l, src, src_size_l, kernel + m * K, K, N);
+			}
+
+			float* __restrict pDst = dst + m * dst_size_l;
+			const float* __restrict pKernel = kernel + m * K;
+			switch (M - m)
+			{
+			case 5: gemm_rows<5, 2>(pDst, dst_size_l, src, src_size_l, pKernel, K, N); break;
+			case 4: gemm_rows<4, 2>(pDst, dst_size_l, src, src_size_l, pKernel, K, N); break;
+			case 3: gemm_rows<3, 2>(pDst, dst_size_l, src, src_size_l, pKernel, K, N); break;
+			case 2: gemm_rows<2, 4>(pDst, dst_size_l, src, src_size_l, pKernel, K, N); break;
+			case 1: gemm_rows<1, 4>(pDst, dst_size_l, src, src_size_l, pKernel, K, N); break;
+			default: break;
+			}
+		}
 	}
 
 #endif
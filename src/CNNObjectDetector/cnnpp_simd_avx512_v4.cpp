@@ -0,0 +1,1045 @@
+/*
+*	Copyright (c) 2018, Ilya Kalinovskiy
+*	All rights reserved.
+*
+*	This is an implementation of the algorithm described in the following paper:
+*		I.A. Kalinovskiy, V.G. Spitsyn,
+*		Compact Convolutional Neural Network Cascade for Face Detection,
+*		http://arxiv.org/abs/1508.01292.
+*
+*	Redistribution and use of this program as source code or in binary form, with or without modifications, are permitted provided that the following conditions are met:
+*		1. Redistributions may not be sold, nor may they be used in a commercial product or activity without prior permission from the copyright holder (contact him at kua_21@mail.ru).
+*		2. Redistributions may not be used for military purposes.
+*		3. Any published work which utilizes this program shall include the reference to the paper available at http://arxiv.org/abs/1508.01292
+*		4. Redistributions must retain the above copyright notice and the reference to the algorithm on which the implementation is based on, this list of conditions and the following disclaimer.
+*
+*	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+*	IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "cnnpp_simd_avx512_v4.h"
+#include "activation_simd.h"
+#include <immintrin.h>
+
+#define IACA__START
+#define IACA__END
+
+//========================================================================================================
+
+namespace NeuralNetworksLib
+{
+#if defined(USE_FIXED_POINT) && defined(USE_AVX512)
+
+	namespace SIMD
+	{
+		//layer constants of CNNPP_v3 are computed by AVX2 code and broadcast to both 256 bit halves
+		#define broadcast_256(m256i) _mm512_broadcast_i64x4(m256i)
+		#define FP2FxP_256(m256, ymm_toFxP) _mm256_cvtps_epi32(_mm256_mul_ps(m256, ymm_toFxP))
+		#define FxP_squeeze_256(m256i) _mm256_permute4x64_epi64(_mm256_hadd_epi16(m256i, m256i), 216)
+
+		#define FP2FxP(m512, zmm_toFxP) _mm512_cvtps_epi32(_mm512_mul_ps(m512, zmm_toFxP))
+
+		//_mm256_hadd_epi16 has no 512 bit version: pairs are summed by madd with ones and low words are gathered by word permutation,
+		//the sum is taken modulo 2^16 like in hadd
+		#define FxP_squeeze(m512i) _mm512_permutexvar_epi16(zmm_squeeze_idx, _mm512_madd_epi16(m512i, zmm_one))
+		#define hadd_epi16(a, b) _mm512_permutex2var_epi16(_mm512_madd_epi16(a, zmm_one), zmm_hadd_idx, _mm512_madd_epi16(b, zmm_one))
+
+		//FxP_squeeze of CNNPP_v3 in each 256 bit half
+		ALIGN(64) static const short squeeze_idx[32] = {
+			0, 2, 4, 6, 8, 10, 12, 14, 0, 2, 4, 6, 8, 10, 12, 14,
+			16, 18, 20, 22, 24, 26, 28, 30, 16, 18, 20, 22, 24, 26, 28, 30 };
+
+		//_mm256_hadd_epi16 in each 256 bit half, indices above 31 select second operand
+		ALIGN(64) static const short hadd_idx[32] = {
+			0, 2, 4, 6, 32, 34, 36, 38, 8, 10, 12, 14, 40, 42, 44, 46,
+			16, 18, 20, 22, 48, 50, 52, 54, 24, 26, 28, 30, 56, 58, 60, 62 };
+
+		//_mm256_hadd_ps in each 256 bit half
+		#define hadd_ps(a, b) _mm512_add_ps(_mm512_shuffle_ps(a, b, 136), _mm512_shuffle_ps(a, b, 221))
+
+		#define conv_block(k, id)												    \
+				zmm_s1 = _mm512_shuffle_epi32(zmm_d1, (_MM_PERM_ENUM)78);			\
+				zmm_d1 = _mm512_add_epi16(zmm_d1, zmm_s1);							\
+				zmm_s2 = _mm512_shuffle_epi8(zmm_s1, zmm_mask1);					\
+				zmm_d1 = _mm512_add_epi16(zmm_d1, zmm_s2);							\
+				zmm_s1 = _mm512_mulhrs_epi16(zmm_d1, zmm_k_1_##id[k]);				\
+				sum_1 = _mm512_add_epi16(sum_1, zmm_s1);							\
+				zmm_s2 = _mm512_mulhrs_epi16(zmm_d1, zmm_k_2_##id[k]);				\
+				sum_2 = _mm512_add_epi16(sum_2, zmm_s2);
+
+		void CNNPP_v4::conv_4x4_lrelu_bn_max_avx512(float* __restrict dst, int dst_size_l, float* __restrict src, int src_size_l, int src_size_h, float* __restrict kernel, float* __restrict conv_b, float* __restrict lrelu_w1, float* __restrict lrelu_w2, float* __restrict bn_w, float* __restrict bn_b, size_t L, size_t H, int num_threads)
+		{
+			if (L == 0) L = src_size_l - 3;
+			if (H == 0) H = src_size_h - 3;
+			if (H & 1) H--;
+
+			const __m512i zmm_mask1 = broadcast_256(_mm256_setr_epi8(0, 1, 0, 1, 0, 1, 0, 1, 128, 128, 128, 128, 128, 128, 128, 128, 4, 5, 4, 5, 4, 5, 4, 5, 128, 128, 128, 128, 128, 128, 128, 128));
+			const __m512i zmm_mask2 = broadcast_256(_mm256_setr_epi8(2, 3, 2, 3, 2, 3, 2, 3, 2, 3, 2, 3, 2, 3, 2, 3, 6, 7, 6, 7, 6, 7, 6, 7, 6, 7, 6, 7, 6, 7, 6, 7));
+			const __m512i zmm_mask3 = broadcast_256(_mm256_setr_epi8(4, 5, 4, 5, 4, 5, 4, 5, 4, 5, 4, 5, 4, 5, 4, 5, 8, 9, 8, 9, 8, 9, 8, 9, 8, 9, 8, 9, 8, 9, 8, 9));
+			const __m512i zmm_mask4 = broadcast_256(_mm256_setr_epi8(6, 7, 6, 7, 6, 7, 6, 7, 6, 7, 6, 7, 6, 7, 6, 7, 10, 11, 10, 11, 10, 11, 10, 11, 10, 11, 10, 11, 10, 11, 10, 11));
+			const __m512i zmm_mask5 = broadcast_256(_mm256_setr_epi8(128, 128, 128, 128, 128, 128, 128, 128, 8, 9, 8, 9, 8, 9, 8, 9, 128, 128, 128, 128, 128, 128, 128, 128, 12, 13, 12, 13, 12, 13, 12, 13));
+			const __m512i zmm_one = _mm512_set1_epi16(1);
+			const __m512i zmm_squeeze_idx = _mm512_load_si512((const __m512i*)squeeze_idx);
+			const __m512i zmm_load_idx = _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 4, 5, 6, 7, 8, 9, 10, 11);
+			const __m512i zmm_store_idx = _mm512_setr_epi64(0, 1, 4, 5, 0, 1, 4, 5);
+
+			fct = 1.f;
+			const __m512 zmm_toFxP_data = _mm512_set1_ps(toFxP / scale_data);
+			const __m256 ymm_toFxP_kernel = _mm256_set1_ps(toFxP / skt1);
+			const __m256 ymm_toFxP_conv_b = _mm256_set1_ps(toFxP / (fct * 2.f * scale_data * skt1));
+			const __m256 ymm_toFxP_lrelu_w = _mm256_set1_ps(toFxP / skt2);
+			const __m256 ymm_toFxP_bn_b = _mm256_set1_ps(toFxP / (fct * 2.f * 2.f * scale_data * skt1 * skt2));
+
+			fct *= 2.f * 2.f * scale_data * skt1 * skt2;
+
+			__m256i ymm_temp;
+
+			ymm_temp = FP2FxP_256(_mm256_load_ps(kernel + 0 * REG_SIZE), ymm_toFxP_kernel); const __m512i zmm_k11 = broadcast_256(FxP_squeeze_256(ymm_temp));
+			ymm_temp = FP2FxP_256(_mm256_load_ps(kernel + 1 * REG_SIZE), ymm_toFxP_kernel); const __m512i zmm_k12 = broadcast_256(FxP_squeeze_256(ymm_temp));
+			ymm_temp = FP2FxP_256(_mm256_load_ps(kernel + 2 * REG_SIZE), ymm_toFxP_kernel); const __m512i zmm_k13 = broadcast_256(FxP_squeeze_256(ymm_temp));
+			ymm_temp = FP2FxP_256(_mm256_load_ps(kernel + 3 * REG_SIZE), ymm_toFxP_kernel); const __m512i zmm_k14 = broadcast_256(FxP_squeeze_256(ymm_temp));
+
+			ymm_temp = FP2FxP_256(_mm256_load_ps(kernel + 4 * REG_SIZE), ymm_toFxP_kernel); const __m512i zmm_k21 = broadcast_256(FxP_squeeze_256(ymm_temp));
+			ymm_temp = FP2FxP_256(_mm256_load_ps(kernel + 5 * REG_SIZE), ymm_toFxP_kernel); const __m512i zmm_k22 = broadcast_256(FxP_squeeze_256(ymm_temp));
+			ymm_temp = FP2FxP_256(_mm256_load_ps(kernel + 6 * REG_SIZE), ymm_toFxP_kernel); const __m512i zmm_k23 = broadcast_256(FxP_squeeze_256(ymm_temp));
+			ymm_temp = FP2FxP_256(_mm256_load_ps(kernel + 7 * REG_SIZE), ymm_toFxP_kernel); const __m512i zmm_k24 = broadcast_256(FxP_squeeze_256(ymm_temp));
+
+			ymm_temp = FP2FxP_256(_mm256_load_ps(kernel + 8 * REG_SIZE), ymm_toFxP_kernel);  const __m512i zmm_k31 = broadcast_256(FxP_squeeze_256(ymm_temp));
+			ymm_temp = FP2FxP_256(_mm256_load_ps(kernel + 9 * REG_SIZE), ymm_toFxP_kernel);  const __m512i zmm_k32 = broadcast_256(FxP_squeeze_256(ymm_temp));
+			ymm_temp = FP2FxP_256(_mm256_load_ps(kernel + 10 * REG_SIZE), ymm_toFxP_kernel); const __m512i zmm_k33 = broadcast_256(FxP_squeeze_256(ymm_temp));
+			ymm_temp = FP2FxP_256(_mm256_load_ps(kernel + 11 * REG_SIZE), ymm_toFxP_kernel); const __m512i zmm_k34 = broadcast_256(FxP_squeeze_256(ymm_temp));
+
+			ymm_temp = FP2FxP_256(_mm256_load_ps(kernel + 12 * REG_SIZE), ymm_toFxP_kernel); const __m512i zmm_k41 = broadcast_256(FxP_squeeze_256(ymm_temp));
+			ymm_temp = FP2FxP_256(_mm256_load_ps(kernel + 13 * REG_SIZE), ymm_toFxP_kernel); const __m512i zmm_k42 = broadcast_256(FxP_squeeze_256(ymm_temp));
+			ymm_temp = FP2FxP_256(_mm256_load_ps(kernel + 14 * REG_SIZE), ymm_toFxP_kernel); const __m512i zmm_k43 = broadcast_256(FxP_squeeze_256(ymm_temp));
+			ymm_temp = FP2FxP_256(_mm256_load_ps(kernel + 15 * REG_SIZE), ymm_toFxP_kernel); const __m512i zmm_k44 = broadcast_256(FxP_squeeze_256(ymm_temp));
+
+			ymm_temp = FP2FxP_256(_mm256_load_ps(conv_b), ymm_toFxP_conv_b);	const __m512i zmm_conv_b = broadcast_256(FxP_squeeze_256(ymm_temp));
+			ymm_temp = FP2FxP_256(_mm256_load_ps(lrelu_w1), ymm_toFxP_lrelu_w);	const __m512i zmm_lrelu_w1 = broadcast_256(FxP_squeeze_256(ymm_temp));
+			ymm_temp = FP2FxP_256(_mm256_load_ps(lrelu_w2), ymm_toFxP_lrelu_w);	const __m512i zmm_lrelu_w2 = broadcast_256(FxP_squeeze_256(ymm_temp));
+			ymm_temp = FP2FxP_256(_mm256_load_ps(bn_b), ymm_toFxP_bn_b);		const __m512i zmm_bn_b = broadcast_256(FxP_squeeze_256(ymm_temp));
+
+			OMP_PRAGMA(omp parallel for num_threads(num_threads))
+			for (int j = 0; j < H; j += 2)
+			{
+				float* __restrict pSrc0 = src + (j + 0) * src_size_l;
+				float* __restrict pSrc1 = src + (j + 1) * src_size_l;
+				float* __restrict pSrc2 = src + (j + 2) * src_size_l;
+				float* __restrict pSrc3 = src + (j + 3) * src_size_l;
+				float* __restrict pSrc4 = src + (j + 4) * src_size_l;
+				float* __restrict pDst = dst + (j >> 1) * dst_size_l;
+
+				IACA__START;
+				for (size_t i = 0; i < L; i += 8)
+				{
+					//high half computes iteration i + 4 of AVX2 kernel
+					const bool pair = i + 4 < L;
+					const __mmask16 load_mask = pair ? 0x0FFF : 0x00FF;
+
+					//0
+					__m512i zmm_data = FP2FxP(_mm512_permutexvar_ps(zmm_load_idx, _mm512_maskz_loadu_ps(load_mask, pSrc0)), zmm_toFxP_data);
+					zmm_data = FxP_squeeze(zmm_data);
+					pSrc0 += REG_SIZE;
+
+					__m512i zmm_d = _mm512_shuffle_epi8(zmm_data, zmm_mask1);
+					__m512i sum_1 = _mm512_mulhrs_epi16(zmm_d, zmm_k11);
+
+					zmm_d = _mm512_shuffle_epi8(zmm_data, zmm_mask2);
+					__m512i zmm_m = _mm512_mulhrs_epi16(zmm_d, zmm_k12);
+					sum_1 = _mm512_add_epi16(sum_1, zmm_m);
+
+					zmm_d = _mm512_shuffle_epi8(zmm_data, zmm_mask3);
+					zmm_m = _mm512_mulhrs_epi16(zmm_d, zmm_k13);
+					sum_1 = _mm512_add_epi16(sum_1, zmm_m);
+
+					zmm_d = _mm512_shuffle_epi8(zmm_data, zmm_mask4);
+					zmm_m = _mm512_mulhrs_epi16(zmm_d, zmm_k14);
+					sum_1 = _mm512_add_epi16(sum_1, zmm_m);
+
+					zmm_d = _mm512_shuffle_epi8(zmm_data, zmm_mask5);
+					zmm_m = _mm512_mulhrs_epi16(zmm_d, zmm_k11);
+					sum_1 = _mm512_add_epi16(sum_1, zmm_m);
+
+					//1
+					zmm_data = FP2FxP(_mm512_permutexvar_ps(zmm_load_idx, _mm512_maskz_loadu_ps(load_mask, pSrc1)), zmm_toFxP_data);
+					zmm_data = FxP_squeeze(zmm_data);
+					pSrc1 += REG_SIZE;
+
+					zmm_d = _mm512_shuffle_epi8(zmm_data, zmm_mask1);
+					zmm_m = _mm512_mulhrs_epi16(zmm_d, zmm_k21);
+					sum_1 = _mm512_add_epi16(sum_1, zmm_m);
+					__m512i sum_2 = _mm512_mulhrs_epi16(zmm_d, zmm_k11);
+
+					zmm_d = _mm512_shuffle_epi8(zmm_data, zmm_mask2);
+					zmm_m = _mm512_mulhrs_epi16(zmm_d, zmm_k22);
+					sum_1 = _mm512_add_epi16(sum_1, zmm_m);
+					zmm_m = _mm512_mulhrs_epi16(zmm_d, zmm_k12);
+					sum_2 = _mm512_add_epi16(sum_2, zmm_m);
+
+					zmm_d = _mm512_shuffle_epi8(zmm_data, zmm_mask3);
+					zmm_m = _mm512_mulhrs_epi16(zmm_d, zmm_k23);
+					sum_1 = _mm512_add_epi16(sum_1, zmm_m);
+					zmm_m = _mm512_mulhrs_epi16(zmm_d, zmm_k13);
+					sum_2 = _mm512_add_epi16(sum_2, zmm_m);
+
+					zmm_d = _mm512_shuffle_epi8(zmm_data, zmm_mask4);
+					zmm_m = _mm512_mulhrs_epi16(zmm_d, zmm_k24);
+					sum_1 = _mm512_add_epi16(sum_1, zmm_m);
+					zmm_m = _mm512_mulhrs_epi16(zmm_d, zmm_k14);
+					sum_2 = _mm512_add_epi16(sum_2, zmm_m);
+
+					zmm_d = _mm512_shuffle_epi8(zmm_data, zmm_mask5);
+					zmm_m = _mm512_mulhrs_epi16(zmm_d, zmm_k21);
+					sum_1 = _mm512_add_epi16(sum_1, zmm_m);
+					zmm_m = _mm512_mulhrs_epi16(zmm_d, zmm_k11);
+					sum_2 = _mm512_add_epi16(sum_2, zmm_m);
+
+					//2
+					zmm_data = FP2FxP(_mm512_permutexvar_ps(zmm_load_idx, _mm512_maskz_loadu_ps(load_mask, pSrc2)), zmm_toFxP_data);
+					zmm_data = FxP_squeeze(zmm_data);
+					pSrc2 += REG_SIZE;
+
+					zmm_d = _mm512_shuffle_epi8(zmm_data, zmm_mask1);
+					zmm_m = _mm512_mulhrs_epi16(zmm_d, zmm_k31);
+					sum_1 = _mm512_add_epi16(sum_1, zmm_m);
+					zmm_m = _mm512_mulhrs_epi16(zmm_d, zmm_k21);
+					sum_2 = _mm512_add_epi16(sum_2, zmm_m);
+
+					zmm_d = _mm512_shuffle_epi8(zmm_data, zmm_mask2);
+					zmm_m = _mm512_mulhrs_epi16(zmm_d, zmm_k32);
+					sum_1 = _mm512_add_epi16(sum_1, zmm_m);
+					zmm_m = _mm512_mulhrs_epi16(zmm_d, zmm_k22);
+					sum_2 = _mm512_add_epi16(sum_2, zmm_m);
+
+					zmm_d = _mm512_shuffle_epi8(zmm_data, zmm_mask3);
+					zmm_m = _mm512_mulhrs_epi16(zmm_d, zmm_k33);
+					sum_1 = _mm512_add_epi16(sum_1, zmm_m);
+					zmm_m = _mm512_mulhrs_epi16(zmm_d, zmm_k23);
+					sum_2 = _mm512_add_epi16(sum_2, zmm_m);
+
+					zmm_d = _mm512_shuffle_epi8(zmm_data, zmm_mask4);
+					zmm_m = _mm512_mulhrs_epi16(zmm_d, zmm_k34);
+					sum_1 = _mm512_add_epi16(sum_1, zmm_m);
+					zmm_m = _mm512_mulhrs_epi16(zmm_d, zmm_k24);
+					sum_2 = _mm512_add_epi16(sum_2, zmm_m);
+
+					zmm_d = _mm512_shuffle_epi8(zmm_data, zmm_mask5);
+					zmm_m = _mm512_mulhrs_epi16(zmm_d, zmm_k31);
+					sum_1 = _mm512_add_epi16(sum_1, zmm_m);
+					zmm_m = _mm512_mulhrs_epi16(zmm_d, zmm_k21);
+					sum_2 = _mm512_add_epi16(sum_2, zmm_m);
+
+					//3
+					zmm_data = FP2FxP(_mm512_permutexvar_ps(zmm_load_idx, _mm512_maskz_loadu_ps(load_mask, pSrc3)), zmm_toFxP_data);
+					zmm_data = FxP_squeeze(zmm_data);
+					pSrc3 += REG_SIZE;
+
+					zmm_d = _mm512_shuffle_epi8(zmm_data, zmm_mask1);
+					zmm_m = _mm512_mulhrs_epi16(zmm_d, zmm_k41);
+					sum_1 = _mm512_add_epi16(sum_1, zmm_m);
+					zmm_m = _mm512_mulhrs_epi16(zmm_d, zmm_k31);
+					sum_2 = _mm512_add_epi16(sum_2, zmm_m);
+
+					zmm_d = _mm512_shuffle_epi8(zmm_data, zmm_mask2);
+					zmm_m = _mm512_mulhrs_epi16(zmm_d, zmm_k42);
+					sum_1 = _mm512_add_epi16(sum_1, zmm_m);
+					zmm_m = _mm512_mulhrs_epi16(zmm_d, zmm_k32);
+					sum_2 = _mm512_add_epi16(sum_2, zmm_m);
+
+					zmm_d = _mm512_shuffle_epi8(zmm_data, zmm_mask3);
+					zmm_m = _mm512_mulhrs_epi16(zmm_d, zmm_k43);
+					sum_1 = _mm512_add_epi16(sum_1, zmm_m);
+					zmm_m = _mm512_mulhrs_epi16(zmm_d, zmm_k33);
+					sum_2 = _mm512_add_epi16(sum_2, zmm_m);
+
+					zmm_d = _mm512_shuffle_epi8(zmm_data, zmm_mask4);
+					zmm_m = _mm512_mulhrs_epi16(zmm_d, zmm_k44);
+					sum_1 = _mm512_add_epi16(sum_1, zmm_m);
+					zmm_m = _mm512_mulhrs_epi16(zmm_d, zmm_k34);
+					sum_2 = _mm512_add_epi16(sum_2, zmm_m);
+
+					zmm_d = _mm512_shuffle_epi8(zmm_data, zmm_mask5);
+					zmm_m = _mm512_mulhrs_epi16(zmm_d, zmm_k41);
+					sum_1 = _mm512_add_epi16(sum_1, zmm_m);
+					zmm_m = _mm512_mulhrs_epi16(zmm_d, zmm_k31);
+					sum_2 = _mm512_add_epi16(sum_2, zmm_m);
+
+					//4
+					zmm_data = FP2FxP(_mm512_permutexvar_ps(zmm_load_idx, _mm512_maskz_loadu_ps(load_mask, pSrc4)), zmm_toFxP_data);
+					zmm_data = FxP_squeeze(zmm_data);
+					pSrc4 += REG_SIZE;
+
+					zmm_d = _mm512_shuffle_epi8(zmm_data, zmm_mask1);
+					zmm_m = _mm512_mulhrs_epi16(zmm_d, zmm_k41);
+					sum_2 = _mm512_add_epi16(sum_2, zmm_m);
+
+					zmm_d = _mm512_shuffle_epi8(zmm_data, zmm_mask2);
+					zmm_m = _mm512_mulhrs_epi16(zmm_d, zmm_k42);
+					sum_2 = _mm512_add_epi16(sum_2, zmm_m);
+
+					zmm_d = _mm512_shuffle_epi8(zmm_data, zmm_mask3);
+					zmm_m = _mm512_mulhrs_epi16(zmm_d, zmm_k43);
+					sum_2 = _mm512_add_epi16(sum_2, zmm_m);
+
+					zmm_d = _mm512_shuffle_epi8(zmm_data, zmm_mask4);
+					zmm_m = _mm512_mulhrs_epi16(zmm_d, zmm_k44);
+					sum_2 = _mm512_add_epi16(sum_2, zmm_m);
+
+					zmm_d = _mm512_shuffle_epi8(zmm_data, zmm_mask5);
+					zmm_m = _mm512_mulhrs_epi16(zmm_d, zmm_k41);
+					sum_2 = _mm512_add_epi16(sum_2, zmm_m);
+
+					//-----------------------------
+
+					sum_1 = _mm512_add_epi16(sum_1, zmm_conv_b);
+					zmm_d = _mm512_max_epi16(sum_1, _mm512_setzero_si512());
+
+					zmm_m = _mm512_mulhrs_epi16(sum_1, zmm_lrelu_w1);
+					sum_1 = _mm512_add_epi16(zmm_bn_b, zmm_m);
+
+					zmm_m = _mm512_mulhrs_epi16(zmm_d, zmm_lrelu_w2);
+					sum_1 = _mm512_add_epi16(sum_1, zmm_m);
+
+					sum_2 = _mm512_add_epi16(sum_2, zmm_conv_b);
+					zmm_d = _mm512_max_epi16(sum_2, _mm512_setzero_si512());
+
+					zmm_m = _mm512_mulhrs_epi16(sum_2, zmm_lrelu_w1);
+					sum_2 = _mm512_add_epi16(zmm_bn_b, zmm_m);
+
+					zmm_m = _mm512_mulhrs_epi16(zmm_d, zmm_lrelu_w2);
+					sum_2 = _mm512_add_epi16(sum_2, zmm_m);
+
+					//-----------------------------
+
+					sum_1 = _mm512_max_epi16(sum_1, sum_2);
+					sum_1 = _mm512_max_epi16(_mm512_permutex_epi64(sum_1, 8), _mm512_permutex_epi64(sum_1, 13));
+					sum_1 = _mm512_permutexvar_epi64(zmm_store_idx, sum_1);
+
+					_mm256_mask_storeu_epi64(pDst, pair ? 0x0F : 0x03, _mm512_castsi512_si256(sum_1));
+					pDst += REG_SIZE;
+				}
+				IACA__END
+			}
+		}
+		void CNNPP_v4::conv_3x3_lrelu_bn_max_avx512(float* __restrict dst, int dst_size_l, float* __restrict src, int src_size_l, int src_size_h, float* __restrict kernel, float* __restrict conv_b, float* __restrict lrelu_w1, float* __restrict lrelu_w2, float* __restrict bn_w, float* __restrict bn_b, size_t L, size_t H, int num_threads)
+		{
+			if (L == 0) L = src_size_l - 2;
+			if (H == 0) H = src_size_h - 2;
+
+			ALIGN(ALIGN_DEF) const int set1_mask[8] = { 0, 4, 6, 2, 1, 5, 7, 3 };
+			const __m256i ymm_mask0 = _mm256_load_si256((__m256i*)set1_mask);
+
+			const __m256i ymm_mask1 = _mm256_setr_epi8(2, 3, 0, 1, 6, 7, 4, 5, 10, 11, 8, 9, 14, 15, 12, 13, 2, 3, 0, 1, 6, 7, 4, 5, 10, 11, 8, 9, 14, 15, 12, 13);
+			const __m256i ymm_mask2 = _mm256_setr_epi8(128, 128, 4, 5, 2, 3, 128, 128, 128, 128, 12, 13, 10, 11, 128, 128, 128, 128, 4, 5, 2, 3, 128, 128, 128, 128, 12, 13, 10, 11, 128, 128);
+			const __m256i ymm_mask3 = _mm256_setr_epi8(0, 1, 8, 9, 2, 3, 10, 11, 4, 5, 12, 13, 6, 7, 14, 15, 0, 1, 8, 9, 2, 3, 10, 11, 4, 5, 12, 13, 6, 7, 14, 15);
+			const __m256i ymm_mask4 = _mm256_setr_epi8(0, 1, 8, 9, 12, 13, 4, 5, 2, 3, 10, 11, 14, 15, 6, 7, 0, 1, 8, 9, 12, 13, 4, 5, 2, 3, 10, 11, 14, 15, 6, 7);
+
+			const __m512i zmm_mask1 = broadcast_256(ymm_mask1);
+			const __m512i zmm_mask2 = broadcast_256(ymm_mask2);
+			const __m512i zmm_mask3 = broadcast_256(ymm_mask3);
+			const __m512i zmm_one = _mm512_set1_epi16(1);
+			const __m512i zmm_hadd_idx = _mm512_load_si512((const __m512i*)hadd_idx);
+			const __m512i zmm_lo_idx = _mm512_setr_epi64(0, 1, 8, 9, 4, 5, 12, 13);
+			const __m512i zmm_hi_idx = _mm512_setr_epi64(2, 3, 10, 11, 6, 7, 14, 15);
+
+			const __m256 ymm_toFxP_kernel = _mm256_set1_ps(toFxP / skt3);
+			const __m256 ymm_toFxP_conv_b = _mm256_set1_ps(toFxP / (fct * 2.f * skt3));
+			const __m256 ymm_toFxP_lrelu_w = _mm256_set1_ps(toFxP / (skt4));
+			const __m256 ymm_toFxP_bn_b = _mm256_set1_ps(toFxP / (fct * 2.f * 2.f * skt3 * skt4));
+
+			fct *= 2.f * 2.f * skt3 * skt4;
+
+			__m256i ymm_temp;
+			IACA__START
+			ymm_temp = FP2FxP_256(_mm256_load_ps(kernel + 0 * REG_SIZE), ymm_toFxP_kernel); __m256i ymm_k1 = _mm256_permutevar8x32_epi32(ymm_temp, ymm_mask0);
+			ymm_temp = FP2FxP_256(_mm256_load_ps(kernel + 1 * REG_SIZE), ymm_toFxP_kernel); __m256i ymm_k2 = _mm256_permutevar8x32_epi32(ymm_temp, ymm_mask0);
+			ymm_temp = FP2FxP_256(_mm256_load_ps(kernel + 2 * REG_SIZE), ymm_toFxP_kernel); __m256i ymm_k3 = _mm256_permutevar8x32_epi32(ymm_temp, ymm_mask0);
+			__m256i ymm_p1 = _mm256_hadd_epi16(ymm_k1, ymm_k2);
+			__m256i ymm_p2 = _mm256_hadd_epi16(ymm_k3, _mm256_setzero_si256());
+			const __m256i ymm_kp311 = _mm256_shuffle_epi8(_mm256_permute2x128_si256(ymm_p1, ymm_p2, 32), ymm_mask3);
+			const __m256i ymm_kp312 = _mm256_shuffle_epi8(_mm256_permute2x128_si256(ymm_p1, ymm_p2, 49), ymm_mask3);
+			ymm_temp = _mm256_shuffle_epi8(ymm_kp311, ymm_mask1);
+			const __m256i ymm_kp313 = _mm256_blend_epi16(ymm_temp, _mm256_permute2x128_si256(ymm_temp, ymm_temp, 1), 85);
+			ymm_temp = _mm256_shuffle_epi8(ymm_kp312, ymm_mask1);
+			const __m256i ymm_kp314 = _mm256_blend_epi16(ymm_temp, _mm256_permute2x128_si256(ymm_temp, ymm_temp, 1), 85);
+
+			ymm_temp = FP2FxP_256(_mm256_load_ps(kernel + 3 * REG_SIZE), ymm_toFxP_kernel); ymm_k1 = _mm256_permutevar8x32_epi32(ymm_temp, ymm_mask0);
+			ymm_temp = FP2FxP_256(_mm256_load_ps(kernel + 4 * REG_SIZE), ymm_toFxP_kernel); ymm_k2 = _mm256_permutevar8x32_epi32(ymm_temp, ymm_mask0);
+			ymm_temp = FP2FxP_256(_mm256_load_ps(kernel + 5 * REG_SIZE), ymm_toFxP_kernel); ymm_k3 = _mm256_permutevar8x32_epi32(ymm_temp, ymm_mask0);
+			ymm_p1 = _mm256_hadd_epi16(ymm_k1, ymm_k2);
+			ymm_p2 = _mm256_hadd_epi16(ymm_k3, _mm256_setzero_si256());
+			const __m256i ymm_kp321 = _mm256_shuffle_epi8(_mm256_permute2x128_si256(ymm_p1, ymm_p2, 32), ymm_mask3);
+			const __m256i ymm_kp322 = _mm256_shuffle_epi8(_mm256_permute2x128_si256(ymm_p1, ymm_p2, 49), ymm_mask3);
+			ymm_temp = _mm256_shuffle_epi8(ymm_kp321, ymm_mask1);
+			const __m256i ymm_kp323 = _mm256_blend_epi16(ymm_temp, _mm256_permute2x128_si256(ymm_temp, ymm_temp, 1), 85);
+			ymm_temp = _mm256_shuffle_epi8(ymm_kp322, ymm_mask1);
+			const __m256i ymm_kp324 = _mm256_blend_epi16(ymm_temp, _mm256_permute2x128_si256(ymm_temp, ymm_temp, 1), 85);
+
+			ymm_temp = FP2FxP_256(_mm256_load_ps(kernel + 6 * REG_SIZE), ymm_toFxP_kernel); ymm_k1 = _mm256_permutevar8x32_epi32(ymm_temp, ymm_mask0);
+			ymm_temp = FP2FxP_256(_mm256_load_ps(kernel + 7 * REG_SIZE), ymm_toFxP_kernel); ymm_k2 = _mm256_permutevar8x32_epi32(ymm_temp, ymm_mask0);
+			ymm_temp = FP2FxP_256(_mm256_load_ps(kernel + 8 * REG_SIZE), ymm_toFxP_kernel); ymm_k3 = _mm256_permutevar8x32_epi32(ymm_temp, ymm_mask0);
+			ymm_p1 = _mm256_hadd_epi16(ymm_k1, ymm_k2);
+			ymm_p2 = _mm256_hadd_epi16(ymm_k3, _mm256_setzero_si256());
+			const __m256i ymm_kp331 = _mm256_shuffle_epi8(_mm256_permute2x128_si256(ymm_p1, ymm_p2, 32), ymm_mask3);
+			const __m256i ymm_kp332 = _mm256_shuffle_epi8(_mm256_permute2x128_si256(ymm_p1, ymm_p2, 49), ymm_mask3);
+			ymm_temp = _mm256_shuffle_epi8(ymm_kp331, ymm_mask1);
+			const __m256i ymm_kp333 = _mm256_blend_epi16(ymm_temp, _mm256_permute2x128_si256(ymm_temp, ymm_temp, 1), 85);
+			ymm_temp = _mm256_shuffle_epi8(ymm_kp332, ymm_mask1);
+			const __m256i ymm_kp334 = _mm256_blend_epi16(ymm_temp, _mm256_permute2x128_si256(ymm_temp, ymm_temp, 1), 85);
+
+			const __m512i zmm_kp311 = broadcast_256(ymm_kp311);
+			const __m512i zmm_kp312 = broadcast_256(ymm_kp312);
+			const __m512i zmm_kp313 = broadcast_256(ymm_kp313);
+			const __m512i zmm_kp314 = broadcast_256(ymm_kp314);
+			const __m512i zmm_kp321 = broadcast_256(ymm_kp321);
+			const __m512i zmm_kp322 = broadcast_256(ymm_kp322);
+			const __m512i zmm_kp323 = broadcast_256(ymm_kp323);
+			const __m512i zmm_kp324 = broadcast_256(ymm_kp324);
+			const __m512i zmm_kp331 = broadcast_256(ymm_kp331);
+			const __m512i zmm_kp332 = broadcast_256(ymm_kp332);
+			const __m512i zmm_kp333 = broadcast_256(ymm_kp333);
+			const __m512i zmm_kp334 = broadcast_256(ymm_kp334);
+
+			ymm_temp = FP2FxP_256(_mm256_load_ps(conv_b), ymm_toFxP_conv_b);	const __m512i zmm_conv_b = broadcast_256(_mm256_shuffle_epi8(FxP_squeeze_256(ymm_temp), ymm_mask4));
+			ymm_temp = FP2FxP_256(_mm256_load_ps(lrelu_w1), ymm_toFxP_lrelu_w);	const __m512i zmm_lrelu_w1 = broadcast_256(_mm256_shuffle_epi8(FxP_squeeze_256(ymm_temp), ymm_mask4));
+			ymm_temp = FP2FxP_256(_mm256_load_ps(lrelu_w2), ymm_toFxP_lrelu_w);	const __m512i zmm_lrelu_w2 = broadcast_256(_mm256_shuffle_epi8(FxP_squeeze_256(ymm_temp), ymm_mask4));
+			ymm_temp = FP2FxP_256(_mm256_load_ps(bn_b), ymm_toFxP_bn_b);		const __m512i zmm_bn_b = broadcast_256(_mm256_shuffle_epi8(FxP_squeeze_256(ymm_temp), ymm_mask4));
+			IACA__END
+
+			OMP_PRAGMA(omp parallel for num_threads(num_threads))
+			for (int j = 0; j < H; ++j)
+			{
+				float* __restrict pSrc0 = src + j * src_size_l;
+				float* __restrict pSrc1 = src + (j + 1) * src_size_l;
+				float* __restrict pSrc2 = src + (j + 2) * src_size_l;
+
+				float* __restrict pDst = dst + j * dst_size_l;
+
+				IACA__START
+				for (size_t i = 0; i < L; i += 8)
+				{
+					//high half computes iteration i + 4 of AVX2 kernel
+					const __mmask8 mask = i + 4 < L ? 0xFF : 0x0F;
+
+					//0
+					__m512i zmm_d1 = _mm512_maskz_loadu_epi64(mask, pSrc0);
+					__m512i zmm_d2 = _mm512_maskz_loadu_epi64(mask, pSrc0 + REG_SIZE / 2);
+					pSrc0 += 2 * REG_SIZE;
+
+					__m512i zmm_s1 = _mm512_shuffle_epi8(zmm_d1, zmm_mask1);
+					__m512i zmm_a1 = _mm512_add_epi16(zmm_d1, zmm_s1);
+					zmm_s1 = _mm512_shuffle_epi8(zmm_d1, zmm_mask2);
+					zmm_a1 = _mm512_add_epi16(zmm_a1, zmm_s1);
+					zmm_a1 = _mm512_shuffle_epi8(zmm_a1, zmm_mask3);
+
+					__m512i zmm_s2 = _mm512_shuffle_epi8(zmm_d2, zmm_mask1);
+					__m512i zmm_a2 = _mm512_add_epi16(zmm_d2, zmm_s2);
+					zmm_s2 = _mm512_shuffle_epi8(zmm_d2, zmm_mask2);
+					zmm_a2 = _mm512_add_epi16(zmm_a2, zmm_s2);
+					zmm_a2 = _mm512_shuffle_epi8(zmm_a2, zmm_mask3);
+
+					__m512i zmm_r11 = _mm512_mulhrs_epi16(zmm_a1, zmm_kp311);
+					__m512i zmm_r12 = _mm512_mulhrs_epi16(zmm_a1, zmm_kp312);
+					__m512i zmm_r13 = _mm512_mulhrs_epi16(zmm_a2, zmm_kp311);
+					__m512i zmm_r14 = _mm512_mulhrs_epi16(zmm_a2, zmm_kp312);
+
+					__m512i zmm_r21 = _mm512_mulhrs_epi16(zmm_a1, zmm_kp313);
+					__m512i zmm_r22 = _mm512_mulhrs_epi16(zmm_a1, zmm_kp314);
+					__m512i zmm_r23 = _mm512_mulhrs_epi16(zmm_a2, zmm_kp313);
+					__m512i zmm_r24 = _mm512_mulhrs_epi16(zmm_a2, zmm_kp314);
+
+					//1
+					zmm_d1 = _mm512_maskz_loadu_epi64(mask, pSrc1);
+					zmm_d2 = _mm512_maskz_loadu_epi64(mask, pSrc1 + REG_SIZE / 2);
+					pSrc1 += 2 * REG_SIZE;
+
+					zmm_s1 = _mm512_shuffle_epi8(zmm_d1, zmm_mask1);
+					zmm_a1 = _mm512_add_epi16(zmm_d1, zmm_s1);
+					zmm_s1 = _mm512_shuffle_epi8(zmm_d1, zmm_mask2);
+					zmm_a1 = _mm512_add_epi16(zmm_a1, zmm_s1);
+					zmm_a1 = _mm512_shuffle_epi8(zmm_a1, zmm_mask3);
+
+					zmm_s2 = _mm512_shuffle_epi8(zmm_d2, zmm_mask1);
+					zmm_a2 = _mm512_add_epi16(zmm_d2, zmm_s2);
+					zmm_s2 = _mm512_shuffle_epi8(zmm_d2, zmm_mask2);
+					zmm_a2 = _mm512_add_epi16(zmm_a2, zmm_s2);
+					zmm_a2 = _mm512_shuffle_epi8(zmm_a2, zmm_mask3);
+
+					zmm_s1 = _mm512_mulhrs_epi16(zmm_a1, zmm_kp321);
+					zmm_r11 = _mm512_add_epi16(zmm_r11, zmm_s1);
+					zmm_s2 = _mm512_mulhrs_epi16(zmm_a1, zmm_kp322);
+					zmm_r12 = _mm512_add_epi16(zmm_r12, zmm_s2);
+					zmm_s1 = _mm512_mulhrs_epi16(zmm_a2, zmm_kp321);
+					zmm_r13 = _mm512_add_epi16(zmm_r13, zmm_s1);
+					zmm_s2 = _mm512_mulhrs_epi16(zmm_a2, zmm_kp322);
+					zmm_r14 = _mm512_add_epi16(zmm_r14, zmm_s2);
+
+					zmm_s1 = _mm512_mulhrs_epi16(zmm_a1, zmm_kp323);
+					zmm_r21 = _mm512_add_epi16(zmm_r21, zmm_s1);
+					zmm_s2 = _mm512_mulhrs_epi16(zmm_a1, zmm_kp324);
+					zmm_r22 = _mm512_add_epi16(zmm_r22, zmm_s2);
+					zmm_s1 = _mm512_mulhrs_epi16(zmm_a2, zmm_kp323);
+					zmm_r23 = _mm512_add_epi16(zmm_r23, zmm_s1);
+					zmm_s2 = _mm512_mulhrs_epi16(zmm_a2, zmm_kp324);
+					zmm_r24 = _mm512_add_epi16(zmm_r24, zmm_s2);
+
+					//2
+					zmm_d1 = _mm512_maskz_loadu_epi64(mask, pSrc2);
+					zmm_d2 = _mm512_maskz_loadu_epi64(mask, pSrc2 + REG_SIZE / 2);
+					pSrc2 += 2 * REG_SIZE;
+
+					zmm_s1 = _mm512_shuffle_epi8(zmm_d1, zmm_mask1);
+					zmm_a1 = _mm512_add_epi16(zmm_d1, zmm_s1);
+					zmm_s1 = _mm512_shuffle_epi8(zmm_d1, zmm_mask2);
+					zmm_a1 = _mm512_add_epi16(zmm_a1, zmm_s1);
+					zmm_a1 = _mm512_shuffle_epi8(zmm_a1, zmm_mask3);
+
+					zmm_s2 = _mm512_shuffle_epi8(zmm_d2, zmm_mask1);
+					zmm_a2 = _mm512_add_epi16(zmm_d2, zmm_s2);
+					zmm_s2 = _mm512_shuffle_epi8(zmm_d2, zmm_mask2);
+					zmm_a2 = _mm512_add_epi16(zmm_a2, zmm_s2);
+					zmm_a2 = _mm512_shuffle_epi8(zmm_a2, zmm_mask3);
+
+					zmm_s1 = _mm512_mulhrs_epi16(zmm_a1, zmm_kp331);
+					zmm_r11 = _mm512_add_epi16(zmm_r11, zmm_s1);
+					zmm_s2 = _mm512_mulhrs_epi16(zmm_a1, zmm_kp332);
+					zmm_r12 = _mm512_add_epi16(zmm_r12, zmm_s2);
+					zmm_s1 = _mm512_mulhrs_epi16(zmm_a2, zmm_kp331);
+					zmm_r13 = _mm512_add_epi16(zmm_r13, zmm_s1);
+					zmm_s2 = _mm512_mulhrs_epi16(zmm_a2, zmm_kp332);
+					zmm_r14 = _mm512_add_epi16(zmm_r14, zmm_s2);
+
+					zmm_s1 = _mm512_mulhrs_epi16(zmm_a1, zmm_kp333);
+					zmm_r21 = _mm512_add_epi16(zmm_r21, zmm_s1);
+					zmm_s2 = _mm512_mulhrs_epi16(zmm_a1, zmm_kp334);
+					zmm_r22 = _mm512_add_epi16(zmm_r22, zmm_s2);
+					zmm_s1 = _mm512_mulhrs_epi16(zmm_a2, zmm_kp333);
+					zmm_r23 = _mm512_add_epi16(zmm_r23, zmm_s1);
+					zmm_s2 = _mm512_mulhrs_epi16(zmm_a2, zmm_kp334);
+					zmm_r24 = _mm512_add_epi16(zmm_r24, zmm_s2);
+
+					//-----------------------------
+
+					zmm_r11 = hadd_epi16(zmm_r11, zmm_r12);
+					zmm_r13 = hadd_epi16(zmm_r13, zmm_r14);
+
+					zmm_s1 = _mm512_permutex2var_epi64(zmm_r11, zmm_lo_idx, zmm_r13);
+					zmm_s2 = _mm512_permutex2var_epi64(zmm_r11, zmm_hi_idx, zmm_r13);
+
+					zmm_r11 = _mm512_add_epi16(zmm_s1, zmm_s2);
+
+					zmm_r11 = _mm512_add_epi16(zmm_r11, zmm_conv_b);	
+					zmm_s1 = _mm512_max_epi16(zmm_r11, _mm512_setzero_si512());
+
+					zmm_s2 = _mm512_mulhrs_epi16(zmm_r11, zmm_lrelu_w1);		
+					zmm_r11 = _mm512_add_epi16(zmm_bn_b, zmm_s2);
+
+					zmm_s2 = _mm512_mulhrs_epi16(zmm_s1, zmm_lrelu_w2);
+					zmm_r11 = _mm512_add_epi16(zmm_r11, zmm_s2);
+
+					//-----------------------------
+
+					zmm_r21 = hadd_epi16(zmm_r21, zmm_r22);
+					zmm_r23 = hadd_epi16(zmm_r23, zmm_r24);
+
+					zmm_s1 = _mm512_permutex2var_epi64(zmm_r21, zmm_lo_idx, zmm_r23);
+					zmm_s2 = _mm512_permutex2var_epi64(zmm_r21, zmm_hi_idx, zmm_r23);
+
+					zmm_r21 = _mm512_add_epi16(zmm_s1, zmm_s2);
+
+					zmm_r21 = _mm512_add_epi16(zmm_r21, zmm_conv_b);
+					zmm_s1 = _mm512_max_epi16(zmm_r21, _mm512_setzero_si512());
+
+					zmm_s2 = _mm512_mulhrs_epi16(zmm_r21, zmm_lrelu_w1);			
+					zmm_r21 = _mm512_add_epi16(zmm_bn_b, zmm_s2);
+
+					zmm_s2 = _mm512_mulhrs_epi16(zmm_s1, zmm_lrelu_w2);
+					zmm_r21 = _mm512_add_epi16(zmm_r21, zmm_s2);
+
+					//-----------------------------
+
+					zmm_r11 = _mm512_max_epi16(zmm_r11, zmm_r21);
+
+					_mm512_mask_storeu_epi64(pDst, mask, zmm_r11);
+					pDst += 2 * REG_SIZE;
+				}
+				IACA__END
+			}
+		}
+		void CNNPP_v4::conv_5x4_lrelu_bn_avx512(float* __restrict dst, int dst_size_l, float* __restrict src, int src_size_l, int src_size_h, float* __restrict kernel, float* __restrict conv_b, float* __restrict lrelu_w1, float* __restrict lrelu_w2, float* __restrict bn_w, float* __restrict bn_b, size_t L, size_t H, int num_threads)
+		{
+			if (L == 0) L = src_size_l - 4;
+			if (H == 0) H = src_size_h - 5;
+
+			const __m256i ymm_mask0 = _mm256_setr_epi8(0, 1, 4, 5, 8, 9, 12, 13, 2, 3, 6, 7, 10, 11, 14, 15, 0, 1, 4, 5, 8, 9, 12, 13, 2, 3, 6, 7, 10, 11, 14, 15);
+			const __m512i zmm_mask1 = broadcast_256(_mm256_setr_epi8(128, 128, 0, 1, 2, 3, 4, 5, 10, 11, 12, 13, 14, 15, 128, 128, 128, 128, 0, 1, 2, 3, 4, 5, 10, 11, 12, 13, 14, 15, 128, 128));
+			const __m512i zmm_mask3 = broadcast_256(_mm256_setr_epi8(0, 1, 8, 9, 2, 3, 10, 11, 4, 5, 12, 13, 6, 7, 14, 15, 0, 1, 8, 9, 2, 3, 10, 11, 4, 5, 12, 13, 6, 7, 14, 15));
+
+			const __m256 ymm_toFxP_kernel = _mm256_set1_ps(toFxP / skt5);
+			const __m256 ymm_toFxP_conv_b = _mm256_set1_ps(toFxP / (fct * 2.f * skt5));
+			const __m256 ymm_toFxP_lrelu_w = _mm256_set1_ps(toFxP / skt6);
+			const __m256 ymm_toFxP_bn_b = _mm256_set1_ps(toFxP / (fct * 2.f * 2.f * skt5 * skt6));
+
+			fct *= 2.f * 2.f * skt5 * skt6;
+
+			__m512i zmm_k_1_0[5];
+			__m512i zmm_k_1_1[5];
+			__m512i zmm_k_1_2[5];
+			__m512i zmm_k_1_3[5];
+
+			for (size_t k = 0; k < 5; ++k)
+			{
+				zmm_k_1_0[k] = broadcast_256(_mm256_shuffle_epi8(FxP_squeeze_256(FP2FxP_256(_mm256_load_ps(kernel + (0 + 4 * k) * REG_SIZE), ymm_toFxP_kernel)), ymm_mask0));
+				zmm_k_1_1[k] = broadcast_256(_mm256_shuffle_epi8(FxP_squeeze_256(FP2FxP_256(_mm256_load_ps(kernel + (1 + 4 * k) * REG_SIZE), ymm_toFxP_kernel)), ymm_mask0));
+				zmm_k_1_2[k] = broadcast_256(_mm256_shuffle_epi8(FxP_squeeze_256(FP2FxP_256(_mm256_load_ps(kernel + (2 + 4 * k) * REG_SIZE), ymm_toFxP_kernel)), ymm_mask0));
+				zmm_k_1_3[k] = broadcast_256(_mm256_shuffle_epi8(FxP_squeeze_256(FP2FxP_256(_mm256_load_ps(kernel + (3 + 4 * k) * REG_SIZE), ymm_toFxP_kernel)), ymm_mask0));
+			}
+
+			__m512i zmm_k_2_0[5];
+			__m512i zmm_k_2_1[5];
+			__m512i zmm_k_2_2[5];
+			__m512i zmm_k_2_3[5];
+
+			kernel += 5 * 4 * REG_SIZE;
+			for (size_t k = 0; k < 5; ++k)
+			{
+				zmm_k_2_0[k] = broadcast_256(_mm256_shuffle_epi8(FxP_squeeze_256(FP2FxP_256(_mm256_load_ps(kernel + (0 + 4 * k) * REG_SIZE), ymm_toFxP_kernel)), ymm_mask0));
+				zmm_k_2_1[k] = broadcast_256(_mm256_shuffle_epi8(FxP_squeeze_256(FP2FxP_256(_mm256_load_ps(kernel + (1 + 4 * k) * REG_SIZE), ymm_toFxP_kernel)), ymm_mask0));
+				zmm_k_2_2[k] = broadcast_256(_mm256_shuffle_epi8(FxP_squeeze_256(FP2FxP_256(_mm256_load_ps(kernel + (2 + 4 * k) * REG_SIZE), ymm_toFxP_kernel)), ymm_mask0));
+				zmm_k_2_3[k] = broadcast_256(_mm256_shuffle_epi8(FxP_squeeze_256(FP2FxP_256(_mm256_load_ps(kernel + (3 + 4 * k) * REG_SIZE), ymm_toFxP_kernel)), ymm_mask0));
+			}
+
+			const __m256 _ymm_conv_b_1 = _mm256_load_ps(conv_b);
+			const __m256 _ymm_conv_b_2 = _mm256_load_ps(conv_b + REG_SIZE);
+			const __m256 _ymm_lrelu_w1_1 = _mm256_load_ps(lrelu_w1);
+			const __m256 _ymm_lrelu_w1_2 = _mm256_load_ps(lrelu_w1 + REG_SIZE);
+			const __m256 _ymm_lrelu_w2_1 = _mm256_load_ps(lrelu_w2);
+			const __m256 _ymm_lrelu_w2_2 = _mm256_load_ps(lrelu_w2 + REG_SIZE);
+			const __m256 _ymm_bn_b_1 = _mm256_load_ps(bn_b);
+			const __m256 _ymm_bn_b_2 = _mm256_load_ps(bn_b + REG_SIZE);
+
+			const __m512i zmm_conv_b_1 = broadcast_256(FxP_squeeze_256(FP2FxP_256(_ymm_conv_b_1, ymm_toFxP_conv_b)));
+			const __m512i zmm_conv_b_2 = broadcast_256(FxP_squeeze_256(FP2FxP_256(_ymm_conv_b_2, ymm_toFxP_conv_b)));
+			const __m512i zmm_lrelu_w1_1 = broadcast_256(FxP_squeeze_256(FP2FxP_256(_ymm_lrelu_w1_1, ymm_toFxP_lrelu_w)));
+			const __m512i zmm_lrelu_w1_2 = broadcast_256(FxP_squeeze_256(FP2FxP_256(_ymm_lrelu_w1_2, ymm_toFxP_lrelu_w)));
+			const __m512i zmm_lrelu_w2_1 = broadcast_256(FxP_squeeze_256(FP2FxP_256(_ymm_lrelu_w2_1, ymm_toFxP_lrelu_w)));
+			const __m512i zmm_lrelu_w2_2 = broadcast_256(FxP_squeeze_256(FP2FxP_256(_ymm_lrelu_w2_2, ymm_toFxP_lrelu_w)));
+			const __m512i zmm_bn_b_1 = broadcast_256(FxP_squeeze_256(FP2FxP_256(_ymm_bn_b_1, ymm_toFxP_bn_b)));
+			const __m512i zmm_bn_b_2 = broadcast_256(FxP_squeeze_256(FP2FxP_256(_ymm_bn_b_2, ymm_toFxP_bn_b)));
+
+			OMP_PRAGMA(omp parallel for num_threads(num_threads))
+			for (int j = 0; j < H; ++j)
+			{
+				float* __restrict pSrc = src + (j << 1) * src_size_l;
+				float* __restrict pDst = dst + j * dst_size_l;
+
+				IACA__START
+					for (size_t i = 0; i < L; i += 4)
+					{
+						//high half computes iteration i + 2 of AVX2 kernel
+						const bool pair = i + 2 < L;
+						const __mmask8 mask = pair ? 0xFF : 0x0F;
+
+						__m512i sum_1 = _mm512_setzero_si512();
+						__m512i sum_2 = _mm512_setzero_si512();
+
+#pragma unroll
+						for (size_t k = 0; k < 5; ++k)
+						{
+							float* __restrict pSrc_temp_1 = pSrc + (k << 1) * src_size_l;
+							float* __restrict pSrc_temp_2 = pSrc + ((k << 1) + 1) * src_size_l;
+							__m512i zmm_s1, zmm_s2;
+
+							//0
+							__m512i zmm_d1 = _mm512_maskz_loadu_epi64(mask, pSrc_temp_1);
+							__m512i zmm_d2 = _mm512_maskz_loadu_epi64(mask, pSrc_temp_2);
+							pSrc_temp_1 += REG_SIZE / 2;
+							pSrc_temp_2 += REG_SIZE / 2;
+							zmm_d1 = _mm512_max_epi16(zmm_d1, zmm_d2);
+							conv_block(k, 0);
+
+							//1
+							zmm_d1 = _mm512_maskz_loadu_epi64(mask, pSrc_temp_1);
+							zmm_d2 = _mm512_maskz_loadu_epi64(mask, pSrc_temp_2);
+							pSrc_temp_1 += REG_SIZE / 2;
+							pSrc_temp_2 += REG_SIZE / 2;
+							zmm_d1 = _mm512_max_epi16(zmm_d1, zmm_d2);
+							conv_block(k, 1);
+
+							//2
+							zmm_d1 = _mm512_maskz_loadu_epi64(mask, pSrc_temp_1);
+							zmm_d2 = _mm512_maskz_loadu_epi64(mask, pSrc_temp_2);
+							pSrc_temp_1 += REG_SIZE / 2;
+							pSrc_temp_2 += REG_SIZE / 2;
+							zmm_d1 = _mm512_max_epi16(zmm_d1, zmm_d2);
+							conv_block(k, 2);
+
+							//3
+							zmm_d1 = _mm512_maskz_loadu_epi64(mask, pSrc_temp_1);
+							zmm_d2 = _mm512_maskz_loadu_epi64(mask, pSrc_temp_2);
+							pSrc_temp_1 += REG_SIZE / 2;
+							pSrc_temp_2 += REG_SIZE / 2;
+							zmm_d1 = _mm512_max_epi16(zmm_d1, zmm_d2);
+							conv_block(k, 3);
+						}
+						pSrc += 2 * REG_SIZE;
+
+						//-----------------------------
+
+						sum_1 = _mm512_shuffle_epi8(sum_1, zmm_mask3);
+						sum_1 = _mm512_add_epi16(sum_1, zmm_conv_b_1);
+
+						__m512i zmm_d = _mm512_max_epi16(sum_1, _mm512_setzero_si512());
+						__m512i zmm_m = _mm512_mulhrs_epi16(sum_1, zmm_lrelu_w1_1); //loss of accuracy!
+						sum_1 = _mm512_add_epi16(zmm_bn_b_1, zmm_m);
+
+						zmm_m = _mm512_mulhrs_epi16(zmm_d, zmm_lrelu_w2_1);
+						sum_1 = _mm512_add_epi16(sum_1, zmm_m);
+
+						sum_2 = _mm512_shuffle_epi8(sum_2, zmm_mask3);
+						sum_2 = _mm512_add_epi16(sum_2, zmm_conv_b_2);
+
+						zmm_d = _mm512_max_epi16(sum_2, _mm512_setzero_si512());
+						zmm_m = _mm512_mulhrs_epi16(sum_2, zmm_lrelu_w1_2);
+						sum_2 = _mm512_add_epi16(zmm_bn_b_2, zmm_m);
+
+						zmm_m = _mm512_mulhrs_epi16(zmm_d, zmm_lrelu_w2_2);
+						sum_2 = _mm512_add_epi16(sum_2, zmm_m);
+
+						_mm512_storeu_si512(pDst, _mm512_shuffle_i64x2(sum_1, sum_2, 0x44));
+						if (pair) _mm512_storeu_si512(pDst + 2 * REG_SIZE, _mm512_shuffle_i64x2(sum_1, sum_2, 0xEE));
+						pDst += 4 * REG_SIZE;
+					}
+				IACA__END
+			}
+		}
+		void CNNPP_v4::mulCN_add_tanhW_add_avx512(float* __restrict dst, int dst_size_l, float* __restrict src, int src_size_l, int src_size_h, float** __restrict snn_hl_w, float** __restrict snn_hl_b, float* __restrict snn_tanh_w, float* __restrict snn_bn_w, float* __restrict snn_bn_b, float** __restrict snn_ol_w, size_t L, size_t H, int num_threads)
+		{
+			const __m512i zmm_mask_temp = _mm512_setr_epi32(1, 2, 3, 4, 5, 6, 7, 0, 9, 10, 11, 12, 13, 14, 15, 8);
+			const __m512i zmm_store_idx = _mm512_setr_epi32(0, 8, 0, 8, 0, 8, 0, 8, 0, 8, 0, 8, 0, 8, 0, 8);
+
+			const __m512 zmm_toFP_data = _mm512_set1_ps(fct * toFP);
+
+			__m512 zmm_hl_w[4][8];
+			for (size_t k = 0; k < 4; ++k)
+			{
+				for (size_t i = 0; i < 8; ++i)
+				{
+					zmm_hl_w[k][i] = _mm512_broadcast_f32x8(_mm256_load_ps(snn_hl_w[k] + i * REG_SIZE));
+					zmm_hl_w[k][i] = _mm512_mul_ps(zmm_hl_w[k][i], zmm_toFP_data);
+				}
+			}
+
+			__m512 zmm_tanh_w[2];
+			for (size_t i = 0; i < 2; ++i)
+			{
+				zmm_tanh_w[i] = _mm512_broadcast_f32x8(_mm256_load_ps(snn_tanh_w + i * REG_SIZE));
+			}
+
+			__m512 zmm_hl_b[4][2];
+			for (size_t k = 0; k < 4; ++k)
+			{
+				for (size_t i = 0; i < 2; ++i)
+				{
+					zmm_hl_b[k][i] = _mm512_broadcast_f32x8(_mm256_load_ps(snn_hl_b[k] + i * REG_SIZE));
+					zmm_hl_b[k][i] = _mm512_mul_ps(zmm_hl_b[k][i], zmm_tanh_w[i]);
+				}
+			}
+
+			__m512 zmm_bn_w[4];
+			for (size_t i = 0; i < 4; ++i)
+			{
+				zmm_bn_w[i] = _mm512_set1_ps(snn_bn_w[i]);
+			}
+
+			__m512 zmm_bn_b[4];
+			for (size_t i = 0; i < 4; ++i)
+			{
+				zmm_bn_b[i] = _mm512_set1_ps(snn_bn_b[i]);
+			}
+
+			__m512 zmm_ol_w[4][2];
+			for (size_t k = 0; k < 4; ++k)
+			{
+				for (size_t i = 0; i < 2; ++i)
+				{
+					zmm_ol_w[k][i] = _mm512_broadcast_f32x8(_mm256_load_ps(snn_ol_w[k] + i * REG_SIZE));
+				}
+			}
+
+			const float scale = 0.5f;
+			const Activation::tanh_tier tanh_f;
+			const __m512 zmm_scale = _mm512_set1_ps(scale);
+
+			OMP_PRAGMA(omp parallel for num_threads(num_threads))
+			for (int j = 0; j < H; ++j)
+			{
+				float* __restrict pSrc = src + j * src_size_l;
+				float* __restrict pDst = dst + j * dst_size_l;
+
+				IACA__START
+				for (size_t i = 0; i < L; i += 2)
+				{
+					//high half computes iteration i + 1 of AVX2 kernel
+					const bool pair = i + 1 < L;
+					const __mmask16 mask = pair ? 0xFFFF : 0x00FF;
+
+					__m512 zmm_0 = _mm512_cvtepi32_ps(_mm512_cvtepi16_epi32(_mm256_maskz_loadu_epi16(mask, pSrc)));
+					__m512 zmm_1 = _mm512_cvtepi32_ps(_mm512_cvtepi16_epi32(_mm256_maskz_loadu_epi16(mask, pSrc + REG_SIZE)));
+					pSrc += 2 * REG_SIZE;
+
+					__m512 zmm_sum = _mm512_setzero_ps();
+					for (size_t k = 0; k < 4; ++k)
+					{
+						__m512 zmm_s0 = _mm512_fmadd_ps(zmm_0, zmm_hl_w[k][0], _mm512_mul_ps(zmm_1, zmm_hl_w[k][1]));
+
+						__m512 zmm_0_shf = _mm512_permutexvar_ps(zmm_mask_temp, zmm_0);
+						__m512 zmm_s1 = _mm512_fmadd_ps(zmm_0_shf, zmm_hl_w[k][3], _mm512_mul_ps(zmm_1, zmm_hl_w[k][2]));
+
+						zmm_s0 = hadd_ps(zmm_s0, zmm_s1);
+
+						__m512 zmm_1_shf = _mm512_permutexvar_ps(zmm_mask_temp, zmm_1);
+						zmm_s1 = _mm512_fmadd_ps(zmm_0_shf, zmm_hl_w[k][4], _mm512_mul_ps(zmm_1_shf, zmm_hl_w[k][5]));
+
+						zmm_0_shf = _mm512_permutexvar_ps(zmm_mask_temp, zmm_0_shf);
+						zmm_0_shf = _mm512_fmadd_ps(zmm_0_shf, zmm_hl_w[k][7], _mm512_mul_ps(zmm_1_shf, zmm_hl_w[k][6]));
+
+						zmm_s1 = hadd_ps(zmm_s1, zmm_0_shf);
+
+						zmm_s0 = _mm512_fmadd_ps(zmm_s0, zmm_tanh_w[0], zmm_hl_b[k][0]);
+						zmm_s1 = _mm512_fmadd_ps(zmm_s1, zmm_tanh_w[1], zmm_hl_b[k][1]);
+
+						//------------------------------
+
+						zmm_s0 = tanh_f(zmm_s0);
+
+						//------------------------------
+
+						zmm_s1 = tanh_f(zmm_s1);
+
+						//------------------------------
+
+						zmm_s0 = _mm512_fmadd_ps(zmm_s0, zmm_scale, zmm_scale);
+						zmm_s0 = _mm512_fmadd_ps(zmm_s0, zmm_bn_w[k], zmm_bn_b[k]);
+
+						zmm_s1 = _mm512_fmadd_ps(zmm_s1, zmm_scale, zmm_scale);
+						zmm_s1 = _mm512_fmadd_ps(zmm_s1, zmm_bn_w[k], zmm_bn_b[k]);
+
+						//------------------------------
+
+						zmm_sum = _mm512_fmadd_ps(zmm_s0, zmm_ol_w[k][0], zmm_sum);
+						zmm_sum = _mm512_fmadd_ps(zmm_s1, zmm_ol_w[k][1], zmm_sum);
+					}
+
+					//------------------------------
+
+					zmm_1 = _mm512_shuffle_f32x4(zmm_sum, zmm_sum, 0xF5);
+					zmm_1 = _mm512_add_ps(zmm_sum, zmm_1);
+
+					zmm_0 = _mm512_permute_ps(zmm_1, 14);
+					zmm_1 = _mm512_add_ps(zmm_1, zmm_0);
+					zmm_0 = _mm512_permute_ps(zmm_1, 1);
+					zmm_1 = _mm512_add_ps(zmm_1, zmm_0);
+
+					//------------------------------
+
+					if (pair)
+					{
+						zmm_1 = _mm512_permutexvar_ps(zmm_store_idx, zmm_1);
+						_mm_storel_pi((__m64*)pDst, _mm512_castps512_ps128(zmm_1));
+						pDst += 2;
+					}
+					else
+					{
+						_mm_store_ss(pDst++, _mm512_castps512_ps128(zmm_1));
+					}
+				}
+				IACA__END
+			}
+		}
+		void CNNPP_v4::mulCN_add_tanhW_add_N_avx512(int N, float** __restrict dst_N, int dst_size_l, float* __restrict src, int src_size_l, int src_size_h, float** __restrict snn_hl_w, float** __restrict snn_hl_b, float* __restrict snn_tanh_w, float* __restrict snn_bn_w, float* __restrict snn_bn_b, float*** __restrict snn_ol_w_N, size_t L, size_t H, int num_threads)
+		{
+			const __m512i zmm_mask_temp = _mm512_setr_epi32(1, 2, 3, 4, 5, 6, 7, 0, 9, 10, 11, 12, 13, 14, 15, 8);
+			const __m512i zmm_store_idx = _mm512_setr_epi32(0, 8, 0, 8, 0, 8, 0, 8, 0, 8, 0, 8, 0, 8, 0, 8);
+
+			const __m512 zmm_toFP_data = _mm512_set1_ps(fct * toFP);
+
+			__m512 zmm_hl_w[4][8];
+			for (size_t k = 0; k < 4; ++k)
+			{
+				for (size_t i = 0; i < 8; ++i)
+				{
+					zmm_hl_w[k][i] = _mm512_broadcast_f32x8(_mm256_load_ps(snn_hl_w[k] + i * REG_SIZE));
+					zmm_hl_w[k][i] = _mm512_mul_ps(zmm_hl_w[k][i], zmm_toFP_data);
+				}
+			}
+
+			__m512 zmm_tanh_w[2];
+			for (size_t i = 0; i < 2; ++i)
+			{
+				zmm_tanh_w[i] = _mm512_broadcast_f32x8(_mm256_load_ps(snn_tanh_w + i * REG_SIZE));
+			}
+
+			__m512 zmm_hl_b[4][2];
+			for (size_t k = 0; k < 4; ++k)
+			{
+				for (size_t i = 0; i < 2; ++i)
+				{
+					zmm_hl_b[k][i] = _mm512_broadcast_f32x8(_mm256_load_ps(snn_hl_b[k] + i * REG_SIZE));
+					zmm_hl_b[k][i] = _mm512_mul_ps(zmm_hl_b[k][i], zmm_tanh_w[i]);
+				}
+			}
+
+			__m512 zmm_bn_w[4];
+			for (size_t i = 0; i < 4; ++i)
+			{
+				zmm_bn_w[i] = _mm512_set1_ps(snn_bn_w[i]);
+			}
+
+			__m512 zmm_bn_b[4];
+			for (size_t i = 0; i < 4; ++i)
+			{
+				zmm_bn_b[i] = _mm512_set1_ps(snn_bn_b[i]);
+			}
+
+			const float scale = 0.5f;
+			const Activation::tanh_tier tanh_f;
+			const __m512 zmm_scale = _mm512_set1_ps(scale);
+
+			OMP_PRAGMA(omp parallel for num_threads(num_threads))
+			for (int j = 0; j < H; ++j)
+			{
+				float* __restrict pSrc = src + j * src_size_l;
+
+				IACA__START
+				for (size_t i = 0; i < L; i += 2)
+				{
+					//high half computes iteration i + 1 of AVX2 kernel
+					const bool pair = i + 1 < L;
+					const __mmask16 mask = pair ? 0xFFFF : 0x00FF;
+
+					__m512 zmm_0 = _mm512_cvtepi32_ps(_mm512_cvtepi16_epi32(_mm256_maskz_loadu_epi16(mask, pSrc)));
+					__m512 zmm_1 = _mm512_cvtepi32_ps(_mm512_cvtepi16_epi32(_mm256_maskz_loadu_epi16(mask, pSrc + REG_SIZE)));
+					pSrc += 2 * REG_SIZE;
+
+					//hidden layer once, output layers of N neurons on it
+					__m512 zmm_hl[4][2];
+					for (size_t k = 0; k < 4; ++k)
+					{
+						__m512 zmm_s0 = _mm512_fmadd_ps(zmm_0, zmm_hl_w[k][0], _mm512_mul_ps(zmm_1, zmm_hl_w[k][1]));
+
+						__m512 zmm_0_shf = _mm512_permutexvar_ps(zmm_mask_temp, zmm_0);
+						__m512 zmm_s1 = _mm512_fmadd_ps(zmm_0_shf, zmm_hl_w[k][3], _mm512_mul_ps(zmm_1, zmm_hl_w[k][2]));
+
+						zmm_s0 = hadd_ps(zmm_s0, zmm_s1);
+
+						__m512 zmm_1_shf = _mm512_permutexvar_ps(zmm_mask_temp, zmm_1);
+						zmm_s1 = _mm512_fmadd_ps(zmm_0_shf, zmm_hl_w[k][4], _mm512_mul_ps(zmm_1_shf, zmm_hl_w[k][5]));
+
+						zmm_0_shf = _mm512_permutexvar_ps(zmm_mask_temp, zmm_0_shf);
+						zmm_0_shf = _mm512_fmadd_ps(zmm_0_shf, zmm_hl_w[k][7], _mm512_mul_ps(zmm_1_shf, zmm_hl_w[k][6]));
+
+						zmm_s1 = hadd_ps(zmm_s1, zmm_0_shf);
+
+						zmm_s0 = _mm512_fmadd_ps(zmm_s0, zmm_tanh_w[0], zmm_hl_b[k][0]);
+						zmm_s1 = _mm512_fmadd_ps(zmm_s1, zmm_tanh_w[1], zmm_hl_b[k][1]);
+
+						//------------------------------
+
+						zmm_s0 = tanh_f(zmm_s0);
+
+						//------------------------------
+
+						zmm_s1 = tanh_f(zmm_s1);
+
+						//------------------------------
+
+						zmm_s0 = _mm512_fmadd_ps(zmm_s0, zmm_scale, zmm_scale);
+						zmm_s0 = _mm512_fmadd_ps(zmm_s0, zmm_bn_w[k], zmm_bn_b[k]);
+
+						zmm_s1 = _mm512_fmadd_ps(zmm_s1, zmm_scale, zmm_scale);
+						zmm_s1 = _mm512_fmadd_ps(zmm_s1, zmm_bn_w[k], zmm_bn_b[k]);
+
+						zmm_hl[k][0] = zmm_s0;
+						zmm_hl[k][1] = zmm_s1;
+					}
+
+					for (int n = 0; n < N; ++n)
+					{
+						__m512 zmm_sum = _mm512_setzero_ps();
+						for (size_t k = 0; k < 4; ++k)
+						{
+							zmm_sum = _mm512_fmadd_ps(zmm_hl[k][0], _mm512_broadcast_f32x8(_mm256_load_ps(snn_ol_w_N[n][k])), zmm_sum);
+							zmm_sum = _mm512_fmadd_ps(zmm_hl[k][1], _mm512_broadcast_f32x8(_mm256_load_ps(snn_ol_w_N[n][k] + REG_SIZE)), zmm_sum);
+						}
+
+						//------------------------------
+
+						zmm_1 = _mm512_shuffle_f32x4(zmm_sum, zmm_sum, 0xF5);
+						zmm_1 = _mm512_add_ps(zmm_sum, zmm_1);
+
+						zmm_0 = _mm512_permute_ps(zmm_1, 14);
+						zmm_1 = _mm512_add_ps(zmm_1, zmm_0);
+						zmm_0 = _mm512_permute_ps(zmm_1, 1);
+						zmm_1 = _mm512_add_ps(zmm_1, zmm_0);
+
+						//------------------------------
+
+						float* pDst = dst_N[n] + j * dst_size_l + i;
+						if (pair)
+						{
+							zmm_1 = _mm512_permutexvar_ps(zmm_store_idx, zmm_1);
+							_mm_storel_pi((__m64*)pDst, _mm512_castps512_ps128(zmm_1));
+						}
+						else
+						{
+							_mm_store_ss(pDst, _mm512_castps512_ps128(zmm_1));
+						}
+					}
+				}
+				IACA__END
+			}
+		}
+		void CNNPP_v4::tanhW_avx512(float* __restrict dst, int dst_size_l, float* __restrict src, int src_size_l, int src_size_h, float* __restrict snn_ol_b, float* __restrict tanh_w, float* __restrict scale, size_t L, size_t H, int num_threads)
+		{
+			const Activation::tanh_tier tanh_f;
+			const __m512 zmm12 = _mm512_set1_ps(*snn_ol_b);
+			const __m512 zmm11 = _mm512_set1_ps(*scale);
+			const __m512 zmm10 = _mm512_set1_ps(*tanh_w);
+
+			OMP_PRAGMA(omp parallel for num_threads(num_threads))
+			for (int j = 0; j < H; ++j)
+			{
+				float* __restrict pSrc = src + j * src_size_l;
+				float* __restrict pDst = dst + j * dst_size_l;
+
+				IACA__START
+				for (size_t i = 0; i < L; i += 2 * REG_SIZE)
+				{
+					const __mmask16 mask = i + REG_SIZE < L ? 0xFFFF : 0x00FF;
+
+					__m512 zmm0 = _mm512_maskz_loadu_ps(mask, pSrc);
+					pSrc += 2 * REG_SIZE;
+
+					zmm0 = _mm512_add_ps(zmm0, zmm12);
+					zmm0 = _mm512_mul_ps(zmm0, zmm10);
+
+					__m512 zmm3 = tanh_f(zmm0);
+
+					zmm3 = _mm512_mul_ps(zmm3, zmm11);
+
+					_mm512_mask_storeu_ps(pDst, mask, zmm3);
+					pDst += 2 * REG_SIZE;
+				}
+				IACA__END
+			}
+		}
+
+		void Activation::transform_avx512(Function func, Tier tier, float* dst, const float* src, size_t size)
+		{
+			transform<__m512>(func, tier, dst, src, size);
+		}
+	}
+
+#endif
+}
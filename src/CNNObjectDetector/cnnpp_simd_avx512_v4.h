@@ -0,0 +1,122 @@
+/*
+*	Copyright (c) 2018, Ilya Kalinovskiy
+*	All rights reserved.
+*
+*	This is an implementation of the algorithm described in the following paper:
+*		I.A. Kalinovskiy, V.G. Spitsyn,
+*		Compact Convolutional Neural Network Cascade for Face Detection,
+*		http://arxiv.org/abs/1508.01292.
+*
+*	Redistribution and use of this program as source code or in binary form, with or without modifications, are permitted provided that the following conditions are met:
+*		1. Redistributions may not be sold, nor may they be used in a commercial product or activity without prior permission from the copyright holder (contact him at kua_21@mail.ru).
+*		2. Redistributions may not be used for military purposes.
+*		3. Any published work which utilizes this program shall include the reference to the paper available at http://arxiv.org/abs/1508.01292
+*		4. Redistributions must retain the above copyright notice and the reference to the algorithm on which the implementation is based on, this list of conditions and the following disclaimer.
+*
+*	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+*	IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#pragma once
+
+#include "config.h"
+#include "cnnpp_simd_avx_v3.h"
+
+#ifdef _MSC_VER
+#	include <intrin.h>
+#endif
+
+
+//========================================================================================================
+
+
+namespace NeuralNetworksLib
+{
+#if defined(USE_FIXED_POINT) && defined(USE_AVX512)
+
+	namespace SIMD
+	{
+		//AVX-512 BW version of CNNPP_v3 kernels, each 256 bit half of register computes one iteration of AVX2 kernel, so results are bit-exact;
+		//kernels are selected at runtime and fall back to CNNPP_v3 if cpu does not support AVX-512
+		class CNNPP_v4 : public CNNPP_v3
+		{
+		private:
+			static bool& enabled()
+			{
+				static bool enabled = isSupported();
+				return enabled;
+			}
+
+			void conv_4x4_lrelu_bn_max_avx512(float* __restrict dst, int dst_size_l, float* __restrict src, int src_size_l, int src_size_h, float* __restrict kernel, float* __restrict conv_b, float* __restrict lrelu_w1, float* __restrict lrelu_w2, float* __restrict bn_w, float* __restrict bn_b, size_t L, size_t H, int num_threads);
+			void conv_3x3_lrelu_bn_max_avx512(float* __restrict dst, int dst_size_l, float* __restrict src, int src_size_l, int src_size_h, float* __restrict kernel, float* __restrict conv_b, float* __restrict lrelu_w1, float* __restrict lrelu_w2, float* __restrict bn_w, float* __restrict bn_b, size_t L, size_t H, int num_threads);
+			void conv_5x4_lrelu_bn_avx512(float* __restrict dst, int dst_size_l, float* __restrict src, int src_size_l, int src_size_h, float* __restrict kernel, float* __restrict conv_b, float* __restrict lrelu_w1, float* __restrict lrelu_w2, float* __restrict bn_w, float* __restrict bn_b, size_t L, size_t H, int num_threads);
+			void mulCN_add_tanhW_add_avx512(float* __restrict dst, int dst_size_l, float* __restrict src, int src_size_l, int src_size_h, float** __restrict snn_hl_w, float** __restrict snn_hl_b, float* __restrict snn_tanh_w, float* __restrict snn_bn_w, float* __restrict snn_bn_b, float** __restrict snn_ol_w, size_t L, size_t H, int num_threads);
+			void mulCN_add_tanhW_add_N_avx512(int N, float** __restrict dst_N, int dst_size_l, float* __restrict src, int src_size_l, int src_size_h, float** __restrict snn_hl_w, float** __restrict snn_hl_b, float* __restrict snn_tanh_w, float* __restrict snn_bn_w, float* __restrict snn_bn_b, float*** __restrict snn_ol_w_N, size_t L, size_t H, int num_threads);
+			void tanhW_avx512(float* __restrict dst, int dst_size_l, float* __restrict src, int src_size_l, int src_size_h, float* __restrict snn_ol_b, float* __restrict tanh_w, float* __restrict scale, size_t L, size_t H, int num_threads);
+
+		public:
+			CNNPP_v4() { }
+			~CNNPP_v4() { }
+
+			//AVX-512 F/BW/VL/DQ support of cpu and os
+			static inline bool isSupported()
+			{
+#ifdef _MSC_VER
+				int info[4];
+				__cpuid(info, 0);
+				if (info[0] < 7) return false;
+				__cpuid(info, 1);
+				if ((info[2] & (1 << 27)) == 0 || (_xgetbv(0) & 0xE6) != 0xE6) return false;
+				__cpuidex(info, 7, 0);
+				const int bits = (1 << 16) | (1 << 17) | (1 << 30) | (1 << 31);
+				return (info[1] & bits) == bits;
+#else
+				__builtin_cpu_init();
+				return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw")
+					&& __builtin_cpu_supports("avx512vl") && __builtin_cpu_supports("avx512dq");
+#endif
+			}
+
+			//global switch of AVX-512 kernels (validation against AVX2 kernels), not thread safe
+			static inline bool isEnabled() { return enabled(); }
+			static inline void setEnabled(bool _enabled) { enabled() = _enabled && isSupported(); }
+
+			void conv_4x4_lrelu_bn_max(float* __restrict dst, int dst_size_l, float* __restrict src, int src_size_l, int src_size_h, float* __restrict kernel, float* __restrict conv_b, float* __restrict lrelu_w1, float* __restrict lrelu_w2, float* __restrict bn_w, float* __restrict bn_b, size_t L = 0, size_t H = 0, int num_threads = 1)
+			{
+				if (isEnabled()) conv_4x4_lrelu_bn_max_avx512(dst, dst_size_l, src, src_size_l, src_size_h, kernel, conv_b, lrelu_w1, lrelu_w2, bn_w, bn_b, L, H, num_threads);
+				else CNNPP_v3::conv_4x4_lrelu_bn_max(dst, dst_size_l, src, src_size_l, src_size_h, kernel, conv_b, lrelu_w1, lrelu_w2, bn_w, bn_b, L, H, num_threads);
+			}
+			void conv_3x3_lrelu_bn_max(float* __restrict dst, int dst_size_l, float* __restrict src, int src_size_l, int src_size_h, float* __restrict kernel, float* __restrict conv_b, float* __restrict lrelu_w1, float* __restrict lrelu_w2, float* __restrict bn_w, float* __restrict bn_b, size_t L = 0, size_t H = 0, int num_threads = 1)
+			{
+				if (isEnabled()) conv_3x3_lrelu_bn_max_avx512(dst, dst_size_l, src, src_size_l, src_size_h, kernel, conv_b, lrelu_w1, lrelu_w2, bn_w, bn_b, L, H, num_threads);
+				else CNNPP_v3::conv_3x3_lrelu_bn_max(dst, dst_size_l, src, src_size_l, src_size_h, kernel, conv_b, lrelu_w1, lrelu_w2, bn_w, bn_b, L, H, num_threads);
+			}
+			void conv_5x4_lrelu_bn(float* __restrict dst, int dst_size_l, float* __restrict src, int src_size_l, int src_size_h, float* __restrict kernel, float* __restrict conv_b, float* __restrict lrelu_w1, float* __restrict lrelu_w2, float* __restrict bn_w, float* __restrict bn_b, size_t L = 0, size_t H = 0, int num_threads = 1)
+			{
+				if (isEnabled()) conv_5x4_lrelu_bn_avx512(dst, dst_size_l, src, src_size_l, src_size_h, kernel, conv_b, lrelu_w1, lrelu_w2, bn_w, bn_b, L, H, num_threads);
+				else CNNPP_v3::conv_5x4_lrelu_bn(dst, dst_size_l, src, src_size_l, src_size_h, kernel, conv_b, lrelu_w1, lrelu_w2, bn_w, bn_b, L, H, num_threads);
+			}
+			void mulCN_add_tanhW_add(float* __restrict dst, int dst_size_l, float* __restrict src, int src_size_l, int src_size_h, float** __restrict snn_hl_w, float** __restrict snn_hl_b, float* __restrict snn_tanh_w, float* __restrict snn_bn_w, float* __restrict snn_bn_b, float** __restrict snn_ol_w, size_t L, size_t H, int num_threads = 1)
+			{
+				if (isEnabled()) mulCN_add_tanhW_add_avx512(dst, dst_size_l, src, src_size_l, src_size_h, snn_hl_w, snn_hl_b, snn_tanh_w, snn_bn_w, snn_bn_b, snn_ol_w, L, H, num_threads);
+				else CNNPP_v3::mulCN_add_tanhW_add(dst, dst_size_l, src, src_size_l, src_size_h, snn_hl_w, snn_hl_b, snn_tanh_w, snn_bn_w, snn_bn_b, snn_ol_w, L, H, num_threads);
+			}
+			void mulCN_add_tanhW_add_N(int N, float** __restrict dst_N, int dst_size_l, float* __restrict src, int src_size_l, int src_size_h, float** __restrict snn_hl_w, float** __restrict snn_hl_b, float* __restrict snn_tanh_w, float* __restrict snn_bn_w, float* __restrict snn_bn_b, float*** __restrict snn_ol_w_N, size_t L, size_t H, int num_threads = 1)
+			{
+				if (isEnabled()) mulCN_add_tanhW_add_N_avx512(N, dst_N, dst_size_l, src, src_size_l, src_size_h, snn_hl_w, snn_hl_b, snn_tanh_w, snn_bn_w, snn_bn_b, snn_ol_w_N, L, H, num_threads);
+				else CNNPP_v3::mulCN_add_tanhW_add_N(N, dst_N, dst_size_l, src, src_size_l, src_size_h, snn_hl_w, snn_hl_b, snn_tanh_w, snn_bn_w, snn_bn_b, snn_ol_w_N, L, H, num_threads);
+			}
+			void tanhW(float* __restrict dst, int dst_size_l, float* __restrict src, int src_size_l, int src_size_h, float* __restrict snn_ol_b, float* __restrict tanh_w, float* __restrict scale, size_t L, size_t H, int num_threads = 1)
+			{
+				if (isEnabled()) tanhW_avx512(dst, dst_size_l, src, src_size_l, src_size_h, snn_ol_b, tanh_w, scale, L, H, num_threads);
+				else CNNPP_v3::tanhW(dst, dst_size_l, src, src_size_l, src_size_h, snn_ol_b, tanh_w, scale, L, H, num_threads);
+			}
+
+			CNNPP_v4(const CNNPP_v4&) = delete;
+			CNNPP_v4& operator=(const CNNPP_v4&) = delete;
+		};
+	}
+
+#endif
+}
@@ -18,6 +18,7 @@
 */
 
 #include "cnnpp_simd_avx_v2.h"
+#include "activation_simd.h"
 #include <immintrin.h>
 
 //#define USE_IACA
@@ -62,6 +63,17 @@ namespace NeuralNetworksLib
 				ymm_ml = _mm256_mul_ps(ymm_d1, ymm_k_2_##id[k]);					\
 				sum_2 = _mm256_add_ps(ymm_ml, sum_2);					
 
+		//layer buffers of stage 1 hold fp16 values with USE_HF (F16C), REG_SIZE values take lb_step floats
+#ifndef USE_HF
+		#define lb_step REG_SIZE
+		#define lb_load(p) _mm256_load_ps(p)
+		#define lb_store(p, a) _mm256_store_ps(p, a)
+#else
+		#define lb_step (REG_SIZE / 2)
+		#define lb_load(p) _mm256_cvtph_ps(_mm_load_si128((__m128i*)(p)))
+		#define lb_store(p, a) _mm_store_si128((__m128i*)(p), _mm256_cvtps_ph(a, 0))
+#endif
+
 		void CNNPP_v2::conv_4x4(float* __restrict dst, int dst_size_l, float* __restrict src, int src_size_l, int src_size_h, float* __restrict kernel, size_t L, size_t H, int num_threads)
 		{
 			if (L == 0) L = src_size_l - 3;
@@ -703,8 +715,13 @@ namespace NeuralNetworksLib
 					ymm_d = _mm256_permute2f128_ps(sum, sum, 1);
 					sum = _mm256_max_ps(sum, ymm_d);
 
+#ifndef USE_HF
 					_mm_store_ps(pDst, _mm256_extractf128_ps(sum, 0));
 					pDst += REG_SIZE / 2;
+#else
+					_mm_storel_epi64((__m128i*)pDst, _mm_cvtps_ph(_mm256_extractf128_ps(sum, 0), 0));
+					pDst += REG_SIZE / 4;
+#endif
 				}
 				IACA__END
 
@@ -794,7 +811,11 @@ namespace NeuralNetworksLib
 
 					//-----------------------------
 
+#ifndef USE_HF
 					_mm_store_ps(pDst, _mm256_extractf128_ps(sum, 0));
+#else
+					_mm_storel_epi64((__m128i*)pDst, _mm_cvtps_ph(_mm256_extractf128_ps(sum, 0), 0));
+#endif
 				}
 			}
 		}
@@ -839,15 +860,15 @@ namespace NeuralNetworksLib
 				for (size_t i = 0; i <= L - 2; i += 2)
 				{
 					//0
-					__m256 ymm_d1 = _mm256_load_ps(pSrc0 + 0);
-					__m256 ymm_d2 = _mm256_load_ps(pSrc0 + REG_SIZE);
-					pSrc0 += REG_SIZE;
+					__m256 ymm_d1 = lb_load(pSrc0);
+					__m256 ymm_d2 = lb_load(pSrc0 + lb_step);
+					pSrc0 += lb_step;
 
 					//-----------------------------
 
-					__m256 ymm_d1_2 = _mm256_load_ps(pSrc0_2 + 0);
-					__m256 ymm_d2_2 = _mm256_load_ps(pSrc0_2 + REG_SIZE);
-					pSrc0_2 += REG_SIZE;
+					__m256 ymm_d1_2 = lb_load(pSrc0_2);
+					__m256 ymm_d2_2 = lb_load(pSrc0_2 + lb_step);
+					pSrc0_2 += lb_step;
 
 					ymm_d1 = _mm256_max_ps(ymm_d1, ymm_d1_2);
 					ymm_d2 = _mm256_max_ps(ymm_d2, ymm_d2_2);
@@ -877,15 +898,15 @@ namespace NeuralNetworksLib
 					sum_2 = _mm256_add_ps(_mm256_mul_ps(ymm_d2, ymm_k13), sum_2);
 
 					//1
-					ymm_d1 = _mm256_load_ps(pSrc1 + 0);
-					ymm_d2 = _mm256_load_ps(pSrc1 + REG_SIZE);
-					pSrc1 += REG_SIZE;
+					ymm_d1 = lb_load(pSrc1);
+					ymm_d2 = lb_load(pSrc1 + lb_step);
+					pSrc1 += lb_step;
 
 					//-----------------------------
 
-					ymm_d1_2 = _mm256_load_ps(pSrc1_2 + 0);
-					ymm_d2_2 = _mm256_load_ps(pSrc1_2 + REG_SIZE);
-					pSrc1_2 += REG_SIZE;
+					ymm_d1_2 = lb_load(pSrc1_2);
+					ymm_d2_2 = lb_load(pSrc1_2 + lb_step);
+					pSrc1_2 += lb_step;
 
 					ymm_d1 = _mm256_max_ps(ymm_d1, ymm_d1_2);
 					ymm_d2 = _mm256_max_ps(ymm_d2, ymm_d2_2);
@@ -915,15 +936,15 @@ namespace NeuralNetworksLib
 					sum_2 = _mm256_add_ps(_mm256_mul_ps(ymm_d2, ymm_k23), sum_2);
 
 					//2
-					ymm_d1 = _mm256_load_ps(pSrc2 + 0);
-					ymm_d2 = _mm256_load_ps(pSrc2 + REG_SIZE);
-					pSrc2 += REG_SIZE;
+					ymm_d1 = lb_load(pSrc2);
+					ymm_d2 = lb_load(pSrc2 + lb_step);
+					pSrc2 += lb_step;
 
 					//-----------------------------
 
-					ymm_d1_2 = _mm256_load_ps(pSrc2_2 + 0);
-					ymm_d2_2 = _mm256_load_ps(pSrc2_2 + REG_SIZE);
-					pSrc2_2 += REG_SIZE;
+					ymm_d1_2 = lb_load(pSrc2_2);
+					ymm_d2_2 = lb_load(pSrc2_2 + lb_step);
+					pSrc2_2 += lb_step;
 
 					ymm_d1 = _mm256_max_ps(ymm_d1, ymm_d1_2);
 					ymm_d2 = _mm256_max_ps(ymm_d2, ymm_d2_2);
@@ -980,16 +1001,16 @@ namespace NeuralNetworksLib
 					sum_1 = _mm256_permute2f128_ps(ymm_d2, ymm_d2, 1);
 					sum_1 = _mm256_blend_ps(sum_1, ymm_d2, 51);
 
-					_mm256_store_ps(pDst, sum_1);
-					pDst += REG_SIZE;
+					lb_store(pDst, sum_1);
+					pDst += lb_step;
 				}
 				IACA__END
 
 				if (L & 1)
 				{
 					//0
-					__m256 ymm_d1 = _mm256_load_ps(pSrc0 + 0);
-					__m256 ymm_d2 = _mm256_load_ps(pSrc0 + REG_SIZE);
+					__m256 ymm_d1 = lb_load(pSrc0);
+					__m256 ymm_d2 = lb_load(pSrc0 + lb_step);
 
 					__m256 ymm_d3 = _mm256_hadd_ps(ymm_d1, ymm_d2);
 
@@ -1009,8 +1030,8 @@ namespace NeuralNetworksLib
 					sum_1 = _mm256_add_ps(_mm256_mul_ps(ymm_d3, ymm_k13), sum_1);
 
 					//1
-					ymm_d1 = _mm256_load_ps(pSrc1 + 0);
-					ymm_d2 = _mm256_load_ps(pSrc1 + REG_SIZE);
+					ymm_d1 = lb_load(pSrc1);
+					ymm_d2 = lb_load(pSrc1 + lb_step);
 
 					ymm_d3 = _mm256_hadd_ps(ymm_d1, ymm_d2);
 
@@ -1030,8 +1051,8 @@ namespace NeuralNetworksLib
 					sum_1 = _mm256_add_ps(_mm256_mul_ps(ymm_d3, ymm_k23), sum_1);
 
 					//2
-					ymm_d1 = _mm256_load_ps(pSrc2 + 0);
-					ymm_d2 = _mm256_load_ps(pSrc2 + REG_SIZE);
+					ymm_d1 = lb_load(pSrc2);
+					ymm_d2 = lb_load(pSrc2 + lb_step);
 
 					ymm_d3 = _mm256_hadd_ps(ymm_d1, ymm_d2);
 
@@ -1067,7 +1088,7 @@ namespace NeuralNetworksLib
 					sum_1 = _mm256_permute2f128_ps(ymm_d2, ymm_d2, 1);
 					sum_1 = _mm256_blend_ps(sum_1, ymm_d2, 51);
 
-					_mm256_store_ps(pDst, sum_1);
+					lb_store(pDst, sum_1);
 				}
 			}
 		}
@@ -1133,38 +1154,38 @@ namespace NeuralNetworksLib
 						__m256 ymm_d1, ymm_d2, ymm_ml, ymm_shf;
 
 						//0
-						ymm_d1 = _mm256_load_ps(pSrc_temp_1);
-						ymm_d2 = _mm256_load_ps(pSrc_temp_2);
-						pSrc_temp_1 += REG_SIZE;
-						pSrc_temp_2 += REG_SIZE;
+						ymm_d1 = lb_load(pSrc_temp_1);
+						ymm_d2 = lb_load(pSrc_temp_2);
+						pSrc_temp_1 += lb_step;
+						pSrc_temp_2 += lb_step;
 						ymm_d1 = _mm256_max_ps(ymm_d1, ymm_d2);
 						conv_block(k, 0);
 
 						//1
-						ymm_d1 = _mm256_load_ps(pSrc_temp_1);
-						ymm_d2 = _mm256_load_ps(pSrc_temp_2);
-						pSrc_temp_1 += REG_SIZE;
-						pSrc_temp_2 += REG_SIZE;
+						ymm_d1 = lb_load(pSrc_temp_1);
+						ymm_d2 = lb_load(pSrc_temp_2);
+						pSrc_temp_1 += lb_step;
+						pSrc_temp_2 += lb_step;
 						ymm_d1 = _mm256_max_ps(ymm_d1, ymm_d2);
 						conv_block(k, 1);
 
 						//2
-						ymm_d1 = _mm256_load_ps(pSrc_temp_1);
-						ymm_d2 = _mm256_load_ps(pSrc_temp_2);
-						pSrc_temp_1 += REG_SIZE;
-						pSrc_temp_2 += REG_SIZE;
+						ymm_d1 = lb_load(pSrc_temp_1);
+						ymm_d2 = lb_load(pSrc_temp_2);
+						pSrc_temp_1 += lb_step;
+						pSrc_temp_2 += lb_step;
 						ymm_d1 = _mm256_max_ps(ymm_d1, ymm_d2);
 						conv_block(k, 2);
 
 						//3
-						ymm_d1 = _mm256_load_ps(pSrc_temp_1);
-						ymm_d2 = _mm256_load_ps(pSrc_temp_2);
-						pSrc_temp_1 += REG_SIZE;
-						pSrc_temp_2 += REG_SIZE;
+						ymm_d1 = lb_load(pSrc_temp_1);
+						ymm_d2 = lb_load(pSrc_temp_2);
+						pSrc_temp_1 += lb_step;
+						pSrc_temp_2 += lb_step;
 						ymm_d1 = _mm256_max_ps(ymm_d1, ymm_d2);
 						conv_block(k, 3);
 					}
-					pSrc += REG_SIZE;
+					pSrc += lb_step;
 
 					//-----------------------------
 
@@ -1188,9 +1209,9 @@ namespace NeuralNetworksLib
 
 					//-----------------------------
 
-					_mm256_store_ps(pDst, sum_1);
-					_mm256_store_ps(pDst + REG_SIZE, sum_2);
-					pDst += 2 * REG_SIZE;
+					lb_store(pDst, sum_1);
+					lb_store(pDst + lb_step, sum_2);
+					pDst += 2 * lb_step;
 				}
 				IACA__END
 			}
@@ -2852,6 +2873,181 @@ namespace NeuralNetworksLib
 
 #endif
 
+		//maps of 4 neighbouring pixels (ymm_d1, ymm_d2) to 8 channels of layer 2 and horizontal input transform of Winograd F(2, 3)
+		static inline void wino_3x3_row(__m256* __restrict h, __m256 ymm_d1, __m256 ymm_d2)
+		{
+			__m256 ymm_d3 = _mm256_hadd_ps(ymm_d1, ymm_d2);
+
+			__m256 ymm_d4 = _mm256_shuffle_ps(ymm_d1, ymm_d2, 153);
+			ymm_d4 = _mm256_shuffle_ps(ymm_d4, ymm_d4, 177);
+			ymm_d4 = _mm256_add_ps(ymm_d3, ymm_d4);
+
+			ymm_d1 = _mm256_permute2f128_ps(ymm_d3, ymm_d4, 32);
+			ymm_d2 = _mm256_permute2f128_ps(ymm_d4, ymm_d3, 19);
+
+			const __m256 ymm_c0 = _mm256_shuffle_ps(ymm_d1, ymm_d1, 80);
+			const __m256 ymm_c2 = _mm256_shuffle_ps(ymm_d1, ymm_d1, 250);
+			const __m256 ymm_c1 = _mm256_shuffle_ps(ymm_d2, ymm_d2, 80);
+			const __m256 ymm_c3 = _mm256_shuffle_ps(ymm_d2, ymm_d2, 250);
+
+			h[0] = _mm256_sub_ps(ymm_c0, ymm_c2);
+			h[1] = _mm256_add_ps(ymm_c1, ymm_c2);
+			h[2] = _mm256_sub_ps(ymm_c2, ymm_c1);
+			h[3] = _mm256_sub_ps(ymm_c1, ymm_c3);
+		}
+
+		void CNNPP_v2::conv_3x3_lrelu_bn_max_wino(float* __restrict dst, int dst_size_l, float* __restrict src, int src_size_l, int src_size_h, float* __restrict kernel, float* __restrict conv_b, float* __restrict lrelu_w1, float* __restrict lrelu_w2, float* __restrict bn_w, float* __restrict bn_b, size_t L, size_t H, int num_threads)
+		{
+			if (L == 0) L = src_size_l - 2;
+			if (H == 0) H = src_size_h - 2;
+
+			const __m256 ymm_conv_b = _mm256_load_ps(conv_b);
+			const __m256 ymm_lrelu_w1 = _mm256_load_ps(lrelu_w1);
+			const __m256 ymm_lrelu_w2 = _mm256_load_ps(lrelu_w2);
+			const __m256 ymm_bn_b = _mm256_load_ps(bn_b);
+			const __m256 ymm_zero = _mm256_setzero_ps();
+
+			//tile of 2 output rows and 2 output columns, columns are pooled
+			const int H2 = ((int)H + 1) >> 1;
+
+#ifndef USE_FMA
+			//input rows are pooled here
+			const int rows = src_size_h >> 1;
+#else
+			const int rows = src_size_h;
+#endif
+
+			OMP_PRAGMA(omp parallel for num_threads(num_threads))
+			for (int j2 = 0; j2 < H2; ++j2)
+			{
+				const int j = j2 << 1;
+
+				//last row of odd H: second output row of tiles is not stored
+				const bool row_2 = j + 1 < (int)H;
+
+				float* __restrict pSrc[4];
+				for (int r = 0; r < 4; ++r)
+				{
+					//first output row of tiles does not depend on last input row
+					const int y = j + r < rows ? j + r : j + 2;
+#ifndef USE_FMA
+					pSrc[r] = src + (y << 1) * src_size_l;
+#else
+					pSrc[r] = src + y * src_size_l;
+#endif
+				}
+
+				float* __restrict pDst0 = dst + j * dst_size_l;
+				float* __restrict pDst1 = pDst0 + dst_size_l;
+
+				for (size_t i = 0; i < L; i += 2)
+				{
+					__m256 ymm_h[4][4];
+					for (int r = 0; r < 4; ++r)
+					{
+#ifndef USE_FMA
+#ifndef USE_HF
+						const __m256 ymm_d1 = _mm256_max_ps(_mm256_load_ps(pSrc[r] + 4 * i), _mm256_load_ps(pSrc[r] + src_size_l + 4 * i));
+						const __m256 ymm_d2 = _mm256_max_ps(_mm256_load_ps(pSrc[r] + 4 * i + REG_SIZE), _mm256_load_ps(pSrc[r] + src_size_l + 4 * i + REG_SIZE));
+#else
+						const __m256 ymm_d1 = _mm256_max_ps(lb_load(pSrc[r] + 2 * i), lb_load(pSrc[r] + src_size_l + 2 * i));
+						const __m256 ymm_d2 = _mm256_max_ps(lb_load(pSrc[r] + 2 * i + lb_step), lb_load(pSrc[r] + src_size_l + 2 * i + lb_step));
+#endif
+#else
+#ifndef USE_HF
+						const __m256 ymm_d1 = _mm256_load_ps(pSrc[r] + 4 * i);
+						const __m256 ymm_d2 = _mm256_load_ps(pSrc[r] + 4 * i + REG_SIZE);
+#else
+						const __m256i load_si = _mm256_loadu_si256((__m256i*)(pSrc[r] + 2 * i));
+						const __m256 ymm_d1 = _mm256_cvtph_ps(_mm256_extracti128_si256(load_si, 0));
+						const __m256 ymm_d2 = _mm256_cvtph_ps(_mm256_extracti128_si256(load_si, 1));
+#endif
+#endif
+						wino_3x3_row(ymm_h[r], ymm_d1, ymm_d2);
+					}
+
+					__m256 ymm_t0[4];
+					__m256 ymm_t1[4];
+					for (int c = 0; c < 4; ++c)
+					{
+						const __m256 ymm_v0 = _mm256_sub_ps(ymm_h[0][c], ymm_h[2][c]);
+						const __m256 ymm_v1 = _mm256_add_ps(ymm_h[1][c], ymm_h[2][c]);
+						const __m256 ymm_v2 = _mm256_sub_ps(ymm_h[2][c], ymm_h[1][c]);
+						const __m256 ymm_v3 = _mm256_sub_ps(ymm_h[1][c], ymm_h[3][c]);
+
+						const __m256 ymm_k0 = _mm256_load_ps(kernel + (0 + c) * REG_SIZE);
+						const __m256 ymm_k1 = _mm256_load_ps(kernel + (4 + c) * REG_SIZE);
+						const __m256 ymm_k2 = _mm256_load_ps(kernel + (8 + c) * REG_SIZE);
+						const __m256 ymm_k3 = _mm256_load_ps(kernel + (12 + c) * REG_SIZE);
+
+#ifdef USE_FMA
+						ymm_t0[c] = _mm256_mul_ps(ymm_v0, ymm_k0);
+						ymm_t0[c] = _mm256_fmadd_ps(ymm_v1, ymm_k1, ymm_t0[c]);
+						ymm_t0[c] = _mm256_fmadd_ps(ymm_v2, ymm_k2, ymm_t0[c]);
+
+						ymm_t1[c] = _mm256_mul_ps(ymm_v1, ymm_k1);
+						ymm_t1[c] = _mm256_fnmadd_ps(ymm_v2, ymm_k2, ymm_t1[c]);
+						ymm_t1[c] = _mm256_fnmadd_ps(ymm_v3, ymm_k3, ymm_t1[c]);
+#else
+						const __m256 ymm_m1 = _mm256_mul_ps(ymm_v1, ymm_k1);
+						const __m256 ymm_m2 = _mm256_mul_ps(ymm_v2, ymm_k2);
+
+						ymm_t0[c] = _mm256_add_ps(_mm256_mul_ps(ymm_v0, ymm_k0), ymm_m1);
+						ymm_t0[c] = _mm256_add_ps(ymm_t0[c], ymm_m2);
+
+						ymm_t1[c] = _mm256_sub_ps(ymm_m1, ymm_m2);
+						ymm_t1[c] = _mm256_sub_ps(ymm_t1[c], _mm256_mul_ps(ymm_v3, ymm_k3));
+#endif
+					}
+
+					__m256 y[4];
+					y[0] = _mm256_add_ps(_mm256_add_ps(ymm_t0[0], ymm_t0[1]), ymm_t0[2]);
+					y[1] = _mm256_sub_ps(_mm256_sub_ps(ymm_t0[1], ymm_t0[2]), ymm_t0[3]);
+					y[2] = _mm256_add_ps(_mm256_add_ps(ymm_t1[0], ymm_t1[1]), ymm_t1[2]);
+					y[3] = _mm256_sub_ps(_mm256_sub_ps(ymm_t1[1], ymm_t1[2]), ymm_t1[3]);
+
+					//-----------------------------
+
+					for (int k = 0; k < 4; ++k)
+					{
+						y[k] = _mm256_add_ps(y[k], ymm_conv_b);
+						const __m256 ymm_relu = _mm256_max_ps(y[k], ymm_zero);
+
+#ifdef USE_FMA
+						y[k] = _mm256_fmadd_ps(y[k], ymm_lrelu_w1, ymm_bn_b);
+						y[k] = _mm256_fmadd_ps(ymm_relu, ymm_lrelu_w2, y[k]);
+#else
+						y[k] = _mm256_mul_ps(y[k], ymm_lrelu_w1);
+						y[k] = _mm256_add_ps(y[k], _mm256_mul_ps(ymm_relu, ymm_lrelu_w2));
+						y[k] = _mm256_add_ps(y[k], ymm_bn_b);
+#endif
+					}
+
+					//-----------------------------
+
+					//last column of odd L is not pooled
+					__m256 sum_1 = i + 1 < L ? _mm256_max_ps(y[0], y[1]) : y[0];
+					__m256 sum_2 = i + 1 < L ? _mm256_max_ps(y[2], y[3]) : y[2];
+
+					__m256 ymm_d2 = _mm256_castpd_ps(_mm256_shuffle_pd(_mm256_castps_pd(sum_1), _mm256_castps_pd(sum_1), 6));
+					sum_1 = _mm256_permute2f128_ps(ymm_d2, ymm_d2, 1);
+					sum_1 = _mm256_blend_ps(sum_1, ymm_d2, 51);
+
+					ymm_d2 = _mm256_castpd_ps(_mm256_shuffle_pd(_mm256_castps_pd(sum_2), _mm256_castps_pd(sum_2), 6));
+					sum_2 = _mm256_permute2f128_ps(ymm_d2, ymm_d2, 1);
+					sum_2 = _mm256_blend_ps(sum_2, ymm_d2, 51);
+
+#ifndef USE_HF
+					_mm256_store_ps(pDst0 + 4 * i, sum_1);
+					if (row_2) _mm256_store_ps(pDst1 + 4 * i, sum_2);
+#else
+					_mm_store_si128((__m128i*)(pDst0 + 2 * i), _mm256_cvtps_ph(sum_1, 0));
+					if (row_2) _mm_store_si128((__m128i*)(pDst1 + 2 * i), _mm256_cvtps_ph(sum_2, 0));
+#endif
+				}
+			}
+		}
+
 		void CNNPP_v2::max_tanh_tanh(float* __restrict dst, int dst_size_l, float* __restrict src, int src_size_l, int src_size_h, float* __restrict conv_b, float* __restrict subs_w, float* __restrict subs_b, float* __restrict scale, int num_threads)
 		{
 			const __m256 ymm14 = _mm256_broadcast_ss((float*)&abs_mask);
@@ -3253,9 +3449,7 @@ namespace NeuralNetworksLib
 			}
 
 			const float scale = 0.5f;
-			const __m256 ymm14 = _mm256_broadcast_ss((float*)&abs_mask);
-			const __m256 ymm15 = _mm256_broadcast_ss(&one);
-			const __m256 ymm13 = _mm256_broadcast_ss(&tanh_a);
+			const Activation::tanh_tier tanh_f;
 			const __m256 ymm_scale = _mm256_broadcast_ss(&scale);
 
 			OMP_PRAGMA(omp parallel for num_threads(num_threads))
@@ -3272,9 +3466,8 @@ namespace NeuralNetworksLib
 					__m256 ymm_1 = _mm256_load_ps(pSrc + REG_SIZE);
 					pSrc += 2 * REG_SIZE;
 #else
-					__m256i load_si = _mm256_loadu_si256((__m256i*)pSrc);
-					__m256 ymm_0 = _mm256_cvtph_ps(_mm256_extracti128_si256(load_si, 0));
-					__m256 ymm_1 = _mm256_cvtph_ps(_mm256_extracti128_si256(load_si, 1));
+					__m256 ymm_0 = _mm256_cvtph_ps(_mm_load_si128((__m128i*)pSrc));
+					__m256 ymm_1 = _mm256_cvtph_ps(_mm_load_si128((__m128i*)(pSrc + REG_SIZE / 2)));
 					pSrc += REG_SIZE;
 #endif
 
@@ -3282,7 +3475,6 @@ namespace NeuralNetworksLib
 					for (size_t k = 0; k < 4; ++k)
 					{
 #ifdef USE_FMA
-						__m256 ymm_0_w, ymm_1_w;
 						__m256 ymm_s0 = _mm256_fmadd_ps(ymm_0, ymm_hl_w[k][0], _mm256_mul_ps(ymm_1, ymm_hl_w[k][1]));
 
 						__m256 ymm_0_shf = _mm256_permutevar8x32_ps(ymm_0, ymm_mask_temp);
@@ -3334,57 +3526,11 @@ namespace NeuralNetworksLib
 
 						//------------------------------
 
-						ymm_0_w = _mm256_and_ps(ymm14, ymm_s0);
-						ymm_1_w = _mm256_add_ps(ymm15, ymm_0_w);
-						ymm_0_shf = _mm256_mul_ps(ymm_s0, ymm_s0);
-
-						ymm_1_w = _mm256_add_ps(ymm_1_w, ymm_0_shf);
-						ymm_0_shf = _mm256_mul_ps(ymm_0_shf, ymm_0_shf);
-
-#ifdef USE_FMA
-						ymm_1_w = _mm256_fmadd_ps(ymm_0_shf, ymm13, ymm_1_w);
-#else	
-						ymm_0_shf = _mm256_mul_ps(ymm_0_shf, ymm13);
-						ymm_1_w = _mm256_add_ps(ymm_1_w, ymm_0_shf);
-#endif
-
-						ymm_0_shf = _mm256_andnot_ps(ymm14, ymm_s0);
-
-#ifdef USE_FAST_DIV
-						ymm_1_w = _mm256_rcp_ps(ymm_1_w);
-#else
-						ymm_1_w = _mm256_div_ps(ymm15, ymm_1_w);
-#endif	
-
-						ymm_1_w = _mm256_sub_ps(ymm15, ymm_1_w);
-						ymm_s0 = _mm256_or_ps(ymm_1_w, ymm_0_shf);
+						ymm_s0 = tanh_f(ymm_s0);
 
 						//------------------------------
 
-						ymm_0_w = _mm256_and_ps(ymm14, ymm_s1);
-						ymm_1_w = _mm256_add_ps(ymm15, ymm_0_w);
-						ymm_0_shf = _mm256_mul_ps(ymm_s1, ymm_s1);
-
-						ymm_1_w = _mm256_add_ps(ymm_1_w, ymm_0_shf);
-						ymm_0_shf = _mm256_mul_ps(ymm_0_shf, ymm_0_shf);
-
-#ifdef USE_FMA
-						ymm_1_w = _mm256_fmadd_ps(ymm_0_shf, ymm13, ymm_1_w);
-#else	
-						ymm_0_shf = _mm256_mul_ps(ymm_0_shf, ymm13);
-						ymm_1_w = _mm256_add_ps(ymm_1_w, ymm_0_shf);
-#endif
-
-						ymm_0_shf = _mm256_andnot_ps(ymm14, ymm_s1);
-
-#ifdef USE_FAST_DIV
-						ymm_1_w = _mm256_rcp_ps(ymm_1_w);
-#else
-						ymm_1_w = _mm256_div_ps(ymm15, ymm_1_w);
-#endif	
-
-						ymm_1_w = _mm256_sub_ps(ymm15, ymm_1_w);
-						ymm_s1 = _mm256_or_ps(ymm_1_w, ymm_0_shf);
+						ymm_s1 = tanh_f(ymm_s1);
 
 						//------------------------------
 
@@ -3439,11 +3585,192 @@ namespace NeuralNetworksLib
 				IACA__END
 			}
 		}
+		void CNNPP_v2::mulCN_add_tanhW_add_N(int N, float** __restrict dst_N, int dst_size_l, float* __restrict src, int src_size_l, int src_size_h, float** __restrict snn_hl_w, float** __restrict snn_hl_b, float* __restrict snn_tanh_w, float* __restrict snn_bn_w, float* __restrict snn_bn_b, float*** __restrict snn_ol_w_N, size_t L, size_t H, int num_threads)
+		{
+			ALIGN(ALIGN_DEF) const int set1_mask[8] = { 1, 2, 3, 4, 5, 6, 7, 0 };
+			const __m256i ymm_mask_temp = _mm256_load_si256((__m256i*)set1_mask);
+
+			__m256 ymm_hl_w[4][8];
+			for (size_t k = 0; k < 4; ++k)
+			{
+				for (size_t i = 0; i < 8; ++i)
+				{
+					ymm_hl_w[k][i] = _mm256_load_ps(snn_hl_w[k] + i * REG_SIZE);
+				}
+			}
+
+			__m256 ymm_hl_b[4][2];
+			for (size_t k = 0; k < 4; ++k)
+			{
+				for (size_t i = 0; i < 2; ++i)
+				{
+					ymm_hl_b[k][i] = _mm256_load_ps(snn_hl_b[k] + i * REG_SIZE);
+				}
+			}
+
+			__m256 ymm_tanh_w[2];
+			for (size_t i = 0; i < 2; ++i)
+			{
+				ymm_tanh_w[i] = _mm256_load_ps(snn_tanh_w + i * REG_SIZE);
+			}
+
+			__m256 ymm_bn_w[4];
+			for (size_t i = 0; i < 4; ++i)
+			{
+				ymm_bn_w[i] = _mm256_broadcast_ss(&snn_bn_w[i]);
+			}
+
+			__m256 ymm_bn_b[4];
+			for (size_t i = 0; i < 4; ++i)
+			{
+				ymm_bn_b[i] = _mm256_broadcast_ss(&snn_bn_b[i]);
+			}
+
+			const float scale = 0.5f;
+			const Activation::tanh_tier tanh_f;
+			const __m256 ymm_scale = _mm256_broadcast_ss(&scale);
+
+			OMP_PRAGMA(omp parallel for num_threads(num_threads))
+			for (int j = 0; j < H; ++j)
+			{
+				float* __restrict pSrc = src + j * src_size_l;
+
+				IACA__START
+				for (size_t i = 0; i < L; ++i)
+				{
+#ifndef USE_HF
+					__m256 ymm_0 = _mm256_load_ps(pSrc);
+					__m256 ymm_1 = _mm256_load_ps(pSrc + REG_SIZE);
+					pSrc += 2 * REG_SIZE;
+#else
+					__m256 ymm_0 = _mm256_cvtph_ps(_mm_load_si128((__m128i*)pSrc));
+					__m256 ymm_1 = _mm256_cvtph_ps(_mm_load_si128((__m128i*)(pSrc + REG_SIZE / 2)));
+					pSrc += REG_SIZE;
+#endif
+
+					//hidden layer once, output layers of N neurons on it
+					__m256 ymm_hl[4][2];
+					for (size_t k = 0; k < 4; ++k)
+					{
+#ifdef USE_FMA
+						__m256 ymm_s0 = _mm256_fmadd_ps(ymm_0, ymm_hl_w[k][0], _mm256_mul_ps(ymm_1, ymm_hl_w[k][1]));
+
+						__m256 ymm_0_shf = _mm256_permutevar8x32_ps(ymm_0, ymm_mask_temp);
+						__m256 ymm_s1 = _mm256_fmadd_ps(ymm_0_shf, ymm_hl_w[k][3], _mm256_mul_ps(ymm_1, ymm_hl_w[k][2]));
+#else
+						__m256 ymm_0_w = _mm256_mul_ps(ymm_0, ymm_hl_w[k][0]);
+						__m256 ymm_1_w = _mm256_mul_ps(ymm_1, ymm_hl_w[k][1]);
+						__m256 ymm_s0 = _mm256_add_ps(ymm_0_w, ymm_1_w);
+
+						__m256 ymm_0_shf = _mm256_shuffle_ps(ymm_0, ymm_0, 57);
+						ymm_0_shf = _mm256_blend_ps(ymm_0_shf, _mm256_permute2f128_ps(ymm_0_shf, ymm_0_shf, 1), 136);
+
+						ymm_0_w = _mm256_mul_ps(ymm_0_shf, ymm_hl_w[k][3]);
+						ymm_1_w = _mm256_mul_ps(ymm_1, ymm_hl_w[k][2]);
+						__m256 ymm_s1 = _mm256_add_ps(ymm_0_w, ymm_1_w);
+#endif
+
+						ymm_s0 = _mm256_hadd_ps(ymm_s0, ymm_s1);
+
+#ifdef USE_FMA
+						__m256 ymm_1_shf = _mm256_permutevar8x32_ps(ymm_1, ymm_mask_temp);
+						ymm_s1 = _mm256_fmadd_ps(ymm_0_shf, ymm_hl_w[k][4], _mm256_mul_ps(ymm_1_shf, ymm_hl_w[k][5]));
+
+						ymm_0_shf = _mm256_permutevar8x32_ps(ymm_0_shf, ymm_mask_temp);
+						ymm_0_shf = _mm256_fmadd_ps(ymm_0_shf, ymm_hl_w[k][7], _mm256_mul_ps(ymm_1_shf, ymm_hl_w[k][6]));
+#else
+						__m256 ymm_1_shf = _mm256_shuffle_ps(ymm_1, ymm_1, 57);
+						ymm_1_shf = _mm256_blend_ps(ymm_1_shf, _mm256_permute2f128_ps(ymm_1_shf, ymm_1_shf, 1), 136);
+
+						ymm_0_w = _mm256_mul_ps(ymm_0_shf, ymm_hl_w[k][4]);
+						ymm_1_w = _mm256_mul_ps(ymm_1_shf, ymm_hl_w[k][5]);
+						ymm_s1 = _mm256_add_ps(ymm_0_w, ymm_1_w);
+
+						ymm_0_shf = _mm256_shuffle_ps(ymm_0_shf, ymm_0_shf, 57);
+						ymm_0_shf = _mm256_blend_ps(ymm_0_shf, _mm256_permute2f128_ps(ymm_0_shf, ymm_0_shf, 1), 136);
+
+						ymm_0_w = _mm256_mul_ps(ymm_0_shf, ymm_hl_w[k][7]);
+						ymm_1_w = _mm256_mul_ps(ymm_1_shf, ymm_hl_w[k][6]);
+						ymm_0_shf = _mm256_add_ps(ymm_0_w, ymm_1_w);
+#endif
+
+						ymm_s1 = _mm256_hadd_ps(ymm_s1, ymm_0_shf);
+
+						ymm_s0 = _mm256_add_ps(ymm_s0, ymm_hl_b[k][0]);
+						ymm_s1 = _mm256_add_ps(ymm_s1, ymm_hl_b[k][1]);
+
+						ymm_s0 = _mm256_mul_ps(ymm_s0, ymm_tanh_w[0]);
+						ymm_s1 = _mm256_mul_ps(ymm_s1, ymm_tanh_w[1]);
+
+						//------------------------------
+
+						ymm_s0 = tanh_f(ymm_s0);
+
+						//------------------------------
+
+						ymm_s1 = tanh_f(ymm_s1);
+
+						//------------------------------
+
+#ifdef USE_FMA
+						ymm_s0 = _mm256_fmadd_ps(ymm_s0, ymm_scale, ymm_scale);
+						ymm_s0 = _mm256_fmadd_ps(ymm_s0, ymm_bn_w[k], ymm_bn_b[k]);
+
+						ymm_s1 = _mm256_fmadd_ps(ymm_s1, ymm_scale, ymm_scale);
+						ymm_s1 = _mm256_fmadd_ps(ymm_s1, ymm_bn_w[k], ymm_bn_b[k]);
+#else
+						ymm_s0 = _mm256_mul_ps(ymm_s0, ymm_scale);
+						ymm_s0 = _mm256_add_ps(ymm_s0, ymm_scale);
+
+						ymm_s0 = _mm256_mul_ps(ymm_s0, ymm_bn_w[k]);
+						ymm_s0 = _mm256_add_ps(ymm_s0, ymm_bn_b[k]);
+
+						ymm_s1 = _mm256_mul_ps(ymm_s1, ymm_scale);
+						ymm_s1 = _mm256_add_ps(ymm_s1, ymm_scale);
+
+						ymm_s1 = _mm256_mul_ps(ymm_s1, ymm_bn_w[k]);
+						ymm_s1 = _mm256_add_ps(ymm_s1, ymm_bn_b[k]);
+#endif
+
+						ymm_hl[k][0] = ymm_s0;
+						ymm_hl[k][1] = ymm_s1;
+					}
+
+					for (int n = 0; n < N; ++n)
+					{
+						__m256 ymm_sum = _mm256_setzero_ps();
+						for (size_t k = 0; k < 4; ++k)
+						{
+#ifdef USE_FMA
+							ymm_sum = _mm256_fmadd_ps(ymm_hl[k][0], _mm256_load_ps(snn_ol_w_N[n][k]), ymm_sum);
+							ymm_sum = _mm256_fmadd_ps(ymm_hl[k][1], _mm256_load_ps(snn_ol_w_N[n][k] + REG_SIZE), ymm_sum);
+#else
+							ymm_sum = _mm256_add_ps(ymm_sum, _mm256_mul_ps(ymm_hl[k][0], _mm256_load_ps(snn_ol_w_N[n][k])));
+							ymm_sum = _mm256_add_ps(ymm_sum, _mm256_mul_ps(ymm_hl[k][1], _mm256_load_ps(snn_ol_w_N[n][k] + REG_SIZE)));
+#endif
+						}
+
+						//------------------------------
+
+						ymm_1 = _mm256_permute2f128_ps(ymm_sum, ymm_sum, 19);
+						ymm_1 = _mm256_add_ps(ymm_sum, ymm_1);
+
+						ymm_0 = _mm256_permute_ps(ymm_1, 14);
+						ymm_1 = _mm256_add_ps(ymm_1, ymm_0);
+						ymm_0 = _mm256_permute_ps(ymm_1, 1);
+						ymm_1 = _mm256_add_ps(ymm_1, ymm_0);
+
+						//------------------------------
+
+						_mm_store_ss(dst_N[n] + j * dst_size_l + i, _mm256_extractf128_ps(ymm_1, 0));
+					}
+				}
+				IACA__END
+			}
+		}
 		void CNNPP_v2::tanhW(float* __restrict dst, int dst_size_l, float* __restrict src, int src_size_l, int src_size_h, float* __restrict snn_ol_b, float* __restrict tanh_w, float* __restrict scale, size_t L, size_t H, int num_threads)
 		{
-			const __m256 ymm14 = _mm256_broadcast_ss((float*)&abs_mask);
-			const __m256 ymm15 = _mm256_broadcast_ss(&one);
-			const __m256 ymm13 = _mm256_broadcast_ss(&tanh_a);
+			const Activation::tanh_tier tanh_f;
 			const __m256 ymm12 = _mm256_broadcast_ss(snn_ol_b);
 			const __m256 ymm11 = _mm256_broadcast_ss(scale);
 			const __m256 ymm10 = _mm256_broadcast_ss(tanh_w);
@@ -3463,30 +3790,7 @@ namespace NeuralNetworksLib
 					ymm0 = _mm256_add_ps(ymm0, ymm12);
 					ymm0 = _mm256_mul_ps(ymm0, ymm10);
 
-					__m256 ymm1 = _mm256_and_ps(ymm14, ymm0);
-					__m256 ymm3 = _mm256_add_ps(ymm15, ymm1);
-					__m256 ymm4 = _mm256_mul_ps(ymm0, ymm0);
-
-					ymm3 = _mm256_add_ps(ymm3, ymm4);
-					__m256 ymm5 = _mm256_mul_ps(ymm4, ymm4);
-
-#ifdef USE_FMA
-					ymm3 = _mm256_fmadd_ps(ymm5, ymm13, ymm3);
-#else	
-					ymm5 = _mm256_mul_ps(ymm5, ymm13);
-					ymm3 = _mm256_add_ps(ymm3, ymm5);
-#endif
-
-					__m256 ymm2 = _mm256_andnot_ps(ymm14, ymm0);
-
-#ifdef USE_FAST_DIV
-					ymm3 = _mm256_rcp_ps(ymm3);
-#else
-					ymm3 = _mm256_div_ps(ymm15, ymm3);
-#endif	
-
-					ymm3 = _mm256_sub_ps(ymm15, ymm3);
-					ymm3 = _mm256_or_ps(ymm3, ymm2);
+					__m256 ymm3 = tanh_f(ymm0);
 
 					ymm3 = _mm256_mul_ps(ymm3, ymm11);
 
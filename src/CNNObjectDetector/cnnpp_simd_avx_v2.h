@@ -21,6 +21,7 @@
 #pragma once
 
 #include "config.h"
+#include <cstddef>
 
 
 //========================================================================================================
@@ -49,6 +50,8 @@ namespace NeuralNetworksLib
 
 			void conv_4x4_lrelu_bn_max(float* __restrict dst, int dst_size_l, float* __restrict src, int src_size_l, int src_size_h, float* __restrict kernel, float* __restrict conv_b, float* __restrict lrelu_w1, float* __restrict lrelu_w2, float* __restrict bn_w, float* __restrict bn_b, size_t L = 0, size_t H = 0, int num_threads = 1);
 			void conv_3x3_lrelu_bn_max(float* __restrict dst, int dst_size_l, float* __restrict src, int src_size_l, int src_size_h, float* __restrict kernel, float* __restrict conv_b, float* __restrict lrelu_w1, float* __restrict lrelu_w2, float* __restrict bn_w, float* __restrict bn_b, size_t L = 0, size_t H = 0, int num_threads = 1);
+			//Winograd F(2x2, 3x3) of conv_3x3_lrelu_bn_max, kernel is 4x4 transformed kernels G g G^T of 8 maps (ConvNeuralNetwork::WinogradKernel3x3)
+			void conv_3x3_lrelu_bn_max_wino(float* __restrict dst, int dst_size_l, float* __restrict src, int src_size_l, int src_size_h, float* __restrict kernel, float* __restrict conv_b, float* __restrict lrelu_w1, float* __restrict lrelu_w2, float* __restrict bn_w, float* __restrict bn_b, size_t L = 0, size_t H = 0, int num_threads = 1);
 			void conv_5x4_lrelu_bn(float* __restrict dst, int dst_size_l, float* __restrict src, int src_size_l, int src_size_h, float* __restrict kernel, float* __restrict conv_b, float* __restrict lrelu_w1, float* __restrict lrelu_w2, float* __restrict bn_w, float* __restrict bn_b, size_t L = 0, size_t H = 0, int num_threads = 1);
 
 			void max_tanh_tanh(float* __restrict dst, int dst_size_l, float* __restrict src, int src_size_l, int src_size_h, float* __restrict conv_b, float* __restrict subs_w, float* __restrict subs_b, float* __restrict scale, int num_threads = 1);
@@ -56,6 +59,8 @@ namespace NeuralNetworksLib
 			void tanh(float* __restrict dst, int dst_size_l, float* __restrict src, int src_size_l, int src_size_h, float* __restrict snn_ol_b, float* __restrict scale, int num_threads = 1);
 
 			void mulCN_add_tanhW_add(float* __restrict dst, int dst_size_l, float* __restrict src, int src_size_l, int src_size_h, float** __restrict snn_hl_w, float** __restrict snn_hl_b, float* __restrict snn_tanh_w, float* __restrict snn_bn_w, float* __restrict snn_bn_b, float** __restrict snn_ol_w, size_t L, size_t H, int num_threads = 1);
+			//hidden layer of mulCN_add_tanhW_add runs once, dst_N[n] gets output layer snn_ol_w_N[n] of N neurons
+			void mulCN_add_tanhW_add_N(int N, float** __restrict dst_N, int dst_size_l, float* __restrict src, int src_size_l, int src_size_h, float** __restrict snn_hl_w, float** __restrict snn_hl_b, float* __restrict snn_tanh_w, float* __restrict snn_bn_w, float* __restrict snn_bn_b, float*** __restrict snn_ol_w_N, size_t L, size_t H, int num_threads = 1);
 			void tanhW(float* __restrict dst, int dst_size_l, float* __restrict src, int src_size_l, int src_size_h, float* __restrict snn_ol_b, float* __restrict tanh_w, float* __restrict scale, size_t L, size_t H, int num_threads = 1);
 
 			CNNPP_v2(const CNNPP_v2&) = delete;
@@ -18,6 +18,7 @@
 */
 
 #include "cnnpp_simd_avx_v3.h"
+#include "activation_simd.h"
 #include <immintrin.h>
 
 //#define USE_IACA
@@ -66,11 +67,11 @@ namespace NeuralNetworksLib
 			if (H == 0) H = src_size_h - 3;
 			if (H & 1) H--;
 
-			const __m256i ymm_mask1 = { 0, 1, 0, 1, 0, 1, 0, 1, 128, 128, 128, 128, 128, 128, 128, 128, 4, 5, 4, 5, 4, 5, 4, 5, 128, 128, 128, 128, 128, 128, 128, 128 };
-			const __m256i ymm_mask2 = { 2, 3, 2, 3, 2, 3, 2, 3, 2, 3, 2, 3, 2, 3, 2, 3, 6, 7, 6, 7, 6, 7, 6, 7, 6, 7, 6, 7, 6, 7, 6, 7 };
-			const __m256i ymm_mask3 = { 4, 5, 4, 5, 4, 5, 4, 5, 4, 5, 4, 5, 4, 5, 4, 5, 8, 9, 8, 9, 8, 9, 8, 9, 8, 9, 8, 9, 8, 9, 8, 9 };
-			const __m256i ymm_mask4 = { 6, 7, 6, 7, 6, 7, 6, 7, 6, 7, 6, 7, 6, 7, 6, 7, 10, 11, 10, 11, 10, 11, 10, 11, 10, 11, 10, 11, 10, 11, 10, 11 };
-			const __m256i ymm_mask5 = { 128, 128, 128, 128, 128, 128, 128, 128, 8, 9, 8, 9, 8, 9, 8, 9, 128, 128, 128, 128, 128, 128, 128, 128, 12, 13, 12, 13, 12, 13, 12, 13 };
+			const __m256i ymm_mask1 = _mm256_setr_epi8(0, 1, 0, 1, 0, 1, 0, 1, 128, 128, 128, 128, 128, 128, 128, 128, 4, 5, 4, 5, 4, 5, 4, 5, 128, 128, 128, 128, 128, 128, 128, 128);
+			const __m256i ymm_mask2 = _mm256_setr_epi8(2, 3, 2, 3, 2, 3, 2, 3, 2, 3, 2, 3, 2, 3, 2, 3, 6, 7, 6, 7, 6, 7, 6, 7, 6, 7, 6, 7, 6, 7, 6, 7);
+			const __m256i ymm_mask3 = _mm256_setr_epi8(4, 5, 4, 5, 4, 5, 4, 5, 4, 5, 4, 5, 4, 5, 4, 5, 8, 9, 8, 9, 8, 9, 8, 9, 8, 9, 8, 9, 8, 9, 8, 9);
+			const __m256i ymm_mask4 = _mm256_setr_epi8(6, 7, 6, 7, 6, 7, 6, 7, 6, 7, 6, 7, 6, 7, 6, 7, 10, 11, 10, 11, 10, 11, 10, 11, 10, 11, 10, 11, 10, 11, 10, 11);
+			const __m256i ymm_mask5 = _mm256_setr_epi8(128, 128, 128, 128, 128, 128, 128, 128, 8, 9, 8, 9, 8, 9, 8, 9, 128, 128, 128, 128, 128, 128, 128, 128, 12, 13, 12, 13, 12, 13, 12, 13);
 
 			fct = 1.f;
 			const __m256 ymm_toFxP_data = _mm256_set1_ps(toFxP / scale_data);
@@ -318,10 +319,10 @@ namespace NeuralNetworksLib
 			ALIGN(ALIGN_DEF) const int set1_mask[8] = { 0, 4, 6, 2, 1, 5, 7, 3 };
 			const __m256i ymm_mask0 = _mm256_load_si256((__m256i*)set1_mask);
 
-			const __m256i ymm_mask1 = { 2, 3, 0, 1, 6, 7, 4, 5, 10, 11, 8, 9, 14, 15, 12, 13, 2, 3, 0, 1, 6, 7, 4, 5, 10, 11, 8, 9, 14, 15, 12, 13 };
-			const __m256i ymm_mask2 = { 128, 128, 4, 5, 2, 3, 128, 128, 128, 128, 12, 13, 10, 11, 128, 128, 128, 128, 4, 5, 2, 3, 128, 128, 128, 128, 12, 13, 10, 11, 128, 128 };
-			const __m256i ymm_mask3 = { 0, 1, 8, 9, 2, 3, 10, 11, 4, 5, 12, 13, 6, 7, 14, 15, 0, 1, 8, 9, 2, 3, 10, 11, 4, 5, 12, 13, 6, 7, 14, 15 };
-			const __m256i ymm_mask4 = { 0, 1, 8, 9, 12, 13, 4, 5, 2, 3, 10, 11, 14, 15, 6, 7, 0, 1, 8, 9, 12, 13, 4, 5, 2, 3, 10, 11, 14, 15, 6, 7 };
+			const __m256i ymm_mask1 = _mm256_setr_epi8(2, 3, 0, 1, 6, 7, 4, 5, 10, 11, 8, 9, 14, 15, 12, 13, 2, 3, 0, 1, 6, 7, 4, 5, 10, 11, 8, 9, 14, 15, 12, 13);
+			const __m256i ymm_mask2 = _mm256_setr_epi8(128, 128, 4, 5, 2, 3, 128, 128, 128, 128, 12, 13, 10, 11, 128, 128, 128, 128, 4, 5, 2, 3, 128, 128, 128, 128, 12, 13, 10, 11, 128, 128);
+			const __m256i ymm_mask3 = _mm256_setr_epi8(0, 1, 8, 9, 2, 3, 10, 11, 4, 5, 12, 13, 6, 7, 14, 15, 0, 1, 8, 9, 2, 3, 10, 11, 4, 5, 12, 13, 6, 7, 14, 15);
+			const __m256i ymm_mask4 = _mm256_setr_epi8(0, 1, 8, 9, 12, 13, 4, 5, 2, 3, 10, 11, 14, 15, 6, 7, 0, 1, 8, 9, 12, 13, 4, 5, 2, 3, 10, 11, 14, 15, 6, 7);
 
 			const __m256 ymm_toFxP_data = _mm256_set1_ps(toFxP / scale_data);
 			const __m256 ymm_toFxP_kernel = _mm256_set1_ps(toFxP / skt3);
@@ -604,9 +605,9 @@ namespace NeuralNetworksLib
 			if (L == 0) L = src_size_l - 4;
 			if (H == 0) H = src_size_h - 5;
 
-			const __m256i ymm_mask0 = { 0, 1, 4, 5, 8, 9, 12, 13, 2, 3, 6, 7, 10, 11, 14, 15, 0, 1, 4, 5, 8, 9, 12, 13, 2, 3, 6, 7, 10, 11, 14, 15 };
-			const __m256i ymm_mask1 = { 128, 128, 0, 1, 2, 3, 4, 5, 10, 11, 12, 13, 14, 15, 128, 128, 128, 128, 0, 1, 2, 3, 4, 5, 10, 11, 12, 13, 14, 15, 128, 128 };
-			const __m256i ymm_mask3 = { 0, 1, 8, 9, 2, 3, 10, 11, 4, 5, 12, 13, 6, 7, 14, 15, 0, 1, 8, 9, 2, 3, 10, 11, 4, 5, 12, 13, 6, 7, 14, 15 };
+			const __m256i ymm_mask0 = _mm256_setr_epi8(0, 1, 4, 5, 8, 9, 12, 13, 2, 3, 6, 7, 10, 11, 14, 15, 0, 1, 4, 5, 8, 9, 12, 13, 2, 3, 6, 7, 10, 11, 14, 15);
+			const __m256i ymm_mask1 = _mm256_setr_epi8(128, 128, 0, 1, 2, 3, 4, 5, 10, 11, 12, 13, 14, 15, 128, 128, 128, 128, 0, 1, 2, 3, 4, 5, 10, 11, 12, 13, 14, 15, 128, 128);
+			const __m256i ymm_mask3 = _mm256_setr_epi8(0, 1, 8, 9, 2, 3, 10, 11, 4, 5, 12, 13, 6, 7, 14, 15, 0, 1, 8, 9, 2, 3, 10, 11, 4, 5, 12, 13, 6, 7, 14, 15);
 			
 			const __m256 ymm_toFxP_data = _mm256_set1_ps(toFxP / scale_data);
 			const __m256 ymm_toFxP_kernel = _mm256_set1_ps(toFxP / skt5);
@@ -858,9 +859,7 @@ namespace NeuralNetworksLib
 			}
 
 			const float scale = 0.5f;
-			const __m256 ymm14 = _mm256_broadcast_ss((float*)&abs_mask);
-			const __m256 ymm15 = _mm256_broadcast_ss(&one);
-			const __m256 ymm13 = _mm256_broadcast_ss(&tanh_a);
+			const Activation::tanh_tier tanh_f;
 			const __m256 ymm_scale = _mm256_broadcast_ss(&scale);
 
 			OMP_PRAGMA(omp parallel for num_threads(num_threads))
@@ -892,7 +891,6 @@ namespace NeuralNetworksLib
 					__m256 ymm_sum = _mm256_setzero_ps();
 					for (size_t k = 0; k < 4; ++k)
 					{
-						__m256 ymm_0_w, ymm_1_w;
 						__m256 ymm_s0 = _mm256_fmadd_ps(ymm_0, ymm_hl_w[k][0], _mm256_mul_ps(ymm_1, ymm_hl_w[k][1]));
 
 						__m256 ymm_0_shf = _mm256_permutevar8x32_ps(ymm_0, ymm_mask_temp);
@@ -913,47 +911,11 @@ namespace NeuralNetworksLib
 
 						//------------------------------
 
-						ymm_0_w = _mm256_and_ps(ymm14, ymm_s0);
-						ymm_1_w = _mm256_add_ps(ymm15, ymm_0_w);
-						ymm_0_shf = _mm256_mul_ps(ymm_s0, ymm_s0);
-
-						ymm_1_w = _mm256_add_ps(ymm_1_w, ymm_0_shf);
-						ymm_0_shf = _mm256_mul_ps(ymm_0_shf, ymm_0_shf);
-
-						ymm_1_w = _mm256_fmadd_ps(ymm_0_shf, ymm13, ymm_1_w);
-
-						ymm_0_shf = _mm256_andnot_ps(ymm14, ymm_s0);
-
-#ifdef USE_FAST_DIV
-						ymm_1_w = _mm256_rcp_ps(ymm_1_w);
-#else
-						ymm_1_w = _mm256_div_ps(ymm15, ymm_1_w);
-#endif	
-
-						ymm_1_w = _mm256_sub_ps(ymm15, ymm_1_w);
-						ymm_s0 = _mm256_or_ps(ymm_1_w, ymm_0_shf);
+						ymm_s0 = tanh_f(ymm_s0);
 
 						//------------------------------
 
-						ymm_0_w = _mm256_and_ps(ymm14, ymm_s1);
-						ymm_1_w = _mm256_add_ps(ymm15, ymm_0_w);
-						ymm_0_shf = _mm256_mul_ps(ymm_s1, ymm_s1);
-
-						ymm_1_w = _mm256_add_ps(ymm_1_w, ymm_0_shf);
-						ymm_0_shf = _mm256_mul_ps(ymm_0_shf, ymm_0_shf);
-
-						ymm_1_w = _mm256_fmadd_ps(ymm_0_shf, ymm13, ymm_1_w);
-
-						ymm_0_shf = _mm256_andnot_ps(ymm14, ymm_s1);
-
-#ifdef USE_FAST_DIV
-						ymm_1_w = _mm256_rcp_ps(ymm_1_w);
-#else
-						ymm_1_w = _mm256_div_ps(ymm15, ymm_1_w);
-#endif	
-
-						ymm_1_w = _mm256_sub_ps(ymm15, ymm_1_w);
-						ymm_s1 = _mm256_or_ps(ymm_1_w, ymm_0_shf);
+						ymm_s1 = tanh_f(ymm_s1);
 
 						//------------------------------
 
@@ -986,11 +948,152 @@ namespace NeuralNetworksLib
 				IACA__END
 			}
 		}
+		void CNNPP_v3::mulCN_add_tanhW_add_N(int N, float** __restrict dst_N, int dst_size_l, float* __restrict src, int src_size_l, int src_size_h, float** __restrict snn_hl_w, float** __restrict snn_hl_b, float* __restrict snn_tanh_w, float* __restrict snn_bn_w, float* __restrict snn_bn_b, float*** __restrict snn_ol_w_N, size_t L, size_t H, int num_threads)
+		{
+			ALIGN(ALIGN_DEF) const int set1_mask[8] = { 1, 2, 3, 4, 5, 6, 7, 0 };
+			const __m256i ymm_mask_temp = _mm256_load_si256((__m256i*)set1_mask);
+
+			const __m256 ymm_toFP_data = _mm256_set1_ps(fct * toFP);
+
+			__m256 ymm_hl_w[4][8];
+			for (size_t k = 0; k < 4; ++k)
+			{
+				for (size_t i = 0; i < 8; ++i)
+				{
+					ymm_hl_w[k][i] = _mm256_load_ps(snn_hl_w[k] + i * REG_SIZE);
+					ymm_hl_w[k][i] = _mm256_mul_ps(ymm_hl_w[k][i], ymm_toFP_data);
+				}
+			}
+
+			__m256 ymm_tanh_w[2];
+			for (size_t i = 0; i < 2; ++i)
+			{
+				ymm_tanh_w[i] = _mm256_load_ps(snn_tanh_w + i * REG_SIZE);
+			}
+
+			__m256 ymm_hl_b[4][2];
+			for (size_t k = 0; k < 4; ++k)
+			{
+				for (size_t i = 0; i < 2; ++i)
+				{
+					ymm_hl_b[k][i] = _mm256_load_ps(snn_hl_b[k] + i * REG_SIZE);
+					ymm_hl_b[k][i] = _mm256_mul_ps(ymm_hl_b[k][i], ymm_tanh_w[i]);
+				}
+			}
+
+			__m256 ymm_bn_w[4];
+			for (size_t i = 0; i < 4; ++i)
+			{
+				ymm_bn_w[i] = _mm256_broadcast_ss(&snn_bn_w[i]);
+			}
+
+			__m256 ymm_bn_b[4];
+			for (size_t i = 0; i < 4; ++i)
+			{
+				ymm_bn_b[i] = _mm256_broadcast_ss(&snn_bn_b[i]);
+			}
+
+			const float scale = 0.5f;
+			const Activation::tanh_tier tanh_f;
+			const __m256 ymm_scale = _mm256_broadcast_ss(&scale);
+
+			OMP_PRAGMA(omp parallel for num_threads(num_threads))
+			for (int j = 0; j < H; ++j)
+			{
+				float* __restrict pSrc = src + j * src_size_l;
+
+				IACA__START
+				for (size_t i = 0; i < L; ++i)
+				{
+					__m256 ymm_0, ymm_1;
+					if (i & 1)
+					{
+						ymm_0 = _mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(_mm_loadu_si128((__m128i*)(pSrc + REG_SIZE / 2))));
+						ymm_1 = _mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(_mm_loadu_si128((__m128i*)(pSrc + 3 * REG_SIZE / 2))));
+						pSrc += 2 * REG_SIZE;
+					}
+					else
+					{
+						ymm_0 = _mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(_mm_loadu_si128((__m128i*)pSrc)));
+						ymm_1 = _mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(_mm_loadu_si128((__m128i*)(pSrc + REG_SIZE))));
+					}
+
+					//__m256 ymm_0 = _mm256_loadu_ps(pSrc);
+					//__m256 ymm_1 = _mm256_loadu_ps(pSrc + REG_SIZE);
+					//pSrc += 2 * REG_SIZE;
+
+					//hidden layer once, output layers of N neurons on it
+					__m256 ymm_hl[4][2];
+					for (size_t k = 0; k < 4; ++k)
+					{
+						__m256 ymm_s0 = _mm256_fmadd_ps(ymm_0, ymm_hl_w[k][0], _mm256_mul_ps(ymm_1, ymm_hl_w[k][1]));
+
+						__m256 ymm_0_shf = _mm256_permutevar8x32_ps(ymm_0, ymm_mask_temp);
+						__m256 ymm_s1 = _mm256_fmadd_ps(ymm_0_shf, ymm_hl_w[k][3], _mm256_mul_ps(ymm_1, ymm_hl_w[k][2]));
+
+						ymm_s0 = _mm256_hadd_ps(ymm_s0, ymm_s1);
+
+						__m256 ymm_1_shf = _mm256_permutevar8x32_ps(ymm_1, ymm_mask_temp);
+						ymm_s1 = _mm256_fmadd_ps(ymm_0_shf, ymm_hl_w[k][4], _mm256_mul_ps(ymm_1_shf, ymm_hl_w[k][5]));
+
+						ymm_0_shf = _mm256_permutevar8x32_ps(ymm_0_shf, ymm_mask_temp);
+						ymm_0_shf = _mm256_fmadd_ps(ymm_0_shf, ymm_hl_w[k][7], _mm256_mul_ps(ymm_1_shf, ymm_hl_w[k][6]));
+
+						ymm_s1 = _mm256_hadd_ps(ymm_s1, ymm_0_shf);
+
+						ymm_s0 = _mm256_fmadd_ps(ymm_s0, ymm_tanh_w[0], ymm_hl_b[k][0]);
+						ymm_s1 = _mm256_fmadd_ps(ymm_s1, ymm_tanh_w[1], ymm_hl_b[k][1]);
+
+						//------------------------------
+
+						ymm_s0 = tanh_f(ymm_s0);
+
+						//------------------------------
+
+						ymm_s1 = tanh_f(ymm_s1);
+
+						//------------------------------
+
+						ymm_s0 = _mm256_fmadd_ps(ymm_s0, ymm_scale, ymm_scale);
+						ymm_s0 = _mm256_fmadd_ps(ymm_s0, ymm_bn_w[k], ymm_bn_b[k]);
+
+						ymm_s1 = _mm256_fmadd_ps(ymm_s1, ymm_scale, ymm_scale);
+						ymm_s1 = _mm256_fmadd_ps(ymm_s1, ymm_bn_w[k], ymm_bn_b[k]);
+
+						ymm_hl[k][0] = ymm_s0;
+						ymm_hl[k][1] = ymm_s1;
+					}
+
+					for (int n = 0; n < N; ++n)
+					{
+						__m256 ymm_sum = _mm256_setzero_ps();
+						for (size_t k = 0; k < 4; ++k)
+						{
+							ymm_sum = _mm256_fmadd_ps(ymm_hl[k][0], _mm256_load_ps(snn_ol_w_N[n][k]), ymm_sum);
+							ymm_sum = _mm256_fmadd_ps(ymm_hl[k][1], _mm256_load_ps(snn_ol_w_N[n][k] + REG_SIZE), ymm_sum);
+						}
+
+						//------------------------------
+
+						ymm_1 = _mm256_permute2f128_ps(ymm_sum, ymm_sum, 19);
+						ymm_1 = _mm256_add_ps(ymm_sum, ymm_1);
+
+						ymm_0 = _mm256_permute_ps(ymm_1, 14);
+						ymm_1 = _mm256_add_ps(ymm_1, ymm_0);
+						ymm_0 = _mm256_permute_ps(ymm_1, 1);
+						ymm_1 = _mm256_add_ps(ymm_1, ymm_0);
+
+						//------------------------------
+
+						_mm_store_ss(dst_N[n] + j * dst_size_l + i, _mm256_extractf128_ps(ymm_1, 0));
+					}
+				}
+				IACA__END
+			}
+		}
 		void CNNPP_v3::tanhW(float* __restrict dst, int dst_size_l, float* __restrict src, int src_size_l, int src_size_h, float* __restrict snn_ol_b, float* __restrict tanh_w, float* __restrict scale, size_t L, size_t H, int num_threads)
 		{
-			const __m256 ymm14 = _mm256_broadcast_ss((float*)&abs_mask);
-			const __m256 ymm15 = _mm256_broadcast_ss(&one);
-			const __m256 ymm13 = _mm256_broadcast_ss(&tanh_a);
+			const Activation::tanh_tier tanh_f;
 			const __m256 ymm12 = _mm256_broadcast_ss(snn_ol_b);
 			const __m256 ymm11 = _mm256_broadcast_ss(scale);
 			const __m256 ymm10 = _mm256_broadcast_ss(tanh_w);
@@ -1010,25 +1113,7 @@ namespace NeuralNetworksLib
 					ymm0 = _mm256_add_ps(ymm0, ymm12);
 					ymm0 = _mm256_mul_ps(ymm0, ymm10);
 
-					__m256 ymm1 = _mm256_and_ps(ymm14, ymm0);
-					__m256 ymm3 = _mm256_add_ps(ymm15, ymm1);
-					__m256 ymm4 = _mm256_mul_ps(ymm0, ymm0);
-
-					ymm3 = _mm256_add_ps(ymm3, ymm4);
-					__m256 ymm5 = _mm256_mul_ps(ymm4, ymm4);
-
-					ymm3 = _mm256_fmadd_ps(ymm5, ymm13, ymm3);
-
-					__m256 ymm2 = _mm256_andnot_ps(ymm14, ymm0);
-
-#ifdef USE_FAST_DIV
-					ymm3 = _mm256_rcp_ps(ymm3);
-#else
-					ymm3 = _mm256_div_ps(ymm15, ymm3);
-#endif	
-
-					ymm3 = _mm256_sub_ps(ymm15, ymm3);
-					ymm3 = _mm256_or_ps(ymm3, ymm2);
+					__m256 ymm3 = tanh_f(ymm0);
 
 					ymm3 = _mm256_mul_ps(ymm3, ymm11);
 
@@ -21,6 +21,7 @@
 #pragma once
 
 #include "config.h"
+#include <cstddef>
 
 
 //========================================================================================================
@@ -34,7 +35,7 @@ namespace NeuralNetworksLib
 	{
 		class CNNPP_v3
 		{
-		private:
+		protected:
 			const int Q = 14;
 			const int Kq = (1 << (Q - 0));
 
@@ -64,10 +65,16 @@ namespace NeuralNetworksLib
 			CNNPP_v3() { }
 			~CNNPP_v3() { }
 
+			//fixed point scale of data passed between layers, reset by layer 1 and accumulated by each next layer
+			inline float getScale() const { return fct; }
+			inline void setScale(float _fct) { fct = _fct; }
+
 			void conv_4x4_lrelu_bn_max(float* __restrict dst, int dst_size_l, float* __restrict src, int src_size_l, int src_size_h, float* __restrict kernel, float* __restrict conv_b, float* __restrict lrelu_w1, float* __restrict lrelu_w2, float* __restrict bn_w, float* __restrict bn_b, size_t L = 0, size_t H = 0, int num_threads = 1);
 			void conv_3x3_lrelu_bn_max(float* __restrict dst, int dst_size_l, float* __restrict src, int src_size_l, int src_size_h, float* __restrict kernel, float* __restrict conv_b, float* __restrict lrelu_w1, float* __restrict lrelu_w2, float* __restrict bn_w, float* __restrict bn_b, size_t L = 0, size_t H = 0, int num_threads = 1);
 			void conv_5x4_lrelu_bn(float* __restrict dst, int dst_size_l, float* __restrict src, int src_size_l, int src_size_h, float* __restrict kernel, float* __restrict conv_b, float* __restrict lrelu_w1, float* __restrict lrelu_w2, float* __restrict bn_w, float* __restrict bn_b, size_t L = 0, size_t H = 0, int num_threads = 1);
 			void mulCN_add_tanhW_add(float* __restrict dst, int dst_size_l, float* __restrict src, int src_size_l, int src_size_h, float** __restrict snn_hl_w, float** __restrict snn_hl_b, float* __restrict snn_tanh_w, float* __restrict snn_bn_w, float* __restrict snn_bn_b, float** __restrict snn_ol_w, size_t L, size_t H, int num_threads = 1);
+			//hidden layer of mulCN_add_tanhW_add runs once, dst_N[n] gets output layer snn_ol_w_N[n] of N neurons
+			void mulCN_add_tanhW_add_N(int N, float** __restrict dst_N, int dst_size_l, float* __restrict src, int src_size_l, int src_size_h, float** __restrict snn_hl_w, float** __restrict snn_hl_b, float* __restrict snn_tanh_w, float* __restrict snn_bn_w, float* __restrict snn_bn_b, float*** __restrict snn_ol_w_N, size_t L, size_t H, int num_threads = 1);
 			void tanhW(float* __restrict dst, int dst_size_l, float* __restrict src, int src_size_l, int src_size_h, float* __restrict snn_ol_b, float* __restrict tanh_w, float* __restrict scale, size_t L, size_t H, int num_threads = 1);
 
 			//void conv_4x4_lrelu_bn_max_old(float* __restrict dst, int dst_size_l, float* __restrict src, int src_size_l, int src_size_h, float* __restrict kernel, float* __restrict conv_b, float* __restrict lrelu_w1, float* __restrict lrelu_w2, float* __restrict bn_w, float* __restrict bn_b, size_t L = 0, size_t H = 0, int num_threads = 1);
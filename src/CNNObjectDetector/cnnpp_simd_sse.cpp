@@ -89,21 +89,21 @@ namespace NeuralNetworksLib
 
 					//-----------------------------------------
 
-					ymm0 = _mm_blend_ps(ymm0, ymm4, 17);
+					ymm0 = _mm_blend_ps(ymm0, ymm4, 1);
 					ymm12 = _mm_shuffle_ps(ymm12, ymm12, 147);
 					ymm8 = _mm_mul_ps(ymm0, ymm12);
 
-					ymm1 = _mm_blend_ps(ymm1, ymm5, 17);
+					ymm1 = _mm_blend_ps(ymm1, ymm5, 1);
 					ymm13 = _mm_shuffle_ps(ymm13, ymm13, 147);
 					ymm9 = _mm_mul_ps(ymm1, ymm13);
 					ymm8 = _mm_add_ps(ymm8, ymm9);
 
-					ymm2 = _mm_blend_ps(ymm2, ymm6, 17);
+					ymm2 = _mm_blend_ps(ymm2, ymm6, 1);
 					ymm14 = _mm_shuffle_ps(ymm14, ymm14, 147);
 					ymm9 = _mm_mul_ps(ymm2, ymm14);
 					ymm8 = _mm_add_ps(ymm8, ymm9);
 
-					ymm3 = _mm_blend_ps(ymm3, ymm7, 17);
+					ymm3 = _mm_blend_ps(ymm3, ymm7, 1);
 					ymm15 = _mm_shuffle_ps(ymm15, ymm15, 147);
 					ymm9 = _mm_mul_ps(ymm3, ymm15);
 					ymm8 = _mm_add_ps(ymm8, ymm9);
@@ -112,25 +112,25 @@ namespace NeuralNetworksLib
 					ymm8 = _mm_add_ps(ymm8, ymm9);
 					ymm9 = _mm_shuffle_ps(ymm8, ymm8, 1);
 					ymm8 = _mm_add_ps(ymm8, ymm9);
-					ymm11 = _mm_blend_ps(ymm11, ymm8, 34);
+					ymm11 = _mm_blend_ps(ymm11, ymm8, 2);
 
 					//-----------------------------------------
 
-					ymm0 = _mm_blend_ps(ymm0, ymm4, 34);
+					ymm0 = _mm_blend_ps(ymm0, ymm4, 2);
 					ymm12 = _mm_shuffle_ps(ymm12, ymm12, 147);
 					ymm8 = _mm_mul_ps(ymm0, ymm12);
 
-					ymm1 = _mm_blend_ps(ymm1, ymm5, 34);
+					ymm1 = _mm_blend_ps(ymm1, ymm5, 2);
 					ymm13 = _mm_shuffle_ps(ymm13, ymm13, 147);
 					ymm9 = _mm_mul_ps(ymm1, ymm13);
 					ymm8 = _mm_add_ps(ymm8, ymm9);
 
-					ymm2 = _mm_blend_ps(ymm2, ymm6, 34);
+					ymm2 = _mm_blend_ps(ymm2, ymm6, 2);
 					ymm14 = _mm_shuffle_ps(ymm14, ymm14, 147);
 					ymm9 = _mm_mul_ps(ymm2, ymm14);
 					ymm8 = _mm_add_ps(ymm8, ymm9);
 
-					ymm3 = _mm_blend_ps(ymm3, ymm7, 34);
+					ymm3 = _mm_blend_ps(ymm3, ymm7, 2);
 					ymm15 = _mm_shuffle_ps(ymm15, ymm15, 147);
 					ymm9 = _mm_mul_ps(ymm3, ymm15);
 					ymm8 = _mm_add_ps(ymm8, ymm9);
@@ -139,25 +139,25 @@ namespace NeuralNetworksLib
 					ymm8 = _mm_add_ps(ymm8, ymm9);
 					ymm9 = _mm_shuffle_ps(ymm8, ymm8, 176);
 					ymm8 = _mm_add_ps(ymm8, ymm9);
-					ymm11 = _mm_blend_ps(ymm11, ymm8, 68);
+					ymm11 = _mm_blend_ps(ymm11, ymm8, 4);
 
 					//-----------------------------------------
 
-					ymm0 = _mm_blend_ps(ymm0, ymm4, 68);
+					ymm0 = _mm_blend_ps(ymm0, ymm4, 4);
 					ymm12 = _mm_shuffle_ps(ymm12, ymm12, 147);
 					ymm8 = _mm_mul_ps(ymm0, ymm12);
 
-					ymm1 = _mm_blend_ps(ymm1, ymm5, 68);
+					ymm1 = _mm_blend_ps(ymm1, ymm5, 4);
 					ymm13 = _mm_shuffle_ps(ymm13, ymm13, 147);
 					ymm9 = _mm_mul_ps(ymm1, ymm13);
 					ymm8 = _mm_add_ps(ymm8, ymm9);
 
-					ymm2 = _mm_blend_ps(ymm2, ymm6, 68);
+					ymm2 = _mm_blend_ps(ymm2, ymm6, 4);
 					ymm14 = _mm_shuffle_ps(ymm14, ymm14, 147);
 					ymm9 = _mm_mul_ps(ymm2, ymm14);
 					ymm8 = _mm_add_ps(ymm8, ymm9);
 
-					ymm3 = _mm_blend_ps(ymm3, ymm7, 68);
+					ymm3 = _mm_blend_ps(ymm3, ymm7, 4);
 					ymm15 = _mm_shuffle_ps(ymm15, ymm15, 147);
 					ymm9 = _mm_mul_ps(ymm3, ymm15);
 					ymm8 = _mm_add_ps(ymm8, ymm9);
@@ -166,7 +166,7 @@ namespace NeuralNetworksLib
 					ymm8 = _mm_add_ps(ymm8, ymm9);
 					ymm9 = _mm_shuffle_ps(ymm8, ymm8, 176);
 					ymm8 = _mm_add_ps(ymm8, ymm9);
-					ymm11 = _mm_blend_ps(ymm11, ymm8, 136);
+					ymm11 = _mm_blend_ps(ymm11, ymm8, 8);
 
 					_mm_store_ps(pDst, ymm11);
 					pDst += REG_SIZE;
@@ -214,21 +214,21 @@ namespace NeuralNetworksLib
 
 				//-----------------------------------------
 
-				ymm0 = _mm_blend_ps(ymm0, ymm4, 17);
+				ymm0 = _mm_blend_ps(ymm0, ymm4, 1);
 				ymm12 = _mm_shuffle_ps(ymm12, ymm12, 147);
 				ymm8 = _mm_mul_ps(ymm0, ymm12);
 
-				ymm1 = _mm_blend_ps(ymm1, ymm5, 17);
+				ymm1 = _mm_blend_ps(ymm1, ymm5, 1);
 				ymm13 = _mm_shuffle_ps(ymm13, ymm13, 147);
 				ymm9 = _mm_mul_ps(ymm1, ymm13);
 				ymm8 = _mm_add_ps(ymm8, ymm9);
 
-				ymm2 = _mm_blend_ps(ymm2, ymm6, 17);
+				ymm2 = _mm_blend_ps(ymm2, ymm6, 1);
 				ymm14 = _mm_shuffle_ps(ymm14, ymm14, 147);
 				ymm9 = _mm_mul_ps(ymm2, ymm14);
 				ymm8 = _mm_add_ps(ymm8, ymm9);
 
-				ymm3 = _mm_blend_ps(ymm3, ymm7, 17);
+				ymm3 = _mm_blend_ps(ymm3, ymm7, 1);
 				ymm15 = _mm_shuffle_ps(ymm15, ymm15, 147);
 				ymm9 = _mm_mul_ps(ymm3, ymm15);
 				ymm8 = _mm_add_ps(ymm8, ymm9);
@@ -237,25 +237,25 @@ namespace NeuralNetworksLib
 				ymm8 = _mm_add_ps(ymm8, ymm9);
 				ymm9 = _mm_shuffle_ps(ymm8, ymm8, 1);
 				ymm8 = _mm_add_ps(ymm8, ymm9);
-				ymm11 = _mm_blend_ps(ymm11, ymm8, 34);
+				ymm11 = _mm_blend_ps(ymm11, ymm8, 2);
 
 				//-----------------------------------------
 
-				ymm0 = _mm_blend_ps(ymm0, ymm4, 34);
+				ymm0 = _mm_blend_ps(ymm0, ymm4, 2);
 				ymm12 = _mm_shuffle_ps(ymm12, ymm12, 147);
 				ymm8 = _mm_mul_ps(ymm0, ymm12);
 
-				ymm1 = _mm_blend_ps(ymm1, ymm5, 34);
+				ymm1 = _mm_blend_ps(ymm1, ymm5, 2);
 				ymm13 = _mm_shuffle_ps(ymm13, ymm13, 147);
 				ymm9 = _mm_mul_ps(ymm1, ymm13);
 				ymm8 = _mm_add_ps(ymm8, ymm9);
 
-				ymm2 = _mm_blend_ps(ymm2, ymm6, 34);
+				ymm2 = _mm_blend_ps(ymm2, ymm6, 2);
 				ymm14 = _mm_shuffle_ps(ymm14, ymm14, 147);
 				ymm9 = _mm_mul_ps(ymm2, ymm14);
 				ymm8 = _mm_add_ps(ymm8, ymm9);
 
-				ymm3 = _mm_blend_ps(ymm3, ymm7, 34);
+				ymm3 = _mm_blend_ps(ymm3, ymm7, 2);
 				ymm15 = _mm_shuffle_ps(ymm15, ymm15, 147);
 				ymm9 = _mm_mul_ps(ymm3, ymm15);
 				ymm8 = _mm_add_ps(ymm8, ymm9);
@@ -264,25 +264,25 @@ namespace NeuralNetworksLib
 				ymm8 = _mm_add_ps(ymm8, ymm9);
 				ymm9 = _mm_shuffle_ps(ymm8, ymm8, 176);
 				ymm8 = _mm_add_ps(ymm8, ymm9);
-				ymm11 = _mm_blend_ps(ymm11, ymm8, 68);
+				ymm11 = _mm_blend_ps(ymm11, ymm8, 4);
 
 				//-----------------------------------------
 
-				ymm0 = _mm_blend_ps(ymm0, ymm4, 68);
+				ymm0 = _mm_blend_ps(ymm0, ymm4, 4);
 				ymm12 = _mm_shuffle_ps(ymm12, ymm12, 147);
 				ymm8 = _mm_mul_ps(ymm0, ymm12);
 
-				ymm1 = _mm_blend_ps(ymm1, ymm5, 68);
+				ymm1 = _mm_blend_ps(ymm1, ymm5, 4);
 				ymm13 = _mm_shuffle_ps(ymm13, ymm13, 147);
 				ymm9 = _mm_mul_ps(ymm1, ymm13);
 				ymm8 = _mm_add_ps(ymm8, ymm9);
 
-				ymm2 = _mm_blend_ps(ymm2, ymm6, 68);
+				ymm2 = _mm_blend_ps(ymm2, ymm6, 4);
 				ymm14 = _mm_shuffle_ps(ymm14, ymm14, 147);
 				ymm9 = _mm_mul_ps(ymm2, ymm14);
 				ymm8 = _mm_add_ps(ymm8, ymm9);
 
-				ymm3 = _mm_blend_ps(ymm3, ymm7, 68);
+				ymm3 = _mm_blend_ps(ymm3, ymm7, 4);
 				ymm15 = _mm_shuffle_ps(ymm15, ymm15, 147);
 				ymm9 = _mm_mul_ps(ymm3, ymm15);
 				ymm8 = _mm_add_ps(ymm8, ymm9);
@@ -291,7 +291,7 @@ namespace NeuralNetworksLib
 				ymm8 = _mm_add_ps(ymm8, ymm9);
 				ymm9 = _mm_shuffle_ps(ymm8, ymm8, 176);
 				ymm8 = _mm_add_ps(ymm8, ymm9);
-				ymm11 = _mm_blend_ps(ymm11, ymm8, 136);
+				ymm11 = _mm_blend_ps(ymm11, ymm8, 8);
 
 				_mm_store_ps(pDst, ymm11);
 
@@ -350,16 +350,16 @@ namespace NeuralNetworksLib
 
 					//-----------------------------------------
 
-					ymm0 = _mm_blend_ps(ymm0, ymm4, 17);
+					ymm0 = _mm_blend_ps(ymm0, ymm4, 1);
 					ymm12 = _mm_shuffle_ps(ymm12, ymm12, 147);
 					ymm8 = _mm_mul_ps(ymm0, ymm12);
 
-					ymm1 = _mm_blend_ps(ymm1, ymm5, 17);
+					ymm1 = _mm_blend_ps(ymm1, ymm5, 1);
 					ymm13 = _mm_shuffle_ps(ymm13, ymm13, 147);
 					ymm9 = _mm_mul_ps(ymm1, ymm13);
 					ymm8 = _mm_add_ps(ymm8, ymm9);
 
-					ymm2 = _mm_blend_ps(ymm2, ymm6, 17);
+					ymm2 = _mm_blend_ps(ymm2, ymm6, 1);
 					ymm14 = _mm_shuffle_ps(ymm14, ymm14, 147);
 					ymm9 = _mm_mul_ps(ymm2, ymm14);
 					ymm8 = _mm_add_ps(ymm8, ymm9);
@@ -368,20 +368,20 @@ namespace NeuralNetworksLib
 					ymm8 = _mm_add_ps(ymm8, ymm9);
 					ymm9 = _mm_shuffle_ps(ymm8, ymm8, 1);
 					ymm8 = _mm_add_ps(ymm8, ymm9);
-					ymm11 = _mm_blend_ps(ymm11, ymm8, 34);
+					ymm11 = _mm_blend_ps(ymm11, ymm8, 2);
 
 					//-----------------------------------------
 
-					ymm0 = _mm_blend_ps(ymm0, ymm4, 34);
+					ymm0 = _mm_blend_ps(ymm0, ymm4, 2);
 					ymm12 = _mm_shuffle_ps(ymm12, ymm12, 147);
 					ymm8 = _mm_mul_ps(ymm0, ymm12);
 
-					ymm1 = _mm_blend_ps(ymm1, ymm5, 34);
+					ymm1 = _mm_blend_ps(ymm1, ymm5, 2);
 					ymm13 = _mm_shuffle_ps(ymm13, ymm13, 147);
 					ymm9 = _mm_mul_ps(ymm1, ymm13);
 					ymm8 = _mm_add_ps(ymm8, ymm9);
 
-					ymm2 = _mm_blend_ps(ymm2, ymm6, 34);
+					ymm2 = _mm_blend_ps(ymm2, ymm6, 2);
 					ymm14 = _mm_shuffle_ps(ymm14, ymm14, 147);
 					ymm9 = _mm_mul_ps(ymm2, ymm14);
 					ymm8 = _mm_add_ps(ymm8, ymm9);
@@ -390,20 +390,20 @@ namespace NeuralNetworksLib
 					ymm8 = _mm_add_ps(ymm8, ymm9);
 					ymm9 = _mm_shuffle_ps(ymm8, ymm8, 176);
 					ymm8 = _mm_add_ps(ymm8, ymm9);
-					ymm11 = _mm_blend_ps(ymm11, ymm8, 68);
+					ymm11 = _mm_blend_ps(ymm11, ymm8, 4);
 
 					//-----------------------------------------
 
-					ymm0 = _mm_blend_ps(ymm0, ymm4, 68);
+					ymm0 = _mm_blend_ps(ymm0, ymm4, 4);
 					ymm12 = _mm_shuffle_ps(ymm12, ymm12, 147);
 					ymm8 = _mm_mul_ps(ymm0, ymm12);
 
-					ymm1 = _mm_blend_ps(ymm1, ymm5, 68);
+					ymm1 = _mm_blend_ps(ymm1, ymm5, 4);
 					ymm13 = _mm_shuffle_ps(ymm13, ymm13, 147);
 					ymm9 = _mm_mul_ps(ymm1, ymm13);
 					ymm8 = _mm_add_ps(ymm8, ymm9);
 
-					ymm2 = _mm_blend_ps(ymm2, ymm6, 68);
+					ymm2 = _mm_blend_ps(ymm2, ymm6, 4);
 					ymm14 = _mm_shuffle_ps(ymm14, ymm14, 147);
 					ymm9 = _mm_mul_ps(ymm2, ymm14);
 					ymm8 = _mm_add_ps(ymm8, ymm9);
@@ -412,7 +412,7 @@ namespace NeuralNetworksLib
 					ymm8 = _mm_add_ps(ymm8, ymm9);
 					ymm9 = _mm_shuffle_ps(ymm8, ymm8, 176);
 					ymm8 = _mm_add_ps(ymm8, ymm9);
-					ymm11 = _mm_blend_ps(ymm11, ymm8, 136);
+					ymm11 = _mm_blend_ps(ymm11, ymm8, 8);
 
 					_mm_store_ps(pDst, ymm11);
 					pDst += REG_SIZE;
@@ -453,16 +453,16 @@ namespace NeuralNetworksLib
 
 				//-----------------------------------------
 
-				ymm0 = _mm_blend_ps(ymm0, ymm4, 17);
+				ymm0 = _mm_blend_ps(ymm0, ymm4, 1);
 				ymm12 = _mm_shuffle_ps(ymm12, ymm12, 147);
 				ymm8 = _mm_mul_ps(ymm0, ymm12);
 
-				ymm1 = _mm_blend_ps(ymm1, ymm5, 17);
+				ymm1 = _mm_blend_ps(ymm1, ymm5, 1);
 				ymm13 = _mm_shuffle_ps(ymm13, ymm13, 147);
 				ymm9 = _mm_mul_ps(ymm1, ymm13);
 				ymm8 = _mm_add_ps(ymm8, ymm9);
 
-				ymm2 = _mm_blend_ps(ymm2, ymm6, 17);
+				ymm2 = _mm_blend_ps(ymm2, ymm6, 1);
 				ymm14 = _mm_shuffle_ps(ymm14, ymm14, 147);
 				ymm9 = _mm_mul_ps(ymm2, ymm14);
 				ymm8 = _mm_add_ps(ymm8, ymm9);
@@ -471,20 +471,20 @@ namespace NeuralNetworksLib
 				ymm8 = _mm_add_ps(ymm8, ymm9);
 				ymm9 = _mm_shuffle_ps(ymm8, ymm8, 1);
 				ymm8 = _mm_add_ps(ymm8, ymm9);
-				ymm11 = _mm_blend_ps(ymm11, ymm8, 34);
+				ymm11 = _mm_blend_ps(ymm11, ymm8, 2);
 
 				//-----------------------------------------
 
-				ymm0 = _mm_blend_ps(ymm0, ymm4, 34);
+				ymm0 = _mm_blend_ps(ymm0, ymm4, 2);
 				ymm12 = _mm_shuffle_ps(ymm12, ymm12, 147);
 				ymm8 = _mm_mul_ps(ymm0, ymm12);
 
-				ymm1 = _mm_blend_ps(ymm1, ymm5, 34);
+				ymm1 = _mm_blend_ps(ymm1, ymm5, 2);
 				ymm13 = _mm_shuffle_ps(ymm13, ymm13, 147);
 				ymm9 = _mm_mul_ps(ymm1, ymm13);
 				ymm8 = _mm_add_ps(ymm8, ymm9);
 
-				ymm2 = _mm_blend_ps(ymm2, ymm6, 34);
+				ymm2 = _mm_blend_ps(ymm2, ymm6, 2);
 				ymm14 = _mm_shuffle_ps(ymm14, ymm14, 147);
 				ymm9 = _mm_mul_ps(ymm2, ymm14);
 				ymm8 = _mm_add_ps(ymm8, ymm9);
@@ -493,20 +493,20 @@ namespace NeuralNetworksLib
 				ymm8 = _mm_add_ps(ymm8, ymm9);
 				ymm9 = _mm_shuffle_ps(ymm8, ymm8, 176);
 				ymm8 = _mm_add_ps(ymm8, ymm9);
-				ymm11 = _mm_blend_ps(ymm11, ymm8, 68);
+				ymm11 = _mm_blend_ps(ymm11, ymm8, 4);
 
 				//-----------------------------------------
 
-				ymm0 = _mm_blend_ps(ymm0, ymm4, 68);
+				ymm0 = _mm_blend_ps(ymm0, ymm4, 4);
 				ymm12 = _mm_shuffle_ps(ymm12, ymm12, 147);
 				ymm8 = _mm_mul_ps(ymm0, ymm12);
 
-				ymm1 = _mm_blend_ps(ymm1, ymm5, 68);
+				ymm1 = _mm_blend_ps(ymm1, ymm5, 4);
 				ymm13 = _mm_shuffle_ps(ymm13, ymm13, 147);
 				ymm9 = _mm_mul_ps(ymm1, ymm13);
 				ymm8 = _mm_add_ps(ymm8, ymm9);
 
-				ymm2 = _mm_blend_ps(ymm2, ymm6, 68);
+				ymm2 = _mm_blend_ps(ymm2, ymm6, 4);
 				ymm14 = _mm_shuffle_ps(ymm14, ymm14, 147);
 				ymm9 = _mm_mul_ps(ymm2, ymm14);
 				ymm8 = _mm_add_ps(ymm8, ymm9);
@@ -515,7 +515,7 @@ namespace NeuralNetworksLib
 				ymm8 = _mm_add_ps(ymm8, ymm9);
 				ymm9 = _mm_shuffle_ps(ymm8, ymm8, 176);
 				ymm8 = _mm_add_ps(ymm8, ymm9);
-				ymm11 = _mm_blend_ps(ymm11, ymm8, 136);
+				ymm11 = _mm_blend_ps(ymm11, ymm8, 8);
 
 				_mm_store_ps(pDst, ymm11);
 
@@ -783,7 +783,7 @@ namespace NeuralNetworksLib
 					ymm8 = _mm_add_ps(ymm8, ymm10);
 					ymm10 = _mm_shuffle_ps(ymm8, ymm8, 1);
 					ymm8 = _mm_add_ps(ymm8, ymm10);
-					ymm11 = _mm_blend_ps(ymm11, ymm8, 34);
+					ymm11 = _mm_blend_ps(ymm11, ymm8, 2);
 
 					//-----------------------------------------
 
@@ -807,7 +807,7 @@ namespace NeuralNetworksLib
 					ymm8 = _mm_add_ps(ymm8, ymm10);
 					ymm10 = _mm_shuffle_ps(ymm8, ymm8, 176);
 					ymm8 = _mm_add_ps(ymm8, ymm10);
-					ymm11 = _mm_blend_ps(ymm11, ymm8, 68);
+					ymm11 = _mm_blend_ps(ymm11, ymm8, 4);
 
 					//-----------------------------------------
 
@@ -831,7 +831,7 @@ namespace NeuralNetworksLib
 					ymm8 = _mm_add_ps(ymm8, ymm10);
 					ymm10 = _mm_shuffle_ps(ymm8, ymm8, 176);
 					ymm8 = _mm_add_ps(ymm8, ymm10);
-					ymm11 = _mm_blend_ps(ymm11, ymm8, 136);
+					ymm11 = _mm_blend_ps(ymm11, ymm8, 8);
 
 					_mm_store_ps(pDst, ymm11);
 					pDst += REG_SIZE;
@@ -892,7 +892,7 @@ namespace NeuralNetworksLib
 				ymm8 = _mm_add_ps(ymm8, ymm10);
 				ymm10 = _mm_shuffle_ps(ymm8, ymm8, 1);
 				ymm8 = _mm_add_ps(ymm8, ymm10);
-				ymm11 = _mm_blend_ps(ymm11, ymm8, 34);
+				ymm11 = _mm_blend_ps(ymm11, ymm8, 2);
 
 				//-----------------------------------------
 
@@ -916,7 +916,7 @@ namespace NeuralNetworksLib
 				ymm8 = _mm_add_ps(ymm8, ymm10);
 				ymm10 = _mm_shuffle_ps(ymm8, ymm8, 176);
 				ymm8 = _mm_add_ps(ymm8, ymm10);
-				ymm11 = _mm_blend_ps(ymm11, ymm8, 68);
+				ymm11 = _mm_blend_ps(ymm11, ymm8, 4);
 
 				//-----------------------------------------
 
@@ -940,7 +940,7 @@ namespace NeuralNetworksLib
 				ymm8 = _mm_add_ps(ymm8, ymm10);
 				ymm10 = _mm_shuffle_ps(ymm8, ymm8, 176);
 				ymm8 = _mm_add_ps(ymm8, ymm10);
-				ymm11 = _mm_blend_ps(ymm11, ymm8, 136);
+				ymm11 = _mm_blend_ps(ymm11, ymm8, 8);
 
 				_mm_store_ps(pDst, ymm11);
 
@@ -1009,7 +1009,7 @@ namespace NeuralNetworksLib
 					ymm8 = _mm_add_ps(ymm8, ymm10);
 					ymm10 = _mm_shuffle_ps(ymm8, ymm8, 1);
 					ymm8 = _mm_add_ps(ymm8, ymm10);
-					ymm11 = _mm_blend_ps(ymm11, ymm8, 34);
+					ymm11 = _mm_blend_ps(ymm11, ymm8, 2);
 
 					//-----------------------------------------
 
@@ -1029,7 +1029,7 @@ namespace NeuralNetworksLib
 					ymm8 = _mm_add_ps(ymm8, ymm10);
 					ymm10 = _mm_shuffle_ps(ymm8, ymm8, 176);
 					ymm8 = _mm_add_ps(ymm8, ymm10);
-					ymm11 = _mm_blend_ps(ymm11, ymm8, 68);
+					ymm11 = _mm_blend_ps(ymm11, ymm8, 4);
 
 					//-----------------------------------------
 
@@ -1049,7 +1049,7 @@ namespace NeuralNetworksLib
 					ymm8 = _mm_add_ps(ymm8, ymm10);
 					ymm10 = _mm_shuffle_ps(ymm8, ymm8, 176);
 					ymm8 = _mm_add_ps(ymm8, ymm10);
-					ymm11 = _mm_blend_ps(ymm11, ymm8, 136);
+					ymm11 = _mm_blend_ps(ymm11, ymm8, 8);
 
 					_mm_store_ps(pDst, ymm11);
 					pDst += REG_SIZE;
@@ -1099,7 +1099,7 @@ namespace NeuralNetworksLib
 				ymm8 = _mm_add_ps(ymm8, ymm10);
 				ymm10 = _mm_shuffle_ps(ymm8, ymm8, 1);
 				ymm8 = _mm_add_ps(ymm8, ymm10);
-				ymm11 = _mm_blend_ps(ymm11, ymm8, 34);
+				ymm11 = _mm_blend_ps(ymm11, ymm8, 2);
 
 				//-----------------------------------------
 
@@ -1119,7 +1119,7 @@ namespace NeuralNetworksLib
 				ymm8 = _mm_add_ps(ymm8, ymm10);
 				ymm10 = _mm_shuffle_ps(ymm8, ymm8, 176);
 				ymm8 = _mm_add_ps(ymm8, ymm10);
-				ymm11 = _mm_blend_ps(ymm11, ymm8, 68);
+				ymm11 = _mm_blend_ps(ymm11, ymm8, 4);
 
 				//-----------------------------------------
 
@@ -1139,7 +1139,7 @@ namespace NeuralNetworksLib
 				ymm8 = _mm_add_ps(ymm8, ymm10);
 				ymm10 = _mm_shuffle_ps(ymm8, ymm8, 176);
 				ymm8 = _mm_add_ps(ymm8, ymm10);
-				ymm11 = _mm_blend_ps(ymm11, ymm8, 136);
+				ymm11 = _mm_blend_ps(ymm11, ymm8, 8);
 
 				_mm_store_ps(pDst, ymm11);
 
@@ -0,0 +1,572 @@
+/*
+*	Copyright (c) 2018, Ilya Kalinovskiy
+*	All rights reserved.
+*
+*	This is an implementation of the algorithm described in the following paper:
+*		I.A. Kalinovskiy, V.G. Spitsyn,
+*		Compact Convolutional Neural Network Cascade for Face Detection,
+*		http://arxiv.org/abs/1508.01292.
+*
+*	Redistribution and use of this program as source code or in binary form, with or without modifications, are permitted provided that the following conditions are met:
+*		1. Redistributions may not be sold, nor may they be used in a commercial product or activity without prior permission from the copyright holder (contact him at kua_21@mail.ru).
+*		2. Redistributions may not be used for military purposes.
+*		3. Any published work which utilizes this program shall include the reference to the paper available at http://arxiv.org/abs/1508.01292
+*		4. Redistributions must retain the above copyright notice and the reference to the algorithm on which the implementation is based on, this list of conditions and the following disclaimer.
+*
+*	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+*	IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#include "cnnpp_simd_template.h"
+#include "activation_simd.h"
+#include <cmath>
+#include <type_traits>
+
+#ifdef _MSC_VER
+#	include <intrin.h>
+#endif
+
+#if defined(__GNUC__) && !defined(__clang__)
+#	pragma GCC diagnostic push
+#	pragma GCC diagnostic ignored "-Wignored-attributes"
+#endif
+
+#if defined(USE_CNTK_MODELS) && defined(USE_AVX2)
+namespace NeuralNetworksLib
+{
+	namespace SIMD
+	{
+		namespace ConvTemplate
+		{
+			namespace
+			{
+				//u8 x s7 pairs of _mm256_maddubs_epi16 do not saturate int16, 2 maps per pass keep 8 accumulators in 16 registers
+				struct DotQ8
+				{
+					enum { MB = Q8_BLOCK };
+					static inline __m256i dot(const __m256i acc, const __m256i a, const __m256i w)
+					{
+						return _mm256_add_epi32(acc, _mm256_madd_epi16(_mm256_maddubs_epi16(a, w), _mm256_set1_epi16(1)));
+					}
+				};
+			}
+		}
+	}
+}
+#	include "cnnpp_simd_template_q8.h"
+#endif
+
+
+//========================================================================================================
+
+
+namespace NeuralNetworksLib
+{
+#ifdef USE_CNTK_MODELS
+
+	namespace SIMD
+	{
+		namespace ConvTemplate
+		{
+#if defined(USE_AVX)
+			typedef __m256 vec;
+#elif defined(USE_SSE)
+			typedef __m128 vec;
+#else
+			typedef float vec;
+#endif
+
+			//max of adjacent columns of a (columns 0 .. size - 1) and b (columns size .. 2 size - 1)
+			template <typename V>
+			inline V max_pairs(const V a, const V b);
+
+			template <>
+			inline float max_pairs<float>(const float a, const float b) { return fmaxf(a, b); }
+
+#if defined(USE_SSE) || defined(USE_AVX)
+			template <>
+			inline __m128 max_pairs<__m128>(const __m128 a, const __m128 b)
+			{
+				return _mm_max_ps(_mm_shuffle_ps(a, b, 136), _mm_shuffle_ps(a, b, 221));
+			}
+#endif
+
+#ifdef USE_AVX
+			template <>
+			inline __m256 max_pairs<__m256>(const __m256 a, const __m256 b)
+			{
+				const __m256 lo = _mm256_permute2f128_ps(a, b, 32);
+				const __m256 hi = _mm256_permute2f128_ps(a, b, 49);
+				return _mm256_max_ps(_mm256_shuffle_ps(lo, hi, 136), _mm256_shuffle_ps(lo, hi, 221));
+			}
+#endif
+
+			//leaky ReLU + bn of conv output, rounded as CNNPP::lrelu_bn_max
+			template <typename V>
+			struct LReLU_BN
+			{
+				V conv_b, lrelu_w1, lrelu_w2, bn_b;
+
+				inline void set(const float _conv_b, const float _lrelu_w1, const float _lrelu_w2, const float _bn_b)
+				{
+					typedef Activation::VecOps<V> O;
+					conv_b = O::set1(_conv_b);
+					lrelu_w1 = O::set1(_lrelu_w1);
+					lrelu_w2 = O::set1(_lrelu_w2);
+					bn_b = O::set1(_bn_b);
+				}
+				inline V operator()(V x) const
+				{
+					typedef Activation::VecOps<V> O;
+					x = O::add(x, conv_b);
+					const V relu = O::max(x, O::set1(0.f));
+#ifdef USE_FMA
+					return O::fmadd(relu, lrelu_w2, O::fmadd(x, lrelu_w1, bn_b));
+#else
+					return O::add(O::add(O::mul(x, lrelu_w1), O::mul(relu, lrelu_w2)), bn_b);
+#endif
+				}
+			};
+
+			//conv block of MB maps: with max pool 2 rows x 2 vectors of conv outputs give 1 vector of pooled columns,
+			//else a row of NV vectors; src points to the conv input of the first output, products are summed in kernel order
+			template <typename V, int KW, int KH, int MB, bool POOL, int NV = (POOL || Activation::VecOps<V>::size > 1 ? 2 : 1)>
+			inline void conv_block(float** dst, const int offset, const float* src, const int src_size_l, const float* kernels, const LReLU_BN<V>* af)
+			{
+				typedef Activation::VecOps<V> O;
+				enum { N = O::size, R = POOL ? 2 : 1 };
+
+				V c[MB][R * NV];
+				for (int m = 0; m < MB; ++m)
+				{
+					for (int k = 0; k < R * NV; ++k)
+					{
+						c[m][k] = O::set1(0.f);
+					}
+				}
+
+				for (int ky = 0; ky < KH; ++ky)
+				{
+					for (int kx = 0; kx < KW; ++kx)
+					{
+						V s[R * NV];
+						for (int r = 0; r < R; ++r)
+						{
+							for (int v = 0; v < NV; ++v)
+							{
+								s[r * NV + v] = O::load(src + (ky + r) * src_size_l + kx + v * N);
+							}
+						}
+
+						for (int m = 0; m < MB; ++m)
+						{
+							const V w = O::set1(kernels[(m * KH + ky) * KW + kx]);
+							for (int k = 0; k < R * NV; ++k)
+							{
+								c[m][k] = O::fmadd(s[k], w, c[m][k]);
+							}
+						}
+					}
+				}
+
+				for (int m = 0; m < MB; ++m)
+				{
+					if (POOL)
+					{
+						const V a = O::max(af[m](c[m][0]), af[m](c[m][2]));
+						const V b = O::max(af[m](c[m][1]), af[m](c[m][3]));
+						O::store(dst[m] + offset, max_pairs(a, b));
+					}
+					else
+					{
+						for (int v = 0; v < NV; ++v)
+						{
+							O::store(dst[m] + offset + v * N, af[m](c[m][v]));
+						}
+					}
+				}
+			}
+
+			//MB maps of layer, vector blocks while they are inside of dst and src rows, scalar blocks at the right edge
+			template <int KW, int KH, int MB, bool POOL>
+			inline void conv_maps(float** dst, const int dst_size_l, const float* src, const int src_size_l, const float* kernels,
+								  const LReLU_BN<vec>* af, const LReLU_BN<float>* af1, const int L, const int H)
+			{
+				enum { N = Activation::VecOps<vec>::size, S = POOL ? 2 : 1, W = POOL ? N : (N > 1 ? 2 * N : 1) };
+
+				const int L_out = POOL ? L >> 1 : L;
+				const int H_out = POOL ? H >> 1 : H;
+
+				for (int y = 0; y < H_out; ++y)
+				{
+					const float* src_y = src + S * y * src_size_l;
+					const int offset = y * dst_size_l;
+
+					int x = 0;
+					for (; x < L_out && x + W <= dst_size_l && S * (x + W) + KW - 1 <= src_size_l; x += W)
+					{
+						conv_block<vec, KW, KH, MB, POOL>(dst, offset + x, src_y + S * x, src_size_l, kernels, af);
+					}
+					for (; x < L_out; ++x)
+					{
+						conv_block<float, KW, KH, MB, POOL>(dst, offset + x, src_y + S * x, src_size_l, kernels, af1);
+					}
+				}
+			}
+
+			//maps are processed in blocks of MB, which keep their accumulators in registers
+			template <int KW, int KH, int M, bool POOL>
+			void conv_lrelu_bn(float** dst, int dst_size_l, const float* src, int src_size_l, const float* kernels,
+							   const float* conv_b, const float* lrelu_w1, const float* lrelu_w2, const float* bn_b, int L, int H)
+			{
+				enum { MB = (POOL ? 2 : 4) < M ? (POOL ? 2 : 4) : M, MR = M % MB, K = KW * KH };
+
+				LReLU_BN<vec> af[M];
+				LReLU_BN<float> af1[M];
+				for (int m = 0; m < M; ++m)
+				{
+					af[m].set(conv_b[m], lrelu_w1[m], lrelu_w2[m], bn_b[m]);
+					af1[m].set(conv_b[m], lrelu_w1[m], lrelu_w2[m], bn_b[m]);
+				}
+
+				int m = 0;
+				for (; m + MB <= M; m += MB)
+				{
+					conv_maps<KW, KH, MB, POOL>(dst + m, dst_size_l, src, src_size_l, kernels + m * K, af + m, af1 + m, L, H);
+				}
+				if (MR > 0)
+				{
+					conv_maps<KW, KH, (MR > 0 ? MR : 1), POOL>(dst + m, dst_size_l, src, src_size_l, kernels + m * K, af + m, af1 + m, L, H);
+				}
+
+#ifdef USE_AVX
+				_mm256_zeroupper();
+#endif
+			}
+
+			//widest vector of the build of at most C columns
+			template <int C>
+			struct FixedVec
+			{
+#if defined(USE_AVX)
+				typedef typename std::conditional<(C >= 8), __m256, typename std::conditional<(C >= 4), __m128, float>::type>::type type;
+#elif defined(USE_SSE)
+				typedef typename std::conditional<(C >= 4), __m128, float>::type type;
+#else
+				typedef float type;
+#endif
+			};
+
+			//B blocks of W columns per row, the last one ends at L_OUT (overlapping columns are computed twice)
+			template <typename V, int NV, int KW, int KH, int MB, bool POOL, int L_OUT, int H_OUT>
+			inline void conv_maps_fixed(float** dst, const int dst_size_l, const float* src, const int src_size_l, const float* kernels, const LReLU_BN<V>* af)
+			{
+				enum { N = Activation::VecOps<V>::size, S = POOL ? 2 : 1, W = POOL ? N : NV * N, B = (L_OUT + W - 1) / W };
+
+				for (int y = 0; y < H_OUT; ++y)
+				{
+					const float* src_y = src + S * y * src_size_l;
+					const int offset = y * dst_size_l;
+					for (int b = 0; b < B; ++b)
+					{
+						const int x = b < B - 1 ? b * W : L_OUT - W;
+						conv_block<V, KW, KH, MB, POOL, NV>(dst, offset + x, src_y + S * x, src_size_l, kernels, af);
+					}
+				}
+			}
+
+			template <int KW, int KH, int M, bool POOL, int L, int H>
+			void conv_lrelu_bn_fixed(float** dst, int dst_size_l, const float* src, int src_size_l, const float* kernels,
+									 const float* conv_b, const float* lrelu_w1, const float* lrelu_w2, const float* bn_b)
+			{
+				enum { L_OUT = POOL ? L >> 1 : L, H_OUT = POOL ? H >> 1 : H, N = Activation::VecOps<vec>::size, WIDE = !POOL && N > 1 && L_OUT >= 2 * N };
+				static_assert(L_OUT > 0 && H_OUT > 0, "empty conv layer");
+
+				//2 vectors per block with max pool and on wide rows, else 1 vector of at most L_OUT columns
+				typedef typename std::conditional<WIDE, vec, typename FixedVec<L_OUT>::type>::type V;
+				enum { NV = POOL || WIDE ? 2 : 1, MB = (POOL ? 2 : 4) < M ? (POOL ? 2 : 4) : M, MR = M % MB, K = KW * KH };
+
+				LReLU_BN<V> af[M];
+				for (int m = 0; m < M; ++m)
+				{
+					af[m].set(conv_b[m], lrelu_w1[m], lrelu_w2[m], bn_b[m]);
+				}
+
+				int m = 0;
+				for (; m + MB <= M; m += MB)
+				{
+					conv_maps_fixed<V, NV, KW, KH, MB, POOL, L_OUT, H_OUT>(dst + m, dst_size_l, src, src_size_l, kernels + m * K, af + m);
+				}
+				if (MR > 0)
+				{
+					conv_maps_fixed<V, NV, KW, KH, (MR > 0 ? MR : 1), POOL, L_OUT, H_OUT>(dst + m, dst_size_l, src, src_size_l, kernels + m * K, af + m);
+				}
+
+#ifdef USE_AVX
+				_mm256_zeroupper();
+#endif
+			}
+
+			Kernel find(int kernel_w, int kernel_h, int maps, bool pool)
+			{
+#define CONV_TEMPLATE_FIND(KW, KH, M, POOL)									\
+				if (kernel_w == KW && kernel_h == KH && maps == M && pool == POOL)	\
+				{																	\
+					return conv_lrelu_bn<KW, KH, M, POOL>;							\
+				}
+
+				CONV_TEMPLATE_SHAPES(CONV_TEMPLATE_FIND)
+
+#undef CONV_TEMPLATE_FIND
+
+				return nullptr;
+			}
+			FixedKernel findFixed(int kernel_w, int kernel_h, int maps, bool pool, int L, int H)
+			{
+#define CONV_TEMPLATE_FIND_FIXED(KW, KH, M, POOL, FL, FH)															\
+				if (kernel_w == KW && kernel_h == KH && maps == M && pool == POOL && L == FL && H == FH)	\
+				{																							\
+					return conv_lrelu_bn_fixed<KW, KH, M, POOL, FL, FH>;									\
+				}
+
+				CONV_TEMPLATE_FIXED_SHAPES(CONV_TEMPLATE_FIND_FIXED)
+
+#undef CONV_TEMPLATE_FIND_FIXED
+
+				return nullptr;
+			}
+
+#ifdef USE_AVX2
+			bool isVNNISupported()
+			{
+				const int isa = VNNI::getInstructionSet();
+				if (isa == 0) return false;
+#ifdef _MSC_VER
+				int info[4];
+				__cpuid(info, 0);
+				if (info[0] < 7) return false;
+				__cpuid(info, 1);
+				if ((info[2] & (1 << 27)) == 0) return false;
+				if (isa == 1)
+				{
+					if ((_xgetbv(0) & 0xE6) != 0xE6) return false;
+					__cpuidex(info, 7, 0);
+					const int bits = (1 << 16) | (1 << 30) | (1 << 31);
+					return (info[1] & bits) == bits && (info[2] & (1 << 11)) != 0;
+				}
+				if ((_xgetbv(0) & 0x6) != 0x6) return false;
+				__cpuidex(info, 7, 1);
+				return (info[0] & (1 << 4)) != 0;
+#else
+				__builtin_cpu_init();
+				if (isa == 1)
+				{
+					return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw") && __builtin_cpu_supports("avx512vl")
+						&& __builtin_cpu_supports("avx512vnni");
+				}
+				return __builtin_cpu_supports("avxvnni");
+#endif
+			}
+			static bool& vnniEnabled()
+			{
+				static bool enabled = isVNNISupported();
+				return enabled;
+			}
+			bool isVNNIEnabled() { return vnniEnabled(); }
+			void setVNNIEnabled(bool enabled) { vnniEnabled() = enabled && isVNNISupported(); }
+
+			PoolKernelQ8 findPoolQ8(int kernel_w, int kernel_h, int maps)
+			{
+				if (isVNNIEnabled()) return VNNI::findPoolQ8(kernel_w, kernel_h, maps);
+				return findPoolQ8Impl(kernel_w, kernel_h, maps);
+			}
+			KernelQ8 findQ8(int kernel_w, int kernel_h, int maps)
+			{
+				if (isVNNIEnabled()) return VNNI::findQ8(kernel_w, kernel_h, maps);
+				return findQ8Impl(kernel_w, kernel_h, maps);
+			}
+
+			void packKernelsQ8(int* dst, const signed char* kernels, int kernel_w, int kernel_h, int maps)
+			{
+				const int W4 = (kernel_w + 3) >> 2;
+				for (int k = 0; k < maps; ++k)
+				{
+					for (int ky = 0; ky < kernel_h; ++ky)
+					{
+						for (int g = 0; g < W4; ++g)
+						{
+							uint_ w = 0;
+							for (int i = 0; i < 4 && 4 * g + i < kernel_w; ++i)
+							{
+								w |= uint_(uchar_(kernels[(k * kernel_h + ky) * kernel_w + 4 * g + i])) << (8 * i);
+							}
+							dst[(((k / Q8_BLOCK) * kernel_h + ky) * W4 + g) * Q8_BLOCK + k % Q8_BLOCK] = int(w);
+						}
+					}
+				}
+			}
+
+			void quantizeQ8(uchar_* dst, int dst_size_l, const float* src, int src_size_l, int L, int H, float inv_scale, int zero_point)
+			{
+				const __m256 ymm_inv_scale = _mm256_set1_ps(inv_scale);
+				const __m256i ymm_zero_point = _mm256_set1_epi32(zero_point);
+
+				for (int y = 0; y < H; ++y)
+				{
+					const float* src_y = src + y * src_size_l;
+					uchar_* dst_y = dst + y * dst_size_l;
+
+					int x = 0;
+					for (; x + 32 <= L; x += 32)
+					{
+						const __m256i q0 = _mm256_add_epi32(_mm256_cvtps_epi32(_mm256_mul_ps(_mm256_loadu_ps(src_y + x), ymm_inv_scale)), ymm_zero_point);
+						const __m256i q1 = _mm256_add_epi32(_mm256_cvtps_epi32(_mm256_mul_ps(_mm256_loadu_ps(src_y + x + 8), ymm_inv_scale)), ymm_zero_point);
+						const __m256i q2 = _mm256_add_epi32(_mm256_cvtps_epi32(_mm256_mul_ps(_mm256_loadu_ps(src_y + x + 16), ymm_inv_scale)), ymm_zero_point);
+						const __m256i q3 = _mm256_add_epi32(_mm256_cvtps_epi32(_mm256_mul_ps(_mm256_loadu_ps(src_y + x + 24), ymm_inv_scale)), ymm_zero_point);
+
+						//packs interleave 128 bit lanes: dwords of the result are 0 2 4 6 1 3 5 7 of columns x + 4 k
+						const __m256i q = _mm256_packus_epi16(_mm256_packs_epi32(q0, q1), _mm256_packs_epi32(q2, q3));
+						_mm256_storeu_si256((__m256i*)(dst_y + x), _mm256_permutevar8x32_epi32(q, _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7)));
+					}
+					for (; x + 8 <= L; x += 8)
+					{
+						__m256i q = _mm256_add_epi32(_mm256_cvtps_epi32(_mm256_mul_ps(_mm256_loadu_ps(src_y + x), ymm_inv_scale)), ymm_zero_point);
+						q = _mm256_packs_epi32(q, q);
+						q = _mm256_packus_epi16(q, q);
+						_mm_storel_epi64((__m128i*)(dst_y + x), _mm_unpacklo_epi32(_mm256_castsi256_si128(q), _mm256_extracti128_si256(q, 1)));
+					}
+					for (; x < L; ++x)
+					{
+						const int q = _mm_cvtss_si32(_mm_set_ss(src_y[x] * inv_scale)) + zero_point;
+						dst_y[x] = uchar_(q < 0 ? 0 : (q > 255 ? 255 : q));
+					}
+				}
+
+				_mm256_zeroupper();
+			}
+
+			//NB vectors of outputs of hiddenOutputQ8 at x, chains of the vectors are independent; OUT outputs (0: out_count), so output sums
+			//of one output (detector) stay in registers
+			template <int NB, int OUT>
+			inline void hidden_output_block(float** dst, const float* const* src, const int x, const int connect, const int hl_groups, const int hl_scale,
+											const float* const* hl_w, const float* hl_b, const float* hl_tanh_w, const float* bn_w, const float* bn_b,
+											const int out_count, const float* const* ol_w, const float* ol_b, const float ol_tanh_w, const float* af_scale)
+			{
+				const Activation::tanh_tier tanh_f;
+				const __m256 half = _mm256_set1_ps(0.5f);
+				const int outs = OUT > 0 ? OUT : out_count;
+				__m256 ol[OUT > 0 ? OUT : Q8_MAX_OUTPUTS][NB];
+
+				for (int i = 0; i < hl_groups; ++i)
+				{
+					const __m256 tanh_w = _mm256_broadcast_ss(hl_tanh_w + i);
+					for (int t = 0; t < hl_scale; ++t)
+					{
+						const int n = hl_scale * i + t;
+						__m256 h[NB];
+						for (int b = 0; b < NB; ++b)
+						{
+							h[b] = _mm256_broadcast_ss(hl_b + n);
+						}
+						for (int j = 0; j < connect; ++j)
+						{
+							const __m256 w = _mm256_broadcast_ss(hl_w[n] + j);
+							for (int b = 0; b < NB; ++b)
+							{
+								const __m256 m = _mm256_loadu_ps(src[i + j] + x + 8 * b);
+#ifdef USE_FMA
+								h[b] = _mm256_fmadd_ps(m, w, h[b]);
+#else
+								h[b] = _mm256_add_ps(h[b], _mm256_mul_ps(m, w));
+#endif
+							}
+						}
+
+						const __m256 bn_w_t = _mm256_broadcast_ss(bn_w + t);
+						const __m256 bn_b_t = _mm256_broadcast_ss(bn_b + t);
+						for (int b = 0; b < NB; ++b)
+						{
+							h[b] = tanh_f(_mm256_mul_ps(h[b], tanh_w));
+							h[b] = _mm256_add_ps(_mm256_mul_ps(h[b], half), half);
+							h[b] = _mm256_add_ps(_mm256_mul_ps(h[b], bn_w_t), bn_b_t);
+						}
+
+						for (int k = 0; k < outs; ++k)
+						{
+							const __m256 w = _mm256_broadcast_ss(ol_w[k] + t * hl_groups + i);
+							for (int b = 0; b < NB; ++b)
+							{
+								if (n == 0)
+								{
+									ol[k][b] = _mm256_mul_ps(h[b], w);
+								}
+								else
+								{
+#ifdef USE_FMA
+									ol[k][b] = _mm256_fmadd_ps(h[b], w, ol[k][b]);
+#else
+									ol[k][b] = _mm256_add_ps(_mm256_mul_ps(h[b], w), ol[k][b]);
+#endif
+								}
+							}
+						}
+					}
+				}
+
+				for (int k = 0; k < outs; ++k)
+				{
+					const __m256 b_k = _mm256_broadcast_ss(ol_b + k);
+					const __m256 tanh_w = _mm256_set1_ps(ol_tanh_w);
+					const __m256 scale = _mm256_set1_ps(af_scale[k]);
+					for (int b = 0; b < NB; ++b)
+					{
+						__m256 y = tanh_f(_mm256_mul_ps(_mm256_add_ps(ol[k][b], b_k), tanh_w));
+						y = af_scale[k] == 0.f ? _mm256_add_ps(_mm256_mul_ps(y, half), half) : _mm256_mul_ps(y, scale);
+						_mm256_storeu_ps(dst[k] + x + 8 * b, y);
+					}
+				}
+			}
+
+			void hiddenOutputQ8(float** dst, const float* const* src, int size, int connect, int hl_size, int hl_scale, const float* const* hl_w,
+								const float* hl_b, const float* hl_tanh_w, const float* bn_w, const float* bn_b, int out_count, const float* const* ol_w,
+								const float* ol_b, float ol_tanh_w, const float* af_scale)
+			{
+				const int hl_groups = hl_size / hl_scale;
+
+				int x = 0;
+				if (out_count == 1)
+				{
+					for (; x + 32 <= size; x += 32)
+					{
+						hidden_output_block<4, 1>(dst, src, x, connect, hl_groups, hl_scale, hl_w, hl_b, hl_tanh_w, bn_w, bn_b, out_count, ol_w, ol_b, ol_tanh_w, af_scale);
+					}
+					for (; x < size; x += 8)
+					{
+						hidden_output_block<1, 1>(dst, src, x, connect, hl_groups, hl_scale, hl_w, hl_b, hl_tanh_w, bn_w, bn_b, out_count, ol_w, ol_b, ol_tanh_w, af_scale);
+					}
+				}
+				else
+				{
+					for (; x + 32 <= size; x += 32)
+					{
+						hidden_output_block<4, 0>(dst, src, x, connect, hl_groups, hl_scale, hl_w, hl_b, hl_tanh_w, bn_w, bn_b, out_count, ol_w, ol_b, ol_tanh_w, af_scale);
+					}
+					for (; x < size; x += 8)
+					{
+						hidden_output_block<1, 0>(dst, src, x, connect, hl_groups, hl_scale, hl_w, hl_b, hl_tanh_w, bn_w, bn_b, out_count, ol_w, ol_b, ol_tanh_w, af_scale);
+					}
+				}
+
+				_mm256_zeroupper();
+			}
+#endif
+		}
+	}
+
+#endif
+}
+
+#if defined(__GNUC__) && !defined(__clang__)
+#	pragma GCC diagnostic pop
+#endif
@@ -0,0 +1,140 @@
+/*
+*	Copyright (c) 2018, Ilya Kalinovskiy
+*	All rights reserved.
+*
+*	This is an implementation of the algorithm described in the following paper:
+*		I.A. Kalinovskiy, V.G. Spitsyn,
+*		Compact Convolutional Neural Network Cascade for Face Detection,
+*		http://arxiv.org/abs/1508.01292.
+*
+*	Redistribution and use of this program as source code or in binary form, with or without modifications, are permitted provided that the following conditions are met:
+*		1. Redistributions may not be sold, nor may they be used in a commercial product or activity without prior permission from the copyright holder (contact him at kua_21@mail.ru).
+*		2. Redistributions may not be used for military purposes.
+*		3. Any published work which utilizes this program shall include the reference to the paper available at http://arxiv.org/abs/1508.01292
+*		4. Redistributions must retain the above copyright notice and the reference to the algorithm on which the implementation is based on, this list of conditions and the following disclaimer.
+*
+*	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+*	IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#pragma once
+
+#include "config.h"
+
+
+//========================================================================================================
+
+
+namespace NeuralNetworksLib
+{
+#ifdef USE_CNTK_MODELS
+
+	namespace SIMD
+	{
+		//conv + leaky ReLU + bn (+ 2x2 max pool) kernels generated at compile time for kernel size, count of output maps
+		//of one input map and max pool (conv layers of SIMD::ConvNeuralNetwork); vector type is that of the build
+		namespace ConvTemplate
+		{
+			//dst[m] is output map m of src convolved by kernel kernels + m * kernel_w * kernel_h (row-major), m < maps,
+			//L x H conv outputs are written, (L / 2) x (H / 2) with max pool; conv_b, lrelu_w1, lrelu_w2, bn_b hold params of maps
+			typedef void(*Kernel)(float** dst, int dst_size_l, const float* src, int src_size_l, const float* kernels,
+								  const float* conv_b, const float* lrelu_w1, const float* lrelu_w2, const float* bn_b, int L, int H);
+
+			//instantiated shapes X(kernel_w, kernel_h, maps, pool): layer 1 (all maps of image), layers 2, 3 (2 maps of sum of input maps),
+			//add shapes of new model topologies here or define CONV_TEMPLATE_SHAPES before the build
+#ifndef CONV_TEMPLATE_SHAPES
+#	define CONV_TEMPLATE_SHAPES(X)																		\
+				X(3, 3, 4, true) X(3, 3, 6, true) X(3, 3, 8, true)											\
+				X(4, 4, 4, true) X(4, 4, 6, true) X(4, 4, 8, true) X(4, 4, 24, true)						\
+				X(5, 5, 4, true) X(5, 5, 6, true) X(5, 5, 8, true)											\
+				X(3, 3, 2, true) X(4, 4, 2, true) X(5, 5, 2, true)											\
+				X(3, 3, 2, false) X(4, 4, 2, false) X(4, 5, 2, false) X(5, 5, 2, false) X(5, 6, 2, false)	\
+				X(6, 6, 2, false) X(7, 7, 2, false) X(7, 8, 2, false) X(8, 8, 2, false) X(10, 11, 2, false)	\
+				X(11, 11, 2, false)
+#endif
+
+			//kernel of shape, nullptr if the shape is not instantiated
+			Kernel find(int kernel_w, int kernel_h, int maps, bool pool);
+
+			//kernel of fixed input geometry: L x H conv outputs are template arguments (stage 2/3 networks run on one input size),
+			//loops have constant bounds, the last vector block of a row is shifted left to end at the last output,
+			//rows narrower than the vector of the build use narrower vectors; only valid columns are read and written
+			typedef void(*FixedKernel)(float** dst, int dst_size_l, const float* src, int src_size_l, const float* kernels,
+									   const float* conv_b, const float* lrelu_w1, const float* lrelu_w2, const float* bn_b);
+
+			//instantiated geometries X(kernel_w, kernel_h, maps, pool, L, H): layers 1-3 of the shipped stage 2/3 models on the 36 x 40
+			//pattern and layers 1-2 on ext_pattern_size_cd 47 x 51 of CNNDetector (layer 3 on 4 x 4 outputs is faster in the direct kernel),
+			//define CONV_TEMPLATE_FIXED_SHAPES before the build for other models or empty to disable
+#ifndef CONV_TEMPLATE_FIXED_SHAPES
+#	define CONV_TEMPLATE_FIXED_SHAPES(X)													\
+				X(4, 4, 6, true, 33, 37) X(3, 3, 2, true, 14, 16) X(7, 8, 2, false, 1, 1)	\
+				X(4, 4, 6, true, 44, 48) X(3, 3, 2, true, 20, 22)
+#endif
+
+			//kernel of shape and geometry, nullptr if it is not instantiated
+			FixedKernel findFixed(int kernel_w, int kernel_h, int maps, bool pool, int L, int H);
+
+#ifdef USE_AVX2
+			//int8 conv layers: src are src_count maps of u8 activations, M output maps of each of them are computed (map m of src i is
+			//output map i * M + m), kernels are 7 bit weights packed by packKernelsQ8, params hold Q8_PARAMS floats of every output map:
+			//scale of conv sum, bias (zero point of input folded in), lrelu_w1, lrelu_w2, bn_b; rows of src and dst are read and written
+			//in blocks of 8 outputs, so buffers need Q8_PADDING bytes after the last row and dst rows of multiple of 8 columns
+			enum { Q8_PARAMS = 5, Q8_BLOCK = 2, Q8_MAX_MAPS = 32, Q8_PADDING = 64 };
+
+			//conv + leaky ReLU + bn + 2x2 max pool, dst are u8 input maps of next layer: dst[j] is sum of pooled maps j - 1, j, j + 1
+			//quantized by inv_scale and zero_point (as SumPoolMaps), activations stay u8 between layers
+			typedef void(*PoolKernelQ8)(uchar_** dst, int dst_size_l, const uchar_* const* src, int src_size_l, int src_count, const int* kernels,
+										const float* params, float inv_scale, int zero_point, int L, int H);
+			//conv + leaky ReLU + bn of last conv layer, dst are float maps
+			typedef void(*KernelQ8)(float** dst, int dst_size_l, const uchar_* const* src, int src_size_l, int src_count, const int* kernels,
+									const float* params, int L, int H);
+
+			//instantiated shapes X(kernel_w, kernel_h, maps, pool), maps is output maps per src (even), layers without max pool are last
+#ifndef CONV_TEMPLATE_Q8_SHAPES
+#	define CONV_TEMPLATE_Q8_SHAPES(X)																\
+				X(3, 3, 4, true) X(3, 3, 6, true) X(4, 4, 4, true) X(4, 4, 6, true) X(4, 4, 8, true)	\
+				X(3, 3, 2, true) X(4, 4, 2, true) X(5, 5, 2, true)										\
+				X(3, 3, 2, false) X(4, 4, 2, false) X(4, 5, 2, false) X(5, 5, 2, false)					\
+				X(6, 6, 2, false) X(7, 7, 2, false) X(7, 8, 2, false) X(8, 8, 2, false)
+#endif
+
+			//kernels of shape, vpdpbusd kernels if they are enabled, nullptr if the shape is not instantiated
+			PoolKernelQ8 findPoolQ8(int kernel_w, int kernel_h, int maps);
+			KernelQ8 findQ8(int kernel_w, int kernel_h, int maps);
+
+			//weights kernels[map][ky][kx] of maps are packed by blocks of Q8_BLOCK maps as dst[block][ky][kx / 4][map of block],
+			//4 weights of a row in an int (zero past kernel_w); dst has maps * kernel_h * ((kernel_w + 3) / 4) ints
+			void packKernelsQ8(int* dst, const signed char* kernels, int kernel_w, int kernel_h, int maps);
+
+			//u8 input of layer 1: dst = clamp(round(src * inv_scale) + zero_point, 0, 255)
+			void quantizeQ8(uchar_* dst, int dst_size_l, const float* src, int src_size_l, int L, int H, float inv_scale, int zero_point);
+
+			//hidden and output layers on size values of float maps src of layer 3, 32 values at a time with hidden neurons in registers:
+			//hidden neuron n = hl_scale * i + t reads src[i] .. src[i + connect - 1] (hl_w[n], hl_b[n], hl_tanh_w[i], bn_w[t], bn_b[t]),
+			//dst[k] is output neuron of ol_w[k] (index t * (hl_size / hl_scale) + i), ol_b[k], af_scale[k] (0 - sigmoid), out_count <= Q8_MAX_OUTPUTS;
+			//operations are those of CNNPP::mulCN_add_tanhW, mulC, mulC1_add, tanhW, so outputs equal Run_HL, size is rounded up to 8
+			enum { Q8_MAX_OUTPUTS = 8 };
+			void hiddenOutputQ8(float** dst, const float* const* src, int size, int connect, int hl_size, int hl_scale, const float* const* hl_w,
+								const float* hl_b, const float* hl_tanh_w, const float* bn_w, const float* bn_b, int out_count, const float* const* ol_w,
+								const float* ol_b, float ol_tanh_w, const float* af_scale);
+
+			//vpdpbusd versions of int8 kernels (AVX512-VNNI or AVX-VNNI of cpu and compiler), bit-exact with the _mm256_maddubs_epi16
+			//kernels (7 bit weights do not saturate), selected by find functions; global switch for validation, not thread safe
+			bool isVNNISupported();
+			bool isVNNIEnabled();
+			void setVNNIEnabled(bool enabled);
+
+			//cnnpp_simd_template_vnni.cpp, compiled with VNNI flags of CMakeLists.txt: 0 - not compiled, 1 - AVX512-VNNI, 2 - AVX-VNNI
+			namespace VNNI
+			{
+				int getInstructionSet();
+				PoolKernelQ8 findPoolQ8(int kernel_w, int kernel_h, int maps);
+				KernelQ8 findQ8(int kernel_w, int kernel_h, int maps);
+			}
+#endif
+		}
+	}
+
+#endif
+}
@@ -0,0 +1,363 @@
+/*
+*	Copyright (c) 2018, Ilya Kalinovskiy
+*	All rights reserved.
+*
+*	This is an implementation of the algorithm described in the following paper:
+*		I.A. Kalinovskiy, V.G. Spitsyn,
+*		Compact Convolutional Neural Network Cascade for Face Detection,
+*		http://arxiv.org/abs/1508.01292.
+*
+*	Redistribution and use of this program as source code or in binary form, with or without modifications, are permitted provided that the following conditions are met:
+*		1. Redistributions may not be sold, nor may they be used in a commercial product or activity without prior permission from the copyright holder (contact him at kua_21@mail.ru).
+*		2. Redistributions may not be used for military purposes.
+*		3. Any published work which utilizes this program shall include the reference to the paper available at http://arxiv.org/abs/1508.01292
+*		4. Redistributions must retain the above copyright notice and the reference to the algorithm on which the implementation is based on, this list of conditions and the following disclaimer.
+*
+*	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+*	IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+//int8 kernels of ConvTemplate, included by cnnpp_simd_template.cpp (_mm256_maddubs_epi16) and cnnpp_simd_template_vnni.cpp (vpdpbusd):
+//the including file defines struct DotQ8 { enum { MB }; static __m256i dot(acc, a, w); } before the include, MB is maps per pass
+//of pool kernels (multiple of Q8_BLOCK); everything is in an anonymous namespace, so kernels of both files are not merged by the linker
+
+#pragma once
+
+#include "cnnpp_simd_template.h"
+#include <immintrin.h>
+
+
+//========================================================================================================
+
+
+namespace NeuralNetworksLib
+{
+#if defined(USE_CNTK_MODELS) && defined(USE_AVX2)
+
+	namespace SIMD
+	{
+		namespace ConvTemplate
+		{
+			namespace
+			{
+				//x = acc * scale + bias, leaky ReLU + bn as LReLU_BN; pool is max of activations of 4 conv sums, which is the activation
+				//of their max (min) sum if the activation is non-decreasing (non-increasing) in the sum
+				struct EpilogueQ8
+				{
+					__m256 scale, bias, lrelu_w1, lrelu_w2, bn_b;
+					int monotone;
+
+					inline void set(const float* params)
+					{
+						scale = _mm256_set1_ps(params[0]);
+						bias = _mm256_set1_ps(params[1]);
+						lrelu_w1 = _mm256_set1_ps(params[2]);
+						lrelu_w2 = _mm256_set1_ps(params[3]);
+						bn_b = _mm256_set1_ps(params[4]);
+
+						const float w1 = params[2];
+						const float w2 = params[2] + params[3];
+						const int slope = w1 >= 0.f && w2 >= 0.f ? 1 : (w1 <= 0.f && w2 <= 0.f ? -1 : 0);
+						monotone = params[0] >= 0.f ? slope : -slope;
+					}
+					inline __m256 operator()(const __m256i acc) const
+					{
+						const __m256 x = _mm256_fmadd_ps(_mm256_cvtepi32_ps(acc), scale, bias);
+						const __m256 relu = _mm256_max_ps(x, _mm256_setzero_ps());
+						return _mm256_fmadd_ps(relu, lrelu_w2, _mm256_fmadd_ps(x, lrelu_w1, bn_b));
+					}
+					inline __m256 pool(const __m256i* c) const
+					{
+						if (monotone > 0) return (*this)(_mm256_max_epi32(_mm256_max_epi32(c[0], c[1]), _mm256_max_epi32(c[2], c[3])));
+						if (monotone < 0) return (*this)(_mm256_min_epi32(_mm256_min_epi32(c[0], c[1]), _mm256_min_epi32(c[2], c[3])));
+						return _mm256_max_ps(_mm256_max_ps((*this)(c[0]), (*this)(c[1])), _mm256_max_ps((*this)(c[2]), (*this)(c[3])));
+					}
+				};
+
+				//packed weights of row ky, dword group g of map m (maps of pass start at a block)
+				template <int KH, int W4>
+				inline __m256i weights_q8(const int* kernels, const int m, const int ky, const int g)
+				{
+					return _mm256_set1_epi32(kernels[(((m / Q8_BLOCK) * KH + ky) * W4 + g) * Q8_BLOCK + m % Q8_BLOCK]);
+				}
+
+				//4 u8 inputs of each of 8 lanes from 16 bytes at p and p + offset (pshufb works in 128 bit halves)
+				inline __m256i load_q8(const uchar_* p, const int offset, const __m256i shuffle)
+				{
+					const __m256i s = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128((const __m128i*)p)), _mm_loadu_si128((const __m128i*)(p + offset)), 1);
+					return _mm256_shuffle_epi8(s, shuffle);
+				}
+
+				//8 pooled outputs of MB maps: sums of conv columns 2k (even) and 2k + 1 (odd) of conv rows 0, 1 in c[m][0..3],
+				//input row y is kernel row y of conv row 0 and kernel row y - 1 of conv row 1
+				template <typename DOT, int KW, int KH, int MB>
+				inline void conv_pool_block_q8(__m256* dst, const uchar_* src, const int src_size_l, const int* kernels, const EpilogueQ8* ep,
+											   const __m256i even, const __m256i odd)
+				{
+					enum { W4 = (KW + 3) / 4 };
+
+					__m256i c[MB][4];
+					for (int m = 0; m < MB; ++m)
+					{
+						for (int k = 0; k < 4; ++k)
+						{
+							c[m][k] = _mm256_setzero_si256();
+						}
+					}
+
+					for (int y = 0; y <= KH; ++y)
+					{
+						for (int g = 0; g < W4; ++g)
+						{
+							const uchar_* p = src + y * src_size_l + 4 * g;
+							const __m256i a = load_q8(p, 8, even);
+							const __m256i b = load_q8(p, 8, odd);
+
+							for (int m = 0; m < MB; ++m)
+							{
+								if (y < KH)
+								{
+									const __m256i w = weights_q8<KH, W4>(kernels, m, y, g);
+									c[m][0] = DOT::dot(c[m][0], a, w);
+									c[m][1] = DOT::dot(c[m][1], b, w);
+								}
+								if (y > 0)
+								{
+									const __m256i w = weights_q8<KH, W4>(kernels, m, y - 1, g);
+									c[m][2] = DOT::dot(c[m][2], a, w);
+									c[m][3] = DOT::dot(c[m][3], b, w);
+								}
+							}
+						}
+					}
+
+					for (int m = 0; m < MB; ++m)
+					{
+						dst[m] = ep[m].pool(c[m]);
+					}
+				}
+
+				//8 u8 inputs of next layer of each of T pooled maps: sums of neighbour maps as SumPoolMaps, quantized
+				inline void store_sum_q8(uchar_** dst, const int offset, const __m256* p, const int T, const __m256 inv_scale, const __m256i zero_point)
+				{
+					for (int j = 0; j < T; ++j)
+					{
+						__m256 sum = p[j];
+						if (j > 0) sum = _mm256_add_ps(sum, p[j - 1]);
+						if (j < T - 1) sum = _mm256_add_ps(sum, p[j + 1]);
+
+						__m256i q = _mm256_add_epi32(_mm256_cvtps_epi32(_mm256_mul_ps(sum, inv_scale)), zero_point);
+						q = _mm256_packs_epi32(q, q);
+						q = _mm256_packus_epi16(q, q);
+						_mm_storel_epi64((__m128i*)(dst[j] + offset), _mm_unpacklo_epi32(_mm256_castsi256_si128(q), _mm256_extracti128_si256(q, 1)));
+					}
+				}
+
+				//pooled maps of all src are kept in registers of a block of 8 outputs, so neighbour maps are summed and quantized
+				//without float buffers of layer
+				template <typename DOT, int KW, int KH, int M>
+				void conv_pool_q8(uchar_** dst, int dst_size_l, const uchar_* const* src, int src_size_l, int src_count, const int* kernels,
+								  const float* params, float inv_scale, int zero_point, int L, int H)
+				{
+					enum { W4 = (KW + 3) / 4, MB = DOT::MB < M ? DOT::MB : M, MR = M % MB, K = M * KH * W4 };
+					static_assert(M % Q8_BLOCK == 0 && MB % Q8_BLOCK == 0, "maps are packed by blocks");
+
+					const int T = src_count * M;
+					EpilogueQ8 ep[Q8_MAX_MAPS];
+					for (int j = 0; j < T; ++j)
+					{
+						ep[j].set(params + j * Q8_PARAMS);
+					}
+
+					const __m256i even = _mm256_setr_epi8(0, 1, 2, 3, 2, 3, 4, 5, 4, 5, 6, 7, 6, 7, 8, 9, 0, 1, 2, 3, 2, 3, 4, 5, 4, 5, 6, 7, 6, 7, 8, 9);
+					const __m256i odd = _mm256_setr_epi8(1, 2, 3, 4, 3, 4, 5, 6, 5, 6, 7, 8, 7, 8, 9, 10, 1, 2, 3, 4, 3, 4, 5, 6, 5, 6, 7, 8, 7, 8, 9, 10);
+					const __m256 ymm_inv_scale = _mm256_set1_ps(inv_scale);
+					const __m256i ymm_zero_point = _mm256_set1_epi32(zero_point);
+
+					const int L_out = L >> 1;
+					const int H_out = H >> 1;
+
+					__m256 p[Q8_MAX_MAPS];
+					for (int y = 0; y < H_out; ++y)
+					{
+						for (int x = 0; x < L_out; x += 8)
+						{
+							for (int i = 0; i < src_count; ++i)
+							{
+								const uchar_* src_yx = src[i] + 2 * (y * src_size_l + x);
+								const int* kernels_i = kernels + i * K;
+
+								int m = 0;
+								for (; m + MB <= M; m += MB)
+								{
+									conv_pool_block_q8<DOT, KW, KH, MB>(p + i * M + m, src_yx, src_size_l, kernels_i + m * KH * W4, ep + i * M + m, even, odd);
+								}
+								if (MR > 0)
+								{
+									conv_pool_block_q8<DOT, KW, KH, (MR > 0 ? int(MR) : int(Q8_BLOCK))>(p + i * M + m, src_yx, src_size_l, kernels_i + m * KH * W4, ep + i * M + m, even, odd);
+								}
+							}
+
+							store_sum_q8(dst, y * dst_size_l + x, p, T, ymm_inv_scale, ymm_zero_point);
+						}
+					}
+
+					_mm256_zeroupper();
+				}
+
+				//8 outputs of R rows of MB maps, input row y is kernel row y - r of conv row r
+				template <typename DOT, int KW, int KH, int MB, int R>
+				inline void conv_block_q8(float** dst, const int offset, const int dst_size_l, const uchar_* src, const int src_size_l, const int* kernels,
+										  const EpilogueQ8* ep, const __m256i seq)
+				{
+					enum { W4 = (KW + 3) / 4 };
+
+					__m256i c[MB][R];
+					for (int m = 0; m < MB; ++m)
+					{
+						for (int r = 0; r < R; ++r)
+						{
+							c[m][r] = _mm256_setzero_si256();
+						}
+					}
+
+					for (int y = 0; y < KH + R - 1; ++y)
+					{
+						for (int g = 0; g < W4; ++g)
+						{
+							const __m256i a = load_q8(src + y * src_size_l + 4 * g, 4, seq);
+
+							for (int m = 0; m < MB; ++m)
+							{
+								for (int r = 0; r < R; ++r)
+								{
+									if (y - r >= 0 && y - r < KH)
+									{
+										c[m][r] = DOT::dot(c[m][r], a, weights_q8<KH, W4>(kernels, m, y - r, g));
+									}
+								}
+							}
+						}
+					}
+
+					for (int m = 0; m < MB; ++m)
+					{
+						for (int r = 0; r < R; ++r)
+						{
+							_mm256_storeu_ps(dst[m] + offset + r * dst_size_l, ep[m](c[m][r]));
+						}
+					}
+				}
+
+				template <typename DOT, int KW, int KH, int MB, int R>
+				inline void conv_rows_q8(float** dst, const int dst_size_l, const uchar_* src, const int src_size_l, const int* kernels,
+										 const EpilogueQ8* ep, const __m256i seq, const int y, const int L)
+				{
+					for (int x = 0; x < L; x += 8)
+					{
+						conv_block_q8<DOT, KW, KH, MB, R>(dst, y * dst_size_l + x, dst_size_l, src + y * src_size_l + x, src_size_l, kernels, ep, seq);
+					}
+				}
+
+				//last conv layer: float maps of each src in pairs of rows
+				template <typename DOT, int KW, int KH, int M>
+				void conv_q8(float** dst, int dst_size_l, const uchar_* const* src, int src_size_l, int src_count, const int* kernels,
+							 const float* params, int L, int H)
+				{
+					enum { W4 = (KW + 3) / 4, MB = 4 < M ? 4 : M, MR = M % MB, K = M * KH * W4 };
+					static_assert(M % Q8_BLOCK == 0 && MB % Q8_BLOCK == 0, "maps are packed by blocks");
+
+					const __m256i seq = _mm256_setr_epi8(0, 1, 2, 3, 1, 2, 3, 4, 2, 3, 4, 5, 3, 4, 5, 6, 0, 1, 2, 3, 1, 2, 3, 4, 2, 3, 4, 5, 3, 4, 5, 6);
+
+					for (int i = 0; i < src_count; ++i)
+					{
+						EpilogueQ8 ep[M];
+						for (int m = 0; m < M; ++m)
+						{
+							ep[m].set(params + (i * M + m) * Q8_PARAMS);
+						}
+
+						for (int m = 0; m < M; m += MB)
+						{
+							float** dst_m = dst + i * M + m;
+							const int* kernels_m = kernels + i * K + m * KH * W4;
+
+							int y = 0;
+							if (m + MB <= M)
+							{
+								for (; y + 2 <= H; y += 2)
+								{
+									conv_rows_q8<DOT, KW, KH, MB, 2>(dst_m, dst_size_l, src[i], src_size_l, kernels_m, ep + m, seq, y, L);
+								}
+								if (y < H)
+								{
+									conv_rows_q8<DOT, KW, KH, MB, 1>(dst_m, dst_size_l, src[i], src_size_l, kernels_m, ep + m, seq, y, L);
+								}
+							}
+							else
+							{
+								enum { MR_ = MR > 0 ? int(MR) : int(Q8_BLOCK) };
+								for (; y + 2 <= H; y += 2)
+								{
+									conv_rows_q8<DOT, KW, KH, MR_, 2>(dst_m, dst_size_l, src[i], src_size_l, kernels_m, ep + m, seq, y, L);
+								}
+								if (y < H)
+								{
+									conv_rows_q8<DOT, KW, KH, MR_, 1>(dst_m, dst_size_l, src[i], src_size_l, kernels_m, ep + m, seq, y, L);
+								}
+							}
+						}
+					}
+
+					_mm256_zeroupper();
+				}
+
+				//kernels of instantiated shape, layers with max pool have pool kernels only
+				template <int KW, int KH, int M, bool POOL>
+				struct KernelsQ8
+				{
+					static PoolKernelQ8 pool() { return conv_pool_q8<DotQ8, KW, KH, M>; }
+					static KernelQ8 last() { return nullptr; }
+				};
+				template <int KW, int KH, int M>
+				struct KernelsQ8<KW, KH, M, false>
+				{
+					static PoolKernelQ8 pool() { return nullptr; }
+					static KernelQ8 last() { return conv_q8<DotQ8, KW, KH, M>; }
+				};
+
+				PoolKernelQ8 findPoolQ8Impl(int kernel_w, int kernel_h, int maps)
+				{
+#define CONV_TEMPLATE_FIND_POOL_Q8(KW, KH, M, POOL)						\
+					if (POOL && kernel_w == KW && kernel_h == KH && maps == M)	\
+					{															\
+						return KernelsQ8<KW, KH, M, POOL>::pool();				\
+					}
+
+					CONV_TEMPLATE_Q8_SHAPES(CONV_TEMPLATE_FIND_POOL_Q8)
+
+#undef CONV_TEMPLATE_FIND_POOL_Q8
+
+					return nullptr;
+				}
+				KernelQ8 findQ8Impl(int kernel_w, int kernel_h, int maps)
+				{
+#define CONV_TEMPLATE_FIND_Q8(KW, KH, M, POOL)								\
+					if (!POOL && kernel_w == KW && kernel_h == KH && maps == M)	\
+					{															\
+						return KernelsQ8<KW, KH, M, POOL>::last();				\
+					}
+
+					CONV_TEMPLATE_Q8_SHAPES(CONV_TEMPLATE_FIND_Q8)
+
+#undef CONV_TEMPLATE_FIND_Q8
+
+					return nullptr;
+				}
+			}
+		}
+	}
+
+#endif
+}
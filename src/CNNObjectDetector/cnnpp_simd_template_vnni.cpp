@@ -0,0 +1,118 @@
+/*
+*	Copyright (c) 2018, Ilya Kalinovskiy
+*	All rights reserved.
+*
+*	This is an implementation of the algorithm described in the following paper:
+*		I.A. Kalinovskiy, V.G. Spitsyn,
+*		Compact Convolutional Neural Network Cascade for Face Detection,
+*		http://arxiv.org/abs/1508.01292.
+*
+*	Redistribution and use of this program as source code or in binary form, with or without modifications, are permitted provided that the following conditions are met:
+*		1. Redistributions may not be sold, nor may they be used in a commercial product or activity without prior permission from the copyright holder (contact him at kua_21@mail.ru).
+*		2. Redistributions may not be used for military purposes.
+*		3. Any published work which utilizes this program shall include the reference to the paper available at http://arxiv.org/abs/1508.01292
+*		4. Redistributions must retain the above copyright notice and the reference to the algorithm on which the implementation is based on, this list of conditions and the following disclaimer.
+*
+*	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+*	IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+//int8 kernels of ConvTemplate on vpdpbusd, compiled with AVX-512 VNNI (or AVX-VNNI) flags and selected at runtime by ConvTemplate::findPoolQ8
+
+#include "cnnpp_simd_template.h"
+
+#if defined(__GNUC__) && !defined(__clang__)
+#	pragma GCC diagnostic push
+#	pragma GCC diagnostic ignored "-Wignored-attributes"
+#endif
+
+#if defined(USE_CNTK_MODELS) && defined(USE_AVX2) && ((defined(__AVX512VNNI__) && defined(__AVX512VL__)) || defined(__AVXVNNI__))
+#	define CONV_TEMPLATE_VNNI
+#	include <immintrin.h>
+
+namespace NeuralNetworksLib
+{
+	namespace SIMD
+	{
+		namespace ConvTemplate
+		{
+			namespace
+			{
+				//one instruction per dot of 4 pairs, AVX-512 has 32 vector registers for 16 accumulators of 4 maps per pass
+				struct DotQ8
+				{
+#ifdef __AVX512VL__
+					enum { MB = 2 * Q8_BLOCK };
+#else
+					enum { MB = Q8_BLOCK };
+#endif
+					static inline __m256i dot(const __m256i acc, const __m256i a, const __m256i w)
+					{
+#if defined(__AVX512VNNI__) && defined(__AVX512VL__)
+						return _mm256_dpbusd_epi32(acc, a, w);
+#else
+						return _mm256_dpbusd_avx_epi32(acc, a, w);
+#endif
+					}
+				};
+			}
+		}
+	}
+}
+#	include "cnnpp_simd_template_q8.h"
+#endif
+
+
+//========================================================================================================
+
+
+namespace NeuralNetworksLib
+{
+#if defined(USE_CNTK_MODELS) && defined(USE_AVX2)
+
+	namespace SIMD
+	{
+		namespace ConvTemplate
+		{
+			namespace VNNI
+			{
+				int getInstructionSet()
+				{
+#if !defined(CONV_TEMPLATE_VNNI)
+					return 0;
+#elif defined(__AVX512VNNI__) && defined(__AVX512VL__)
+					return 1;
+#else
+					return 2;
+#endif
+				}
+
+				PoolKernelQ8 findPoolQ8(int kernel_w, int kernel_h, int maps)
+				{
+#ifdef CONV_TEMPLATE_VNNI
+					return findPoolQ8Impl(kernel_w, kernel_h, maps);
+#else
+					(void)kernel_w; (void)kernel_h; (void)maps;
+					return nullptr;
+#endif
+				}
+				KernelQ8 findQ8(int kernel_w, int kernel_h, int maps)
+				{
+#ifdef CONV_TEMPLATE_VNNI
+					return findQ8Impl(kernel_w, kernel_h, maps);
+#else
+					(void)kernel_w; (void)kernel_h; (void)maps;
+					return nullptr;
+#endif
+				}
+			}
+		}
+	}
+
+#endif
+}
+
+#if defined(__GNUC__) && !defined(__clang__)
+#	pragma GCC diagnostic pop
+#endif
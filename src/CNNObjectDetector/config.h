@@ -30,6 +30,7 @@ namespace NeuralNetworksLib
 	//#define USE_SSE
 	//#define USE_AVX
 	//#define USE_AVX2
+	//#define USE_F16C
 
 	//#define USE_CUDA
 	//#define USE_CL
@@ -57,6 +58,10 @@ namespace NeuralNetworksLib
 	#	endif
 	#endif
 
+	#if defined(USE_F16C) && defined(USE_AVX) && defined(USE_CNTK_MODELS) && !defined(USE_HF)
+	#	define USE_HF
+	#endif
+
 	#define USE_FAST_TANH
 
 	#ifndef CHECK_TEST
@@ -87,7 +92,11 @@ namespace NeuralNetworksLib
 	#endif
 
 	#ifdef USE_OMP
-	#	define OMP_PRAGMA(pragma) __pragma (pragma)
+	#	ifdef _MSC_VER
+	#		define OMP_PRAGMA(pragma) __pragma (pragma)
+	#	else
+	#		define OMP_PRAGMA(pragma) _Pragma (#pragma)
+	#	endif
 	#	define OMP_RUNTIME(func) func;
 	#else
 	#	define OMP_PRAGMA(pragma)
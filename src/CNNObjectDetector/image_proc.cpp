@@ -124,7 +124,7 @@ namespace NeuralNetworksLib
 #endif
 
 #if defined(USE_AVX2)
-			const __m128i xmm_mask = { 0, 1, 3, 4, 6, 7, 9, 10, 2, 128, 5, 128, 8, 128, 11, 128 };
+			const __m128i xmm_mask = _mm_setr_epi8(0, 1, 3, 4, 6, 7, 9, 10, 2, 128, 5, 128, 8, 128, 11, 128);
 			const __m256 ymm_w1 = { 0.114f, 0.587f, 0.114f, 0.587f, 0.114f, 0.587f, 0.114f, 0.587f };
 			const __m256 ymm_w2 = { 0.299f, 0.0f, 0.299f, 0.0f, 0.299f, 0.0f, 0.299f, 0.0f };
 #endif
@@ -141,7 +141,8 @@ namespace NeuralNetworksLib
 				int i = 0;
 
 #if defined(USE_SSE) || (defined(USE_AVX) && !defined(USE_AVX2))
-				for (; i <= img_color.width - 4; i += 4)
+				//16-byte load of 4 pixels (12 bytes) must stay inside the row
+				for (; i <= img_color.width - 6; i += 4)
 				{
 					__m128i xmm3i = _mm_loadu_si128((__m128i*)pSrc);
 					pSrc += 3 * 4;
@@ -172,7 +173,7 @@ namespace NeuralNetworksLib
 #endif
 
 #if defined(USE_AVX2)
-				for (; i <= img_color.width - 4; i += 4)
+				for (; i <= img_color.width - 6; i += 4)
 				{
 					__m128i xmm3i = _mm_loadu_si128((__m128i*)pSrc);
 					pSrc += 3 * 4;
@@ -568,9 +569,9 @@ namespace NeuralNetworksLib
 			const __m256 ymm15 = _mm256_broadcast_ss(&kernel[2]);
 #else
 #	ifdef USE_SSE
-			const __m128 ymm13 = _mm_broadcast_ss(&kernel[0]);
-			const __m128 ymm14 = _mm_broadcast_ss(&kernel[1]);
-			const __m128 ymm15 = _mm_broadcast_ss(&kernel[2]);
+			const __m128 ymm13 = _mm_set1_ps(kernel[0]);
+			const __m128 ymm14 = _mm_set1_ps(kernel[1]);
+			const __m128 ymm15 = _mm_set1_ps(kernel[2]);
 #	endif
 #endif
 
@@ -699,9 +700,9 @@ namespace NeuralNetworksLib
 					ymm2 = _mm_dp_ps(ymm2, ymm15, 244);
 					ymm3 = _mm_dp_ps(ymm3, ymm15, 248);
 
-					ymm0 = _mm_blend_ps(ymm0, ymm1, 34);
-					ymm0 = _mm_blend_ps(ymm0, ymm2, 68);
-					ymm0 = _mm_blend_ps(ymm0, ymm3, 136);
+					ymm0 = _mm_blend_ps(ymm0, ymm1, 2);
+					ymm0 = _mm_blend_ps(ymm0, ymm2, 4);
+					ymm0 = _mm_blend_ps(ymm0, ymm3, 8);
 
 					_mm_storeu_ps(pDst, ymm0);
 					pDst += REG_SIZE;
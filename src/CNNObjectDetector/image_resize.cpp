@@ -21,6 +21,7 @@
 #include "image_resize.h"
 
 #include <cmath>
+#include <vector>
 
 #if defined(USE_SSE) || defined(USE_AVX)
 #	include <immintrin.h>
@@ -202,7 +203,7 @@ namespace NeuralNetworksLib
 #endif
 
 #if defined(USE_SSE) || defined(USE_AVX) || defined(USE_AVX2)
-			__m128i ymm_mask = { 0, 2, 4, 6, 1, 3, 5, 7, 8, 10, 12, 14, 9, 11, 13, 15 };
+			__m128i ymm_mask = _mm_setr_epi8(0, 2, 4, 6, 1, 3, 5, 7, 8, 10, 12, 14, 9, 11, 13, 15);
 #else
 			uchar_ ymm_mask[16] = { 0, 2, 4, 6, 1, 3, 5, 7, 8, 10, 12, 14, 9, 11, 13, 15 };
 #endif
@@ -588,6 +589,71 @@ namespace NeuralNetworksLib
 			_pxLine = pxLine();
 			_pyLine = pyLine();
 		}
+
+		void FeatureMapsResize(Image_32f& dst, Image_32f& src, int map_count, float scale_x, float offset_x, float scale_y, float offset_y, int num_threads)
+		{
+			if (map_count <= 0 || dst.isEmpty() || src.isEmpty()) return;
+
+			const int dst_cols = dst.width;
+			const int dst_rows = dst.height / map_count;
+			const int src_cols = src.width;
+			const int src_rows = src.height / map_count;
+			if (dst_cols <= 0 || dst_rows <= 0 || src_cols <= 0 || src_rows <= 0) return;
+
+			std::vector<int> px(dst_cols);
+			std::vector<float> ax(dst_cols);
+			for (int x = 0; x < dst_cols; ++x)
+			{
+				const float sx = MIN(MAX(scale_x * float(x) + offset_x, 0.f), float(src_cols - 1));
+				px[x] = MIN((int)sx, MAX(src_cols - 2, 0));
+				ax[x] = src_cols > 1 ? sx - float(px[x]) : 0.f;
+			}
+
+			std::vector<int> py(dst_rows);
+			std::vector<float> ay(dst_rows);
+			for (int y = 0; y < dst_rows; ++y)
+			{
+				const float sy = MIN(MAX(scale_y * float(y) + offset_y, 0.f), float(src_rows - 1));
+				py[y] = MIN((int)sy, MAX(src_rows - 2, 0));
+				ay[y] = src_rows > 1 ? sy - float(py[y]) : 0.f;
+			}
+
+			const int dx = src_cols > 1 ? 1 : 0;
+			const int dy = src_rows > 1 ? src.widthStep : 0;
+
+			auto resize_row = [&](int map, int y)
+			{
+				const float* pSrc = src.data + (map * src_rows + py[y]) * src.widthStep;
+				float* pDst = dst.data + (map * dst_rows + y) * dst.widthStep;
+				const float fy = ay[y];
+
+				for (int x = 0; x < dst_cols; ++x)
+				{
+					const float* p = pSrc + px[x];
+					const float top = p[0] + ax[x] * (p[dx] - p[0]);
+					const float bottom = p[dy] + ax[x] * (p[dy + dx] - p[dy]);
+					pDst[x] = top + fy * (bottom - top);
+				}
+			};
+
+#ifndef USE_OMP
+			(void)num_threads;
+			for (int map = 0; map < map_count; ++map)
+			{
+				for (int y = 0; y < dst_rows; ++y)
+				{
+					resize_row(map, y);
+				}
+			}
+#else
+			OMP_PRAGMA(omp parallel for num_threads(num_threads))
+			for (int i = 0; i < map_count * dst_rows; ++i)
+			{
+				const int map = i / dst_rows;
+				resize_row(map, i - map * dst_rows);
+			}
+#endif
+		}
 	}
 
 }
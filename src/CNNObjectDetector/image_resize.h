@@ -64,5 +64,9 @@ namespace NeuralNetworksLib
 			void FastImageResize(Image_32f& dst, Image_32f& src, const int type_resize, int num_threads = 1);
 			void getLineIndexes(uint_*& _pxLine, uint_*& _pyLine, const Size& _dst_img_size, const Size& _src_img_size);
 		};
+
+		//bilinear resampling of map_count maps stacked by rows (map height = image height / map_count):
+		//dst(x, y) = src(scale_x * x + offset_x, scale_y * y + offset_y), source coordinates are clamped to map borders
+		void FeatureMapsResize(Image_32f& dst, Image_32f& src, int map_count, float scale_x, float offset_x, float scale_y, float offset_y, int num_threads = 1);
 	}
 }
\ No newline at end of file
@@ -4,6 +4,9 @@
 
 
 #include "packing_2D.h"
+#include <algorithm>
+#include <numeric>
+#include <climits>
 //#include <opencv2/opencv.hpp>
 
 
@@ -190,4 +193,339 @@ namespace NeuralNetworksLib
 		}
 	}
 
+
+	//================================================================================================================================================
+
+	static inline bool overlaps(const Rect& a, const Rect& b)
+	{
+		return a.x < b.x2 && b.x < a.x2 && a.y < b.y2 && b.y < a.y2;
+	}
+	static inline bool contains(const Rect& a, const Rect& b)
+	{
+		return b.x >= a.x && b.y >= a.y && b.x2 <= a.x2 && b.y2 <= a.y2;
+	}
+	static std::vector<int> getPackingOrder(const std::vector<Rect>& levels)
+	{
+		//tall levels first, rotation is not allowed
+		std::vector<int> order(levels.size());
+		std::iota(order.begin(), order.end(), 0);
+		std::stable_sort(order.begin(), order.end(), [&levels](int a, int b)
+		{
+			return levels[a].height > levels[b].height || (levels[a].height == levels[b].height && levels[a].width > levels[b].width);
+		});
+		return order;
+	}
+
+	void Packing2D::setPattern(Size _pattern_size, int _alignment, int _padding)
+	{
+		pattern_size = Size(MAX(1, _pattern_size.width), MAX(1, _pattern_size.height));
+		alignment = MAX(1, _alignment);
+		padding = _padding > 0 ? roundUpMul(_padding, alignment) : 0;
+	}
+
+	std::vector<Rect> Packing2D::getLevels(const std::vector<float>& scales, Size image_size) const
+	{
+		std::vector<Rect> levels;
+		for (int scl = 0; scl < (int)scales.size(); ++scl)
+		{
+			Size img_resize = image_size * scales[scl];
+			levels.push_back(Rect(0, 0, roundUpMul(img_resize.width, alignment) + padding, roundUpMul(img_resize.height, alignment) + padding));
+		}
+		return levels;
+	}
+
+	bool Packing2D::packSkyline(std::vector<Rect>& packed, const std::vector<Rect>& levels, int strip_width) const
+	{
+		packed.assign(levels.size(), Rect());
+
+		//bottom-left skyline: segments cover [0, strip_width) ordered by x
+		std::vector<Skyline> skyline(1, Skyline{ 0, 0, strip_width });
+
+		const std::vector<int> order = getPackingOrder(levels);
+		for (auto it = order.begin(); it != order.end(); ++it)
+		{
+			const int width = levels[*it].width;
+			const int height = levels[*it].height;
+			if (width > strip_width) return false;
+
+			int best = -1;
+			int best_y = INT_MAX;
+			for (int i = 0; i < (int)skyline.size(); ++i)
+			{
+				const int x = skyline[i].x;
+				if (x + width > strip_width) break;
+
+				int y = 0;
+				for (int j = i, width_left = width; width_left > 0; ++j)
+				{
+					y = MAX(y, skyline[j].y);
+					width_left -= skyline[j].width;
+				}
+
+				if (y < best_y)
+				{
+					best = i;
+					best_y = y;
+				}
+			}
+			if (best < 0) return false;
+
+			const int x = skyline[best].x;
+			packed[*it] = Rect(x, best_y, width, height);
+
+			skyline.insert(skyline.begin() + best, Skyline{ x, best_y + height, width });
+			for (int i = best + 1; i < (int)skyline.size();)
+			{
+				const int shrink = x + width - skyline[i].x;
+				if (shrink <= 0) break;
+
+				skyline[i].x += shrink;
+				skyline[i].width -= shrink;
+				if (skyline[i].width <= 0)
+				{
+					skyline.erase(skyline.begin() + i);
+				}
+				else
+				{
+					break;
+				}
+			}
+			for (int i = 0; i + 1 < (int)skyline.size();)
+			{
+				if (skyline[i].y == skyline[i + 1].y)
+				{
+					skyline[i].width += skyline[i + 1].width;
+					skyline.erase(skyline.begin() + i + 1);
+				}
+				else
+				{
+					++i;
+				}
+			}
+		}
+
+		return true;
+	}
+
+	bool Packing2D::packMaxRects(std::vector<Rect>& packed, const std::vector<Rect>& levels, int strip_width) const
+	{
+		packed.assign(levels.size(), Rect());
+
+		int strip_height = 0;
+		for (auto it = levels.begin(); it != levels.end(); ++it)
+		{
+			strip_height += it->height;
+		}
+
+		//maximal free rectangles, placement rule is bottom-left
+		std::vector<Rect> free_rects(1, Rect(0, 0, strip_width, strip_height));
+
+		const std::vector<int> order = getPackingOrder(levels);
+		for (auto it = order.begin(); it != order.end(); ++it)
+		{
+			const int width = levels[*it].width;
+			const int height = levels[*it].height;
+
+			int best = -1;
+			for (int i = 0; i < (int)free_rects.size(); ++i)
+			{
+				const Rect& free_rect = free_rects[i];
+				if (width > free_rect.width || height > free_rect.height) continue;
+
+				if (best < 0 || free_rect.y < free_rects[best].y || (free_rect.y == free_rects[best].y && free_rect.x < free_rects[best].x))
+				{
+					best = i;
+				}
+			}
+			if (best < 0) return false;
+
+			const Rect rect(free_rects[best].x, free_rects[best].y, width, height);
+			packed[*it] = rect;
+
+			std::vector<Rect> split;
+			for (auto free_rect = free_rects.begin(); free_rect != free_rects.end(); ++free_rect)
+			{
+				if (!overlaps(*free_rect, rect))
+				{
+					split.push_back(*free_rect);
+					continue;
+				}
+
+				if (rect.x > free_rect->x) split.push_back(Rect(free_rect->x, free_rect->y, rect.x - free_rect->x, free_rect->height));
+				if (rect.x2 < free_rect->x2) split.push_back(Rect(rect.x2, free_rect->y, free_rect->x2 - rect.x2, free_rect->height));
+				if (rect.y > free_rect->y) split.push_back(Rect(free_rect->x, free_rect->y, free_rect->width, rect.y - free_rect->y));
+				if (rect.y2 < free_rect->y2) split.push_back(Rect(free_rect->x, rect.y2, free_rect->width, free_rect->y2 - rect.y2));
+			}
+
+			free_rects.clear();
+			for (int i = 0; i < (int)split.size(); ++i)
+			{
+				bool redundant = false;
+				for (int j = 0; j < (int)split.size() && !redundant; ++j)
+				{
+					if (i == j || !contains(split[j], split[i])) continue;
+
+					//of two equal rectangles the first one is kept
+					redundant = !contains(split[i], split[j]) || j < i;
+				}
+				if (!redundant) free_rects.push_back(split[i]);
+			}
+		}
+
+		return true;
+	}
+
+	long long Packing2D::getCost(const Size& size) const
+	{
+		//stage-1 outputs computed for canvas
+		const long long cols = size.width >= pattern_size.width ? (size.width - pattern_size.width) / alignment + 1 : 0;
+		const long long rows = size.height >= pattern_size.height ? (size.height - pattern_size.height) / alignment + 1 : 0;
+		return cols * rows;
+	}
+
+	bool Packing2D::finishLayout(Layout& layout) const
+	{
+		layout.size = Size(0, 0);
+
+		long long area = 0;
+		long long outputs = 0;
+		for (int i = 0; i < (int)layout.rects.size(); ++i)
+		{
+			const Rect& rect = layout.rects[i];
+			if (rect.x < 0 || rect.y < 0 || rect.x % alignment != 0 || rect.y % alignment != 0) return false;
+			for (int j = 0; j < i; ++j)
+			{
+				if (overlaps(rect, layout.rects[j])) return false;
+			}
+
+			layout.size.width = MAX(layout.size.width, rect.x2);
+			layout.size.height = MAX(layout.size.height, rect.y2);
+			area += (long long)rect.width * (long long)rect.height;
+			outputs += getCost(Size(rect.width, rect.height));
+		}
+		if (layout.size.width == 0 || layout.size.height == 0) return false;
+
+		layout.area_ratio = float((double)area / ((double)layout.size.width * (double)layout.size.height));
+		layout.waste = 1.f - float((double)outputs / (double)MAX(1ll, getCost(layout.size)));
+
+		return true;
+	}
+
+	void Packing2D::selectLayout(Layout& best, bool& found, Layout& layout, Size max_canvas) const
+	{
+		if (padding > 0)
+		{
+			for (auto it = layout.rects.begin(); it != layout.rects.end(); ++it)
+			{
+				*it = Rect(it->x, it->y, it->width - padding, it->height - padding);
+			}
+		}
+
+		if (!finishLayout(layout)) return;
+		if (max_canvas.width > 0 && (layout.size.width > max_canvas.width || layout.size.height > max_canvas.height)) return;
+
+		const long long cost = getCost(layout.size);
+		const long long best_cost = getCost(best.size);
+		if (!found || cost < best_cost || (cost == best_cost &&
+			(long long)layout.size.width * layout.size.height < (long long)best.size.width * best.size.height))
+		{
+			best = layout;
+			found = true;
+		}
+	}
+
+	const Packing2D::Layout* Packing2D::getLayout(Size image_size, const std::vector<float>& scales, Size max_canvas)
+	{
+		const LayoutKey key(std::vector<int>({ image_size.width, image_size.height, max_canvas.width, max_canvas.height,
+			pattern_size.width, pattern_size.height, alignment, padding }), scales);
+
+		auto cached = layout_cache.find(key);
+		if (cached != layout_cache.end())
+		{
+			return &cached->second;
+		}
+
+		const std::vector<Rect> levels = getLevels(scales, image_size);
+		if (levels.empty()) return NULL;
+
+		int max_width = 0;
+		int sum_width = 0;
+		for (auto it = levels.begin(); it != levels.end(); ++it)
+		{
+			max_width = MAX(max_width, it->width);
+			sum_width += it->width;
+		}
+
+		//strip widths of previous packer and a sweep from widest level to a single row
+		std::vector<int> strip_widths;
+		for (int i = 0; i < MIN(4, (int)scales.size()); ++i)
+		{
+			strip_widths.push_back(int(1.f + scales[i]) * image_size.width);
+		}
+		const int num_steps = 24;
+		for (int i = 0; i <= num_steps; ++i)
+		{
+			strip_widths.push_back(roundUpMul(max_width + (sum_width - max_width) * i / num_steps, alignment));
+		}
+		if (max_canvas.width > 0)
+		{
+			strip_widths.push_back(max_canvas.width);
+		}
+		std::sort(strip_widths.begin(), strip_widths.end());
+		strip_widths.erase(std::unique(strip_widths.begin(), strip_widths.end()), strip_widths.end());
+
+		//level packer uses own level sizes
+		const bool level_method = padding == 0 && 4 % alignment == 0;
+
+		Layout best;
+		bool found = false;
+		for (auto strip_width = strip_widths.begin(); strip_width != strip_widths.end(); ++strip_width)
+		{
+			if (*strip_width < max_width || (max_canvas.width > 0 && *strip_width > max_canvas.width)) continue;
+
+			for (int method = 0; method < 3; ++method)
+			{
+				Layout layout;
+				layout.method = (Method)method;
+				layout.strip_width = *strip_width;
+
+				bool packed = false;
+				switch (layout.method)
+				{
+				case Method::level:
+					if (level_method)
+					{
+						std::vector<float> level_scales = scales;
+						Size level_image_size = image_size;
+						packing(&layout.rects, &layout.size, level_scales, level_image_size, *strip_width);
+						packed = true;
+					}
+					break;
+
+				case Method::skyline:
+					packed = packSkyline(layout.rects, levels, *strip_width);
+					break;
+
+				case Method::max_rects:
+					packed = packMaxRects(layout.rects, levels, *strip_width);
+					break;
+				}
+				if (!packed) continue;
+
+				selectLayout(best, found, layout, max_canvas);
+			}
+		}
+
+		if (!found) return NULL;
+
+		return &(layout_cache[key] = best);
+	}
+
+
+	const char* Packing2D::getMethodName(Method method)
+	{
+		static const char* names[] = { "level", "skyline", "max_rects" };
+		return names[(int)method];
+	}
+
 }
\ No newline at end of file
@@ -7,6 +7,7 @@
 
 #include "type.h"
 #include <vector>
+#include <map>
 
 
 //========================================================================================================
@@ -45,11 +46,62 @@ namespace NeuralNetworksLib
 			int STRIPH;
 		};
 
+		struct Skyline
+		{
+			int x;
+			int y;
+			int width;
+		};
+
+	public:
+		enum struct Method
+		{
+			level = 0,
+			skyline,
+			max_rects
+		};
+
+		struct Layout
+		{
+			std::vector<Rect> rects;		//pyramid levels on canvas, in order of scales
+			Size size;						//canvas
+			Method method = Method::level;
+			int strip_width = 0;
+			float area_ratio = 0.f;			//area of levels / area of canvas
+			float waste = 0.f;				//share of stage-1 outputs of canvas which do not belong to any level
+		};
+
+	private:
+		typedef std::pair<std::vector<int>, std::vector<float>> LayoutKey;
+
+		Size pattern_size = Size(1, 1);
+		int alignment = 4;
+		int padding = 0;
+		std::map<LayoutKey, Layout> layout_cache;
+
+		std::vector<Rect> getLevels(const std::vector<float>& scales, Size image_size) const;
+		bool packSkyline(std::vector<Rect>& packed, const std::vector<Rect>& levels, int strip_width) const;
+		bool packMaxRects(std::vector<Rect>& packed, const std::vector<Rect>& levels, int strip_width) const;
+		bool finishLayout(Layout& layout) const;
+		long long getCost(const Size& size) const;
+		void selectLayout(Layout& best, bool& found, Layout& layout, Size max_canvas) const;
+
 	public:
 		Packing2D() { }
 		~Packing2D() { }
 
 		float packing(std::vector<Rect>* packed, Size* packed_size, std::vector<float>& scales, Size& max_size, int strip_width = 0);
+
+		//receptive field and stride of stage 1: levels are aligned to stride and layouts are compared by stage-1 outputs of canvas
+		void setPattern(Size _pattern_size, int _alignment, int _padding = 0);
+
+		//best layout over candidate strip widths and packing methods (level, skyline, maxrects without rotation),
+		//cached per (image size, scales, max canvas); max_canvas limits canvas if not zero, returns NULL if levels do not fit
+		const Layout* getLayout(Size image_size, const std::vector<float>& scales, Size max_canvas = Size(0, 0));
+		void clearCache() { layout_cache.clear(); }
+		inline int getCacheSize() const { return (int)layout_cache.size(); }
+
+		static const char* getMethodName(Method method);
 	};
 
 }
\ No newline at end of file
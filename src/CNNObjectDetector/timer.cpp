@@ -47,11 +47,11 @@ namespace NeuralNetworksLib
 
 	void Timer::start(int counter) 
 	{
-		this->counters[counter] = std::chrono::high_resolution_clock::now();
+		this->counters[counter] = std::chrono::steady_clock::now();
 	} 
 	double Timer::get(double multiply, int counter) 
 	{
-		auto end = std::chrono::high_resolution_clock::now();
+		auto end = std::chrono::steady_clock::now();
 		std::chrono::duration<double> diff = end - this->counters[counter];
 		return diff.count() * multiply;
 	}
@@ -129,12 +129,12 @@ namespace NeuralNetworksLib
 		void Timer::start()
 		{
 			clFinish(queue);
-			this->counters = std::chrono::high_resolution_clock::now();
+			this->counters = std::chrono::steady_clock::now();
 		}
 		double Timer::get(double multiply)
 		{
 			clFinish(queue);
-			auto end = std::chrono::high_resolution_clock::now();
+			auto end = std::chrono::steady_clock::now();
 			std::chrono::duration<double> diff = end - this->counters;
 			return diff.count() * multiply;
 		}
@@ -21,6 +21,7 @@
 #include <opencv2/opencv.hpp>
 
 #include <map>
+#include <chrono>
 #include <iostream>
 #include <fstream>
 #include <string>
@@ -322,14 +323,15 @@ void writeDetections(const std::string log_name, const std::string image_path, c
 int test(CompactCNNLib::FaceDetector& detector, 
 	     const std::string data_root, const std::string flist, 
 	     const std::string gt_data, const std::string FDDB_result,
-	     const bool draw)
+	     const bool draw, Stat& stat, double& detect_time)
 {
 	const int border_size = 50;
 	std::vector<std::string> image_path;
 	std::map<int, GroundTruth*> ground_truth;
 	FDDBPraser(flist, gt_data, image_path, ground_truth, border_size, ".");
 
-	Stat stat;
+	stat = Stat();
+	detect_time = 0.;
 	for (std::size_t i = 0; i < image_path.size(); ++i) {
 		std::cout << image_path[i].c_str();
 		cv::Mat img = cv::imread(data_root + image_path[i] + ".jpg");
@@ -343,7 +345,9 @@ int test(CompactCNNLib::FaceDetector& detector,
 
 		CompactCNNLib::FaceDetector::Face faces[100];
 		CompactCNNLib::FaceDetector::ImageData frame_ref(img_border.cols, img_border.rows, img_border.channels(), img_border.data, img_border.step[0]);
+		const auto start = std::chrono::steady_clock::now();
 		int num_faces = detector.Detect(faces, frame_ref);
+		detect_time += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
 
 		std::vector<cv::Rect> cv_faces;
 		std::vector<float> score;
@@ -374,8 +378,49 @@ int test(CompactCNNLib::FaceDetector& detector,
 
 	std::cout << std::endl
 		<< "	Recall: " << stat.true_detections / float(stat.face_count) << std::endl
-		<< "	Precision: " << stat.true_detections / float(stat.true_detections + stat.false_detections) << std::endl;
+		<< "	Precision: " << stat.true_detections / float(stat.true_detections + stat.false_detections) << std::endl
+		<< "	Detect time: " << detect_time / double(MAX(stat.image_count, 1)) << " ms per image" << std::endl;
 
+	detect_time /= double(MAX(stat.image_count, 1));
+	return 0;
+}
+
+//int8 models: every calib_step-th FDDB image calibrates conv layers of float models
+int quantizeModels(const std::string data_root, const std::string flist, const std::string models_path,
+				   const std::string int8_path, const int calib_step = 20)
+{
+	std::vector<std::string> image_path;
+	std::fstream f(flist.c_str(), std::ios_base::in);
+	std::string str;
+	while (f >> str) {
+		image_path.push_back(str);
+	}
+	f.close();
+
+	std::vector<cv::Mat> images;
+	std::vector<CompactCNNLib::FaceDetector::ImageData> calib_images;
+	for (std::size_t i = 0; i < image_path.size(); i += calib_step) {
+		cv::Mat img = cv::imread(data_root + image_path[i] + ".jpg");
+		if (img.data) images.push_back(img);
+	}
+	for (auto& img : images) {
+		calib_images.push_back(CompactCNNLib::FaceDetector::ImageData(img.cols, img.rows, img.channels(), img.data, img.step[0]));
+	}
+	if (calib_images.empty()) {
+		std::cout << "Calibration images not found!" << std::endl;
+		return -1;
+	}
+
+	for (int i = 1; i <= 3; ++i) {
+		const std::string model = models_path + "cnn4face" + std::to_string(i) + "_cntk.bin";
+		const std::string model_int8 = int8_path + "cnn4face" + std::to_string(i) + "_int8.bin";
+		if (CompactCNNLib::FaceDetector::QuantizeModel(model_int8.c_str(), model.c_str(), calib_images.data(), (int)calib_images.size()) < 0) {
+			std::cout << "Could not quantize " << model << std::endl;
+			return -1;
+		}
+	}
+
+	std::cout << "int8 models are calibrated on " << calib_images.size() << " images" << std::endl;
 	return 0;
 }
 
@@ -399,14 +444,53 @@ int main(int argc, char* argv[])
 	param.num_threads = 4;
 	param.drop_detect = false;
 
+	//speed vs recall of coarse-to-fine search: FDDB_test cpu [coarse_to_fine]
+	//accuracy delta of int8 models: FDDB_test cpu int8
+	bool int8 = false;
+	for (int i = 1; i < argc; ++i) {
+		const std::string arg = argv[i];
+		if (arg == "cpu") param.pipeline = CompactCNNLib::FaceDetector::Pipeline::CPU;
+		if (arg == "coarse_to_fine") param.coarse_to_fine = true;
+		if (arg == "int8") int8 = true;
+	}
+
 	if (face_detector.Init(param) < 0) return -1;
 
 	std::string data_root = FDDBPath;
 	std::string image_list = FDDBFold"FDDB-fold-all.txt";
 	std::string ground_truth_data = FDDBFold"FDDB-fold-all-ellipseList.txt";
-	std::string FDDB_result = "FDDB_result.txt";
+	std::string FDDB_result = param.coarse_to_fine ? "FDDB_result_coarse_to_fine.txt" : "FDDB_result.txt";
 	bool draw = false;
-	test(face_detector, data_root, image_list, ground_truth_data, FDDB_result, draw);
+	Stat stat;
+	double detect_time = 0.;
+	test(face_detector, data_root, image_list, ground_truth_data, FDDB_result, draw, stat, detect_time);
+
+	if (int8) {
+		const std::string models_path = FDDBFold"../../models/";
+		if (quantizeModels(data_root, image_list, models_path, "") < 0) return -1;
+
+		const std::string model_int8[3] = { "cnn4face1_int8.bin", "cnn4face2_int8.bin", "cnn4face3_int8.bin" };
+		for (int i = 0; i < 3; ++i) {
+			param.models[i] = model_int8[i].c_str();
+			param.int8_models[i] = true;
+		}
+
+		face_detector.Clear();
+		if (face_detector.Init(param) < 0) return -1;
+
+		Stat stat_int8;
+		double detect_time_int8 = 0.;
+		test(face_detector, data_root, image_list, ground_truth_data, "FDDB_result_int8.txt", draw, stat_int8, detect_time_int8);
+
+		const float recall = stat.true_detections / float(stat.face_count);
+		const float precision = stat.true_detections / float(stat.true_detections + stat.false_detections);
+		const float recall_int8 = stat_int8.true_detections / float(stat_int8.face_count);
+		const float precision_int8 = stat_int8.true_detections / float(stat_int8.true_detections + stat_int8.false_detections);
+		std::cout << std::endl << "int8 vs float models:" << std::endl
+			<< "	Recall: " << recall_int8 << " (" << recall_int8 - recall << ")" << std::endl
+			<< "	Precision: " << precision_int8 << " (" << precision_int8 - precision << ")" << std::endl
+			<< "	Detect time: " << detect_time_int8 << " ms per image (" << detect_time / MAX(detect_time_int8, 1e-6) << "x)" << std::endl;
+	}
 
 	std::system("pause");
 	return 0;